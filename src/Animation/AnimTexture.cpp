@@ -1,5 +1,9 @@
 #include "AnimTexture.hpp"
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
 #include <tinyxml2.h>
 
 #include "../Logger/Logger.hpp"
@@ -12,33 +16,56 @@ namespace swift
 	{}
 
 	bool AnimTexture::loadFromFile(const std::string& f)
+	{
+		std::ifstream fin(f, std::ios::binary);
+		std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		
+		return loadFromMemory(text.data(), text.size(), f);
+	}
+	
+	bool AnimTexture::loadFromMemory(const void* data, std::size_t size, const std::string& f)
 	{
 		file = f;
 		
+		ByteReader in(static_cast<const std::uint8_t*>(data), size);
+		
+		if(in.readUInt32() == ANIM_MAGIC && in.good())
+		{
+			if(!loadBinary(in))
+			{
+				SWIFT_ERROR(Assets, "Loading compiled animation file \"" << file << "\" failed.\n");
+				return false;
+			}
+			
+			return true;
+		}
+		
 		tinyxml2::XMLDocument loadFile;
-		loadFile.LoadFile(f.c_str());
+		loadFile.Parse(static_cast<const char*>(data), size);
 		
 		if(loadFile.Error())
 		{
-			log << "[ERROR] Loading animation file \"" << file << "\" failed.\n";
+			SWIFT_ERROR(Assets, "Loading animation file \"" << file << "\" failed.\n");
 			return false;
 		}
 
 		tinyxml2::XMLElement* animRoot = loadFile.FirstChildElement("animated");
 		if(animRoot == nullptr)
 		{
-			log << "[WARNING] Animation file \"" << file << "\" does not have a \"animated\" root element.\n";
+			SWIFT_WARNING(Assets, "Animation file \"" << file << "\" does not have a \"animated\" root element.\n");
 			return false;
 		}
 		
 		textureFile = animRoot->Attribute("texture");
 		
+		std::map<std::string, FrameAnimation> byName;
+		
 		tinyxml2::XMLElement* animation = animRoot->FirstChildElement("animation");
 		while(animation != nullptr)
 		{
 			std::string animName = animation->Attribute("name");
-			animations[animName].setTime(std::stof(animation->Attribute("time")));
-			animations[animName].setLooping(std::string(animation->Attribute("looping")) == "true" ? true : false);
+			byName[animName].setTime(std::stof(animation->Attribute("time")));
+			byName[animName].setLooping(std::string(animation->Attribute("looping")) == "true" ? true : false);
 			
 			tinyxml2::XMLElement* frame = animation->FirstChildElement("frame");
 			while(frame != nullptr)
@@ -58,12 +85,12 @@ namespace swift
 					else if(name == "h")
 						frameRect.height = std::stoi(param->GetText());
 					else
-						log << "[INFO]: Unknown paramater: \"" << name << "\" in anim file: " << file << '\n';
+						SWIFT_INFO(Assets, "Unknown paramater: \"" << name << "\" in anim file: " << file << '\n');
 					
 					param = param->NextSiblingElement();
 				}
 				
-				animations[animName].addFrame(frameRect);
+				byName[animName].addFrame(frameRect);
 				
 				frame = frame->NextSiblingElement("frame");
 			}
@@ -71,6 +98,96 @@ namespace swift
 			animation = animation->NextSiblingElement("animation");
 		}
 		
+		// a map sorts them by name
+		names.clear();
+		animations.clear();
+		
+		for(auto& a : byName)
+		{
+			names.push_back(a.first);
+			animations.push_back(std::move(a.second));
+		}
+		
+		return true;
+	}
+	
+	void AnimTexture::write(ByteWriter& out) const
+	{
+		out.writeUInt32(ANIM_MAGIC);
+		out.writeByte(ANIM_VERSION);
+		out.writeString(textureFile);
+		out.writeUInt(animations.size());
+		
+		for(std::size_t i = 0; i < animations.size(); i++)
+		{
+			const FrameAnimation& anim = animations[i];
+			
+			out.writeString(names[i]);
+			out.writeFloat(anim.getTime());
+			out.writeBool(anim.isLooping());
+			out.writeUInt(anim.getFrameCount());
+			
+			for(unsigned j = 0; j < anim.getFrameCount(); j++)
+			{
+				const sf::IntRect& frame = anim.getFrame(j);
+				out.writeInt(frame.left);
+				out.writeInt(frame.top);
+				out.writeInt(frame.width);
+				out.writeInt(frame.height);
+			}
+		}
+	}
+	
+	bool AnimTexture::loadBinary(ByteReader& in)
+	{
+		if(in.readByte() > ANIM_VERSION)
+			return false;
+		
+		std::string texture = in.readString();
+		std::uint64_t count = in.readUInt();
+		
+		// every animation takes at least a few bytes
+		if(!in.good() || count > in.remaining())
+			return false;
+		
+		std::vector<std::string> readNames;
+		std::vector<FrameAnimation> readAnims(static_cast<std::size_t>(count));
+		
+		for(auto& anim : readAnims)
+		{
+			readNames.push_back(in.readString());
+			anim.setTime(in.readFloat());
+			anim.setLooping(in.readBool());
+			
+			std::uint64_t frames = in.readUInt();
+			
+			if(!in.good() || frames > in.remaining())
+				return false;
+			
+			std::vector<sf::IntRect> rects(static_cast<std::size_t>(frames));
+			
+			for(auto& r : rects)
+			{
+				r.left = static_cast<int>(in.readInt());
+				r.top = static_cast<int>(in.readInt());
+				r.width = static_cast<int>(in.readInt());
+				r.height = static_cast<int>(in.readInt());
+			}
+			
+			anim.setFrames(rects);
+			
+			// written in order of their names, which finding them needs
+			if(readNames.size() > 1 && !(readNames[readNames.size() - 2] < readNames.back()))
+				return false;
+		}
+		
+		if(!in.good())
+			return false;
+		
+		textureFile = texture;
+		names.swap(readNames);
+		animations.swap(readAnims);
+		
 		return true;
 	}
 	
@@ -84,20 +201,29 @@ namespace swift
 		return textureFile;
 	}
 	
-	std::vector<std::string> AnimTexture::getAnimNames() const
+	const std::vector<std::string>& AnimTexture::getAnimNames() const
 	{
-		std::vector<std::string> anims;
-		
-		for(auto& it : animations)
-		{
-			anims.push_back(it.first);
-		}
-		
-		return anims;
+		return names;
+	}
+	
+	std::size_t AnimTexture::getAnimCount() const
+	{
+		return animations.size();
+	}
+	
+	const FrameAnimation* AnimTexture::getAnim(unsigned id) const
+	{
+		return id < animations.size() ? &animations[id] : nullptr;
 	}
 	
-	const FrameAnimation& AnimTexture::getAnimFrames(const std::string& n) const
+	bool AnimTexture::findAnim(const std::string& n, unsigned& id) const
 	{
-		return animations.at(n);
+		auto it = std::lower_bound(names.begin(), names.end(), n);
+		
+		if(it == names.end() || *it != n)
+			return false;
+		
+		id = static_cast<unsigned>(it - names.begin());
+		return true;
 	}
 }
@@ -6,9 +6,12 @@
 
 #include <vector>
 #include <map>
+#include <cstdint>
 
 #include "FrameAnimation.hpp"
 
+#include "../Serialization/ByteStream.hpp"
+
 namespace swift
 {
 	class AnimTexture
@@ -18,16 +21,37 @@ namespace swift
 			
 			bool loadFromFile(const std::string& f);
 			
+			// an anim file from somewhere else, a pack. f is what it's known as.
+			// Either the XML anim files are written as, or what write compiles them to
+			bool loadFromMemory(const void* data, std::size_t size, const std::string& f);
+			
+			// the compiled form, read in one pass without parsing any text
+			void write(ByteWriter& out) const;
+			
 			const std::string& getFile() const;
 			const std::string& getTextureFile() const;
-			std::vector<std::string> getAnimNames() const;
-			const FrameAnimation& getAnimFrames(const std::string& n) const;
+			
+			// animations are numbered in order of their names, so what's animated only keeps a number.
+			// Numbers can change when the file is loaded again
+			const std::vector<std::string>& getAnimNames() const;
+			std::size_t getAnimCount() const;
+			const FrameAnimation* getAnim(unsigned id) const;
+			
+			// Returns true if there's an animation named n, and puts its number in id
+			bool findAnim(const std::string& n, unsigned& id) const;
 
 		private:
+			static const std::uint32_t ANIM_MAGIC = 0x4e415753;	// "SWAN"
+			static const std::uint8_t ANIM_VERSION = 1;
+			
+			bool loadBinary(ByteReader& in);
+			
 			std::string textureFile;
 			std::string file;
 			
-			std::map<std::string, FrameAnimation> animations;
+			// by number, with the names in the same order
+			std::vector<std::string> names;
+			std::vector<FrameAnimation> animations;
 	};
 }
 
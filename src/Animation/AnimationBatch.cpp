@@ -0,0 +1,174 @@
+#include "AnimationBatch.hpp"
+
+#include "../SystemInfo/CpuInfo.hpp"
+
+#include <limits>
+
+#ifdef SWIFT_AVX2_KERNELS
+	#include <immintrin.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define SWIFT_ANIM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SWIFT_ANIM_NEON
+#endif
+
+#ifdef SWIFT_AVX2_KERNELS
+namespace
+{
+	// the same as the SSE loop 8 at a time, returns how far it got
+	SWIFT_TARGET_AVX2 std::size_t updateAVX2(float* frames, float* times, const float* frameTimes, const float* frameCounts, const float* ends,
+											std::size_t count, float dt)
+	{
+		const __m256 step = _mm256_set1_ps(dt);
+		const __m256 one = _mm256_set1_ps(1);
+
+		std::size_t i = 0;
+
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256 frame = _mm256_loadu_ps(frames + i);
+			__m256 time = _mm256_add_ps(_mm256_loadu_ps(times + i), step);
+			__m256 next = _mm256_add_ps(frame, one);
+
+			__m256 advance = _mm256_and_ps(_mm256_cmp_ps(time, _mm256_mul_ps(_mm256_loadu_ps(frameTimes + i), next), _CMP_GE_OQ),
+											_mm256_cmp_ps(time, _mm256_loadu_ps(ends + i), _CMP_LT_OQ));
+			__m256 wrap = _mm256_and_ps(advance, _mm256_cmp_ps(next, _mm256_loadu_ps(frameCounts + i), _CMP_GE_OQ));
+
+			frame = _mm256_blendv_ps(frame, next, advance);
+			frame = _mm256_andnot_ps(wrap, frame);
+			time = _mm256_andnot_ps(wrap, time);
+
+			_mm256_storeu_ps(frames + i, frame);
+			_mm256_storeu_ps(times + i, time);
+		}
+
+		return i;
+	}
+}
+#endif
+
+namespace swift
+{
+	void AnimationBatch::clear()
+	{
+		frames.clear();
+		times.clear();
+		frameTimes.clear();
+		frameCounts.clear();
+		ends.clear();
+	}
+
+	void AnimationBatch::add(const FrameAnimation& anim, unsigned frame, float time)
+	{
+		// frames of a different animation than this one
+		if(frame >= anim.getFrameCount())
+		{
+			frame = 0;
+			time = 0;
+		}
+
+		frames.push_back(static_cast<float>(frame));
+		times.push_back(time);
+		frameTimes.push_back(anim.getFrameTime());
+		frameCounts.push_back(static_cast<float>(anim.getFrameCount()));
+		ends.push_back(anim.isLooping() ? std::numeric_limits<float>::infinity() : anim.getTime());
+	}
+
+	void AnimationBatch::update(float dt)
+	{
+		std::size_t count = size();
+		std::size_t i = 0;
+		SimdLevel level = getSimdLevel();
+
+		// a frame is done once the time is past its end. The last frame wraps around to the first, time and all
+#ifdef SWIFT_AVX2_KERNELS
+		if(level == SimdLevel::Avx2 && count)
+			i = updateAVX2(&frames[0], &times[0], &frameTimes[0], &frameCounts[0], &ends[0], count, dt);
+#endif
+
+#if defined(SWIFT_ANIM_SSE)
+		const __m128 step = _mm_set1_ps(dt);
+		const __m128 one = _mm_set1_ps(1);
+
+		for(; level >= SimdLevel::Wide4 && i + 4 <= count; i += 4)
+		{
+			__m128 frame = _mm_loadu_ps(&frames[i]);
+			__m128 time = _mm_add_ps(_mm_loadu_ps(&times[i]), step);
+			__m128 next = _mm_add_ps(frame, one);
+
+			__m128 advance = _mm_and_ps(_mm_cmpge_ps(time, _mm_mul_ps(_mm_loadu_ps(&frameTimes[i]), next)),
+										_mm_cmplt_ps(time, _mm_loadu_ps(&ends[i])));
+			__m128 wrap = _mm_and_ps(advance, _mm_cmpge_ps(next, _mm_loadu_ps(&frameCounts[i])));
+
+			// next where it advances, then 0 where it wraps
+			frame = _mm_or_ps(_mm_and_ps(advance, next), _mm_andnot_ps(advance, frame));
+			frame = _mm_andnot_ps(wrap, frame);
+			time = _mm_andnot_ps(wrap, time);
+
+			_mm_storeu_ps(&frames[i], frame);
+			_mm_storeu_ps(&times[i], time);
+		}
+#elif defined(SWIFT_ANIM_NEON)
+		const float32x4_t step = vdupq_n_f32(dt);
+		const float32x4_t one = vdupq_n_f32(1);
+		const float32x4_t zero = vdupq_n_f32(0);
+
+		for(; level >= SimdLevel::Wide4 && i + 4 <= count; i += 4)
+		{
+			float32x4_t frame = vld1q_f32(&frames[i]);
+			float32x4_t time = vaddq_f32(vld1q_f32(&times[i]), step);
+			float32x4_t next = vaddq_f32(frame, one);
+
+			uint32x4_t advance = vandq_u32(vcgeq_f32(time, vmulq_f32(vld1q_f32(&frameTimes[i]), next)),
+										vcltq_f32(time, vld1q_f32(&ends[i])));
+			uint32x4_t wrap = vandq_u32(advance, vcgeq_f32(next, vld1q_f32(&frameCounts[i])));
+
+			frame = vbslq_f32(advance, next, frame);
+			frame = vbslq_f32(wrap, zero, frame);
+			time = vbslq_f32(wrap, zero, time);
+
+			vst1q_f32(&frames[i], frame);
+			vst1q_f32(&times[i], time);
+		}
+#endif
+
+		// whatever doesn't fill a whole batch
+		for(; i < count; i++)
+		{
+			float time = times[i] + dt;
+			float next = frames[i] + 1;
+
+			if(time >= frameTimes[i] * next && time < ends[i])
+			{
+				if(next >= frameCounts[i])
+				{
+					next = 0;
+					time = 0;
+				}
+
+				frames[i] = next;
+			}
+
+			times[i] = time;
+		}
+	}
+
+	unsigned AnimationBatch::getFrame(std::size_t i) const
+	{
+		return static_cast<unsigned>(frames[i]);
+	}
+
+	float AnimationBatch::getTime(std::size_t i) const
+	{
+		return times[i];
+	}
+
+	std::size_t AnimationBatch::size() const
+	{
+		return frames.size();
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef ANIMATIONBATCH_HPP
+#define ANIMATIONBATCH_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include "FrameAnimation.hpp"
+
+namespace swift
+{
+	// steps many animations' playback at once, 4 at a time with SSE or NEON where available.
+	// Steps the same as FrameAnimation::update, without its branches: an animation that doesn't loop ends where
+	// one that loops never does
+	class AnimationBatch
+	{
+		public:
+			void clear();
+
+			// anim must have frames
+			void add(const FrameAnimation& anim, unsigned frame, float time);
+
+			void update(float dt);
+
+			// of the ith added, after update
+			unsigned getFrame(std::size_t i) const;
+			float getTime(std::size_t i) const;
+
+			std::size_t size() const;
+
+		private:
+			// one array per value, so 4 animations load in one go. Frames are floats
+			// so they're compared and picked with the rest, they're far too few to lose any
+			std::vector<float> frames;
+			std::vector<float> times;
+			std::vector<float> frameTimes;
+			std::vector<float> frameCounts;
+			std::vector<float> ends;	// the time it's done at, infinite when looping
+	};
+}
+
+#endif // ANIMATIONBATCH_HPP
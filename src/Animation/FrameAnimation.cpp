@@ -3,64 +3,84 @@
 namespace swift
 {
 	FrameAnimation::FrameAnimation()
-	:	frameNum(0),
-	    totalTime(0),
-	    currentTime(0),
-	    looping(false),
-	    done(false)
+	:	totalTime(0),
+	    frameTime(0),
+	    looping(false)
 	{}
 
-	const sf::IntRect& FrameAnimation::update(float dt)
+	const sf::IntRect& FrameAnimation::update(unsigned& frame, float& time, float dt) const
 	{
-		currentTime += dt;
-
-		if(currentTime >= (totalTime / frames.size()) * (frameNum + 1) && (currentTime < totalTime || looping))
+		// frames of a different animation than this one
+		if(frame >= frames.size())
 		{
-			if(frames.size() > 0 && !done)
-			{
-				if(frameNum < frames.size() - 1)
-				{
-					frameNum++;
-				}
-				else
-				{
-					frameNum = 0;
-					currentTime = 0;
-				}
-			}
+			frame = 0;
+			time = 0;
 		}
 
-		if(!looping && currentTime >= totalTime)
-			done = true;
+		time += dt;
 
-		return frames[frameNum];
-	}
-
-	void FrameAnimation::setFrameNum(unsigned fn)
-	{
-		if(fn < frames.size())
+		// a non-looping animation is done once its time is up, and stays on its last frame
+		if(time >= frameTime * (frame + 1) && (time < totalTime || looping))
 		{
-			frameNum = fn;
+			if(frame < frames.size() - 1)
+			{
+				frame++;
+			}
+			else
+			{
+				frame = 0;
+				time = 0;
+			}
 		}
+
+		return frames[frame];
 	}
 
 	void FrameAnimation::addFrame(const sf::IntRect& rect)
 	{
 		frames.push_back(rect);
+		frameTime = totalTime / frames.size();
 	}
 
 	void FrameAnimation::setFrames(const std::vector<sf::IntRect>& fs)
 	{
 		frames = fs;
+		frameTime = frames.empty() ? 0 : totalTime / frames.size();
+	}
+
+	std::size_t FrameAnimation::getFrameCount() const
+	{
+		return frames.size();
+	}
+
+	const sf::IntRect& FrameAnimation::getFrame(unsigned frame) const
+	{
+		return frames[frame];
 	}
 
 	void FrameAnimation::setTime(float seconds)
 	{
 		totalTime = seconds;
+		frameTime = frames.empty() ? 0 : totalTime / frames.size();
 	}
 
 	void FrameAnimation::setLooping(bool l)
 	{
 		looping = l;
 	}
+
+	float FrameAnimation::getTime() const
+	{
+		return totalTime;
+	}
+
+	float FrameAnimation::getFrameTime() const
+	{
+		return frameTime;
+	}
+
+	bool FrameAnimation::isLooping() const
+	{
+		return looping;
+	}
 }
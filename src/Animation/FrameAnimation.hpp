@@ -11,28 +11,35 @@
 
 namespace swift
 {
+	// an animation's frames and timing. Shared by everything playing it, each keeps how far into it it is
 	class FrameAnimation
 	{
 		public:
 			FrameAnimation();
 			
-			const sf::IntRect& update(float dt);
-			void setFrameNum(unsigned int fn);
+			// moves frame and time, how far into the animation something is, on by dt
+			// Returns the frame to show. The animation must have frames
+			const sf::IntRect& update(unsigned& frame, float& time, float dt) const;
+			
 			void addFrame(const sf::IntRect& rect);
 			void setFrames(const std::vector<sf::IntRect>& fs);
+			std::size_t getFrameCount() const;
+			const sf::IntRect& getFrame(unsigned frame) const;
 			
 			void setTime(float seconds);
 			void setLooping(bool l);
+			
+			float getTime() const;
+			float getFrameTime() const;
+			bool isLooping() const;
 
 		private:
 			std::vector<sf::IntRect> frames;
-			unsigned int frameNum;
 			
 			float totalTime;	// time the animation lasts
-			float currentTime;	// current time in animation
+			float frameTime;	// each frame's share of it
 			
 			bool looping;
-			bool done;	// set to true if animation is non-looping and is done
 	};
 }
 
@@ -0,0 +1,129 @@
+#include "AABBBatch.hpp"
+
+#include "../SystemInfo/CpuInfo.hpp"
+
+#ifdef SWIFT_AVX2_KERNELS
+	#include <immintrin.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define SWIFT_AABB_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SWIFT_AABB_NEON
+#endif
+
+#ifdef SWIFT_AVX2_KERNELS
+namespace
+{
+	// 8 pairs at a time, returns how far it got
+	SWIFT_TARGET_AVX2 std::size_t testAVX2(const float* oneLeft, const float* oneTop, const float* oneRight, const float* oneBottom,
+											const float* twoLeft, const float* twoTop, const float* twoRight, const float* twoBottom,
+											unsigned char* hits, std::size_t count)
+	{
+		std::size_t i = 0;
+
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256 x = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(oneLeft + i), _mm256_loadu_ps(twoRight + i), _CMP_LT_OQ),
+									_mm256_cmp_ps(_mm256_loadu_ps(twoLeft + i), _mm256_loadu_ps(oneRight + i), _CMP_LT_OQ));
+			__m256 y = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(oneTop + i), _mm256_loadu_ps(twoBottom + i), _CMP_LT_OQ),
+									_mm256_cmp_ps(_mm256_loadu_ps(twoTop + i), _mm256_loadu_ps(oneBottom + i), _CMP_LT_OQ));
+
+			int mask = _mm256_movemask_ps(_mm256_and_ps(x, y));
+
+			for(int l = 0; l < 8; l++)
+				hits[i + l] = (mask >> l) & 1;
+		}
+
+		return i;
+	}
+}
+#endif
+
+namespace swift
+{
+	void AABBBatch::clear()
+	{
+		oneLeft.clear();
+		oneTop.clear();
+		oneRight.clear();
+		oneBottom.clear();
+
+		twoLeft.clear();
+		twoTop.clear();
+		twoRight.clear();
+		twoBottom.clear();
+	}
+
+	void AABBBatch::add(const sf::FloatRect& one, const sf::FloatRect& two)
+	{
+		oneLeft.push_back(one.left);
+		oneTop.push_back(one.top);
+		oneRight.push_back(one.left + one.width);
+		oneBottom.push_back(one.top + one.height);
+
+		twoLeft.push_back(two.left);
+		twoTop.push_back(two.top);
+		twoRight.push_back(two.left + two.width);
+		twoBottom.push_back(two.top + two.height);
+	}
+
+	void AABBBatch::test(std::vector<unsigned char>& hits) const
+	{
+		std::size_t count = size();
+		hits.resize(count);
+
+		std::size_t i = 0;
+		SimdLevel level = getSimdLevel();
+
+#ifdef SWIFT_AVX2_KERNELS
+		if(level == SimdLevel::Avx2 && count)
+			i = testAVX2(&oneLeft[0], &oneTop[0], &oneRight[0], &oneBottom[0], &twoLeft[0], &twoTop[0], &twoRight[0], &twoBottom[0], &hits[0], count);
+#endif
+
+#if defined(SWIFT_AABB_SSE)
+		for(; level >= SimdLevel::Wide4 && i + 4 <= count; i += 4)
+		{
+			__m128 x = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(&oneLeft[i]), _mm_loadu_ps(&twoRight[i])),
+									_mm_cmplt_ps(_mm_loadu_ps(&twoLeft[i]), _mm_loadu_ps(&oneRight[i])));
+			__m128 y = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(&oneTop[i]), _mm_loadu_ps(&twoBottom[i])),
+									_mm_cmplt_ps(_mm_loadu_ps(&twoTop[i]), _mm_loadu_ps(&oneBottom[i])));
+
+			int mask = _mm_movemask_ps(_mm_and_ps(x, y));
+
+			hits[i] = mask & 1;
+			hits[i + 1] = (mask >> 1) & 1;
+			hits[i + 2] = (mask >> 2) & 1;
+			hits[i + 3] = (mask >> 3) & 1;
+		}
+#elif defined(SWIFT_AABB_NEON)
+		for(; level >= SimdLevel::Wide4 && i + 4 <= count; i += 4)
+		{
+			uint32x4_t x = vandq_u32(vcltq_f32(vld1q_f32(&oneLeft[i]), vld1q_f32(&twoRight[i])),
+									vcltq_f32(vld1q_f32(&twoLeft[i]), vld1q_f32(&oneRight[i])));
+			uint32x4_t y = vandq_u32(vcltq_f32(vld1q_f32(&oneTop[i]), vld1q_f32(&twoBottom[i])),
+									vcltq_f32(vld1q_f32(&twoTop[i]), vld1q_f32(&oneBottom[i])));
+
+			uint32_t lanes[4];
+			vst1q_u32(lanes, vandq_u32(x, y));
+
+			for(int l = 0; l < 4; l++)
+				hits[i + l] = lanes[l] != 0;
+		}
+#endif
+
+		// whatever doesn't fill a whole batch
+		for(; i < count; i++)
+		{
+			hits[i] = oneLeft[i] < twoRight[i] && twoLeft[i] < oneRight[i]
+					&& oneTop[i] < twoBottom[i] && twoTop[i] < oneBottom[i];
+		}
+	}
+
+	std::size_t AABBBatch::size() const
+	{
+		return oneLeft.size();
+	}
+}
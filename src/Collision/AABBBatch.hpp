@@ -0,0 +1,38 @@
+#ifndef AABBBATCH_HPP
+#define AABBBATCH_HPP
+
+#include <vector>
+
+#include <SFML/Graphics/Rect.hpp>
+
+namespace swift
+{
+	// overlap test for many pairs of axis aligned boxes, 4 pairs at a time with SSE or NEON where available.
+	// boxes that only touch don't overlap, same as the separating axis test
+	class AABBBatch
+	{
+		public:
+			void clear();
+
+			void add(const sf::FloatRect& one, const sf::FloatRect& two);
+
+			// hits[i] is 1 if the boxes of the ith added pair overlap, 0 otherwise
+			void test(std::vector<unsigned char>& hits) const;
+
+			std::size_t size() const;
+
+		private:
+			// one array per edge, so 4 pairs load in one go
+			std::vector<float> oneLeft;
+			std::vector<float> oneTop;
+			std::vector<float> oneRight;
+			std::vector<float> oneBottom;
+
+			std::vector<float> twoLeft;
+			std::vector<float> twoTop;
+			std::vector<float> twoRight;
+			std::vector<float> twoBottom;
+	};
+}
+
+#endif // AABBBATCH_HPP
@@ -0,0 +1,425 @@
+#include "AABBTree.hpp"
+
+#include <algorithm>
+
+namespace swift
+{
+	constexpr int AABBTree::NONE;
+
+	AABBTree::AABBTree(float m)
+	:	root(NONE),
+		freeList(NONE),
+		leaves(0),
+		margin(m)
+	{
+	}
+
+	int AABBTree::insert(unsigned item, const sf::FloatRect& bounds)
+	{
+		int leaf = allocate();
+
+		nodes[leaf].bounds = {bounds.left - margin, bounds.top - margin, bounds.width + 2 * margin, bounds.height + 2 * margin};
+		nodes[leaf].item = item;
+		nodes[leaf].height = 0;
+
+		insertLeaf(leaf);
+		leaves++;
+
+		return leaf;
+	}
+
+	void AABBTree::remove(int proxy)
+	{
+		if(proxy < 0 || proxy >= static_cast<int>(nodes.size()) || !nodes[proxy].isLeaf() || nodes[proxy].height != 0)
+			return;
+
+		removeLeaf(proxy);
+		release(proxy);
+		leaves--;
+	}
+
+	bool AABBTree::move(int proxy, const sf::FloatRect& bounds)
+	{
+		if(contains(nodes[proxy].bounds, bounds))
+			return false;
+
+		removeLeaf(proxy);
+
+		nodes[proxy].bounds = {bounds.left - margin, bounds.top - margin, bounds.width + 2 * margin, bounds.height + 2 * margin};
+
+		insertLeaf(proxy);
+
+		return true;
+	}
+
+	void AABBTree::clear()
+	{
+		nodes.clear();
+		root = NONE;
+		freeList = NONE;
+		leaves = 0;
+	}
+
+	unsigned AABBTree::getItem(int proxy) const
+	{
+		return nodes[proxy].item;
+	}
+
+	const sf::FloatRect& AABBTree::getFatBounds(int proxy) const
+	{
+		return nodes[proxy].bounds;
+	}
+
+	void AABBTree::query(const sf::FloatRect& bounds, std::vector<unsigned>& items) const
+	{
+		query(bounds, [this, &items](int proxy)
+		{
+			items.push_back(nodes[proxy].item);
+		});
+	}
+
+	void AABBTree::getPairs(std::vector<Pair>& pairs) const
+	{
+		for(int i = 0; i < static_cast<int>(nodes.size()); i++)
+		{
+			if(nodes[i].height != 0)
+				continue;
+
+			// only pair with later leaves, so each pair shows up once
+			query(nodes[i].bounds, [this, i, &pairs](int other)
+			{
+				if(other > i)
+					pairs.emplace_back(nodes[i].item, nodes[other].item);
+			});
+		}
+	}
+
+	void AABBTree::setMargin(float m)
+	{
+		margin = std::max(m, 0.f);
+	}
+
+	float AABBTree::getMargin() const
+	{
+		return margin;
+	}
+
+	std::size_t AABBTree::size() const
+	{
+		return leaves;
+	}
+
+	int AABBTree::allocate()
+	{
+		int node;
+
+		if(freeList != NONE)
+		{
+			node = freeList;
+			freeList = nodes[node].parent;
+		}
+		else
+		{
+			node = nodes.size();
+			nodes.emplace_back();
+		}
+
+		nodes[node].parent = NONE;
+		nodes[node].left = NONE;
+		nodes[node].right = NONE;
+		nodes[node].height = 0;
+		nodes[node].item = 0;
+
+		return node;
+	}
+
+	void AABBTree::release(int node)
+	{
+		nodes[node].parent = freeList;
+		nodes[node].left = NONE;
+		nodes[node].height = -1;
+		freeList = node;
+	}
+
+	void AABBTree::insertLeaf(int leaf)
+	{
+		if(root == NONE)
+		{
+			root = leaf;
+			nodes[root].parent = NONE;
+			return;
+		}
+
+		// walk down to the cheapest sibling, by perimeter growth
+		sf::FloatRect bounds = nodes[leaf].bounds;
+		int index = root;
+
+		while(!nodes[index].isLeaf())
+		{
+			int left = nodes[index].left;
+			int right = nodes[index].right;
+
+			float area = perimeter(nodes[index].bounds);
+			float combinedArea = perimeter(combine(nodes[index].bounds, bounds));
+
+			// cost of making a new parent for this node and the leaf
+			float cost = 2.f * combinedArea;
+
+			// minimum cost of pushing the leaf further down
+			float inheritance = 2.f * (combinedArea - area);
+
+			float leftCost = perimeter(combine(nodes[left].bounds, bounds)) + inheritance;
+			if(!nodes[left].isLeaf())
+				leftCost -= perimeter(nodes[left].bounds);
+
+			float rightCost = perimeter(combine(nodes[right].bounds, bounds)) + inheritance;
+			if(!nodes[right].isLeaf())
+				rightCost -= perimeter(nodes[right].bounds);
+
+			if(cost < leftCost && cost < rightCost)
+				break;
+
+			index = leftCost < rightCost ? left : right;
+		}
+
+		int sibling = index;
+		int oldParent = nodes[sibling].parent;
+
+		int newParent = allocate();
+		nodes[newParent].parent = oldParent;
+		nodes[newParent].bounds = combine(bounds, nodes[sibling].bounds);
+		nodes[newParent].height = nodes[sibling].height + 1;
+		nodes[newParent].left = sibling;
+		nodes[newParent].right = leaf;
+
+		nodes[sibling].parent = newParent;
+		nodes[leaf].parent = newParent;
+
+		if(oldParent != NONE)
+		{
+			if(nodes[oldParent].left == sibling)
+				nodes[oldParent].left = newParent;
+			else
+				nodes[oldParent].right = newParent;
+		}
+		else
+			root = newParent;
+
+		// fix up heights and bounds on the way back up
+		index = nodes[leaf].parent;
+		while(index != NONE)
+		{
+			index = balance(index);
+
+			int left = nodes[index].left;
+			int right = nodes[index].right;
+
+			nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+			nodes[index].bounds = combine(nodes[left].bounds, nodes[right].bounds);
+
+			index = nodes[index].parent;
+		}
+	}
+
+	void AABBTree::removeLeaf(int leaf)
+	{
+		if(leaf == root)
+		{
+			root = NONE;
+			return;
+		}
+
+		int parent = nodes[leaf].parent;
+		int grandParent = nodes[parent].parent;
+		int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+		if(grandParent != NONE)
+		{
+			// replace the parent with the sibling
+			if(nodes[grandParent].left == parent)
+				nodes[grandParent].left = sibling;
+			else
+				nodes[grandParent].right = sibling;
+
+			nodes[sibling].parent = grandParent;
+			release(parent);
+
+			int index = grandParent;
+			while(index != NONE)
+			{
+				index = balance(index);
+
+				int left = nodes[index].left;
+				int right = nodes[index].right;
+
+				nodes[index].bounds = combine(nodes[left].bounds, nodes[right].bounds);
+				nodes[index].height = 1 + std::max(nodes[left].height, nodes[right].height);
+
+				index = nodes[index].parent;
+			}
+		}
+		else
+		{
+			root = sibling;
+			nodes[sibling].parent = NONE;
+			release(parent);
+		}
+
+		nodes[leaf].parent = NONE;
+	}
+
+	int AABBTree::balance(int a)
+	{
+		Node& A = nodes[a];
+
+		if(A.isLeaf() || A.height < 2)
+			return a;
+
+		int b = A.left;
+		int c = A.right;
+
+		int diff = nodes[c].height - nodes[b].height;
+
+		// rotate c up
+		if(diff > 1)
+		{
+			int f = nodes[c].left;
+			int g = nodes[c].right;
+
+			nodes[c].left = a;
+			nodes[c].parent = A.parent;
+			A.parent = c;
+
+			if(nodes[c].parent != NONE)
+			{
+				if(nodes[nodes[c].parent].left == a)
+					nodes[nodes[c].parent].left = c;
+				else
+					nodes[nodes[c].parent].right = c;
+			}
+			else
+				root = c;
+
+			// the taller child of c stays with c
+			int keep = nodes[f].height > nodes[g].height ? f : g;
+			int give = keep == f ? g : f;
+
+			nodes[c].right = keep;
+			A.right = give;
+			nodes[give].parent = a;
+
+			A.bounds = combine(nodes[b].bounds, nodes[give].bounds);
+			nodes[c].bounds = combine(A.bounds, nodes[keep].bounds);
+
+			A.height = 1 + std::max(nodes[b].height, nodes[give].height);
+			nodes[c].height = 1 + std::max(A.height, nodes[keep].height);
+
+			return c;
+		}
+
+		// rotate b up
+		if(diff < -1)
+		{
+			int d = nodes[b].left;
+			int e = nodes[b].right;
+
+			nodes[b].left = a;
+			nodes[b].parent = A.parent;
+			A.parent = b;
+
+			if(nodes[b].parent != NONE)
+			{
+				if(nodes[nodes[b].parent].left == a)
+					nodes[nodes[b].parent].left = b;
+				else
+					nodes[nodes[b].parent].right = b;
+			}
+			else
+				root = b;
+
+			int keep = nodes[d].height > nodes[e].height ? d : e;
+			int give = keep == d ? e : d;
+
+			nodes[b].right = keep;
+			A.left = give;
+			nodes[give].parent = a;
+
+			A.bounds = combine(nodes[c].bounds, nodes[give].bounds);
+			nodes[b].bounds = combine(A.bounds, nodes[keep].bounds);
+
+			A.height = 1 + std::max(nodes[c].height, nodes[give].height);
+			nodes[b].height = 1 + std::max(A.height, nodes[keep].height);
+
+			return b;
+		}
+
+		return a;
+	}
+
+	sf::FloatRect AABBTree::combine(const sf::FloatRect& one, const sf::FloatRect& two)
+	{
+		float left = std::min(one.left, two.left);
+		float top = std::min(one.top, two.top);
+		float right = std::max(one.left + one.width, two.left + two.width);
+		float bottom = std::max(one.top + one.height, two.top + two.height);
+
+		return {left, top, right - left, bottom - top};
+	}
+
+	float AABBTree::perimeter(const sf::FloatRect& rect)
+	{
+		return 2.f * (rect.width + rect.height);
+	}
+
+	bool AABBTree::overlaps(const sf::FloatRect& one, const sf::FloatRect& two)
+	{
+		return one.left <= two.left + two.width && two.left <= one.left + one.width
+			&& one.top <= two.top + two.height && two.top <= one.top + one.height;
+	}
+
+	bool AABBTree::intersectRay(const sf::FloatRect& box, const sf::Vector2f& from, const sf::Vector2f& delta, float maxFraction, float& fraction)
+	{
+		float enter = 0;
+		float exit = maxFraction;
+
+		// where it's between each pair of edges, the slabs, overlapping is where it's in the box
+		const float starts[2] = {from.x, from.y};
+		const float steps[2] = {delta.x, delta.y};
+		const float mins[2] = {box.left, box.top};
+		const float maxs[2] = {box.left + box.width, box.top + box.height};
+
+		for(int a = 0; a < 2; a++)
+		{
+			if(steps[a] == 0)
+			{
+				if(starts[a] < mins[a] || starts[a] > maxs[a])
+					return false;
+
+				continue;
+			}
+
+			float inverse = 1 / steps[a];
+			float first = (mins[a] - starts[a]) * inverse;
+			float second = (maxs[a] - starts[a]) * inverse;
+
+			if(first > second)
+				std::swap(first, second);
+
+			enter = std::max(enter, first);
+			exit = std::min(exit, second);
+
+			if(enter > exit)
+				return false;
+		}
+
+		fraction = enter;
+		return true;
+	}
+
+	bool AABBTree::contains(const sf::FloatRect& outer, const sf::FloatRect& inner)
+	{
+		return outer.left <= inner.left && outer.top <= inner.top
+			&& inner.left + inner.width <= outer.left + outer.width
+			&& inner.top + inner.height <= outer.top + outer.height;
+	}
+}
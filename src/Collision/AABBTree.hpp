@@ -0,0 +1,180 @@
+#ifndef AABBTREE_HPP
+#define AABBTREE_HPP
+
+#include <vector>
+#include <utility>
+
+#include <SFML/Graphics/Rect.hpp>
+
+namespace swift
+{
+	// incremental bounding volume hierarchy. Leaves store fattened bounds, so an item
+	// only has to be reinserted once it moves out of them.
+	// works well where a uniform grid doesn't: sparse worlds, and items of very different sizes
+	class AABBTree
+	{
+		public:
+			using Pair = std::pair<unsigned, unsigned>;
+
+			static constexpr int NONE = -1;
+
+			// margin is how far leaf bounds are grown on each side
+			explicit AABBTree(float margin = 8.f);
+
+			// item is a caller defined value, returned by queries. Returns the leaf's proxy
+			int insert(unsigned item, const sf::FloatRect& bounds);
+			void remove(int proxy);
+
+			// returns true if the item left its fattened bounds, and was reinserted
+			bool move(int proxy, const sf::FloatRect& bounds);
+
+			void clear();
+
+			unsigned getItem(int proxy) const;
+			const sf::FloatRect& getFatBounds(int proxy) const;
+
+			// appends items whose fattened bounds overlap bounds
+			void query(const sf::FloatRect& bounds, std::vector<unsigned>& items) const;
+
+			// calls func(proxy) for each leaf whose fattened bounds overlap bounds
+			template<typename F>
+			void query(const sf::FloatRect& bounds, F func) const;
+
+			// calls func(proxy, maxFraction) for each leaf whose fattened bounds the segment from from to
+			// from + (to - from) * maxFraction crosses, maxFraction starting at 1. func returns what to cut the
+			// segment to, maxFraction to leave it, so once something is hit only what's nearer is visited
+			template<typename F>
+			void raycast(const sf::Vector2f& from, const sf::Vector2f& to, F func) const;
+
+			// true if the segment from from to from + delta * maxFraction crosses box, with fraction how far along
+			// it enters. 0 if it starts inside
+			static bool intersectRay(const sf::FloatRect& box, const sf::Vector2f& from, const sf::Vector2f& delta, float maxFraction, float& fraction);
+
+			// appends every pair of items whose fattened bounds overlap, each only once
+			void getPairs(std::vector<Pair>& pairs) const;
+
+			void setMargin(float m);
+			float getMargin() const;
+
+			std::size_t size() const;
+
+		private:
+			struct Node
+			{
+				sf::FloatRect bounds;
+				int parent;		// doubles as the next free node
+				int left;
+				int right;
+				int height;		// 0 for leaves, -1 for free nodes
+				unsigned item;
+
+				bool isLeaf() const
+				{
+					return left == NONE;
+				}
+			};
+
+			int allocate();
+			void release(int node);
+
+			void insertLeaf(int leaf);
+			void removeLeaf(int leaf);
+
+			// rotates the subtree at a if it is unbalanced, returns the new root of the subtree
+			int balance(int a);
+
+			static sf::FloatRect combine(const sf::FloatRect& one, const sf::FloatRect& two);
+			static float perimeter(const sf::FloatRect& rect);
+			static bool overlaps(const sf::FloatRect& one, const sf::FloatRect& two);
+			static bool contains(const sf::FloatRect& outer, const sf::FloatRect& inner);
+
+			std::vector<Node> nodes;
+			int root;
+			int freeList;
+			std::size_t leaves;
+
+			float margin;
+
+			// reused by queries, so they don't allocate
+			mutable std::vector<int> stack;
+	};
+
+	template<typename F>
+	void AABBTree::query(const sf::FloatRect& bounds, F func) const
+	{
+		if(root == NONE)
+			return;
+
+		// the stack is shared, nested queries work on top of the entries below base
+		std::size_t base = stack.size();
+		stack.push_back(root);
+
+		while(stack.size() > base)
+		{
+			int n = stack.back();
+			stack.pop_back();
+
+			const Node& node = nodes[n];
+
+			if(!overlaps(node.bounds, bounds))
+				continue;
+
+			if(node.isLeaf())
+				func(n);
+			else
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	template<typename F>
+	void AABBTree::raycast(const sf::Vector2f& from, const sf::Vector2f& to, F func) const
+	{
+		if(root == NONE)
+			return;
+
+		const sf::Vector2f delta = to - from;
+		float maxFraction = 1;
+		float fraction = 0;
+
+		std::size_t base = stack.size();
+		stack.push_back(root);
+
+		while(stack.size() > base)
+		{
+			int n = stack.back();
+			stack.pop_back();
+
+			const Node& node = nodes[n];
+
+			if(!intersectRay(node.bounds, from, delta, maxFraction, fraction))
+				continue;
+
+			if(node.isLeaf())
+			{
+				maxFraction = func(n, maxFraction);
+				continue;
+			}
+
+			// the nearer child on top, so what it hits cuts the ray before the farther one is visited
+			float left = 0;
+			float right = 0;
+			bool hitsLeft = intersectRay(nodes[node.left].bounds, from, delta, maxFraction, left);
+			bool hitsRight = intersectRay(nodes[node.right].bounds, from, delta, maxFraction, right);
+
+			if(hitsLeft && hitsRight)
+			{
+				stack.push_back(left < right ? node.right : node.left);
+				stack.push_back(left < right ? node.left : node.right);
+			}
+			else if(hitsLeft)
+				stack.push_back(node.left);
+			else if(hitsRight)
+				stack.push_back(node.right);
+		}
+	}
+}
+
+#endif // AABBTREE_HPP
@@ -11,8 +11,8 @@
 namespace swift
 {
 	Collision::Collision(Entity& f, Entity& s)
-	:	one(f),
-		two(s),
+	:	one(&f),
+		two(&s),
 		position({-1.f, -1.f}),
 		result(false)
 	{
@@ -21,12 +21,12 @@ namespace swift
 
 	Entity& Collision::getFirstEntity() const
 	{
-		return one;
+		return *one;
 	}
 	
 	Entity& Collision::getSecondEntity() const
 	{
-		return two;
+		return *two;
 	}
 
 	const sf::Vector2f& Collision::getPosition() const
@@ -41,8 +41,8 @@ namespace swift
 
 	bool Collision::handle()
 	{
-		Physical* physOne = one.get<Physical>();
-		Physical* physTwo = two.get<Physical>();
+		Physical* physOne = one->get<Physical>();
+		Physical* physTwo = two->get<Physical>();
 		
 		// make sure we're actually dealing with collidable entities
 		if(!(physOne->collides && physTwo->collides))
@@ -52,8 +52,12 @@ namespace swift
 		if(physOne->zIndex != physTwo->zIndex)
 			return false;
 		
+		// and that they collide with each other. The broadphase usually dropped the pair already
+		if(!physOne->interacts(*physTwo))
+			return false;
+		
 		// make sure at least one of the entities is able to move
-		if(!(one.has<Movable>() || two.has<Movable>()))
+		if(!(one->has<Movable>() || two->has<Movable>()))
 			return false;
 		
 		return separatingAxisTheorem();
@@ -61,8 +65,8 @@ namespace swift
 	
 	bool Collision::circularCollision()
 	{
-		Physical* physOne = one.get<Physical>();
-		Physical* physTwo = two.get<Physical>();
+		Physical* physOne = one->get<Physical>();
+		Physical* physTwo = two->get<Physical>();
 		
 		// get the center points of the entities
 		sf::Vector2f centerPosOne = physOne->position + static_cast<sf::Vector2f>(physOne->size) / 2.f;
@@ -97,89 +101,65 @@ namespace swift
 	
 	bool Collision::separatingAxisTheorem()
 	{
-		Physical* physOne = one.get<Physical>();
-		Physical* physTwo = two.get<Physical>();
-			
-		// get length of diagonals
-		float oneDiagLength = std::sqrt(physOne->size.x * physOne->size.x + physOne->size.y * physOne->size.y);
-		float oneDiagAngle = std::atan2(physOne->size.y, physOne->size.x) * 180.f / math::PI;
-		float twoDiagLength = std::sqrt(physTwo->size.x * physTwo->size.x + physTwo->size.y * physTwo->size.y);
-		float twoDiagAngle = std::atan2(physTwo->size.y, physTwo->size.x) * 180.f / math::PI;
-		
-		// points of the rects clockwise
-		sf::Vector2f oneVerts[4];
-		oneVerts[0] = physOne->position;
-		oneVerts[1] = physOne->position + sf::Vector2f(physOne->size.x * std::cos(physOne->angle * math::PI / 180.f), physOne->size.x * std::sin(physOne->angle * math::PI / 180.f));
-		oneVerts[2] = physOne->position + sf::Vector2f(oneDiagLength * std::cos((physOne->angle + oneDiagAngle) * math::PI / 180.f), oneDiagLength * std::sin((physOne->angle + oneDiagAngle) * math::PI / 180.f));
-		oneVerts[3] = physOne->position + sf::Vector2f(physOne->size.y * std::cos((physOne->angle + 90.f) * math::PI / 180.f), physOne->size.y * std::sin((physOne->angle + 90.f) * math::PI / 180.f));
-		
-		sf::Vector2f twoVerts[4];
-		twoVerts[0] = physTwo->position;
-		twoVerts[1] = physTwo->position + sf::Vector2f(physTwo->size.x * std::cos(physTwo->angle * math::PI / 180.f), physTwo->size.x * std::sin(physTwo->angle * math::PI / 180.f));
-		twoVerts[2] = physTwo->position + sf::Vector2f(twoDiagLength * std::cos((physTwo->angle + twoDiagAngle) * math::PI / 180.f), twoDiagLength * std::sin((physTwo->angle + twoDiagAngle) * math::PI / 180.f));
-		twoVerts[3] = physTwo->position + sf::Vector2f(physTwo->size.y * std::cos((physTwo->angle + 90.f) * math::PI / 180.f), physTwo->size.y * std::sin((physTwo->angle + 90.f) * math::PI / 180.f));
-		
-		// axes to test from rect 1
-		sf::Vector2f oneAxes[4];
-		oneAxes[0] = math::normalY(oneVerts[1] - oneVerts[0]);
-		oneAxes[1] = math::normalY(oneVerts[2] - oneVerts[1]);
-		oneAxes[2] = math::normalY(oneVerts[3] - oneVerts[2]);
-		oneAxes[3] = math::normalY(oneVerts[0] - oneVerts[3]);
-		
-		// axes to test from rect 2
-		sf::Vector2f twoAxes[4];
-		twoAxes[0] = math::normalY(twoVerts[1] - twoVerts[0]);
-		twoAxes[1] = math::normalY(twoVerts[2] - twoVerts[1]);
-		twoAxes[2] = math::normalY(twoVerts[3] - twoVerts[2]);
-		twoAxes[3] = math::normalY(twoVerts[0] - twoVerts[3]);
-		
-		// check for overlap between projections onto axes
+		Physical* physOne = one->get<Physical>();
+		Physical* physTwo = two->get<Physical>();
+		
+		// degenerate rects have no edge normals to test
+		if(physOne->size.x == 0 || physOne->size.y == 0 || physTwo->size.x == 0 || physTwo->size.y == 0)
+			return false;
+		
 		float overlap = -1.f;
 		sf::Vector2f smallestAxis;
-		for(int i = 0; i < 4; i++)
+		
+		if(physOne->angle == 0.f && physTwo->angle == 0.f)
 		{
-			Projection<float> p1(oneAxes[i], oneVerts);
-			Projection<float> p2(oneAxes[i], twoVerts);
-			
-			float o = p1.overlap(p2);
-			if(o == 0.f)
+			if(!axisAlignedOverlap(*physOne, *physTwo, overlap, smallestAxis))
 				return false;
-			
-			if(overlap < 0.f || o < overlap)
-			{
-				overlap = o;
-				smallestAxis = oneAxes[i];
-			}
 		}
-		
-		for(int i = 0; i < 4; i++)
+		else
 		{
-			Projection<float> p1(twoAxes[i], oneVerts);
-			Projection<float> p2(twoAxes[i], twoVerts);
+			const Physical::Box& boxOne = physOne->getBox();
+			const Physical::Box& boxTwo = physTwo->getBox();
 			
-			float o = p1.overlap(p2);
-			if(o == 0.f)
-				return false;
+			sf::Vector2f oneVerts[4] = {boxOne.vertices[0], boxOne.vertices[1], boxOne.vertices[2], boxOne.vertices[3]};
+			sf::Vector2f twoVerts[4] = {boxTwo.vertices[0], boxTwo.vertices[1], boxTwo.vertices[2], boxTwo.vertices[3]};
+			
+			// check for overlap between projections onto each rect's edge normals.
+			// opposite edges have opposite normals, so one projection serves both
+			const Physical::Box* boxes[2] = {&boxOne, &boxTwo};
 			
-			if(overlap < 0.f || o < overlap)
+			for(auto& box : boxes)
 			{
-				overlap = o;
-				smallestAxis = twoAxes[i];
+				Projection<float> p1[2] = {{box->axes[0], oneVerts}, {box->axes[1], oneVerts}};
+				Projection<float> p2[2] = {{box->axes[0], twoVerts}, {box->axes[1], twoVerts}};
+				
+				for(int i = 0; i < 4; i++)
+				{
+					float o = i < 2 ? p1[i].overlap(p2[i]) : p1[i - 2].reversed().overlap(p2[i - 2].reversed());
+					if(o == 0.f)
+						return false;
+					
+					if(overlap < 0.f || o < overlap)
+					{
+						overlap = o;
+						smallestAxis = i < 2 ? box->axes[i] : -box->axes[i - 2];
+					}
+				}
 			}
 		}
 		
 		// well, since we're here, they collided. now to handle the collision...
 		// if both are movable, move both
-		if(one.has<Movable>() && two.has<Movable>())
+		if(one->has<Movable>() && two->has<Movable>())
 		{
-			one.get<Physical>()->position -= smallestAxis * (overlap / 2.f);
-			two.get<Physical>()->position += smallestAxis * (overlap / 2.f);
+			one->get<Physical>()->position -= smallestAxis * (overlap / 2.f);
+			two->get<Physical>()->position += smallestAxis * (overlap / 2.f);
 		}
 		// only one is a movable
 		else
 		{
-			Physical* movable = one.has<Movable>() ? one.get<Physical>() : two.get<Physical>();
-			Physical* stuck = one.has<Movable>() ? two.get<Physical>() : one.get<Physical>();
+			Physical* movable = one->has<Movable>() ? one->get<Physical>() : two->get<Physical>();
+			Physical* stuck = one->has<Movable>() ? two->get<Physical>() : one->get<Physical>();
 			
 			movable->position -= (smallestAxis * overlap);
 		}
@@ -187,6 +167,39 @@ namespace swift
 		return true;
 	}
 	
+	bool Collision::axisAlignedOverlap(const Physical& physOne, const Physical& physTwo, float& overlap, sf::Vector2f& smallestAxis)
+	{
+		// same axes and order the general test uses for unrotated rects, without the trig and projections
+		Projection<float> oneX(physOne.position.x, physOne.position.x + physOne.size.x);
+		Projection<float> oneY(physOne.position.y, physOne.position.y + physOne.size.y);
+		Projection<float> twoX(physTwo.position.x, physTwo.position.x + physTwo.size.x);
+		Projection<float> twoY(physTwo.position.y, physTwo.position.y + physTwo.size.y);
+		
+		const float overlaps[4] =
+		{
+			oneY.overlap(twoY),
+			oneX.reversed().overlap(twoX.reversed()),
+			oneY.reversed().overlap(twoY.reversed()),
+			oneX.overlap(twoX)
+		};
+		
+		const sf::Vector2f axes[4] = {{0, 1}, {-1, 0}, {0, -1}, {1, 0}};
+		
+		for(int i = 0; i < 4; i++)
+		{
+			if(overlaps[i] == 0.f)
+				return false;
+			
+			if(overlap < 0.f || overlaps[i] < overlap)
+			{
+				overlap = overlaps[i];
+				smallestAxis = axes[i];
+			}
+		}
+		
+		return true;
+	}
+	
 	sf::Vector2f Collision::scaledDiffVector(const sf::Vector2f& oneVec, const sf::Vector2f& twoVec, float wantLength)
 	{
 		sf::Vector2f twoToOne = twoVec - oneVec;
@@ -6,7 +6,9 @@
 namespace swift
 {
 	class Entity;
+	class Physical;
 	
+	// result of testing two entities against each other. A plain value, so results can be kept in a reused buffer
 	class Collision
 	{
 		public:
@@ -25,10 +27,13 @@ namespace swift
 			bool circularCollision();
 			bool separatingAxisTheorem();
 			
+			// separating axis test for two unrotated rects
+			static bool axisAlignedOverlap(const Physical& physOne, const Physical& physTwo, float& overlap, sf::Vector2f& smallestAxis);
+			
 			static sf::Vector2f scaledDiffVector(const sf::Vector2f& oneVec, const sf::Vector2f& twoVec, float scale);
 			
-			Entity& one;
-			Entity& two;
+			Entity* one;
+			Entity* two;
 			sf::Vector2f position;
 			
 			bool result;
@@ -0,0 +1,24 @@
+#ifndef CONTACTEVENT_HPP
+#define CONTACTEVENT_HPP
+
+#include "../EntitySystem/EntityHandle.hpp"
+
+namespace swift
+{
+	// change in the contact between two entities over an update
+	struct ContactEvent
+	{
+		enum class Type
+		{
+			Begin,		// first update they collided
+			Stay,		// still colliding
+			End			// stopped colliding, or one of them is gone
+		};
+		
+		Type type;
+		EntityHandle one;
+		EntityHandle two;
+	};
+}
+
+#endif // CONTACTEVENT_HPP
@@ -29,6 +29,18 @@ namespace swift
 				}
 			}
 			
+			Projection(T mn, T mx)
+			:	min(mn),
+				max(mx)
+			{
+			}
+			
+			// projection onto the opposite axis
+			Projection<T> reversed() const
+			{
+				return {-max, -min};
+			}
+			
 			T getMin() const
 			{
 				return min;
@@ -0,0 +1,196 @@
+#include "SpatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace swift
+{
+	SpatialGrid::SpatialGrid(const sf::Vector2f& cs)
+	:	cellSize(0, 0),
+		mark(0)
+	{
+		setCellSize(cs);
+	}
+
+	void SpatialGrid::setCellSize(const sf::Vector2f& cs)
+	{
+		sf::Vector2f size = {cs.x > 0 ? cs.x : 32.f, cs.y > 0 ? cs.y : 32.f};
+
+		if(size == cellSize)
+			return;
+
+		cellSize = size;
+
+		// existing items are in the wrong cells now
+		cells.clear();
+		clear();
+	}
+
+	const sf::Vector2f& SpatialGrid::getCellSize() const
+	{
+		return cellSize;
+	}
+
+	void SpatialGrid::clear()
+	{
+		// cells that stay empty are dropped once they far outnumber the items, so the map can't grow forever
+		if(cells.size() > items.size() * 4 + 1024)
+			cells.clear();
+		else
+		{
+			for(auto& c : cells)
+				c.second.clear();
+		}
+
+		for(auto& i : items)
+			ranges[i].used = false;
+
+		items.clear();
+		layers.clear();
+	}
+
+	void SpatialGrid::insert(unsigned item, const sf::FloatRect& bounds, unsigned layer, unsigned category, unsigned mask)
+	{
+		if(item >= ranges.size())
+		{
+			ranges.resize(item + 1, {0, 0, 0, 0, 0, 0, 0, false});
+			marks.resize(item + 1, 0);
+		}
+
+		// already inserted
+		if(ranges[item].used)
+			return;
+
+		Range range = getRange(bounds, layer);
+		range.category = category;
+		range.mask = mask;
+		ranges[item] = range;
+		items.push_back(item);
+
+		if(std::find(layers.begin(), layers.end(), layer) == layers.end())
+			layers.push_back(layer);
+
+		for(int y = range.minY; y <= range.maxY; y++)
+			for(int x = range.minX; x <= range.maxX; x++)
+				cells[key(x, y, layer)].push_back(item);
+	}
+
+	void SpatialGrid::getPairs(std::vector<Pair>& pairs) const
+	{
+		for(auto& a : items)
+		{
+			const Range& ra = ranges[a];
+
+			for(int y = ra.minY; y <= ra.maxY; y++)
+			{
+				for(int x = ra.minX; x <= ra.maxX; x++)
+				{
+					const std::vector<unsigned>* cell = getCell(x, y, ra.layer);
+
+					if(!cell)
+						continue;
+
+					for(auto& b : *cell)
+					{
+						if(b <= a)
+							continue;
+
+						const Range& rb = ranges[b];
+
+						// before anything else is looked at, projectiles that ignore each other cost one test
+						if((ra.category & rb.mask) == 0 || (rb.category & ra.mask) == 0)
+							continue;
+
+						// items sharing several cells are only paired in the first one they share
+						if(x == std::max(ra.minX, rb.minX) && y == std::max(ra.minY, rb.minY))
+							pairs.emplace_back(a, b);
+					}
+				}
+			}
+		}
+	}
+
+	void SpatialGrid::query(const sf::FloatRect& bounds, unsigned layer, std::vector<unsigned>& found) const
+	{
+		query(getRange(bounds, layer), false, found);
+	}
+
+	void SpatialGrid::query(const sf::FloatRect& bounds, std::vector<unsigned>& found) const
+	{
+		query(getRange(bounds, 0), true, found);
+	}
+
+	std::size_t SpatialGrid::size() const
+	{
+		return items.size();
+	}
+
+	SpatialGrid::Range SpatialGrid::getRange(const sf::FloatRect& bounds, unsigned layer) const
+	{
+		Range range;
+
+		range.minX = static_cast<int>(std::floor(bounds.left / cellSize.x));
+		range.minY = static_cast<int>(std::floor(bounds.top / cellSize.y));
+		range.maxX = static_cast<int>(std::floor((bounds.left + bounds.width) / cellSize.x));
+		range.maxY = static_cast<int>(std::floor((bounds.top + bounds.height) / cellSize.y));
+		range.layer = layer;
+		range.category = ~0u;
+		range.mask = ~0u;
+		range.used = true;
+
+		return range;
+	}
+
+	std::uint64_t SpatialGrid::key(int x, int y, unsigned layer)
+	{
+		// 24 bits per coordinate, 16 for the layer
+		std::uint64_t kx = static_cast<std::uint32_t>(x) & 0xffffff;
+		std::uint64_t ky = static_cast<std::uint32_t>(y) & 0xffffff;
+		std::uint64_t kl = layer & 0xffff;
+
+		return (kl << 48) | (ky << 24) | kx;
+	}
+
+	const std::vector<unsigned>* SpatialGrid::getCell(int x, int y, unsigned layer) const
+	{
+		auto it = cells.find(key(x, y, layer));
+
+		return it != cells.end() && !it->second.empty() ? &it->second : nullptr;
+	}
+
+	void SpatialGrid::query(const Range& range, bool anyLayer, std::vector<unsigned>& found) const
+	{
+		// wrapped around, start over so old stamps can't match
+		if(++mark == 0)
+		{
+			std::fill(marks.begin(), marks.end(), 0);
+			mark = 1;
+		}
+
+		for(auto& l : layers)
+		{
+			if(!anyLayer && l != range.layer)
+				continue;
+
+			for(int y = range.minY; y <= range.maxY; y++)
+			{
+				for(int x = range.minX; x <= range.maxX; x++)
+				{
+					const std::vector<unsigned>* cell = getCell(x, y, l);
+
+					if(!cell)
+						continue;
+
+					for(auto& i : *cell)
+					{
+						if(marks[i] != mark)
+						{
+							marks[i] = mark;
+							found.push_back(i);
+						}
+					}
+				}
+			}
+		}
+	}
+}
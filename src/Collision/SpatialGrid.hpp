@@ -0,0 +1,87 @@
+#ifndef SPATIALGRID_HPP
+#define SPATIALGRID_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+namespace swift
+{
+	// uniform grid broadphase. Items are inserted with their bounds and a layer,
+	// items only pair up with items on the same layer, and only if each one's category is in the other's mask.
+	// cells are hashed, so the grid does not need to know the size of the world.
+	// clearing keeps the cell buffers, so rebuilding every tick does not allocate once warmed up
+	class SpatialGrid
+	{
+		public:
+			using Pair = std::pair<unsigned, unsigned>;
+
+			explicit SpatialGrid(const sf::Vector2f& cellSize = {32, 32});
+
+			void setCellSize(const sf::Vector2f& cs);
+			const sf::Vector2f& getCellSize() const;
+
+			// removes all items
+			void clear();
+
+			// item is a caller defined index, usually a position in a vector of entities
+			void insert(unsigned item, const sf::FloatRect& bounds, unsigned layer, unsigned category = ~0u, unsigned mask = ~0u);
+
+			// appends every pair of items on the same layer whose cells overlap and whose masks let them interact, each pair only once.
+			// pairs are only candidates, the items' bounds might not actually overlap
+			void getPairs(std::vector<Pair>& pairs) const;
+
+			// appends items on layer whose cells overlap bounds, each item only once
+			void query(const sf::FloatRect& bounds, unsigned layer, std::vector<unsigned>& items) const;
+
+			// appends items on any layer whose cells overlap bounds, each item only once
+			void query(const sf::FloatRect& bounds, std::vector<unsigned>& items) const;
+
+			std::size_t size() const;
+
+		private:
+			// inclusive range of cells an item covers
+			struct Range
+			{
+				int minX;
+				int minY;
+				int maxX;
+				int maxY;
+				unsigned layer;
+				unsigned category;
+				unsigned mask;
+				bool used;
+			};
+
+			Range getRange(const sf::FloatRect& bounds, unsigned layer) const;
+
+			static std::uint64_t key(int x, int y, unsigned layer);
+
+			const std::vector<unsigned>* getCell(int x, int y, unsigned layer) const;
+
+			void query(const Range& range, bool anyLayer, std::vector<unsigned>& items) const;
+
+			sf::Vector2f cellSize;
+
+			std::unordered_map<std::uint64_t, std::vector<unsigned>> cells;
+
+			// indexed by item
+			std::vector<Range> ranges;
+
+			// items in insertion order
+			std::vector<unsigned> items;
+
+			// layers with at least one item
+			std::vector<unsigned> layers;
+
+			// stamps, so queries can skip items they already returned without clearing a set
+			mutable std::vector<unsigned> marks;
+			mutable unsigned mark;
+	};
+}
+
+#endif // SPATIALGRID_HPP
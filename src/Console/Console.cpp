@@ -1,29 +1,33 @@
 #include "Console.hpp"
 #include <sstream>
+#include <algorithm>
 
 namespace swift
 {
 	const int Console::FONT_SIZE = 14;
+	const std::size_t Console::SCROLLBACK = 1024;
 	
 	Console::Console(int w, int h, const sf::Font& f, const std::string& p)
 		:	background(sf::Vector2f(w, h)),
 		    font(f),
+		    lineHeight(f.getLineSpacing(FONT_SIZE)),
 		    promptStr(p),
+		    prompt(promptStr, font, FONT_SIZE),
+		    lines(SCROLLBACK),
+		    firstLine(0),
+		    lineCount(0),
+		    scroll(0),
 		    activated(false)
 	{
 		background.setFillColor(sf::Color(0, 0, 0, 190));
 		background.setOutlineThickness(2);
 		background.setOutlineColor(sf::Color(60, 60, 60));
 		
-		prompts.emplace_front(promptStr, font, FONT_SIZE);
-		prompts[0].setPosition(0, 0);
-		
 		command.setString(commandStr);
 		command.setFont(font);
 		command.setCharacterSize(FONT_SIZE);
-		command.setPosition(prompts[0].getGlobalBounds().width + 2, prompts[0].getPosition().y);
-		// work by lines... 1 sf::Text per line, but 2 strings per line, 1 for the prompt, 1 for the command
-		// may want a Line subclass for this
+		
+		layout();
 	}
 
 	Console::~Console()
@@ -45,13 +49,14 @@ namespace swift
 					command.setString(commandStr);
 
 					// wrap around
-					if(command.getGlobalBounds().width + prompts[0].getGlobalBounds().width >= background.getGlobalBounds().width)
+					if(command.getGlobalBounds().width + prompt.getGlobalBounds().width >= background.getGlobalBounds().width)
 					{
 						char temp = commandStr[commandStr.getSize() - 1];
 						commandStr.erase(commandStr.getSize() - 1);
 						commandStr += '\n';
 						commandStr += temp;
 						command.setString(commandStr);
+						layout();
 					}
 				}
 				else if(t == 8)
@@ -59,6 +64,7 @@ namespace swift
 					if(commandStr.getSize() > 0)
 						commandStr.erase(commandStr.getSize() - 1);
 					command.setString(commandStr);
+					layout();
 				}
 				else if(t == 13)
 				{
@@ -66,39 +72,20 @@ namespace swift
 						return;
 
 					// get prompt + command
-					lines.emplace_front(promptStr + commandStr, font, FONT_SIZE);
-					lines[0].setPosition(prompts[0].getPosition());
-					prompts.pop_front();	// remove to get rid of overwriting
+					newLine();
+					write(promptStr + commandStr);
 
-					// output
-					lines.emplace_front(handleCommand(commandStr), font, FONT_SIZE);
-					lines[0].setPosition(0, command.getGlobalBounds().top + command.getGlobalBounds().height);
-
-					// new prompt
-					prompts.emplace_front(promptStr, font, FONT_SIZE);
-					prompts[0].setPosition(0, lines[0].getGlobalBounds().top + lines[0].getGlobalBounds().height);
+					// output, after anything the command wrote itself
+					std::string output = handleCommand(commandStr);
+					newLine();
+					write(output);
 
 					commands.emplace_front(commandStr);
 					commandStr.clear();
 					command.setString(commandStr);
-					command.setPosition(prompts[0].getGlobalBounds().width + 2, prompts[0].getPosition().y);
-
-					// pop off the top if we start going out the bottom of the console
-					if(prompts[0].getGlobalBounds().top + prompts[0].getGlobalBounds().height >= background.getGlobalBounds().height ||
-					        lines[0].getGlobalBounds().top + lines[0].getGlobalBounds().height >= background.getGlobalBounds().height)
-						lines.pop_back();
-
-					// check for going out of the bottom, then move everything up a line while we are going out the bottom
-					while(prompts[0].getGlobalBounds().top + prompts[0].getGlobalBounds().height >= background.getGlobalBounds().height ||
-					        lines[0].getGlobalBounds().top + lines[0].getGlobalBounds().height >= background.getGlobalBounds().height)
-					{
-						// pull everything up a line
-						for(auto &p : prompts)
-							p.setPosition(p.getPosition().x, p.getPosition().y - (FONT_SIZE + 2));
-						command.setPosition(command.getPosition().x, command.getPosition().y - (FONT_SIZE + 2));
-						for(auto &l : lines)
-							l.setPosition(l.getPosition().x, l.getPosition().y - (FONT_SIZE + 2));
-					}
+					
+					scroll = 0;
+					layout();
 				}
 				else if(t == 127)
 				{
@@ -122,6 +109,13 @@ namespace swift
 
 				}
 			}
+			else if(event.type == sf::Event::MouseWheelMoved)
+			{
+				std::size_t most = lineCount - getVisibleLines();
+				int to = static_cast<int>(scroll) + event.mouseWheel.delta;
+				
+				scroll = to < 0 ? 0 : std::min(static_cast<std::size_t>(to), most);
+			}
 		}
 	}
 
@@ -142,14 +136,14 @@ namespace swift
 
 	Console& Console::operator <<(const std::string& str)
 	{
-		lines[0].setString(lines[0].getString() + str);
+		write(str);
 
 		return *this;
 	}
 
 	Console& Console::operator <<(char c)
 	{
-		lines[0].setString(lines[0].getString() + c);
+		write(std::string(1, c));
 
 		return *this;
 	}
@@ -177,12 +171,98 @@ namespace swift
 	{
 		if(activated)
 		{
-			target.draw(background, states);
-			for(auto& p : prompts)
-				target.draw(p, states);
-			target.draw(command, states);
-			for(auto& l : lines)
-				target.draw(l, states);
+			// one draw for the background, one for all the text. Only the lines on screen are made
+			batch.clear();
+			batch.add(background);
+
+			std::size_t shown = getVisibleLines();
+			std::size_t first = lineCount - shown - scroll;
+
+			for(std::size_t i = 0; i < shown; i++)
+				batch.addText(getLine(first + i), font, FONT_SIZE, {0, i * lineHeight});
+
+			batch.add(prompt);
+			batch.add(command);
+
+			target.draw(batch, states);
+		}
+	}
+
+	std::string& Console::getLine(std::size_t i)
+	{
+		return lines[(firstLine + i) % lines.size()];
+	}
+
+	const std::string& Console::getLine(std::size_t i) const
+	{
+		return lines[(firstLine + i) % lines.size()];
+	}
+
+	void Console::newLine()
+	{
+		if(lineCount < lines.size())
+		{
+			lineCount++;
+		}
+		else
+		{
+			firstLine = (firstLine + 1) % lines.size();
+		}
+
+		// keeps the dropped line's memory
+		getLine(lineCount - 1).clear();
+
+		// a scrolled back view stays on the lines it was on, layout() keeps it in range
+		if(scroll != 0)
+			scroll++;
+	}
+
+	void Console::write(const std::string& str)
+	{
+		if(lineCount == 0)
+			newLine();
+
+		std::size_t start = 0;
+		std::size_t end = str.find('\n');
+
+		while(end != std::string::npos)
+		{
+			getLine(lineCount - 1).append(str, start, end - start);
+			newLine();
+
+			start = end + 1;
+			end = str.find('\n', start);
+		}
+
+		getLine(lineCount - 1).append(str, start, std::string::npos);
+		layout();
+	}
+
+	std::size_t Console::getVisibleLines() const
+	{
+		std::size_t rows = static_cast<std::size_t>(background.getSize().y / lineHeight);
+		std::size_t commandRows = 1;
+
+		for(std::size_t i = 0; i < commandStr.getSize(); i++)
+		{
+			if(commandStr[i] == '\n')
+				commandRows++;
 		}
+
+		rows = rows > commandRows ? rows - commandRows : 0;
+		return std::min(lineCount, rows);
+	}
+
+	void Console::layout()
+	{
+		std::size_t shown = getVisibleLines();
+
+		if(scroll > lineCount - shown)
+			scroll = lineCount - shown;
+
+		float y = shown * lineHeight;
+
+		prompt.setPosition(0, y);
+		command.setPosition(prompt.getGlobalBounds().width + 2, y);
 	}
 }
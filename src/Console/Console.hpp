@@ -6,6 +6,8 @@
 #include <functional>
 #include <map>
 #include <deque>
+#include <vector>
+#include <cstddef>
 
 #include <SFML/System/String.hpp>
 #include <SFML/Window/Event.hpp>
@@ -15,6 +17,8 @@
 #include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/Color.hpp>
 
+#include "../GUI/Batch.hpp"
+
 namespace swift
 {
 	typedef std::vector<std::string> ArgVec;
@@ -41,24 +45,45 @@ namespace swift
 			std::string handleCommand(const std::string& c);
 			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 			
+			// scrollback, oldest first. It's a ring, so a full one drops its oldest line for a new one
+			std::string& getLine(std::size_t i);
+			const std::string& getLine(std::size_t i) const;
+			void newLine();
+			
+			// appends to the last line, starting new ones at each '\n'
+			void write(const std::string& str);
+			
+			// how many lines fit above the prompt
+			std::size_t getVisibleLines() const;
+			
+			// puts the prompt under the last visible line
+			void layout();
+			
 			sf::RectangleShape background;
 
 			const sf::Font& font;
+			float lineHeight;
 
 			const sf::String promptStr;
-			std::deque<sf::Text> prompts;
+			sf::Text prompt;
 
 			sf::String commandStr;
 			sf::Text command;
 			std::deque<sf::String> commands;
 
-			std::deque<sf::Text> lines;
+			std::vector<std::string> lines;
+			std::size_t firstLine;
+			std::size_t lineCount;
+			std::size_t scroll;		// lines up from the newest
 
 			std::map<std::string, CommandFunc> commandList;
 
+			mutable cstr::Batch batch;
+
 			bool activated;
 			
 			static const int FONT_SIZE;
+			static const std::size_t SCROLLBACK;
 	};
 }
 
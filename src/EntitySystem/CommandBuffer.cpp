@@ -0,0 +1,35 @@
+#include "CommandBuffer.hpp"
+
+namespace swift
+{
+	void CommandBuffer::create(Entity* entity)
+	{
+		created.push_back(entity);
+	}
+
+	void CommandBuffer::destroy(EntityHandle entity)
+	{
+		destroyed.push_back(entity);
+	}
+
+	bool CommandBuffer::empty() const
+	{
+		return created.empty() && destroyed.empty();
+	}
+
+	void CommandBuffer::clear()
+	{
+		created.clear();
+		destroyed.clear();
+	}
+
+	const std::vector<Entity*>& CommandBuffer::getCreated() const
+	{
+		return created;
+	}
+
+	const std::vector<EntityHandle>& CommandBuffer::getDestroyed() const
+	{
+		return destroyed;
+	}
+}
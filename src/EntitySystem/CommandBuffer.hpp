@@ -0,0 +1,33 @@
+#ifndef COMMANDBUFFER_HPP
+#define COMMANDBUFFER_HPP
+
+#include <vector>
+
+#include "EntityHandle.hpp"
+
+namespace swift
+{
+	class Entity;
+
+	// structural changes requested while a World is updating.
+	// created entities are usable right away through their handle, but only join the world's entity list on flush.
+	// destroyed entities stay alive until the flush
+	class CommandBuffer
+	{
+		public:
+			void create(Entity* entity);
+			void destroy(EntityHandle entity);
+
+			bool empty() const;
+			void clear();
+
+			const std::vector<Entity*>& getCreated() const;
+			const std::vector<EntityHandle>& getDestroyed() const;
+
+		private:
+			std::vector<Entity*> created;
+			std::vector<EntityHandle> destroyed;
+	};
+}
+
+#endif // COMMANDBUFFER_HPP
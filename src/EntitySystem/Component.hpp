@@ -4,6 +4,8 @@
 #include <string>
 #include <map>
 
+#include "../Serialization/ByteStream.hpp"
+
 namespace swift
 {
 	class Component
@@ -15,8 +17,61 @@ namespace swift
 			
 			virtual std::map<std::string, std::string> serialize() const = 0;
 			virtual void unserialize(const std::map<std::string, std::string>& variables) = 0;
+			
+			// binary form. Each component starts with its schema version, so data written by older
+			// versions can still be read. By default, the string map is written (version 0)
+			virtual void write(ByteWriter& out) const
+			{
+				const std::map<std::string, std::string> variables = serialize();
+				
+				out.writeByte(0);
+				out.writeUInt(variables.size());
+				
+				for(auto& v : variables)
+				{
+					out.writeString(v.first);
+					out.writeString(v.second);
+				}
+			}
+			
+			// false if the data is malformed or from a newer version
+			virtual bool read(ByteReader& in)
+			{
+				readVersion(in, 0);
+				
+				return in.good() && readMap(in);
+			}
 		
 		protected:
+			// reads the version byte, failing the reader if it is newer than latest
+			static unsigned readVersion(ByteReader& in, unsigned latest)
+			{
+				unsigned version = in.readByte();
+				
+				if(version > latest)
+					in.fail();
+				
+				return version;
+			}
+			
+			// reads the body of a version 0 component, the string map
+			bool readMap(ByteReader& in)
+			{
+				std::map<std::string, std::string> variables;
+				std::uint64_t count = in.readUInt();
+				
+				for(std::uint64_t i = 0; i < count && in.good(); i++)
+				{
+					std::string name = in.readString();
+					variables.emplace(name, in.readString());
+				}
+				
+				if(in.good())
+					unserialize(variables);
+				
+				return in.good();
+			}
+			
 			template<typename T>
 			static void initMember(const std::string& name, const std::map<std::string, std::string>& variables, T& var, T def);
 	};
@@ -39,7 +94,8 @@ namespace swift
 	{
 		if(variables.find(name) != variables.end())
 		{
-			var = std::stoi(variables.at(name));
+			// stoi can't take the top bit, masks have it
+			var = static_cast<unsigned int>(std::stoul(variables.at(name)));
 		}
 		else
 		{
@@ -0,0 +1,178 @@
+#ifndef COMPONENTPOOL_HPP
+#define COMPONENTPOOL_HPP
+
+#include <vector>
+#include <limits>
+#include <cstddef>
+
+#include "Component.hpp"
+#include "../Memory/PoolStats.hpp"
+
+namespace swift
+{
+	// type-erased interface, so pools can be reached by component type id
+	class BaseComponentPool
+	{
+		public:
+			static constexpr unsigned NONE = std::numeric_limits<unsigned>::max();
+
+			virtual ~BaseComponentPool() = default;
+
+			virtual Component* add(unsigned entity) = 0;
+			virtual bool remove(unsigned entity) = 0;
+			virtual Component* get(unsigned entity) = 0;
+
+			// copies the component that 'from' has in source onto 'to' in this pool
+			virtual Component* copy(unsigned to, BaseComponentPool& source, unsigned from) = 0;
+
+			virtual std::size_t size() const = 0;
+
+			virtual void reserve(std::size_t count) = 0;
+			virtual PoolStats getStats() const = 0;
+
+			// bytes the pool holds, components and tables
+			virtual std::size_t getMemory() const = 0;
+	};
+
+	// stores every component of one type contiguously.
+	// entities index into the packed array through a sparse table, removal swaps with the last element.
+	// pointers into the pool are only valid until the next add or remove on it
+	template<typename C>
+	class ComponentPool : public BaseComponentPool
+	{
+		public:
+			ComponentPool()
+			:	peak(0),
+				growths(0)
+			{
+			}
+
+			virtual C* add(unsigned entity)
+			{
+				if(entity >= sparse.size())
+					sparse.resize(entity + 1, static_cast<unsigned>(NONE));
+
+				if(sparse[entity] != NONE)
+					return &components[sparse[entity]];
+
+				if(components.size() == components.capacity())
+					growths++;
+
+				sparse[entity] = components.size();
+				components.emplace_back();
+				owners.push_back(entity);
+
+				if(components.size() > peak)
+					peak = components.size();
+
+				return &components.back();
+			}
+
+			virtual bool remove(unsigned entity)
+			{
+				if(entity >= sparse.size() || sparse[entity] == NONE)
+					return false;
+
+				unsigned index = sparse[entity];
+				unsigned last = components.size() - 1;
+
+				if(index != last)
+				{
+					components[index] = std::move(components[last]);
+					owners[index] = owners[last];
+					sparse[owners[index]] = index;
+				}
+
+				components.pop_back();
+				owners.pop_back();
+				sparse[entity] = NONE;
+
+				return true;
+			}
+
+			virtual C* get(unsigned entity)
+			{
+				if(entity >= sparse.size() || sparse[entity] == NONE)
+					return nullptr;
+
+				return &components[sparse[entity]];
+			}
+
+			virtual C* copy(unsigned to, BaseComponentPool& source, unsigned from)
+			{
+				C* other = static_cast<ComponentPool<C>&>(source).get(from);
+
+				if(other == nullptr)
+					return nullptr;
+
+				// copy first, adding may reallocate if source is this pool
+				C value = *other;
+
+				C* comp = add(to);
+				*comp = std::move(value);
+
+				return comp;
+			}
+
+			virtual std::size_t size() const
+			{
+				return components.size();
+			}
+
+			// storage is never released, so reserving for the expected peak avoids growing mid-game
+			virtual void reserve(std::size_t count)
+			{
+				components.reserve(count);
+				owners.reserve(count);
+			}
+
+			virtual PoolStats getStats() const
+			{
+				PoolStats stats;
+
+				stats.live = components.size();
+				stats.peak = peak;
+				stats.capacity = components.capacity();
+				stats.growths = growths;
+
+				return stats;
+			}
+
+			virtual std::size_t getMemory() const
+			{
+				return components.capacity() * sizeof(C) + (owners.capacity() + sparse.capacity()) * sizeof(unsigned);
+			}
+
+			// packed access, for systems that stream a whole component type
+			C& operator[](std::size_t i)
+			{
+				return components[i];
+			}
+
+			const C& operator[](std::size_t i) const
+			{
+				return components[i];
+			}
+
+			// id of the entity owning the i-th packed component
+			unsigned getOwner(std::size_t i) const
+			{
+				return owners[i];
+			}
+
+			C* data()
+			{
+				return components.data();
+			}
+
+		private:
+			std::vector<C> components;
+			std::vector<unsigned> owners;
+			std::vector<unsigned> sparse;
+
+			std::size_t peak;
+			std::size_t growths;
+	};
+}
+
+#endif // COMPONENTPOOL_HPP
@@ -0,0 +1,78 @@
+#include "ComponentRegistry.hpp"
+
+#include "../Logger/Logger.hpp"
+
+namespace swift
+{
+	bool ComponentRegistry::add(unsigned id, const std::string& name, PoolFactory factory)
+	{
+		Table& table = getTable();
+
+		if(id >= MAX_COMPONENTS || table.entries[id].factory != nullptr || table.ids.find(name) != table.ids.end())
+		{
+			SWIFT_WARNING(Entities, "Could not register component \"" << name << "\" with id " << id << ", it is already taken.\n");
+			return false;
+		}
+
+		table.entries[id].name = name;
+		table.entries[id].factory = factory;
+		table.ids.emplace(name, id);
+
+		return true;
+	}
+
+	BaseComponentPool* ComponentRegistry::createPool(unsigned id)
+	{
+		const Table& table = getTable();
+
+		if(id < MAX_COMPONENTS && table.entries[id].factory)
+			return table.entries[id].factory();
+		else
+			return nullptr;
+	}
+
+	unsigned ComponentRegistry::getID(const std::string& c)
+	{
+		const Table& table = getTable();
+
+		auto it = table.ids.find(c);
+
+		return it != table.ids.end() ? it->second : MAX_COMPONENTS;
+	}
+
+	const std::string& ComponentRegistry::getName(unsigned id)
+	{
+		static const std::string none;
+
+		const Table& table = getTable();
+
+		return id < MAX_COMPONENTS ? table.entries[id].name : none;
+	}
+
+	ComponentRegistry::Table::Table()
+	:	entries(MAX_COMPONENTS)
+	{
+		addAll(EngineComponents());
+	}
+
+	template<typename... Cs>
+	void ComponentRegistry::Table::addAll(TypeList<Cs...>)
+	{
+		const std::string names[] = {Cs::getType()...};
+		const PoolFactory factories[] = {&makePool<Cs>...};
+		const unsigned typeIDs[] = {ComponentID<Cs>::value...};
+
+		for(unsigned i = 0; i < sizeof...(Cs); i++)
+		{
+			entries[typeIDs[i]].name = names[i];
+			entries[typeIDs[i]].factory = factories[i];
+			ids.emplace(names[i], typeIDs[i]);
+		}
+	}
+
+	ComponentRegistry::Table& ComponentRegistry::getTable()
+	{
+		static Table table;
+		return table;
+	}
+}
@@ -1,43 +1,78 @@
 #ifndef COMPONENTREGISTRY_HPP
 #define COMPONENTREGISTRY_HPP
 
-#include "Component.hpp"
-#include "Components/Animated.hpp"
-#include "Components/Controllable.hpp"
-#include "Components/Drawable.hpp"
-#include "Components/Movable.hpp"
-#include "Components/Pathfinder.hpp"
-#include "Components/Physical.hpp"
-#include "Components/Name.hpp"
-#include "Components/Noisy.hpp"
+#include <vector>
+#include <unordered_map>
+
+#include "ComponentTypes.hpp"
+#include "ComponentPool.hpp"
 
 namespace swift
 {
+	// maps component names to type ids and pool factories.
+	// engine components are always registered. Game components need an id (see SWIFT_USER_COMPONENT)
+	// and a call to add<C>() before any entity uses them by name
 	class ComponentRegistry
 	{
 		public:
-			static Component* get(const std::string& c)
+			using PoolFactory = BaseComponentPool* (*)();
+
+			// false if the id or the name is already taken
+			template<typename C>
+			static bool add()
+			{
+				return add(ComponentID<C>::value, C::getType(), &makePool<C>);
+			}
+
+			static bool add(unsigned id, const std::string& name, PoolFactory factory);
+
+			// creates an empty pool for the component with type id, nullptr if the id is unknown
+			static BaseComponentPool* createPool(unsigned id);
+
+			// returns MAX_COMPONENTS if c is not a known component
+			static unsigned getID(const std::string& c);
+
+			static const std::string& getName(unsigned id);
+
+			template<typename C>
+			static BaseComponentPool* makePool()
 			{
-				if(c == "Animated")
-					return new Animated;
-				else if(c == "Controllable")
-					return new Controllable;
-				else if(c == "Drawable")
-					return new Drawable;
-				else if(c == "Movable")
-					return new Movable;
-				else if(c == "Pathfinder")
-					return new Pathfinder;
-				else if(c == "Physical")
-					return new Physical;
-				else if(c == "Name")
-					return new Name;
-				else if(c == "Noisy")
-					return new Noisy;
-				else
-					return nullptr;
+				return new ComponentPool<C>;
 			}
+
+		private:
+			struct Entry
+			{
+				std::string name;
+				PoolFactory factory = nullptr;
+			};
+
+			struct Table
+			{
+				Table();
+
+				template<typename... Cs>
+				void addAll(TypeList<Cs...>);
+
+				std::vector<Entry> entries;		// indexed by type id
+				std::unordered_map<std::string, unsigned> ids;
+			};
+
+			static Table& getTable();
 	};
 }
 
+// gives a game component the n-th type id after the engine's, n starting at 0.
+// use at global scope, with the fully qualified type name
+#define SWIFT_USER_COMPONENT(Type, n) \
+	namespace swift \
+	{ \
+		template<> \
+		struct ComponentID<Type> \
+		{ \
+			static constexpr unsigned value = EngineComponents::size + (n); \
+			static_assert(value < MAX_COMPONENTS, "Too many component types for MAX_COMPONENTS"); \
+		}; \
+	}
+
 #endif // COMPONENTREGISTRY_HPP
@@ -0,0 +1,299 @@
+#include "ComponentStorage.hpp"
+
+namespace swift
+{
+	ComponentStorage::ComponentStorage()
+	:	pools(),
+		deferred(false)
+	{
+	}
+
+	ComponentStorage::~ComponentStorage()
+	{
+		for(auto& p : pools)
+		{
+			delete p;
+			p = nullptr;
+		}
+		
+		for(auto& v : views)
+			delete v;
+	}
+
+	unsigned ComponentStorage::create(Entity* entity)
+	{
+		unsigned id;
+
+		if(!freeIDs.empty())
+		{
+			id = freeIDs.back();
+			freeIDs.pop_back();
+			entities[id] = entity;
+		}
+		else
+		{
+			id = entities.size();
+			entities.push_back(entity);
+			masks.emplace_back();
+			generations.push_back(1);
+		}
+
+		refresh(id);
+
+		return id;
+	}
+
+	void ComponentStorage::destroy(unsigned id)
+	{
+		for(unsigned t = 0; t < MAX_COMPONENTS; t++)
+		{
+			if(masks[id].test(t))
+				pools[t]->remove(id);
+		}
+
+		masks[id].reset();
+
+		if(id < removing.size())
+			removing[id].reset();
+
+		entities[id] = nullptr;
+		freeIDs.push_back(id);
+
+		refresh(id);
+
+		// invalidate outstanding handles, skipping 0 so a reused id never matches the null handle
+		generations[id] = (generations[id] + 1) & EntityHandle::GENERATION_MASK;
+		if(generations[id] == 0)
+			generations[id] = 1;
+	}
+
+	Component* ComponentStorage::add(unsigned id, unsigned type)
+	{
+		BaseComponentPool* pool = getPool(type);
+
+		if(pool == nullptr)
+			return nullptr;
+
+		Component* comp = pool->add(id);
+		masks[id].set(type);
+		keep(id, type);
+		refresh(id);
+		return comp;
+	}
+
+	bool ComponentStorage::remove(unsigned id, unsigned type)
+	{
+		if(!has(id, type))
+			return false;
+
+		if(deferred)
+			return deferRemoval(id, type);
+
+		pools[type]->remove(id);
+		masks[id].reset(type);
+		refresh(id);
+		return true;
+	}
+
+	Component* ComponentStorage::get(unsigned id, unsigned type) const
+	{
+		if(!has(id, type))
+			return nullptr;
+
+		return pools[type]->get(id);
+	}
+
+	const ComponentMask& ComponentStorage::getMask(unsigned id) const
+	{
+		return masks[id];
+	}
+
+	Entity* ComponentStorage::getEntity(unsigned id) const
+	{
+		return id < entities.size() ? entities[id] : nullptr;
+	}
+
+	EntityHandle ComponentStorage::getHandle(unsigned id) const
+	{
+		if(id >= entities.size() || id > EntityHandle::INDEX_MASK)
+			return {};
+
+		return {id, generations[id]};
+	}
+
+	Entity* ComponentStorage::getEntity(EntityHandle handle) const
+	{
+		return isValid(handle) ? entities[handle.getIndex()] : nullptr;
+	}
+
+	bool ComponentStorage::isValid(EntityHandle handle) const
+	{
+		unsigned id = handle.getIndex();
+
+		return !handle.isNull() && id < entities.size() && entities[id] != nullptr && generations[id] == handle.getGeneration();
+	}
+
+	void ComponentStorage::copy(unsigned to, const ComponentStorage& source, unsigned from)
+	{
+		if(&source == this && to == from)
+			return;
+
+		const ComponentMask& other = source.masks[from];
+
+		for(unsigned t = 0; t < MAX_COMPONENTS; t++)
+		{
+			if(other.test(t))
+			{
+				getPool(t)->copy(to, *source.pools[t], from);
+				masks[to].set(t);
+				keep(to, t);
+			}
+			else if(masks[to].test(t) && deferred)
+				deferRemoval(to, t);
+			else if(masks[to].test(t))
+			{
+				pools[t]->remove(to);
+				masks[to].reset(t);
+			}
+		}
+
+		refresh(to);
+	}
+
+	BaseComponentPool* ComponentStorage::getPool(unsigned type)
+	{
+		if(type >= MAX_COMPONENTS)
+			return nullptr;
+
+		if(pools[type] == nullptr)
+			pools[type] = ComponentRegistry::createPool(type);
+
+		return pools[type];
+	}
+
+	void ComponentStorage::reserve(unsigned type, std::size_t count)
+	{
+		BaseComponentPool* pool = getPool(type);
+
+		if(pool)
+			pool->reserve(count);
+	}
+
+	void ComponentStorage::reserveEntities(std::size_t count)
+	{
+		masks.reserve(count);
+		entities.reserve(count);
+	}
+
+	PoolStats ComponentStorage::getStats(unsigned type) const
+	{
+		if(type < MAX_COMPONENTS && pools[type])
+			return pools[type]->getStats();
+
+		return PoolStats();
+	}
+
+	std::size_t ComponentStorage::getMemory() const
+	{
+		std::size_t bytes = (masks.capacity() + removing.capacity()) * sizeof(ComponentMask) + entities.capacity() * sizeof(Entity*);
+
+		for(auto& p : pools)
+		{
+			if(p)
+				bytes += p->getMemory();
+		}
+
+		return bytes;
+	}
+
+	View& ComponentStorage::getView(const ComponentMask& signature)
+	{
+		for(auto& v : views)
+		{
+			if(v->getSignature() == signature)
+				return *v;
+		}
+
+		View* view = new View(signature);
+		views.push_back(view);
+
+		for(unsigned id = 0; id < entities.size(); id++)
+			view->refresh(id, entities[id], masks[id]);
+
+		return *view;
+	}
+
+	void ComponentStorage::setDeferred(bool d)
+	{
+		deferred = d;
+
+		if(!deferred)
+		{
+			for(auto& id : pending)
+			{
+				isPending[id] = false;
+				applyRemovals(id);
+
+				for(auto& v : views)
+					v->refresh(id, entities[id], masks[id]);
+			}
+
+			pending.clear();
+		}
+	}
+
+	bool ComponentStorage::isDeferred() const
+	{
+		return deferred;
+	}
+
+	bool ComponentStorage::deferRemoval(unsigned id, unsigned type)
+	{
+		if(id >= removing.size())
+			removing.resize(id + 1);
+
+		if(removing[id].test(type))
+			return false;
+
+		removing[id].set(type);
+		refresh(id);
+		return true;
+	}
+
+	void ComponentStorage::applyRemovals(unsigned id)
+	{
+		if(id >= removing.size() || removing[id].none())
+			return;
+
+		for(unsigned t = 0; t < MAX_COMPONENTS; t++)
+		{
+			if(removing[id].test(t) && masks[id].test(t))
+			{
+				pools[t]->remove(id);
+				masks[id].reset(t);
+			}
+		}
+
+		removing[id].reset();
+	}
+
+	void ComponentStorage::refresh(unsigned id)
+	{
+		if(deferred)
+		{
+			if(id >= isPending.size())
+				isPending.resize(id + 1, false);
+
+			if(!isPending[id])
+			{
+				isPending[id] = true;
+				pending.push_back(id);
+			}
+		}
+		else
+		{
+			for(auto& v : views)
+				v->refresh(id, entities[id], masks[id]);
+		}
+	}
+}
@@ -0,0 +1,168 @@
+#ifndef COMPONENTSTORAGE_HPP
+#define COMPONENTSTORAGE_HPP
+
+#include <array>
+#include <vector>
+
+#include "ComponentRegistry.hpp"
+#include "View.hpp"
+#include "EntityHandle.hpp"
+
+namespace swift
+{
+	class Entity;
+
+	// owns the component pools of a World, and hands out entity ids.
+	// ids are dense and reused after an entity is destroyed, with a new generation
+	class ComponentStorage
+	{
+		public:
+			ComponentStorage();
+			~ComponentStorage();
+
+			ComponentStorage(const ComponentStorage&) = delete;
+			ComponentStorage& operator=(const ComponentStorage&) = delete;
+
+			unsigned create(Entity* entity);
+			void destroy(unsigned id);
+
+			template<typename C>
+			C* add(unsigned id)
+			{
+				C* comp = getPool<C>().add(id);
+				masks[id].set(ComponentID<C>::value);
+				keep(id, ComponentID<C>::value);
+				refresh(id);
+				return comp;
+			}
+
+			Component* add(unsigned id, unsigned type);
+
+			template<typename C>
+			bool remove(unsigned id)
+			{
+				if(!has(id, ComponentID<C>::value))
+					return false;
+
+				if(deferred)
+					return deferRemoval(id, ComponentID<C>::value);
+
+				getPool<C>().remove(id);
+				masks[id].reset(ComponentID<C>::value);
+				refresh(id);
+				return true;
+			}
+
+			bool remove(unsigned id, unsigned type);
+
+			template<typename C>
+			C* get(unsigned id) const
+			{
+				if(!has(id, ComponentID<C>::value))
+					return nullptr;
+
+				return static_cast<ComponentPool<C>*>(pools[ComponentID<C>::value])->get(id);
+			}
+
+			Component* get(unsigned id, unsigned type) const;
+
+			bool has(unsigned id, unsigned type) const
+			{
+				return type < MAX_COMPONENTS && masks[id].test(type);
+			}
+
+			const ComponentMask& getMask(unsigned id) const;
+			Entity* getEntity(unsigned id) const;
+
+			EntityHandle getHandle(unsigned id) const;
+
+			// nullptr if the handle is stale or null
+			Entity* getEntity(EntityHandle handle) const;
+			bool isValid(EntityHandle handle) const;
+
+			// copies every component of 'from' in source onto 'to', removing the ones 'from' lacks
+			void copy(unsigned to, const ComponentStorage& source, unsigned from);
+
+			template<typename C>
+			ComponentPool<C>& getPool()
+			{
+				BaseComponentPool*& pool = pools[ComponentID<C>::value];
+
+				if(pool == nullptr)
+					pool = new ComponentPool<C>;
+
+				return *static_cast<ComponentPool<C>*>(pool);
+			}
+
+			// nullptr if type is not a known component
+			BaseComponentPool* getPool(unsigned type);
+
+			// pre-sizes the pool of type, and the per-entity tables
+			void reserve(unsigned type, std::size_t count);
+
+			template<typename C>
+			void reserve(std::size_t count)
+			{
+				reserve(ComponentID<C>::value, count);
+			}
+
+			void reserveEntities(std::size_t count);
+
+			// empty stats if no component of type was ever added
+			PoolStats getStats(unsigned type) const;
+
+			// bytes held by every pool and the per-entity tables
+			std::size_t getMemory() const;
+
+			// view of every entity having at least the components in signature.
+			// created on first request, the reference stays valid for the life of the storage
+			View& getView(const ComponentMask& signature);
+
+			template<typename... Cs>
+			View& getView()
+			{
+				return getView(makeMask<Cs...>());
+			}
+
+			// while deferred, views are not modified. Membership changes are applied once deferring is turned off,
+			// so views can be iterated while entities change. Components removed meanwhile are removed then too, so
+			// every entity of a view still has what the view is of until it's left it
+			void setDeferred(bool d);
+			bool isDeferred() const;
+
+		private:
+			// updates view membership of id after its mask changed
+			void refresh(unsigned id);
+
+			// queues removing type from id for when deferring is turned off. False if it already was
+			bool deferRemoval(unsigned id, unsigned type);
+
+			// a queued removal of type from id, undone by adding it again
+			void keep(unsigned id, unsigned type)
+			{
+				if(id < removing.size())
+					removing[id].reset(type);
+			}
+
+			// removes the components queued for id, that it still has
+			void applyRemovals(unsigned id);
+
+			std::array<BaseComponentPool*, MAX_COMPONENTS> pools;
+
+			// indexed by entity id
+			std::vector<ComponentMask> masks;
+			std::vector<Entity*> entities;
+			std::vector<unsigned> generations;
+
+			std::vector<unsigned> freeIDs;
+
+			std::vector<View*> views;
+
+			bool deferred;
+			std::vector<unsigned> pending;
+			std::vector<bool> isPending;	// indexed by entity id
+			std::vector<ComponentMask> removing;	// indexed by entity id, components to remove once deferring is off
+	};
+}
+
+#endif // COMPONENTSTORAGE_HPP
@@ -0,0 +1,75 @@
+#ifndef COMPONENTTYPES_HPP
+#define COMPONENTTYPES_HPP
+
+#include <bitset>
+
+#include "Component.hpp"
+#include "Components/Animated.hpp"
+#include "Components/Controllable.hpp"
+#include "Components/Drawable.hpp"
+#include "Components/Luminous.hpp"
+#include "Components/Movable.hpp"
+#include "Components/Name.hpp"
+#include "Components/Noisy.hpp"
+#include "Components/Pathfinder.hpp"
+#include "Components/Physical.hpp"
+#include "Components/Sighted.hpp"
+
+namespace swift
+{
+	template<typename... Cs>
+	struct TypeList
+	{
+		static constexpr unsigned size = sizeof...(Cs);
+	};
+
+	// index of C within a TypeList, resolved at compile time
+	template<typename C, typename List>
+	struct IndexOf;
+
+	template<typename C, typename... Cs>
+	struct IndexOf<C, TypeList<C, Cs...>>
+	{
+		static constexpr unsigned value = 0;
+	};
+
+	template<typename C, typename D, typename... Cs>
+	struct IndexOf<C, TypeList<D, Cs...>>
+	{
+		static constexpr unsigned value = 1 + IndexOf<C, TypeList<Cs...>>::value;
+	};
+
+	// every component the engine knows about. The order here defines the type ids
+	using EngineComponents = TypeList<Animated, Controllable, Drawable, Luminous, Movable, Name, Noisy, Pathfinder, Physical, Sighted>;
+
+	constexpr unsigned MAX_COMPONENTS = 32;
+
+	static_assert(EngineComponents::size <= MAX_COMPONENTS, "Too many component types for MAX_COMPONENTS");
+
+	using ComponentMask = std::bitset<MAX_COMPONENTS>;
+
+	template<typename C>
+	struct ComponentID
+	{
+		static_assert(std::is_base_of<Component, C>::value, "C must be a child of swift::Component");
+
+		static constexpr unsigned value = IndexOf<C, EngineComponents>::value;
+	};
+
+	template<typename... Cs>
+	ComponentMask makeMask()
+	{
+		ComponentMask mask;
+
+		// leading 0 keeps the array valid for an empty pack
+		const unsigned ids[] = {0u, (ComponentID<Cs>::value + 1)...};
+
+		for(unsigned id : ids)
+			if(id != 0)
+				mask.set(id - 1);
+
+		return mask;
+	}
+}
+
+#endif // COMPONENTTYPES_HPP
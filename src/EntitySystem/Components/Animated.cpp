@@ -4,7 +4,11 @@ namespace swift
 {
 	Animated::Animated()
 	:	animTex(nullptr),
-		currentAnim("")
+		anim(0),
+		frame(0),
+		time(0),
+		placedAngle(0),
+		placed(false)
 	{}
 	
 	std::string Animated::getType()
@@ -32,4 +36,95 @@ namespace swift
 		
 		initMember("animation", variables, animationFile, std::string("./data/anims/man.anim"));
 	}
+	
+	void Animated::write(ByteWriter& out) const
+	{
+		out.writeByte(1);
+		out.writeFloat(sprite.getScale().x);
+		out.writeFloat(sprite.getScale().y);
+		out.writeString(animationFile);
+	}
+	
+	bool Animated::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 1);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		sf::Vector2f scale;
+		scale.x = in.readFloat();
+		scale.y = in.readFloat();
+		sprite.setScale(scale);
+		
+		animationFile = in.readString();
+		
+		return in.good();
+	}
+	
+	void Animated::setAnimTexture(AnimTexture& at, const AssetHandle<sf::Texture>& texture, const sf::IntRect& region)
+	{
+		// the same animations again, for a new atlas page, keep playing where they were
+		if(animTex != &at)
+		{
+			anim = 0;
+			frame = 0;
+			time = 0;
+		}
+		
+		animTex = &at;
+		
+		textureAsset = texture;
+		
+		if(!texture)
+			return;
+		
+		sprite.setTexture(*texture);
+		origin = {region.left, region.top};
+	}
+	
+	std::string Animated::getAnimation() const
+	{
+		if(!animTex || anim >= animTex->getAnimCount())
+			return "";
+		
+		return animTex->getAnimNames()[anim];
+	}
+	
+	bool Animated::setAnimation(const std::string& n)
+	{
+		unsigned id;
+		
+		if(!animTex || !animTex->findAnim(n, id))
+			return false;
+		
+		if(id != anim)
+		{
+			anim = id;
+			frame = 0;
+			time = 0;
+		}
+		
+		return true;
+	}
+	
+	void Animated::setFrame(const sf::IntRect& frame)
+	{
+		sprite.setTextureRect({frame.left + origin.x, frame.top + origin.y, frame.width, frame.height});
+	}
+	
+	void Animated::place(const sf::Vector2f& pos, float angle)
+	{
+		if(placed && pos == placedPosition && angle == placedAngle)
+			return;
+		
+		sprite.setPosition(pos);
+		sprite.setRotation(angle);
+		
+		placedPosition = pos;
+		placedAngle = angle;
+		placed = true;
+	}
 }
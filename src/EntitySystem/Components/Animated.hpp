@@ -6,7 +6,7 @@
 #include <SFML/Graphics/Sprite.hpp>
 
 #include "../../Animation/AnimTexture.hpp"
-#include "../../Animation/FrameAnimation.hpp"
+#include "../../ResourceManager/AssetHandle.hpp"
 
 namespace swift
 {
@@ -18,12 +18,47 @@ namespace swift
 			
 			virtual std::map<std::string, std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
+			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
 
 			sf::Sprite sprite;
 			AnimTexture* animTex;
-			std::map<std::string, FrameAnimation> anims;
-			std::string currentAnim;
 			std::string animationFile;
+			
+			// what's playing, by its number in animTex, and how far into it this is. The frames are animTex's
+			unsigned anim;
+			unsigned frame;
+			float time;
+			
+			// keeps the sprite's texture from being evicted, set along with it
+			AssetHandle<sf::Texture> textureAsset;
+			
+			// moves the sprite, unless it's there already. Every change makes SFML compute the sprite's transform again
+			void place(const sf::Vector2f& pos, float angle);
+			
+			// the name of what's playing, empty without an animTex
+			std::string getAnimation() const;
+			
+			// plays the animation named n from its start, unless it's already playing
+			// Returns false if animTex has no animation named n
+			bool setAnimation(const std::string& n);
+			
+			// plays at's animations, drawn from region of texture, which is where at's texture file is on its atlas page,
+			// if it's on one
+			void setAnimTexture(AnimTexture& at, const AssetHandle<sf::Texture>& texture, const sf::IntRect& region);
+			
+			// frame of the animation's texture file, wherever it's packed
+			void setFrame(const sf::IntRect& frame);
+			
+		private:
+			// of the texture file on what the sprite draws from
+			sf::Vector2i origin;
+			
+			// what the sprite was last placed at
+			sf::Vector2f placedPosition;
+			float placedAngle;
+			bool placed;
 	};
 }
 
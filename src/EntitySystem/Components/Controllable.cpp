@@ -33,4 +33,29 @@ namespace swift
 		initMember("moveUp", variables, moveUp, false);
 		initMember("moveDown", variables, moveDown, false);
 	}
+	
+	void Controllable::write(ByteWriter& out) const
+	{
+		out.writeByte(1);
+		out.writeByte((moveLeft ? 1 : 0) | (moveRight ? 2 : 0) | (moveUp ? 4 : 0) | (moveDown ? 8 : 0));
+	}
+	
+	bool Controllable::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 1);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		std::uint8_t flags = in.readByte();
+		
+		moveLeft = flags & 1;
+		moveRight = flags & 2;
+		moveUp = flags & 4;
+		moveDown = flags & 8;
+		
+		return in.good();
+	}
 }
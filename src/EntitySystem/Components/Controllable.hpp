@@ -15,6 +15,9 @@ namespace swift
 			virtual std::map<std::string,std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
 			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
+			
 			// booleans of all things a player entity should do when a key is pressed
 			bool moveLeft;
 			bool moveRight;
@@ -4,6 +4,11 @@
 
 namespace swift
 {
+	Drawable::Drawable()
+	:	placedAngle(0),
+		placed(false)
+	{}
+	
 	std::string Drawable::getType()
 	{
 		return "Drawable";
@@ -28,4 +33,61 @@ namespace swift
 		initMember("scaleY", variables, scale.y, 0.f);
 		sprite.setScale(scale);
 	}
+	
+	void Drawable::write(ByteWriter& out) const
+	{
+		out.writeByte(1);
+		out.writeString(texture);
+		out.writeFloat(sprite.getScale().x);
+		out.writeFloat(sprite.getScale().y);
+	}
+	
+	bool Drawable::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 1);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		texture = in.readString();
+		
+		sf::Vector2f scale;
+		scale.x = in.readFloat();
+		scale.y = in.readFloat();
+		sprite.setScale(scale);
+		
+		return in.good();
+	}
+	
+	void Drawable::setTexture(const AssetHandle<sf::Texture>& texture, const sf::IntRect& region)
+	{
+		textureAsset = texture;
+		
+		if(!texture)
+			return;
+		
+		sprite.setTexture(*texture);
+		sprite.setTextureRect(region);
+		origin = {region.left, region.top};
+	}
+	
+	void Drawable::setTextureRect(const sf::IntRect& rect)
+	{
+		sprite.setTextureRect({rect.left + origin.x, rect.top + origin.y, rect.width, rect.height});
+	}
+	
+	void Drawable::place(const sf::Vector2f& pos, float angle)
+	{
+		if(placed && pos == placedPosition && angle == placedAngle)
+			return;
+		
+		sprite.setPosition(pos);
+		sprite.setRotation(angle);
+		
+		placedPosition = pos;
+		placedAngle = angle;
+		placed = true;
+	}
 }
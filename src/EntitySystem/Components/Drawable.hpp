@@ -4,19 +4,47 @@
 #include "../Component.hpp"
 
 #include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+#include "../../ResourceManager/AssetHandle.hpp"
 
 namespace swift
 {
 	class Drawable : public Component
 	{
 		public:
+			Drawable();
 			static std::string getType();
 			
 			virtual std::map<std::string, std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
+			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
+
+			// moves the sprite, unless it's there already. Every change makes SFML compute the sprite's transform again
+			void place(const sf::Vector2f& pos, float angle);
+			
+			// draws all of region of texture, which is where the texture file is on its atlas page, if it's on one
+			void setTexture(const AssetHandle<sf::Texture>& texture, const sf::IntRect& region);
+			
+			// rect of the texture file, wherever it's packed
+			void setTextureRect(const sf::IntRect& rect);
 
 			sf::Sprite sprite;
 			std::string texture;
+			
+			// keeps the sprite's texture from being evicted, set along with it
+			AssetHandle<sf::Texture> textureAsset;
+			
+		private:
+			// of the texture file on what the sprite draws from
+			sf::Vector2i origin;
+			
+			// what the sprite was last placed at
+			sf::Vector2f placedPosition;
+			float placedAngle;
+			bool placed;
 	};
 }
 
@@ -0,0 +1,75 @@
+#include "Luminous.hpp"
+
+namespace swift
+{
+	Luminous::Luminous()
+	:	radius(0),
+		color(sf::Color::White),
+		lightTexture(nullptr)
+	{}
+	
+	std::string Luminous::getType()
+	{
+		return "Luminous";
+	}
+	
+	std::map<std::string, std::string> Luminous::serialize() const
+	{
+		std::map<std::string, std::string> variables;
+		
+		variables.emplace("radius", std::to_string(radius));
+		variables.emplace("red", std::to_string(color.r));
+		variables.emplace("green", std::to_string(color.g));
+		variables.emplace("blue", std::to_string(color.b));
+		variables.emplace("alpha", std::to_string(color.a));
+		variables.emplace("texture", texture);
+		
+		return variables;
+	}
+	
+	void Luminous::unserialize(const std::map<std::string, std::string>& variables)
+	{
+		initMember("radius", variables, radius, 128.f);
+		
+		unsigned r, g, b, a;
+		initMember("red", variables, r, 255u);
+		initMember("green", variables, g, 255u);
+		initMember("blue", variables, b, 255u);
+		initMember("alpha", variables, a, 255u);
+		color = sf::Color(r, g, b, a);
+		
+		initMember("texture", variables, texture, std::string(""));
+		lightTexture = nullptr;
+	}
+	
+	void Luminous::write(ByteWriter& out) const
+	{
+		out.writeByte(1);
+		out.writeFloat(radius);
+		out.writeByte(color.r);
+		out.writeByte(color.g);
+		out.writeByte(color.b);
+		out.writeByte(color.a);
+		out.writeString(texture);
+	}
+	
+	bool Luminous::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 1);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		radius = in.readFloat();
+		color.r = in.readByte();
+		color.g = in.readByte();
+		color.b = in.readByte();
+		color.a = in.readByte();
+		texture = in.readString();
+		lightTexture = nullptr;
+		
+		return in.good();
+	}
+}
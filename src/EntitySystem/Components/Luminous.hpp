@@ -0,0 +1,33 @@
+#ifndef LUMINOUS_HPP
+#define LUMINOUS_HPP
+
+#include "../Component.hpp"
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+namespace swift
+{
+	// a light centered on the entity, drawn into the world's light map
+	class Luminous : public Component
+	{
+		public:
+			Luminous();
+			static std::string getType();
+			
+			virtual std::map<std::string, std::string> serialize() const;
+			virtual void unserialize(const std::map<std::string, std::string>& variables);
+			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
+			
+			float radius;
+			sf::Color color;
+			std::string texture;	// empty for a round falloff
+			
+			// looked up from texture the first time the light is drawn, not saved
+			const sf::Texture* lightTexture;
+	};
+}
+
+#endif // LUMINOUS_HPP
@@ -32,4 +32,28 @@ namespace swift
 		initMember("velocityX", variables, velocity.x, 0.f);
 		initMember("velocityY", variables, velocity.y, 0.f);
 	}
+	
+	void Movable::write(ByteWriter& out) const
+	{
+		out.writeByte(1);
+		out.writeFloat(moveVelocity);
+		out.writeFloat(velocity.x);
+		out.writeFloat(velocity.y);
+	}
+	
+	bool Movable::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 1);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		moveVelocity = in.readFloat();
+		velocity.x = in.readFloat();
+		velocity.y = in.readFloat();
+		
+		return in.good();
+	}
 }
@@ -17,6 +17,9 @@ namespace swift
 			virtual std::map<std::string, std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
 			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
+			
 			float moveVelocity;
 			sf::Vector2f velocity;
 	};
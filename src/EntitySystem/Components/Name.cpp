@@ -1,12 +1,30 @@
 #include "Name.hpp"
 
 #include "../Entity.hpp"
+#include "../NameTable.hpp"
 
 namespace swift
 {
+	std::atomic<unsigned> Name::revision(0);
+	
 	Name::Name()
-		:	name("")
+		:	id(0)
+	{
+	}
+	
+	Name::Name(const Name& other)
+		:	Component(other),
+			id(other.id)
 	{
+		revision++;
+	}
+	
+	Name& Name::operator=(const Name& other)
+	{
+		id = other.id;
+		revision++;
+		
+		return *this;
 	}
 	
 	std::string Name::getType()
@@ -18,13 +36,59 @@ namespace swift
 	{
 		std::map<std::string, std::string> variables;
 		
-		variables.emplace("name", name);
+		variables.emplace("name", getName());
 		
 		return std::move(variables);
 	}
 	
 	void Name::unserialize(const std::map<std::string, std::string>& variables)
 	{
+		std::string name;
 		initMember("name", variables, name, std::string("null"));
+		setName(name);
+	}
+	
+	void Name::write(ByteWriter& out) const
+	{
+		out.writeByte(1);
+		out.writeString(getName());
+	}
+	
+	bool Name::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 1);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		std::string name = in.readString();
+		
+		if(in.good())
+			setName(name);
+		
+		return in.good();
+	}
+	
+	void Name::setName(const std::string& n)
+	{
+		id = NameTable::intern(n);
+		revision++;
+	}
+	
+	const std::string& Name::getName() const
+	{
+		return NameTable::get(id);
+	}
+	
+	unsigned Name::getID() const
+	{
+		return id;
+	}
+	
+	unsigned Name::getRevision()
+	{
+		return revision;
 	}
 }
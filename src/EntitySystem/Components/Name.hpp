@@ -4,20 +4,42 @@
 #include "../Component.hpp"
 
 #include <string>
+#include <atomic>
 
 namespace swift
 {
+	// the name is interned, so names are compared by id
 	class Name : public Component
 	{
 		public:
 			Name();
+			Name(const Name& other);
+			Name(Name&& other) = default;
+			
+			Name& operator=(const Name& other);
+			Name& operator=(Name&& other) = default;
 			
 			static std::string getType();
 			
 			virtual std::map<std::string, std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
 			
-			std::string name;
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
+			
+			void setName(const std::string& n);
+			const std::string& getName() const;
+			
+			// the NameTable id
+			unsigned getID() const;
+			
+			// changes each time any entity gets a name, by being set or copied. Moving within a pool doesn't change it
+			static unsigned getRevision();
+		
+		private:
+			unsigned id;
+			
+			static std::atomic<unsigned> revision;
 	};
 }
 
@@ -2,6 +2,11 @@
 
 namespace swift
 {
+	Noisy::Noisy()
+	:	shouldPlay(false),
+		priority(0)
+	{}
+	
 	std::string Noisy::getType()
 	{
 		return "Noisy";
@@ -12,6 +17,7 @@ namespace swift
 		std::map<std::string, std::string> variables;
 		
 		variables.emplace("sound", soundFile);
+		variables.emplace("priority", std::to_string(priority));
 		
 		return std::move(variables);
 	}
@@ -19,5 +25,30 @@ namespace swift
 	void Noisy::unserialize(const std::map<std::string, std::string>& variables)
 	{
 		initMember("sound", variables, soundFile, std::string("./data/sounds/nothing.wav"));
+		initMember("priority", variables, priority, 0);
+	}
+	
+	void Noisy::write(ByteWriter& out) const
+	{
+		out.writeByte(2);
+		out.writeString(soundFile);
+		out.writeInt(priority);
+	}
+	
+	bool Noisy::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 2);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		soundFile = in.readString();
+		
+		if(version >= 2)
+			priority = static_cast<int>(in.readInt());
+		
+		return in.good();
 	}
 }
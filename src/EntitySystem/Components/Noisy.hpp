@@ -5,18 +5,33 @@
 
 #include <string>
 
+#include <SFML/Audio/SoundBuffer.hpp>
+
+#include "../../ResourceManager/AssetHandle.hpp"
+
 namespace swift
 {
 	class Noisy : public Component
 	{
 		public:
+			Noisy();
 			static std::string getType();
 			
 			virtual std::map<std::string,std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
+			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
 
 			std::string soundFile;
 			bool shouldPlay;
+			
+			// sounds with a higher priority take the voices of lower ones when every voice is busy
+			int priority;
+			
+			// soundFile's buffer, looked up again by the noisy system only once soundFile no longer matches soundAssetFile
+			AssetHandle<sf::SoundBuffer> soundAsset;
+			std::string soundAssetFile;
 	};
 }
 
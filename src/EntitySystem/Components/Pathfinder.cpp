@@ -4,7 +4,13 @@ namespace swift
 {
 	Pathfinder::Pathfinder()
 	:	destination({0, 0}),
-		needsPath(false)
+		needsPath(false),
+		algorithm(GridSearch::Algorithm::AStar),
+		priority(0),
+		avoidance(0),
+		pathVersion(0),
+		request(PathService::NONE),
+		requestDestination({0, 0})
 	{}
 	
 	std::string Pathfinder::getType()
@@ -14,11 +20,88 @@ namespace swift
 	
 	std::map<std::string, std::string> Pathfinder::serialize() const
 	{
-		return std::map<std::string, std::string>();
+		std::map<std::string, std::string> variables;
+		
+		switch(algorithm)
+		{
+			case GridSearch::Algorithm::JumpPoint:
+				variables.emplace("algorithm", "jps");
+				break;
+			case GridSearch::Algorithm::Hierarchical:
+				variables.emplace("algorithm", "hpa");
+				break;
+			case GridSearch::Algorithm::FlowField:
+				variables.emplace("algorithm", "flow");
+				break;
+			default:
+				variables.emplace("algorithm", "astar");
+				break;
+		}
+		
+		variables.emplace("priority", std::to_string(priority));
+		variables.emplace("avoidance", std::to_string(avoidance));
+		
+		return variables;
+	}
+	
+	void Pathfinder::unserialize(const std::map<std::string, std::string>& variables)
+	{
+		initMember("priority", variables, priority, 0);
+		initMember("avoidance", variables, avoidance, 0.f);
+		
+		std::string name;
+		initMember("algorithm", variables, name, std::string("astar"));
+		
+		if(name == "jps")
+			algorithm = GridSearch::Algorithm::JumpPoint;
+		else if(name == "hpa")
+			algorithm = GridSearch::Algorithm::Hierarchical;
+		else if(name == "flow")
+			algorithm = GridSearch::Algorithm::FlowField;
+		else
+			algorithm = GridSearch::Algorithm::AStar;
 	}
 	
-	void Pathfinder::unserialize(const std::map<std::string, std::string>&)
+	void Pathfinder::write(ByteWriter& out) const
 	{
+		out.writeByte(4);
+		out.writeFloat(destination.x);
+		out.writeFloat(destination.y);
+		out.writeBool(needsPath);
+		out.writeByte(static_cast<std::uint8_t>(algorithm));
+		out.writeInt(priority);
+		out.writeFloat(avoidance);
+	}
+	
+	bool Pathfinder::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 4);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		destination.x = in.readFloat();
+		destination.y = in.readFloat();
+		needsPath = in.readBool();
+		
+		if(version >= 2)
+		{
+			std::uint8_t a = in.readByte();
+			
+			if(a > static_cast<std::uint8_t>(GridSearch::Algorithm::FlowField))
+				in.fail();
+			
+			algorithm = static_cast<GridSearch::Algorithm>(a);
+		}
+		
+		if(version >= 3)
+			priority = static_cast<int>(in.readInt());
+		
+		if(version >= 4)
+			avoidance = in.readFloat();
 		
+		return in.good();
 	}
 }
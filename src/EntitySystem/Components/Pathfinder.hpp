@@ -2,7 +2,10 @@
 #define PATHFINDER_HPP
 
 #include "../Component.hpp"
-#include "../../Pathfinding/Path.hpp"
+#include "../../Pathfinding/PathService.hpp"
+#include "../../Pathfinding/FlowField.hpp"
+
+#include <memory>
 
 #include <queue>
 
@@ -17,10 +20,35 @@ namespace swift
 
 			virtual std::map<std::string, std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
+			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
 
-			Path::PathNodes nodes;
+			CompactPath path;
+			Path::Waypoints waypoints;	// left to refine into path, for Hierarchical paths
 			sf::Vector2f destination;
 			bool needsPath;
+			
+			// JumpPoint is much faster on open maps of uniform cost, Hierarchical on large maps,
+			// FlowField when many entities share a destination.
+			// "algorithm" = "astar", "jps", "hpa" or "flow" when unserialized
+			GridSearch::Algorithm algorithm;
+			
+			// requests with higher priorities are solved first
+			int priority;
+			
+			// radius, in pixels, of the space SteeringSystem keeps other moving entities out of. 0 doesn't steer
+			float avoidance;
+			
+			// of the layer path was found on, it's repaired once the layer changes
+			unsigned pathVersion;
+			
+			// the request in flight, and where it was going
+			PathService::Ticket request;
+			sf::Vector2f requestDestination;
+			
+			// followed instead of path, for FlowField
+			std::shared_ptr<const FlowField> field;
 	};
 }
 
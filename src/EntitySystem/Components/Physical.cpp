@@ -1,6 +1,8 @@
 #include "Physical.hpp"
 #include <iostream>
+#include <algorithm>
 #include "../Entity.hpp"
+#include "../../Math/Math.hpp"
 
 namespace swift
 {
@@ -9,7 +11,14 @@ namespace swift
 		zIndex(1),
 		size({0, 0}),
 		collides(false),
-		angle(0)
+		angle(0),
+		category(1),
+		mask(~0u),
+		previousPosition({0, 0}),
+		previousAngle(0),
+		boxAngle(0),
+		boxValid(false),
+		hasPrevious(false)
 	{}
 	
 	std::string Physical::getType()
@@ -28,6 +37,8 @@ namespace swift
 		variables.emplace("sizeY", std::to_string(size.y));
 		variables.emplace("collides", collides ? "true" : "false");
 		variables.emplace("angle", std::to_string(angle));
+		variables.emplace("category", std::to_string(category));
+		variables.emplace("mask", std::to_string(mask));
 		
 		return std::move(variables);
 	}
@@ -41,5 +52,142 @@ namespace swift
 		initMember("sizeY", variables, size.y, 0u);
 		initMember("collides", variables, collides, false);
 		initMember("angle", variables, angle, 0.f);
+		initMember("category", variables, category, 1u);
+		initMember("mask", variables, mask, ~0u);
+		
+		resetPrevious();
+	}
+	
+	void Physical::write(ByteWriter& out) const
+	{
+		out.writeByte(2);
+		out.writeFloat(position.x);
+		out.writeFloat(position.y);
+		out.writeUInt(zIndex);
+		out.writeUInt(size.x);
+		out.writeUInt(size.y);
+		out.writeBool(collides);
+		out.writeFloat(angle);
+		out.writeUInt(category);
+		out.writeUInt(mask);
+	}
+	
+	bool Physical::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 2);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		position.x = in.readFloat();
+		position.y = in.readFloat();
+		zIndex = in.readUInt();
+		size.x = in.readUInt();
+		size.y = in.readUInt();
+		collides = in.readBool();
+		angle = in.readFloat();
+		
+		if(version >= 2)
+		{
+			category = in.readUInt();
+			mask = in.readUInt();
+		}
+		else
+		{
+			category = 1;
+			mask = ~0u;
+		}
+		
+		resetPrevious();
+		
+		return in.good();
+	}
+	
+	const Physical::Box& Physical::getBox() const
+	{
+		if(!boxValid || position != boxPosition || size != boxSize || angle != boxAngle)
+			updateBox();
+		
+		return box;
+	}
+	
+	const sf::FloatRect& Physical::getBounds() const
+	{
+		return getBox().bounds;
+	}
+	
+	void Physical::storePrevious()
+	{
+		previousPosition = position;
+		previousAngle = angle;
+		hasPrevious = true;
+	}
+	
+	sf::Vector2f Physical::getDrawPosition(float alpha) const
+	{
+		if(!hasPrevious)
+			return position;
+		
+		return previousPosition + (position - previousPosition) * alpha;
+	}
+	
+	float Physical::getDrawAngle(float alpha) const
+	{
+		if(!hasPrevious)
+			return angle;
+		
+		// the short way around
+		float diff = std::fmod(angle - previousAngle + 540.f, 360.f) - 180.f;
+		
+		return previousAngle + diff * alpha;
+	}
+	
+	void Physical::resetPrevious()
+	{
+		hasPrevious = false;
+	}
+	
+	void Physical::updateBox() const
+	{
+		boxPosition = position;
+		boxSize = size;
+		boxAngle = angle;
+		boxValid = true;
+		
+		sf::Vector2f xDir = {1, 0};
+		sf::Vector2f yDir = {0, 1};
+		
+		// most entities aren't rotated, skip the trig for them
+		if(angle != 0.f)
+		{
+			float radians = angle * math::PI / 180.f;
+			float cos = std::cos(radians);
+			float sin = std::sin(radians);
+			
+			xDir = {cos, sin};
+			yDir = {-sin, cos};
+		}
+		
+		// the rectangle rotates around position, its top left corner
+		sf::Vector2f xEdge = xDir * static_cast<float>(size.x);
+		sf::Vector2f yEdge = yDir * static_cast<float>(size.y);
+		
+		box.vertices[0] = position;
+		box.vertices[1] = position + xEdge;
+		box.vertices[2] = position + xEdge + yEdge;
+		box.vertices[3] = position + yEdge;
+		
+		// normals of the first two edges
+		box.axes[0] = yDir;
+		box.axes[1] = -xDir;
+		
+		float minX = position.x + std::min(0.f, xEdge.x) + std::min(0.f, yEdge.x);
+		float maxX = position.x + std::max(0.f, xEdge.x) + std::max(0.f, yEdge.x);
+		float minY = position.y + std::min(0.f, xEdge.y) + std::min(0.f, yEdge.y);
+		float maxY = position.y + std::max(0.f, xEdge.y) + std::max(0.f, yEdge.y);
+		
+		box.bounds = {minX, minY, maxX - minX, maxY - minY};
 	}
 }
@@ -4,24 +4,80 @@
 #include "../Component.hpp"
 
 #include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
 
 namespace swift
 {
 	class Physical : public Component
 	{
 		public:
+			// the rectangle in world space
+			struct Box
+			{
+				sf::Vector2f vertices[4];	// clockwise from position
+				sf::Vector2f axes[2];		// unit edge normals, the other two edges' normals are their negatives
+				sf::FloatRect bounds;		// axis aligned box around the vertices
+			};
+			
 			Physical();
 
 			static std::string getType();
 			
 			virtual std::map<std::string, std::string> serialize() const;
 			virtual void unserialize(const std::map<std::string, std::string>& variables);
+			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
+			
+			// cached, and only recomputed after position, size, or angle change.
+			// not safe to call from systems that only read Physical, they may run at the same time
+			const Box& getBox() const;
+			
+			// axis aligned box around the rotated rectangle
+			const sf::FloatRect& getBounds() const;
+			
+			// remembers the current transform, done at the start of every update
+			void storePrevious();
+			
+			// transform between the last two updates, alpha being how far into the current one drawing is.
+			// entities that haven't been through an update yet are drawn where they are
+			sf::Vector2f getDrawPosition(float alpha) const;
+			float getDrawAngle(float alpha) const;
+			
+			// stops interpolating from the old transform, for entities that jumped
+			void resetPrevious();
+			
+			// if each is in a category the other's mask has. Pairs that aren't are dropped by the broadphase
+			bool interacts(const Physical& other) const
+			{
+				return (category & other.mask) != 0 && (other.category & mask) != 0;
+			}
 
 			sf::Vector2f position;
 			unsigned int zIndex;
 			sf::Vector2u size;
 			bool collides;
 			float angle;	// degrees
+			
+			// bits of what the entity is, and of what it collides with. Every entity is in 1 and collides with everything by default
+			unsigned category;
+			unsigned mask;
+			
+			// transform at the start of the last update, not saved
+			sf::Vector2f previousPosition;
+			float previousAngle;
+			
+		private:
+			void updateBox() const;
+			
+			// what box was computed from
+			mutable Box box;
+			mutable sf::Vector2f boxPosition;
+			mutable sf::Vector2u boxSize;
+			mutable float boxAngle;
+			mutable bool boxValid;
+			
+			bool hasPrevious;
 	};
 }
 
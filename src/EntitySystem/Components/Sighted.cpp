@@ -0,0 +1,52 @@
+#include "Sighted.hpp"
+
+namespace swift
+{
+	Sighted::Sighted()
+	:	faction(0),
+		radius(0)
+	{}
+	
+	std::string Sighted::getType()
+	{
+		return "Sighted";
+	}
+	
+	std::map<std::string, std::string> Sighted::serialize() const
+	{
+		std::map<std::string, std::string> variables;
+		
+		variables.emplace("faction", std::to_string(faction));
+		variables.emplace("radius", std::to_string(radius));
+		
+		return variables;
+	}
+	
+	void Sighted::unserialize(const std::map<std::string, std::string>& variables)
+	{
+		initMember("faction", variables, faction, 0u);
+		initMember("radius", variables, radius, 256.f);
+	}
+	
+	void Sighted::write(ByteWriter& out) const
+	{
+		out.writeByte(1);
+		out.writeUInt(faction);
+		out.writeFloat(radius);
+	}
+	
+	bool Sighted::read(ByteReader& in)
+	{
+		unsigned version = readVersion(in, 1);
+		
+		if(!in.good())
+			return false;
+		else if(version == 0)
+			return readMap(in);
+		
+		faction = static_cast<unsigned>(in.readUInt());
+		radius = in.readFloat();
+		
+		return in.good();
+	}
+}
@@ -0,0 +1,27 @@
+#ifndef SIGHTED_HPP
+#define SIGHTED_HPP
+
+#include "../Component.hpp"
+
+namespace swift
+{
+	// sees the tiles around the entity for its faction, in the world's visibility map.
+	// impassable tiles of the sight layer block sight, and are seen themselves
+	class Sighted : public Component
+	{
+		public:
+			Sighted();
+			static std::string getType();
+			
+			virtual std::map<std::string, std::string> serialize() const;
+			virtual void unserialize(const std::map<std::string, std::string>& variables);
+			
+			virtual void write(ByteWriter& out) const;
+			virtual bool read(ByteReader& in);
+			
+			unsigned faction;
+			float radius;	// in pixels
+	};
+}
+
+#endif // SIGHTED_HPP
@@ -1,191 +1,136 @@
 #ifndef ENTITY_HPP
 #define ENTITY_HPP
 
-#include <unordered_map>
-
 #include "Component.hpp"
 #include "ComponentRegistry.hpp"
+#include "ComponentStorage.hpp"
 
 namespace swift
 {
+	// an entity is an id into a ComponentStorage, its components live in the storage's pools.
+	// component pointers returned by get() are invalidated when a component of the same type is added or removed
 	class Entity
 	{
 		public:
-			Entity()
+			Entity(ComponentStorage& s)
+			:	storage(s),
+				id(storage.create(this))
 			{
 			}
-			
+
 			Entity(const Entity& other)
+			:	storage(other.storage),
+				id(storage.create(this))
 			{
 				*this = other;
 			}
-			
+
+			// copies the components of other, which may belong to a different storage
 			Entity& operator=(const Entity& other)
 			{
-				if(other.has<Animated>())
-				{
-					add<Animated>();
-					*get<Animated>() = *other.get<Animated>();
-				}
-				
-				if(other.has<Controllable>())
-				{
-					add<Controllable>();
-					*get<Controllable>() = *other.get<Controllable>();
-				}
-				
-				if(other.has<Drawable>())
-				{
-					add<Drawable>();
-					*get<Drawable>() = *other.get<Drawable>();
-				}
-				
-				if(other.has<Movable>())
-				{
-					add<Movable>();
-					*get<Movable>() = *other.get<Movable>();
-				}
-				
-				if(other.has<Name>())
-				{
-					add<Name>();
-					*get<Name>() = *other.get<Name>();
-				}
-				
-				if(other.has<Noisy>())
-				{
-					add<Noisy>();
-					*get<Noisy>() = *other.get<Noisy>();
-				}
-				
-				if(other.has<Pathfinder>())
-				{
-					add<Pathfinder>();
-					*get<Pathfinder>() = *other.get<Pathfinder>();
-				}
-				
-				if(other.has<Physical>())
-				{
-					add<Physical>();
-					*get<Physical>() = *other.get<Physical>();
-				}
-				
+				if(this != &other)
+					storage.copy(id, other.storage, other.id);
+
 				return *this;
 			}
 
 			~Entity()
 			{
-				auto it = components.begin();
-				while(it != components.end())
-				{
-					if(it->second)
-						delete it->second;
-					it = components.erase(it);
-				}
+				storage.destroy(id);
 			}
-			
+
 			template<typename C>
 			bool add()
 			{
 				static_assert(std::is_base_of<Component, C>::value, "C must be a child of swift::Component");
-				
+
 				if(!has<C>())
 				{
-					components.emplace(C::getType(), new C);
+					storage.add<C>(id);
 					return true;
 				}
 				else
 					return false;
 			}
-			
-			bool add(std::string c)
+
+			bool add(const std::string& c)
 			{
-				if(has(c))
+				unsigned type = ComponentRegistry::getID(c);
+
+				if(type >= MAX_COMPONENTS || storage.has(id, type))
 					return false;
 				else
-				{
-					Component* comp = ComponentRegistry::get(c);
-				
-					if(comp == nullptr)
-						return false;
-					
-					components.emplace(c, comp);
-					return true;
-				}
+					return storage.add(id, type) != nullptr;
 			}
-			
+
 			template<typename C>
 			bool remove()
 			{
 				static_assert(std::is_base_of<Component, C>::value, "C must be a child of swift::Component");
-				
-				if(has<C>())
-				{
-					delete components[C::getType()];
-					components.erase(C::getType());
-					return true;
-				}
-				else
-					return false;
+
+				return storage.remove<C>(id);
 			}
-			
-			bool remove(std::string c)
+
+			bool remove(const std::string& c)
 			{
-				if(has(c))
-					return false;
-				else
-				{
-					Component* comp = ComponentRegistry::get(c);
-					
-					if(comp == nullptr)
-						return false;
-				
-					components.emplace(c, comp);
-					return true;
-				}
+				return storage.remove(id, ComponentRegistry::getID(c));
 			}
-			
+
 			template<typename C>
 			C* get() const
 			{
 				static_assert(std::is_base_of<Component, C>::value, "C must be a child of swift::Component");
-				
-				if(has<C>())
-				{
-					return static_cast<C*>(components.at(C::getType()));
-				}
-				else
-					return nullptr;
+
+				return storage.get<C>(id);
 			}
-			
-			Component* get(std::string c) const
+
+			Component* get(const std::string& c) const
 			{
-				if(has(c))
-					return components.at(c);
-				else
-					return nullptr;
+				return storage.get(id, ComponentRegistry::getID(c));
 			}
-			
+
+			Component* get(unsigned type) const
+			{
+				return storage.get(id, type);
+			}
+
 			template<typename C>
 			bool has() const
 			{
 				static_assert(std::is_base_of<Component, C>::value, "C must be a child of swift::Component");
-				
-				return components.find(C::getType()) != components.end();
+
+				return storage.has(id, ComponentID<C>::value);
+			}
+
+			bool has(const std::string& c) const
+			{
+				return storage.has(id, ComponentRegistry::getID(c));
 			}
-			
-			bool has(std::string c) const
+
+			// bit n is set if the entity has the component with type id n
+			const ComponentMask& getMask() const
+			{
+				return storage.getMask(id);
+			}
+
+			unsigned getID() const
 			{
-				return components.find(c) != components.end();
+				return id;
 			}
-			
-			const std::unordered_map<std::string, Component*>& getComponents() const
+
+			EntityHandle getHandle() const
+			{
+				return storage.getHandle(id);
+			}
+
+			ComponentStorage& getStorage() const
 			{
-				return components;
+				return storage;
 			}
 
 		private:
-			std::unordered_map<std::string, Component*> components;
+			ComponentStorage& storage;
+			unsigned id;
 	};
 }
 
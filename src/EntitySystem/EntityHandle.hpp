@@ -0,0 +1,58 @@
+#ifndef ENTITYHANDLE_HPP
+#define ENTITYHANDLE_HPP
+
+#include <cstdint>
+
+namespace swift
+{
+	// stable reference to an entity: its id plus the generation of that id.
+	// the generation is bumped each time the id is reused, so handles to destroyed entities stop resolving.
+	// packed into 32 bits so it fits into a Lua light userdata on any platform
+	class EntityHandle
+	{
+		public:
+			static constexpr unsigned INDEX_BITS = 20;
+			static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+			static constexpr std::uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+			// null handle. generations start at 1, so no live entity has this value
+			EntityHandle()
+			:	value(0)
+			{
+			}
+
+			EntityHandle(unsigned index, unsigned generation)
+			:	value(((generation & GENERATION_MASK) << INDEX_BITS) | (index & INDEX_MASK))
+			{
+			}
+
+			unsigned getIndex() const
+			{
+				return value & INDEX_MASK;
+			}
+
+			unsigned getGeneration() const
+			{
+				return value >> INDEX_BITS;
+			}
+
+			bool isNull() const
+			{
+				return value == 0;
+			}
+
+			bool operator==(const EntityHandle& other) const
+			{
+				return value == other.value;
+			}
+
+			bool operator!=(const EntityHandle& other) const
+			{
+				return value != other.value;
+			}
+
+			std::uint32_t value;
+	};
+}
+
+#endif // ENTITYHANDLE_HPP
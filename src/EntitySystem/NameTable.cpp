@@ -0,0 +1,59 @@
+#include "NameTable.hpp"
+
+namespace swift
+{
+	NameTable::Table::Table()
+	{
+		names.emplace_back();
+		ids.emplace(std::string(), 0);
+	}
+
+	unsigned NameTable::intern(const std::string& s)
+	{
+		Table& table = getTable();
+		std::lock_guard<std::mutex> lock(table.mutex);
+
+		auto it = table.ids.find(s);
+
+		if(it != table.ids.end())
+			return it->second;
+
+		unsigned id = static_cast<unsigned>(table.names.size());
+		table.names.push_back(s);
+		table.ids.emplace(s, id);
+
+		return id;
+	}
+
+	unsigned NameTable::find(const std::string& s)
+	{
+		Table& table = getTable();
+		std::lock_guard<std::mutex> lock(table.mutex);
+
+		auto it = table.ids.find(s);
+
+		return it != table.ids.end() ? it->second : 0;
+	}
+
+	const std::string& NameTable::get(unsigned id)
+	{
+		Table& table = getTable();
+		std::lock_guard<std::mutex> lock(table.mutex);
+
+		return id < table.names.size() ? table.names[id] : table.names[0];
+	}
+
+	std::size_t NameTable::getSize()
+	{
+		Table& table = getTable();
+		std::lock_guard<std::mutex> lock(table.mutex);
+
+		return table.names.size();
+	}
+
+	NameTable::Table& NameTable::getTable()
+	{
+		static Table table;
+		return table;
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef NAMETABLE_HPP
+#define NAMETABLE_HPP
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+
+namespace swift
+{
+	// every name given to an entity, each kept once and known by an id. Ids are never reused, so
+	// equal names always have equal ids, and comparing names is comparing ids. Id 0 is ""
+	class NameTable
+	{
+		public:
+			// the id of s, adding it if it's new
+			static unsigned intern(const std::string& s);
+
+			// the id of s, or 0 if no entity was ever given it without adding it
+			static unsigned find(const std::string& s);
+
+			// "" for unknown ids. The reference stays valid for the whole run
+			static const std::string& get(unsigned id);
+
+			static std::size_t getSize();
+
+		private:
+			struct Table
+			{
+				Table();
+
+				std::deque<std::string> names;		// indexed by id, a deque so references to them stay valid
+				std::unordered_map<std::string, unsigned> ids;
+				std::mutex mutex;
+			};
+
+			static Table& getTable();
+	};
+}
+
+#endif // NAMETABLE_HPP
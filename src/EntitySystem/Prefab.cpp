@@ -0,0 +1,118 @@
+#include "Prefab.hpp"
+
+#include <map>
+#include <fstream>
+#include <iterator>
+
+#include <tinyxml2.h>
+
+#include "Components/Drawable.hpp"
+#include "Components/Animated.hpp"
+#include "../ResourceManager/AssetManager.hpp"
+#include "../Logger/Logger.hpp"
+
+namespace swift
+{
+	Prefab::Prefab()
+	:	entity(storage),
+		resolved(false)
+	{
+	}
+
+	bool Prefab::loadFromFile(const std::string& f)
+	{
+		std::ifstream fin(f, std::ios::binary);
+
+		if(!fin)
+			return false;
+
+		std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+		return loadFromMemory(text.data(), text.size(), f);
+	}
+
+	bool Prefab::loadFromMemory(const void* data, std::size_t size, const std::string& f)
+	{
+		tinyxml2::XMLDocument doc;
+
+		if(doc.Parse(static_cast<const char*>(data), size) != tinyxml2::XML_SUCCESS)
+			return false;
+
+		tinyxml2::XMLElement* root = doc.FirstChildElement("prefab");
+
+		if(root == nullptr)
+		{
+			SWIFT_ERROR(Entities, "Prefab file \"" << f << "\" does not have a \"prefab\" root element.\n");
+			return false;
+		}
+
+		for(tinyxml2::XMLElement* component = root->FirstChildElement(); component != nullptr; component = component->NextSiblingElement())
+		{
+			std::string componentName = component->Value();
+
+			if(!entity.add(componentName))
+			{
+				SWIFT_WARNING(Entities, "Unknown or repeated component \"" << componentName << "\" in prefab \"" << f << "\".\n");
+				continue;
+			}
+
+			std::map<std::string, std::string> variables;
+
+			for(tinyxml2::XMLElement* variable = component->FirstChildElement(); variable != nullptr; variable = variable->NextSiblingElement())
+			{
+				if(variable->GetText() != nullptr)
+					variables.emplace(variable->Value(), variable->GetText());
+			}
+
+			entity.get(componentName)->unserialize(variables);
+		}
+
+		file = f;
+		resolved = false;
+
+		return true;
+	}
+
+	void Prefab::resolve(AssetManager& assets)
+	{
+		if(resolved)
+			return;
+
+		std::lock_guard<std::mutex> lock(resolving);
+
+		if(resolved)
+			return;
+
+		// copies share the sprite's texture
+		swift::Drawable* draw = entity.get<swift::Drawable>();
+
+		if(draw)
+		{
+			sf::IntRect region;
+			AssetHandle<sf::Texture> texture = assets.acquireSprite(draw->texture, region);
+			draw->setTexture(texture, region);
+		}
+
+		Animated* anim = entity.get<Animated>();
+		AnimTexture* animTex = anim ? assets.getAnimTexture(anim->animationFile) : nullptr;
+
+		if(animTex)
+		{
+			sf::IntRect region;
+			AssetHandle<sf::Texture> texture = assets.acquireSprite(animTex->getTextureFile(), region);
+			anim->setAnimTexture(*animTex, texture, region);
+		}
+
+		resolved = true;
+	}
+
+	const Entity& Prefab::getEntity() const
+	{
+		return entity;
+	}
+
+	const std::string& Prefab::getFile() const
+	{
+		return file;
+	}
+}
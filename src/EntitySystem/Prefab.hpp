@@ -0,0 +1,52 @@
+#ifndef PREFAB_HPP
+#define PREFAB_HPP
+
+#include <string>
+#include <atomic>
+#include <mutex>
+
+#include "Entity.hpp"
+
+namespace swift
+{
+	class AssetManager;
+
+	// a named entity template, from a .prefab file in a "prefabs" folder of the assets.
+	// files are laid out like an entity of an XML world save, with a "prefab" root element:
+	//	<prefab>
+	//		<Physical><sizeX>16</sizeX><sizeY>16</sizeY></Physical>
+	//		<Drawable><texture>./data/textures/crate.png</texture></Drawable>
+	//	</prefab>
+	// the template's components are parsed once, spawning copies them straight between pools
+	class Prefab
+	{
+		public:
+			Prefab();
+
+			Prefab(const Prefab&) = delete;
+			Prefab& operator=(const Prefab&) = delete;
+
+			bool loadFromFile(const std::string& file);
+
+			// a prefab file's text from somewhere else, a pack. file is what it's known as
+			bool loadFromMemory(const void* data, std::size_t size, const std::string& file);
+
+			// looks the template's textures up, once. Textures may be loaded after the prefab, so it's done on first spawn.
+			// Worlds ticking on other threads may spawn it at the same time
+			void resolve(AssetManager& assets);
+
+			const Entity& getEntity() const;
+			const std::string& getFile() const;
+
+		private:
+			// must outlive entity
+			ComponentStorage storage;
+			Entity entity;
+
+			std::string file;
+			std::atomic<bool> resolved;
+			std::mutex resolving;
+	};
+}
+
+#endif // PREFAB_HPP
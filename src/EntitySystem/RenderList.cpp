@@ -0,0 +1,166 @@
+#include "RenderList.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Components/Drawable.hpp"
+#include "Components/Animated.hpp"
+#include "Components/Physical.hpp"
+
+namespace swift
+{
+	RenderList::RenderList()
+	:	frame(0)
+	{
+	}
+
+	void RenderList::update(const std::vector<Entity*>& drawables, const std::vector<Entity*>& animateds, float e, const sf::FloatRect& v)
+	{
+		frame++;
+		visible = v;
+
+		auto mark = [this](Entity* entity, bool animated)
+		{
+			unsigned slot = entity->getID() * 2 + animated;
+
+			if(slot >= seen.size())
+			{
+				current.resize(slot + 1, nullptr);
+				seen.resize(slot + 1, 0);
+				kept.resize(slot + 1, 0);
+			}
+
+			current[slot] = entity;
+			seen[slot] = frame;
+		};
+
+		for(auto& a : animateds)
+			mark(a, true);
+
+		for(auto& d : drawables)
+			mark(d, false);
+
+		// last frame's items still in a view stay where they were. Ids may have been reused, so entities are looked up again
+		std::size_t size = 0;
+
+		for(auto& i : items)
+		{
+			if(seen[i.slot] != frame)
+				continue;
+
+			i.entity = current[i.slot];
+			kept[i.slot] = frame;
+			items[size++] = i;
+		}
+
+		items.resize(size);
+		std::size_t previous = size;
+
+		// animated sprites went first before they were drawn together, so they still do where keys are equal
+		for(auto& a : animateds)
+		{
+			if(kept[a->getID() * 2 + 1] != frame)
+				add(a, true);
+		}
+
+		for(auto& d : drawables)
+		{
+			if(kept[d->getID() * 2] != frame)
+				add(d, false);
+		}
+
+		for(auto& i : items)
+		{
+			const Physical* phys = i.entity->get<Physical>();
+
+			// interpolate between the last two updates, so movement is smooth at low tick rates
+			sf::Vector2f pos = phys->getDrawPosition(e);
+			pos = {std::floor(pos.x), std::floor(pos.y)};
+			float angle = phys->getDrawAngle(e);
+
+			// entities standing still leave their sprite's transform as it is
+			if(i.slot & 1)
+			{
+				Animated* anim = i.entity->get<Animated>();
+				anim->place(pos, angle);
+				i.sprite = &anim->sprite;
+			}
+			else
+			{
+				// qualified, sf::Drawable would be found first
+				swift::Drawable* draw = i.entity->get<swift::Drawable>();
+				draw->place(pos, angle);
+				i.sprite = &draw->sprite;
+			}
+
+			i.key = makeKey(phys->zIndex, pos);
+		}
+
+		auto less = [](const Item& one, const Item& two)
+		{
+			return one.key < two.key;
+		};
+
+		// mostly in order already. Lots of new items would take too many shifts, they're sorted in one go
+		if(items.size() - previous > 64 && items.size() - previous > previous / 8)
+		{
+			std::stable_sort(items.begin(), items.end(), less);
+			return;
+		}
+
+		for(std::size_t i = 1; i < items.size(); i++)
+		{
+			if(!less(items[i], items[i - 1]))
+				continue;
+
+			Item item = items[i];
+			std::size_t j = i;
+
+			for(; j > 0 && less(item, items[j - 1]); j--)
+				items[j] = items[j - 1];
+
+			items[j] = item;
+		}
+	}
+
+	std::size_t RenderList::getSize() const
+	{
+		return items.size();
+	}
+
+	std::size_t RenderList::getBatchCount() const
+	{
+		return batch.getBatchCount();
+	}
+
+	void RenderList::draw(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		batch.clear();
+
+		for(auto& i : items)
+		{
+			if(i.sprite->getGlobalBounds().intersects(visible))
+				batch.add(*i.sprite);
+		}
+
+		target.draw(batch, states);
+	}
+
+	std::uint64_t RenderList::makeKey(unsigned zIndex, const sf::Vector2f& pos)
+	{
+		// positions are biased so negative ones sort first, and clamped to what fits
+		const float bias = 1 << 23;
+		const float most = (1 << 24) - 1;
+
+		std::uint64_t z = std::min(zIndex, 0xffffu);
+		std::uint64_t y = static_cast<std::uint64_t>(std::min(std::max(pos.y + bias, 0.f), most));
+		std::uint64_t x = static_cast<std::uint64_t>(std::min(std::max(pos.x + bias, 0.f), most));
+
+		return z << 48 | y << 24 | x;
+	}
+
+	void RenderList::add(Entity* entity, bool animated)
+	{
+		items.push_back({entity, nullptr, 0, entity->getID() * 2 + animated});
+	}
+}
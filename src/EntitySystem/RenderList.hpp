@@ -0,0 +1,63 @@
+#ifndef RENDERLIST_HPP
+#define RENDERLIST_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+
+#include "Entity.hpp"
+#include "SpriteBatch.hpp"
+
+namespace swift
+{
+	// the sprites of Drawable and Animated entities, in the order they're drawn: by z index, then top to bottom, then left to right.
+	// the order is kept from one frame to the next and sorted again from there, so entities that moved a little cost a few swaps
+	class RenderList : public sf::Drawable
+	{
+		public:
+			RenderList();
+
+			// places every sprite where its entity is drawn at e between the last two updates, then sorts.
+			// entities may be in both views, both their sprites are drawn. Sprites that don't overlap visible aren't drawn
+			void update(const std::vector<Entity*>& drawables, const std::vector<Entity*>& animateds, float e, const sf::FloatRect& visible);
+
+			std::size_t getSize() const;
+
+			// draw calls the last draw took
+			std::size_t getBatchCount() const;
+
+		private:
+			// in one draw call per run of sprites sharing a texture
+			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+			struct Item
+			{
+				Entity* entity;
+				sf::Sprite* sprite;
+				std::uint64_t key;
+				unsigned slot;		// entity id * 2, + 1 for the Animated sprite
+			};
+
+			// 16 bits of z index, then 24 each of y and x, in whole pixels
+			static std::uint64_t makeKey(unsigned zIndex, const sf::Vector2f& pos);
+
+			void add(Entity* entity, bool animated);
+
+			std::vector<Item> items;
+
+			// by slot, for telling which items are still in a view without searching for them
+			std::vector<Entity*> current;	// in a view this frame
+			std::vector<unsigned> seen;		// frame the slot was in a view
+			std::vector<unsigned> kept;		// frame the slot's item was kept from the last one
+			unsigned frame;
+
+			sf::FloatRect visible;
+			mutable SpriteBatch batch;
+	};
+}
+
+#endif // RENDERLIST_HPP
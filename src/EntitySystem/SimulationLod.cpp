@@ -0,0 +1,186 @@
+#include "SimulationLod.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "Components/Physical.hpp"
+
+namespace swift
+{
+	std::vector<SimulationLod::Band> SimulationLod::bands;
+
+	SimulationLod::SimulationLod()
+	:	tick(0)
+	{
+	}
+
+	void SimulationLod::setBands(const std::vector<Band>& b)
+	{
+		bands = b;
+
+		// states keep a band in a byte
+		if(bands.size() >= Unplaced)
+			bands.resize(Unplaced - 1);
+
+		for(auto& band : bands)
+			band.interval = std::max(band.interval, 1u);
+
+		std::sort(bands.begin(), bands.end(), [](const Band& one, const Band& two)
+		{
+			return one.radius < two.radius;
+		});
+	}
+
+	const std::vector<SimulationLod::Band>& SimulationLod::getBands()
+	{
+		return bands;
+	}
+
+	bool SimulationLod::parseBands(const std::string& text)
+	{
+		std::vector<Band> parsed;
+		std::istringstream in(text);
+		std::string pair;
+
+		while(std::getline(in, pair, ','))
+		{
+			std::istringstream values(pair);
+			Band band;
+			char colon = 0;
+
+			if(!(values >> band.radius >> colon >> band.interval) || colon != ':' || band.radius <= 0)
+				return false;
+
+			parsed.push_back(band);
+		}
+
+		setBands(parsed);
+		return true;
+	}
+
+	bool SimulationLod::isEnabled()
+	{
+		return !bands.empty();
+	}
+
+	float SimulationLod::getReach()
+	{
+		return bands.empty() ? 0 : bands.back().radius;
+	}
+
+	void SimulationLod::begin(ComponentStorage& storage)
+	{
+		tick++;
+
+		for(auto& s : states)
+			s.band = Unplaced;
+
+		const unsigned char frozen = static_cast<unsigned char>(bands.size());
+		ComponentPool<Physical>& physicals = storage.getPool<Physical>();
+
+		for(std::size_t i = 0; i < physicals.size(); i++)
+			getState(physicals.getOwner(i)).band = frozen;
+	}
+
+	void SimulationLod::place(unsigned id, float distanceSquared)
+	{
+		State& state = getState(id);
+
+		for(unsigned char b = 0; b < state.band && b < bands.size(); b++)
+		{
+			if(distanceSquared <= bands[b].radius * bands[b].radius)
+			{
+				state.band = b;
+				break;
+			}
+		}
+	}
+
+	void SimulationLod::wake(unsigned id, unsigned ticks)
+	{
+		State& state = getState(id);
+		state.awakeUntil = std::max(state.awakeUntil, tick + ticks);
+	}
+
+	void SimulationLod::finish()
+	{
+		const unsigned char frozen = static_cast<unsigned char>(bands.size());
+
+		counts.assign(bands.size() + 1, 0);
+
+		for(unsigned id = 0; id < states.size(); id++)
+		{
+			State& s = states[id];
+
+			if(s.band != Unplaced && s.awakeUntil > tick)
+				s.band = 0;
+
+			if(s.band == Unplaced)
+			{
+				s.step = 1;
+				s.last = tick;
+				continue;
+			}
+
+			counts[s.band]++;
+
+			if(s.band == frozen)
+			{
+				s.step = 0;
+				s.last = tick;
+			}
+			else if((tick + id) % bands[s.band].interval == 0)
+			{
+				// staggered by id, so a band's entities are spread over its ticks. Entities that just came
+				// from a less frequent band may be due sooner, they catch up on the time they were waiting
+				s.step = tick - s.last;
+				s.last = tick;
+			}
+			else
+				s.step = 0;
+		}
+	}
+
+	unsigned SimulationLod::getStep(unsigned id) const
+	{
+		return id < states.size() ? states[id].step : 1;
+	}
+
+	bool SimulationLod::isFrozen(unsigned id) const
+	{
+		return id < states.size() && states[id].band == bands.size();
+	}
+
+	void SimulationLod::split(const std::vector<Entity*>& entities, std::vector<std::vector<Entity*>>& buckets) const
+	{
+		for(auto& b : buckets)
+			b.clear();
+
+		for(auto& e : entities)
+		{
+			unsigned step = getStep(e->getID());
+
+			if(step == 0)
+				continue;
+
+			if(step >= buckets.size())
+				buckets.resize(step + 1);
+
+			buckets[step].push_back(e);
+		}
+	}
+
+	std::size_t SimulationLod::getCount(std::size_t b) const
+	{
+		return b < counts.size() ? counts[b] : 0;
+	}
+
+	SimulationLod::State& SimulationLod::getState(unsigned id)
+	{
+		// new entities start as if they ran last tick
+		if(id >= states.size())
+			states.resize(id + 1, {Unplaced, 1, tick - 1, 0});
+
+		return states[id];
+	}
+}
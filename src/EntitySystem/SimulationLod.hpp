@@ -0,0 +1,83 @@
+#ifndef SIMULATIONLOD_HPP
+#define SIMULATIONLOD_HPP
+
+#include <vector>
+#include <string>
+
+#include "Entity.hpp"
+#include "ComponentStorage.hpp"
+
+namespace swift
+{
+	// how often each entity is simulated, by how far it is from the nearest focus, such as a player or the camera.
+	// entities inside a band's radius run every interval ticks, given the time since they last ran, so far ones
+	// move and path more coarsely. Past the last band they're frozen, time doesn't pass for them until they're
+	// back in a band or woken. Entities without a Physical have no position, and always run every tick
+	class SimulationLod
+	{
+		public:
+			struct Band
+			{
+				float radius;
+				unsigned interval;	// ticks, at least 1
+			};
+
+			SimulationLod();
+
+			// shared by every world, nearest first. No bands, the default, runs everything every tick
+			static void setBands(const std::vector<Band>& b);
+			static const std::vector<Band>& getBands();
+
+			// as "radius:interval" pairs split by commas, "1024:1,2048:4,4096:16". false if it doesn't parse, the bands are unchanged then
+			static bool parseBands(const std::string& text);
+
+			static bool isEnabled();
+
+			// how far the last band reaches, what the focus queries need to cover
+			static float getReach();
+
+			// starts a tick with every Physical entity frozen, until place finds it near a focus
+			void begin(ComponentStorage& storage);
+
+			// entity id is distanceSquared from a focus. The nearest focus decides the band
+			void place(unsigned id, float distanceSquared);
+
+			// runs id every tick for the next ticks, however far it is, such as when something runs into it
+			void wake(unsigned id, unsigned ticks);
+
+			// decides which entities run this tick, once every one has been placed
+			void finish();
+
+			// ticks id is given this tick, 0 if it doesn't run. 1 for entities the lod doesn't know
+			unsigned getStep(unsigned id) const;
+
+			bool isFrozen(unsigned id) const;
+
+			// entities into buckets by step, buckets[s] for those given s ticks. Frozen and waiting ones are left out
+			void split(const std::vector<Entity*>& entities, std::vector<std::vector<Entity*>>& buckets) const;
+
+			// entities in band b this tick, getBands().size() for frozen ones
+			std::size_t getCount(std::size_t b) const;
+
+		private:
+			static const unsigned char Unplaced = 255;
+
+			struct State
+			{
+				unsigned char band;		// index into bands, bands.size() frozen, Unplaced for no Physical
+				unsigned step;
+				unsigned last;			// tick it last ran, or was frozen through
+				unsigned awakeUntil;
+			};
+
+			State& getState(unsigned id);
+
+			std::vector<State> states;		// by entity id
+			std::vector<std::size_t> counts;
+			unsigned tick;
+
+			static std::vector<Band> bands;
+	};
+}
+
+#endif // SIMULATIONLOD_HPP
@@ -0,0 +1,65 @@
+#include "SpriteBatch.hpp"
+
+#include <cmath>
+
+#include "../Profiling/FrameStats.hpp"
+
+namespace swift
+{
+	void SpriteBatch::clear()
+	{
+		vertices.clear();
+		batches.clear();
+	}
+
+	void SpriteBatch::add(const sf::Sprite& sprite)
+	{
+		const sf::Texture* texture = sprite.getTexture();
+
+		if(texture == nullptr)
+			return;
+
+		if(batches.empty() || batches.back().texture != texture)
+			batches.push_back({texture, vertices.size(), 0});
+
+		// the same corners and texture coordinates sf::Sprite uses, flipped rects included
+		const sf::IntRect& rect = sprite.getTextureRect();
+		const sf::Transform& transform = sprite.getTransform();
+		const sf::Color& color = sprite.getColor();
+
+		float width = static_cast<float>(std::abs(rect.width));
+		float height = static_cast<float>(std::abs(rect.height));
+
+		float left = static_cast<float>(rect.left);
+		float right = left + rect.width;
+		float top = static_cast<float>(rect.top);
+		float bottom = top + rect.height;
+
+		vertices.emplace_back(transform.transformPoint(0, 0), color, sf::Vector2f(left, top));
+		vertices.emplace_back(transform.transformPoint(width, 0), color, sf::Vector2f(right, top));
+		vertices.emplace_back(transform.transformPoint(width, height), color, sf::Vector2f(right, bottom));
+		vertices.emplace_back(transform.transformPoint(0, height), color, sf::Vector2f(left, bottom));
+
+		batches.back().count += 4;
+	}
+
+	std::size_t SpriteBatch::getBatchCount() const
+	{
+		return batches.size();
+	}
+
+	std::size_t SpriteBatch::getSpriteCount() const
+	{
+		return vertices.size() / 4;
+	}
+
+	void SpriteBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		for(auto& b : batches)
+		{
+			states.texture = b.texture;
+			target.draw(&vertices[b.first], b.count, sf::PrimitiveType::Quads, states);
+			FrameStats::countDraw(FrameStats::Draws::Sprites, b.count);
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef SPRITEBATCH_HPP
+#define SPRITEBATCH_HPP
+
+#include <vector>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+
+namespace swift
+{
+	// sprites as quads, drawn with one draw call per run of sprites sharing a texture.
+	// sprites are drawn in the order they were added, so add them sorted by texture where
+	// the order between them doesn't matter.
+	// the vertices are kept between clears, so a batch refilled every frame doesn't allocate
+	class SpriteBatch : public sf::Drawable
+	{
+		public:
+			void clear();
+
+			// with the sprite's transform, texture rect, and color as they are now. Sprites without a texture are skipped
+			void add(const sf::Sprite& sprite);
+
+			// draw calls the batch makes
+			std::size_t getBatchCount() const;
+			std::size_t getSpriteCount() const;
+
+		private:
+			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+
+			struct Batch
+			{
+				const sf::Texture* texture;
+				std::size_t first;		// vertex
+				std::size_t count;
+			};
+
+			std::vector<sf::Vertex> vertices;
+			std::vector<Batch> batches;
+	};
+}
+
+#endif // SPRITEBATCH_HPP
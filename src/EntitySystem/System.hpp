@@ -9,7 +9,23 @@ namespace swift
 	{
 		public:
 			virtual ~System() = default;
+			
+			// entities passed in are expected to have every component in getSignature()
 			virtual void update(std::vector<Entity*>& entities, float dt) = 0;
+			
+			virtual ComponentMask getSignature() const = 0;
+			
+			// components the system reads from and writes to, used to decide which systems may run at the same time.
+			// by default, everything in the signature is written
+			virtual ComponentMask getReads() const
+			{
+				return getSignature();
+			}
+			
+			virtual ComponentMask getWrites() const
+			{
+				return getSignature();
+			}
 	};
 }
 
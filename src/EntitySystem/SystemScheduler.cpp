@@ -0,0 +1,152 @@
+#include "SystemScheduler.hpp"
+
+#include <SFML/System/Clock.hpp>
+
+#include "../Profiling/Profiler.hpp"
+#include "../Memory/FrameArena.hpp"
+
+namespace swift
+{
+	ThreadPool* SystemScheduler::threadPool = nullptr;
+	std::map<std::string, unsigned> SystemScheduler::intervals;
+
+	void SystemScheduler::add(const System& system, const Job& job, const std::string& name)
+	{
+		Entry entry;
+		entry.reads = system.getReads();
+		entry.writes = system.getWrites();
+		entry.job = job;
+		entry.stage = 0;
+		entry.name = name;
+		entry.interval = getInterval(name);
+		entry.elapsed = 0;
+
+		// staggered by when they were added, so slow systems don't all land on the same run
+		entry.wait = entries.size() % entry.interval;
+
+		for(auto& e : entries)
+		{
+			if(conflicts(e, entry) && e.stage >= entry.stage)
+				entry.stage = e.stage + 1;
+		}
+
+		if(entry.stage >= stages.size())
+			stages.resize(entry.stage + 1);
+
+		stages[entry.stage].push_back(entries.size());
+		entries.push_back(entry);
+	}
+
+	void SystemScheduler::run(float dt)
+	{
+		// every tick, so from the arena instead of the heap
+		FrameArena::Scope scope;
+		FrameVector<ThreadPool::Job> jobs;
+		FrameVector<unsigned> due;
+
+		for(auto& s : stages)
+		{
+			due.clear();
+
+			for(auto& i : s)
+			{
+				Entry& entry = entries[i];
+				entry.elapsed += dt;
+
+				if(entry.wait == 0)
+				{
+					entry.wait = entry.interval;
+					due.push_back(i);
+				}
+
+				entry.wait--;
+			}
+
+			if(due.size() == 1 || threadPool == nullptr)
+			{
+				for(auto& i : due)
+					runEntry(entries[i]);
+			}
+			else if(!due.empty())
+			{
+				jobs.clear();
+
+				for(auto& i : due)
+				{
+					Entry& entry = entries[i];
+					jobs.push_back([&entry]()
+					{
+						runEntry(entry);
+					});
+				}
+
+				threadPool->run(jobs.data(), jobs.size());
+			}
+		}
+	}
+
+	unsigned SystemScheduler::getStageCount() const
+	{
+		return stages.size();
+	}
+
+	std::size_t SystemScheduler::getSystemCount() const
+	{
+		return entries.size();
+	}
+
+	const std::string& SystemScheduler::getName(std::size_t system) const
+	{
+		return entries[system].name;
+	}
+
+	sf::Time SystemScheduler::getTime(std::size_t system) const
+	{
+		return entries[system].time;
+	}
+
+	void SystemScheduler::setThreadPool(ThreadPool& tp)
+	{
+		threadPool = &tp;
+	}
+
+	ThreadPool* SystemScheduler::getThreadPool()
+	{
+		return threadPool;
+	}
+
+	void SystemScheduler::setInterval(const std::string& name, unsigned ticks)
+	{
+		intervals[name] = ticks == 0 ? 1 : ticks;
+	}
+
+	unsigned SystemScheduler::getInterval(const std::string& name)
+	{
+		auto it = intervals.find(name);
+		return it != intervals.end() ? it->second : 1;
+	}
+
+	void SystemScheduler::parallelFor(std::size_t count, const ThreadPool::RangeJob& func)
+	{
+		if(threadPool)
+			threadPool->parallelFor(count, func);
+		else if(count != 0)
+			func(0, count);
+	}
+
+	void SystemScheduler::runEntry(Entry& entry)
+	{
+		SWIFT_PROFILE(entry.name.c_str());
+		
+		// each entry is only ever run by one thread at a time, so its time needs no lock
+		sf::Clock clock;
+		entry.job(entry.elapsed);
+		entry.time = clock.getElapsedTime();
+		entry.elapsed = 0;
+	}
+
+	bool SystemScheduler::conflicts(const Entry& one, const Entry& two)
+	{
+		return (one.writes & (two.reads | two.writes)).any() || (two.writes & one.reads).any();
+	}
+}
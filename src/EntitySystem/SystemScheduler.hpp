@@ -0,0 +1,91 @@
+#ifndef SYSTEMSCHEDULER_HPP
+#define SYSTEMSCHEDULER_HPP
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <map>
+
+#include <SFML/System/Time.hpp>
+
+#include "System.hpp"
+#include "../Threading/ThreadPool.hpp"
+
+namespace swift
+{
+	// runs systems in the order they were added, but lets systems whose component
+	// reads and writes don't conflict run at the same time.
+	// systems are grouped into stages: a system goes one stage after the last earlier system it conflicts with
+	class SystemScheduler
+	{
+		public:
+			using Job = std::function<void(float)>;
+
+			// job is what runs the system, so the caller decides what the system is given. name is for stats,
+			// and for looking up how often the system runs
+			void add(const System& system, const Job& job, const std::string& name = "");
+
+			void run(float dt);
+
+			unsigned getStageCount() const;
+
+			// systems in the order they were added, and how long each took in the last run
+			std::size_t getSystemCount() const;
+			const std::string& getName(std::size_t system) const;
+			sf::Time getTime(std::size_t system) const;
+
+			// pool shared by all schedulers. Without one, everything runs on the calling thread
+			static void setThreadPool(ThreadPool& tp);
+			static ThreadPool* getThreadPool();
+			
+			// systems named name, added after this, run every ticks runs instead of every run, given the time since
+			// they last ran. Systems sharing an interval are spread over the runs between instead of all running on one
+			static void setInterval(const std::string& name, unsigned ticks);
+			static unsigned getInterval(const std::string& name);
+
+			// for use inside systems, splits the work over the pool if there is one
+			static void parallelFor(std::size_t count, const ThreadPool::RangeJob& func);
+
+			template<typename T, typename F>
+			static void parallelForEach(std::vector<T>& items, F func)
+			{
+				if(threadPool)
+					threadPool->parallelForEach(items, func);
+				else
+				{
+					for(auto& i : items)
+						func(i);
+				}
+			}
+
+		private:
+			struct Entry
+			{
+				ComponentMask reads;
+				ComponentMask writes;
+				Job job;
+				unsigned stage;
+				std::string name;
+				sf::Time time;
+				
+				unsigned interval;
+				unsigned wait;	// runs left until it's due
+				float elapsed;	// passed since it last ran
+			};
+
+			// with the time since it last ran
+			static void runEntry(Entry& entry);
+
+			static bool conflicts(const Entry& one, const Entry& two);
+
+			std::vector<Entry> entries;
+
+			// indices into entries, per stage
+			std::vector<std::vector<unsigned>> stages;
+
+			static ThreadPool* threadPool;
+			static std::map<std::string, unsigned> intervals;
+	};
+}
+
+#endif // SYSTEMSCHEDULER_HPP
@@ -1,65 +1,63 @@
 #include "AnimatedSystem.hpp"
 
+#include "../SystemScheduler.hpp"
+
 namespace swift
 {
 	void AnimatedSystem::update(std::vector<Entity*>& entities, float dt)
 	{
-		for(auto& e : entities)
-		{
-			if(e->has<Animated>() && e->has<Physical>())
-			{
-				Physical* phys = e->get<Physical>();
-				Animated* anim = e->get<Animated>();
-
-				anim->sprite.setPosition(std::floor(phys->position.x), std::floor(phys->position.y));
-
-				anim->sprite.setOrigin(std::floor(phys->size.x / 2.f), std::floor(phys->size.y / 2.f));
-				anim->sprite.setRotation(phys->angle);
-				anim->sprite.setOrigin(0.f, 0.f);
-				
-				anim->sprite.setTextureRect(anim->anims[anim->currentAnim].update(dt));
-			}
-		}
-	}
-
-	void AnimatedSystem::draw(std::vector<Entity*>& entities, float e, sf::RenderTarget& target, sf::RenderStates states) const
-	{
-		std::vector<Entity*> animateds;
+		batch.clear();
+		batched.clear();
+		anims.clear();
 		
 		for(auto& e : entities)
 		{
-			if(e->has<Animated>() && e->has<Physical>())
-				animateds.push_back(e);
-		}
-		
-		std::sort(animateds.begin(), animateds.end(), [](Entity* one, Entity* two)
-		{
-			Physical* onePhys = one->get<Physical>();
-			Physical* twoPhys = two->get<Physical>();
+			Animated* anim = e->get<Animated>();
+			const AnimTexture* animTex = anim->animTex;
+			const FrameAnimation* clip = animTex ? animTex->getAnim(anim->anim) : nullptr;
 			
-			if(onePhys->zIndex < twoPhys->zIndex)
-			{
-				return true;
-			}
-			else if(onePhys->zIndex == twoPhys->zIndex)
+			// its animations were loaded again, without the one it was playing
+			if(!clip && animTex && animTex->getAnimCount() != 0)
 			{
-				return onePhys->position.x < twoPhys->position.x || onePhys->position.y < twoPhys->position.y;
+				anim->anim = 0;
+				clip = animTex->getAnim(0);
 			}
-			else
+			
+			if(clip && clip->getFrameCount() != 0)
 			{
-				return false;
+				batch.add(*clip, anim->frame, anim->time);
+				batched.push_back(anim);
+				anims.push_back(clip);
 			}
-		});
+		}
 		
-		for(auto& a : animateds)
+		batch.update(dt);
+		
+		// back into the components, with the frames drawn
+		SystemScheduler::parallelFor(batched.size(), [this](std::size_t begin, std::size_t end)
 		{
-			/*if(d->has<Movable>())
+			for(std::size_t i = begin; i < end; i++)
 			{
-				Movable* m = d->get<Movable>();
-				sf::Sprite* s = &d->get<Drawable>()->sprite;
-				s->setPosition(s->getPosition().x + m->velocity.x * e, s->getPosition().y + m->velocity.y * e);
-			}*/
-			target.draw(a->get<Animated>()->sprite, states);
-		}
+				Animated* anim = batched[i];
+				anim->frame = batch.getFrame(i);
+				anim->time = batch.getTime(i);
+				anim->setFrame(anims[i]->getFrame(anim->frame));
+			}
+		});
+	}
+
+	ComponentMask AnimatedSystem::getSignature() const
+	{
+		return makeMask<Animated, Physical>();
+	}
+	
+	ComponentMask AnimatedSystem::getReads() const
+	{
+		return makeMask<>();
+	}
+	
+	ComponentMask AnimatedSystem::getWrites() const
+	{
+		return makeMask<Animated>();
 	}
 }
@@ -5,17 +5,23 @@
 
 #include "../Entity.hpp"
 
-#include <SFML/Graphics/RenderTarget.hpp>
-#include <SFML/Graphics/RenderStates.hpp>
+#include "../../Animation/AnimationBatch.hpp"
 
 namespace swift
 {
-	class AnimatedSystem
+	class AnimatedSystem : public System
 	{
 		public:
 			virtual void update(std::vector<Entity*>& entities, float dt);
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
 			
-			virtual void draw(std::vector<Entity*>& entities, float e, sf::RenderTarget& target, sf::RenderStates states) const;
+		private:
+			// the playing animations, stepped together, and whose they are
+			AnimationBatch batch;
+			std::vector<Animated*> batched;
+			std::vector<const FrameAnimation*> anims;
 	};
 }
 
@@ -1,36 +1,55 @@
 #include "ControllableSystem.hpp"
 
-#include "../../Math/Math.hpp"
-
 namespace swift
 {
+	namespace
+	{
+		// the unit direction of each combination of keys held, left, right, up, and down as bits 0 through 3.
+		// opposite keys cancel out
+		const float DIAGONAL = 0.70710678f;
+		
+		const sf::Vector2f directions[16] =
+		{
+			// neither up nor down
+			{0, 0}, {-1, 0}, {1, 0}, {0, 0},
+			// up
+			{0, -1}, {-DIAGONAL, -DIAGONAL}, {DIAGONAL, -DIAGONAL}, {0, -1},
+			// down
+			{0, 1}, {-DIAGONAL, DIAGONAL}, {DIAGONAL, DIAGONAL}, {0, 1},
+			// both
+			{0, 0}, {-1, 0}, {1, 0}, {0, 0},
+		};
+	}
+	
 	void ControllableSystem::update(std::vector<Entity*>& entities, float)
 	{
+		// the view only holds entities with both components, so it's usually just the player
 		for(auto& e : entities)
 		{
-			if(e->has<Controllable>() && e->has<Movable>())
-			{
-				Controllable* cont = e->get<Controllable>();
-				Movable* mov = e->get<Movable>();
-				
-				sf::Vector2f moveDir = {0, 0};
-				
-				// set the direction based on keypresses
-				if(cont->moveLeft)
-					moveDir += {-1, 0};
-				
-				if(cont->moveRight)
-					moveDir += {1, 0};
-					
-				if(cont->moveUp)
-					moveDir += {0, -1};
-				
-				if(cont->moveDown)
-					moveDir += {0, 1};
-				
-				// set the velocity based on the direction and the entity's move velocity
-				mov->velocity = math::unit(moveDir) * mov->moveVelocity;
-			}
+			Controllable* cont = e->get<Controllable>();
+			Movable* mov = e->get<Movable>();
+			
+			unsigned keys = cont->moveLeft | cont->moveRight << 1 | cont->moveUp << 2 | cont->moveDown << 3;
+			sf::Vector2f velocity = directions[keys] * mov->moveVelocity;
+			
+			// only written when the keys held, the entity's speed, or its velocity from elsewhere changed
+			if(mov->velocity != velocity)
+				mov->velocity = velocity;
 		}
 	}
+	
+	ComponentMask ControllableSystem::getSignature() const
+	{
+		return makeMask<Controllable, Movable>();
+	}
+	
+	ComponentMask ControllableSystem::getReads() const
+	{
+		return makeMask<Controllable>();
+	}
+	
+	ComponentMask ControllableSystem::getWrites() const
+	{
+		return makeMask<Movable>();
+	}
 }
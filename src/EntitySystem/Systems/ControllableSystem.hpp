@@ -9,6 +9,9 @@ namespace swift
 	{
 		public:
 			virtual void update(std::vector<Entity*>& entities, float dt);
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
 	};
 }
 
@@ -5,17 +5,15 @@
 
 #include "../Entity.hpp"
 
-#include <SFML/Graphics/RenderTarget.hpp>
-#include <SFML/Graphics/RenderStates.hpp>
-
 namespace swift
 {
 	class DrawableSystem : public System
 	{
 		public:
 			virtual void update(std::vector<Entity*>& entities, float dt);
-			
-			virtual void draw(std::vector<Entity*>& entities, float e, sf::RenderTarget& target, sf::RenderStates states) const;
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
 	};
 }
 
@@ -1,5 +1,7 @@
 #include "MovableSystem.hpp"
 
+#include "../SystemScheduler.hpp"
+
 #include "../Components/Movable.hpp"
 #include "../Components/Physical.hpp"
 
@@ -7,16 +9,52 @@ namespace swift
 {
 	void MovableSystem::update(std::vector<Entity*>& entities, float dt)
 	{
-		for(auto& e : entities)
+		SystemScheduler::parallelForEach(entities, [dt](Entity* e)
 		{
-			if(e->has<Movable>() && e->has<Physical>())
+			Physical* phys = e->get<Physical>();
+			Movable* mov = e->get<Movable>();
+			
+			phys->position.x += mov->velocity.x * dt;
+			phys->position.y += mov->velocity.y * dt;
+		});
+	}
+	
+	void MovableSystem::update(ComponentStorage& storage, float dt, const SimulationLod* lod)
+	{
+		ComponentPool<Movable>& movables = storage.getPool<Movable>();
+		ComponentPool<Physical>& physicals = storage.getPool<Physical>();
+		
+		SystemScheduler::parallelFor(movables.size(), [&movables, &physicals, dt, lod](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t i = begin; i < end; i++)
 			{
-				Physical* phys = e->get<Physical>();
-				Movable* mov = e->get<Movable>();
+				unsigned owner = movables.getOwner(i);
+				float step = lod ? dt * lod->getStep(owner) : dt;
+				Physical* phys = step != 0 ? physicals.get(owner) : nullptr;
 				
-				phys->position.x += mov->velocity.x * dt;
-				phys->position.y += mov->velocity.y * dt;
+				if(phys)
+				{
+					const Movable& mov = movables[i];
+					
+					phys->position.x += mov.velocity.x * step;
+					phys->position.y += mov.velocity.y * step;
+				}
 			}
-		}
+		});
+	}
+	
+	ComponentMask MovableSystem::getSignature() const
+	{
+		return makeMask<Movable, Physical>();
+	}
+	
+	ComponentMask MovableSystem::getReads() const
+	{
+		return makeMask<Movable>();
+	}
+	
+	ComponentMask MovableSystem::getWrites() const
+	{
+		return makeMask<Physical>();
 	}
 }
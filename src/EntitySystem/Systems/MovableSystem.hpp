@@ -4,6 +4,7 @@
 #include "../System.hpp"
 
 #include "../Entity.hpp"
+#include "../SimulationLod.hpp"
 
 namespace swift
 {
@@ -11,6 +12,12 @@ namespace swift
 	{
 		public:
 			void update(std::vector<Entity*>& entities, float dt);
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
+			
+			// streams the packed Movable pool instead of walking entities. With lod, each entity moves for its step
+			void update(ComponentStorage& storage, float dt, const SimulationLod* lod = nullptr);
 	};
 }
 
@@ -1,7 +1,12 @@
 #include "NoisySystem.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace swift
 {
+	std::mutex NoisySystem::soundMutex;
+	
 	NoisySystem::NoisySystem(SoundPlayer& sp, AssetManager& am)
 		:	soundPlayer(sp),
 		    assets(am)
@@ -9,19 +14,77 @@ namespace swift
 
 	void NoisySystem::update(std::vector<Entity*>& entities, float)
 	{
+		events.clear();
+		
 		for(auto& e : entities)
 		{
-			if(e->has<Noisy>() && e->has<Physical>())
-			{
-				Noisy* noisy = e->get<Noisy>();
-				Physical* physical = e->get<Physical>();
+			Noisy* noisy = e->get<Noisy>();
+			Physical* physical = e->get<Physical>();
 
-				if(noisy->shouldPlay)
+			if(noisy->shouldPlay)
+			{
+				sf::Vector3f position = {physical->position.x, physical->position.y, 0};
+				
+				// too far away to hear, it isn't started at all
+				if(soundPlayer.isAudible(position))
 				{
-					soundPlayer.newSound(*assets.getSoundBuffer(noisy->soundFile), {physical->position.x, physical->position.y, 0}, false);
-					noisy->shouldPlay = false;
+					if(noisy->soundAssetFile != noisy->soundFile)
+					{
+						noisy->soundAsset = assets.acquireSoundBuffer(noisy->soundFile);
+						noisy->soundAssetFile = noisy->soundFile;
+					}
+					
+					if(noisy->soundAsset)
+						addEvent(*noisy->soundAsset, position, noisy->priority);
 				}
+				
+				noisy->shouldPlay = false;
 			}
 		}
+		
+		// unrelated sounds playing together add up the same way, so the gain is how much louder all of them are than the loudest
+		std::lock_guard<std::mutex> lock(soundMutex);
+		
+		for(auto& ev : events)
+			soundPlayer.newSound(*ev.buffer, ev.position, false, ev.priority, std::sqrt(ev.power) / ev.loudest);
+	}
+	
+	void NoisySystem::addEvent(const sf::SoundBuffer& buffer, const sf::Vector3f& position, int priority)
+	{
+		float attenuation = soundPlayer.getAttenuation(position);
+		
+		// a handful of different sounds an update at most
+		for(auto& ev : events)
+		{
+			if(ev.buffer == &buffer)
+			{
+				if(attenuation > ev.loudest)
+				{
+					ev.position = position;
+					ev.loudest = attenuation;
+				}
+				
+				ev.power += attenuation * attenuation;
+				ev.priority = std::max(ev.priority, priority);
+				return;
+			}
+		}
+		
+		events.push_back({&buffer, position, attenuation, attenuation * attenuation, priority});
+	}
+	
+	ComponentMask NoisySystem::getSignature() const
+	{
+		return makeMask<Noisy, Physical>();
+	}
+	
+	ComponentMask NoisySystem::getReads() const
+	{
+		return makeMask<Physical>();
+	}
+	
+	ComponentMask NoisySystem::getWrites() const
+	{
+		return makeMask<Noisy>();
 	}
 }
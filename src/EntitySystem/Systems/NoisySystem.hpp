@@ -5,6 +5,8 @@
 
 #include "../Entity.hpp"
 
+#include <mutex>
+
 #include "../../SoundSystem/SoundPlayer.hpp"
 #include "../../ResourceManager/AssetManager.hpp"
 
@@ -15,10 +17,30 @@ namespace swift
 		public:
 			NoisySystem(SoundPlayer& sp, AssetManager& am);
 			virtual void update(std::vector<Entity*>& entities, float dt);
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
 
 		private:
+			// the same sound started by several entities in one update, played once
+			struct Event
+			{
+				const sf::SoundBuffer* buffer;
+				sf::Vector3f position;	// of the loudest, which the sound plays from
+				float loudest;			// its attenuation
+				float power;			// of all of them, the sum of each one's attenuation squared
+				int priority;			// the highest
+			};
+			
+			void addEvent(const sf::SoundBuffer& buffer, const sf::Vector3f& position, int priority);
+			
 			SoundPlayer& soundPlayer;
 			AssetManager& assets;
+			
+			// the sound player is every world's, and worlds may tick on different threads. Assets lock themselves
+			static std::mutex soundMutex;
+			
+			std::vector<Event> events;
 	};
 }
 
@@ -8,45 +8,190 @@
 
 namespace swift
 {
-	World* PathfinderSystem::world = nullptr;
+	PathfinderSystem::PathfinderSystem()
+	:	world(nullptr)
+	{
+	}
 
 	void PathfinderSystem::update(std::vector<Entity*>& entities, float)
 	{
 		for(auto& e : entities)
 		{
-			if(e->has<Pathfinder>() && e->has<Physical>() && e->has<Movable>())
+			Pathfinder* pf = e->get<Pathfinder>();
+			Physical* phys = e->get<Physical>();
+			Movable* mov = e->get<Movable>();
+			
+			if(world)
 			{
-				Pathfinder* pf = e->get<Pathfinder>();
-				Physical* phys = e->get<Physical>();
-				Movable* mov = e->get<Movable>();
+				if(pf->algorithm == GridSearch::Algorithm::FlowField)
+				{
+					followField(*pf, *phys, *mov);
+					continue;
+				}
 				
-				if(world)
+				if(pf->needsPath)
 				{
-					if(pf->needsPath)
+					PathService& service = world->pathService;
+					
+					// the destination changed since asking, the answer would be no use
+					if(pf->request != PathService::NONE && pf->requestDestination != pf->destination)
 					{
-
-						Path path(phys->position, pf->destination, phys->zIndex, world->tilemap);
-
-						pf->nodes = path.getNodes();
-
-						if(!pf->nodes.empty())
+						service.cancel(pf->request);
+						pf->request = PathService::NONE;
+					}
+					
+					if(pf->request == PathService::NONE)
+					{
+						pf->request = service.submit(phys->position, pf->destination, phys->zIndex, pf->algorithm, pf->priority);
+						pf->requestDestination = pf->destination;
+					}
+					
+					PathService::Result result;
+					
+					if(service.collect(pf->request, result))
+					{
+						pf->request = PathService::NONE;
+						pf->path = std::move(result.path);
+						pf->waypoints = std::move(result.waypoints);
+						pf->pathVersion = result.version;
+						
+						// no path, asks again next update
+						if(!pf->path.isDone())
+						{
 							pf->needsPath = false;
+							
+							// it's standing on the first tile already
+							if(pf->path.size() > 1)
+								pf->path.advance();
+							
+							steer(*pf, *phys, *mov);
+						}
 					}
+					else if(!service.isPending(pf->request))	// dropped as stale
+						pf->request = PathService::NONE;
+				}
 
-					if(!pf->nodes.empty())
+				// tiles changed under the path, detour around whatever got blocked rather than searching again
+				if(!pf->path.isDone())
+				{
+					const Layer* layer = world->tilemap.getLayer(phys->zIndex);
+					
+					if(layer && layer->getVersion() != pf->pathVersion)
 					{
-						if(math::distanceSquared(pf->nodes.front().getPosition(), phys->position) <= world->tilemap.getTileSize().x * world->tilemap.getTileSize().x / 16.f)
+						pf->pathVersion = layer->getVersion();
+						
+						if(Path::repair(pf->path, Path::getTile(phys->position, world->tilemap.getTileSize()), layer->getPassability()))
+							steer(*pf, *phys, *mov);
+						else
 						{
-							pf->nodes.pop_front();
-							
-							if(pf->nodes.empty())	// destination reached!
-								mov->velocity = {0, 0};
-							else					// change direction to next node
-								mov->velocity = math::unit(pf->nodes.front().getPosition() - phys->position) * mov->moveVelocity;
+							pf->path.clear();
+							pf->waypoints.clear();
+							pf->needsPath = true;
+							mov->velocity = {0, 0};
 						}
 					}
 				}
+				
+				if(!pf->path.isDone())
+				{
+					sf::Vector2u tileSize = world->tilemap.getTileSize();
+					
+					if(math::distanceSquared(Path::getTileCenter(pf->path.getCurrent(), tileSize), phys->position) <= tileSize.x * tileSize.x / 16.f)
+					{
+						pf->path.advance();
+						
+						// hierarchical paths are refined a cluster at a time, as they are walked
+						if(pf->path.isDone() && !pf->waypoints.empty() && !refineNext(*pf, phys->zIndex))
+						{
+							pf->waypoints.clear();
+							pf->needsPath = true;
+						}
+						
+						if(pf->path.isDone())	// destination reached!
+							mov->velocity = {0, 0};
+						else					// change direction to next tile
+							steer(*pf, *phys, *mov);
+					}
+				}
 			}
 		}
 	}
+	
+	void PathfinderSystem::followField(Pathfinder& pf, const Physical& phys, Movable& mov)
+	{
+		const TileMap& map = world->tilemap;
+		sf::Vector2u tileSize = map.getTileSize();
+		sf::Vector2i goal = Path::getTile(pf.destination, tileSize);
+		
+		// entities with the same destination tile end up sharing one field
+		if(pf.needsPath || !pf.field || pf.field->getGoal() != goal || FlowFieldCache::isStale(*pf.field, phys.zIndex, map))
+		{
+			pf.field = world->flowFields.get(phys.zIndex, goal, map);
+			pf.needsPath = false;
+			pf.path.clear();
+			pf.waypoints.clear();
+		}
+		
+		sf::Vector2i tile = Path::getTile(phys.position, tileSize);
+		
+		if(!pf.field || !pf.field->reaches(tile.x, tile.y))
+			mov.velocity = {0, 0};
+		else if(tile == goal)
+		{
+			// the last stretch goes straight for the destination
+			if(math::distanceSquared(pf.destination, phys.position) <= tileSize.x * tileSize.x / 16.f)
+				mov.velocity = {0, 0};
+			else
+				mov.velocity = math::unit(pf.destination - phys.position) * mov.moveVelocity;
+		}
+		else
+		{
+			// aiming for the center of the next tile keeps entities off of corners
+			sf::Vector2i next = pf.field->getNext(tile.x, tile.y);
+			mov.velocity = math::unit(Path::getTileCenter(next, tileSize) - phys.position) * mov.moveVelocity;
+		}
+	}
+	
+	void PathfinderSystem::steer(const Pathfinder& pf, const Physical& phys, Movable& mov)
+	{
+		sf::Vector2f target = Path::getTileCenter(pf.path.getCurrent(), world->tilemap.getTileSize());
+		mov.velocity = math::unit(target - phys.position) * mov.moveVelocity;
+	}
+	
+	bool PathfinderSystem::refineNext(Pathfinder& pf, unsigned layer)
+	{
+		static thread_local std::vector<sf::Vector2i> tiles;
+		sf::Vector2i from = pf.waypoints.front();
+		
+		if(!Path::refine(pf.waypoints, tiles, layer, world->tilemap))
+			return false;
+		
+		// smoothed from the waypoint just reached
+		tiles.insert(tiles.begin(), from);
+		const Layer* mapLayer = world->tilemap.getLayer(layer);
+		Path::smooth(tiles, mapLayer->getPassability());
+		
+		pf.path.clear();
+		pf.pathVersion = mapLayer->getVersion();
+		
+		for(std::size_t i = 1; i < tiles.size(); i++)
+			pf.path.append(tiles[i]);
+		
+		return true;
+	}
+	
+	ComponentMask PathfinderSystem::getSignature() const
+	{
+		return makeMask<Pathfinder, Physical, Movable>();
+	}
+	
+	ComponentMask PathfinderSystem::getReads() const
+	{
+		return makeMask<Physical>();
+	}
+	
+	ComponentMask PathfinderSystem::getWrites() const
+	{
+		return makeMask<Pathfinder, Movable>();
+	}
 }
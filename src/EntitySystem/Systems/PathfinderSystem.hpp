@@ -6,13 +6,32 @@
 namespace swift
 {
 	class World;
+	class Pathfinder;
+	class Physical;
+	class Movable;
 
-	class PathfinderSystem
+	class PathfinderSystem : public System
 	{
 		public:
+			PathfinderSystem();
+			
 			virtual void update(std::vector<Entity*>& entities, float);
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
 
-			static World* world;
+			// the one whose map and path service it uses. Its own, worlds may tick on different threads
+			World* world;
+			
+		private:
+			// steers toward the next tile of the field, set up for the entity's destination
+			void followField(Pathfinder& pf, const Physical& phys, Movable& mov);
+			
+			// toward the current tile of the path
+			void steer(const Pathfinder& pf, const Physical& phys, Movable& mov);
+			
+			// refines the path to the next waypoint, false if it can't be reached anymore
+			bool refineNext(Pathfinder& pf, unsigned layer);
 	};
 }
 
@@ -1,41 +1,347 @@
 #include "PhysicalSystem.hpp"
 
 #include "../Components/Physical.hpp"
-
-#include "../../Collision/Collision.hpp"
+#include "../Components/Movable.hpp"
 
 namespace swift
 {
+	PhysicalSystem::PhysicalSystem()
+	:	broadphase(Broadphase::Grid),
+		sleepTicks(30),
+		stamp(0)
+	{
+	}
+	
 	void PhysicalSystem::update(std::vector<Entity*>& entities, float /*dt*/)
 	{
-		for(auto& c : collisions)
-			delete c;
-		
 		collisions.clear();
 		
-		for(auto& e1 : entities)
+		stamp++;
+		
+		for(unsigned i = 0; i < entities.size(); i++)
+		{
+			unsigned id = entities[i]->getID();
+			
+			if(id >= positions.size())
+				positions.resize(id + 1);
+			
+			refit(*entities[i]);
+			
+			Proxy& proxy = proxies[id];
+			proxy.stamp = stamp;
+			positions[id] = i;
+			
+			// entities that can't move are static straight away, movables once they've been still for a while.
+			// Being moved by anything else, a script teleporting it, counts as moving
+			Movable* mov = entities[i]->get<Movable>();
+			const sf::FloatRect& bounds = entities[i]->get<Physical>()->getBounds();
+			
+			if(!mov)
+				stillTicks[id] = sleepTicks;
+			else if(mov->velocity != sf::Vector2f(0, 0) || bounds != proxy.bounds)
+				stillTicks[id] = 0;
+			else if(stillTicks[id] < sleepTicks)
+				stillTicks[id]++;
+			
+			proxy.bounds = bounds;
+		}
+		
+		// anything not seen this update was destroyed, or lost its Physical
+		for(unsigned i = 0; i < tracked.size();)
+		{
+			Proxy& proxy = proxies[tracked[i]];
+			
+			if(proxy.stamp != stamp)
+			{
+				tree.remove(proxy.node);
+				proxy.node = AABBTree::NONE;
+				
+				tracked[i] = tracked.back();
+				tracked.pop_back();
+			}
+			else
+				i++;
+		}
+		
+		findPairs(entities);
+		
+		// unrotated pairs are tested in one batch up front
+		batch.clear();
+		
+		for(auto& p : pairs)
+		{
+			Physical* one = entities[p.first]->get<Physical>();
+			Physical* two = entities[p.second]->get<Physical>();
+			
+			if(one->angle == 0.f && two->angle == 0.f)
+				batch.add(one->getBounds(), two->getBounds());
+		}
+		
+		batch.test(hits);
+		
+		// resolving a collision moves entities, which makes the batch results for their later pairs stale
+		moved.assign(entities.size(), false);
+		
+		std::size_t batched = 0;
+		
+		for(auto& p : pairs)
+		{
+			Entity& one = *entities[p.first];
+			Entity& two = *entities[p.second];
+			
+			Physical* physOne = one.get<Physical>();
+			Physical* physTwo = two.get<Physical>();
+			
+			bool stale = moved[p.first] || moved[p.second];
+			
+			if(physOne->angle == 0.f && physTwo->angle == 0.f)
+			{
+				if(!hits[batched++] && !stale)
+					continue;
+			}
+			else
+				stale = true;
+			
+			// skip pairs whose cells overlap but whose boxes don't
+			if(stale && !physOne->getBounds().intersects(physTwo->getBounds()))
+				continue;
+			
+			collisions.emplace_back(one, two);
+			
+			if(collisions.back().getResult())
+			{
+				moved[p.first] = true;
+				moved[p.second] = true;
+				
+				// getting pushed wakes sleeping entities up
+				stillTicks[one.getID()] = 0;
+				stillTicks[two.getID()] = 0;
+			}
+			else
+				collisions.pop_back();
+		}
+		
+		updateContacts();
+	}
+	
+	const std::vector<Collision>& PhysicalSystem::getCollisions() const
+	{
+		return collisions;
+	}
+	
+	const std::vector<ContactEvent>& PhysicalSystem::getContactEvents() const
+	{
+		return contactEvents;
+	}
+	
+	void PhysicalSystem::setCellSize(const sf::Vector2u& size)
+	{
+		grid.setCellSize(static_cast<sf::Vector2f>(size));
+		
+		// most entities move less than a quarter tile per update
+		tree.setMargin(grid.getCellSize().x / 4.f);
+	}
+	
+	void PhysicalSystem::setBroadphase(Broadphase b)
+	{
+		broadphase = b;
+	}
+	
+	PhysicalSystem::Broadphase PhysicalSystem::getBroadphase() const
+	{
+		return broadphase;
+	}
+	
+	void PhysicalSystem::refit(const Entity& e)
+	{
+		Physical* phys = e.get<Physical>();
+		unsigned id = e.getID();
+		
+		if(!phys)
+			return;
+		
+		if(id >= proxies.size())
+		{
+			proxies.resize(id + 1, {AABBTree::NONE, {}, 0, {}});
+			stillTicks.resize(id + 1, 0);
+		}
+		
+		Proxy& proxy = proxies[id];
+		
+		bool inserted = proxy.node == AABBTree::NONE;
+		
+		if(inserted)
+		{
+			proxy.node = tree.insert(id, phys->getBounds());
+			tracked.push_back(id);
+		}
+		else
+			tree.move(proxy.node, phys->getBounds());
+		
+		// ids are reused, maybe between updates. A new entity starts awake whatever the last one with its id was doing
+		if(inserted || proxy.entity != e.getHandle())
+		{
+			proxy.entity = e.getHandle();
+			proxy.stamp = stamp;
+			proxy.bounds = phys->getBounds();
+			stillTicks[id] = 0;
+		}
+	}
+	
+	void PhysicalSystem::query(const sf::FloatRect& area, std::vector<unsigned>& ids) const
+	{
+		tree.query(area, ids);
+	}
+	
+	void PhysicalSystem::setSleepTicks(unsigned t)
+	{
+		sleepTicks = t;
+	}
+	
+	unsigned PhysicalSystem::getSleepTicks() const
+	{
+		return sleepTicks;
+	}
+	
+	std::size_t PhysicalSystem::getStaticCount() const
+	{
+		return staticBodies.size();
+	}
+	
+	bool PhysicalSystem::isStatic(const Entity& e) const
+	{
+		return stillTicks[e.getID()] >= sleepTicks;
+	}
+	
+	void PhysicalSystem::findPairs(std::vector<Entity*>& entities)
+	{
+		pairs.clear();
+		
+		if(broadphase == Broadphase::Grid)
 		{
-			for(auto& e2 : entities)
+			grid.clear();
+			currentStatic.clear();
+			
+			for(unsigned i = 0; i < entities.size(); i++)
+			{
+				Physical* phys = entities[i]->get<Physical>();
+				
+				if(!phys->collides)
+					continue;
+				
+				if(isStatic(*entities[i]))
+					currentStatic.push_back({entities[i]->getID(), phys->getBounds(), phys->zIndex});
+				else
+					grid.insert(i, phys->getBounds(), phys->zIndex, phys->category, phys->mask);
+			}
+			
+			// the static grid is only rebuilt when the scenery changed
+			if(currentStatic != staticBodies)
+			{
+				staticBodies.swap(currentStatic);
+				staticGrid.setCellSize(grid.getCellSize());
+				staticGrid.clear();
+				
+				for(auto& b : staticBodies)
+					staticGrid.insert(b.id, b.bounds, b.layer);
+			}
+			
+			// dynamic against dynamic
+			grid.getPairs(pairs);
+			
+			// dynamic against static. Static pairs are never tested against each other
+			for(unsigned i = 0; i < entities.size(); i++)
 			{
-				if(e1 != e2)
+				Physical* phys = entities[i]->get<Physical>();
+				
+				if(!phys->collides || isStatic(*entities[i]))
+					continue;
+				
+				found.clear();
+				staticGrid.query(phys->getBounds(), phys->zIndex, found);
+				
+				for(auto& id : found)
 				{
-					if(e1->has<Physical>() && e2->has<Physical>())
-					{
-						collisions.emplace_back(new Collision(*e1, *e2));
-						
-						if(!collisions.back()->getResult())
-						{
-							delete collisions.back();
-							collisions.pop_back();
-						}
-					}
+					if(phys->interacts(*entities[positions[id]]->get<Physical>()))
+						pairs.emplace_back(i, positions[id]);
 				}
 			}
 		}
+		else
+		{
+			tree.getPairs(pairs);
+			
+			// the tree pairs entity ids, and doesn't know about zIndex, collides, masks, or static entities
+			unsigned kept = 0;
+			
+			for(auto& p : pairs)
+			{
+				Entity& one = *entities[positions[p.first]];
+				Entity& two = *entities[positions[p.second]];
+				
+				Physical* physOne = one.get<Physical>();
+				Physical* physTwo = two.get<Physical>();
+				
+				if(physOne->collides && physTwo->collides && physOne->zIndex == physTwo->zIndex && physOne->interacts(*physTwo) && !(isStatic(one) && isStatic(two)))
+					pairs[kept++] = {positions[p.first], positions[p.second]};
+			}
+			
+			pairs.resize(kept);
+		}
 	}
 	
-	std::vector<Collision*> PhysicalSystem::getCollisions() const
+	void PhysicalSystem::updateContacts()
 	{
-		return collisions;
+		contactEvents.clear();
+		
+		for(auto& c : collisions)
+		{
+			EntityHandle one = c.getFirstEntity().getHandle();
+			EntityHandle two = c.getSecondEntity().getHandle();
+			
+			if(two.value < one.value)
+				std::swap(one, two);
+			
+			std::uint64_t key = (static_cast<std::uint64_t>(one.value) << 32) | two.value;
+			
+			auto it = contacts.find(key);
+			
+			if(it == contacts.end())
+			{
+				contacts.emplace(key, Contact{one, two, stamp});
+				contactEvents.push_back({ContactEvent::Type::Begin, one, two});
+			}
+			else
+			{
+				it->second.stamp = stamp;
+				contactEvents.push_back({ContactEvent::Type::Stay, one, two});
+			}
+		}
+		
+		for(auto it = contacts.begin(); it != contacts.end();)
+		{
+			if(it->second.stamp != stamp)
+			{
+				contactEvents.push_back({ContactEvent::Type::End, it->second.one, it->second.two});
+				it = contacts.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+	
+	ComponentMask PhysicalSystem::getSignature() const
+	{
+		return makeMask<Physical>();
+	}
+	
+	ComponentMask PhysicalSystem::getReads() const
+	{
+		return makeMask<Physical, Movable>();
+	}
+	
+	ComponentMask PhysicalSystem::getWrites() const
+	{
+		return makeMask<Physical>();
 	}
 }
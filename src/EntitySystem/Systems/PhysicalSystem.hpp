@@ -3,21 +3,153 @@
 
 #include "../System.hpp"
 
+#include "../../Collision/SpatialGrid.hpp"
+#include "../../Collision/AABBTree.hpp"
+#include "../../Collision/AABBBatch.hpp"
+#include "../../Collision/Collision.hpp"
+#include "../../Collision/ContactEvent.hpp"
+
 #include <vector>
+#include <unordered_map>
+#include <cstdint>
 
 namespace swift
 {
-	class Collision;
-	
 	class PhysicalSystem : public System
 	{
 		public:
+			// Grid suits dense maps of similarly sized entities, Tree suits sparse maps and mixed sizes
+			enum class Broadphase
+			{
+				Grid,
+				Tree
+			};
+			
+			PhysicalSystem();
+			
 			virtual void update(std::vector<Entity*>& entities, float dt);
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
+			
+			// collisions found in the last update. Entities in them may have been removed since
+			const std::vector<Collision>& getCollisions() const;
+			
+			// contacts that began, stayed, or ended in the last update
+			const std::vector<ContactEvent>& getContactEvents() const;
+			
+			// broadphase cell size, usually the tile size of the map
+			void setCellSize(const sf::Vector2u& size);
+			
+			void setBroadphase(Broadphase b);
+			Broadphase getBroadphase() const;
 			
-			std::vector<Collision*> getCollisions() const;
+			// updates the entity's bounds in the tree, for entities moved outside of update
+			void refit(const Entity& e);
+			
+			// appends the ids of entities whose bounds may overlap area. Entities are added to the tree on update
+			// or refit, and the result needs checking against the entities' actual positions
+			void query(const sf::FloatRect& area, std::vector<unsigned>& ids) const;
+			
+			// as AABBTree::raycast, with func(id, maxFraction) given entity ids
+			template<typename F>
+			void raycast(const sf::Vector2f& from, const sf::Vector2f& to, F func) const
+			{
+				tree.raycast(from, to, [this, &func](int proxy, float maxFraction)
+				{
+					return func(tree.getItem(proxy), maxFraction);
+				});
+			}
+			
+			// updates a movable has to stand still before it is treated as static
+			void setSleepTicks(unsigned t);
+			unsigned getSleepTicks() const;
+			
+			// static and sleeping entities in the static broadphase
+			std::size_t getStaticCount() const;
 			
 		private:
-			std::vector<Collision*> collisions;
+			struct Proxy
+			{
+				int node;
+				EntityHandle entity;	// which entity of the id it's for
+				unsigned stamp;			// update the entity was last seen in
+				sf::FloatRect bounds;	// the entity's at the start of that update, moving since wakes it up
+			};
+			
+			struct StaticBody
+			{
+				unsigned id;
+				sf::FloatRect bounds;
+				unsigned layer;
+				
+				bool operator==(const StaticBody& other) const
+				{
+					return id == other.id && layer == other.layer && bounds == other.bounds;
+				}
+				
+				bool operator!=(const StaticBody& other) const
+				{
+					return !(*this == other);
+				}
+			};
+			
+			// entities without a Movable, or that haven't had a velocity, been pushed, or been moved for sleepTicks updates
+			bool isStatic(const Entity& e) const;
+			
+			void findPairs(std::vector<Entity*>& entities);
+			
+			// compares this update's collisions with the contact cache
+			void updateContacts();
+			
+			// cleared every update, but keeps its capacity
+			std::vector<Collision> collisions;
+			
+			struct Contact
+			{
+				EntityHandle one;
+				EntityHandle two;
+				unsigned stamp;		// last update they collided in
+			};
+			
+			// keyed by both handles, the smaller in the high bits
+			std::unordered_map<std::uint64_t, Contact> contacts;
+			std::vector<ContactEvent> contactEvents;
+			
+			Broadphase broadphase;
+			
+			// rebuilt every update from the moving entities, only pairs sharing a cell (and zIndex) are tested
+			SpatialGrid grid;
+			
+			// static entities, by id. Only rebuilt when they change
+			SpatialGrid staticGrid;
+			std::vector<StaticBody> staticBodies;
+			std::vector<StaticBody> currentStatic;
+			std::vector<unsigned> found;
+			
+			// indexed by entity id
+			std::vector<unsigned> stillTicks;
+			unsigned sleepTicks;
+			
+			// every physical entity, kept up to date incrementally. Backs queries with either broadphase
+			AABBTree tree;
+			
+			// indexed by entity id
+			std::vector<Proxy> proxies;
+			std::vector<unsigned> positions;
+			
+			// ids of entities in the tree
+			std::vector<unsigned> tracked;
+			unsigned stamp;
+			
+			std::vector<SpatialGrid::Pair> pairs;
+			
+			// narrowphase for pairs of unrotated boxes
+			AABBBatch batch;
+			std::vector<unsigned char> hits;
+			
+			// indexed by position in the updated entities, set once an entity was pushed by a collision
+			std::vector<bool> moved;
 	};
 }
 
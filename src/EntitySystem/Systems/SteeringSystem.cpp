@@ -0,0 +1,285 @@
+#include "SteeringSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../SystemScheduler.hpp"
+
+#include "../Components/Movable.hpp"
+#include "../Components/Pathfinder.hpp"
+#include "../Components/Physical.hpp"
+
+namespace swift
+{
+	SteeringSystem::SteeringSystem()
+	:	horizon(1),
+		cellSize(32),
+		maxRadius(0),
+		maxSpeed(0)
+	{
+	}
+	
+	void SteeringSystem::update(std::vector<Entity*>& entities, float)
+	{
+		std::size_t count = entities.size();
+		bool steering = false;
+		
+		maxRadius = 0;
+		maxSpeed = 0;
+		
+		for(auto& e : entities)
+		{
+			const Pathfinder* pf = e->get<Pathfinder>();
+			steering = steering || (pf && pf->avoidance > 0);
+		}
+		
+		// nothing to steer, nothing to gather
+		if(!steering)
+			return;
+		
+		radius.resize(count);
+		avoidance.resize(count);
+		speed.resize(count);
+		posX.resize(count);
+		posY.resize(count);
+		velX.resize(count);
+		velY.resize(count);
+		layer.resize(count);
+		keys.resize(count);
+		order.resize(count);
+		steeredX.resize(count);
+		steeredY.resize(count);
+		unsortedKeys.resize(count);
+		
+		// sizes first, cells are big enough that most neighbors are in the 3 by 3 around an entity
+		for(std::size_t i = 0; i < count; i++)
+		{
+			const Physical* phys = entities[i]->get<Physical>();
+			const Movable* mov = entities[i]->get<Movable>();
+			const Pathfinder* pf = entities[i]->get<Pathfinder>();
+			
+			float r = pf && pf->avoidance > 0 ? pf->avoidance : std::max(phys->size.x, phys->size.y) / 2.f;
+			float s = mov->moveVelocity > 0 ? mov->moveVelocity : std::sqrt(mov->velocity.x * mov->velocity.x + mov->velocity.y * mov->velocity.y);
+			
+			maxRadius = std::max(maxRadius, r);
+			maxSpeed = std::max(maxSpeed, s);
+		}
+		
+		cellSize = std::max(maxRadius * 2 + maxSpeed * horizon, 16.f);
+		
+		for(std::size_t i = 0; i < count; i++)
+		{
+			const Physical* phys = entities[i]->get<Physical>();
+			float x = phys->position.x + phys->size.x / 2.f;
+			float y = phys->position.y + phys->size.y / 2.f;
+			
+			unsortedKeys[i] = key(static_cast<int>(std::floor(x / cellSize)), static_cast<int>(std::floor(y / cellSize)), phys->zIndex);
+			order[i] = static_cast<unsigned>(i);
+		}
+		
+		// entities of a cell are next to each other, so a neighbor search reads a few short runs of each array
+		std::sort(order.begin(), order.end(), [this](unsigned a, unsigned b)
+		{
+			return unsortedKeys[a] < unsortedKeys[b] || (unsortedKeys[a] == unsortedKeys[b] && a < b);
+		});
+		
+		cells.clear();
+		
+		for(std::size_t i = 0; i < count; i++)
+		{
+			const Entity* e = entities[order[i]];
+			const Physical* phys = e->get<Physical>();
+			const Movable* mov = e->get<Movable>();
+			const Pathfinder* pf = e->get<Pathfinder>();
+			
+			keys[i] = unsortedKeys[order[i]];
+			posX[i] = phys->position.x + phys->size.x / 2.f;
+			posY[i] = phys->position.y + phys->size.y / 2.f;
+			velX[i] = mov->velocity.x;
+			velY[i] = mov->velocity.y;
+			avoidance[i] = pf && pf->avoidance > 0 ? pf->avoidance : 0;
+			radius[i] = avoidance[i] > 0 ? avoidance[i] : std::max(phys->size.x, phys->size.y) / 2.f;
+			speed[i] = mov->moveVelocity > 0 ? mov->moveVelocity : std::sqrt(velX[i] * velX[i] + velY[i] * velY[i]);
+			layer[i] = phys->zIndex;
+			
+			if(i == 0 || keys[i] != keys[i - 1])
+				cells[keys[i]] = {static_cast<unsigned>(i), 0};
+			
+			cells[keys[i]].count++;
+		}
+		
+		// only reads what was gathered, and writes its own entity's result
+		SystemScheduler::parallelFor(count, [this](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t i = begin; i < end; i++)
+				steer(static_cast<unsigned>(i));
+		});
+		
+		SystemScheduler::parallelFor(count, [this, &entities](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t i = begin; i < end; i++)
+			{
+				if(avoidance[i] > 0)
+					entities[order[i]]->get<Movable>()->velocity = {steeredX[i], steeredY[i]};
+			}
+		});
+	}
+	
+	ComponentMask SteeringSystem::getSignature() const
+	{
+		return makeMask<Movable, Physical>();
+	}
+	
+	ComponentMask SteeringSystem::getReads() const
+	{
+		return makeMask<Movable, Physical, Pathfinder>();
+	}
+	
+	ComponentMask SteeringSystem::getWrites() const
+	{
+		return makeMask<Movable>();
+	}
+	
+	void SteeringSystem::setHorizon(float h)
+	{
+		horizon = std::max(h, 0.f);
+	}
+	
+	float SteeringSystem::getHorizon() const
+	{
+		return horizon;
+	}
+	
+	std::uint64_t SteeringSystem::key(int x, int y, unsigned layer)
+	{
+		// as SpatialGrid's, 24 bits per coordinate, 16 for the layer
+		std::uint64_t kx = static_cast<std::uint32_t>(x) & 0xffffff;
+		std::uint64_t ky = static_cast<std::uint32_t>(y) & 0xffffff;
+		std::uint64_t kl = layer & 0xffff;
+		
+		return (kl << 48) | (ky << 24) | kx;
+	}
+	
+	void SteeringSystem::steer(unsigned i)
+	{
+		const float vx = velX[i];
+		const float vy = velY[i];
+		
+		steeredX[i] = vx;
+		steeredY[i] = vy;
+		
+		if(avoidance[i] <= 0)
+			return;
+		
+		const float px = posX[i];
+		const float py = posY[i];
+		const float r = radius[i];
+		const float range = r + maxRadius + horizon * (speed[i] + maxSpeed);
+		
+		const int minX = static_cast<int>(std::floor((px - range) / cellSize));
+		const int maxX = static_cast<int>(std::floor((px + range) / cellSize));
+		const int minY = static_cast<int>(std::floor((py - range) / cellSize));
+		const int maxY = static_cast<int>(std::floor((py + range) / cellSize));
+		
+		float pushX = 0;
+		float pushY = 0;
+		
+		for(int y = minY; y <= maxY; y++)
+		{
+			for(int x = minX; x <= maxX; x++)
+			{
+				auto cell = cells.find(key(x, y, layer[i]));
+				
+				if(cell == cells.end())
+					continue;
+				
+				for(unsigned j = cell->second.begin; j < cell->second.begin + cell->second.count; j++)
+				{
+					if(j == i)
+						continue;
+					
+					const float dx = px - posX[j];
+					const float dy = py - posY[j];
+					const float minDist = r + radius[j];
+					const float dist2 = dx * dx + dy * dy;
+					
+					// both sides of a pair that steer each give way half of it, as reciprocal velocity obstacles do
+					const float share = avoidance[j] > 0 ? 0.5f : 1.f;
+					
+					// already too close, pushed straight apart by how far in they are
+					if(dist2 < minDist * minDist)
+					{
+						float dist = std::sqrt(dist2);
+						
+						if(dist > 0.0001f)
+						{
+							pushX += dx / dist * (minDist - dist) / minDist * share;
+							pushY += dy / dist * (minDist - dist) / minDist * share;
+						}
+						else
+						{
+							// on top of each other, split along x by which came first
+							pushX += (order[i] < order[j] ? 1.f : -1.f) * share;
+						}
+						
+						continue;
+					}
+					
+					if(horizon <= 0)
+						continue;
+					
+					// closest the two get at the velocities they have, and when. Sooner and closer pushes harder
+					const float rvx = vx - velX[j];
+					const float rvy = vy - velY[j];
+					const float rv2 = rvx * rvx + rvy * rvy;
+					
+					if(rv2 < 0.0001f)
+						continue;
+					
+					const float t = -(dx * rvx + dy * rvy) / rv2;
+					
+					if(t <= 0 || t >= horizon)
+						continue;
+					
+					const float fx = dx + rvx * t;
+					const float fy = dy + rvy * t;
+					const float future2 = fx * fx + fy * fy;
+					
+					if(future2 >= minDist * minDist)
+						continue;
+					
+					const float future = std::sqrt(future2);
+					const float weight = (1 - t / horizon) * (minDist - future) / minDist * share;
+					
+					if(future > 0.0001f)
+					{
+						pushX += fx / future * weight;
+						pushY += fy / future * weight;
+					}
+					else
+					{
+						// head on, sidestepped to the right of the approach
+						const float rv = std::sqrt(rv2);
+						pushX += -rvy / rv * weight;
+						pushY += rvx / rv * weight;
+					}
+				}
+			}
+		}
+		
+		float nx = vx + pushX * speed[i];
+		float ny = vy + pushY * speed[i];
+		
+		// never faster than it can move
+		const float length = std::sqrt(nx * nx + ny * ny);
+		
+		if(speed[i] > 0 && length > speed[i])
+		{
+			nx *= speed[i] / length;
+			ny *= speed[i] / length;
+		}
+		
+		steeredX[i] = nx;
+		steeredY[i] = ny;
+	}
+}
@@ -0,0 +1,76 @@
+#ifndef STEERINGSYSTEM_HPP
+#define STEERINGSYSTEM_HPP
+
+#include "../System.hpp"
+
+#include "../Entity.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace swift
+{
+	// keeps crowds from walking into each other, instead of leaving it to collisions. Entities with a Pathfinder
+	// whose avoidance is above 0 bend the velocity they were given away from moving entities on their layer
+	// that they're in, or about to be in, the personal space of. Runs after pathfinding, so velocities are changed
+	// before they're integrated. Neighbors are found in a hash of cells, rebuilt each update into arrays sorted by
+	// cell, which the steering of every entity reads at once over the thread pool
+	class SteeringSystem : public System
+	{
+		public:
+			SteeringSystem();
+			
+			virtual void update(std::vector<Entity*>& entities, float dt);
+			virtual ComponentMask getSignature() const;
+			virtual ComponentMask getReads() const;
+			virtual ComponentMask getWrites() const;
+			
+			// seconds ahead entities look for another that's about to get too close. 0 only pushes apart ones already too close
+			void setHorizon(float h);
+			float getHorizon() const;
+		
+		private:
+			// where each cell's entities start in the sorted arrays, and how many there are
+			struct Cell
+			{
+				unsigned begin;
+				unsigned count;
+			};
+			
+			static std::uint64_t key(int x, int y, unsigned layer);
+			
+			// the new velocity of sorted entity i, from its neighbors
+			void steer(unsigned i);
+			
+			float horizon;
+			float cellSize;
+			
+			// of everything gathered this update, for how far to look
+			float maxRadius;
+			float maxSpeed;
+			
+			// every moving entity, sorted by cell
+			std::vector<std::uint64_t> keys;
+			std::vector<unsigned> order;	// into entities
+			std::vector<float> posX;
+			std::vector<float> posY;
+			std::vector<float> velX;
+			std::vector<float> velY;
+			std::vector<float> radius;		// personal space
+			std::vector<float> avoidance;	// of entities that steer, 0 for ones that are only steered around
+			std::vector<float> speed;		// most they may move at
+			std::vector<unsigned> layer;
+			
+			// what steer gives back, written to the Movables once every entity is steered
+			std::vector<float> steeredX;
+			std::vector<float> steeredY;
+			
+			std::unordered_map<std::uint64_t, Cell> cells;
+			
+			// before sorting
+			std::vector<std::uint64_t> unsortedKeys;
+	};
+}
+
+#endif // STEERINGSYSTEM_HPP
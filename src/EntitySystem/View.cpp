@@ -0,0 +1,79 @@
+#include "View.hpp"
+
+#include <limits>
+
+namespace swift
+{
+	namespace
+	{
+		constexpr unsigned NO_SLOT = std::numeric_limits<unsigned>::max();
+	}
+
+	View::View(const ComponentMask& sig)
+	:	signature(sig)
+	{
+	}
+
+	const ComponentMask& View::getSignature() const
+	{
+		return signature;
+	}
+
+	std::vector<Entity*>& View::getEntities()
+	{
+		return entities;
+	}
+
+	const std::vector<Entity*>& View::getEntities() const
+	{
+		return entities;
+	}
+
+	bool View::matches(const ComponentMask& mask) const
+	{
+		return (mask & signature) == signature;
+	}
+
+	void View::refresh(unsigned id, Entity* entity, const ComponentMask& mask)
+	{
+		bool inView = id < slots.size() && slots[id] != NO_SLOT;
+
+		if(matches(mask) && entity != nullptr)
+		{
+			if(!inView)
+				insert(id, entity);
+		}
+		else if(inView)
+			erase(id);
+	}
+
+	void View::erase(unsigned id)
+	{
+		if(id >= slots.size() || slots[id] == NO_SLOT)
+			return;
+
+		unsigned slot = slots[id];
+		unsigned last = entities.size() - 1;
+
+		if(slot != last)
+		{
+			entities[slot] = entities[last];
+			owners[slot] = owners[last];
+			slots[owners[slot]] = slot;
+		}
+
+		entities.pop_back();
+		owners.pop_back();
+		slots[id] = NO_SLOT;
+	}
+
+	void View::insert(unsigned id, Entity* entity)
+	{
+		if(id >= slots.size())
+			slots.resize(id + 1, NO_SLOT);
+
+		slots[id] = entities.size();
+		entities.push_back(entity);
+		owners.push_back(id);
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef VIEW_HPP
+#define VIEW_HPP
+
+#include <vector>
+
+#include "ComponentTypes.hpp"
+
+namespace swift
+{
+	class Entity;
+
+	// list of entities having every component in a signature.
+	// kept up to date by the ComponentStorage that created it, so systems don't have to filter each tick
+	class View
+	{
+		public:
+			View(const ComponentMask& sig);
+
+			const ComponentMask& getSignature() const;
+
+			std::vector<Entity*>& getEntities();
+			const std::vector<Entity*>& getEntities() const;
+
+			bool matches(const ComponentMask& mask) const;
+
+			// adds or removes the entity with id depending on whether mask matches
+			void refresh(unsigned id, Entity* entity, const ComponentMask& mask);
+
+			void erase(unsigned id);
+
+		private:
+			void insert(unsigned id, Entity* entity);
+
+			ComponentMask signature;
+
+			std::vector<Entity*> entities;
+			std::vector<unsigned> owners;
+
+			// indexed by entity id, position in entities
+			std::vector<unsigned> slots;
+	};
+}
+
+#endif // VIEW_HPP
@@ -0,0 +1,182 @@
+#include "Batch.hpp"
+
+#include <cmath>
+
+namespace cstr
+{
+	Batch::Batch()
+	:	used(0)
+	{
+	}
+	
+	void Batch::clear()
+	{
+		for(std::size_t i = 0; i < used; i++)
+			layers[i].vertices.clear();
+		
+		used = 0;
+	}
+	
+	void Batch::add(const sf::Sprite& sprite)
+	{
+		if(!sprite.getTexture())
+			return;
+		
+		sf::FloatRect texRect = static_cast<sf::FloatRect>(sprite.getTextureRect());
+		addQuad(sprite.getTransform(), {0, 0, std::abs(texRect.width), std::abs(texRect.height)}, texRect, sprite.getColor(), sprite.getTexture());
+	}
+	
+	void Batch::add(const sf::RectangleShape& shape)
+	{
+		const sf::Transform& transform = shape.getTransform();
+		sf::Vector2f size = shape.getSize();
+		
+		sf::FloatRect texRect = static_cast<sf::FloatRect>(shape.getTextureRect());
+		addQuad(transform, {0, 0, size.x, size.y}, texRect, shape.getFillColor(), shape.getTexture());
+		
+		float thickness = shape.getOutlineThickness();
+		
+		if(thickness == 0)
+			return;
+		
+		// the band between the shape and the shape grown by thickness. Negative grows it inward
+		float t = std::abs(thickness);
+		sf::FloatRect outer = thickness > 0 ? sf::FloatRect(-t, -t, size.x + 2 * t, size.y + 2 * t) : sf::FloatRect(0, 0, size.x, size.y);
+		sf::FloatRect inner = thickness > 0 ? sf::FloatRect(0, 0, size.x, size.y) : sf::FloatRect(t, t, size.x - 2 * t, size.y - 2 * t);
+		
+		float outerRight = outer.left + outer.width;
+		float outerBottom = outer.top + outer.height;
+		float innerRight = inner.left + inner.width;
+		float innerBottom = inner.top + inner.height;
+		
+		sf::Color color = shape.getOutlineColor();
+		
+		addQuad(transform, {outer.left, outer.top, outer.width, inner.top - outer.top}, {}, color, nullptr);
+		addQuad(transform, {outer.left, innerBottom, outer.width, outerBottom - innerBottom}, {}, color, nullptr);
+		addQuad(transform, {outer.left, inner.top, inner.left - outer.left, inner.height}, {}, color, nullptr);
+		addQuad(transform, {innerRight, inner.top, outerRight - innerRight, inner.height}, {}, color, nullptr);
+	}
+	
+	void Batch::add(const sf::Text& text)
+	{
+		if(!text.getFont())
+			return;
+		
+		bool bold = (text.getStyle() & sf::Text::Bold) != 0;
+		addGlyphs(text.getTransform(), text.getString(), *text.getFont(), text.getCharacterSize(), bold, text.getColor());
+	}
+	
+	void Batch::addText(const sf::String& string, const sf::Font& font, unsigned size, sf::Vector2f position, sf::Color color)
+	{
+		sf::Transform transform;
+		transform.translate(position);
+		
+		addGlyphs(transform, string, font, size, false, color);
+	}
+	
+	void Batch::addQuad(const sf::Transform& transform, const sf::FloatRect& rect, const sf::FloatRect& texRect, sf::Color color, const sf::Texture* texture)
+	{
+		std::vector<sf::Vertex>& vertices = getVertices(texture);
+		
+		float right = rect.left + rect.width;
+		float bottom = rect.top + rect.height;
+		float texRight = texRect.left + texRect.width;
+		float texBottom = texRect.top + texRect.height;
+		
+		vertices.emplace_back(transform.transformPoint(rect.left, rect.top), color, sf::Vector2f(texRect.left, texRect.top));
+		vertices.emplace_back(transform.transformPoint(right, rect.top), color, sf::Vector2f(texRight, texRect.top));
+		vertices.emplace_back(transform.transformPoint(right, bottom), color, sf::Vector2f(texRight, texBottom));
+		vertices.emplace_back(transform.transformPoint(rect.left, bottom), color, sf::Vector2f(texRect.left, texBottom));
+	}
+	
+	void Batch::addGlyphs(const sf::Transform& transform, const sf::String& string, const sf::Font& font, unsigned size, bool bold, sf::Color color)
+	{
+		if(string.isEmpty())
+			return;
+		
+		const sf::Texture* texture = &font.getTexture(size);
+		
+		float space = font.getGlyph(L' ', size, bold).advance;
+		float lineSpacing = font.getLineSpacing(size);
+		
+		// as sf::Text lays it out, from the baseline of the first line
+		float x = 0;
+		float y = static_cast<float>(size);
+		sf::Uint32 previous = 0;
+		
+		for(std::size_t i = 0; i < string.getSize(); i++)
+		{
+			sf::Uint32 c = string[i];
+			
+			x += font.getKerning(previous, c, size);
+			previous = c;
+			
+			switch(c)
+			{
+				case ' ':
+					x += space;
+					continue;
+				case '\t':
+					x += space * 4;
+					continue;
+				case '\n':
+					y += lineSpacing;
+					x = 0;
+					continue;
+				case '\v':
+					y += lineSpacing * 4;
+					continue;
+				default:
+					break;
+			}
+			
+			const sf::Glyph& glyph = font.getGlyph(c, size, bold);
+			
+			addQuad(transform, {x + glyph.bounds.left, y + glyph.bounds.top, glyph.bounds.width, glyph.bounds.height},
+					static_cast<sf::FloatRect>(glyph.textureRect), color, texture);
+			
+			x += glyph.advance;
+		}
+	}
+	
+	std::size_t Batch::getDrawCalls() const
+	{
+		return used;
+	}
+	
+	std::size_t Batch::getVertexCount() const
+	{
+		std::size_t count = 0;
+		
+		for(std::size_t i = 0; i < used; i++)
+			count += layers[i].vertices.size();
+		
+		return count;
+	}
+	
+	std::vector<sf::Vertex>& Batch::getVertices(const sf::Texture* texture)
+	{
+		// a handful of textures, a search is quicker than a map
+		for(std::size_t i = 0; i < used; i++)
+		{
+			if(layers[i].texture == texture)
+				return layers[i].vertices;
+		}
+		
+		// in order of first use this fill, reusing a layer from the last one
+		if(used == layers.size())
+			layers.push_back({texture, {}});
+		
+		layers[used].texture = texture;
+		return layers[used++].vertices;
+	}
+	
+	void Batch::draw(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		for(std::size_t i = 0; i < used; i++)
+		{
+			states.texture = layers[i].texture;
+			target.draw(layers[i].vertices.data(), static_cast<unsigned>(layers[i].vertices.size()), sf::Quads, states);
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Transform.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/System/String.hpp>
+#include <SFML/Graphics/RectangleShape.hpp>
+
+namespace cstr
+{
+	// quads of sprites, shapes, and text, in one vertex array per texture, drawn with a call each.
+	// Text is made from its font's glyph page, the font keeps one per character size, so text of one font and size
+	// shares a texture, and their geometry is only made here, not kept by each sf::Text.
+	// Arrays are drawn in the order their texture was first added, so what goes on top is added after
+	class Batch : public sf::Drawable
+	{
+		public:
+			Batch();
+			
+			// keeps the memory, for the next fill
+			void clear();
+			
+			void add(const sf::Sprite& sprite);
+			void add(const sf::RectangleShape& shape);
+			void add(const sf::Text& text);
+			
+			// text without an sf::Text, for lots of it that changes often
+			void addText(const sf::String& string, const sf::Font& font, unsigned size, sf::Vector2f position, sf::Color color = sf::Color::White);
+			
+			// rect in the transform's local space, texRect in pixels. nullptr for an untextured quad
+			void addQuad(const sf::Transform& transform, const sf::FloatRect& rect, const sf::FloatRect& texRect, sf::Color color, const sf::Texture* texture);
+			
+			std::size_t getDrawCalls() const;
+			std::size_t getVertexCount() const;
+		
+		private:
+			struct Layer
+			{
+				const sf::Texture* texture;
+				std::vector<sf::Vertex> vertices;
+			};
+			
+			void addGlyphs(const sf::Transform& transform, const sf::String& string, const sf::Font& font, unsigned size, bool bold, sf::Color color);
+			
+			std::vector<sf::Vertex>& getVertices(const sf::Texture* texture);
+			
+			virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+			
+			// the first used are this fill's, the rest are kept from earlier fills for their memory
+			std::vector<Layer> layers;
+			std::size_t used;
+	};
+}
+
+#endif // BATCH_HPP
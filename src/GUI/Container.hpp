@@ -2,6 +2,7 @@
 #define CONTAINER_HPP
 
 #include "Widget.hpp"
+#include "EventRouter.hpp"
 
 #include <vector>
 
@@ -17,7 +18,8 @@ namespace cstr
 				:	Widget(r),
 					border(0),
 				    isVisible(true),
-				    scrollable(s)
+				    scrollable(s),
+				    arranged(true)
 			{
 			}
 			
@@ -25,7 +27,8 @@ namespace cstr
 				:	Widget({0, 0, size.x, size.y}),
 					border(0),
 					isVisible(true),
-					scrollable(s)
+					scrollable(s),
+					arranged(true)
 			{
 			}
 
@@ -42,7 +45,9 @@ namespace cstr
 				
 				widgets.push_back(w);
 				
-				reposition();
+				// arranged by the next layout, so adding many widgets arranges them once, not once each
+				arranged = false;
+				markChanged();
 				
 				return *w;
 			}
@@ -70,6 +75,7 @@ namespace cstr
 			void show(bool v)
 			{
 				isVisible = v;
+				markChanged();
 			}
 			
 			bool isScrollable() const
@@ -77,18 +83,80 @@ namespace cstr
 				return scrollable;
 			}
 			
+			// arranges the widgets if some were added since they last were, then the containers among them.
+			// A Window lays its containers out before it draws or routes events to them
+			void layout()
+			{
+				if(!arranged)
+				{
+					reposition();
+					arranged = true;
+					cull();
+				}
+				
+				for(auto& w : widgets)
+				{
+					if(w->isContainer())
+						static_cast<Container*>(w)->layout();
+				}
+			}
+			
+			bool isChanged() const
+			{
+				if(Widget::isChanged())
+					return true;
+				
+				for(auto& w : widgets)
+				{
+					if(w->isChanged())
+						return true;
+				}
+				
+				return false;
+			}
+			
+			void clearChanged()
+			{
+				Widget::clearChanged();
+				
+				for(auto& w : widgets)
+					w->clearChanged();
+			}
+			
+			void batch(Batch& b) const
+			{
+				if(isVisible)
+				{
+					for(auto& w : shown)
+						w->batch(b);
+				}
+			}
+			
 			virtual void update(sf::Event& event) = 0;
 		
 		protected:
+			// to the widget the event is for
 			void updateWidgets(sf::Event& event)
 			{
 				if(isVisible)
+					router.route(event, shown);
+			}
+			
+			// finds the widgets shown again. Scrollable, only those reaching the container are batched, drawn,
+			// and sent events, so a long list costs what its visible part does
+			void cull()
+			{
+				shown.clear();
+				
+				sf::FloatRect bounds = getGlobalBounds();
+				
+				for(auto& w : widgets)
 				{
-					for(auto& w : widgets)
-					{
-						w->update(event);
-					}
+					if(!scrollable || w->getGlobalBounds().intersects(bounds))
+						shown.push_back(w);
 				}
+				
+				markChanged();
 			}
 			
 			const std::vector<Widget*>& getWidgets() const
@@ -101,7 +169,7 @@ namespace cstr
 			{
 				if(isVisible)
 				{
-					for(auto& w : widgets)
+					for(auto& w : shown)
 					{
 						target.draw(*w, states);
 					}
@@ -112,10 +180,13 @@ namespace cstr
 			virtual void scroll(float amount) = 0;
 
 			std::vector<Widget*> widgets;
+			std::vector<Widget*> shown;
+			EventRouter router;
 
 			int border;
 			bool isVisible;
 			bool scrollable;
+			bool arranged;
 	};
 }
 
@@ -110,6 +110,8 @@ namespace cstr
 			{
 				for(auto& w : getWidgets())
 					w->setPosition({static_cast<int>(w->getGlobalBounds().left), static_cast<int>(w->getGlobalBounds().top - amount * 10)});
+				
+				cull();
 			}
 		}
 	}
@@ -110,5 +110,7 @@ namespace cstr
 		{
 			w->setPosition({static_cast<int>(w->getGlobalBounds().left + amount * 10), static_cast<int>(w->getGlobalBounds().top)});
 		}
+		
+		cull();
 	}
 }
@@ -0,0 +1,113 @@
+#ifndef EVENTROUTER_HPP
+#define EVENTROUTER_HPP
+
+#include "Widget.hpp"
+
+#include <vector>
+
+#include <SFML/Window/Event.hpp>
+
+namespace cstr
+{
+	// sends events to the widget they're for, found by where the mouse is, instead of to every widget.
+	// A widget pressed on gets the mouse until it's released, so drags work. A widget the mouse
+	// leaves gets that move, to see it's gone. Keys and text go to the one under the mouse
+	class EventRouter
+	{
+		public:
+			EventRouter()
+				:	hovered(nullptr),
+					captured(nullptr)
+			{
+			}
+			
+			template<typename W>
+			void route(sf::Event& event, const std::vector<W*>& widgets)
+			{
+				switch(event.type)
+				{
+					case sf::Event::MouseMoved:
+					{
+						Widget* under = hit(widgets, event.mouseMove.x, event.mouseMove.y);
+						
+						if(hovered && hovered != under)
+							hovered->update(event);
+						
+						if(captured && captured != under && captured != hovered)
+							captured->update(event);
+						
+						hovered = under;
+						
+						if(under)
+							under->update(event);
+						
+						break;
+					}
+					case sf::Event::MouseButtonPressed:
+						hovered = hit(widgets, event.mouseButton.x, event.mouseButton.y);
+						captured = hovered;
+						
+						if(captured)
+							captured->update(event);
+						
+						break;
+					case sf::Event::MouseButtonReleased:
+					{
+						Widget* target = captured ? captured : hit(widgets, event.mouseButton.x, event.mouseButton.y);
+						captured = nullptr;
+						
+						if(target)
+							target->update(event);
+						
+						break;
+					}
+					case sf::Event::MouseWheelMoved:
+					{
+						Widget* under = hit(widgets, event.mouseWheel.x, event.mouseWheel.y);
+						
+						if(under)
+							under->update(event);
+						
+						break;
+					}
+					case sf::Event::MouseLeft:
+						if(hovered)
+							hovered->update(event);
+						
+						hovered = nullptr;
+						break;
+					default:
+						if(hovered)
+							hovered->update(event);
+						
+						break;
+				}
+			}
+			
+			// before the widgets are deleted
+			void reset()
+			{
+				hovered = nullptr;
+				captured = nullptr;
+			}
+		
+		private:
+			// the last drawn is on top
+			template<typename W>
+			static Widget* hit(const std::vector<W*>& widgets, int x, int y)
+			{
+				for(auto it = widgets.rbegin(); it != widgets.rend(); ++it)
+				{
+					if((*it)->getGlobalBounds().contains(static_cast<float>(x), static_cast<float>(y)))
+						return *it;
+				}
+				
+				return nullptr;
+			}
+			
+			Widget* hovered;
+			Widget* captured;
+	};
+}
+
+#endif // EVENTROUTER_HPP
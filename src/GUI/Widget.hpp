@@ -6,6 +6,10 @@
 #include <SFML/Graphics/RenderStates.hpp>
 #include <SFML/Window/Event.hpp>
 
+#include <cstddef>
+
+#include "Batch.hpp"
+
 namespace cstr
 {
 	class Widget : public sf::Drawable
@@ -17,24 +21,42 @@ namespace cstr
 			    Center,
 			    Right
 			};
+			
+			// what widgets drew since it was last reset, for performance stats
+			struct DrawCount
+			{
+				std::size_t calls;
+				std::size_t vertices;
+			};
+			
+			static DrawCount& getDrawCount()
+			{
+				static DrawCount count = {0, 0};
+				return count;
+			}
 
 			Widget()
 				:	mouseOn(false),
 					rect(0, 0, 0, 0),
-					alignment(Alignment::Center)
+					alignment(Alignment::Center),
+					changed(true)
 			{
 			}
 			
 			Widget(sf::IntRect r)
 				:	mouseOn(false),
 					rect(r),
-					alignment(Alignment::Center)
+					alignment(Alignment::Center),
+					changed(true)
 			{
 			}
 			
 			virtual ~Widget() {}
 
 			virtual void update(sf::Event& event) = 0;
+			
+			// adds what draw would draw, so a Window draws every widget in a call per texture
+			virtual void batch(Batch& b) const = 0;
 
 			virtual sf::FloatRect getGlobalBounds() const
 			{
@@ -60,15 +82,40 @@ namespace cstr
 			{
 				rect.left = pos.x;
 				rect.top = pos.y;
+				markChanged();
 			}
 			
 			virtual void setSize(sf::Vector2u size)
 			{
 				rect.width = size.x;
 				rect.height = size.y;
+				markChanged();
+			}
+			
+			// if it looks different since it was last cleared, a retained Window draws again then
+			virtual bool isChanged() const
+			{
+				return changed;
+			}
+			
+			virtual void clearChanged()
+			{
+				changed = false;
 			}
 
 		protected:
+			// sprites and shapes are about a quad, text a quad per character
+			static void countDraw(std::size_t vertices)
+			{
+				getDrawCount().calls++;
+				getDrawCount().vertices += vertices;
+			}
+			
+			void markChanged()
+			{
+				changed = true;
+			}
+			
 			bool mouseOn;
 			sf::IntRect rect;
 			
@@ -76,6 +123,8 @@ namespace cstr
 			virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const = 0;
 
 			Alignment alignment;
+			
+			bool changed;
 	};
 }
 
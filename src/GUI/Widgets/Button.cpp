@@ -25,28 +25,39 @@ namespace cstr
 		switch(event.type)
 		{
 			case sf::Event::MouseMoved:
-				if(sprite.getGlobalBounds().contains({static_cast<float>(event.mouseMove.x), static_cast<float>(event.mouseMove.y)}))
+			{
+				bool on = sprite.getGlobalBounds().contains({static_cast<float>(event.mouseMove.x), static_cast<float>(event.mouseMove.y)});
+				
+				// only a change of hover is a change to draw
+				if(on != mouseOn)
 				{
-					mouseOn = true;
-					sprite.setColor(baseColor + COLOR_CHANGE);
+					mouseOn = on;
+					sprite.setColor(on ? baseColor + COLOR_CHANGE : baseColor);
+					markChanged();
 				}
-				else
+				break;
+			}
+			case sf::Event::MouseLeft:
+				if(mouseOn)
 				{
 					mouseOn = false;
 					sprite.setColor(baseColor);
+					markChanged();
 				}
 				break;
 			case sf::Event::MouseButtonPressed:
 				if(mouseOn)
 				{
 					sprite.setColor(baseColor - COLOR_CHANGE);
+					markChanged();
 				}
 				break;
 			case sf::Event::MouseButtonReleased:
 				if(mouseOn)
 				{
-					callback();
 					sprite.setColor(baseColor);
+					markChanged();
+					callback();
 				}
 				break;
 			default:
@@ -84,6 +95,7 @@ namespace cstr
 		
 		text.setOrigin({text.getLocalBounds().left + text.getLocalBounds().width / 2, text.getLocalBounds().top + text.getLocalBounds().height / 2});
 		text.setPosition({sprite.getGlobalBounds().left + sprite.getGlobalBounds().width / 2, sprite.getGlobalBounds().top + sprite.getGlobalBounds().height / 2});
+		markChanged();
 	}
 	
 	void Button::setString(const std::string& str, unsigned ts)
@@ -100,6 +112,7 @@ namespace cstr
 	{
 		sprite.setPosition(static_cast<sf::Vector2f>(pos));
 		text.setPosition({sprite.getGlobalBounds().left + sprite.getGlobalBounds().width / 2, sprite.getGlobalBounds().top + sprite.getGlobalBounds().height / 2});
+		markChanged();
 	}
 	
 	void Button::setSize(sf::Vector2u size)
@@ -108,6 +121,8 @@ namespace cstr
 		
 		if(string != "")
 			setString(string, *text.getFont(), textSize);
+		
+		markChanged();
 	}
 	
 	void Button::setTextureRect(const sf::IntRect& rect, const sf::Vector2f& size)
@@ -115,12 +130,26 @@ namespace cstr
 		sprite.setTextureRect(rect);
 		sprite.setScale({1, 1});
 		sprite.setScale(size.x / sprite.getGlobalBounds().width, size.y / sprite.getGlobalBounds().height);
+		markChanged();
 	}
 
 	void Button::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
 		target.draw(sprite, states);
+		countDraw(4);
+		
 		if(string.length() > 0)
+		{
 			target.draw(text, states);
+			countDraw(string.length() * 4);
+		}
+	}
+	
+	void Button::batch(Batch& b) const
+	{
+		b.add(sprite);
+		
+		if(string.length() > 0)
+			b.add(text);
 	}
 }
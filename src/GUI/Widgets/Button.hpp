@@ -21,6 +21,8 @@ namespace cstr
 			
 			virtual void update(sf::Event& event);
 			
+			virtual void batch(Batch& b) const;
+			
 			void call();
 
 			virtual sf::FloatRect getGlobalBounds() const;
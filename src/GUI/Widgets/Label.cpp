@@ -41,6 +41,7 @@ namespace cstr
 			textSize = 0;
 		}
 		
+		markChanged();
 	}
 	
 	const std::string& Label::getString() const
@@ -51,6 +52,7 @@ namespace cstr
 	void Label::setPosition(sf::Vector2i pos)
 	{
 		text.setPosition(static_cast<sf::Vector2f>(pos));
+		markChanged();
 	}
 	
 	void Label::setSize(sf::Vector2u size)
@@ -61,10 +63,17 @@ namespace cstr
 		else
 			text.setCharacterSize(textSize);
 		text.setOrigin({text.getLocalBounds().left, text.getLocalBounds().top});
+		markChanged();
 	}
 	
 	void Label::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
 		target.draw(text, states);
+		countDraw(text.getString().getSize() * 4);
+	}
+	
+	void Label::batch(Batch& b) const
+	{
+		b.add(text);
 	}
 }
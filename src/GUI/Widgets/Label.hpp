@@ -15,6 +15,8 @@ namespace cstr
 			~Label();
 			
 			virtual void update(sf::Event& event);
+			
+			virtual void batch(Batch& b) const;
 
 			virtual sf::FloatRect getGlobalBounds() const;
 			
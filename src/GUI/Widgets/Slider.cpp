@@ -32,6 +32,7 @@ namespace cstr
 						slider.setPosition(track.getGlobalBounds().left + track.getGlobalBounds().width - slider.getGlobalBounds().width / 2, slider.getGlobalBounds().top);
 						
 					value = (slider.getGlobalBounds().left + slider.getGlobalBounds().width / 2 - track.getGlobalBounds().left) / track.getGlobalBounds().width;
+					markChanged();
 				}
 				break;
 			case sf::Event::MouseButtonPressed:
@@ -56,12 +57,14 @@ namespace cstr
 	{
 		slider.setPosition(pos.x + slider.getPosition().x - track.getPosition().x, pos.y);
 		track.setPosition(pos.x, pos.y + slider.getSize().y / 3);
+		markChanged();
 	}
 	
 	void Slider::setSize(sf::Vector2u size)
 	{
 		track.setSize({static_cast<float>(size.x), static_cast<float>(size.y) / 3});
 		slider.setSize({static_cast<float>(size.x / 20), static_cast<float>(size.y)});
+		markChanged();
 	}
 	
 	void Slider::setValue(float v)
@@ -70,6 +73,7 @@ namespace cstr
 		{
 			value = v;
 			slider.setPosition(track.getPosition().x + track.getGlobalBounds().width * value, slider.getPosition().y);
+			markChanged();
 		}
 	}
 	
@@ -81,16 +85,26 @@ namespace cstr
 	void Slider::setSliderColor(sf::Color c)
 	{
 		slider.setFillColor(c);
+		markChanged();
 	}
 	
 	void Slider::setTrackColor(sf::Color c)
 	{
 		track.setFillColor(c);
+		markChanged();
 	}
 	
 	void Slider::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
 		target.draw(track, states);
 		target.draw(slider, states);
+		countDraw(4);
+		countDraw(4);
+	}
+	
+	void Slider::batch(Batch& b) const
+	{
+		b.add(track);
+		b.add(slider);
 	}
 }
@@ -14,6 +14,8 @@ namespace cstr
 			~Slider();
 
 			virtual void update(sf::Event& event);
+			
+			virtual void batch(Batch& b) const;
 
 			virtual sf::FloatRect getGlobalBounds() const;
 
@@ -30,4 +30,9 @@ namespace cstr
 		target.draw(fill, states);*/
 		// do nothing
 	}
+	
+	void Spacer::batch(Batch& /*b*/) const
+	{
+		// nothing to draw
+	}
 }
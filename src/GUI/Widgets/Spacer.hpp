@@ -13,6 +13,8 @@ namespace cstr
 
 			virtual void update(sf::Event& event);
 			
+			virtual void batch(Batch& b) const;
+			
 			virtual sf::FloatRect getGlobalBounds() const;
 
 		private:
@@ -60,6 +60,7 @@ namespace cstr
 					text.setString(currentStr.substr(0, cursorPosition) + '|' + currentStr.substr(cursorPosition));
 
 					setDisplayedString();
+					markChanged();
 				}
 				break;
 			case sf::Event::KeyPressed:
@@ -91,6 +92,7 @@ namespace cstr
 					text.setString(currentStr.substr(0, cursorPosition) + '|' + currentStr.substr(cursorPosition));
 
 					setDisplayedString();
+					markChanged();
 				}
 				break;
 			case sf::Event::MouseMoved:
@@ -112,6 +114,7 @@ namespace cstr
 	{
 		border.setPosition(static_cast<sf::Vector2f>(pos));
 		text.setPosition(pos.x + BORDER_SIZE, pos.y + BORDER_SIZE);
+		markChanged();
 	}
 
 	void TextBox::setSize(sf::Vector2u size)
@@ -120,6 +123,7 @@ namespace cstr
 		text.setCharacterSize(size.y - 2 * BORDER_SIZE);
 		text.setOrigin( {text.getLocalBounds().left, text.getLocalBounds().top});
 		text.setPosition(border.getGlobalBounds().left + BORDER_SIZE, border.getGlobalBounds().top + BORDER_SIZE);
+		markChanged();
 	}
 
 	const std::string& TextBox::getString() const
@@ -132,27 +136,39 @@ namespace cstr
 		currentStr.clear();
 		text.setString("");
 		setDisplayedString();
+		markChanged();
 	}
 
 	void TextBox::setTextColor(const sf::Color& tc)
 	{
 		text.setColor(tc);
+		markChanged();
 	}
 
 	void TextBox::setOutlineColor(const sf::Color& oc)
 	{
 		border.setOutlineColor(oc);
+		markChanged();
 	}
 
 	void TextBox::setBackgroundColor(const sf::Color& bc)
 	{
 		border.setFillColor(bc);
+		markChanged();
 	}
 
 	void TextBox::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
 		target.draw(border, states);
 		target.draw(text, states);
+		countDraw(4);
+		countDraw(text.getString().getSize() * 4);
+	}
+	
+	void TextBox::batch(Batch& b) const
+	{
+		b.add(border);
+		b.add(text);
 	}
 
 	void TextBox::setDisplayedString()
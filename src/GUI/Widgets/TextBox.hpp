@@ -17,6 +17,8 @@ namespace cstr
 
 			virtual void update(sf::Event& event);
 			
+			virtual void batch(Batch& b) const;
+			
 			virtual sf::FloatRect getGlobalBounds() const;
 
 			virtual void setPosition(sf::Vector2i pos);
@@ -31,20 +31,32 @@ namespace cstr
 		switch(event.type)
 		{
 			case sf::Event::MouseMoved:
-				if(sprite.getGlobalBounds().contains({static_cast<float>(event.mouseMove.x), static_cast<float>(event.mouseMove.y)}))
+			{
+				bool on = sprite.getGlobalBounds().contains({static_cast<float>(event.mouseMove.x), static_cast<float>(event.mouseMove.y)});
+				
+				// only a change of hover is a change to draw
+				if(on != mouseOn)
 				{
-					mouseOn = true;
-					sprite.setColor(baseColor + COLOR_CHANGE);
+					mouseOn = on;
+					sprite.setColor(on ? baseColor + COLOR_CHANGE : baseColor);
+					markChanged();
 				}
-				else
+				break;
+			}
+			case sf::Event::MouseLeft:
+				if(mouseOn)
 				{
 					mouseOn = false;
 					sprite.setColor(baseColor);
+					markChanged();
 				}
 				break;
 			case sf::Event::MouseButtonPressed:
 				if(mouseOn)
+				{
 					sprite.setColor(baseColor - COLOR_CHANGE);
+					markChanged();
+				}
 				break;
 			case sf::Event::MouseButtonReleased:
 				if(mouseOn)
@@ -52,6 +64,7 @@ namespace cstr
 					state = !state;
 					sprite.setTextureRect(state ? onRect : offRect);
 					sprite.setColor(baseColor);
+					markChanged();
 					callback(state);
 				}
 				break;
@@ -68,15 +81,23 @@ namespace cstr
 	void Toggle::setPosition(sf::Vector2i pos)
 	{
 		sprite.setPosition(static_cast<sf::Vector2f>(pos));
+		markChanged();
 	}
 	
 	void Toggle::setSize(sf::Vector2u size)
 	{
 		sprite.scale({size.x / sprite.getGlobalBounds().width, size.y / sprite.getGlobalBounds().height});
+		markChanged();
 	}
 	
 	void Toggle::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
 		target.draw(sprite, states);
+		countDraw(4);
+	}
+	
+	void Toggle::batch(Batch& b) const
+	{
+		b.add(sprite);
 	}
 }
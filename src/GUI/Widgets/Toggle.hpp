@@ -20,6 +20,8 @@ namespace cstr
 			bool getState() const;
 
 			virtual void update(sf::Event& event);
+			
+			virtual void batch(Batch& b) const;
 
 			virtual sf::FloatRect getGlobalBounds() const;
 
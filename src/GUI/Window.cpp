@@ -1,10 +1,17 @@
 #include "Window.hpp"
 
+#include <SFML/Graphics/Sprite.hpp>
+
+#include "../Memory/MemoryTracker.hpp"
+
 namespace cstr
 {
 	Window::Window()
 		:	font(nullptr),
-			textSize(0)
+			textSize(0),
+			retained(false),
+			cacheValid(false),
+			batchValid(false)
 	{
 	}
 
@@ -16,10 +23,13 @@ namespace cstr
 	
 	void Window::update(sf::Event& event)
 	{
+		SWIFT_MEMORY_SCOPE(Gui);
+		
+		// widgets added since the last frame have to be where they'll be drawn to get events
 		for(auto& c : containers)
-		{
-			c->update(event);
-		}
+			c->layout();
+		
+		router.route(event, containers);
 	}
 	
 	void Window::setTextSize(unsigned s)
@@ -34,6 +44,9 @@ namespace cstr
 	
 	void Window::clear()
 	{
+		router.reset();
+		batchValid = false;
+		
 		for(unsigned i = 0; i < containers.size(); i++)
 		{
 			delete containers[i];
@@ -42,11 +55,95 @@ namespace cstr
 		containers.clear();
 	}
 	
+	void Window::setRetained(bool r)
+	{
+		retained = r;
+		cacheValid = false;
+	}
+	
+	bool Window::isRetained() const
+	{
+		return retained;
+	}
+	
 	void Window::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
+		bool changed = !batchValid;
+		
+		// once a frame at most, however many widgets were added
 		for(auto& c : containers)
 		{
-			target.draw(*c, states);
+			c->layout();
+			changed = changed || c->isChanged();
+		}
+		
+		// the widgets' geometry, only made again when they change
+		if(changed)
+		{
+			batch.clear();
+			
+			for(auto& c : containers)
+			{
+				c->batch(batch);
+				c->clearChanged();
+			}
+			
+			batchValid = true;
+			cacheValid = false;
+		}
+		
+		if(!retained)
+		{
+			target.draw(batch, states);
+			countDraw(batch.getDrawCalls(), batch.getVertexCount());
+			return;
 		}
+		
+		render(target, states);
+		
+		// the cache is the target's size, drawn over it one to one
+		sf::View view = target.getView();
+		target.setView(target.getDefaultView());
+		target.draw(sf::Sprite(cache.getTexture()));
+		target.setView(view);
+		
+		countDraw(1, 4);
+	}
+	
+	void Window::render(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		SWIFT_MEMORY_SCOPE(Gui);
+		
+		const sf::View& view = target.getView();
+		
+		if(cache.getSize() != target.getSize())
+		{
+			cache.create(target.getSize().x, target.getSize().y);
+			cacheValid = false;
+		}
+		
+		if(view.getCenter() != cacheCenter || view.getSize() != cacheSize)
+		{
+			cacheCenter = view.getCenter();
+			cacheSize = view.getSize();
+			cacheValid = false;
+		}
+		
+		if(cacheValid)
+			return;
+		
+		cache.setView(view);
+		cache.clear(sf::Color::Transparent);
+		cache.draw(batch, states);
+		cache.display();
+		
+		countDraw(batch.getDrawCalls(), batch.getVertexCount());
+		cacheValid = true;
+	}
+	
+	void Window::countDraw(std::size_t calls, std::size_t vertices)
+	{
+		Widget::getDrawCount().calls += calls;
+		Widget::getDrawCount().vertices += vertices;
 	}
 }
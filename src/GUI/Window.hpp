@@ -11,9 +11,13 @@
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/View.hpp>
 
 #include "Widget.hpp"
 #include "Container.hpp"
+#include "EventRouter.hpp"
+#include "Batch.hpp"
 
 namespace cstr
 {
@@ -33,15 +37,37 @@ namespace cstr
 			void setFont(sf::Font& font);
 			
 			void clear();
+			
+			// the widgets are drawn from one batch, made again when one of them changes. Retained, the batch is drawn
+			// to a texture, and the window is the texture until the batch changes. Otherwise the batch is drawn every frame
+			void setRetained(bool r);
+			bool isRetained() const;
 
 		private:
 			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 			
+			// draws the batch to cache, if it's changed
+			void render(sf::RenderTarget& target, sf::RenderStates states) const;
+			
+			// for the frame stats, as widgets count their own draws
+			static void countDraw(std::size_t calls, std::size_t vertices);
+			
 			std::vector<Container*> containers;
+			EventRouter router;
 			
 			sf::Font* font;
 			
 			unsigned textSize;
+			
+			bool retained;
+			mutable sf::RenderTexture cache;
+			mutable bool cacheValid;
+			mutable sf::Vector2f cacheCenter;	// of the view the cache was drawn in
+			mutable sf::Vector2f cacheSize;
+			
+			// every widget's quads, made again when one changes
+			mutable Batch batch;
+			mutable bool batchValid;
 	};
 	
 	template<typename C>
@@ -50,6 +76,7 @@ namespace cstr
 		static_assert(std::is_base_of<Container, C>::value, "C must be a child of cstr::Container");
 		
 		containers.push_back(c);
+		batchValid = false;
 		
 		return *c;
 	}
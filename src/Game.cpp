@@ -1,34 +1,75 @@
 #include "Game.hpp"
 
 #include "SystemInfo/SystemInfo.hpp"
+#include "SystemInfo/CpuInfo.hpp"
+
+#include "EntitySystem/SystemScheduler.hpp"
+#include "EntitySystem/SimulationLod.hpp"
+
+#include "Pathfinding/PathBenchmark.hpp"
+#include "World/WorldBenchmark.hpp"
+#include "Mapping/TileMap.hpp"
+#include "Noise/OpenSimplexNoise.hpp"
+
+#include "Profiling/Profiler.hpp"
+#include "Memory/MemoryTracker.hpp"
+#include "Memory/FrameArena.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <random>
 
 namespace swift
 {
 	Game::Game(const std::string& t, unsigned tps)
 	:	running(false),
+		musicPlayer(assets),
+		audio(soundPlayer, musicPlayer),
 		console(500, 200, defaultFont, "$:"),
 		graphics(Quality::Medium),
 		smoothing(false),
 		fullscreen(false),
 		verticalSync(true),
+		threadedRendering(false),
+		hotReload(false),
 		resolution({800, 600}),
 		soundLevel(100),
 		musicLevel(75),
+		threadPool(getCpuInfo().cores - 1),
 		title(t),
 		currentState(nullptr),
+		loading(nullptr),
+		pacer(GameTime),
 		ticksPerSecond(tps),
+		maxCatchUp(5),
+		scriptGcTime(sf::microseconds(1000)),
 		editor(false),
-		debug(false)
+		debug(false),
+		headless(false),
+		unthrottled(false),
+		headlessTicks(0)
 	{
 		addKeyboardCommands();
 		addConsoleCommands();
 		
+		State::setInput(input);
+		SystemScheduler::setThreadPool(threadPool);
+		TileMap::setThreadPool(threadPool);
+		OpenSimplexNoise::setThreadPool(threadPool);
+		AssetManager::setThreadPool(threadPool);
+		TileMap::setAsyncWriter(saveWriter);
+		World::setAsyncWriter(saveWriter);
+		
 		// get System Info
+		SWIFT_STARTUP("System info");
 		log	<< "OS:\t\t" << getOSName() << '\n'
 			<< "Version:\t" << getOSVersion() << '\n'
 			<< "Arch:\t\t" << getOSArch() << '\n'
 			<< "Total Mem:\t" << getTotalMem() << '\n'
 			<< "CPU:\t\t" << getCPUModel() << '\n'
+			<< "CPU Features:\t" << getCpuFeatures() << '\n'
 			<< "Video Vendor:\t" << getVideoVendor() << '\n'
 			<< "Video Card:\t" << getVideoCard() << '\n'
 			<< "Video Driver:\t" << getVideoDriver() << "\n\n";
@@ -38,85 +79,447 @@ namespace swift
 	{
 		if(currentState)
 			delete currentState;
+		
+		// saves of the worlds just deleted
+		saveWriter.wait();
+		saveWriter.poll();
 	}
 
 	// Finish cleaning up memory, close cleanly, etc
 	void Game::finish()
 	{
-		window.close();
+		gpuTimer.release();
+		
+		if(recorder.getMode() == InputRecorder::Mode::Recording && recorder.save(recordFile))
+			log << "Recorded " << recorder.getTickCount() << " ticks to \"" << recordFile << "\".\n";
+		
+		if(recorder.getMode() == InputRecorder::Mode::Replaying)
+			log << "Replay of \"" << replayFile << "\": " << recorder.getReport() << ".\n";
+		
+		if(window)
+			window->close();
 	}
 
 	void Game::update(sf::Time dt)
 	{
+		SWIFT_PROFILE("Game::update");
+		
+		// finished saves report back
+		saveWriter.poll();
+		
+		// prefetched assets done decoding
+		assets.update();
+		
+		settings.getEvents().dispatch();
+		
+		sf::Time started = GameTime.getElapsedTime();
+		
+		// everything first, so redundant mouse moves are merged before anything handles them
+		input.begin();
+		
 		sf::Event event;
-		while(window.pollEvent(event) && running)
+		while(window && window->pollEvent(event) && running)
 		{
-			keyboard(event);
-			mouse(event);
-
-			// avoid having the console type the key that toggles it
-			if(event.type == sf::Event::TextEntered && event.text.unicode != '\\')
-				console.update(event);
-
-			if(event.type == sf::Event::Closed)
-				running = false;
+			// replays only take input from the recording, the window can still be closed
+			if(recorder.getMode() == InputRecorder::Mode::Replaying)
+			{
+				if(event.type == sf::Event::Closed)
+					running = false;
+				
+				continue;
+			}
+			
+			input.add(event);
+		}
+		
+		while(running && recorder.poll(event))
+			input.add(event);
+		
+		// recorded as they're handled, so replays are given the same merged events
+		for(auto& e : input.getEvents())
+		{
+			if(!running)
+				break;
 			
-			if(running)
-				currentState->handleEvent(event);
+			event = e;
+			recorder.add(event);
+			handleEvent(event);
 		}
 		
 		if(running)
 			currentState->update(dt);
+		
+		recorder.endTick(GameTime.getElapsedTime() - started);
+		
+		// nothing from this tick's arena is used after it
+		FrameArena::get().reset();
+	}
+	
+	void Game::handleEvent(sf::Event& event)
+	{
+		keyboard(event);
+		mouse(event);
+
+		// avoid having the console type the key that toggles it
+		if(event.type == sf::Event::TextEntered && event.text.unicode != '\\')
+			console.update(event);
+
+		if(event.type == sf::Event::Closed)
+			running = false;
+		
+		if(running)
+			currentState->handleEvent(event);
 	}
 
 	void Game::draw(float e)
 	{
+		SWIFT_PROFILE("Game::draw");
+		
 		if(running)
 		{
+			if(debug)
+				gpuTimer.begin();
+			
 			/* clear display */
-			window.clear();
+			window->clear();
 
 			/* state drawing */
 			currentState->draw(e);
 			
+			// widgets count what they draw themselves
+			cstr::Widget::DrawCount& gui = cstr::Widget::getDrawCount();
+			FrameStats::countDraw(FrameStats::Draws::GUI, gui.vertices, gui.calls);
+			gui = {0, 0};
+			
 			/* other drawing */
-			window.draw(console);
+			window->draw(console);
 			
 			if(debug)
-				window.draw(FPS);
-
-			/* display drawing */
-			window.display();
+			{
+				gpuTimer.end();
+				
+				FrameStats::endFrame();
+				updateStats();
+				
+				overlay.clear();
+				overlay.add(FPS);
+				overlay.add(stats);
+				window->draw(overlay);
+			}
+			else
+				FrameStats::endFrame();
+		}
+		
+		// of the thread drawing, which is the tick's when there's no render thread
+		FrameArena::get().reset();
+	}
+	
+	void Game::updateStats()
+	{
+		auto milliseconds = [](sf::Time t)
+		{
+			return std::to_string(t.asMicroseconds() / 1000.f).substr(0, 5) + " ms";
+		};
+		
+		std::string text = "Ticks: " + std::to_string(FrameStats::getTicks()) + '\n';
+		text += "Dropped ticks: " + std::to_string(FrameStats::getDroppedTicks()) + ", " + std::to_string(FrameStats::getTotalDroppedTicks()) + " total\n";
+		
+		for(unsigned i = 0; i < static_cast<unsigned>(FrameStats::Draws::Count); i++)
+		{
+			FrameStats::Draws who = static_cast<FrameStats::Draws>(i);
+			const FrameStats::DrawCount& count = FrameStats::getDraws(who);
+			
+			text += std::string(FrameStats::getName(who)) + ": " + std::to_string(count.calls) + " calls, " + std::to_string(count.vertices) + " vertices\n";
+		}
+		
+		if(GpuTimer::isAvailable())
+			FrameStats::setGpuTime(gpuTimer.getTime());
+		
+		text += "GPU: " + (GpuTimer::isAvailable() ? milliseconds(FrameStats::getGpuTime()) : std::string("no timer queries")) + '\n';
+		
+		// last tick's
+		for(auto& s : FrameStats::getSystemTimes())
+			text += s.name + ": " + milliseconds(s.time) + '\n';
+		
+		stats.setString(text);
+	}
+	
+	void Game::reportHitch(std::ostream& out) const
+	{
+		// of this thread, the one updating
+		const World* world = Script::getWorld();
+		
+		if(world)
+		{
+			out << "Entities: " << world->getEntities().size() << '\n';
+			out << "Scripts:\n";
+			
+			for(auto& s : world->getScripts())
+				out << '\t' << s.first << '\n';
+		}
+		else
+			out << "No world\n";
+		
+		out << "Memory:\n";
+		
+		for(unsigned c = 0; c < static_cast<unsigned>(MemoryTracker::Category::Count); c++)
+		{
+			MemoryTracker::Category category = static_cast<MemoryTracker::Category>(c);
+			out << '\t' << MemoryTracker::getName(category) << ": " << MemoryTracker::getStats(category).live << " bytes\n";
+		}
+	}
+	
+	void Game::enterState(State* state, State::Type type)
+	{
+		std::function<void()> job = state->preload();
+		
+		if(!job)
+		{
+			currentState = state;
+			currentState->setup();
+			return;
 		}
+		
+		loading = new Loading(*window, assets, soundPlayer, musicPlayer, settings, dictionary, defaultFont, state, type, job);
+		currentState = loading;
+	}
+	
+	void Game::renderLoop()
+	{
+		window->setActive(true);
+		
+		const float dt = 1.f / ticksPerSecond;
+		sf::Clock frameClock;
+		
+		// the main thread has its own
+		FramePacer framePacer(GameTime);
+		framePacer.setFrameLimit(pacer.getFrameLimit());
+		
+		while(running)
+		{
+			sf::Time frameStart = GameTime.getElapsedTime();
+			
+			{
+				std::lock_guard<std::mutex> lock(frameMutex);
+				
+				// the state may have been destroyed by the tick that stopped the game
+				if(!running)
+					break;
+				
+				// interpolate from the last ticks, plus the time since. Frames between ticks still move
+				sf::Time sinceTick = GameTime.getElapsedTime() - lastTick;
+				draw(std::min((lastLag + sinceTick).asSeconds() / dt, 1.f));
+			}
+			
+			window->display();
+			
+			framePacer.waitUntil(framePacer.getFrameDeadline(frameStart));
+			
+			// frames per second measurement, shown next frame
+			sf::Time frameTime = frameClock.restart();
+			
+			if(debug)
+			{
+				std::lock_guard<std::mutex> lock(frameMutex);
+				FPS.setString(std::to_string(1 / frameTime.asSeconds()).substr(0, 7));
+			}
+		}
+		
+		window->setActive(false);
+	}
+	
+	void Game::runHeadless()
+	{
+		World world(headlessWorld, assets, soundPlayer, musicPlayer, headlessScripts);
+		
+		// tiles without their textures, for passability, pathfinding, and collision
+		if(!world.tilemap.loadFile(headlessMap))
+		{
+			SWIFT_ERROR(General, "Loading tilemap \"" << headlessMap << "\" failed, headless run stopped.\n");
+			running = false;
+			return;
+		}
+		
+		if(!world.load())
+			SWIFT_WARNING(World, "Loading World data for world: \"" << headlessWorld << "\" failed.\n");
+		
+		Script::setWorld(world);
+		
+		const float dt = 1.f / ticksPerSecond;
+		const sf::Time tick = sf::seconds(dt);
+		const sf::Time start = GameTime.getElapsedTime();
+		
+		sf::Time next = start;
+		unsigned ticks = 0;
+		
+		log << "Running \"" << headlessWorld << "\" headless" << (unthrottled ? ", unthrottled" : "") << ".\n";
+		
+		while(running && (headlessTicks == 0 || ticks < headlessTicks))
+		{
+			saveWriter.poll();
+			assets.update();
+			settings.getEvents().dispatch();
+			
+			sf::Time tickStart = GameTime.getElapsedTime();
+			watchdog.begin();
+			world.update(dt);
+			watchdog.check("Tick", GameTime.getElapsedTime() - tickStart, [this](std::ostream& out) { reportHitch(out); });
+			ticks++;
+			
+			FrameStats::countTick();
+			FrameStats::endFrame();
+			
+			if(unthrottled)
+				continue;
+			
+			next += tick;
+			
+			// fell behind, start again from now instead of running a burst of ticks
+			if(GameTime.getElapsedTime() > next + sf::seconds(0.25))
+				next = GameTime.getElapsedTime();
+			
+			Script::collectGarbage(std::min(scriptGcTime, next - GameTime.getElapsedTime()));
+			pacer.waitUntil(next);
+		}
+		
+		float seconds = (GameTime.getElapsedTime() - start).asSeconds();
+		
+		log << "Ran " << ticks << " ticks in " << seconds << " s, " << (seconds > 0 ? ticks / seconds : 0) << " a second, "
+			<< (seconds > 0 ? ticks * dt / seconds : 0) << "x real time.\n";
+		
+		Script::setWorld(nullptr);
+		running = false;
+	}
+	
+	void Game::runBenchmark()
+	{
+		log << "World Benchmark:\n";
+		
+		WorldBenchmark bench(assets, soundPlayer, musicPlayer, saveWriter);
+		
+		if(!bench.run(benchmarkMap, benchmarkAnimation, *window))
+			return;
+		
+		for(auto& r : bench.getResults())
+		{
+			log << r.entities << " entities: " << r.update << " us update, " << r.draw << " us draw, "
+				<< r.collisions << " collisions, " << r.save << " ms save, " << r.load << " ms load, "
+				<< r.memory << " bytes, " << r.peakMemory << " bytes peak\n";
+			
+			for(auto& s : r.systems)
+				log << '\t' << s.first << ": " << s.second << " us\n";
+		}
+		
+		bench.save("./data/worldbench.json");
+		log << '\n';
+	}
+	
+	void Game::setupRecording()
+	{
+		if(!replayFile.empty())
+		{
+			if(!recorder.load(replayFile))
+			{
+				SWIFT_ERROR(General, "Replay of \"" << replayFile << "\" failed, playing normally.\n");
+				return;
+			}
+			
+			// ticks are only the same at the same rate, and from the same randomness
+			ticksPerSecond = recorder.getTicksPerSecond();
+			Random::setSeed(recorder.getSeed());
+			rng = Random::stream("game");
+			std::srand(recorder.getSeed());
+			
+			// replays aren't paced, so nothing should wait on the display
+			verticalSync = false;
+			
+			if(window)
+				window->setVerticalSyncEnabled(false);
+			
+			log << "Replaying " << recorder.getTickCount() << " ticks from \"" << replayFile << "\".\n";
+		}
+		else if(!recordFile.empty())
+		{
+			std::uint32_t seed = std::random_device()();
+			Random::setSeed(seed);
+			rng = Random::stream("game");
+			std::srand(seed);
+			
+			recorder.record(seed, ticksPerSecond);
+			
+			log << "Recording input to \"" << recordFile << "\".\n";
+		}
+	}
+	
+	void Game::finishStartup()
+	{
+		if(fileIndex.getReused() + fileIndex.getWalked() > 0)
+		{
+			log << "Startup index: " << fileIndex.getReused() << " folders reused, " << fileIndex.getWalked() << " walked\n";
+			
+			if(!fileIndex.save())
+				SWIFT_WARNING(General, "Could not save the startup index\n");
+		}
+		
+		log << "Startup:\n" << StartupTimer::report() << '\n';
+		StartupTimer::clear();
 	}
 	
 	void Game::setupWindow()
 	{
+		SWIFT_STARTUP("Window");
+		
+		// nothing to show, and maybe no display to show it on
+		if(headless)
+			return;
+		
+		if(!window)
+			window.reset(new sf::RenderWindow);
+		
 		if(fullscreen)
-			window.create(sf::VideoMode::getDesktopMode(), title, sf::Style::Fullscreen);
+			window->create(sf::VideoMode::getDesktopMode(), title, sf::Style::Fullscreen);
 		else
-			window.create({resolution.x, resolution.y, 32}, title, sf::Style::Titlebar | sf::Style::Close);
+			window->create({resolution.x, resolution.y, 32}, title, sf::Style::Titlebar | sf::Style::Close);
 		
-		window.setVerticalSyncEnabled(verticalSync);
-		window.setKeyRepeatEnabled(false);
+		window->setVerticalSyncEnabled(verticalSync);
+		window->setKeyRepeatEnabled(false);
 
 		// fps display
 		FPS.setFont(defaultFont);
 		FPS.setScale(0.7, 0.7);
 		FPS.setString("000.000");
 		FPS.setColor(sf::Color::White);
-		FPS.setPosition(window.getSize().x - (FPS.getGlobalBounds().width + 10), 10);
+		FPS.setPosition(window->getSize().x - (FPS.getGlobalBounds().width + 10), 10);
+		
+		// stats display, under the fps
+		stats.setFont(defaultFont);
+		stats.setScale(0.5, 0.5);
+		stats.setColor(sf::Color::White);
+		stats.setPosition(window->getSize().x - 260, 40);
 	}
 	
 	void Game::loadAssets()
 	{
+		SWIFT_STARTUP("Assets");
+		
 		assets.setSmooth(smoothing);
-		assets.loadResourceFolder("./data/anims");
-		assets.loadResourceFolder("./data/textures");
-		assets.loadResourceFolder("./data/fonts");
-		assets.loadResourceFolder("./data/music");
-		assets.loadResourceFolder("./data/scripts");
-		assets.loadResourceFolder("./data/sounds");
+		
+		// a release's assets, in one file. Loose files in the folders below are loaded over it
+		if(std::ifstream("./data/base.pack"))
+			assets.mountPack("./data/base.pack");
+		
+		std::vector<std::string> folders = {"./data/anims", "./data/textures", "./data/fonts", "./data/music", "./data/scripts",
+			"./data/sounds", "./data/prefabs"};
+		
+		// only what the simulation needs, textures and sounds would need a graphics or audio context
+		if(headless)
+			folders = {"./data/scripts", "./data/prefabs"};
+		
+		assets.loadResourceFolders(folders);
+		
+		// for changing content without restarting
+		if(hotReload)
+			assets.watch(folders);
 		
 		// make log file a little prettier
 		log << '\n';
@@ -125,23 +528,44 @@ namespace swift
 	void Game::loadMods()
 	{
 		// find all mods
-		mods.loadMods("./data/mods");
+		{
+			SWIFT_STARTUP("Mod discovery");
+			mods.loadMods("./data/mods");
+		}
 
-		// this would be where you normally conditionally load up mods
+		// this would be where you normally conditionally load up mods.
+		// all at once, so a file replaced by more than one mod is only loaded from the last, in name order
+		std::vector<const Mod*> active;
+		
 		for(auto& m : mods.getMods())
+			active.push_back(&m.second.mod);
+		
 		{
-			assets.loadMod(m.second.mod);
+			SWIFT_STARTUP("Mod assets");
+			assets.loadMods(active);
+		}
+		
+		if(hotReload)
+		{
+			for(auto& m : active)
+				assets.watch({m->getFolder()});
 		}
 	}
 			
 	// initialize scripting variables
 	void Game::initScripting()
 	{
+		SWIFT_STARTUP("Scripting");
+		
 		// setup Script static variables
-		Script::setWindow(window);
+		if(window)
+			Script::setWindow(*window);
 		Script::setAssetManager(assets);
 		Script::setClock(GameTime);
 		Script::setSettings(settings);
+		
+		// key bindings that fire wake scripts' onKey callbacks
+		keyboard.setListener(&Script::onKeyBinding);
 	}
 	
 	void Game::addKeyboardCommands()
@@ -168,6 +592,225 @@ namespace swift
 			return 0;
 		});
 
+		// profile start, profile stop, profile save [file]. Saves are Chrome tracing files, open them in chrome://tracing or Perfetto
+		console.addCommand("profile", [&](ArgVec args)
+		{
+			if(args.size() >= 2 && args[1] == "start")
+			{
+				Profiler::start();
+				console << "\nProfiling.";
+			}
+			else if(args.size() >= 2 && args[1] == "stop")
+			{
+				Profiler::stop();
+				console << "\nStopped profiling.";
+			}
+			else if(args.size() >= 2 && args[1] == "save")
+			{
+				std::string file = args.size() >= 3 ? args[2] : "./data/profile.json";
+				
+				if(!Profiler::save(file))
+				{
+					console << "\nCould not save profile to \"" << file << "\".";
+					return 1;
+				}
+				
+				console << "\nSaved profile to \"" << file << "\".";
+			}
+			else
+			{
+				console << "\nUsage: profile start|stop|save [file]";
+				return 1;
+			}
+			
+			return 0;
+		});
+		
+		// pack file folder..., packs the folders' files, ex: pack ./data/base.pack ./data/textures ./data/sounds
+		console.addCommand("pack", [&](ArgVec args)
+		{
+			if(args.size() < 3)
+			{
+				console << "\nUsage: pack file folder...";
+				return 1;
+			}
+			
+			if(!AssetManager::writePack(args[1], std::vector<std::string>(args.begin() + 2, args.end())))
+			{
+				console << "\nCould not write pack \"" << args[1] << "\".";
+				return 1;
+			}
+			
+			console << "\nWrote pack \"" << args[1] << "\".";
+			return 0;
+		});
+		
+		// memory of each budgeted asset category
+		console.addCommand("assets", [&](ArgVec /*args*/)
+		{
+			const char* names[] = {"Textures", "Sounds"};
+			
+			for(unsigned c = 0; c < 2; c++)
+			{
+				AssetManager::Category category = static_cast<AssetManager::Category>(c);
+				std::size_t budget = assets.getBudget(category);
+				
+				console << "\n" << names[c] << ": " << std::to_string(assets.getCount(category)) << " loaded, "
+						<< std::to_string(assets.getMemory(category) / 1024) << " KiB of "
+						<< (budget ? std::to_string(budget / 1024) + " KiB" : "unlimited")
+						<< ", " << std::to_string(assets.getEvictions(category)) << " evicted";
+			}
+			
+			console << "\nAtlas: " << std::to_string(assets.getAtlasPages()) << " pages";
+			
+			return 0;
+		});
+		
+		// live and peak memory of each part of the engine. memory save [file] writes it for comparing builds, memory reset clears the peaks
+		console.addCommand("memory", [&](ArgVec args)
+		{
+			if(args.size() >= 2 && args[1] == "save")
+			{
+				std::string file = args.size() >= 3 ? args[2] : "./data/memory.csv";
+				
+				if(!MemoryTracker::save(file))
+				{
+					console << "\nCould not save memory stats to \"" << file << "\".";
+					return 1;
+				}
+				
+				console << "\nSaved memory stats to \"" << file << "\".";
+				return 0;
+			}
+			
+			if(args.size() >= 2 && args[1] == "reset")
+			{
+				MemoryTracker::reset();
+				console << "\nReset memory peaks and counts.";
+				return 0;
+			}
+			
+			if(!MemoryTracker::isTrackingHeap())
+				console << "\nOnly Lua is counted, build with SWIFT_TRACK_MEMORY for the rest.";
+			
+			for(unsigned c = 0; c < static_cast<unsigned>(MemoryTracker::Category::Count); c++)
+			{
+				MemoryTracker::Category category = static_cast<MemoryTracker::Category>(c);
+				MemoryTracker::Stats stats = MemoryTracker::getStats(category);
+				
+				console << "\n" << MemoryTracker::getName(category) << ": " << std::to_string(stats.live / 1024) << " KiB live, "
+						<< std::to_string(stats.peak / 1024) << " KiB peak, " << std::to_string(stats.allocations) << " allocations, "
+						<< std::to_string(stats.frees) << " frees";
+			}
+			
+			return 0;
+		});
+		
+		// scripts that ran out of their Update budget, and how many ticks they did.
+		// scripts top [count], the costliest scripts by update time per tick. scripts reset, clears what top shows
+		console.addCommand("scripts", [&](ArgVec args)
+		{
+			if(args.size() >= 2 && args[1] == "top")
+			{
+				std::vector<std::pair<std::string, const Script::Stats*>> top;
+				
+				for(auto& s : assets.getScripts())
+					top.emplace_back(s.first, &s.second->getStats());
+				
+				auto perTick = [](const Script::Stats& s, std::int64_t time)
+				{
+					return s.updates ? time / s.updates : 0;
+				};
+				
+				std::sort(top.begin(), top.end(), [&](const std::pair<std::string, const Script::Stats*>& one, const std::pair<std::string, const Script::Stats*>& two)
+				{
+					return perTick(*one.second, one.second->updateTime) > perTick(*two.second, two.second->updateTime);
+				});
+				
+				std::size_t count = args.size() >= 3 ? std::strtoul(args[2].c_str(), nullptr, 10) : 0;
+				count = count ? count : 5;
+				
+				for(std::size_t i = 0; i < top.size() && i < count; i++)
+				{
+					const Script::Stats& stats = *top[i].second;
+					
+					console << "\n" << top[i].first << ": " << std::to_string(perTick(stats, stats.updateTime)) << " us update, "
+							<< std::to_string(perTick(stats, stats.gcTime)) << " us GC a tick, "
+							<< std::to_string(stats.memory / 1024) << " KiB";
+					
+					// its most called bindings
+					std::vector<std::pair<unsigned, unsigned>> calls;
+					
+					for(unsigned id = 0; id < stats.calls.size(); id++)
+					{
+						if(stats.calls[id])
+							calls.emplace_back(stats.calls[id], id);
+					}
+					
+					std::sort(calls.rbegin(), calls.rend());
+					
+					for(std::size_t c = 0; c < calls.size() && c < 5; c++)
+						console << "\n    " << lpp::CallStats::getName(calls[c].second) << ": " << std::to_string(calls[c].first) << " calls";
+				}
+				
+				if(top.empty())
+					console << "\nNo scripts are loaded.";
+				
+				return 0;
+			}
+			else if(args.size() >= 2 && args[1] == "reset")
+			{
+				for(auto& s : assets.getScripts())
+					s.second->resetStats();
+				
+				console << "\nCleared script stats.";
+				return 0;
+			}
+			
+			if(Script::getOverBudget().empty())
+				console << "\nNo script ran out of budget.";
+			
+			for(auto& s : Script::getOverBudget())
+				console << "\n" << s.first << ": over budget " << std::to_string(s.second) << " ticks";
+			
+			return 0;
+		});
+		
+		// log, lists the log's categories. log category|all on|off, turns one or all of them on or off
+		console.addCommand("log", [&](ArgVec args)
+		{
+			if(args.size() >= 3 && (args[2] == "on" || args[2] == "off"))
+			{
+				Logger::Category category = Logger::General;
+				bool all = args[1] == "all";
+				
+				if(!all && !Logger::findCategory(args[1], category))
+				{
+					console << "\nNo log category \"" << args[1] << "\".";
+					return 1;
+				}
+				
+				for(unsigned c = 0; c < Logger::CategoryCount; c++)
+				{
+					if(all || c == static_cast<unsigned>(category))
+						log.setEnabled(static_cast<Logger::Category>(c), args[2] == "on");
+				}
+			}
+			else if(args.size() >= 2)
+			{
+				console << "\nUsage: log [category|all on|off]";
+				return 1;
+			}
+			
+			for(unsigned c = 0; c < Logger::CategoryCount; c++)
+			{
+				Logger::Category category = static_cast<Logger::Category>(c);
+				console << "\n" << Logger::getName(category) << ": " << (log.isEnabled(category) ? "on" : "off");
+			}
+			
+			return 0;
+		});
+		
 		console.addCommand("exit", [&](ArgVec /*args*/)
 		{
 			running = false;
@@ -198,6 +841,48 @@ namespace swift
 			{
 				fullscreen = true;
 			}
+			else if(args[arg] == std::string("renderThread"))
+			{
+				threadedRendering = true;
+			}
+			else if(args[arg] == std::string("headless") && arg + 2 < c)
+			{
+				// headless world map, ticks the world without a window, sound, or states
+				headless = true;
+				headlessWorld = args[arg + 1];
+				headlessMap = args[arg + 2];
+				soundPlayer.setEnabled(false);
+				arg += 2;
+			}
+			else if(args[arg] == std::string("script") && arg + 1 < c)
+			{
+				// script file, run by the headless world. May be given more than once
+				headlessScripts.push_back(args[arg + 1]);
+				arg++;
+			}
+			else if(args[arg] == std::string("ticks") && arg + 1 < c)
+			{
+				// ticks the headless world runs before the game stops
+				headlessTicks = std::stoi(args[arg + 1]);
+				arg++;
+			}
+			else if(args[arg] == std::string("unthrottled"))
+			{
+				// headless ticks run back to back, as fast as they can
+				unthrottled = true;
+			}
+			else if(args[arg] == std::string("record") && arg + 1 < c)
+			{
+				// record file, saves the session's input to replay later
+				recordFile = args[arg + 1];
+				arg++;
+			}
+			else if(args[arg] == std::string("replay") && arg + 1 < c)
+			{
+				// replay file, plays a recorded session's input again, as fast as it can, then stops
+				replayFile = args[arg + 1];
+				arg++;
+			}
 			else if(args[arg] == std::string("res"))
 			{
 				resolution.x = std::stoi(args[arg + 1]);
@@ -217,6 +902,45 @@ namespace swift
 				}
 				log << '\n';
 			}
+			else if(args[arg] == std::string("pathBench"))
+			{
+				// results go to data/pathbench.csv, regressions against data/pathbench_baseline.csv
+				// are logged as warnings. Copy the results over the baseline to accept them
+				log << "Pathfinding Benchmark:\n";
+				
+				PathBenchmark bench;
+				bench.run();
+				
+				for(auto& r : bench.getResults())
+				{
+					log << PathBenchmark::getName(r.map) << ' ' << r.size << ' ' << PathBenchmark::getName(r.algorithm) << ": "
+						<< r.found << '/' << r.queries << " found, " << r.expanded << " expanded, "
+						<< r.microseconds << " us, " << r.memory << " bytes\n";
+				}
+				
+				bench.save("./data/pathbench.csv");
+				log << bench.compare("./data/pathbench_baseline.csv") << " regressions\n\n";
+			}
+			else if(args[arg] == std::string("worldBench") && arg + 2 < c)
+			{
+				// worldBench map animation, once the assets are loaded, ticks and draws generated worlds on maps made from
+				// map's tilesets, then stops. Results go to data/worldbench.json
+				benchmarkMap = args[arg + 1];
+				benchmarkAnimation = args[arg + 2];
+				arg += 2;
+			}
+			else if(args[arg] == std::string("compileMap") && arg + 2 < c)
+			{
+				// compiles a .tmx map into the binary format TileMap::loadFile maps straight into memory, for release builds
+				TileMap map;
+				
+				if(map.loadFile(args[arg + 1]) && map.saveBinary(args[arg + 2]))
+					log << "Compiled map \"" << args[arg + 1] << "\" to \"" << args[arg + 2] << "\".\n";
+				else
+					SWIFT_ERROR(General, "Compiling map \"" << args[arg + 1] << "\" failed.\n");
+				
+				arg += 2;
+			}
 			else
 			{
 				log << "\nUnknown launch option: " << args[arg] << '\n';
@@ -228,16 +952,176 @@ namespace swift
 	
 	void Game::loadSettings(const std::string& file)
 	{
+		SWIFT_STARTUP("Settings");
+		
 		// settings file settings
 		if(!settings.loadFile(file))
-			log << "Could not open settings file, default settings will be used\n";
+			SWIFT_WARNING(General, "Could not open settings file, default settings will be used\n");
 
 		settings.get("fullscreen", fullscreen);
 		settings.get("vsync", verticalSync);
+		settings.get("renderThread", threadedRendering);
 		settings.get("res.x", resolution.x);
 		settings.get("res.y", resolution.y);
 		settings.get("sound", soundLevel);
 		settings.get("music", musicLevel);
 		settings.get("lang", language);
+		
+		// sounds started further than this from the listener aren't played, 0 for no limit
+		float soundDistance = 0;
+		settings.get("soundDistance", soundDistance);
+		soundPlayer.setAudibleDistance(soundDistance);
+		
+		// seconds each song fades into the next over
+		float musicFade = 2;
+		settings.get("musicFade", musicFade);
+		musicPlayer.setCrossfade(sf::seconds(musicFade));
+		
+		// sounds and music are run on a thread of their own
+		bool audioThread = true;
+		settings.get("audioThread", audioThread);
+		
+		if(audioThread && !headless)
+			audio.start();
+		else
+			audio.stop();
+		
+		// drawing interpolates between updates, so this can be well under the frame rate
+		settings.get("tps", ticksPerSecond);
+		
+		// ticks a frame runs at most when it's behind, 0 for no limit
+		settings.get("maxCatchUp", maxCatchUp);
+		
+		// systems that can run less often than every tick, as "hz.Pathfinder 10"
+		for(auto& system : {"Controllable", "Movable", "Pathfinder", "Physical", "Noisy", "Animated", "Drawable"})
+		{
+			float hz = 0;
+			
+			if(settings.get(std::string("hz.") + system, hz) && hz > 0)
+				SystemScheduler::setInterval(system, static_cast<unsigned>(std::max(1.f, std::round(ticksPerSecond / hz))));
+		}
+		
+		// entities within each radius of a player or the camera run every that many ticks, further ones are frozen,
+		// as "lodBands 1024:1,2048:4,4096:16". Unset, everything runs every tick
+		std::string lodBands;
+		
+		if(settings.get("lodBands", lodBands) && !SimulationLod::parseBands(lodBands))
+			SWIFT_WARNING(General, "Could not parse lodBands \"" << lodBands << "\", expected radius:interval pairs\n");
+		
+		// frames a second drawn at most, 0 for no limit. The loop sleeps until the next frame instead of spinning
+		unsigned fpsLimit = pacer.getFrameLimit();
+		settings.get("fpsLimit", fpsLimit);
+		pacer.setFrameLimit(fpsLimit);
+		
+		// entities per system before its work is split across threads
+		unsigned parallelThreshold = threadPool.getParallelThreshold();
+		settings.get("parallelThreshold", parallelThreshold);
+		threadPool.setParallelThreshold(parallelThreshold);
+		
+		// widest SIMD the batched kernels use: "scalar", "wide4" for SSE2 or NEON, or "avx2". The default is what the CPU has
+		std::string simd;
+		
+		if(settings.get("simd", simd))
+		{
+			if(simd == "scalar")
+				setSimdLimit(SimdLevel::Scalar);
+			else if(simd == "wide4")
+				setSimdLimit(SimdLevel::Wide4);
+			else
+				setSimdLimit(SimdLevel::Avx2);
+			
+			SWIFT_INFO(General, "SIMD kernels: " << getName(getSimdLevel()) << '\n');
+		}
+		
+		// world saves as XML, for editing them by hand. Binary and XML saves both load either way
+		bool xmlSaves = false;
+		settings.get("xmlSaves", xmlSaves);
+		World::setSaveFormat(xmlSaves ? World::SaveFormat::Xml : World::SaveFormat::Binary);
+		
+		// scripts share one Lua VM, each with its own globals
+		bool sharedLua = false;
+		settings.get("sharedLua", sharedLua);
+		Script::setSharedState(sharedLua);
+		
+		// Lua instructions a script's Update runs each tick before it's paused until the next, 0 for no limit
+		unsigned scriptBudget = 0;
+		settings.get("scriptBudget", scriptBudget);
+		Script::setBudget(scriptBudget);
+		
+		// compiled scripts are kept here, so unchanged ones aren't compiled again at startup or when switching worlds. "" for none
+		std::string bytecodeCache = "./data/saves";
+		settings.get("bytecodeCache", bytecodeCache);
+		Script::setBytecodeCache(bytecodeCache);
+		
+		// content folders' files and mods' info, as this run finds them, so the next skips walking and parsing what's unchanged.
+		// "" for none
+		std::string startupIndex = "./data/saves/startup.index";
+		settings.get("startupIndex", startupIndex);
+		
+		if(!startupIndex.empty())
+		{
+			if(!fileIndex.load(startupIndex))
+				SWIFT_INFO(General, "No startup index at \"" << startupIndex << "\", content folders will be walked\n");
+			
+			AssetManager::setFileIndex(fileIndex);
+			ModManager::setFileIndex(fileIndex);
+		}
+		
+		// microseconds a frame may spend collecting scripts' garbage, when it has them to spare
+		int scriptGcMicroseconds = static_cast<int>(scriptGcTime.asMicroseconds());
+		settings.get("scriptGcTime", scriptGcMicroseconds);
+		scriptGcTime = sf::microseconds(scriptGcMicroseconds);
+		
+		// what every stream of random numbers is derived from. Recordings replace it with their own
+		unsigned seed = 0;
+		settings.get("seed", seed);
+		Random::setSeed(seed);
+		rng = Random::stream("game");
+		
+		// milliseconds a frame or tick may take before the profile of the frames before it is saved, 0 for never.
+		// The profiler captures all the time while it's on
+		unsigned hitchThreshold = 0;
+		unsigned hitchFrames = 120;
+		std::string hitchFolder = "./data";
+		settings.get("hitchThreshold", hitchThreshold);
+		settings.get("hitchFrames", hitchFrames);
+		settings.get("hitchFolder", hitchFolder);
+		watchdog.setFrames(hitchFrames);
+		watchdog.setFolder(hitchFolder);
+		watchdog.setThreshold(sf::milliseconds(hitchThreshold));
+		
+		// changed asset files reload while playing
+		settings.get("hotReload", hotReload);
+		
+		// assets load when first used, instead of all at startup
+		bool lazyAssets = false;
+		settings.get("lazyAssets", lazyAssets);
+		assets.setLazy(lazyAssets);
+		
+		// .ogg and .flac sounds are kept compressed, and decoded when first played, then within the sound budget
+		bool compressedSounds = false;
+		settings.get("compressedSounds", compressedSounds);
+		assets.setCompressedSounds(compressedSounds);
+		
+		// textures no bigger than this on a side are packed onto atlas pages at startup, 0 for none
+		unsigned atlasSize = 256;
+		settings.get("atlasSize", atlasSize);
+		assets.setAtlas(atlasSize);
+		
+		// mipmapped textures, for zooming out. And kilobytes of prefetched textures uploaded a frame, 0 for all at once
+		bool mipmaps = false;
+		unsigned uploadBudget = 0;
+		settings.get("mipmaps", mipmaps);
+		settings.get("uploadBudget", uploadBudget);
+		assets.setMipmaps(mipmaps);
+		assets.setUploadBudget(static_cast<std::size_t>(uploadBudget) * 1024);
+		
+		// megabytes of textures and sounds kept loaded when unused, 0 for no limit
+		unsigned textureBudget = 0;
+		unsigned soundBudget = 0;
+		settings.get("textureBudget", textureBudget);
+		settings.get("soundBudget", soundBudget);
+		assets.setBudget(AssetManager::Category::Textures, static_cast<std::size_t>(textureBudget) * 1024 * 1024);
+		assets.setBudget(AssetManager::Category::Sounds, static_cast<std::size_t>(soundBudget) * 1024 * 1024);
 	}
 }
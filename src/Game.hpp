@@ -17,10 +17,13 @@
 #include "StateSystem/States/Play.hpp"
 #include "StateSystem/States/MainMenu.hpp"
 #include "StateSystem/States/SettingsMenu.hpp"
+#include "StateSystem/States/Loading.hpp"
 
 /* Input headers */
 #include "KeyBindings/KeyboardManager.hpp"
 #include "KeyBindings/MouseManager.hpp"
+#include "KeyBindings/InputRecorder.hpp"
+#include "KeyBindings/InputBuffer.hpp"
 
 /* Utility headers */
 #include "Console/Console.hpp"
@@ -34,6 +37,27 @@
 /* Sound headers */
 #include "SoundSystem/SoundPlayer.hpp"
 #include "SoundSystem/MusicPlayer.hpp"
+#include "SoundSystem/AudioService.hpp"
+
+/* Profiling headers */
+#include "Profiling/FrameStats.hpp"
+#include "Profiling/GpuTimer.hpp"
+#include "Profiling/Watchdog.hpp"
+#include "Profiling/StartupTimer.hpp"
+
+/* Threading headers */
+#include "Threading/ThreadPool.hpp"
+#include "Threading/FramePacer.hpp"
+
+/* Scripting headers */
+#include "Scripting/Script.hpp"
+#include "Math/Random.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
 
 namespace swift
 {	
@@ -89,9 +113,37 @@ namespace swift
 			
 			// Drawing all drawable game objects, backgrounds, etc
 			// Same reason as why it has it's own function as Update
+			// Doesn't display, so the caller decides where the buffer swap (and vsync wait) happens
 			void draw(float e);
 			
-			// figure out settings for window and create it
+			// fills the debug stats overlay in from the frame that was just drawn
+			void updateStats();
+			
+			// what the watchdog writes about the game after the profile of a hitch
+			void reportHitch(std::ostream& out) const;
+			
+			// times generated worlds of growing size, with the "worldBench" launch option, instead of playing
+			void runBenchmark();
+			
+			// the event handling for one event of the tick's input
+			void handleEvent(sf::Event& event);
+			
+			// seeds randomness and starts recording, or loads a replay, from the launch options. Called by gameLoop,
+			// once the settings have set the tick rate
+			void setupRecording();
+			
+			// saves the file index and logs how long each phase of starting up took. Called by gameLoop, before the first tick
+			void finishStartup();
+			
+			// ticks the headless world until headlessTicks have run or the game stops, after the launch options,
+			// settings, and assets. Its saves are written as a played world's are
+			void runHeadless();
+			
+			// Drawing on its own thread, for when threadedRendering is set. Draws whenever the display is ready,
+			// taking the simulation lock only while drawing, so vsync and driver stalls don't hold back ticks
+			void renderLoop();
+			
+			// figure out settings for window and create it. Headless runs don't have one
 			void setupWindow();
 			
 			// invoke asset loading
@@ -113,6 +165,10 @@ namespace swift
 			template<typename MainMenu>
 			void initState();
 			
+			// makes state, made as type, the current one. One with something to preload is shown behind a loading screen
+			// until it's done, and set up by manageStates after
+			void enterState(State* state, State::Type type);
+			
 			// initialize scripting variables
 			void initScripting();
 			
@@ -126,7 +182,7 @@ namespace swift
 			// opens the settings file and sets the respective variables
 			virtual void loadSettings(const std::string& file);
 			
-			bool running;
+			std::atomic<bool> running;
 			sf::Font defaultFont;
 			
 			/* Resources */
@@ -136,10 +192,13 @@ namespace swift
 			/* Sound */
 			SoundPlayer soundPlayer;
 			MusicPlayer musicPlayer;
+			AudioService audio;		// runs the players off the game thread, with the "audioThread" setting
 			
 			/* Input */
 			KeyboardManager keyboard;
 			MouseManager mouse;
+			InputRecorder recorder;	// the "record" and "replay" launch options
+			InputBuffer input;		// each tick's events, handled together once they're all in
 			
 			/* Something about the console should go here, but I don't know what to put other than "Console". Which seems redundant */
 			Console console;
@@ -147,6 +206,12 @@ namespace swift
 			/* FPS tracking */
 			sf::Text FPS;
 			
+			/* debug stats overlay */
+			sf::Text stats;
+			
+			// FPS and stats, drawn together
+			cstr::Batch overlay;
+			
 			/* Settings */
 			Settings settings;
 			Settings controls;
@@ -156,29 +221,70 @@ namespace swift
 			bool smoothing;			// texture smoothing
 			bool fullscreen;
 			bool verticalSync;
+			bool threadedRendering;	// draw on a separate thread from updates
+			bool hotReload;			// reload asset files as they're changed
 			Resolution resolution;
 			unsigned soundLevel;
 			unsigned musicLevel;
 			std::string language;
 
-			// random number generator
-			std::mt19937 rng;	// Whenever something random is needed, this is all ready!
+			// random number generator, of the "game" stream. Systems and scripts have streams of their own, see Random
+			Random::Generator rng;
+			
+			/* Threading */
+			ThreadPool threadPool;	// workers for running systems in parallel, one per physical core besides this thread
+			
+			// writes world saves in the background
+			AsyncWriter saveWriter;
+			
+			std::thread renderThread;
+			std::mutex frameMutex;	// held by updates, and by drawing while it reads the game
 			
 		private:
 			/* Engine variables */
-			sf::RenderWindow window;
+			// made by setupWindow, so headless runs never make a graphics context
+			std::unique_ptr<sf::RenderWindow> window;
 			std::string title;
 			
+			// frame time on the GPU, shown when debugging
+			GpuTimer gpuTimer;
+			
 			/* States */
 			State* currentState;
+			Loading* loading;	// the current state while the next one preloads
 			
 			/* timing */
 			sf::Clock GameTime;		// Game loop timing. Starts once Game::Start() is called.
+			FramePacer pacer;		// waits for the next tick or frame, with the "fpsLimit" setting
 			float ticksPerSecond;	// Iterations of Update
+			unsigned maxCatchUp;	// most ticks a frame runs to catch up, the rest are dropped. 0 for no limit
+			sf::Time scriptGcTime;	// most a frame spends collecting scripts' garbage, of the time it has to spare
+			Watchdog watchdog;		// dumps the profile of slow frames, with the "hitchThreshold" setting
+			FileIndex fileIndex;	// content folders, and mods' info, as the last run found them, with the "startupIndex" setting
+			
+			// when the last ticks were run, and the time left over after them, for drawing to interpolate from
+			sf::Time lastTick;
+			sf::Time lastLag;
 
 			/* Launch Arguments */
 			bool editor;	// for running the map editor - not in use
 			bool debug;		// show debugging/performance info
+			
+			// "headless world map": one world ticked without a window, sound, or states, for servers and soak tests
+			bool headless;
+			bool unthrottled;		// ticks run back to back, faster than real time
+			unsigned headlessTicks;	// ticks before stopping, 0 for none
+			std::string headlessWorld;
+			std::string headlessMap;
+			std::vector<std::string> headlessScripts;
+			
+			// "record file" and "replay file": a session's input, to play again tick for tick, as a benchmark
+			std::string recordFile;
+			std::string replayFile;
+			
+			// "worldBench map animation"
+			std::string benchmarkMap;
+			std::string benchmarkAnimation;
 	};
 	
 	template<typename Play, typename MainMenu, typename SettingsMenu>
@@ -186,69 +292,181 @@ namespace swift
 	{
 		running = true;
 		
+		setupRecording();
+		finishStartup();
+		
+		if(headless)
+		{
+			runHeadless();
+			return;
+		}
+		
+		if(!benchmarkMap.empty())
+		{
+			runBenchmark();
+			return;
+		}
+		
 		const sf::Time dt = sf::seconds(1.f / ticksPerSecond);
+		const bool replaying = recorder.getMode() == InputRecorder::Mode::Replaying;
 
 		sf::Time currentTime = GameTime.getElapsedTime();
 		sf::Time lag = sf::seconds(0);
+		
+		lastTick = currentTime;
+		lastLag = lag;
+		
+		// the context can only be active on one thread at a time. Events are still polled here, where the window was made
+		if(threadedRendering)
+		{
+			window->setActive(false);
+			renderThread = std::thread(&Game::renderLoop, this);
+		}
 
+		auto report = [this](std::ostream& out) { reportHitch(out); };
+		
 		while(running)
 		{
 			sf::Time newTime = GameTime.getElapsedTime();
 			sf::Time frameTime = newTime - currentTime;
+			
+			watchdog.begin();
+			
+			// replays run a tick a frame, however long it really took
+			if(replaying)
+				frameTime = dt;
 
+			// a long stall, like a breakpoint or a window drag, isn't caught up on
 			if(frameTime > sf::seconds(0.25))
+			{
+				FrameStats::countDroppedTicks(static_cast<unsigned>((frameTime - sf::seconds(0.25)).asMicroseconds() / dt.asMicroseconds()));
 				frameTime = sf::seconds(0.25);
+			}
 
 			currentTime = newTime;
 
 			lag += frameTime;
 
-			while(lag >= dt)
 			{
-				update(dt);
-				manageStates<Play, MainMenu, SettingsMenu>();
-				lag -= dt;
+				std::lock_guard<std::mutex> lock(frameMutex);
+				
+				unsigned steps = 0;
+				
+				while(lag >= dt)
+				{
+					// too slow to keep up, so the game slows down instead of falling further behind each frame
+					if(maxCatchUp != 0 && steps == maxCatchUp)
+					{
+						sf::Int64 behind = lag.asMicroseconds() / dt.asMicroseconds();
+						FrameStats::countDroppedTicks(static_cast<unsigned>(behind));
+						lag -= sf::microseconds(dt.asMicroseconds() * behind);
+						break;
+					}
+					
+					steps++;
+					
+					sf::Time tickStart = GameTime.getElapsedTime();
+					update(dt);
+					manageStates<Play, MainMenu, SettingsMenu>();
+					watchdog.check("Tick", GameTime.getElapsedTime() - tickStart, report);
+					
+					lag -= dt;
+					
+					FrameStats::countTick();
+				}
+				
+				lastTick = newTime;
+				lastLag = lag;
+			}
+			
+			if(replaying && recorder.isFinished())
+				running = false;
+
+			if(threadedRendering)
+			{
+				// nothing else to do until the next tick is due
+				Script::collectGarbage(std::min(scriptGcTime, dt - lag));
+				
+				if(!replaying)
+					pacer.waitUntil(newTime + dt - lag);
+				
+				continue;
 			}
 
 			draw(lag.asSeconds() / dt.asSeconds());
 			
+			// before waiting for vsync, with what's left until the next tick
+			Script::collectGarbage(std::min(scriptGcTime, dt - lag - (GameTime.getElapsedTime() - newTime)));
+			
+			if(running)
+				window->display();
+			
+			watchdog.check("Frame", GameTime.getElapsedTime() - newTime, report);
+			
+			// vsync may have waited long enough already. Without a limit, the next frame starts now
+			if(!replaying)
+				pacer.waitUntil(pacer.getFrameDeadline(newTime));
+			
 			// frames per second measurement
 			if(debug)
 				FPS.setString(std::to_string(1 / frameTime.asSeconds()).substr(0, 7));
 		}
+		
+		if(renderThread.joinable())
+		{
+			renderThread.join();
+			window->setActive(true);
+		}
 	}
 	
 	template<typename Play, typename MainMenu, typename SettingsMenu>
 	void Game::manageStates()
 	{
+		// the loaded state takes over once its preload is done
+		if(loading)
+		{
+			if(loading->switchFrom())
+			{
+				currentState = loading->take();
+				delete loading;
+				loading = nullptr;
+				
+				currentState->setup();
+			}
+			
+			return;
+		}
+		
 		if(currentState->switchFrom())
 		{
 			State::Type nextState = currentState->finish();
 			delete currentState;
 			currentState = nullptr;
+			
+			State* next = nullptr;
 
 			switch(nextState)
 			{
 				case State::Type::MainMenu:
-					currentState = new MainMenu(window, assets, soundPlayer, musicPlayer, settings, dictionary);
+					next = new MainMenu(*window, assets, soundPlayer, musicPlayer, settings, dictionary);
 					break;
 				case State::Type::SettingsMenu:
-					currentState = new SettingsMenu(window, assets, soundPlayer, musicPlayer, settings, dictionary);
+					next = new SettingsMenu(*window, assets, soundPlayer, musicPlayer, settings, dictionary);
 					break;
 				case State::Type::Play:
-					currentState = new Play(window, assets, soundPlayer, musicPlayer, settings, dictionary);
+					next = new Play(*window, assets, soundPlayer, musicPlayer, settings, dictionary);
 					break;
 				case State::Type::Exit:
 					running = false;
 					break;
 				default:
-					log << "[ERROR]: State machine error, state not valid\n";
+					SWIFT_ERROR(General, "State machine error, state not valid\n");
 					running = false;
 					break;
 			}
 			
-			if(running)
-				currentState->setup();
+			if(next)
+				enterState(next, nextState);
 		}
 	}
 	
@@ -256,13 +474,15 @@ namespace swift
 	template<typename MainMenu>
 	void Game::initState()
 	{
-		// state setup
+		// states are what's shown, headless runs tick their world themselves
+		if(headless)
+			return;
+		
+		// state setup. The editor isn't a state type, leaving it closes the game
 		if(!editor)
-			currentState = new MainMenu(window, assets, soundPlayer, musicPlayer, settings, dictionary);
+			enterState(new MainMenu(*window, assets, soundPlayer, musicPlayer, settings, dictionary), State::Type::MainMenu);
 		else
-			currentState = new Editor(window, assets, soundPlayer, musicPlayer, settings, dictionary);
-		
-		currentState->setup();
+			enterState(new Editor(*window, assets, soundPlayer, musicPlayer, settings, dictionary), State::Type::Exit);
 	}
 }
 
@@ -0,0 +1,135 @@
+#include "InputBuffer.hpp"
+
+namespace swift
+{
+	InputBuffer::InputBuffer()
+	:	coalesced(0)
+	{
+		snapshot.wheel = 0;
+		snapshot.focused = true;
+	}
+	
+	void InputBuffer::begin()
+	{
+		events.clear();
+		
+		snapshot.keysPressed.reset();
+		snapshot.keysReleased.reset();
+		snapshot.buttonsPressed.reset();
+		snapshot.buttonsReleased.reset();
+		snapshot.mouseMoved = {0, 0};
+		snapshot.wheel = 0;
+		snapshot.text.clear();
+	}
+	
+	void InputBuffer::add(const sf::Event& event)
+	{
+		auto key = [](sf::Keyboard::Key k)
+		{
+			return k >= 0 && k < sf::Keyboard::KeyCount;
+		};
+		
+		auto button = [](sf::Mouse::Button b)
+		{
+			return b >= 0 && b < sf::Mouse::ButtonCount;
+		};
+		
+		switch(event.type)
+		{
+			case sf::Event::MouseMoved:
+			{
+				sf::Vector2i to = {event.mouseMove.x, event.mouseMove.y};
+				
+				if(to.x == snapshot.mouse.x && to.y == snapshot.mouse.y)
+				{
+					coalesced++;
+					return;
+				}
+				
+				snapshot.mouseMoved.x += to.x - snapshot.mouse.x;
+				snapshot.mouseMoved.y += to.y - snapshot.mouse.y;
+				snapshot.mouse = to;
+				
+				// only where it ended up matters, until something else happens
+				if(!events.empty() && events.back().type == sf::Event::MouseMoved)
+				{
+					events.back() = event;
+					coalesced++;
+					return;
+				}
+				
+				break;
+			}
+			case sf::Event::KeyPressed:
+				if(key(event.key.code))
+				{
+					snapshot.keys.set(event.key.code);
+					snapshot.keysPressed.set(event.key.code);
+				}
+				break;
+			case sf::Event::KeyReleased:
+				if(key(event.key.code))
+				{
+					snapshot.keys.reset(event.key.code);
+					snapshot.keysReleased.set(event.key.code);
+				}
+				break;
+			case sf::Event::MouseButtonPressed:
+				if(button(event.mouseButton.button))
+				{
+					snapshot.buttons.set(event.mouseButton.button);
+					snapshot.buttonsPressed.set(event.mouseButton.button);
+				}
+				snapshot.mouse = {event.mouseButton.x, event.mouseButton.y};
+				break;
+			case sf::Event::MouseButtonReleased:
+				if(button(event.mouseButton.button))
+				{
+					snapshot.buttons.reset(event.mouseButton.button);
+					snapshot.buttonsReleased.set(event.mouseButton.button);
+				}
+				snapshot.mouse = {event.mouseButton.x, event.mouseButton.y};
+				break;
+			case sf::Event::MouseWheelMoved:
+				snapshot.wheel += event.mouseWheel.delta;
+				break;
+			case sf::Event::TextEntered:
+				snapshot.text.push_back(event.text.unicode);
+				break;
+			case sf::Event::LostFocus:
+				snapshot.focused = false;
+				releaseAll();
+				break;
+			case sf::Event::GainedFocus:
+				snapshot.focused = true;
+				break;
+			default:
+				break;
+		}
+		
+		events.push_back(event);
+	}
+	
+	const std::vector<sf::Event>& InputBuffer::getEvents() const
+	{
+		return events;
+	}
+	
+	const InputBuffer::Snapshot& InputBuffer::getSnapshot() const
+	{
+		return snapshot;
+	}
+	
+	std::size_t InputBuffer::getCoalesced() const
+	{
+		return coalesced;
+	}
+	
+	void InputBuffer::releaseAll()
+	{
+		snapshot.keysReleased |= snapshot.keys;
+		snapshot.buttonsReleased |= snapshot.buttons;
+		snapshot.keys.reset();
+		snapshot.buttons.reset();
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef INPUTBUFFER_HPP
+#define INPUTBUFFER_HPP
+
+#include <vector>
+#include <bitset>
+#include <cstdint>
+
+#include <SFML/Window/Event.hpp>
+#include <SFML/Window/Keyboard.hpp>
+#include <SFML/Window/Mouse.hpp>
+#include <SFML/System/Vector2.hpp>
+
+namespace swift
+{
+	// a tick's window events, gathered before any are handled, then handled in one pass. Mouse moves with nothing
+	// between them only keep the last, and moves to where the mouse already is are dropped, so handling stays cheap
+	// under heavy dragging. Alongside the events is a snapshot of the input as of the end of the tick, for code that
+	// asks what's held instead of waiting for events, and for replays and networking to read
+	class InputBuffer
+	{
+		public:
+			struct Snapshot
+			{
+				std::bitset<sf::Keyboard::KeyCount> keys;			// held
+				std::bitset<sf::Keyboard::KeyCount> keysPressed;	// during the tick
+				std::bitset<sf::Keyboard::KeyCount> keysReleased;
+				
+				std::bitset<sf::Mouse::ButtonCount> buttons;
+				std::bitset<sf::Mouse::ButtonCount> buttonsPressed;
+				std::bitset<sf::Mouse::ButtonCount> buttonsReleased;
+				
+				sf::Vector2i mouse;		// in window pixels
+				sf::Vector2i mouseMoved;	// during the tick
+				int wheel;
+				
+				std::vector<std::uint32_t> text;	// characters entered during the tick
+				bool focused;
+			};
+			
+			InputBuffer();
+			
+			// starts a tick. What's held carries over
+			void begin();
+			void add(const sf::Event& event);
+			
+			// this tick's, in order, after coalescing
+			const std::vector<sf::Event>& getEvents() const;
+			const Snapshot& getSnapshot() const;
+			
+			// mouse moves merged into a later one or dropped, since starting
+			std::size_t getCoalesced() const;
+			
+			// held keys and buttons are let go, ex: when focus is lost and releases won't be seen
+			void releaseAll();
+		
+		private:
+			std::vector<sf::Event> events;
+			Snapshot snapshot;
+			
+			std::size_t coalesced;
+	};
+}
+
+#endif // INPUTBUFFER_HPP
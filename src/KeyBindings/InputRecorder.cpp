@@ -0,0 +1,365 @@
+#include "InputRecorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "../Serialization/ByteStream.hpp"
+#include "../Logger/Logger.hpp"
+
+namespace swift
+{
+	namespace
+	{
+		// the start of a recording, then the version of its layout
+		const char recordingMagic[4] = {'S', 'W', 'I', 'R'};
+		const std::uint32_t recordingVersion = 1;
+		
+		// only the event's own fields, by type, so recordings don't depend on the union's layout
+		void writeEvent(ByteWriter& out, const sf::Event& e)
+		{
+			out.writeUInt(e.type);
+			
+			switch(e.type)
+			{
+				case sf::Event::Resized:
+					out.writeUInt(e.size.width);
+					out.writeUInt(e.size.height);
+					break;
+				case sf::Event::TextEntered:
+					out.writeUInt(e.text.unicode);
+					break;
+				case sf::Event::KeyPressed:
+				case sf::Event::KeyReleased:
+					out.writeInt(e.key.code);
+					out.writeByte((e.key.alt ? 1 : 0) | (e.key.control ? 2 : 0) | (e.key.shift ? 4 : 0) | (e.key.system ? 8 : 0));
+					break;
+				case sf::Event::MouseWheelMoved:
+					out.writeInt(e.mouseWheel.delta);
+					out.writeInt(e.mouseWheel.x);
+					out.writeInt(e.mouseWheel.y);
+					break;
+				case sf::Event::MouseButtonPressed:
+				case sf::Event::MouseButtonReleased:
+					out.writeUInt(e.mouseButton.button);
+					out.writeInt(e.mouseButton.x);
+					out.writeInt(e.mouseButton.y);
+					break;
+				case sf::Event::MouseMoved:
+					out.writeInt(e.mouseMove.x);
+					out.writeInt(e.mouseMove.y);
+					break;
+				case sf::Event::JoystickButtonPressed:
+				case sf::Event::JoystickButtonReleased:
+					out.writeUInt(e.joystickButton.joystickId);
+					out.writeUInt(e.joystickButton.button);
+					break;
+				case sf::Event::JoystickMoved:
+					out.writeUInt(e.joystickMove.joystickId);
+					out.writeUInt(e.joystickMove.axis);
+					out.writeFloat(e.joystickMove.position);
+					break;
+				case sf::Event::JoystickConnected:
+				case sf::Event::JoystickDisconnected:
+					out.writeUInt(e.joystickConnect.joystickId);
+					break;
+				default:
+					break;
+			}
+		}
+		
+		bool readEvent(ByteReader& in, sf::Event& e)
+		{
+			std::uint64_t type = in.readUInt();
+			
+			if(type >= sf::Event::Count)
+				return false;
+			
+			e.type = static_cast<sf::Event::EventType>(type);
+			
+			switch(e.type)
+			{
+				case sf::Event::Resized:
+					e.size.width = static_cast<unsigned>(in.readUInt());
+					e.size.height = static_cast<unsigned>(in.readUInt());
+					break;
+				case sf::Event::TextEntered:
+					e.text.unicode = static_cast<sf::Uint32>(in.readUInt());
+					break;
+				case sf::Event::KeyPressed:
+				case sf::Event::KeyReleased:
+				{
+					e.key.code = static_cast<sf::Keyboard::Key>(in.readInt());
+					std::uint8_t modifiers = in.readByte();
+					e.key.alt = (modifiers & 1) != 0;
+					e.key.control = (modifiers & 2) != 0;
+					e.key.shift = (modifiers & 4) != 0;
+					e.key.system = (modifiers & 8) != 0;
+					break;
+				}
+				case sf::Event::MouseWheelMoved:
+					e.mouseWheel.delta = static_cast<int>(in.readInt());
+					e.mouseWheel.x = static_cast<int>(in.readInt());
+					e.mouseWheel.y = static_cast<int>(in.readInt());
+					break;
+				case sf::Event::MouseButtonPressed:
+				case sf::Event::MouseButtonReleased:
+					e.mouseButton.button = static_cast<sf::Mouse::Button>(in.readUInt());
+					e.mouseButton.x = static_cast<int>(in.readInt());
+					e.mouseButton.y = static_cast<int>(in.readInt());
+					break;
+				case sf::Event::MouseMoved:
+					e.mouseMove.x = static_cast<int>(in.readInt());
+					e.mouseMove.y = static_cast<int>(in.readInt());
+					break;
+				case sf::Event::JoystickButtonPressed:
+				case sf::Event::JoystickButtonReleased:
+					e.joystickButton.joystickId = static_cast<unsigned>(in.readUInt());
+					e.joystickButton.button = static_cast<unsigned>(in.readUInt());
+					break;
+				case sf::Event::JoystickMoved:
+					e.joystickMove.joystickId = static_cast<unsigned>(in.readUInt());
+					e.joystickMove.axis = static_cast<sf::Joystick::Axis>(in.readUInt());
+					e.joystickMove.position = in.readFloat();
+					break;
+				case sf::Event::JoystickConnected:
+				case sf::Event::JoystickDisconnected:
+					e.joystickConnect.joystickId = static_cast<unsigned>(in.readUInt());
+					break;
+				default:
+					break;
+			}
+			
+			return in.good();
+		}
+		
+		// mean, 99th percentile, and slowest, in microseconds
+		std::string describe(std::vector<std::uint32_t> times)
+		{
+			if(times.empty())
+				return "no ticks";
+			
+			std::uint64_t total = 0;
+			
+			for(auto& t : times)
+				total += t;
+			
+			std::sort(times.begin(), times.end());
+			
+			std::ostringstream out;
+			out << total / times.size() << " us mean, " << times[(times.size() - 1) * 99 / 100] << " us p99, " << times.back() << " us max";
+			return out.str();
+		}
+	}
+	
+	InputRecorder::InputRecorder()
+	:	mode(Mode::Off),
+		seed(0),
+		ticksPerSecond(0),
+		current(0),
+		nextEvent(0)
+	{
+	}
+	
+	void InputRecorder::record(std::uint32_t s, float tps)
+	{
+		mode = Mode::Recording;
+		seed = s;
+		ticksPerSecond = tps;
+		
+		ticks.clear();
+		events.clear();
+		replayed.clear();
+		
+		ticks.push_back({0, 0, 0});
+	}
+	
+	bool InputRecorder::load(const std::string& file)
+	{
+		mode = Mode::Off;
+		
+		std::ifstream fin(file, std::ios::binary);
+		
+		if(!fin)
+		{
+			SWIFT_ERROR(General, "Could not open recording \"" << file << "\".\n");
+			return false;
+		}
+		
+		std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		ByteReader reader(data);
+		
+		if(data.size() < 4 || std::memcmp(data.data(), recordingMagic, 4) != 0 || !reader.skip(4) || reader.readUInt() != recordingVersion)
+		{
+			SWIFT_ERROR(General, "\"" << file << "\" isn't a recording, or is of another version.\n");
+			return false;
+		}
+		
+		seed = static_cast<std::uint32_t>(reader.readUInt());
+		ticksPerSecond = reader.readFloat();
+		std::size_t tickCount = static_cast<std::size_t>(reader.readUInt());
+		
+		ticks.clear();
+		events.clear();
+		replayed.clear();
+		
+		// a tick takes at least a byte each for its time and event count
+		if(tickCount > reader.remaining() / 2)
+		{
+			SWIFT_ERROR(General, "Recording \"" << file << "\" is damaged.\n");
+			return false;
+		}
+		
+		ticks.reserve(tickCount);
+		
+		for(std::size_t t = 0; t < tickCount && reader.good(); t++)
+		{
+			Tick tick;
+			tick.firstEvent = static_cast<std::uint32_t>(events.size());
+			tick.microseconds = static_cast<std::uint32_t>(reader.readUInt());
+			tick.eventCount = static_cast<std::uint32_t>(reader.readUInt());
+			
+			for(std::uint32_t i = 0; i < tick.eventCount && reader.good(); i++)
+			{
+				sf::Event event;
+				std::memset(&event, 0, sizeof(event));
+				
+				if(!readEvent(reader, event))
+					reader.fail();
+				
+				events.push_back(event);
+			}
+			
+			ticks.push_back(tick);
+		}
+		
+		if(!reader.good())
+		{
+			SWIFT_ERROR(General, "Recording \"" << file << "\" is damaged.\n");
+			ticks.clear();
+			events.clear();
+			return false;
+		}
+		
+		mode = Mode::Replaying;
+		current = 0;
+		nextEvent = 0;
+		replayed.reserve(ticks.size());
+		
+		return true;
+	}
+	
+	bool InputRecorder::save(const std::string& file) const
+	{
+		ByteWriter writer;
+		writer.writeBytes(recordingMagic, 4);
+		writer.writeUInt(recordingVersion);
+		writer.writeUInt(seed);
+		writer.writeFloat(ticksPerSecond);
+		
+		// the tick being recorded when this was called isn't done
+		std::size_t tickCount = mode == Mode::Recording && !ticks.empty() ? ticks.size() - 1 : ticks.size();
+		writer.writeUInt(tickCount);
+		
+		for(std::size_t t = 0; t < tickCount; t++)
+		{
+			const Tick& tick = ticks[t];
+			writer.writeUInt(tick.microseconds);
+			writer.writeUInt(tick.eventCount);
+			
+			for(std::uint32_t i = 0; i < tick.eventCount; i++)
+				writeEvent(writer, events[tick.firstEvent + i]);
+		}
+		
+		std::ofstream fout(file, std::ios::binary);
+		
+		if(!fout)
+		{
+			SWIFT_ERROR(General, "Could not write recording \"" << file << "\".\n");
+			return false;
+		}
+		
+		fout.write(reinterpret_cast<const char*>(writer.getData().data()), writer.size());
+		
+		return static_cast<bool>(fout);
+	}
+	
+	InputRecorder::Mode InputRecorder::getMode() const
+	{
+		return mode;
+	}
+	
+	void InputRecorder::add(const sf::Event& event)
+	{
+		if(mode != Mode::Recording)
+			return;
+		
+		events.push_back(event);
+		ticks.back().eventCount++;
+	}
+	
+	bool InputRecorder::poll(sf::Event& event)
+	{
+		if(mode != Mode::Replaying || current >= ticks.size() || nextEvent >= ticks[current].eventCount)
+			return false;
+		
+		event = events[ticks[current].firstEvent + nextEvent];
+		nextEvent++;
+		
+		return true;
+	}
+	
+	void InputRecorder::endTick(sf::Time took)
+	{
+		std::uint32_t microseconds = static_cast<std::uint32_t>(std::max<sf::Int64>(took.asMicroseconds(), 0));
+		
+		if(mode == Mode::Recording)
+		{
+			ticks.back().microseconds = microseconds;
+			ticks.push_back({static_cast<std::uint32_t>(events.size()), 0, 0});
+		}
+		else if(mode == Mode::Replaying && current < ticks.size())
+		{
+			replayed.push_back(microseconds);
+			current++;
+			nextEvent = 0;
+		}
+	}
+	
+	bool InputRecorder::isFinished() const
+	{
+		return mode == Mode::Replaying && current >= ticks.size();
+	}
+	
+	std::uint32_t InputRecorder::getSeed() const
+	{
+		return seed;
+	}
+	
+	float InputRecorder::getTicksPerSecond() const
+	{
+		return ticksPerSecond;
+	}
+	
+	std::size_t InputRecorder::getTickCount() const
+	{
+		return mode == Mode::Recording && !ticks.empty() ? ticks.size() - 1 : ticks.size();
+	}
+	
+	std::string InputRecorder::getReport() const
+	{
+		std::vector<std::uint32_t> recorded;
+		
+		for(std::size_t t = 0; t < getTickCount(); t++)
+			recorded.push_back(ticks[t].microseconds);
+		
+		std::string report = std::to_string(recorded.size()) + " ticks recorded: " + describe(recorded);
+		
+		if(mode == Mode::Replaying)
+			report += ", " + std::to_string(replayed.size()) + " replayed: " + describe(replayed);
+		
+		return report;
+	}
+}
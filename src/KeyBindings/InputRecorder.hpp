@@ -0,0 +1,79 @@
+#ifndef INPUTRECORDER_HPP
+#define INPUTRECORDER_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <SFML/Window/Event.hpp>
+#include <SFML/System/Time.hpp>
+
+namespace swift
+{
+	// the window events each tick was given, with what randomness was seeded with and how long each tick took.
+	// keyboard and mouse bindings only change with events, so replaying the same events from the same seed, at the
+	// same tick rate, plays the session again, tick for tick. Replays run as fast as they can, so the time
+	// the replayed ticks took can be compared with the recording's, as a benchmark
+	class InputRecorder
+	{
+		public:
+			enum class Mode
+			{
+				Off,
+				Recording,
+				Replaying
+			};
+			
+			InputRecorder();
+			
+			// forgets what was recorded before
+			void record(std::uint32_t seed, float ticksPerSecond);
+			
+			// starts replaying from the first tick. false if the file isn't a recording, it's left Off then
+			bool load(const std::string& file);
+			bool save(const std::string& file) const;
+			
+			Mode getMode() const;
+			
+			// recording, one of this tick's events
+			void add(const sf::Event& event);
+			
+			// replaying, the next of this tick's events. false once the tick has no more
+			bool poll(sf::Event& event);
+			
+			// once a tick, after its events. Recording starts the next tick, replaying moves on to it
+			void endTick(sf::Time took);
+			
+			// every recorded tick has been replayed
+			bool isFinished() const;
+			
+			std::uint32_t getSeed() const;
+			float getTicksPerSecond() const;
+			std::size_t getTickCount() const;
+			
+			// recorded and replayed tick times, the mean, 99th percentile, and slowest of each
+			std::string getReport() const;
+		
+		private:
+			struct Tick
+			{
+				std::uint32_t firstEvent;	// into events
+				std::uint32_t eventCount;
+				std::uint32_t microseconds;
+			};
+			
+			Mode mode;
+			std::uint32_t seed;
+			float ticksPerSecond;
+			
+			std::vector<Tick> ticks;
+			std::vector<sf::Event> events;
+			
+			// replaying, the tick being replayed, how far into its events, and how long the replayed ticks took
+			std::size_t current;
+			std::uint32_t nextEvent;
+			std::vector<std::uint32_t> replayed;
+	};
+}
+
+#endif // INPUTRECORDER_HPP
@@ -2,6 +2,9 @@
 #define KEYBOARDMANAGER_HPP
 
 #include <map>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <string>
 #include <functional>
 
@@ -15,7 +18,44 @@ namespace swift
 		public:
 			void newBinding(const std::string& n, sf::Keyboard::Key k, std::function<void()> f = [](){return true;}, bool onPress = false)
 			{
-				bindings.emplace(std::make_pair(n, KeyBinding(k, f, onPress)));
+				auto added = bindings.emplace(std::make_pair(n, KeyBinding(k, f, onPress)));
+				
+				if(added.second)
+					index(added.first);
+			}
+			
+			// moves binding n to key k, doing what it did. False if there's no binding n
+			bool rebind(const std::string& n, sf::Keyboard::Key k)
+			{
+				auto it = bindings.find(n);
+				
+				if(it == bindings.end())
+					return false;
+				
+				unindex(it);
+				it->second.setKey(k);
+				index(it);
+				
+				return true;
+			}
+			
+			bool removeBinding(const std::string& n)
+			{
+				auto it = bindings.find(n);
+				
+				if(it == bindings.end())
+					return false;
+				
+				unindex(it);
+				bindings.erase(it);
+				
+				return true;
+			}
+			
+			// told the name of each binding a key event fires
+			void setListener(std::function<void(const std::string&)> l)
+			{
+				listener = l;
 			}
 			
 			void call(const std::string& k)
@@ -57,13 +97,21 @@ namespace swift
 					}
 				}
 				
-				for(auto& k : bindings)
-				{
-					if(k.second(e))
-						return k.second.call();
-				}
+				if(e.type != sf::Event::KeyPressed && e.type != sf::Event::KeyReleased)
+					return false;
+				
+				// the first binding by name fires, as if they were all checked in order
+				auto found = byKey.find(getSlot(e.key.code, e.type == sf::Event::KeyPressed));
+				
+				if(found == byKey.end() || found->second.empty())
+					return false;
 				
-				return false;
+				auto& k = *found->second.front();
+				
+				if(listener)
+					listener(k.first);
+				
+				return k.second.call();
 			}
 
 		private:
@@ -81,6 +129,16 @@ namespace swift
 					{
 						return key;
 					}
+					
+					void setKey(sf::Keyboard::Key k)
+					{
+						key = k;
+					}
+					
+					bool isOnPress() const
+					{
+						return onPress;
+					}
 
 					bool operator()(sf::Event& e)
 					{
@@ -105,7 +163,34 @@ namespace swift
 					bool onPress;	// if true, means if key is pressed, if false, means if key is released
 			};
 
-			std::map<std::string, KeyBinding> bindings;
+			using Bindings = std::map<std::string, KeyBinding>;
+			
+			// of a key, pressed or released
+			static unsigned getSlot(sf::Keyboard::Key k, bool press)
+			{
+				return static_cast<unsigned>(k + 1) * 2 + press;
+			}
+			
+			// each slot's bindings are kept in name order
+			void index(Bindings::iterator it)
+			{
+				auto& slot = byKey[getSlot(it->second.getKey(), it->second.isOnPress())];
+				
+				slot.insert(std::lower_bound(slot.begin(), slot.end(), it, [](Bindings::iterator one, Bindings::iterator two)
+				{
+					return one->first < two->first;
+				}), it);
+			}
+			
+			void unindex(Bindings::iterator it)
+			{
+				auto& slot = byKey[getSlot(it->second.getKey(), it->second.isOnPress())];
+				slot.erase(std::find(slot.begin(), slot.end(), it));
+			}
+			
+			Bindings bindings;
+			std::unordered_map<unsigned, std::vector<Bindings::iterator>> byKey;	// by getSlot, so events find theirs at once
+			std::function<void(const std::string&)> listener;
 			
 			bool shiftPressed;
 			bool ctrlPressed;
@@ -2,6 +2,9 @@
 #define MOUSEMANAGER_HPP
 
 #include <map>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <string>
 #include <functional>
 
@@ -15,7 +18,38 @@ namespace swift
 		public:
 			void newBinding(const std::string& n, sf::Mouse::Button b, std::function<void(const sf::Vector2i&)> f = [](const sf::Vector2i&){return true;}, bool onPress = false)
 			{
-				bindings.emplace(std::make_pair(n, ButtonBinding(b, f, onPress)));
+				auto added = bindings.emplace(std::make_pair(n, ButtonBinding(b, f, onPress)));
+				
+				if(added.second)
+					index(added.first);
+			}
+			
+			// moves binding n to button b, doing what it did. False if there's no binding n
+			bool rebind(const std::string& n, sf::Mouse::Button b)
+			{
+				auto it = bindings.find(n);
+				
+				if(it == bindings.end())
+					return false;
+				
+				unindex(it);
+				it->second.setButton(b);
+				index(it);
+				
+				return true;
+			}
+			
+			bool removeBinding(const std::string& n)
+			{
+				auto it = bindings.find(n);
+				
+				if(it == bindings.end())
+					return false;
+				
+				unindex(it);
+				bindings.erase(it);
+				
+				return true;
 			}
 			
 			void call(const std::string& k, const sf::Vector2i& pos)
@@ -25,13 +59,16 @@ namespace swift
 
 			bool operator()(sf::Event& e)
 			{
-				for(auto &b : bindings)
-				{
-					if(b.second(e))
-						return b.second.call({e.mouseButton.x, e.mouseButton.y});
-				}
+				if(e.type != sf::Event::MouseButtonPressed && e.type != sf::Event::MouseButtonReleased)
+					return false;
 				
-				return false;
+				// the first binding by name fires, as if they were all checked in order
+				auto found = byButton.find(getSlot(e.mouseButton.button, e.type == sf::Event::MouseButtonPressed));
+				
+				if(found == byButton.end() || found->second.empty())
+					return false;
+				
+				return found->second.front()->second.call({e.mouseButton.x, e.mouseButton.y});
 			}
 
 		private:
@@ -50,6 +87,16 @@ namespace swift
 						return button;
 					}
 
+					void setButton(sf::Mouse::Button b)
+					{
+						button = b;
+					}
+
+					bool isOnPress() const
+					{
+						return onPress;
+					}
+
 					bool operator()(sf::Event& e)
 					{
 						return ((e.type == sf::Event::MouseButtonPressed && onPress) || (e.type == sf::Event::MouseButtonReleased && !onPress)) && e.mouseButton.button == button;
@@ -73,7 +120,33 @@ namespace swift
 					bool onPress;	// if true, means if key is pressed, if false, means if key is released
 			};
 
-			std::map<std::string, ButtonBinding> bindings;
+			using Bindings = std::map<std::string, ButtonBinding>;
+
+			// of a button, pressed or released
+			static unsigned getSlot(sf::Mouse::Button b, bool press)
+			{
+				return static_cast<unsigned>(b) * 2 + press;
+			}
+
+			// each slot's bindings are kept in name order
+			void index(Bindings::iterator it)
+			{
+				auto& slot = byButton[getSlot(it->second.getButton(), it->second.isOnPress())];
+
+				slot.insert(std::lower_bound(slot.begin(), slot.end(), it, [](Bindings::iterator one, Bindings::iterator two)
+				{
+					return one->first < two->first;
+				}), it);
+			}
+
+			void unindex(Bindings::iterator it)
+			{
+				auto& slot = byButton[getSlot(it->second.getButton(), it->second.isOnPress())];
+				slot.erase(std::find(slot.begin(), slot.end(), it));
+			}
+
+			Bindings bindings;
+			std::unordered_map<unsigned, std::vector<Bindings::iterator>> byButton;	// by getSlot, so events find theirs at once
 
 	};
 }
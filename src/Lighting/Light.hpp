@@ -1,17 +1,20 @@
 #ifndef LIGHT_HPP
 #define LIGHT_HPP
 
-class Light
-{
-	public:
-		Light();
-		Light(const int Radius, const sf::Color Color, const int PosX, const int PosY, bool IsBinded = 0, int UnitVecID = 0);
-		int radius;
-		sf::Color color;
-		int posX, posY;
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Texture.hpp>
 
-		bool isBindedToUnit;
-		int unitVecID;
-};
+namespace swift
+{
+	// one frame's worth of a light, see LightMap
+	struct Light
+	{
+		sf::Vector2f position;		// center
+		float radius;
+		sf::Color color;			// alpha scales the brightness
+		const sf::Texture* texture;	// what the light looks like, stretched over its radius. nullptr for a round falloff
+	};
+}
 
-#endif // LIGHT_HPP
\ No newline at end of file
+#endif // LIGHT_HPP
@@ -0,0 +1,185 @@
+#include "LightMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+
+#include "../Profiling/FrameStats.hpp"
+
+namespace swift
+{
+	LightMap::LightMap()
+	:	ambient(sf::Color::White),
+		scale(4),
+		lightCount(0)
+	{}
+	
+	void LightMap::setAmbient(const sf::Color& a)
+	{
+		ambient = a;
+	}
+	
+	const sf::Color& LightMap::getAmbient() const
+	{
+		return ambient;
+	}
+	
+	void LightMap::setScale(unsigned s)
+	{
+		scale = std::max(s, 1u);
+	}
+	
+	void LightMap::begin(const sf::View& v, const sf::Vector2u& size, const sf::Transform& t)
+	{
+		view = v;
+		transform = t;
+		
+		// what the view shows, in the lights' coordinates
+		visible = view.getInverseTransform().transformRect({-1, -1, 2, 2});
+		visible = transform.getInverse().transformRect(visible);
+		
+		sf::Vector2u mapSize(std::max(size.x / scale, 1u), std::max(size.y / scale, 1u));
+		
+		if(!lightTexture)
+			lightTexture.reset(new sf::RenderTexture);
+		
+		if(lightTexture->getSize() != mapSize)
+		{
+			lightTexture->create(mapSize.x, mapSize.y);
+			lightTexture->setSmooth(true);
+		}
+		
+		for(auto& b : batches)
+			b.vertices.clear();
+		
+		lightCount = 0;
+	}
+	
+	void LightMap::add(const Light& light)
+	{
+		sf::FloatRect bounds(light.position.x - light.radius, light.position.y - light.radius, light.radius * 2, light.radius * 2);
+		
+		if(light.radius <= 0 || !bounds.intersects(visible))
+			return;
+		
+		const sf::Texture* texture = light.texture ? light.texture : getFalloff();
+		
+		// there are only ever a few kinds of lights
+		auto batch = std::find_if(batches.begin(), batches.end(), [texture](const Batch& b)
+		{
+			return b.texture == texture;
+		});
+		
+		if(batch == batches.end())
+		{
+			batches.push_back({texture, {}});
+			batch = batches.end() - 1;
+		}
+		
+		float right = bounds.left + bounds.width;
+		float bottom = bounds.top + bounds.height;
+		sf::Vector2f texSize(texture->getSize());
+		
+		batch->vertices.emplace_back(sf::Vector2f(bounds.left, bounds.top), light.color, sf::Vector2f(0, 0));
+		batch->vertices.emplace_back(sf::Vector2f(right, bounds.top), light.color, sf::Vector2f(texSize.x, 0));
+		batch->vertices.emplace_back(sf::Vector2f(right, bottom), light.color, texSize);
+		batch->vertices.emplace_back(sf::Vector2f(bounds.left, bottom), light.color, sf::Vector2f(0, texSize.y));
+		
+		lightCount++;
+	}
+	
+	void LightMap::end()
+	{
+		if(!lightTexture)
+			return;
+		
+		lightTexture->setView(view);
+		lightTexture->clear(ambient);
+		
+		// overlapping lights add up
+		sf::RenderStates states(sf::BlendAdd, transform, nullptr, nullptr);
+		
+		for(auto& b : batches)
+		{
+			if(b.vertices.empty())
+				continue;
+			
+			states.texture = b.texture;
+			lightTexture->draw(&b.vertices[0], b.vertices.size(), sf::PrimitiveType::Quads, states);
+			FrameStats::countDraw(FrameStats::Draws::Lights, b.vertices.size());
+		}
+		
+		lightTexture->display();
+	}
+	
+	std::size_t LightMap::getLightCount() const
+	{
+		return lightCount;
+	}
+	
+	std::size_t LightMap::getBatchCount() const
+	{
+		return std::count_if(batches.begin(), batches.end(), [](const Batch& b)
+		{
+			return !b.vertices.empty();
+		});
+	}
+	
+	void LightMap::draw(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		if(!lightTexture)
+			return;
+		
+		sf::Vector2f mapSize(lightTexture->getSize());
+		
+		if(mapSize.x == 0 || mapSize.y == 0)
+			return;
+		
+		// stretched back over the view
+		sf::Sprite sprite(lightTexture->getTexture());
+		sprite.setOrigin(mapSize / 2.f);
+		sprite.setPosition(view.getCenter());
+		sprite.setScale(view.getSize().x / mapSize.x, view.getSize().y / mapSize.y);
+		sprite.setRotation(view.getRotation());
+		
+		// the lights were already transformed, the map covers the view as it is
+		states.transform = sf::Transform::Identity;
+		states.blendMode = sf::BlendMultiply;
+		
+		target.draw(sprite, states);
+		FrameStats::countDraw(FrameStats::Draws::Lights, 4);
+	}
+	
+	const sf::Texture* LightMap::getFalloff()
+	{
+		if(falloff)
+			return falloff.get();
+		
+		const unsigned size = 128;
+		
+		sf::Image image;
+		image.create(size, size, sf::Color::Transparent);
+		
+		for(unsigned y = 0; y < size; y++)
+		{
+			for(unsigned x = 0; x < size; x++)
+			{
+				float dx = (x + 0.5f) / size * 2 - 1;
+				float dy = (y + 0.5f) / size * 2 - 1;
+				
+				// squared, so the light fades out softly at the edge
+				float brightness = std::max(1 - std::sqrt(dx * dx + dy * dy), 0.f);
+				
+				image.setPixel(x, y, sf::Color(255, 255, 255, static_cast<sf::Uint8>(brightness * brightness * 255)));
+			}
+		}
+		
+		falloff.reset(new sf::Texture);
+		falloff->loadFromImage(image);
+		falloff->setSmooth(true);
+		
+		return falloff.get();
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef LIGHTMAP_HPP
+#define LIGHTMAP_HPP
+
+#include <vector>
+#include <memory>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/View.hpp>
+
+#include "Light.hpp"
+
+namespace swift
+{
+	// lights added up into a texture smaller than the target, which is then multiplied over what's been drawn.
+	// lights sharing a texture are drawn together in one draw call, and lights outside of the view are skipped
+	class LightMap : public sf::Drawable
+	{
+		public:
+			LightMap();
+			
+			// what unlit areas are multiplied by
+			void setAmbient(const sf::Color& a);
+			const sf::Color& getAmbient() const;
+			
+			// the light map is 1 / s the size of the target, lights are soft anyway
+			void setScale(unsigned s);
+			
+			// starts a new light map covering view, for a target size pixels big. transform is the
+			// one the world is drawn with
+			void begin(const sf::View& view, const sf::Vector2u& size, const sf::Transform& transform = sf::Transform::Identity);
+			
+			// skipped if it doesn't reach the view
+			void add(const Light& light);
+			
+			// renders the lights added since begin into the light map
+			void end();
+			
+			// lights drawn in the last light map, and the draw calls they took
+			std::size_t getLightCount() const;
+			std::size_t getBatchCount() const;
+		
+		private:
+			// the light map, covering the view it was rendered with
+			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+			
+			// white, fading out from the middle
+			const sf::Texture* getFalloff();
+			
+			struct Batch
+			{
+				const sf::Texture* texture;
+				std::vector<sf::Vertex> vertices;	// kept between frames, so a refilled batch doesn't allocate
+			};
+			
+			std::vector<Batch> batches;
+			
+			// made when first used, so worlds that are never drawn don't need a graphics context
+			std::unique_ptr<sf::RenderTexture> lightTexture;
+			std::unique_ptr<sf::Texture> falloff;
+			
+			sf::Color ambient;
+			unsigned scale;
+			
+			sf::View view;
+			sf::Transform transform;
+			sf::FloatRect visible;	// the view, in the lights' coordinates
+			
+			std::size_t lightCount;
+	};
+}
+
+#endif // LIGHTMAP_HPP
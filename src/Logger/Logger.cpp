@@ -1,6 +1,320 @@
 #include "Logger.hpp"
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
 namespace swift
 {
 	Logger log("Swift2");
-}
\ No newline at end of file
+
+	namespace
+	{
+		// for the terminate handler, which can't be given one
+		Logger* crashLog = nullptr;
+		std::terminate_handler previousHandler = nullptr;
+
+		void onTerminate()
+		{
+			if(crashLog)
+				crashLog->flush();
+
+			if(previousHandler)
+				previousHandler();
+
+			std::abort();
+		}
+
+		const std::chrono::milliseconds WritePeriod(50);
+	}
+
+	Logger::Logger(const std::string& header, const std::string& logFile)
+	:	categories((1u << CategoryCount) - 1),
+		warnings(0),
+		errors(0),
+		running(true),
+		asked(0),
+		done(0)
+	{
+		fout.open(logFile);
+
+		// Write the first lines
+		if(fout.is_open())
+		{
+			fout << header << "\n\n";
+			fout.flush();
+		}
+
+		sf::err().rdbuf(0);
+
+		crashLog = this;
+		previousHandler = std::set_terminate(&onTerminate);
+
+		writer = std::thread(&Logger::run, this);
+	}
+
+	Logger::~Logger()
+	{
+		{
+			std::lock_guard<std::mutex> lock(flushMutex);
+			running = false;
+		}
+
+		wake.notify_one();
+		flushed.notify_all();
+		writer.join();
+
+		// what was queued after the writer's last look
+		drain();
+
+		if(crashLog == this)
+		{
+			std::set_terminate(previousHandler);
+			crashLog = nullptr;
+		}
+
+		if(fout.is_open())
+		{
+			fout << std::endl << std::endl;
+
+			// Report number of errors and warnings
+			fout << warnings << " warnings" << std::endl;
+			fout << errors << " errors" << std::endl;
+
+			fout.close();
+		}
+	}
+
+	Logger& Logger::operator<<(Level level)
+	{
+		Buffer& b = getBuffer();
+		b.level = level;
+
+		if(level == Debug)
+			b.line += "[DEBUG] ";
+		else if(level == Warning)
+			b.line += "[WARNING] ";
+		else if(level == Error)
+			b.line += "[ERROR] ";
+
+		return *this;
+	}
+
+	Logger& Logger::operator<<(Category category)
+	{
+		Buffer& b = getBuffer();
+		b.line += getName(category);
+		b.line += ": ";
+
+		return *this;
+	}
+
+	Logger& Logger::operator<<(char c)
+	{
+		append(&c, 1);
+		return *this;
+	}
+
+	Logger& Logger::operator<<(const std::string& text)
+	{
+		append(text.c_str(), text.size());
+		return *this;
+	}
+
+	Logger& Logger::operator<<(const char* text)
+	{
+		append(text, std::char_traits<char>::length(text));
+		return *this;
+	}
+
+	Logger& Logger::operator<<(int n)
+	{
+		return *this << std::to_string(n);
+	}
+
+	Logger& Logger::operator<<(unsigned n)
+	{
+		return *this << std::to_string(n);
+	}
+
+	Logger& Logger::operator<<(std::size_t n)
+	{
+		return *this << std::to_string(n);
+	}
+
+	Logger& Logger::operator<<(float n)
+	{
+		return *this << static_cast<double>(n);
+	}
+
+	Logger& Logger::operator<<(double n)
+	{
+		// as an ostream would write it
+		char text[32];
+		int size = std::snprintf(text, sizeof(text), "%g", n);
+
+		if(size > 0)
+			append(text, static_cast<std::size_t>(size));
+
+		return *this;
+	}
+
+	void Logger::flush()
+	{
+		std::unique_lock<std::mutex> lock(flushMutex);
+
+		if(!running)
+		{
+			lock.unlock();
+			drain();
+			return;
+		}
+
+		unsigned ask = ++asked;
+		wake.notify_one();
+		flushed.wait(lock, [&]()
+		{
+			return done >= ask || !running;
+		});
+	}
+
+	bool Logger::isEnabled(Category category) const
+	{
+		return (categories.load(std::memory_order_relaxed) >> category) & 1;
+	}
+
+	void Logger::setEnabled(Category category, bool enabled)
+	{
+		if(enabled)
+			categories.fetch_or(1u << category, std::memory_order_relaxed);
+		else
+			categories.fetch_and(~(1u << category), std::memory_order_relaxed);
+	}
+
+	const char* Logger::getName(Category category)
+	{
+		static const char* names[] = {"General", "Assets", "Audio", "Entities", "Pathfinding", "Scripting", "World"};
+		return category < CategoryCount ? names[category] : "Unknown";
+	}
+
+	bool Logger::findCategory(const std::string& n, Category& category)
+	{
+		for(unsigned c = 0; c < CategoryCount; c++)
+		{
+			if(n == getName(static_cast<Category>(c)))
+			{
+				category = static_cast<Category>(c);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	Logger::Buffer& Logger::getBuffer()
+	{
+		struct Local
+		{
+			Logger* owner = nullptr;
+			std::shared_ptr<Buffer> buffer;
+		};
+
+		static thread_local Local local;
+
+		if(local.owner != this)
+		{
+			local.owner = this;
+			local.buffer = std::make_shared<Buffer>();
+
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffers.push_back(local.buffer);
+		}
+
+		return *local.buffer;
+	}
+
+	void Logger::append(const char* text, std::size_t size)
+	{
+		Buffer& b = getBuffer();
+		b.line.append(text, size);
+
+		if(size > 0 && text[size - 1] == '\n')
+			endLine(b);
+	}
+
+	void Logger::endLine(Buffer& b)
+	{
+		Level level = b.level;
+
+		if(level == Warning)
+			warnings++;
+		else if(level == Error)
+			errors++;
+
+		// the writer's behind, wait on it rather than lose the line
+		while(!b.lines.push(std::move(b.line)))
+		{
+			if(running)
+				std::this_thread::yield();
+			else
+				drain();
+		}
+
+		b.line.clear();
+		b.level = Info;
+
+		if(level == Error)
+			flush();
+	}
+
+	void Logger::run()
+	{
+		std::unique_lock<std::mutex> lock(flushMutex);
+
+		while(running)
+		{
+			unsigned ask = asked;
+
+			lock.unlock();
+			drain();
+			lock.lock();
+
+			done = ask;
+			flushed.notify_all();
+
+			wake.wait_for(lock, WritePeriod, [&]()
+			{
+				return asked != done || !running;
+			});
+		}
+	}
+
+	void Logger::drain()
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+
+		bool wrote = false;
+		std::string line;
+
+		for(auto it = buffers.begin(); it != buffers.end();)
+		{
+			// looked at first, its thread may queue a last line then go
+			bool gone = it->use_count() == 1;
+
+			while((*it)->lines.pop(line))
+			{
+				fout << line;
+				wrote = true;
+			}
+
+			if(gone)
+				it = buffers.erase(it);
+			else
+				++it;
+		}
+
+		if(wrote)
+			fout.flush();
+	}
+}
@@ -3,116 +3,172 @@
 
 #include <fstream>
 #include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 #include <SFML/System/Err.hpp>
 
+#include "../Threading/SpscQueue.hpp"
+
+// levels below SWIFT_LOG_LEVEL compile to nothing, their messages aren't even evaluated
+#define SWIFT_LOG_DEBUG 0
+#define SWIFT_LOG_INFO 1
+#define SWIFT_LOG_WARNING 2
+#define SWIFT_LOG_ERROR 3
+
+#ifndef SWIFT_LOG_LEVEL
+	#ifdef NDEBUG
+		#define SWIFT_LOG_LEVEL SWIFT_LOG_INFO
+	#else
+		#define SWIFT_LOG_LEVEL SWIFT_LOG_DEBUG
+	#endif
+#endif
+
+// the message is a << chain: SWIFT_WARNING(Assets, "Unable to load " << file << '\n').
+// It's only evaluated if the category is enabled
+#define SWIFT_LOG(level, category, ...) \
+	do \
+	{ \
+		if(::swift::log.isEnabled(::swift::Logger::category)) \
+			::swift::log << ::swift::Logger::level << ::swift::Logger::category << __VA_ARGS__; \
+	} \
+	while(false)
+
+#if SWIFT_LOG_LEVEL <= SWIFT_LOG_DEBUG
+	#define SWIFT_DEBUG(category, ...) SWIFT_LOG(Debug, category, __VA_ARGS__)
+#else
+	#define SWIFT_DEBUG(category, ...) do {} while(false)
+#endif
+
+#if SWIFT_LOG_LEVEL <= SWIFT_LOG_INFO
+	#define SWIFT_INFO(category, ...) SWIFT_LOG(Info, category, __VA_ARGS__)
+#else
+	#define SWIFT_INFO(category, ...) do {} while(false)
+#endif
+
+#if SWIFT_LOG_LEVEL <= SWIFT_LOG_WARNING
+	#define SWIFT_WARNING(category, ...) SWIFT_LOG(Warning, category, __VA_ARGS__)
+#else
+	#define SWIFT_WARNING(category, ...) do {} while(false)
+#endif
+
+#define SWIFT_ERROR(category, ...) SWIFT_LOG(Error, category, __VA_ARGS__)
+
 namespace swift
 {
+	// lines are built up in a buffer of the thread writing them, and queued without a lock once they end
+	// in '\n'. A thread of the logger's own writes them out in batches, flushing once per batch.
+	// An error line waits for everything queued before it to be on disk, as does a crash
 	class Logger
 	{
 		public:
-			explicit Logger(const std::string& header, const std::string& logFile = "./data/swift.log")
+			// starts a line with its tag, and counts it for the report at the end
+			enum Level
 			{
-				warnings = 0;
-				errors = 0;
-
-				fout.open(logFile);
-
-				// Write the first lines
-				if(fout.is_open())
-				{
-					fout << header << "\n\n";
-				}
-				
-				sf::err().rdbuf(0);
-			}
-
-			~Logger()
+				Debug,
+				Info,
+				Warning,
+				Error
+			};
+			
+			// what a message is about, each can be turned off at runtime
+			enum Category
 			{
-				if(fout.is_open())
-				{
-					fout << std::endl << std::endl;
-
-					// Report number of errors and warnings
-					fout << warnings << " warnings" << std::endl;
-					fout << errors << " errors" << std::endl;
-
-					fout.close();
-				}
-			}
-
+				General,
+				Assets,
+				Audio,
+				Entities,
+				Pathfinding,
+				Scripting,
+				World,
+				CategoryCount
+			};
+			
+			explicit Logger(const std::string& header, const std::string& logFile = "./data/swift.log");
+			~Logger();
+			
 			// Make it Non Copyable
 			Logger(const Logger&) = delete;
 			Logger& operator=(const Logger&) = delete;
-
-			Logger& operator<<(char c)
-			{
-				fout << c;
-				return *this;
-			}
-
-			Logger& operator<<(const std::string& text)
-			{
-				fout << text;
-				fout.flush();
-				
-				if(text.find("[ERROR]") != std::string::npos)
-					errors++;
-				if(text.find("[WARNING]") != std::string::npos)
-					warnings++;
-				
-				return *this;
-			}
 			
-			Logger& operator<<(const char* t)
+			Logger& operator<<(Level level);
+			Logger& operator<<(Category category);
+			
+			Logger& operator<<(char c);
+			Logger& operator<<(const std::string& text);
+			Logger& operator<<(const char* text);
+			
+			Logger& operator<<(int n);
+			Logger& operator<<(unsigned n);
+			Logger& operator<<(std::size_t n);
+			Logger& operator<<(float n);
+			Logger& operator<<(double n);
+			
+			// returns once every line queued so far is written and flushed
+			void flush();
+			
+			// all are enabled to start with
+			bool isEnabled(Category category) const;
+			void setEnabled(Category category, bool enabled);
+			
+			static const char* getName(Category category);
+			
+			// false if there's no category named n
+			static bool findCategory(const std::string& n, Category& category);
+		
+		private:
+			static const std::size_t LinesPerThread = 256;	// queued before a thread waits on the writer
+			
+			struct Buffer
 			{
-				std::string text = t;
-				fout << text;
-				fout.flush();
+				Buffer()
+				:	lines(LinesPerThread),
+					level(Info)
+				{}
 				
-				if(text.find("[ERROR]") != std::string::npos)
-					errors++;
-				if(text.find("[WARNING]") != std::string::npos)
-					warnings++;
+				SpscQueue<std::string> lines;
 				
-				return *this;
-			}
-
-			Logger& operator<<(int n)
-			{
-				fout << n;
-				return *this;
-			}
-
-			Logger& operator<<(unsigned n)
-			{
-				fout << n;
-				return *this;
-			}
+				// the line being built, only its thread touches these
+				std::string line;
+				Level level;
+			};
+			
+			// this thread's buffer, made the first time it logs
+			Buffer& getBuffer();
+			
+			// queues the line if text ended it
+			void append(const char* text, std::size_t size);
+			void endLine(Buffer& b);
+			
+			void run();
+			
+			// writes out every queued line, on the writer, or once it's stopped
+			void drain();
 			
-			Logger& operator<<(std::size_t n)
-			{
-				fout << n;
-				return *this;
-			}
-
-			Logger& operator<<(float n)
-			{
-				fout << n;
-				return *this;
-			}
-
-			Logger& operator<<(double n)
-			{
-				fout << n;
-				return *this;
-			}
-
-		private:
 			std::ofstream fout;
-
-			unsigned warnings;
-			unsigned errors;
+			
+			std::atomic<unsigned> categories;	// bit per enabled category
+			
+			std::atomic<unsigned> warnings;
+			std::atomic<unsigned> errors;
+			
+			// buffers of every thread that's logged, guarded by buffersMutex
+			std::vector<std::shared_ptr<Buffer>> buffers;
+			std::mutex buffersMutex;
+			
+			std::thread writer;
+			std::atomic<bool> running;
+			
+			// asked and done are flush counts, guarded by flushMutex
+			std::mutex flushMutex;
+			std::condition_variable wake;
+			std::condition_variable flushed;
+			unsigned asked;
+			unsigned done;
 	};
 	
 	extern Logger log;
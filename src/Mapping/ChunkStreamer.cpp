@@ -0,0 +1,251 @@
+#include "ChunkStreamer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace swift
+{
+	namespace
+	{
+		// skips to the next multiple of a from the start of the file, then points at bytes raw bytes
+		const std::uint8_t* readRaw(ByteReader& reader, const std::uint8_t* file, std::size_t bytes, std::size_t a)
+		{
+			reader.skip((a - reader.getPosition() % a) % a);
+			const std::uint8_t* p = file + reader.getPosition();
+			
+			return reader.skip(bytes) ? p : nullptr;
+		}
+		
+		void align(ByteWriter& writer, std::size_t a)
+		{
+			while(writer.size() % a != 0)
+				writer.writeByte(0);
+		}
+	}
+	
+	ChunkStreamer::ChunkStreamer()
+	:	reading(false),
+		currentCancelled(false),
+		stopping(false)
+	{
+	}
+	
+	ChunkStreamer::~ChunkStreamer()
+	{
+		close();
+	}
+	
+	bool ChunkStreamer::open(const std::string& f)
+	{
+		close();
+		
+		if(!file.open(f))
+			return false;
+		
+		stopping = false;
+		worker = std::thread(&ChunkStreamer::work, this);
+		
+		return true;
+	}
+	
+	void ChunkStreamer::close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+			requests.clear();
+		}
+		
+		wake.notify_all();
+		
+		if(worker.joinable())
+			worker.join();
+		
+		done.clear();
+		reading = false;
+		file.close();
+	}
+	
+	bool ChunkStreamer::isOpen() const
+	{
+		return file.isOpen();
+	}
+	
+	const MappedFile& ChunkStreamer::getFile() const
+	{
+		return file;
+	}
+	
+	void ChunkStreamer::request(unsigned layer, unsigned index, std::uint64_t offset, float priority)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			if(reading && current.layer == layer && current.index == index)
+			{
+				currentCancelled = false;
+				return;
+			}
+			
+			for(auto& d : done)
+			{
+				if(d.layer == layer && d.index == index)
+					return;
+			}
+			
+			for(auto& r : requests)
+			{
+				if(r.layer == layer && r.index == index)
+				{
+					r.priority = priority;
+					return;
+				}
+			}
+			
+			requests.push_back({layer, index, offset, priority});
+		}
+		
+		wake.notify_one();
+	}
+	
+	void ChunkStreamer::cancel(unsigned layer, unsigned index)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		auto matches = [layer, index](const Request& r)
+		{
+			return r.layer == layer && r.index == index;
+		};
+		
+		requests.erase(std::remove_if(requests.begin(), requests.end(), matches), requests.end());
+		
+		done.erase(std::remove_if(done.begin(), done.end(), [layer, index](const Chunk& c)
+		{
+			return c.layer == layer && c.index == index;
+		}), done.end());
+		
+		if(reading && matches(current))
+			currentCancelled = true;
+	}
+	
+	bool ChunkStreamer::collect(Chunk& chunk)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		if(done.empty())
+			return false;
+		
+		chunk = std::move(done.back());
+		done.pop_back();
+		
+		return true;
+	}
+	
+	std::size_t ChunkStreamer::getPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return requests.size() + (reading ? 1 : 0);
+	}
+	
+	void ChunkStreamer::write(ByteWriter& writer, const std::vector<std::uint16_t>& ids, const std::vector<unsigned>& animated, const sf::VertexArray& vertices)
+	{
+		writer.writeUInt(ids.size());
+		align(writer, sizeof(std::uint16_t));
+		writer.writeBytes(ids.data(), ids.size() * sizeof(std::uint16_t));
+		
+		writer.writeUInt(animated.size());
+		
+		for(auto& a : animated)
+			writer.writeUInt(a);
+		
+		std::size_t count = vertices.getVertexCount();
+		
+		writer.writeUInt(count);
+		align(writer, alignof(sf::Vertex));
+		
+		if(count != 0)
+			writer.writeBytes(&vertices[0], count * sizeof(sf::Vertex));
+	}
+	
+	bool ChunkStreamer::read(ByteReader& reader, const std::uint8_t* f, std::vector<std::uint16_t>& ids, std::vector<unsigned>& animated, sf::VertexArray& vertices)
+	{
+		std::uint64_t numIDs = reader.readUInt();
+		const std::uint8_t* rawIDs = numIDs <= reader.remaining() ? readRaw(reader, f, numIDs * sizeof(std::uint16_t), sizeof(std::uint16_t)) : nullptr;
+		
+		if(!rawIDs)
+			return false;
+		
+		ids.resize(numIDs);
+		
+		if(numIDs != 0)
+			std::memcpy(ids.data(), rawIDs, numIDs * sizeof(std::uint16_t));
+		
+		std::uint64_t numAnimated = reader.readUInt();
+		
+		if(numAnimated > reader.remaining())
+			return false;
+		
+		animated.resize(numAnimated);
+		
+		for(auto& a : animated)
+			a = reader.readUInt();
+		
+		std::uint64_t count = reader.readUInt();
+		const std::uint8_t* rawVertices = count <= reader.remaining() ? readRaw(reader, f, count * sizeof(sf::Vertex), alignof(sf::Vertex)) : nullptr;
+		
+		if(!rawVertices || !reader.good())
+			return false;
+		
+		vertices.setPrimitiveType(sf::PrimitiveType::Quads);
+		vertices.resize(count);
+		
+		if(count != 0)
+			std::memcpy(&vertices[0], rawVertices, count * sizeof(sf::Vertex));
+		
+		return true;
+	}
+	
+	void ChunkStreamer::work()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		while(true)
+		{
+			wake.wait(lock, [this]()
+			{
+				return stopping || !requests.empty();
+			});
+			
+			if(stopping)
+				return;
+			
+			// closest first
+			auto next = std::min_element(requests.begin(), requests.end(), [](const Request& one, const Request& two)
+			{
+				return one.priority < two.priority;
+			});
+			
+			current = *next;
+			requests.erase(next);
+			reading = true;
+			currentCancelled = false;
+			
+			lock.unlock();
+			
+			// touching the mapped pages is what reads them from disk
+			Chunk chunk;
+			chunk.layer = current.layer;
+			chunk.index = current.index;
+			
+			ByteReader reader(file.getData(), file.getSize());
+			chunk.good = reader.skip(current.offset) && read(reader, file.getData(), chunk.ids, chunk.animated, chunk.vertices);
+			
+			lock.lock();
+			
+			reading = false;
+			
+			if(!currentCancelled && !stopping)
+				done.push_back(std::move(chunk));
+		}
+	}
+}
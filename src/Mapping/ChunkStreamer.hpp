@@ -0,0 +1,97 @@
+#ifndef CHUNKSTREAMER_HPP
+#define CHUNKSTREAMER_HPP
+
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "../Serialization/MappedFile.hpp"
+#include "../Serialization/ByteStream.hpp"
+
+namespace swift
+{
+	// reads chunks of a compiled map out of its mapped file on a background thread, so the pages they're in
+	// are read from disk off the ticking thread. Chunks are requested by the file offset of their record,
+	// and collected once read, in update. Closer chunks, with lower priorities, are read first
+	class ChunkStreamer
+	{
+		public:
+			struct Chunk
+			{
+				unsigned layer;
+				unsigned index;
+				std::vector<std::uint16_t> ids;		// as Layer keeps them
+				std::vector<unsigned> animated;
+				sf::VertexArray vertices;
+				bool good;							// false if the record was damaged
+			};
+			
+			ChunkStreamer();
+			~ChunkStreamer();
+			
+			ChunkStreamer(const ChunkStreamer&) = delete;
+			ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+			
+			// maps file, and starts the thread. Closes whatever was open first
+			bool open(const std::string& file);
+			
+			// drops every request and result, and unmaps the file
+			void close();
+			
+			bool isOpen() const;
+			
+			// the whole file, for reading its header
+			const MappedFile& getFile() const;
+			
+			// ignored if the chunk is already requested, only its priority changes
+			void request(unsigned layer, unsigned index, std::uint64_t offset, float priority);
+			
+			// drops the request, or its result if already read
+			void cancel(unsigned layer, unsigned index);
+			
+			// hands over a chunk that has been read, false if there are none
+			bool collect(Chunk& chunk);
+			
+			std::size_t getPendingCount() const;
+			
+			// the record of one chunk, as TileMap::saveBinary writes them. Raw arrays are aligned to the start of the file
+			static void write(ByteWriter& writer, const std::vector<std::uint16_t>& ids, const std::vector<unsigned>& animated, const sf::VertexArray& vertices);
+			
+			// reads a record written by write. file is the start of the file reader reads from
+			static bool read(ByteReader& reader, const std::uint8_t* file, std::vector<std::uint16_t>& ids, std::vector<unsigned>& animated, sf::VertexArray& vertices);
+		
+		private:
+			struct Request
+			{
+				unsigned layer;
+				unsigned index;
+				std::uint64_t offset;
+				float priority;
+			};
+			
+			void work();
+			
+			MappedFile file;
+			
+			std::vector<Request> requests;
+			std::vector<Chunk> done;
+			
+			// the request being read now, if it's cancelled meanwhile its result is thrown away
+			bool reading;
+			Request current;
+			bool currentCancelled;
+			
+			mutable std::mutex mutex;
+			std::condition_variable wake;
+			bool stopping;
+			
+			std::thread worker;
+	};
+}
+
+#endif // CHUNKSTREAMER_HPP
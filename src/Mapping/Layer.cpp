@@ -1,49 +1,570 @@
 #include "Layer.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+
+#include "../Profiling/FrameStats.hpp"
+
 namespace swift
 {
-	Layer::Layer(const sf::Vector2u& s, const sf::Vector2u& ts)
-	:	vertices(sf::PrimitiveType::Quads),
+	namespace
+	{
+		// versions are unique over all layers, so a reloaded map never matches a copy of the old one.
+		// Worlds ticking on several threads stream chunks in and out at once
+		std::atomic<unsigned> nextVersion(0);
+		
+		unsigned newVersion()
+		{
+			return nextVersion.fetch_add(1) + 1;
+		}
+	}
+	
+	// std::min takes them by reference
+	const unsigned Layer::CHUNK_SIZE;
+	const int Layer::MAX_ID;
+	
+	Layer::Layer(const sf::Vector2u& s, const sf::Vector2u& ts, bool str)
+	:	chunkCount((s.x + CHUNK_SIZE - 1) / CHUNK_SIZE, (s.y + CHUNK_SIZE - 1) / CHUNK_SIZE),
+		numTiles(str ? s.x * s.y : 0),
+		streamed(str),
+		version(newVersion()),
 		size(s),
 		tileSize(ts)
 	{
-		vertices.resize(size.x * size.y * 4);
+		// nothing is known about tiles that aren't loaded, so nothing may enter them
+		passability.resize(s, !streamed);
+		
+		chunks.resize(chunkCount.x * chunkCount.y);
+		
+		for(unsigned c = 0; c < chunks.size(); c++)
+		{
+			unsigned left = c % chunkCount.x * CHUNK_SIZE;
+			unsigned top = c / chunkCount.x * CHUNK_SIZE;
+			
+			// chunks along the right and bottom edges may be cut short
+			Chunk& chunk = chunks[c];
+			chunk.width = std::min(CHUNK_SIZE, size.x - left);
+			chunk.height = std::min(CHUNK_SIZE, size.y - top);
+			chunk.vertices.setPrimitiveType(sf::PrimitiveType::Quads);
+			chunk.revision = newVersion();
+			
+			if(!streamed)
+			{
+				chunk.vertices.resize(chunk.width * chunk.height * 4);
+				chunk.ids.assign(chunk.width * chunk.height, 0);
+			}
+		}
+		
+		updateBounds();
 	}
 	
-	void Layer::update(float dt)
+	void Layer::update(const std::vector<Tile>& types)
 	{
-		for(auto& t : tiles)
+		for(auto& c : chunks)
 		{
-			t.update(dt);
+			for(auto& t : c.animated)
+			{
+				const Tile& type = types[getID(t)];
+				
+				if(type.hasChanged())
+					updateQuad(t, type.getFrame());
+			}
 		}
+		
+		clusters.update(passability);
 	}
 	
-	void Layer::addTile(const sf::Vector2u& texPos, const sf::Vector2u& texSize, bool p, int i)
+	void Layer::addTile(int i, bool p, unsigned c, bool a)
 	{
-		tiles.emplace_back(texPos, texSize, p, i);
+		if(streamed || numTiles >= size.x * size.y)
+			return;
+		
+		if(i < -1 || i > MAX_ID)
+			i = -1;
+		
+		unsigned t = numTiles++;
+		unsigned x = t % size.x;
+		unsigned y = t / size.x;
+		
+		Chunk& chunk = chunks[getChunk(x, y)];
+		chunk.ids[(y % CHUNK_SIZE) * chunk.width + x % CHUNK_SIZE] = static_cast<std::uint16_t>(i + 1);
+		chunk.revision = newVersion();
+		
+		if(a && i != -1)
+			chunk.animated.push_back(t);
+		
+		setPassable(x, y, p);
+		setCost(x, y, c);
 	}
 	
 	unsigned int Layer::getNumTiles() const
 	{
-		return tiles.size();
+		return numTiles;
 	}
 	
-	const Tile* Layer::getTile(unsigned int t) const
+	int Layer::getID(unsigned int t) const
 	{
-		if(t < tiles.size())
-			return &tiles[t];
-		else
-			return nullptr;
+		if(t >= numTiles)
+			return -1;
+		
+		unsigned x = t % size.x;
+		unsigned y = t / size.x;
+		
+		const Chunk& chunk = chunks[getChunk(x, y)];
+		
+		if(chunk.ids.empty())
+			return -1;
+		
+		return static_cast<int>(chunk.ids[(y % CHUNK_SIZE) * chunk.width + x % CHUNK_SIZE]) - 1;
 	}
 	
-	const Tile* Layer::getTile(const sf::Vector2f& pos) const
+	int Layer::getID(const sf::Vector2f& pos) const
 	{
+		if(pos.x < 0 || pos.y < 0 || tileSize.x == 0 || tileSize.y == 0 || pos.x / tileSize.x >= size.x)
+			return -1;
+		
 		unsigned int tileNum = static_cast<unsigned int>(pos.x / tileSize.x) + static_cast<unsigned int>(pos.y / tileSize.y) * size.x;
-		return getTile(tileNum);
+		return getID(tileNum);
+	}
+	
+	bool Layer::isPassable(int x, int y) const
+	{
+		return passability.isPassable(x, y);
+	}
+	
+	bool Layer::isRowPassable(int y, int x0, int x1) const
+	{
+		return passability.isRowPassable(y, x0, x1);
+	}
+	
+	void Layer::getIDs(const sf::IntRect& area, std::vector<int>& ids) const
+	{
+		ids.assign(std::max(area.width, 0) * std::max(area.height, 0), -1);
+		
+		forEachChunk(area, [&](const ChunkSpan& span)
+		{
+			if(!span.ids)
+				return;
+			
+			for(int y = 0; y < span.tiles.height; y++)
+			{
+				const std::uint16_t* from = span.ids + y * span.stride;
+				int* to = &ids[(span.tiles.top - area.top + y) * area.width + span.tiles.left - area.left];
+				
+				for(int x = 0; x < span.tiles.width; x++)
+					to[x] = static_cast<int>(from[x]) - 1;
+			}
+		});
+	}
+	
+	void Layer::getPassable(const sf::IntRect& area, std::vector<std::uint8_t>& passable) const
+	{
+		passable.assign(std::max(area.width, 0) * std::max(area.height, 0), 1);
+		
+		sf::IntRect clipped;
+		
+		if(!area.intersects({0, 0, static_cast<int>(size.x), static_cast<int>(size.y)}, clipped))
+			return;
+		
+		int right = clipped.left + clipped.width;
+		
+		for(int y = clipped.top; y < clipped.top + clipped.height; y++)
+		{
+			std::uint8_t* to = &passable[(y - area.top) * area.width + clipped.left - area.left];
+			
+			for(int x = clipped.left; x < right;)
+			{
+				std::uint64_t blocked = passability.getBlockedWord(y, x / 64);
+				int end = std::min(right, (x / 64 + 1) * 64);
+				
+				for(; x < end; x++)
+					to[x - clipped.left] = !((blocked >> (x % 64)) & 1);
+			}
+		}
+	}
+	
+	void Layer::forEachChunk(const sf::IntRect& area, const std::function<void(const ChunkSpan&)>& f) const
+	{
+		sf::IntRect clipped;
+		
+		if(!area.intersects({0, 0, static_cast<int>(size.x), static_cast<int>(size.y)}, clipped))
+			return;
+		
+		unsigned left = clipped.left / CHUNK_SIZE;
+		unsigned right = (clipped.left + clipped.width - 1) / CHUNK_SIZE;
+		unsigned top = clipped.top / CHUNK_SIZE;
+		unsigned bottom = (clipped.top + clipped.height - 1) / CHUNK_SIZE;
+		
+		for(unsigned cy = top; cy <= bottom; cy++)
+		{
+			for(unsigned cx = left; cx <= right; cx++)
+			{
+				ChunkSpan span;
+				span.chunk = cy * chunkCount.x + cx;
+				
+				const Chunk& chunk = chunks[span.chunk];
+				sf::IntRect bounds(cx * CHUNK_SIZE, cy * CHUNK_SIZE, chunk.width, chunk.height);
+				
+				clipped.intersects(bounds, span.tiles);
+				span.stride = chunk.width;
+				span.ids = chunk.ids.empty() ? nullptr : &chunk.ids[(span.tiles.top - bounds.top) * chunk.width + span.tiles.left - bounds.left];
+				
+				f(span);
+			}
+		}
+	}
+	
+	void Layer::setPassable(unsigned x, unsigned y, bool p)
+	{
+		if(passability.isPassable(x, y) != p)
+		{
+			passability.setPassable(x, y, p);
+			clusters.markDirty(x, y);
+			version = newVersion();
+		}
+	}
+	
+	void Layer::setCost(unsigned x, unsigned y, unsigned c)
+	{
+		unsigned old = passability.getCost(x, y);
+		passability.setCost(x, y, c);
+		
+		if(passability.getCost(x, y) != old)
+		{
+			clusters.markDirty(x, y);
+			version = newVersion();
+		}
+	}
+	
+	void Layer::setDiagonal(bool d)
+	{
+		if(passability.isDiagonal() == d)
+			return;
+		
+		passability.setDiagonal(d);
+		version = newVersion();
+		
+		// every distance in the graph changes
+		if(clusters.isBuilt())
+			clusters.build(passability);
+	}
+	
+	const PassabilityMap& Layer::getPassability() const
+	{
+		return passability;
+	}
+	
+	unsigned Layer::getVersion() const
+	{
+		return version;
+	}
+	
+	void Layer::buildClusters()
+	{
+		clusters.build(passability);
+	}
+	
+	const ClusterGraph& Layer::getClusters() const
+	{
+		return clusters;
+	}
+	
+	const sf::Vector2u& Layer::getSize() const
+	{
+		return size;
+	}
+	
+	const sf::Vector2u& Layer::getChunkCount() const
+	{
+		return chunkCount;
+	}
+	
+	unsigned Layer::getRevision(unsigned c) const
+	{
+		return c < chunks.size() ? chunks[c].revision : 0;
 	}
 	
 	void Layer::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
-		target.draw(vertices, states);
+		const sf::View& view = target.getView();
+		sf::Vector2f viewSize = view.getSize();
+		
+		// a rotated view covers at most a square as wide as its diagonal
+		if(view.getRotation() != 0)
+		{
+			float diagonal = std::sqrt(viewSize.x * viewSize.x + viewSize.y * viewSize.y);
+			viewSize = {diagonal, diagonal};
+		}
+		
+		// what can be seen, in the layer's own coordinates
+		sf::FloatRect visible(view.getCenter() - viewSize / 2.f, viewSize);
+		visible = states.transform.getInverse().transformRect(visible);
+		
+		// tile geometry hardly ever changes, so it's drawn from vertex buffers, uploaded once
+		TileBuffer::begin(target, states);
+		bool buffered = TileBuffer::isAvailable();
+		
+		// streamed layers only look at what's loaded, there may be far more chunks than that
+		auto drawVisible = [&](const Chunk& c)
+		{
+			if(!c.bounds.intersects(visible))
+				return;
+			
+			FrameStats::countDraw(FrameStats::Draws::TileMap, c.vertices.getVertexCount());
+			
+			if(buffered)
+				c.buffer.draw(c.vertices);
+			else
+				target.draw(c.vertices, states);
+		};
+		
+		if(buffered)
+		{
+			if(streamed)
+			{
+				for(auto& c : loaded)
+					drawVisible(chunks[c]);
+			}
+			else
+			{
+				for(auto& c : chunks)
+					drawVisible(c);
+			}
+		}
+		
+		TileBuffer::end(target);
+		
+		if(!buffered)
+		{
+			if(streamed)
+			{
+				for(auto& c : loaded)
+					drawVisible(chunks[c]);
+			}
+			else
+			{
+				for(auto& c : chunks)
+					drawVisible(c);
+			}
+		}
+	}
+	
+	sf::Vertex* Layer::getQuad(unsigned x, unsigned y)
+	{
+		Chunk& chunk = chunks[getChunk(x, y)];
+		chunk.buffer.markDirty();
+		
+		return &chunk.vertices[((y % CHUNK_SIZE) * chunk.width + x % CHUNK_SIZE) * 4];
+	}
+	
+	void Layer::updateQuad(unsigned t, const sf::IntRect& rect)
+	{
+		if(size.x == 0 || t / size.x >= size.y)
+			return;
+		
+		sf::Vertex* quad = getQuad(t % size.x, t / size.x);
+		
+		quad[0].texCoords = {static_cast<float>(rect.left), static_cast<float>(rect.top)};
+		quad[1].texCoords = {static_cast<float>(rect.left + rect.width), static_cast<float>(rect.top)};
+		quad[2].texCoords = {static_cast<float>(rect.left + rect.width), static_cast<float>(rect.top + rect.height)};
+		quad[3].texCoords = {static_cast<float>(rect.left), static_cast<float>(rect.top + rect.height)};
+	}
+	
+	bool Layer::setTile(unsigned x, unsigned y, int id, const std::vector<Tile>& types)
+	{
+		if(x >= size.x || y >= size.y || y * size.x + x >= numTiles)
+			return false;
+		
+		Chunk& chunk = chunks[getChunk(x, y)];
+		
+		if(chunk.ids.empty())
+			return false;
+		
+		std::uint16_t& stored = chunk.ids[(y % CHUNK_SIZE) * chunk.width + x % CHUNK_SIZE];
+		std::uint16_t value = id >= 0 && static_cast<unsigned>(id) < types.size() ? static_cast<std::uint16_t>(id + 1) : 0;
+		
+		if(stored == value)
+			return true;
+		
+		unsigned t = y * size.x + x;
+		bool wasAnimated = stored != 0 && types[stored - 1].isAnimated();
+		stored = value;
+		chunk.revision = newVersion();
+		
+		if(wasAnimated)
+			chunk.animated.erase(std::find(chunk.animated.begin(), chunk.animated.end(), t));
+		
+		sf::Vertex* quad = getQuad(x, y);
+		
+		// as buildChunk leaves tiles that aren't there, transparent
+		if(value == 0)
+		{
+			for(unsigned v = 0; v < 4; v++)
+				quad[v].color = {0, 0, 0, 0};
+			
+			setPassable(x, y, true);
+			return true;
+		}
+		
+		const Tile& type = types[value - 1];
+		
+		for(unsigned v = 0; v < 4; v++)
+			quad[v].color = sf::Color::White;
+		
+		updateQuad(t, type.getFrame());
+		
+		if(type.isAnimated())
+			chunk.animated.push_back(t);
+		
+		setPassable(x, y, type.isPassable());
+		setCost(x, y, type.getCost());
+		
+		return true;
+	}
+	
+	unsigned Layer::getChunk(unsigned x, unsigned y) const
+	{
+		return y / CHUNK_SIZE * chunkCount.x + x / CHUNK_SIZE;
+	}
+	
+	void Layer::loadChunk(unsigned c, std::vector<std::uint16_t>& ids, std::vector<unsigned>& animated, sf::VertexArray& vertices, const std::vector<Tile>& types)
+	{
+		Chunk& chunk = chunks[c];
+		
+		if(!chunk.ids.empty() || ids.size() != chunk.width * chunk.height || vertices.getVertexCount() != ids.size() * 4)
+			return;
+		
+		chunk.ids.swap(ids);
+		chunk.animated.swap(animated);
+		std::swap(chunk.vertices, vertices);
+		chunk.bounds = chunk.vertices.getBounds();
+		chunk.buffer.markDirty();
+		chunk.revision = newVersion();
+		
+		unsigned left = c % chunkCount.x * CHUNK_SIZE;
+		unsigned top = c / chunkCount.x * CHUNK_SIZE;
+		
+		for(unsigned y = 0; y < chunk.height; y++)
+		{
+			for(unsigned x = 0; x < chunk.width; x++)
+			{
+				int id = static_cast<int>(chunk.ids[y * chunk.width + x]) - 1;
+				
+				// as TileMap::loadFile does, no tile is passable
+				if(id >= 0 && static_cast<unsigned>(id) < types.size())
+				{
+					setPassable(left + x, top + y, types[id].isPassable());
+					setCost(left + x, top + y, types[id].getCost());
+				}
+				else
+				{
+					setPassable(left + x, top + y, true);
+				}
+			}
+		}
+		
+		// texture coordinates of animated tiles were saved with whatever frame they were on
+		for(auto& t : chunk.animated)
+			updateQuad(t, types[getID(t)].getFrame());
+		
+		loaded.push_back(c);
+	}
+	
+	void Layer::unloadChunk(unsigned c)
+	{
+		Chunk& chunk = chunks[c];
+		
+		if(chunk.ids.empty())
+			return;
+		
+		// swapped with empty ones, so the memory is actually given back
+		std::vector<std::uint16_t>().swap(chunk.ids);
+		std::vector<unsigned>().swap(chunk.animated);
+		chunk.vertices = sf::VertexArray(sf::PrimitiveType::Quads);
+		chunk.bounds = {};
+		chunk.buffer.release();
+		chunk.revision = newVersion();
+		
+		unsigned left = c % chunkCount.x * CHUNK_SIZE;
+		unsigned top = c / chunkCount.x * CHUNK_SIZE;
+		
+		for(unsigned y = 0; y < chunk.height; y++)
+			for(unsigned x = 0; x < chunk.width; x++)
+				setPassable(left + x, top + y, false);
+		
+		loaded.erase(std::find(loaded.begin(), loaded.end(), c));
+	}
+	
+	std::size_t Layer::getChunkMemory(unsigned c) const
+	{
+		const Chunk& chunk = chunks[c];
+		
+		return chunk.ids.capacity() * sizeof(std::uint16_t) + chunk.animated.capacity() * sizeof(unsigned)
+			+ chunk.vertices.getVertexCount() * sizeof(sf::Vertex);
+	}
+	
+	void Layer::updateBounds()
+	{
+		for(auto& c : chunks)
+			c.bounds = c.vertices.getBounds();
+	}
+	
+	void Layer::buildChunk(unsigned c, const std::vector<float>& xs, const std::vector<float>& ys, const std::vector<Tile>& types)
+	{
+		Chunk& chunk = chunks[c];
+		
+		if(chunk.ids.empty())
+			return;
+		
+		unsigned left = c % chunkCount.x * CHUNK_SIZE;
+		unsigned top = c / chunkCount.x * CHUNK_SIZE;
+		
+		const sf::Color clear = {0, 0, 0, 0};
+		const std::uint16_t* ids = chunk.ids.data();
+		sf::Vertex* quad = &chunk.vertices[0];
+		
+		for(unsigned j = 0; j < chunk.height; j++)
+		{
+			float y0 = ys[top + j];
+			float y1 = ys[top + j + 1];
+			
+			// rows are contiguous in both ids and vertices
+			for(unsigned i = 0; i < chunk.width; i++, ids++, quad += 4)
+			{
+				float x0 = xs[left + i];
+				float x1 = xs[left + i + 1];
+				
+				quad[0].position = {x0, y0};
+				quad[1].position = {x1, y0};
+				quad[2].position = {x1, y1};
+				quad[3].position = {x0, y1};
+				
+				// no tile here, or not one the tileset has, transparent
+				if(*ids == 0 || *ids > types.size())
+				{
+					quad[0].color = clear;
+					quad[1].color = clear;
+					quad[2].color = clear;
+					quad[3].color = clear;
+					continue;
+				}
+				
+				const sf::IntRect& rect = types[*ids - 1].getFrame();
+				float u0 = static_cast<float>(rect.left);
+				float v0 = static_cast<float>(rect.top);
+				float u1 = static_cast<float>(rect.left + rect.width);
+				float v1 = static_cast<float>(rect.top + rect.height);
+				
+				quad[0].texCoords = {u0, v0};
+				quad[1].texCoords = {u1, v0};
+				quad[2].texCoords = {u1, v1};
+				quad[3].texCoords = {u0, v1};
+			}
+		}
+		
+		// known from the edges, without going over the vertices again
+		chunk.bounds = {xs[left], ys[top], xs[left + chunk.width] - xs[left], ys[top + chunk.height] - ys[top]};
+		chunk.buffer.markDirty();
 	}
 }
@@ -5,10 +5,16 @@
 #include <SFML/Graphics/Drawable.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Rect.hpp>
 
 #include <vector>
+#include <cstdint>
+#include <functional>
 
 #include "Tile.hpp"
+#include "PassabilityMap.hpp"
+#include "TileBuffer.hpp"
+#include "../Pathfinding/ClusterGraph.hpp"
 
 namespace swift
 {
@@ -16,23 +22,137 @@ namespace swift
 	{
 		friend class TileMap;
 		public:
-			Layer(const sf::Vector2u& s, const sf::Vector2u& ts);
+			// the part of a chunk inside a region, as forEachChunk gives it. ids are as the chunk keeps them, the type plus 1,
+			// 0 where there's no tile, with rows stride apart. nullptr if the chunk isn't loaded
+			struct ChunkSpan
+			{
+				unsigned chunk;
+				sf::IntRect tiles;			// of the layer
+				const std::uint16_t* ids;
+				unsigned stride;
+			};
 			
-			void update(float dt);
+			// streamed layers start with every chunk unloaded, and impassable, until TileMap pages them in
+			Layer(const sf::Vector2u& s, const sf::Vector2u& ts, bool streamed = false);
 			
-			void addTile(const sf::Vector2u& texPos, const sf::Vector2u& texSize, bool p, int i);
+			// after types were updated. Only the quads of animated tiles whose type changed frames are touched
+			void update(const std::vector<Tile>& types);
+			
+			// i is the tile's type, -1 for no tile, up to MAX_ID. c is what entering the tile costs pathfinding, 1 through 255.
+			// a if the type is animated
+			void addTile(int i, bool p, unsigned c = 1, bool a = false);
 			
 			unsigned int getNumTiles() const;
 			
-			const Tile* getTile(unsigned int t) const;
-			const Tile* getTile(const sf::Vector2f& pos) const;
+			// type of tile t, -1 if there's no tile there, or its chunk isn't loaded
+			int getID(unsigned int t) const;
+			int getID(const sf::Vector2f& pos) const;
+			
+			// tiles outside of the layer are passable
+			bool isPassable(int x, int y) const;
+			
+			// true if tiles x0 through x1 of row y are all passable
+			bool isRowPassable(int y, int x0, int x1) const;
+			
+			void setPassable(unsigned x, unsigned y, bool p);
+			void setCost(unsigned x, unsigned y, unsigned c);
+			
+			// the types of the tiles of area, in tiles, row by row, -1 where there's no tile, it's outside of the layer, or its
+			// chunk isn't loaded. Copied a row of a chunk at a time, instead of looking each tile up
+			void getIDs(const sf::IntRect& area, std::vector<int>& ids) const;
+			
+			// 1 where the tiles of area are passable, 0 where they aren't, row by row. Read from the passability bits a word
+			// at a time. Tiles outside of the layer are passable
+			void getPassable(const sf::IntRect& area, std::vector<std::uint8_t>& passable) const;
+			
+			// f with each chunk area reaches, a row of chunks at a time, so consumers can walk the tiles as they're stored
+			void forEachChunk(const sf::IntRect& area, const std::function<void(const ChunkSpan&)>& f) const;
+			
+			// lets paths step diagonally, without cutting corners
+			void setDiagonal(bool d);
+			
+			const PassabilityMap& getPassability() const;
+			
+			// changes whenever passability, costs, or diagonal steps change, so copies of it can tell they're out of date
+			unsigned getVersion() const;
+			
+			// built by TileMap::loadFile. Tiles changed with setPassable are rebuilt on the next update
+			void buildClusters();
+			const ClusterGraph& getClusters() const;
+			
+			const sf::Vector2u& getSize() const;
+			
+			// chunks across and down, the last of each may be cut short by the layer's edges
+			const sf::Vector2u& getChunkCount() const;
+			
+			// changes whenever a tile of chunk c does, or the chunk is loaded or unloaded, so copies of its tiles can tell
+			// they're out of date. Unique over all layers, as versions are
+			unsigned getRevision(unsigned c) const;
+			
+			// tiles on a side of each chunk
+			static const unsigned CHUNK_SIZE = 32;
+			
+			// ids are stored in 16 bits
+			static const int MAX_ID = 0xfffe;
 
 		private:
+			// a block of tiles with its own vertices, only drawn while it can be seen
+			struct Chunk
+			{
+				sf::VertexArray vertices;
+				mutable TileBuffer buffer;	// the vertices, on the GPU
+				sf::FloatRect bounds;	// of the vertices, updated by updateBounds
+				unsigned width;			// in tiles, less than CHUNK_SIZE along the right edge
+				unsigned height;		// less along the bottom edge
+				
+				std::vector<std::uint16_t> ids;		// the type of each tile plus 1, 0 where there's none. Empty while not loaded
+				std::vector<unsigned> animated;		// the chunk's animated tiles, by index in the layer
+				unsigned revision;
+			};
+			
+			// only chunks overlapping the target's view are drawn
 			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 			
-			sf::VertexArray vertices;
-
-			std::vector<Tile> tiles;
+			// the 4 vertices of tile x, y. Their chunk is uploaded again on its next draw
+			sf::Vertex* getQuad(unsigned x, unsigned y);
+			
+			// after the vertices are moved
+			void updateBounds();
+			
+			// lays out every quad of chunk c in one pass over its tiles, with textures from the types' current frames.
+			// xs and ys are the pixel edges of each column and row of the layer, size + 1 of them.
+			// only touches chunk c, so chunks can be built on different threads
+			void buildChunk(unsigned c, const std::vector<float>& xs, const std::vector<float>& ys, const std::vector<Tile>& types);
+			
+			// points the texture coordinates of the quad of tile t at rect
+			void updateQuad(unsigned t, const sf::IntRect& rect);
+			
+			// changes tile x, y to type id, -1 for none, patching only its quad, animated list, and passability.
+			// its chunk is uploaded again on its next draw. False if its chunk isn't loaded
+			bool setTile(unsigned x, unsigned y, int id, const std::vector<Tile>& types);
+			
+			// chunk that tile x, y is in
+			unsigned getChunk(unsigned x, unsigned y) const;
+			
+			// streamed layers. Takes over the contents of ids, animated, and vertices, and sets the chunk's passability from types
+			void loadChunk(unsigned c, std::vector<std::uint16_t>& ids, std::vector<unsigned>& animated, sf::VertexArray& vertices, const std::vector<Tile>& types);
+			
+			// frees the chunk's tiles and vertices, leaving it impassable
+			void unloadChunk(unsigned c);
+			
+			// bytes held by the chunk's tiles and vertices
+			std::size_t getChunkMemory(unsigned c) const;
+			
+			std::vector<Chunk> chunks;
+			sf::Vector2u chunkCount;
+			
+			unsigned numTiles;			// added so far, or every tile of a streamed layer
+			bool streamed;
+			std::vector<unsigned> loaded;	// chunks of a streamed layer that are loaded, only these are drawn
+			
+			PassabilityMap passability;
+			ClusterGraph clusters;
+			unsigned version;
 			
 			sf::Vector2u size;
 			sf::Vector2u tileSize;
@@ -0,0 +1,266 @@
+#include "PassabilityMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace swift
+{
+	PassabilityMap::PassabilityMap()
+	:	wordsPerRow(0),
+		size(0, 0),
+		diagonal(false)
+	{
+	}
+	
+	PassabilityMap::PassabilityMap(const sf::Vector2u& s)
+	:	PassabilityMap()
+	{
+		resize(s);
+	}
+	
+	void PassabilityMap::resize(const sf::Vector2u& s, bool passable)
+	{
+		size = s;
+		wordsPerRow = (size.x + 63) / 64;
+		blocked.assign(wordsPerRow * size.y, passable ? 0 : ~std::uint64_t(0));
+		costs.clear();
+	}
+	
+	bool PassabilityMap::isInside(int x, int y) const
+	{
+		return x >= 0 && y >= 0 && x < static_cast<int>(size.x) && y < static_cast<int>(size.y);
+	}
+	
+	bool PassabilityMap::isPassable(int x, int y) const
+	{
+		if(!isInside(x, y))
+			return true;
+		
+		return !((blocked[y * wordsPerRow + x / 64] >> (x % 64)) & 1);
+	}
+	
+	bool PassabilityMap::isRowPassable(int y, int x0, int x1) const
+	{
+		if(y < 0 || y >= static_cast<int>(size.y))
+			return true;
+		
+		x0 = std::max(x0, 0);
+		x1 = std::min(x1, static_cast<int>(size.x) - 1);
+		
+		const std::uint64_t* row = &blocked[y * wordsPerRow];
+		
+		// a word at a time, masking off the bits outside the range at either end
+		for(int w = x0 / 64; w <= x1 / 64 && x0 <= x1; w++)
+		{
+			std::uint64_t bits = row[w];
+			
+			if(w == x0 / 64)
+				bits &= ~std::uint64_t(0) << (x0 % 64);
+			
+			if(w == x1 / 64 && x1 % 64 != 63)
+				bits &= (std::uint64_t(1) << (x1 % 64 + 1)) - 1;
+			
+			if(bits)
+				return false;
+		}
+		
+		return true;
+	}
+	
+	void PassabilityMap::setPassable(unsigned x, unsigned y, bool p)
+	{
+		if(x >= size.x || y >= size.y)
+			return;
+		
+		std::uint64_t bit = std::uint64_t(1) << (x % 64);
+		
+		if(p)
+			blocked[y * wordsPerRow + x / 64] &= ~bit;
+		else
+			blocked[y * wordsPerRow + x / 64] |= bit;
+	}
+	
+	void PassabilityMap::setCost(unsigned x, unsigned y, unsigned c)
+	{
+		if(x >= size.x || y >= size.y)
+			return;
+		
+		c = std::min(std::max(c, 1u), 255u);
+		
+		if(costs.empty())
+		{
+			if(c == 1)
+				return;
+			
+			costs.assign(size.x * size.y, 1);
+		}
+		
+		costs[y * size.x + x] = static_cast<std::uint8_t>(c);
+	}
+	
+	unsigned PassabilityMap::getCost(int x, int y) const
+	{
+		if(costs.empty() || !isInside(x, y))
+			return 1;
+		
+		return costs[y * size.x + x];
+	}
+	
+	bool PassabilityMap::isUniform() const
+	{
+		return costs.empty();
+	}
+	
+	void PassabilityMap::setDiagonal(bool d)
+	{
+		diagonal = d;
+	}
+	
+	bool PassabilityMap::isDiagonal() const
+	{
+		return diagonal;
+	}
+	
+	float PassabilityMap::estimate(const sf::Vector2i& from, const sf::Vector2i& to) const
+	{
+		float dx = static_cast<float>(std::abs(to.x - from.x));
+		float dy = static_cast<float>(std::abs(to.y - from.y));
+		
+		// octile distance, straight as far as the shorter side allows, and along the longer side for the rest
+		if(diagonal)
+			return std::max(dx, dy) + 0.41421356f * std::min(dx, dy);
+		
+		return dx + dy;
+	}
+	
+	bool PassabilityMap::isLineClear(const sf::Vector2i& from, const sf::Vector2i& to) const
+	{
+		const unsigned limit = std::max(getCost(from.x, from.y), getCost(to.x, to.y));
+		
+		auto open = [this, limit](int x, int y)
+		{
+			return isInside(x, y) && isPassable(x, y) && getCost(x, y) <= limit;
+		};
+		
+		const long long nx = std::abs(to.x - from.x);
+		const long long ny = std::abs(to.y - from.y);
+		const int sx = to.x > from.x ? 1 : -1;
+		const int sy = to.y > from.y ? 1 : -1;
+		
+		int x = from.x;
+		int y = from.y;
+		
+		// steps into whichever tile the line enters next, comparing where it crosses
+		// the next vertical and horizontal tile edges, in integers
+		for(long long ix = 0, iy = 0; ix < nx || iy < ny;)
+		{
+			long long toVertical = (1 + 2 * ix) * ny;
+			long long toHorizontal = (1 + 2 * iy) * nx;
+			
+			if(toVertical == toHorizontal)
+			{
+				if(!open(x + sx, y) || !open(x, y + sy))
+					return false;
+				
+				x += sx;
+				y += sy;
+				ix++;
+				iy++;
+			}
+			else if(toVertical < toHorizontal)
+			{
+				x += sx;
+				ix++;
+			}
+			else
+			{
+				y += sy;
+				iy++;
+			}
+			
+			if(!open(x, y))
+				return false;
+		}
+		
+		return true;
+	}
+	
+	bool PassabilityMap::raycast(const sf::Vector2f& from, const sf::Vector2f& to, sf::Vector2i& tile, float& fraction) const
+	{
+		const float dx = to.x - from.x;
+		const float dy = to.y - from.y;
+		const float infinity = std::numeric_limits<float>::infinity();
+		
+		int x = static_cast<int>(std::floor(from.x));
+		int y = static_cast<int>(std::floor(from.y));
+		const int sx = dx > 0 ? 1 : -1;
+		const int sy = dy > 0 ? 1 : -1;
+		
+		// fraction of the segment crossing a whole tile takes, and where it crosses the next tile edge
+		const float deltaX = dx != 0 ? std::abs(1 / dx) : infinity;
+		const float deltaY = dy != 0 ? std::abs(1 / dy) : infinity;
+		float nextX = dx > 0 ? (x + 1 - from.x) * deltaX : dx < 0 ? (from.x - x) * deltaX : infinity;
+		float nextY = dy > 0 ? (y + 1 - from.y) * deltaY : dy < 0 ? (from.y - y) * deltaY : infinity;
+		
+		// a step per tile edge between the ends, so rounding can't walk it past the last tile
+		long long steps = std::abs(static_cast<long long>(std::floor(to.x)) - x) + std::abs(static_cast<long long>(std::floor(to.y)) - y);
+		
+		for(; steps > 0; steps--)
+		{
+			float t;
+			
+			if(nextX < nextY)
+			{
+				t = nextX;
+				x += sx;
+				nextX += deltaX;
+			}
+			else
+			{
+				t = nextY;
+				y += sy;
+				nextY += deltaY;
+			}
+			
+			// past an edge and heading away from the map, nothing further can block it
+			if((x < 0 && sx < 0) || (y < 0 && sy < 0) || (x >= static_cast<int>(size.x) && sx > 0) || (y >= static_cast<int>(size.y) && sy > 0))
+				return false;
+			
+			if(!isPassable(x, y))
+			{
+				tile = {x, y};
+				fraction = std::min(t, 1.f);
+				return true;
+			}
+		}
+		
+		return false;
+	}
+	
+	const sf::Vector2u& PassabilityMap::getSize() const
+	{
+		return size;
+	}
+	
+	const std::vector<std::uint64_t>& PassabilityMap::getBlocked() const
+	{
+		return blocked;
+	}
+	
+	const std::vector<std::uint8_t>& PassabilityMap::getCosts() const
+	{
+		return costs;
+	}
+	
+	void PassabilityMap::assign(const std::uint64_t* b, const std::uint8_t* c)
+	{
+		blocked.assign(b, b + blocked.size());
+		
+		if(c)
+			costs.assign(c, c + size.x * size.y);
+		else
+			costs.clear();
+	}
+}
@@ -0,0 +1,118 @@
+#ifndef PASSABILITYMAP_HPP
+#define PASSABILITYMAP_HPP
+
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+#include <cstdint>
+
+namespace swift
+{
+	// a bit per tile, set if it is impassable. Each row starts on a new word.
+	// small and flat, so checks don't touch Tile objects, and copies are cheap.
+	// optionally a movement cost per tile, and diagonal steps
+	class PassabilityMap
+	{
+		public:
+			PassabilityMap();
+			explicit PassabilityMap(const sf::Vector2u& s);
+			
+			// every tile passable, or every tile blocked, and costing 1
+			void resize(const sf::Vector2u& s, bool passable = true);
+			
+			bool isInside(int x, int y) const;
+			
+			// tiles outside of the map are passable
+			bool isPassable(int x, int y) const;
+			
+			// true if tiles x0 through x1 of row y are all passable
+			bool isRowPassable(int y, int x0, int x1) const;
+			
+			void setPassable(unsigned x, unsigned y, bool p);
+			
+			// what entering the tile costs, 1 through 255. Costs are only stored once one isn't 1
+			void setCost(unsigned x, unsigned y, unsigned c);
+			unsigned getCost(int x, int y) const;
+			
+			// true if every tile costs 1
+			bool isUniform() const;
+			
+			// lets searches step diagonally, as long as both tiles beside the step are passable, so corners aren't cut
+			void setDiagonal(bool d);
+			bool isDiagonal() const;
+			
+			// cost of stepping from x, y to the neighbor dx, dy away: the neighbor's cost, sqrt 2 times that diagonally.
+			// 0 if the step can't be taken, as the neighbor is blocked or outside, or the step would cut a corner.
+			// inline, path searches call it in their inner loops
+			float getStepCost(int x, int y, int dx, int dy) const;
+			
+			// the least a path between the tiles can cost, ignoring what's in between
+			float estimate(const sf::Vector2i& from, const sf::Vector2i& to) const;
+			
+			// true if the straight line between the centers of from and to only crosses passable tiles inside the map.
+			// from itself isn't checked. Where the line passes exactly through a corner, both tiles beside it must be passable.
+			// with costs, every tile crossed must also cost no more than the costlier of from and to, so lines don't cut through expensive ground
+			bool isLineClear(const sf::Vector2i& from, const sf::Vector2i& to) const;
+			
+			// walks the tiles the segment crosses, in order (Amanatides and Woo's DDA), in tile units, so 2.5 is halfway across tile 2.
+			// true if one is blocked, with tile being it and fraction how far along the segment it's entered.
+			// the tile from is in isn't checked, as with isLineClear. Tiles outside of the map are passable
+			bool raycast(const sf::Vector2f& from, const sf::Vector2f& to, sf::Vector2i& tile, float& fraction) const;
+			
+			// the blocked bits of tiles w*64 through w*64+63 of row y, lowest bit first.
+			// unlike isPassable, tiles outside of the map come back blocked, so scans stop at the edges.
+			// inline, path searches call it in their inner loops
+			std::uint64_t getBlockedWord(int y, int w) const;
+			
+			const sf::Vector2u& getSize() const;
+			
+			// for saving the map as it is. Blocked bits a row of words at a time, and costs, empty while uniform
+			const std::vector<std::uint64_t>& getBlocked() const;
+			const std::vector<std::uint8_t>& getCosts() const;
+			
+			// the tiles, as getBlocked and getCosts gave them for a map of the same size. costs is nullptr if uniform
+			void assign(const std::uint64_t* b, const std::uint8_t* c);
+			
+		private:
+			std::vector<std::uint64_t> blocked;
+			std::vector<std::uint8_t> costs;	// empty while uniform
+			unsigned wordsPerRow;
+			sf::Vector2u size;
+			bool diagonal;
+	};
+	
+	inline std::uint64_t PassabilityMap::getBlockedWord(int y, int w) const
+	{
+		if(y < 0 || y >= static_cast<int>(size.y) || w < 0 || w >= static_cast<int>(wordsPerRow))
+			return ~std::uint64_t(0);
+		
+		std::uint64_t bits = blocked[y * wordsPerRow + w];
+		
+		// padding past the last column
+		if(w == static_cast<int>(wordsPerRow) - 1 && size.x % 64 != 0)
+			bits |= ~std::uint64_t(0) << (size.x % 64);
+		
+		return bits;
+	}
+	
+	inline float PassabilityMap::getStepCost(int x, int y, int dx, int dy) const
+	{
+		int nx = x + dx;
+		int ny = y + dy;
+		
+		if(!isInside(nx, ny) || !isPassable(nx, ny))
+			return 0;
+		
+		float c = costs.empty() ? 1.f : costs[ny * size.x + nx];
+		
+		if(dx == 0 || dy == 0)
+			return c;
+		
+		if(!diagonal || !isInside(nx, y) || !isPassable(nx, y) || !isInside(x, ny) || !isPassable(x, ny))
+			return 0;
+		
+		return c * 1.41421356f;
+	}
+}
+
+#endif // PASSABILITYMAP_HPP
@@ -1,31 +1,47 @@
 #include "Tile.hpp"
 
+#include <algorithm>
+
 namespace swift
 {
 	Tile::Tile(const sf::Vector2u& texPos, const sf::Vector2u& texSize, bool p, int i)
 	:	frameNum(0),
 		passable(p),
+		cost(1),
 		animated(false),
 		animationTime(0.f),
 		currentTime(0.f),
+		changed(false),
 		id(i)
 	{
 		texRects.push_back({static_cast<int>(texPos.x), static_cast<int>(texPos.y), static_cast<int>(texSize.x), static_cast<int>(texSize.y)});
 	}
 	
-	void Tile::update(float dt)
+	bool Tile::update(float dt)
+	{
+		changed = false;
+		
+		if(!animated || texRects.size() < 2 || animationTime <= 0)
+			return false;
+		
+		currentTime += dt;
+		
+		unsigned int last = frameNum;
+		
+		// wraps around with the time, so the cycle stays in step
+		while(currentTime >= animationTime)
+			currentTime -= animationTime;
+		
+		frameNum = std::min<unsigned int>(currentTime / (animationTime / texRects.size()), texRects.size() - 1);
+		
+		changed = frameNum != last;
+		
+		return changed;
+	}
+	
+	bool Tile::hasChanged() const
 	{
-		if(animated)
-		{
-			currentTime += dt;
-			if(currentTime >= (animationTime / texRects.size()) * (frameNum + 1))
-			{
-				frameNum++;
-				
-				if(frameNum >= texRects.size())
-					frameNum = 0;
-			}
-		}
+		return changed;
 	}
 	
 	void Tile::addFrame(const sf::IntRect& r)
@@ -33,6 +49,21 @@ namespace swift
 		texRects.push_back(r);
 	}
 	
+	void Tile::setFrames(const std::vector<sf::IntRect>& r)
+	{
+		if(r.empty())
+			return;
+		
+		texRects = r;
+		frameNum = 0;
+		currentTime = 0;
+	}
+	
+	const sf::IntRect& Tile::getFrame() const
+	{
+		return texRects[frameNum];
+	}
+	
 	void Tile::setAnimated(bool a)
 	{
 		animated = a;
@@ -48,11 +79,36 @@ namespace swift
 		animationTime = t;
 	}
 	
+	float Tile::getAnimationTime() const
+	{
+		return animationTime;
+	}
+	
+	const std::vector<sf::IntRect>& Tile::getFrames() const
+	{
+		return texRects;
+	}
+	
+	void Tile::setPassable(bool p)
+	{
+		passable = p;
+	}
+	
 	bool Tile::isPassable() const
 	{
 		return passable;
 	}
 	
+	void Tile::setCost(unsigned int c)
+	{
+		cost = std::min(std::max(c, 1u), 255u);
+	}
+	
+	unsigned int Tile::getCost() const
+	{
+		return cost;
+	}
+	
 	int Tile::getID() const
 	{
 		return id;
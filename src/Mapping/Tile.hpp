@@ -8,21 +8,42 @@
 
 namespace swift
 {
+	// a type of tile in the tileset, shared by every tile of that type in every layer.
+	// layers only keep the id of each of their tiles, so animated tiles all change frames together
 	class Tile
 	{
 		public:
 			Tile(const sf::Vector2u& texPos, const sf::Vector2u& texSize, bool p, int i);
 			
-			void update(float dt);
+			// true if it moved on to another frame, until the next update
+			bool update(float dt);
+			bool hasChanged() const;
 			void addFrame(const sf::IntRect& r);
 			
+			// replaces every frame
+			void setFrames(const std::vector<sf::IntRect>& r);
+			
+			// texture rect of the frame showing now
+			const sf::IntRect& getFrame() const;
+			
 			void setAnimated(bool a);
 			bool isAnimated() const;
 			
 			void setAnimationTime(float t);
 			
+			// seconds for one cycle through every frame
+			float getAnimationTime() const;
+			
+			// texture rects, the first is the tile when not animated
+			const std::vector<sf::IntRect>& getFrames() const;
+			
+			void setPassable(bool p);
 			bool isPassable() const;
 			
+			// 1 through 255, what entering the tile costs pathfinding
+			void setCost(unsigned int c);
+			unsigned int getCost() const;
+			
 			int getID() const;
 
 		private:
@@ -30,10 +51,12 @@ namespace swift
 			unsigned int frameNum;
 			
 			bool passable;
+			unsigned int cost;
 			
 			bool animated;
 			float animationTime;
 			float currentTime;
+			bool changed;
 			
 			unsigned int id;
 	};
@@ -0,0 +1,149 @@
+#include "TileBuffer.hpp"
+
+#include <SFML/Graphics/Texture.hpp>
+
+#include <cstddef>
+#include <cstdio>
+
+#ifdef _WIN32
+	#include <GL/glew.h>
+#else
+	#define GL_GLEXT_PROTOTYPES
+	#include <GL/gl.h>
+	#include <GL/glext.h>
+#endif
+
+namespace swift
+{
+	TileBuffer::TileBuffer()
+	:	id(0),
+		capacity(0),
+		dirty(true)
+	{
+	}
+	
+	TileBuffer::TileBuffer(const TileBuffer&)
+	:	TileBuffer()
+	{
+	}
+	
+	TileBuffer& TileBuffer::operator=(const TileBuffer&)
+	{
+		// keeps its own buffer, whatever is in it now is out of date
+		dirty = true;
+		return *this;
+	}
+	
+	TileBuffer::~TileBuffer()
+	{
+		if(id != 0)
+			glDeleteBuffers(1, &id);
+	}
+	
+	void TileBuffer::markDirty()
+	{
+		dirty = true;
+	}
+	
+	void TileBuffer::release()
+	{
+		if(id != 0)
+			glDeleteBuffers(1, &id);
+		
+		id = 0;
+		capacity = 0;
+		dirty = true;
+	}
+	
+	void TileBuffer::begin(sf::RenderTarget& target, const sf::RenderStates& states)
+	{
+		// activates the target's context, in the states SFML expects
+		target.resetGLStates();
+		
+		const sf::View& view = target.getView();
+		sf::IntRect viewport = target.getViewport(view);
+		
+		// OpenGL counts the viewport from the bottom
+		glViewport(viewport.left, target.getSize().y - (viewport.top + viewport.height), viewport.width, viewport.height);
+		
+		glMatrixMode(GL_PROJECTION);
+		glLoadMatrixf(view.getTransform().getMatrix());
+		glMatrixMode(GL_MODELVIEW);
+		glLoadMatrixf(states.transform.getMatrix());
+		
+		// texture coordinates are in pixels, as with sf::VertexArray
+		sf::Texture::bind(states.texture, sf::Texture::Pixels);
+		
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	}
+	
+	void TileBuffer::draw(const sf::VertexArray& vertices)
+	{
+		std::size_t count = vertices.getVertexCount();
+		
+		if(count == 0)
+			return;
+		
+		if(id == 0)
+			glGenBuffers(1, &id);
+		
+		glBindBuffer(GL_ARRAY_BUFFER, id);
+		
+		if(dirty)
+		{
+			const GLsizeiptr bytes = count * sizeof(sf::Vertex);
+			
+			if(count != capacity)
+			{
+				glBufferData(GL_ARRAY_BUFFER, bytes, &vertices[0], GL_STATIC_DRAW);
+				capacity = count;
+			}
+			else
+				glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, &vertices[0]);
+			
+			dirty = false;
+		}
+		
+		// offsets into the buffer, laid out like sf::Vertex
+		glVertexPointer(2, GL_FLOAT, sizeof(sf::Vertex), reinterpret_cast<const void*>(offsetof(sf::Vertex, position)));
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(sf::Vertex), reinterpret_cast<const void*>(offsetof(sf::Vertex, color)));
+		glTexCoordPointer(2, GL_FLOAT, sizeof(sf::Vertex), reinterpret_cast<const void*>(offsetof(sf::Vertex, texCoords)));
+		
+		glDrawArrays(GL_QUADS, 0, count);
+	}
+	
+	void TileBuffer::end(sf::RenderTarget& target)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		
+		// SFML caches what it last set, which is out of date now
+		target.resetGLStates();
+	}
+	
+	bool TileBuffer::isAvailable()
+	{
+		// checked once, the answer doesn't change
+		static int available = -1;
+		
+		if(available == -1)
+		{
+#ifdef _WIN32
+			available = glewInit() == GLEW_OK && GLEW_VERSION_1_5;
+#else
+			// vertex buffers are core since 1.5
+			const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+			int major = 0;
+			int minor = 0;
+			
+			available = version && std::sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 1 || minor >= 5);
+#endif
+		}
+		
+		return available == 1;
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef TILEBUFFER_HPP
+#define TILEBUFFER_HPP
+
+#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+
+namespace swift
+{
+	// a copy of a chunk's vertices kept by the GPU, in an OpenGL vertex buffer object.
+	// uploaded on the first draw, and again only after being marked dirty.
+	// copies start without a buffer of their own, and upload on their first draw
+	class TileBuffer
+	{
+		public:
+			TileBuffer();
+			TileBuffer(const TileBuffer& other);
+			TileBuffer& operator=(const TileBuffer& other);
+			~TileBuffer();
+			
+			// the vertices changed, upload them again on the next draw
+			void markDirty();
+			
+			// deletes the buffer, the next draw makes a new one. Needs an active context
+			void release();
+			
+			// sets up target for drawing buffers with states' transform and texture
+			static void begin(sf::RenderTarget& target, const sf::RenderStates& states);
+			
+			// between begin and end. Uploads vertices first if dirty
+			void draw(const sf::VertexArray& vertices);
+			
+			// hands target back to SFML
+			static void end(sf::RenderTarget& target);
+			
+			// false if the OpenGL driver doesn't have vertex buffer objects. Needs an active context
+			static bool isAvailable();
+		
+		private:
+			unsigned id;
+			std::size_t capacity;	// vertices the buffer has room for
+			bool dirty;
+	};
+}
+
+#endif // TILEBUFFER_HPP
@@ -0,0 +1,190 @@
+#include "TileData.hpp"
+
+#include <tinyxml2.h>
+#include <zlib.h>
+
+#include <cstring>
+
+namespace swift
+{
+	namespace
+	{
+		// 0 through 63 for base64 digits, 64 for whitespace and padding, 65 for anything else
+		struct Base64Table
+		{
+			unsigned char values[256];
+			
+			Base64Table()
+			{
+				const char* digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+				
+				std::memset(values, 65, sizeof(values));
+				
+				for(unsigned char i = 0; i < 64; i++)
+					values[static_cast<unsigned char>(digits[i])] = i;
+				
+				values[static_cast<unsigned char>('=')] = 64;
+				values[static_cast<unsigned char>(' ')] = 64;
+				values[static_cast<unsigned char>('\t')] = 64;
+				values[static_cast<unsigned char>('\n')] = 64;
+				values[static_cast<unsigned char>('\r')] = 64;
+			}
+		};
+		
+		const Base64Table base64;
+	}
+	
+	bool TileData::read(const tinyxml2::XMLElement* data, unsigned count, std::vector<std::uint32_t>& gids)
+	{
+		gids.clear();
+		
+		if(data == nullptr)
+			return false;
+		
+		const char* encoding = data->Attribute("encoding");
+		const char* compression = data->Attribute("compression");
+		
+		// no encoding is a <tile gid=""/> element per tile
+		if(encoding == nullptr)
+		{
+			gids.reserve(count);
+			
+			for(const tinyxml2::XMLElement* tile = data->FirstChildElement("tile"); tile != nullptr; tile = tile->NextSiblingElement("tile"))
+				gids.push_back(tile->UnsignedAttribute("gid") & ~FLIP_FLAGS);
+			
+			return gids.size() == count;
+		}
+		
+		const char* text = data->GetText();
+		
+		if(text == nullptr)
+			return false;
+		
+		if(std::strcmp(encoding, "csv") == 0)
+			return readCSV(text, count, gids);
+		
+		if(std::strcmp(encoding, "base64") != 0)
+			return false;
+		
+		std::vector<unsigned char> bytes;
+		bytes.reserve(std::strlen(text) / 4 * 3);
+		
+		if(!decodeBase64(text, bytes))
+			return false;
+		
+		if(compression != nullptr && compression[0] != '\0')
+		{
+			if(std::strcmp(compression, "zlib") != 0 && std::strcmp(compression, "gzip") != 0)
+				return false;
+			
+			std::vector<unsigned char> inflated;
+			
+			if(!decompress(bytes, count * 4, inflated))
+				return false;
+			
+			bytes.swap(inflated);
+		}
+		
+		if(bytes.size() != count * 4)
+			return false;
+		
+		// 32 bit little endian gids
+		gids.resize(count);
+		
+		for(unsigned i = 0; i < count; i++)
+		{
+			const unsigned char* b = &bytes[i * 4];
+			gids[i] = (b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<std::uint32_t>(b[3]) << 24)) & ~FLIP_FLAGS;
+		}
+		
+		return true;
+	}
+	
+	bool TileData::readCSV(const char* text, unsigned count, std::vector<std::uint32_t>& gids)
+	{
+		gids.clear();
+		gids.reserve(count);
+		
+		const char* c = text;
+		
+		while(*c != '\0')
+		{
+			// anything before the number: whitespace, or the comma after the last one
+			while(*c != '\0' && (*c < '0' || *c > '9'))
+			{
+				if(*c != ',' && *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r')
+					return false;
+				
+				c++;
+			}
+			
+			if(*c == '\0')
+				break;
+			
+			std::uint32_t gid = 0;
+			
+			// wraps around past 32 bits, Tiled never writes that much
+			while(*c >= '0' && *c <= '9')
+			{
+				gid = gid * 10 + (*c - '0');
+				c++;
+			}
+			
+			gids.push_back(gid & ~FLIP_FLAGS);
+		}
+		
+		return gids.size() == count;
+	}
+	
+	bool TileData::decodeBase64(const char* text, std::vector<unsigned char>& bytes)
+	{
+		std::uint32_t bits = 0;
+		unsigned have = 0;
+		
+		for(const char* c = text; *c != '\0'; c++)
+		{
+			unsigned char value = base64.values[static_cast<unsigned char>(*c)];
+			
+			if(value == 64)
+				continue;
+			
+			if(value == 65)
+				return false;
+			
+			bits = (bits << 6) | value;
+			have += 6;
+			
+			if(have >= 8)
+			{
+				have -= 8;
+				bytes.push_back(static_cast<unsigned char>(bits >> have));
+			}
+		}
+		
+		return true;
+	}
+	
+	bool TileData::decompress(const std::vector<unsigned char>& in, std::size_t size, std::vector<unsigned char>& out)
+	{
+		out.resize(size);
+		
+		z_stream stream;
+		std::memset(&stream, 0, sizeof(stream));
+		
+		// + 32 finds out whether it's zlib or gzip from the header
+		if(inflateInit2(&stream, 32 + MAX_WBITS) != Z_OK)
+			return false;
+		
+		stream.next_in = const_cast<unsigned char*>(in.data());
+		stream.avail_in = in.size();
+		stream.next_out = out.data();
+		stream.avail_out = out.size();
+		
+		int result = inflate(&stream, Z_FINISH);
+		std::size_t written = stream.total_out;
+		
+		inflateEnd(&stream);
+		
+		return result == Z_STREAM_END && written == size;
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef TILEDATA_HPP
+#define TILEDATA_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+namespace tinyxml2
+{
+	class XMLElement;
+}
+
+namespace swift
+{
+	// reads the tiles of a Tiled layer's <data> element, as csv, base64, or base64 compressed with zlib or gzip.
+	// works on tinyxml2's text in place, without copying it into strings or streams
+	class TileData
+	{
+		public:
+			// gids with Tiled's flip flags cleared, 0 where there's no tile. False if data isn't count tiles,
+			// or its encoding or compression isn't supported
+			static bool read(const tinyxml2::XMLElement* data, unsigned count, std::vector<std::uint32_t>& gids);
+			
+			// comma separated, whitespace is skipped
+			static bool readCSV(const char* text, unsigned count, std::vector<std::uint32_t>& gids);
+			
+			// appends the bytes of the base64 text to bytes, whitespace is skipped
+			static bool decodeBase64(const char* text, std::vector<unsigned char>& bytes);
+			
+			// zlib or gzip, found from the header. size is what the bytes decompress to
+			static bool decompress(const std::vector<unsigned char>& in, std::size_t size, std::vector<unsigned char>& out);
+			
+			// Tiled keeps flipping in the top 3 bits of each gid
+			static const std::uint32_t FLIP_FLAGS = 0xe0000000;
+	};
+}
+
+#endif // TILEDATA_HPP
@@ -0,0 +1,114 @@
+#include "TileGenerator.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Layer.hpp"
+#include "../Math/Hash.hpp"
+
+namespace swift
+{
+	TileGenerator::TileGenerator(unsigned long int s)
+	:	seed(s)
+	{
+	}
+	
+	void TileGenerator::addLayer(const std::vector<Band>& bands, float frequency, unsigned octaves, float lacunarity, float gain)
+	{
+		// layers get noise of their own, seeded in order
+		layers.push_back({OpenSimplexNoise(seed + layers.size()), bands, frequency, std::max(octaves, 1u), lacunarity, gain});
+		
+		std::vector<Band>& sorted = layers.back().bands;
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Band& one, const Band& two)
+		{
+			return one.limit < two.limit;
+		});
+	}
+	
+	unsigned TileGenerator::getLayerCount() const
+	{
+		return static_cast<unsigned>(layers.size());
+	}
+	
+	void TileGenerator::generate(unsigned l, unsigned left, unsigned top, unsigned width, unsigned height, std::vector<std::uint16_t>& ids) const
+	{
+		ids.assign(width * height, 0);
+		
+		if(l >= layers.size() || ids.empty())
+			return;
+		
+		const Rules& rules = layers[l];
+		
+		std::vector<float> values(ids.size());
+		rules.noise.evaluateOctaves(values.data(), width, height, left * rules.frequency, top * rules.frequency, rules.frequency,
+									rules.octaves, rules.lacunarity, rules.gain);
+		
+		for(std::size_t i = 0; i < ids.size(); i++)
+		{
+			for(auto& b : rules.bands)
+			{
+				if(values[i] < b.limit)
+				{
+					if(b.id >= 0 && b.id <= Layer::MAX_ID)
+						ids[i] = static_cast<std::uint16_t>(b.id + 1);
+					
+					break;
+				}
+			}
+		}
+	}
+	
+	int TileGenerator::getMaxID() const
+	{
+		int most = -1;
+		
+		for(auto& r : layers)
+			for(auto& b : r.bands)
+				most = std::max(most, b.id);
+		
+		return most;
+	}
+	
+	unsigned long int TileGenerator::getSeed() const
+	{
+		return seed;
+	}
+	
+	std::uint64_t TileGenerator::getVersion() const
+	{
+		// over the rules, floats by their bits
+		std::uint64_t hash = math::HASH_OFFSET;
+		
+		auto add = [&hash](std::uint32_t word)
+		{
+			hash = math::hash(word, hash);
+		};
+		
+		auto bits = [](float f)
+		{
+			std::uint32_t word;
+			std::memcpy(&word, &f, sizeof(word));
+			return word;
+		};
+		
+		add(Revision);
+		add(static_cast<std::uint32_t>(layers.size()));
+		
+		for(auto& r : layers)
+		{
+			add(bits(r.frequency));
+			add(r.octaves);
+			add(bits(r.lacunarity));
+			add(bits(r.gain));
+			add(static_cast<std::uint32_t>(r.bands.size()));
+			
+			for(auto& b : r.bands)
+			{
+				add(bits(b.limit));
+				add(static_cast<std::uint32_t>(b.id));
+			}
+		}
+		
+		return hash;
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef TILEGENERATOR_HPP
+#define TILEGENERATOR_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "../Noise/OpenSimplexNoise.hpp"
+
+namespace swift
+{
+	// rules for making the tiles of a map from noise, a chunk at a time, instead of loading them.
+	// each layer has its own noise, split into bands of tile types by value.
+	// the same seed and rules always make the same tiles, however the chunks are asked for
+	class TileGenerator
+	{
+		public:
+			// noise below limit, and not below the band before it, gets tile type id. -1 leaves the tile empty
+			struct Band
+			{
+				float limit;
+				int id;
+			};
+			
+			explicit TileGenerator(unsigned long int seed);
+			
+			// bands go up by limit, noise not below any of them is left empty.
+			// frequency is in noise units per tile, octaves are summed as OpenSimplexNoise::evaluateOctaves does
+			void addLayer(const std::vector<Band>& bands, float frequency = 1 / 32.f, unsigned octaves = 4, float lacunarity = 2, float gain = 0.5f);
+			
+			unsigned getLayerCount() const;
+			
+			// the tiles of a rectangle of layer l as Layer keeps them, the type plus 1, 0 where there's none, in rows width long.
+			// only reads the generator, so any number of threads can call it at once
+			void generate(unsigned l, unsigned left, unsigned top, unsigned width, unsigned height, std::vector<std::uint16_t>& ids) const;
+			
+			// highest type any band uses, -1 if none do
+			int getMaxID() const;
+			
+			unsigned long int getSeed() const;
+			
+			// of the rules, and of how tiles are made from them, so tiles cached from other rules are never used.
+			// Revision goes up whenever generate changes what it makes
+			std::uint64_t getVersion() const;
+			
+			static const std::uint32_t Revision = 1;
+		
+		private:
+			struct Rules
+			{
+				OpenSimplexNoise noise;
+				std::vector<Band> bands;
+				float frequency;
+				unsigned octaves;
+				float lacunarity;
+				float gain;
+			};
+			
+			unsigned long int seed;
+			std::vector<Rules> layers;
+	};
+}
+
+#endif // TILEGENERATOR_HPP
@@ -0,0 +1,314 @@
+#include "TileHistory.hpp"
+
+#include "TileMap.hpp"
+#include "../Serialization/ByteStream.hpp"
+
+namespace swift
+{
+	TileHistory::TileHistory(std::size_t b)
+	:	memory(0),
+		budget(b),
+		recording(false),
+		mergeTime(0.25f),
+		mergeable(false)
+	{
+	}
+	
+	void TileHistory::setMergeTime(float seconds)
+	{
+		mergeTime = seconds;
+	}
+	
+	void TileHistory::setBudget(std::size_t bytes)
+	{
+		budget = bytes;
+		trim();
+	}
+	
+	void TileHistory::begin()
+	{
+		if(recording)
+			end();
+		
+		// quick dabs one after another are one change, to undo at once
+		if(mergeable && !undos.empty() && mergeTime > 0 && sinceEnd.getElapsedTime().asSeconds() < mergeTime)
+		{
+			if(decode(undos.back(), pending))
+			{
+				memory -= undos.back().size();
+				undos.pop_back();
+			}
+			else
+				pending.clear();
+		}
+		
+		recording = true;
+	}
+	
+	void TileHistory::end()
+	{
+		if(!recording)
+			return;
+		
+		recording = false;
+		
+		// tiles painted over and back
+		for(auto it = pending.begin(); it != pending.end();)
+		{
+			if(it->second.before == it->second.after)
+				it = pending.erase(it);
+			else
+				++it;
+		}
+		
+		if(pending.empty())
+		{
+			mergeable = false;
+			return;
+		}
+		
+		undos.push_back(encode(pending));
+		memory += undos.back().size();
+		pending.clear();
+		
+		// a new change, what was undone can't come back
+		for(auto& r : redos)
+			memory -= r.size();
+		
+		redos.clear();
+		
+		trim();
+		
+		mergeable = true;
+		sinceEnd.restart();
+	}
+	
+	bool TileHistory::isRecording() const
+	{
+		return recording;
+	}
+	
+	bool TileHistory::set(TileMap& map, unsigned layer, unsigned x, unsigned y, int id)
+	{
+		const Layer* l = map.getLayer(layer);
+		
+		if(!l || x >= l->getSize().x || y >= l->getSize().y)
+			return false;
+		
+		unsigned tile = y * l->getSize().x + x;
+		int before = l->getID(tile);
+		
+		if(!map.setTile(layer, x, y, id))
+			return false;
+		
+		if(recording && before != id)
+		{
+			std::uint64_t key = static_cast<std::uint64_t>(layer) << 32 | tile;
+			auto it = pending.find(key);
+			
+			// the first before and the last after, for tiles painted more than once
+			if(it == pending.end())
+				pending.emplace(key, Change{before, id});
+			else
+				it->second.after = id;
+		}
+		
+		return true;
+	}
+	
+	bool TileHistory::undo(TileMap& map)
+	{
+		if(recording)
+			end();
+		
+		if(undos.empty())
+			return false;
+		
+		redos.push_back(std::move(undos.back()));
+		undos.pop_back();
+		apply(map, redos.back(), true);
+		
+		mergeable = false;
+		return true;
+	}
+	
+	bool TileHistory::redo(TileMap& map)
+	{
+		if(recording)
+			end();
+		
+		if(redos.empty())
+			return false;
+		
+		undos.push_back(std::move(redos.back()));
+		redos.pop_back();
+		apply(map, undos.back(), false);
+		
+		mergeable = false;
+		return true;
+	}
+	
+	bool TileHistory::canUndo() const
+	{
+		return !undos.empty() || (recording && !pending.empty());
+	}
+	
+	bool TileHistory::canRedo() const
+	{
+		return !redos.empty();
+	}
+	
+	void TileHistory::clear()
+	{
+		undos.clear();
+		redos.clear();
+		pending.clear();
+		memory = 0;
+		recording = false;
+		mergeable = false;
+	}
+	
+	std::size_t TileHistory::getMemory() const
+	{
+		return memory;
+	}
+	
+	std::size_t TileHistory::getUndoCount() const
+	{
+		return undos.size();
+	}
+	
+	std::vector<std::uint8_t> TileHistory::encode(const Changes& changes)
+	{
+		ByteWriter out;
+		
+		// ids of a run, as value and repeat count pairs. Brushes paint the same id over and over
+		auto writeIds = [&out](const std::vector<int>& ids)
+		{
+			for(std::size_t i = 0; i < ids.size();)
+			{
+				std::size_t j = i + 1;
+				
+				while(j < ids.size() && ids[j] == ids[i])
+					j++;
+				
+				out.writeUInt(static_cast<std::uint64_t>(ids[i] + 1));
+				out.writeUInt(j - i);
+				i = j;
+			}
+		};
+		
+		std::vector<int> befores;
+		std::vector<int> afters;
+		
+		for(auto it = changes.begin(); it != changes.end();)
+		{
+			// tiles one after another on the same layer, a row of a brush
+			std::uint64_t start = it->first;
+			auto end = it;
+			befores.clear();
+			afters.clear();
+			
+			while(end != changes.end() && end->first == start + befores.size() && end->first >> 32 == start >> 32)
+			{
+				befores.push_back(end->second.before);
+				afters.push_back(end->second.after);
+				++end;
+			}
+			
+			out.writeUInt(start >> 32);
+			out.writeUInt(start & 0xffffffff);
+			out.writeUInt(befores.size());
+			writeIds(befores);
+			writeIds(afters);
+			
+			it = end;
+		}
+		
+		std::vector<std::uint8_t> data = out.getData();
+		data.shrink_to_fit();
+		
+		return data;
+	}
+	
+	bool TileHistory::decode(const std::vector<std::uint8_t>& stroke, Changes& changes)
+	{
+		ByteReader in(stroke);
+		
+		std::vector<int> befores;
+		std::vector<int> afters;
+		
+		auto readIds = [&in](std::vector<int>& ids, std::uint64_t length)
+		{
+			ids.clear();
+			
+			while(ids.size() < length && in.good())
+			{
+				int id = static_cast<int>(in.readUInt()) - 1;
+				std::uint64_t count = in.readUInt();
+				
+				if(count == 0 || count > length - ids.size())
+				{
+					in.fail();
+					return;
+				}
+				
+				ids.insert(ids.end(), count, id);
+			}
+		};
+		
+		while(!in.atEnd() && in.good())
+		{
+			std::uint64_t layer = in.readUInt();
+			std::uint64_t start = in.readUInt();
+			std::uint64_t length = in.readUInt();
+			
+			readIds(befores, length);
+			readIds(afters, length);
+			
+			if(!in.good())
+				break;
+			
+			for(std::uint64_t i = 0; i < length; i++)
+				changes.emplace(layer << 32 | (start + i), Change{befores[i], afters[i]});
+		}
+		
+		return in.good();
+	}
+	
+	void TileHistory::apply(TileMap& map, const std::vector<std::uint8_t>& stroke, bool undoing)
+	{
+		Changes changes;
+		
+		if(!decode(stroke, changes))
+			return;
+		
+		for(auto& c : changes)
+		{
+			unsigned layer = static_cast<unsigned>(c.first >> 32);
+			unsigned tile = static_cast<unsigned>(c.first & 0xffffffff);
+			const Layer* l = map.getLayer(layer);
+			
+			if(!l || l->getSize().x == 0)
+				continue;
+			
+			map.setTile(layer, tile % l->getSize().x, tile / l->getSize().x, undoing ? c.second.before : c.second.after);
+		}
+	}
+	
+	void TileHistory::trim()
+	{
+		while(memory > budget && !undos.empty())
+		{
+			memory -= undos.front().size();
+			undos.pop_front();
+		}
+		
+		// what was undone only comes back after everything undone after it
+		while(memory > budget && !redos.empty())
+		{
+			memory -= redos.front().size();
+			redos.erase(redos.begin());
+		}
+	}
+}
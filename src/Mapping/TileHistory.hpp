@@ -0,0 +1,84 @@
+#ifndef TILEHISTORY_HPP
+#define TILEHISTORY_HPP
+
+#include <SFML/System/Clock.hpp>
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+namespace swift
+{
+	class TileMap;
+	
+	// undo and redo for painting a TileMap. Each stroke keeps only the tiles it changed, what they were and what they
+	// became, as runs of neighboring tiles with their ids run length encoded, so long sessions on big maps stay small.
+	// Undoing and redoing go through TileMap::setTile, patching the map as painting does
+	class TileHistory
+	{
+		public:
+			// bytes of encoded strokes kept, the oldest are forgotten past it
+			explicit TileHistory(std::size_t budget = 16 * 1024 * 1024);
+			
+			// strokes begun less than mergeTime seconds after the last one ended are undone together with it. 0 merges none
+			void setMergeTime(float seconds);
+			void setBudget(std::size_t bytes);
+			
+			// changes between begin and end are one stroke. Ends the stroke already going, if there is one
+			void begin();
+			void end();
+			bool isRecording() const;
+			
+			// sets the tile through map, remembering what it was if it's in a stroke. False if setTile was
+			bool set(TileMap& map, unsigned layer, unsigned x, unsigned y, int id);
+			
+			// false if there's nothing to undo, or redo
+			bool undo(TileMap& map);
+			bool redo(TileMap& map);
+			
+			bool canUndo() const;
+			bool canRedo() const;
+			
+			// for a new map
+			void clear();
+			
+			// bytes of encoded strokes
+			std::size_t getMemory() const;
+			std::size_t getUndoCount() const;
+		
+		private:
+			struct Change
+			{
+				int before;
+				int after;
+			};
+			
+			// by layer, then by tile, so neighbors end up next to each other
+			using Changes = std::map<std::uint64_t, Change>;
+			
+			static std::vector<std::uint8_t> encode(const Changes& changes);
+			static bool decode(const std::vector<std::uint8_t>& stroke, Changes& changes);
+			
+			// the before ids if undoing, the after ids if not
+			static void apply(TileMap& map, const std::vector<std::uint8_t>& stroke, bool undoing);
+			
+			// forgets the oldest strokes until the rest fit the budget
+			void trim();
+			
+			std::deque<std::vector<std::uint8_t>> undos;	// oldest first
+			std::vector<std::vector<std::uint8_t>> redos;	// most recently undone last
+			std::size_t memory;
+			std::size_t budget;
+			
+			Changes pending;	// of the stroke going on
+			bool recording;
+			
+			sf::Clock sinceEnd;
+			float mergeTime;
+			bool mergeable;		// the last stroke was just painted, not undone or redone
+	};
+}
+
+#endif // TILEHISTORY_HPP
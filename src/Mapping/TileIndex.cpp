@@ -0,0 +1,116 @@
+#include "TileIndex.hpp"
+
+#include <SFML/Graphics/Image.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace swift
+{
+	TileIndex::TileIndex()
+	{
+	}
+	
+	bool TileIndex::build(const Layer& layer, const std::vector<Tile>& types, const sf::Vector2u& tileSize)
+	{
+		const sf::Vector2u& size = layer.getSize();
+		
+		if(size.x == 0 || size.y == 0 || tileSize.x == 0 || tileSize.y == 0)
+			return false;
+		
+		// only types the layer uses get frames
+		used.clear();
+		std::size_t mostFrames = 1;
+		
+		sf::Image image;
+		image.create(size.x, size.y, {0, 0, 0, 0});
+		
+		for(unsigned t = 0; t < layer.getNumTiles() && t < size.x * size.y; t++)
+		{
+			int id = layer.getID(t);
+			
+			// transparent where there's no tile
+			if(id < 0 || static_cast<unsigned>(id) >= types.size())
+				continue;
+			
+			if(static_cast<unsigned>(id) >= used.size())
+				used.resize(id + 1, false);
+			
+			if(!used[id])
+			{
+				used[id] = true;
+				mostFrames = std::max(mostFrames, types[id].getFrames().size());
+			}
+			
+			// 16 bits of type
+			image.setPixel(t % size.x, t / size.x, {static_cast<sf::Uint8>(id & 0xff), static_cast<sf::Uint8>(id >> 8), 0, 255});
+		}
+		
+		if(!indices.loadFromImage(image))
+			return false;
+		
+		// 8 bits of frame count, 16 of milliseconds per cycle, then a column and row per frame
+		sf::Image table;
+		table.create(mostFrames + 1, std::max<std::size_t>(used.size(), 1), {0, 0, 0, 0});
+		
+		for(unsigned i = 0; i < used.size(); i++)
+		{
+			if(!used[i])
+				continue;
+			
+			const std::vector<sf::IntRect>& rects = types[i].getFrames();
+			
+			std::size_t count = types[i].isAnimated() ? rects.size() : 1;
+			unsigned time = std::min(static_cast<unsigned>(std::round(types[i].getAnimationTime() * 1000)), 0xffffu);
+			
+			table.setPixel(0, i, {static_cast<sf::Uint8>(std::min<std::size_t>(count, 255)), static_cast<sf::Uint8>(time & 0xff), static_cast<sf::Uint8>(time >> 8), 255});
+			
+			for(std::size_t f = 0; f < count && f < 255; f++)
+				table.setPixel(f + 1, i, {static_cast<sf::Uint8>(rects[f].left / tileSize.x), static_cast<sf::Uint8>(rects[f].top / tileSize.y), 0, 255});
+		}
+		
+		if(!frames.loadFromImage(table))
+			return false;
+		
+		// texels are looked up exactly, never blended
+		indices.setSmooth(false);
+		frames.setSmooth(false);
+		
+		return true;
+	}
+	
+	bool TileIndex::setTile(unsigned x, unsigned y, int id)
+	{
+		sf::Vector2u size = indices.getSize();
+		
+		if(x >= size.x || y >= size.y)
+			return false;
+		
+		if(id >= 0 && (static_cast<unsigned>(id) >= used.size() || !used[id]))
+			return false;
+		
+		// as build writes them
+		sf::Uint8 texel[4] = {0, 0, 0, 0};
+		
+		if(id >= 0)
+		{
+			texel[0] = static_cast<sf::Uint8>(id & 0xff);
+			texel[1] = static_cast<sf::Uint8>(id >> 8);
+			texel[3] = 255;
+		}
+		
+		indices.update(texel, 1, 1, x, y);
+		
+		return true;
+	}
+	
+	const sf::Texture& TileIndex::getIndices() const
+	{
+		return indices;
+	}
+	
+	const sf::Texture& TileIndex::getFrames() const
+	{
+		return frames;
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef TILEINDEX_HPP
+#define TILEINDEX_HPP
+
+#include <SFML/Graphics/Texture.hpp>
+
+#include "Layer.hpp"
+
+namespace swift
+{
+	// a layer as textures for TileMap's shader. The index texture has a texel per tile, holding its type,
+	// or nothing where there is no tile. The frame texture has a row per type: the frame count and
+	// animation time, then where each frame is in the tileset, in tiles
+	class TileIndex
+	{
+		public:
+			TileIndex();
+			
+			// types are the tileset's, by id. tileSize is the size of a tile in the tileset. False if the textures couldn't be made
+			bool build(const Layer& layer, const std::vector<Tile>& types, const sf::Vector2u& tileSize);
+			
+			// tile x, y is now of type id, -1 for none. Only its texel is uploaded. False if the frame texture has no row
+			// for id yet, build is needed then
+			bool setTile(unsigned x, unsigned y, int id);
+			
+			const sf::Texture& getIndices() const;
+			const sf::Texture& getFrames() const;
+		
+		private:
+			sf::Texture indices;
+			sf::Texture frames;
+			std::vector<bool> used;		// types with a row in frames
+	};
+}
+
+#endif // TILEINDEX_HPP
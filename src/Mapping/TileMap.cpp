@@ -1,14 +1,98 @@
 #include "TileMap.hpp"
 
-#include <sstream>
 #include <fstream>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <cstdio>
+#include <iterator>
 
 #include <tinyxml2.h>
 
+#include <SFML/Graphics/Shader.hpp>
+
+#include "TileData.hpp"
+#include "ChunkStreamer.hpp"
+#include "../Serialization/ByteStream.hpp"
+#include "../Serialization/MappedFile.hpp"
 #include "../Logger/Logger.hpp"
+#include "../Profiling/FrameStats.hpp"
+#include "../Profiling/Profiler.hpp"
+#include "../Memory/MemoryTracker.hpp"
+#include "../Memory/FrameArena.hpp"
 
 namespace swift
 {
+	namespace
+	{
+		// the start of maps compiled by saveBinary, then the version of their layout
+		const char binaryMagic[4] = {'S', 'W', 'M', 'B'};
+		const std::uint32_t binaryVersion = 3;
+		
+		// chunks of a generated map made per update, closest first, so coming into view doesn't stall a frame
+		const std::size_t generatedPerUpdate = 16;
+		
+		// the start of a generated chunk's cache file, then the version of its layout
+		const char cacheMagic[4] = {'S', 'W', 'G', 'C'};
+		const std::uint32_t cacheVersion = 1;
+		
+		// texture coordinates are in tiles across the layer. Each texel of indices holds a tile type,
+		// each row of frames the frame count and cycle time of a type, then the tileset cells of its frames
+		const std::string tileShader =
+			"uniform sampler2D tileset;\n"
+			"uniform sampler2D indices;\n"
+			"uniform sampler2D frames;\n"
+			"uniform vec2 mapSize;\n"
+			"uniform vec2 framesSize;\n"
+			"uniform vec2 tileSize;\n"
+			"uniform vec2 tilesetSize;\n"
+			"uniform float time;\n"
+			"\n"
+			"float byte(float channel)\n"
+			"{\n"
+			"	return floor(channel * 255.0 + 0.5);\n"
+			"}\n"
+			"\n"
+			"void main()\n"
+			"{\n"
+			"	vec2 pos = gl_TexCoord[0].xy;\n"
+			"	vec2 tile = floor(pos);\n"
+			"	vec4 index = texture2D(indices, (tile + 0.5) / mapSize);\n"
+			"	\n"
+			"	if(index.a < 0.5)\n"
+			"		discard;\n"
+			"	\n"
+			"	float row = (byte(index.r) + byte(index.g) * 256.0 + 0.5) / framesSize.y;\n"
+			"	vec4 head = texture2D(frames, vec2(0.5 / framesSize.x, row));\n"
+			"	float count = byte(head.r);\n"
+			"	float cycle = (byte(head.g) + byte(head.b) * 256.0) / 1000.0;\n"
+			"	\n"
+			"	float frame = 0.0;\n"
+			"	if(count > 1.0 && cycle > 0.0)\n"
+			"		frame = min(floor(mod(time, cycle) / cycle * count), count - 1.0);\n"
+			"	\n"
+			"	vec4 cell = texture2D(frames, vec2((frame + 1.5) / framesSize.x, row));\n"
+			"	vec2 texel = (vec2(byte(cell.r), byte(cell.g)) + fract(pos)) * tileSize;\n"
+			"	gl_FragColor = gl_Color * texture2D(tileset, texel / tilesetSize);\n"
+			"}\n";
+		
+		// shared by every map, loaded on first use
+		sf::Shader* getTileShader()
+		{
+			static sf::Shader shader;
+			static int loaded = -1;
+			
+			if(loaded == -1)
+				loaded = sf::Shader::isAvailable() && shader.loadFromMemory(tileShader, sf::Shader::Fragment);
+			
+			return loaded == 1 ? &shader : nullptr;
+		}
+	}
+	
+	ThreadPool* TileMap::threadPool = nullptr;
+	AsyncWriter* TileMap::writer = nullptr;
+	
 	TileMap::TileMap()
 	:	tileSize({0, 0}),
 		sizePixels({0, 0}),
@@ -17,7 +101,16 @@ namespace swift
 		textureTileSize({0, 0}),
 		file(""),
 		textureFile(""),
-		texture(nullptr)
+		texture(nullptr),
+		renderMode(RenderMode::Chunks),
+		time(0),
+		verticesBuilt(false),
+		streamed(false),
+		streamBudget(64 * 1024 * 1024),
+		streamMemory(0),
+		streamRadius(512),
+		visibility(nullptr),
+		fogFaction(0)
 	{
 	}
 
@@ -28,29 +121,59 @@ namespace swift
 	
 	void TileMap::update(float dt)
 	{
+		SWIFT_MEMORY_SCOPE(TileMap);
+		
+		time += dt;
+		
+		// once per type, then the layers patch the tiles of types that changed
+		for(auto& t : tileTypes)
+		{
+			t.update(dt);
+		}
+		
+		updateStream();
+		
 		for(auto& l : layers)
 		{
-			l.update(dt);
+			l.update(tileTypes);
 		}
 	}
 
 	bool TileMap::loadFile(const std::string& f)
 	{
+		SWIFT_PROFILE("TileMap::loadFile");
+		SWIFT_MEMORY_SCOPE(TileMap);
+		
 		file = f;
+		streamer.reset();
+		generator.reset();
+		
+		// compiled maps start with their magic number
+		{
+			char magic[4] = {0, 0, 0, 0};
+			std::ifstream fin(f, std::ios::binary);
+			fin.read(magic, 4);
+			
+			if(std::memcmp(magic, binaryMagic, 4) == 0)
+				return loadBinary(f);
+		}
+		
+		layers.clear();
+		verticesBuilt = false;
 		
 		tinyxml2::XMLDocument loadFile;
 		loadFile.LoadFile(f.c_str());
 
 		if(loadFile.Error())
 		{
-			log << "[ERROR] Loading world save file \"" << f << "\" failed.\n";
+			SWIFT_ERROR(World, "Loading world save file \"" << f << "\" failed.\n");
 			return false;
 		}
 
 		tinyxml2::XMLElement* mapRoot = loadFile.FirstChildElement("map");
 		if(mapRoot == nullptr)
 		{
-			log << "[WARNING] World save file \"" << f << "\" does not have a \"map\" root element.\n";
+			SWIFT_WARNING(World, "World save file \"" << f << "\" does not have a \"map\" root element.\n");
 			return false;
 		}
 
@@ -60,67 +183,210 @@ namespace swift
 		tileSize.y = std::stoi(mapRoot->Attribute("tileheight"));
 		sizePixels.x = sizeTiles.x * tileSize.x;
 		sizePixels.y = sizeTiles.y * tileSize.y;
-
-		tinyxml2::XMLElement* tileset = mapRoot->FirstChildElement("tileset");
-		textureTileSize.x = std::stoi(tileset->Attribute("tilewidth"));
-		textureTileSize.y = std::stoi(tileset->Attribute("tileheight"));
-
-		tinyxml2::XMLElement* image = tileset->FirstChildElement("image");
-		textureFile = image->Attribute("source");
-		textureSize.x = std::stoi(image->Attribute("width"));
-		textureSize.y = std::stoi(image->Attribute("height"));
-
-		tinyxml2::XMLElement* tileType = tileset->FirstChildElement("tile");
-		while(tileType != nullptr)
+		
+		// map wide properties
+		bool diagonal = false;
+		streamed = false;
+		
+		tinyxml2::XMLElement* mapProperties = mapRoot->FirstChildElement("properties");
+		if(mapProperties != nullptr)
 		{
-			unsigned int id = std::stoi(tileType->Attribute("id"));
-			tileTypes.emplace(id, TileType());
-			TileType& current = tileTypes[id];
-
-			current.texPos.x = (id % (textureSize.x / textureTileSize.x)) * textureTileSize.x;
-			current.texPos.y = (id / (textureSize.x / textureTileSize.x)) * textureTileSize.y;
-
-			tinyxml2::XMLElement* properties = tileType->FirstChildElement("properties");
-			tinyxml2::XMLElement* property = properties->FirstChildElement("property");
+			tinyxml2::XMLElement* property = mapProperties->FirstChildElement("property");
 			while(property != nullptr)
 			{
-				if(property->Attribute("name", "Passable"))
+				if(property->Attribute("name", "Diagonal"))
 				{
-					current.passable = property->Attribute("value", "1") ? true : false;
+					diagonal = property->Attribute("value", "1") ? true : false;
 				}
-				else if(property->Attribute("name", "Animated"))
+				else if(property->Attribute("name", "Streamed"))
 				{
-					current.animated = property->Attribute("value", "1") ? true : false;
+					// only once compiled, loading the .tmx itself always loads every tile
+					streamed = property->Attribute("value", "1") ? true : false;
 				}
-
+				
 				property = property->NextSiblingElement("property");
 			}
+		}
+
+		// Tiled numbers the tiles of all tilesets one after another, from each tileset's firstgid
+		std::vector<tinyxml2::XMLElement*> tilesetElements;
+		std::vector<std::unique_ptr<tinyxml2::XMLDocument>> externals;
+		tilesets.clear();
+		
+		for(tinyxml2::XMLElement* tileset = mapRoot->FirstChildElement("tileset"); tileset != nullptr; tileset = tileset->NextSiblingElement("tileset"))
+		{
+			Tileset info;
+			info.firstID = tileset->Attribute("firstgid") ? std::max(tileset->UnsignedAttribute("firstgid"), 1u) - 1 : 0;
+			
+			// external tilesets are .tsx files next to the map
+			tinyxml2::XMLElement* root = tileset;
+			
+			if(tileset->Attribute("source"))
+			{
+				std::string dir = f.substr(0, f.find_last_of("/\\") + 1);
+				externals.emplace_back(new tinyxml2::XMLDocument);
+				externals.back()->LoadFile((dir + tileset->Attribute("source")).c_str());
+				root = externals.back()->Error() ? nullptr : externals.back()->FirstChildElement("tileset");
+			}
+			
+			tinyxml2::XMLElement* image = root ? root->FirstChildElement("image") : nullptr;
+			
+			if(image == nullptr || !image->Attribute("source"))
+			{
+				SWIFT_WARNING(World, "Tileset " << static_cast<unsigned>(tilesets.size()) << " of \"" << f << "\" doesn't have an image, its tiles are left out.\n");
+				continue;
+			}
+			
+			info.tileSize.x = root->UnsignedAttribute("tilewidth");
+			info.tileSize.y = root->UnsignedAttribute("tileheight");
+			info.file = image->Attribute("source");
+			info.size.x = image->UnsignedAttribute("width");
+			info.size.y = image->UnsignedAttribute("height");
+			
+			tilesets.push_back(info);
+			tilesetElements.push_back(root);
+		}
+		
+		if(tilesets.empty())
+		{
+			SWIFT_WARNING(World, "World save file \"" << f << "\" does not have a tileset.\n");
+			return false;
+		}
+		
+		// the first tileset decides how big tiles are drawn
+		textureFile = tilesets.front().file;
+		textureTileSize = tilesets.front().tileSize;
+		packTilesets();
+		
+		// every tile of every tileset gets a type, tiles without properties are impassable.
+		// ids no tileset covers get a type with nothing to show
+		unsigned int numTypes = 0;
+		
+		for(auto& t : tilesets)
+			numTypes = std::max(numTypes, t.firstID + t.getCount());
+		
+		if(numTypes > static_cast<unsigned int>(Layer::MAX_ID) + 1)
+		{
+			SWIFT_WARNING(World, "Tilesets of \"" << f << "\" have more than " << Layer::MAX_ID + 1 << " tiles, the rest are left out.\n");
+			numTypes = Layer::MAX_ID + 1;
+		}
+		
+		tileTypes.clear();
+		tileTypes.reserve(numTypes);
+		
+		for(unsigned int id = 0; id < numTypes; id++)
+		{
+			const Tileset* owner = getTileset(id);
+			
+			if(owner)
+			{
+				sf::IntRect rect = owner->getTile(id - owner->firstID);
+				tileTypes.emplace_back(sf::Vector2u(rect.left, rect.top), owner->tileSize, false, id);
+			}
+			else
+				tileTypes.emplace_back(sf::Vector2u(0, 0), sf::Vector2u(0, 0), false, id);
+		}
+		
+		for(std::size_t ts = 0; ts < tilesets.size(); ts++)
+		{
+			const Tileset& tileset = tilesets[ts];
+			
+			tinyxml2::XMLElement* tileType = tilesetElements[ts]->FirstChildElement("tile");
+			while(tileType != nullptr)
+			{
+				unsigned int local = tileType->UnsignedAttribute("id");
+				unsigned int id = tileset.firstID + local;
+				
+				if(local >= tileset.getCount() || id >= tileTypes.size())
+				{
+					tileType = tileType->NextSiblingElement("tile");
+					continue;
+				}
+				
+				Tile& current = tileTypes[id];
+
+				tinyxml2::XMLElement* properties = tileType->FirstChildElement("properties");
+				tinyxml2::XMLElement* property = properties ? properties->FirstChildElement("property") : nullptr;
+				while(property != nullptr)
+				{
+					if(property->Attribute("name", "Passable"))
+					{
+						current.setPassable(property->Attribute("value", "1") ? true : false);
+					}
+					else if(property->Attribute("name", "Animated"))
+					{
+						current.setAnimated(property->Attribute("value", "1") ? true : false);
+					}
+					else if(property->Attribute("name", "Cost"))
+					{
+						current.setCost(property->UnsignedAttribute("value"));
+					}
+
+					property = property->NextSiblingElement("property");
+				}
+				
+				// Tiled's animation frames, each another tile of the same tileset shown for a number of milliseconds
+				std::vector<sf::IntRect> frames;
+				float animationTime = 0;
+				
+				tinyxml2::XMLElement* animation = tileType->FirstChildElement("animation");
+				tinyxml2::XMLElement* frame = animation ? animation->FirstChildElement("frame") : nullptr;
+				while(frame != nullptr)
+				{
+					frames.push_back(tileset.getTile(frame->UnsignedAttribute("tileid")));
+					animationTime += frame->UnsignedAttribute("duration") / 1000.f;
+					
+					frame = frame->NextSiblingElement("frame");
+				}
+				
+				// frames without the property still animate
+				if(!frames.empty())
+				{
+					current.setFrames(frames);
+					current.setAnimationTime(animationTime);
+					current.setAnimated(true);
+				}
 
-			tileType = tileType->NextSiblingElement("tile");
+				tileType = tileType->NextSiblingElement("tile");
+			}
 		}
 
+		// reused by every layer
+		std::vector<std::uint32_t> gids;
+		
 		tinyxml2::XMLElement* layer = mapRoot->FirstChildElement("layer");
 		while(layer != nullptr)
 		{
 			layers.emplace_back(sizeTiles, tileSize);
 
-			tinyxml2::XMLElement* data = layer->FirstChildElement("data");
-			std::string mapTiles = data->GetText();
-			std::istringstream iss(mapTiles);
-			std::string tileNum;
+			if(!TileData::read(layer->FirstChildElement("data"), sizeTiles.x * sizeTiles.y, gids))
+			{
+				SWIFT_WARNING(World, "Layer " << static_cast<unsigned>(layers.size() - 1) << " of \"" << f << "\" isn't " << sizeTiles.x * sizeTiles.y
+					<< " tiles of csv, base64, or zlib or gzip compressed base64.\n");
+				return false;
+			}
 			
-			while(std::getline(iss, tileNum, ','))
+			for(auto& g : gids)
 			{
-				int gid = std::stoi(tileNum) - 1;	// Tiled stores gids as tileset # + id in a tileset since I'm just using 1 tileset... "- 1" makes it easy
+				int gid = static_cast<int>(g) - 1;	// types are numbered like gids, from 0 instead of 1
 				
-				if(gid != -1)
-					layers.back().addTile(tileTypes[gid].texPos, textureTileSize, tileTypes[gid].passable, gid);
+				if(gid >= 0 && static_cast<unsigned int>(gid) < tileTypes.size() && tileTypes[gid].getFrame().width != 0)
+				{
+					const Tile& type = tileTypes[gid];
+					layers.back().addTile(gid, type.isPassable(), type.getCost(), type.isAnimated() && type.getFrames().size() > 1);
+				}
 				else	// if no tile goes here
-					layers.back().addTile({0, 0}, {0, 0}, true, -1);
+					layers.back().addTile(-1, true);
 			}
 
 			layer = layer->NextSiblingElement("layer");
 		}
+		
+		for(auto& l : layers)
+		{
+			l.setDiagonal(diagonal);
+			l.buildClusters();
+		}
 
 		return true;
 	}
@@ -130,49 +396,207 @@ namespace swift
 		texture = &tex;
 		if(!texture)
 			return false;
+		
+		// compiled maps come with their vertices
+		if(!verticesBuilt && !buildVertices())
+			return false;
+		
+		if(renderMode == RenderMode::Shader)
+			buildIndices();
 
-		sf::Vector2f scale = {static_cast<float>(tileSize.x) / textureTileSize.x, static_cast<float>(tileSize.y) / textureTileSize.y};
-
+		return true;
+	}
+	
+	bool TileMap::loadTextures(const std::vector<const sf::Texture*>& textures)
+	{
+		// maps made in the editor don't list their tileset
+		if(textures.size() == 1 && tilesets.size() <= 1)
+			return textures[0] && loadTexture(*textures[0]);
+		
+		if(textures.size() != tilesets.size())
+		{
+			SWIFT_ERROR(World, "\"" << file << "\" has " << static_cast<unsigned>(tilesets.size()) << " tilesets, but was given "
+				<< static_cast<unsigned>(textures.size()) << " textures.\n");
+			return false;
+		}
+		
+		if(!atlas)
+			atlas.reset(new sf::Texture);
+		
+		if(std::max(textureSize.x, textureSize.y) > sf::Texture::getMaximumSize() || !atlas->create(textureSize.x, textureSize.y))
+		{
+			SWIFT_ERROR(World, "The tilesets of \"" << file << "\" don't fit in one " << sf::Texture::getMaximumSize() << " pixel texture.\n");
+			return false;
+		}
+		
+		for(std::size_t i = 0; i < textures.size(); i++)
+		{
+			if(textures[i] == nullptr)
+				return false;
+			
+			const Tileset& t = tilesets[i];
+			sf::Image image = textures[i]->copyToImage();
+			
+			// the image may be bigger than the map said, what's past that was never given any tiles
+			if(image.getSize().x < t.size.x || image.getSize().y < t.size.y)
+			{
+				SWIFT_ERROR(World, "Texture \"" << t.file << "\" is smaller than \"" << file << "\" says it is.\n");
+				return false;
+			}
+			
+			sf::Image part;
+			part.create(t.size.x, t.size.y, {0, 0, 0, 0});
+			part.copy(image, 0, 0, {0, 0, static_cast<int>(t.size.x), static_cast<int>(t.size.y)});
+			atlas->update(part, t.position.x, t.position.y);
+		}
+		
+		return loadTexture(*atlas);
+	}
+	
+	bool TileMap::saveBinary(const std::string& f)
+	{
+		// only what's loaded is here
+		if(isStreaming())
+		{
+			SWIFT_ERROR(World, "Streamed map \"" << file << "\" can't be compiled again.\n");
+			return false;
+		}
+		
+		if(!verticesBuilt && !buildVertices())
+			return false;
+		
+		ByteWriter writer;
+		
+		// raw arrays start on their own alignment, so they can be used straight from the mapped file
+		auto align = [&writer](std::size_t a)
+		{
+			while(writer.size() % a != 0)
+				writer.writeByte(0);
+		};
+		
+		// raw arrays are in the byte order and layout of the machine that compiled them
+		const std::uint32_t order = 0x01020304;
+		
+		writer.writeBytes(binaryMagic, 4);
+		writer.writeUInt32(binaryVersion);
+		writer.writeBytes(&order, 4);
+		writer.writeUInt(sizeof(sf::Vertex));
+		
+		writer.writeUInt(sizeTiles.x);
+		writer.writeUInt(sizeTiles.y);
+		writer.writeUInt(tileSize.x);
+		writer.writeUInt(tileSize.y);
+		writer.writeUInt(textureSize.x);
+		writer.writeUInt(textureSize.y);
+		writer.writeUInt(textureTileSize.x);
+		writer.writeUInt(textureTileSize.y);
+		writer.writeString(textureFile);
+		writer.writeUInt(tilesets.size());
+		
+		for(auto& t : tilesets)
+		{
+			writer.writeString(t.file);
+			writer.writeUInt(t.firstID);
+			writer.writeUInt(t.size.x);
+			writer.writeUInt(t.size.y);
+			writer.writeUInt(t.tileSize.x);
+			writer.writeUInt(t.tileSize.y);
+			writer.writeUInt(t.position.x);
+			writer.writeUInt(t.position.y);
+		}
+		
+		writer.writeBool(!layers.empty() && layers.front().getPassability().isDiagonal());
+		writer.writeBool(streamed);
+		
+		writer.writeUInt(tileTypes.size());
+		
+		for(auto& t : tileTypes)
+		{
+			writer.writeBool(t.isPassable());
+			writer.writeUInt(t.getCost());
+			writer.writeBool(t.isAnimated());
+			writer.writeFloat(t.getAnimationTime());
+			writer.writeUInt(t.getFrames().size());
+			
+			for(auto& r : t.getFrames())
+			{
+				writer.writeUInt(r.left);
+				writer.writeUInt(r.top);
+				writer.writeUInt(r.width);
+				writer.writeUInt(r.height);
+			}
+		}
+		
+		writer.writeUInt(layers.size());
+		
 		for(auto& l : layers)
 		{
-			for(unsigned i = 0; i < sizeTiles.x; i++)
+			const std::vector<std::uint64_t>& blocked = l.passability.getBlocked();
+			const std::vector<std::uint8_t>& costs = l.passability.getCosts();
+			
+			writer.writeUInt(blocked.size());
+			align(sizeof(std::uint64_t));
+			writer.writeBytes(blocked.data(), blocked.size() * sizeof(std::uint64_t));
+			
+			writer.writeUInt(costs.size());
+			writer.writeBytes(costs.data(), costs.size());
+			
+			// where each chunk's record starts, so streamed maps can read any one of them
+			writer.writeUInt(l.chunks.size());
+			std::size_t table = writer.size();
+			
+			for(std::size_t c = 0; c < l.chunks.size(); c++)
+				writer.writeBytes("\0\0\0\0\0\0\0\0", 8);
+			
+			for(std::size_t c = 0; c < l.chunks.size(); c++)
 			{
-				for(unsigned j = 0; j < sizeTiles.y; j++)
-				{
-					if(i + j * sizeTiles.x >= l.getNumTiles())
-						return false;
-
-					// pointer to quad
-					sf::Vertex* quad = &l.vertices[(i + j * sizeTiles.x) * 4];
-
-					// current tile number
-					int tileNum = l.getTile(i + j * sizeTiles.x)->getID();
-					
-					// if no tile should be displayed here, make it transparent
-					if(tileNum == -1)
-					{
-						quad[0].color = {0, 0, 0, 0};
-						quad[1].color = {0, 0, 0, 0};
-						quad[2].color = {0, 0, 0, 0};
-						quad[3].color = {0, 0, 0, 0};
-					}
-					
-					// define 4 corners
-					quad[0].position = {std::floor(i * static_cast<float>(tileSize.x) * scale.x), std::floor(j * static_cast<float>(tileSize.y) * scale.y)};
-					quad[1].position = {std::floor((i + 1) * static_cast<float>(tileSize.x) * scale.x), std::floor(j * static_cast<float>(tileSize.y) * scale.y)};
-					quad[2].position = {std::floor((i + 1) * static_cast<float>(tileSize.x) * scale.x), std::floor((j + 1) * static_cast<float>(tileSize.y) * scale.y)};
-					quad[3].position = {std::floor(i * static_cast<float>(tileSize.x) * scale.x), std::floor((j + 1) * static_cast<float>(tileSize.y) * scale.y)};
-
-					// define 4 tex coordinates
-					quad[0].texCoords = {static_cast<float>(tileTypes[tileNum].texPos.x), static_cast<float>(tileTypes[tileNum].texPos.y)};
-					quad[1].texCoords = {static_cast<float>(tileTypes[tileNum].texPos.x + tileSize.x), static_cast<float>(tileTypes[tileNum].texPos.y)};
-					quad[2].texCoords = {static_cast<float>(tileTypes[tileNum].texPos.x + tileSize.x), static_cast<float>(tileTypes[tileNum].texPos.y + tileSize.y)};
-					quad[3].texCoords = {static_cast<float>(tileTypes[tileNum].texPos.x), static_cast<float>(tileTypes[tileNum].texPos.y + tileSize.y)};
-				}
+				std::uint64_t offset = writer.size();
+				writer.patchUInt32(table + c * 8, static_cast<std::uint32_t>(offset));
+				writer.patchUInt32(table + c * 8 + 4, static_cast<std::uint32_t>(offset >> 32));
+				
+				ChunkStreamer::write(writer, l.chunks[c].ids, l.chunks[c].animated, l.chunks[c].vertices);
 			}
 		}
-
-		return true;
+		
+		std::ofstream fout(f, std::ios::binary);
+		
+		if(!fout)
+		{
+			SWIFT_ERROR(World, "Could not write compiled map \"" << f << "\".\n");
+			return false;
+		}
+		
+		fout.write(reinterpret_cast<const char*>(writer.getData().data()), writer.size());
+		
+		return static_cast<bool>(fout);
+	}
+	
+	void TileMap::setRenderMode(RenderMode m)
+	{
+		if(m == RenderMode::Shader && !getTileShader())
+		{
+			SWIFT_WARNING(World, "Tile shader isn't available, drawing tilemap chunks instead.\n");
+			m = RenderMode::Chunks;
+		}
+		
+		// the indices would have to be rebuilt whenever a chunk is paged in
+		if(m == RenderMode::Shader && isStreaming())
+		{
+			SWIFT_WARNING(World, "Streamed maps can't be drawn with the tile shader, drawing tilemap chunks instead.\n");
+			m = RenderMode::Chunks;
+		}
+		
+		renderMode = m;
+		
+		if(renderMode == RenderMode::Shader && texture)
+			buildIndices();
+		else
+			indices.clear();
+	}
+	
+	TileMap::RenderMode TileMap::getRenderMode() const
+	{
+		return renderMode;
 	}
 
 	void TileMap::setTileSize(const sf::Vector2u& ts)
@@ -192,8 +616,8 @@ namespace swift
 
 	const Tile* TileMap::getTile(unsigned int t, unsigned int l) const
 	{
-		if(l < layers.size() && t < layers[l].getNumTiles())
-			return layers[l].getTile(t);
+		if(l < layers.size())
+			return getType(layers[l].getID(t));
 		else
 			return nullptr;
 	}
@@ -201,11 +625,121 @@ namespace swift
 	const Tile* TileMap::getTile(const sf::Vector2f& pos, unsigned int l) const
 	{
 		if(l < layers.size())
-			return layers[l].getTile(pos);
+			return getType(layers[l].getID(pos));
+		else
+			return nullptr;
+	}
+	
+	const Tile* TileMap::getType(int id) const
+	{
+		if(id >= 0 && static_cast<unsigned int>(id) < tileTypes.size())
+			return &tileTypes[id];
 		else
 			return nullptr;
 	}
 
+	bool TileMap::setTile(unsigned l, unsigned x, unsigned y, int id)
+	{
+		if(l >= layers.size() || id < -1 || id >= static_cast<int>(tileTypes.size()))
+			return false;
+		
+		if(!layers[l].setTile(x, y, id, tileTypes))
+			return false;
+		
+		// types the index has no frames for yet need the whole layer's
+		if(l < indices.size() && !indices[l].setTile(x, y, id))
+			indices[l].build(layers[l], tileTypes, textureTileSize);
+		
+		return true;
+	}
+	
+	bool TileMap::isPassable(int x, int y, unsigned int l) const
+	{
+		return l >= layers.size() || layers[l].isPassable(x, y);
+	}
+	
+	bool TileMap::getIDs(const sf::IntRect& area, unsigned int l, std::vector<int>& ids) const
+	{
+		if(l >= layers.size())
+			return false;
+		
+		layers[l].getIDs(area, ids);
+		return true;
+	}
+	
+	bool TileMap::getPassable(const sf::IntRect& area, unsigned int l, std::vector<std::uint8_t>& passable) const
+	{
+		if(l >= layers.size())
+			return false;
+		
+		layers[l].getPassable(area, passable);
+		return true;
+	}
+	
+	bool TileMap::forEachChunk(const sf::IntRect& area, unsigned int l, const std::function<void(const Layer::ChunkSpan&)>& f) const
+	{
+		if(l >= layers.size())
+			return false;
+		
+		layers[l].forEachChunk(area, f);
+		return true;
+	}
+	
+	bool TileMap::raycast(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l, sf::Vector2i& tile, float& fraction) const
+	{
+		if(l >= layers.size() || tileSize.x == 0 || tileSize.y == 0)
+			return false;
+		
+		const sf::Vector2f scale(1.f / tileSize.x, 1.f / tileSize.y);
+		
+		return layers[l].getPassability().raycast({from.x * scale.x, from.y * scale.y}, {to.x * scale.x, to.y * scale.y}, tile, fraction);
+	}
+	
+	bool TileMap::hasLineOfSight(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l) const
+	{
+		sf::Vector2i tile;
+		float fraction;
+		
+		return !raycast(from, to, l, tile, fraction);
+	}
+	
+	void TileMap::hasLineOfSight(const sf::Vector2f* from, const sf::Vector2f* to, std::size_t count, unsigned int l, unsigned char* visible) const
+	{
+		auto check = [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t i = begin; i < end; i++)
+				visible[i] = hasLineOfSight(from[i], to[i], l);
+		};
+		
+		if(threadPool)
+			threadPool->parallelFor(count, check);
+		else
+			check(0, count);
+	}
+	
+	sf::Vector2f TileMap::sweep(const sf::FloatRect& box, const sf::Vector2f& delta, unsigned int l) const
+	{
+		if(l >= layers.size() || tileSize.x == 0 || tileSize.y == 0)
+			return delta;
+		
+		sf::Vector2f moved;
+		sf::FloatRect current = box;
+		
+		moved.x = sweepAxis(current, delta.x, true, layers[l]);
+		current.left += moved.x;
+		
+		moved.y = sweepAxis(current, delta.y, false, layers[l]);
+		
+		return moved;
+	}
+	
+	void TileMap::setVisibility(const VisibilityMap* v, unsigned faction)
+	{
+		visibility = v;
+		fogFaction = faction;
+		fogChunks.clear();
+	}
+	
 	const sf::Vector2u& TileMap::getTileSize() const
 	{
 		return tileSize;
@@ -221,7 +755,25 @@ namespace swift
 		return textureFile;
 	}
 	
-	const std::string& TileMap::getFile() const
+	std::vector<std::string> TileMap::getTextureFiles() const
+	{
+		std::vector<std::string> files;
+		
+		for(auto& t : tilesets)
+			files.push_back(t.file);
+		
+		if(files.empty())
+			files.push_back(textureFile);
+		
+		return files;
+	}
+	
+	const sf::Texture* TileMap::getTexture() const
+	{
+		return texture;
+	}
+	
+	const std::string& TileMap::getFile() const
 	{
 		return file;
 	}
@@ -231,13 +783,1100 @@ namespace swift
 		return tileTypes.size();
 	}
 
+	unsigned int TileMap::getNumLayers() const
+	{
+		return layers.size();
+	}
+	
+	const Layer* TileMap::getLayer(unsigned int l) const
+	{
+		return l < layers.size() ? &layers[l] : nullptr;
+	}
+
+	float TileMap::sweepAxis(const sf::FloatRect& box, float delta, bool horizontal, const Layer& layer) const
+	{
+		if(delta == 0.f)
+			return 0.f;
+		
+		// size of a tile along the movement, and across it
+		float along = static_cast<float>(horizontal ? tileSize.x : tileSize.y);
+		float across = static_cast<float>(horizontal ? tileSize.y : tileSize.x);
+		
+		float start = horizontal ? box.left : box.top;
+		float length = horizontal ? box.width : box.height;
+		float side = horizontal ? box.top : box.left;
+		float sideLength = horizontal ? box.height : box.width;
+		
+		// rows (or columns) the box covers across the movement
+		int first = static_cast<int>(std::floor(side / across));
+		int last = std::max(first, static_cast<int>(std::ceil((side + sideLength) / across)) - 1);
+		
+		// walk the tile lines the leading edge crosses, one at a time
+		if(delta > 0.f)
+		{
+			float leading = start + length;
+			int begin = static_cast<int>(std::ceil(leading / along));
+			int end = static_cast<int>(std::ceil((leading + delta) / along)) - 1;
+			
+			for(int i = begin; i <= end; i++)
+			{
+				if(!linePassable(layer, i, first, last, horizontal))
+					return i * along - leading;
+			}
+		}
+		else
+		{
+			float leading = start;
+			int begin = static_cast<int>(std::floor(leading / along)) - 1;
+			int end = static_cast<int>(std::floor((leading + delta) / along));
+			
+			for(int i = begin; i >= end; i--)
+			{
+				if(!linePassable(layer, i, first, last, horizontal))
+					return (i + 1) * along - leading;
+			}
+		}
+		
+		return delta;
+	}
+	
+	bool TileMap::linePassable(const Layer& layer, int line, int first, int last, bool column)
+	{
+		if(!column)
+			return layer.isRowPassable(line, first, last);
+		
+		for(int j = first; j <= last; j++)
+		{
+			if(!layer.isPassable(line, j))
+				return false;
+		}
+		
+		return true;
+	}
+	
 	void TileMap::draw(sf::RenderTarget& target, sf::RenderStates states) const
 	{
+		SWIFT_MEMORY_SCOPE(TileMap);
+		
+		// streamed chunks are loaded around what was last seen
+		if(isStreaming())
+		{
+			const sf::View& view = target.getView();
+			streamView = states.transform.getInverse().transformRect({view.getCenter() - view.getSize() / 2.f, view.getSize()});
+		}
+		
+		if(renderMode == RenderMode::Shader && indices.size() == layers.size())
+		{
+			drawShaded(target, states);
+			drawFog(target, states);
+			return;
+		}
+		
 		states.texture = texture;
 
 		for(auto& l : layers)
 		{
 			target.draw(l, states);
 		}
+		
+		drawFog(target, states);
+	}
+	
+	void TileMap::drawShaded(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		sf::Shader* shader = getTileShader();
+		
+		if(!shader || !texture)
+			return;
+		
+		// covers the same area the tiles' vertices do
+		sf::Vector2f scale = {static_cast<float>(tileSize.x) / textureTileSize.x, static_cast<float>(tileSize.y) / textureTileSize.y};
+		sf::Vector2f extent = {std::floor(sizeTiles.x * static_cast<float>(tileSize.x) * scale.x), std::floor(sizeTiles.y * static_cast<float>(tileSize.y) * scale.y)};
+		sf::Vector2f tiles = {static_cast<float>(sizeTiles.x), static_cast<float>(sizeTiles.y)};
+		
+		// texture coordinates in tiles, the shader finds the texel in the tileset itself
+		sf::Vertex quad[4] =
+		{
+			{{0, 0}, {0, 0}},
+			{{extent.x, 0}, {tiles.x, 0}},
+			{extent, tiles},
+			{{0, extent.y}, {0, tiles.y}},
+		};
+		
+		shader->setParameter("tileset", *texture);
+		shader->setParameter("mapSize", tiles);
+		shader->setParameter("tileSize", {static_cast<float>(textureTileSize.x), static_cast<float>(textureTileSize.y)});
+		shader->setParameter("tilesetSize", {static_cast<float>(texture->getSize().x), static_cast<float>(texture->getSize().y)});
+		shader->setParameter("time", time);
+		
+		// no texture, so the coordinates reach the shader as they are
+		states.texture = nullptr;
+		states.shader = shader;
+		
+		for(auto& index : indices)
+		{
+			sf::Vector2u framesSize = index.getFrames().getSize();
+			
+			shader->setParameter("indices", index.getIndices());
+			shader->setParameter("frames", index.getFrames());
+			shader->setParameter("framesSize", {static_cast<float>(framesSize.x), static_cast<float>(framesSize.y)});
+			
+			target.draw(quad, 4, sf::PrimitiveType::Quads, states);
+			FrameStats::countDraw(FrameStats::Draws::TileMap, 4);
+		}
+	}
+	
+	void TileMap::drawFog(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		if(!visibility || visibility->getSize() != sizeTiles || sizeTiles.x == 0 || sizeTiles.y == 0)
+			return;
+		
+		const unsigned chunkSize = VisibilityMap::ChunkSize;
+		const sf::Vector2u& chunkCount = visibility->getChunkCount();
+		
+		if(fogChunks.size() != chunkCount.x * chunkCount.y || fogColumns.size() != sizeTiles.x + 1 || fogRows.size() != sizeTiles.y + 1)
+		{
+			fogChunks.assign(chunkCount.x * chunkCount.y, {sf::VertexArray(sf::PrimitiveType::Quads), 0, false});
+			getEdges(fogColumns, fogRows);
+		}
+		
+		const sf::View& view = target.getView();
+		sf::Vector2f viewSize = view.getSize();
+		
+		if(view.getRotation() != 0)
+		{
+			float diagonal = std::sqrt(viewSize.x * viewSize.x + viewSize.y * viewSize.y);
+			viewSize = {diagonal, diagonal};
+		}
+		
+		sf::FloatRect visible = states.transform.getInverse().transformRect({view.getCenter() - viewSize / 2.f, viewSize});
+		
+		const sf::Color seen(0, 0, 0, 160);
+		const sf::Color unseen(0, 0, 0, 255);
+		
+		states.texture = nullptr;
+		
+		for(unsigned cy = 0; cy < chunkCount.y; cy++)
+		{
+			unsigned top = cy * chunkSize;
+			unsigned bottom = std::min(top + chunkSize, sizeTiles.y);
+			
+			for(unsigned cx = 0; cx < chunkCount.x; cx++)
+			{
+				unsigned left = cx * chunkSize;
+				unsigned right = std::min(left + chunkSize, sizeTiles.x);
+				
+				sf::FloatRect bounds(fogColumns[left], fogRows[top], fogColumns[right] - fogColumns[left], fogRows[bottom] - fogRows[top]);
+				
+				if(!bounds.intersects(visible))
+					continue;
+				
+				unsigned c = cy * chunkCount.x + cx;
+				FogChunk& chunk = fogChunks[c];
+				unsigned revision = visibility->getRevision(fogFaction, c);
+				
+				if(!chunk.built || chunk.revision != revision)
+				{
+					const std::uint64_t* visibleRows = visibility->getVisibleRows(fogFaction, c);
+					const std::uint64_t* exploredRows = visibility->getExploredRows(fogFaction, c);
+					
+					chunk.vertices.clear();
+					
+					for(unsigned y = top; y < bottom; y++)
+					{
+						std::uint64_t now = visibleRows ? visibleRows[y - top] : 0;
+						std::uint64_t ever = exploredRows ? exploredRows[y - top] : 0;
+						
+						// runs of tiles fogged the same, seen now ones need no quad
+						unsigned x = left;
+						
+						while(x < right)
+						{
+							unsigned bit = x - left;
+							bool lit = (now >> bit) & 1;
+							bool known = (ever >> bit) & 1;
+							unsigned end = x + 1;
+							
+							while(end < right && ((now >> (end - left)) & 1) == lit && ((ever >> (end - left)) & 1) == known)
+								end++;
+							
+							if(!lit)
+							{
+								sf::Color color = known ? seen : unseen;
+								
+								chunk.vertices.append({{fogColumns[x], fogRows[y]}, color});
+								chunk.vertices.append({{fogColumns[end], fogRows[y]}, color});
+								chunk.vertices.append({{fogColumns[end], fogRows[y + 1]}, color});
+								chunk.vertices.append({{fogColumns[x], fogRows[y + 1]}, color});
+							}
+							
+							x = end;
+						}
+					}
+					
+					chunk.revision = revision;
+					chunk.built = true;
+				}
+				
+				if(chunk.vertices.getVertexCount() == 0)
+					continue;
+				
+				target.draw(chunk.vertices, states);
+				FrameStats::countDraw(FrameStats::Draws::TileMap, chunk.vertices.getVertexCount());
+			}
+		}
+	}
+	
+	void TileMap::buildIndices()
+	{
+		// the shader finds tiles by cell, which only works if every tileset's cells are the same size
+		for(auto& t : tilesets)
+		{
+			if(t.tileSize != textureTileSize)
+			{
+				SWIFT_WARNING(World, "Tilesets of \"" << file << "\" have different tile sizes, drawing tilemap chunks instead.\n");
+				indices.clear();
+				renderMode = RenderMode::Chunks;
+				return;
+			}
+		}
+		
+		indices.assign(layers.size(), TileIndex());
+		
+		for(std::size_t i = 0; i < layers.size(); i++)
+		{
+			if(!indices[i].build(layers[i], tileTypes, textureTileSize))
+			{
+				SWIFT_WARNING(World, "Could not build the tile index of layer " << static_cast<unsigned>(i) << ", drawing tilemap chunks instead.\n");
+				indices.clear();
+				renderMode = RenderMode::Chunks;
+				return;
+			}
+		}
+	}
+	
+	unsigned int TileMap::Tileset::getCount() const
+	{
+		if(tileSize.x == 0 || tileSize.y == 0)
+			return 0;
+		
+		return (size.x / tileSize.x) * (size.y / tileSize.y);
+	}
+	
+	sf::IntRect TileMap::Tileset::getTile(unsigned int local) const
+	{
+		unsigned int columns = tileSize.x != 0 ? size.x / tileSize.x : 0;
+		
+		if(columns == 0)
+			return {0, 0, 0, 0};
+		
+		return {static_cast<int>(position.x + local % columns * tileSize.x), static_cast<int>(position.y + local / columns * tileSize.y),
+				static_cast<int>(tileSize.x), static_cast<int>(tileSize.y)};
+	}
+	
+	void TileMap::packTilesets()
+	{
+		// rows of tilesets, left to right, each row as tall as its tallest tileset
+		unsigned int width = 2048;
+		
+		for(auto& t : tilesets)
+			width = std::max(width, t.size.x);
+		
+		// on whole tiles, so the shader can still find tiles by cell when tilesets share a tile size
+		auto snap = [](unsigned int v, unsigned int step)
+		{
+			return step != 0 ? (v + step - 1) / step * step : v;
+		};
+		
+		sf::Vector2u pos = {0, 0};
+		unsigned int rowHeight = 0;
+		textureSize = {0, 0};
+		
+		for(auto& t : tilesets)
+		{
+			if(pos.x != 0 && pos.x + t.size.x > width)
+			{
+				pos.x = 0;
+				pos.y = snap(pos.y + rowHeight, textureTileSize.y);
+				rowHeight = 0;
+			}
+			
+			t.position = pos;
+			textureSize.x = std::max(textureSize.x, pos.x + t.size.x);
+			textureSize.y = std::max(textureSize.y, pos.y + t.size.y);
+			
+			pos.x = snap(pos.x + t.size.x, textureTileSize.x);
+			rowHeight = std::max(rowHeight, t.size.y);
+		}
+	}
+	
+	const TileMap::Tileset* TileMap::getTileset(unsigned int id) const
+	{
+		for(auto& t : tilesets)
+		{
+			if(id >= t.firstID && id < t.firstID + t.getCount())
+				return &t;
+		}
+		
+		return nullptr;
+	}
+	
+	bool TileMap::readHeader(ByteReader& reader, const std::string& f, bool& diagonal)
+	{
+		std::uint32_t order = 0;
+		
+		reader.skip(4);
+		std::uint32_t version = reader.readUInt32();
+		reader.readBytes(&order, 4);
+		std::uint64_t vertexSize = reader.readUInt();
+		
+		if(!reader.good() || version != binaryVersion || order != 0x01020304 || vertexSize != sizeof(sf::Vertex))
+		{
+			SWIFT_ERROR(World, "Compiled map \"" << f << "\" is from another version, or another kind of machine. Compile it again.\n");
+			return false;
+		}
+		
+		sizeTiles.x = reader.readUInt();
+		sizeTiles.y = reader.readUInt();
+		tileSize.x = reader.readUInt();
+		tileSize.y = reader.readUInt();
+		sizePixels.x = sizeTiles.x * tileSize.x;
+		sizePixels.y = sizeTiles.y * tileSize.y;
+		textureSize.x = reader.readUInt();
+		textureSize.y = reader.readUInt();
+		textureTileSize.x = reader.readUInt();
+		textureTileSize.y = reader.readUInt();
+		textureFile = reader.readString();
+		
+		std::uint64_t numTilesets = reader.readUInt();
+		tilesets.clear();
+		
+		// each tileset takes at least a byte
+		if(numTilesets > reader.remaining())
+			reader.fail();
+		
+		for(std::uint64_t i = 0; i < numTilesets && reader.good(); i++)
+		{
+			Tileset t;
+			t.file = reader.readString();
+			t.firstID = reader.readUInt();
+			t.size.x = reader.readUInt();
+			t.size.y = reader.readUInt();
+			t.tileSize.x = reader.readUInt();
+			t.tileSize.y = reader.readUInt();
+			t.position.x = reader.readUInt();
+			t.position.y = reader.readUInt();
+			tilesets.push_back(t);
+		}
+		
+		diagonal = reader.readBool();
+		streamed = reader.readBool();
+		
+		tileTypes.clear();
+		layers.clear();
+		verticesBuilt = false;
+		
+		std::uint64_t numTypes = reader.readUInt();
+		
+		for(std::uint64_t id = 0; id < numTypes && reader.good(); id++)
+		{
+			bool passable = reader.readBool();
+			unsigned cost = reader.readUInt();
+			bool animated = reader.readBool();
+			float animationTime = reader.readFloat();
+			
+			std::uint64_t numFrames = reader.readUInt();
+			
+			if(numFrames == 0 || numFrames > reader.remaining())
+			{
+				reader.fail();
+				break;
+			}
+			
+			std::vector<sf::IntRect> frames(numFrames);
+			
+			for(auto& r : frames)
+			{
+				r.left = reader.readUInt();
+				r.top = reader.readUInt();
+				r.width = reader.readUInt();
+				r.height = reader.readUInt();
+			}
+			
+			tileTypes.emplace_back(sf::Vector2u(frames[0].left, frames[0].top), sf::Vector2u(frames[0].width, frames[0].height), passable, id);
+			tileTypes.back().setCost(cost);
+			tileTypes.back().setFrames(frames);
+			tileTypes.back().setAnimationTime(animationTime);
+			tileTypes.back().setAnimated(animated);
+		}
+		
+		if(!reader.good())
+		{
+			SWIFT_ERROR(World, "Compiled map \"" << f << "\" is damaged.\n");
+			tileTypes.clear();
+			return false;
+		}
+		
+		return true;
+	}
+	
+	bool TileMap::loadBinary(const std::string& f)
+	{
+		MappedFile mapped;
+		
+		if(!mapped.open(f))
+		{
+			SWIFT_ERROR(World, "Loading compiled map \"" << f << "\" failed.\n");
+			return false;
+		}
+		
+		const std::uint8_t* data = mapped.getData();
+		ByteReader reader(data, mapped.getSize());
+		
+		// a pointer into the mapped file, to bytes raw bytes starting on an a byte boundary
+		auto raw = [&reader, data](std::size_t bytes, std::size_t a) -> const std::uint8_t*
+		{
+			reader.skip((a - reader.getPosition() % a) % a);
+			const std::uint8_t* p = data + reader.getPosition();
+			
+			return reader.skip(bytes) ? p : nullptr;
+		};
+		
+		bool diagonal = false;
+		
+		if(!readHeader(reader, f, diagonal))
+			return false;
+		
+		// read again, a chunk at a time
+		if(streamed)
+		{
+			mapped.close();
+			return openStream(f);
+		}
+		
+		std::uint64_t numLayers = reader.readUInt();
+		
+		for(std::uint64_t i = 0; i < numLayers && reader.good(); i++)
+		{
+			layers.emplace_back(sizeTiles, tileSize);
+			Layer& l = layers.back();
+			
+			std::uint64_t numWords = reader.readUInt();
+			const std::uint8_t* blocked = raw(numWords * sizeof(std::uint64_t), sizeof(std::uint64_t));
+			
+			std::uint64_t numCosts = reader.readUInt();
+			const std::uint8_t* costs = raw(numCosts, 1);
+			
+			if(!blocked || !costs || numWords != l.passability.getBlocked().size() || (numCosts != 0 && numCosts != static_cast<std::uint64_t>(sizeTiles.x) * sizeTiles.y))
+				break;
+			
+			l.passability.assign(reinterpret_cast<const std::uint64_t*>(blocked), numCosts != 0 ? costs : nullptr);
+			
+			// records follow the table, in order
+			if(reader.readUInt() != l.chunks.size() || !reader.skip(l.chunks.size() * 8))
+				break;
+			
+			l.numTiles = sizeTiles.x * sizeTiles.y;
+			
+			for(unsigned c = 0; c < l.chunks.size() && reader.good(); c++)
+			{
+				Layer::Chunk& chunk = l.chunks[c];
+				std::size_t count = chunk.vertices.getVertexCount();
+				
+				if(!ChunkStreamer::read(reader, data, chunk.ids, chunk.animated, chunk.vertices) || !isChunkValid(l, c, chunk.ids, chunk.animated)
+					|| chunk.vertices.getVertexCount() != count)
+					reader.fail();
+			}
+			
+			if(!reader.good())
+				break;
+			
+			l.updateBounds();
+			l.setDiagonal(diagonal);
+			l.buildClusters();
+		}
+		
+		if(!reader.good() || layers.size() != numLayers)
+		{
+			SWIFT_ERROR(World, "Compiled map \"" << f << "\" is damaged.\n");
+			layers.clear();
+			return false;
+		}
+		
+		verticesBuilt = true;
+		
+		return true;
+	}
+	
+	bool TileMap::buildVertices()
+	{
+		// every column and row shares its edges with the next, so they're worked out once
+		std::vector<float> xs;
+		std::vector<float> ys;
+		getEdges(xs, ys);
+		
+		// chunks don't share anything, so they're built in parallel, over every layer at once
+		std::vector<ThreadPool::Job> jobs;
+		
+		for(auto& l : layers)
+		{
+			if(l.getNumTiles() < sizeTiles.x * sizeTiles.y)
+				return false;
+			
+			for(unsigned c = 0; c < l.chunks.size(); c++)
+			{
+				Layer* layer = &l;
+				
+				jobs.push_back([layer, c, &xs, &ys, this]()
+				{
+					layer->buildChunk(c, xs, ys, tileTypes);
+				});
+			}
+		}
+		
+		if(threadPool && jobs.size() > 1)
+			threadPool->run(jobs);
+		else
+		{
+			for(auto& j : jobs)
+				j();
+		}
+		
+		verticesBuilt = true;
+		
+		return true;
+	}
+	
+	void TileMap::getEdges(std::vector<float>& xs, std::vector<float>& ys) const
+	{
+		sf::Vector2f scale = {static_cast<float>(tileSize.x) / textureTileSize.x, static_cast<float>(tileSize.y) / textureTileSize.y};
+		
+		xs.resize(sizeTiles.x + 1);
+		ys.resize(sizeTiles.y + 1);
+		
+		for(unsigned i = 0; i <= sizeTiles.x; i++)
+			xs[i] = std::floor(i * static_cast<float>(tileSize.x) * scale.x);
+		
+		for(unsigned j = 0; j <= sizeTiles.y; j++)
+			ys[j] = std::floor(j * static_cast<float>(tileSize.y) * scale.y);
+	}
+	
+	bool TileMap::openStream(const std::string& f)
+	{
+		file = f;
+		generator.reset();
+		streamer.reset(new ChunkStreamer);
+		
+		if(!streamer->open(f))
+		{
+			SWIFT_ERROR(World, "Loading compiled map \"" << f << "\" failed.\n");
+			streamer.reset();
+			return false;
+		}
+		
+		const MappedFile& mapped = streamer->getFile();
+		ByteReader reader(mapped.getData(), mapped.getSize());
+		bool diagonal = false;
+		
+		if(mapped.getSize() < 4 || std::memcmp(mapped.getData(), binaryMagic, 4) != 0 || !readHeader(reader, f, diagonal))
+		{
+			SWIFT_ERROR(World, "\"" << f << "\" isn't a compiled map.\n");
+			streamer.reset();
+			return false;
+		}
+		
+		if(renderMode == RenderMode::Shader)
+			setRenderMode(RenderMode::Shader);
+		
+		std::uint64_t numLayers = reader.readUInt();
+		chunkOffsets.clear();
+		
+		for(std::uint64_t i = 0; i < numLayers && reader.good(); i++)
+		{
+			layers.emplace_back(sizeTiles, tileSize, true);
+			Layer& l = layers.back();
+			
+			// passability comes from the tile types as chunks are loaded
+			std::uint64_t numWords = reader.readUInt();
+			reader.skip((8 - reader.getPosition() % 8) % 8);
+			reader.skip(numWords * 8);
+			reader.skip(reader.readUInt());
+			
+			if(reader.readUInt() != l.chunks.size())
+				reader.fail();
+			
+			chunkOffsets.emplace_back(l.chunks.size());
+			
+			for(auto& o : chunkOffsets.back())
+			{
+				o = reader.readUInt32();
+				o |= static_cast<std::uint64_t>(reader.readUInt32()) << 32;
+				
+				if(o >= mapped.getSize())
+					reader.fail();
+			}
+			
+			l.setDiagonal(diagonal);
+			
+			// records aren't read past, the next layer's start is after the last one
+			if(i + 1 < numLayers && reader.good() && !l.chunks.empty())
+			{
+				ByteReader record(mapped.getData(), mapped.getSize());
+				std::vector<std::uint16_t> ids;
+				std::vector<unsigned> animated;
+				sf::VertexArray vertices;
+				
+				if(!record.skip(chunkOffsets.back().back()) || !ChunkStreamer::read(record, mapped.getData(), ids, animated, vertices))
+					reader.fail();
+				else
+					reader = record;
+			}
+		}
+		
+		if(!reader.good() || layers.size() != numLayers)
+		{
+			SWIFT_ERROR(World, "Compiled map \"" << f << "\" is damaged.\n");
+			layers.clear();
+			streamer.reset();
+			return false;
+		}
+		
+		// they come with each chunk
+		verticesBuilt = true;
+		streamMemory = 0;
+		requested.assign(layers.size(), {});
+		
+		return true;
+	}
+	
+	bool TileMap::generate(const TileGenerator& g, const sf::Vector2u& s)
+	{
+		SWIFT_MEMORY_SCOPE(TileMap);
+		
+		if(tileTypes.empty() || tileSize.x == 0 || tileSize.y == 0)
+		{
+			SWIFT_ERROR(World, "Generating a map needs the tilesets of a loaded one first.\n");
+			return false;
+		}
+		
+		if(g.getMaxID() >= static_cast<int>(tileTypes.size()))
+			SWIFT_WARNING(World, "Tile generator uses type " << g.getMaxID() << ", but \"" << file << "\" only has " << static_cast<unsigned>(tileTypes.size()) << ", those tiles are left empty.\n");
+		
+		streamer.reset();
+		generator.reset(new TileGenerator(g));
+		
+		sizeTiles = s;
+		sizePixels = {s.x * tileSize.x, s.y * tileSize.y};
+		
+		// every chunk starts unloaded and impassable, as streamed layers do
+		layers.clear();
+		
+		for(unsigned l = 0; l < generator->getLayerCount(); l++)
+			layers.emplace_back(sizeTiles, tileSize, true);
+		
+		if(renderMode == RenderMode::Shader)
+			setRenderMode(RenderMode::Shader);
+		
+		getEdges(columnEdges, rowEdges);
+		
+		// built with each chunk
+		verticesBuilt = true;
+		streamMemory = 0;
+		requested.assign(layers.size(), {});
+		
+		return true;
+	}
+	
+	void TileMap::setThreadPool(ThreadPool& tp)
+	{
+		threadPool = &tp;
+	}
+	
+	bool TileMap::isStreaming() const
+	{
+		return streamer != nullptr || generator != nullptr;
+	}
+	
+	void TileMap::setGenerationCache(const std::string& folder)
+	{
+		generationCache = folder;
+	}
+	
+	void TileMap::setAsyncWriter(AsyncWriter& w)
+	{
+		writer = &w;
+	}
+	
+	void TileMap::setStreamBudget(std::size_t bytes)
+	{
+		streamBudget = bytes;
+	}
+	
+	std::size_t TileMap::getStreamMemory() const
+	{
+		return streamMemory;
+	}
+	
+	std::size_t TileMap::getMemory() const
+	{
+		std::size_t bytes = 0;
+		
+		for(auto& l : layers)
+		{
+			for(unsigned c = 0; c < l.chunks.size(); c++)
+				bytes += l.getChunkMemory(c);
+		}
+		
+		return bytes;
+	}
+	
+	void TileMap::setStreamRadius(float r)
+	{
+		streamRadius = r;
+	}
+	
+	void TileMap::setStreamFocus(const std::vector<sf::Vector2f>& points)
+	{
+		streamFocus = points;
+	}
+	
+	bool TileMap::isChunkValid(const Layer& layer, unsigned c, const std::vector<std::uint16_t>& ids, const std::vector<unsigned>& animated) const
+	{
+		const Layer::Chunk& chunk = layer.chunks[c];
+		
+		if(ids.size() != chunk.width * chunk.height)
+			return false;
+		
+		for(auto& t : animated)
+		{
+			unsigned x = t % sizeTiles.x;
+			unsigned y = t / sizeTiles.x;
+			
+			if(y >= sizeTiles.y || layer.getChunk(x, y) != c)
+				return false;
+			
+			unsigned id = ids[(y % Layer::CHUNK_SIZE) * chunk.width + x % Layer::CHUNK_SIZE];
+			
+			if(id == 0 || id > tileTypes.size())
+				return false;
+		}
+		
+		return true;
+	}
+	
+	void TileMap::updateStream()
+	{
+		if(!isStreaming() || layers.empty())
+			return;
+		
+		ChunkStreamer::Chunk chunk;
+		
+		while(streamer && streamer->collect(chunk))
+		{
+			if(chunk.layer >= layers.size())
+				continue;
+			
+			Layer& l = layers[chunk.layer];
+			std::vector<unsigned>& pending = requested[chunk.layer];
+			pending.erase(std::remove(pending.begin(), pending.end(), chunk.index), pending.end());
+			
+			if(!chunk.good || !isChunkValid(l, chunk.index, chunk.ids, chunk.animated) || chunk.vertices.getVertexCount() != chunk.ids.size() * 4)
+			{
+				SWIFT_WARNING(World, "Chunk " << chunk.index << " of layer " << chunk.layer << " of \"" << file << "\" is damaged, leaving it impassable.\n");
+				continue;
+			}
+			
+			l.loadChunk(chunk.index, chunk.ids, chunk.animated, chunk.vertices, tileTypes);
+			streamMemory += l.getChunkMemory(chunk.index);
+		}
+		
+		// the same size as vertices are laid out by buildVertices
+		const Layer& first = layers.front();
+		sf::Vector2f scale = {static_cast<float>(tileSize.x) / textureTileSize.x, static_cast<float>(tileSize.y) / textureTileSize.y};
+		sf::Vector2f chunkPixels = {Layer::CHUNK_SIZE * tileSize.x * scale.x, Layer::CHUNK_SIZE * tileSize.y * scale.y};
+		
+		if(chunkPixels.x <= 0 || chunkPixels.y <= 0)
+			return;
+		
+		// around the view and every focus point
+		FrameArena::Scope scope;
+		FrameVector<sf::FloatRect> areas;
+		FrameVector<sf::Vector2f> centers;
+		
+		if(streamView.width > 0 && streamView.height > 0)
+		{
+			areas.push_back({streamView.left - streamRadius, streamView.top - streamRadius, streamView.width + streamRadius * 2, streamView.height + streamRadius * 2});
+			centers.push_back({streamView.left + streamView.width / 2, streamView.top + streamView.height / 2});
+		}
+		
+		for(auto& p : streamFocus)
+		{
+			areas.push_back({p.x - streamRadius, p.y - streamRadius, streamRadius * 2, streamRadius * 2});
+			centers.push_back(p);
+		}
+		
+		// every layer has the same chunks
+		wanted.clear();
+		
+		for(auto& a : areas)
+		{
+			int left = std::max(static_cast<int>(std::floor(a.left / chunkPixels.x)), 0);
+			int top = std::max(static_cast<int>(std::floor(a.top / chunkPixels.y)), 0);
+			int right = std::min(static_cast<int>(std::floor((a.left + a.width) / chunkPixels.x)), static_cast<int>(first.chunkCount.x) - 1);
+			int bottom = std::min(static_cast<int>(std::floor((a.top + a.height) / chunkPixels.y)), static_cast<int>(first.chunkCount.y) - 1);
+			
+			for(int y = top; y <= bottom; y++)
+				for(int x = left; x <= right; x++)
+					wanted.push_back(y * first.chunkCount.x + x);
+		}
+		
+		std::sort(wanted.begin(), wanted.end());
+		wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+		
+		// squared, from the chunk's center to the closest center
+		auto distance = [&](unsigned c)
+		{
+			sf::Vector2f middle = {(c % first.chunkCount.x + 0.5f) * chunkPixels.x, (c / first.chunkCount.x + 0.5f) * chunkPixels.y};
+			float closest = std::numeric_limits<float>::max();
+			
+			for(auto& p : centers)
+				closest = std::min(closest, (middle.x - p.x) * (middle.x - p.x) + (middle.y - p.y) * (middle.y - p.y));
+			
+			return closest;
+		};
+		
+		if(generator)
+		{
+			std::vector<std::pair<float, std::pair<unsigned, unsigned>>> missing;
+			
+			for(unsigned i = 0; i < layers.size(); i++)
+			{
+				for(auto& c : wanted)
+				{
+					if(layers[i].chunks[c].ids.empty())
+						missing.push_back({distance(c), {i, c}});
+				}
+			}
+			
+			generateChunks(missing);
+		}
+		
+		for(unsigned i = 0; i < layers.size() && streamer; i++)
+		{
+			Layer& l = layers[i];
+			std::vector<unsigned>& pending = requested[i];
+			
+			// no longer wanted, not worth reading
+			for(auto it = pending.begin(); it != pending.end();)
+			{
+				if(!std::binary_search(wanted.begin(), wanted.end(), *it))
+				{
+					streamer->cancel(i, *it);
+					it = pending.erase(it);
+				}
+				else
+					++it;
+			}
+			
+			for(auto& c : wanted)
+			{
+				if(!l.chunks[c].ids.empty())
+					continue;
+				
+				if(std::find(pending.begin(), pending.end(), c) == pending.end())
+					pending.push_back(c);
+				
+				// closer chunks are read first, priorities change as things move
+				streamer->request(i, c, chunkOffsets[i][c], distance(c));
+			}
+		}
+		
+		if(streamMemory <= streamBudget)
+			return;
+		
+		// farthest first, chunks still wanted stay even past the budget
+		std::vector<std::pair<float, std::pair<unsigned, unsigned>>> unwanted;
+		
+		for(unsigned i = 0; i < layers.size(); i++)
+		{
+			for(auto& c : layers[i].loaded)
+			{
+				if(!std::binary_search(wanted.begin(), wanted.end(), c))
+					unwanted.push_back({distance(c), {i, c}});
+			}
+		}
+		
+		std::sort(unwanted.begin(), unwanted.end(), [](const std::pair<float, std::pair<unsigned, unsigned>>& one, const std::pair<float, std::pair<unsigned, unsigned>>& two)
+		{
+			return one.first > two.first;
+		});
+		
+		for(auto& u : unwanted)
+		{
+			if(streamMemory <= streamBudget)
+				break;
+			
+			Layer& l = layers[u.second.first];
+			streamMemory -= l.getChunkMemory(u.second.second);
+			l.unloadChunk(u.second.second);
+		}
+	}
+	
+	void TileMap::generateChunks(const std::vector<std::pair<float, std::pair<unsigned, unsigned>>>& missing)
+	{
+		if(missing.empty())
+			return;
+		
+		// the closest, up to a frame's worth. The rest wait for the next update
+		std::vector<std::pair<float, std::pair<unsigned, unsigned>>> closest = missing;
+		std::sort(closest.begin(), closest.end());
+		
+		if(closest.size() > generatedPerUpdate)
+			closest.resize(generatedPerUpdate);
+		
+		struct Made
+		{
+			std::vector<std::uint16_t> ids;
+			std::vector<unsigned> animated;
+		};
+		
+		std::vector<Made> made(closest.size());
+		std::vector<ThreadPool::Job> jobs;
+		
+		// noise and rules, on the pool. Layers aren't touched
+		for(std::size_t m = 0; m < closest.size(); m++)
+		{
+			jobs.push_back([&, m]()
+			{
+				SWIFT_MEMORY_SCOPE(TileMap);
+				
+				unsigned l = closest[m].second.first;
+				unsigned c = closest[m].second.second;
+				
+				const Layer& layer = layers[l];
+				const Layer::Chunk& chunk = layer.chunks[c];
+				unsigned left = c % layer.chunkCount.x * Layer::CHUNK_SIZE;
+				unsigned top = c / layer.chunkCount.x * Layer::CHUNK_SIZE;
+				
+				if(generationCache.empty() || !readCached(l, c, made[m].ids))
+				{
+					generator->generate(l, left, top, chunk.width, chunk.height, made[m].ids);
+					
+					if(!generationCache.empty())
+						writeCached(l, c, made[m].ids);
+				}
+				
+				// as loadFile adds them, tiles of types with more than one frame
+				for(unsigned i = 0; i < made[m].ids.size(); i++)
+				{
+					unsigned id = made[m].ids[i];
+					
+					if(id != 0 && id <= tileTypes.size() && tileTypes[id - 1].isAnimated() && tileTypes[id - 1].getFrames().size() > 1)
+						made[m].animated.push_back((top + i / chunk.width) * sizeTiles.x + left + i % chunk.width);
+				}
+			});
+		}
+		
+		if(threadPool && jobs.size() > 1)
+			threadPool->run(jobs);
+		else
+		{
+			for(auto& j : jobs)
+				j();
+		}
+		
+		// passability is shared by the chunks of a layer, so they're loaded one at a time
+		jobs.clear();
+		
+		for(std::size_t m = 0; m < closest.size(); m++)
+		{
+			Layer* layer = &layers[closest[m].second.first];
+			unsigned c = closest[m].second.second;
+			
+			sf::VertexArray vertices(sf::PrimitiveType::Quads, made[m].ids.size() * 4);
+			layer->loadChunk(c, made[m].ids, made[m].animated, vertices, tileTypes);
+			streamMemory += layer->getChunkMemory(c);
+			
+			jobs.push_back([layer, c, this]()
+			{
+				layer->buildChunk(c, columnEdges, rowEdges, tileTypes);
+			});
+		}
+		
+		if(threadPool && jobs.size() > 1)
+			threadPool->run(jobs);
+		else
+		{
+			for(auto& j : jobs)
+				j();
+		}
+	}
+	
+	std::string TileMap::getCacheFile(unsigned l, unsigned c) const
+	{
+		const Layer& layer = layers[l];
+		
+		// flat, the folder is all that has to exist
+		char name[96];
+		std::snprintf(name, sizeof(name), "/%016llx-%016llx-%u-%u-%u.chunk", static_cast<unsigned long long>(generator->getSeed()),
+						static_cast<unsigned long long>(generator->getVersion()), l, c % layer.chunkCount.x, c / layer.chunkCount.x);
+		
+		return generationCache + name;
+	}
+	
+	bool TileMap::readCached(unsigned l, unsigned c, std::vector<std::uint16_t>& ids) const
+	{
+		std::ifstream fin(getCacheFile(l, c), std::ios::binary);
+		
+		if(!fin)
+			return false;
+		
+		std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		ByteReader reader(data);
+		
+		if(data.size() < 4 || std::memcmp(data.data(), cacheMagic, 4) != 0 || !reader.skip(4))
+			return false;
+		
+		const Layer::Chunk& chunk = layers[l].chunks[c];
+		
+		// the name says most of this, but a file can be renamed
+		bool matches = reader.readUInt() == cacheVersion;
+		matches = reader.readUInt() == generator->getSeed() && matches;
+		matches = reader.readUInt() == generator->getVersion() && matches;
+		matches = reader.readUInt() == l && matches;
+		matches = reader.readUInt() == c % layers[l].chunkCount.x && matches;
+		matches = reader.readUInt() == c / layers[l].chunkCount.x && matches;
+		matches = reader.readUInt() == chunk.width && matches;
+		matches = reader.readUInt() == chunk.height && matches;
+		
+		// the record of a compiled map's chunk, without animated tiles or vertices, they depend on the tileset
+		std::vector<unsigned> animated;
+		sf::VertexArray vertices;
+		
+		return matches && reader.good() && ChunkStreamer::read(reader, data.data(), ids, animated, vertices) && ids.size() == chunk.width * chunk.height;
+	}
+	
+	void TileMap::writeCached(unsigned l, unsigned c, const std::vector<std::uint16_t>& ids) const
+	{
+		const Layer::Chunk& chunk = layers[l].chunks[c];
+		
+		ByteWriter out;
+		out.writeBytes(cacheMagic, 4);
+		out.writeUInt(cacheVersion);
+		out.writeUInt(generator->getSeed());
+		out.writeUInt(generator->getVersion());
+		out.writeUInt(l);
+		out.writeUInt(c % layers[l].chunkCount.x);
+		out.writeUInt(c / layers[l].chunkCount.x);
+		out.writeUInt(chunk.width);
+		out.writeUInt(chunk.height);
+		ChunkStreamer::write(out, ids, {}, sf::VertexArray());
+		
+		std::string f = getCacheFile(l, c);
+		
+		if(writer)
+			writer->queue(f, out.getData(), AsyncWriter::Mode::Replace);
+		else if(!AsyncWriter::write(f, out.getData(), AsyncWriter::Mode::Replace))
+			SWIFT_WARNING(World, "Caching generated chunk \"" << f << "\" failed.\n");
 	}
 }
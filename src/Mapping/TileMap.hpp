@@ -10,50 +10,215 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <memory>
 
 #include "Layer.hpp"
+#include "TileIndex.hpp"
+#include "ChunkStreamer.hpp"
+#include "TileGenerator.hpp"
+#include "VisibilityMap.hpp"
+#include "../Threading/ThreadPool.hpp"
+#include "../Serialization/AsyncWriter.hpp"
 
 namespace swift
 {
 	class TileMap : public sf::Drawable
 	{
 		public:
+			enum class RenderMode
+			{
+				Chunks,		// the tiles of each chunk on screen, from vertex buffers
+				Shader,		// each layer as one quad, with a shader looking its tiles up in a TileIndex. For huge maps
+			};
+			
 			TileMap();
 			~TileMap();
 			
 			void update(float dt);
 
+			// Tiled .tmx maps, or maps compiled by saveBinary, told apart by their first bytes
 			bool loadFile(const std::string& f);
 			bool loadTexture(const sf::Texture& tex);
+			
+			// one texture per file of getTextureFiles, packed into one atlas so each layer is still drawn at once.
+			// a single tileset's texture is used as it is
+			bool loadTextures(const std::vector<const sf::Texture*>& textures);
+			
+			// compiles the loaded map, with its vertices built, into a versioned binary file that loadFile maps into memory
+			// and copies out of in a few large blocks. Only loads on machines with the byte order and sf::Vertex layout of this one.
+			// maps with the "Streamed" property are streamed by loadFile once compiled
+			bool saveBinary(const std::string& f);
+			
+			// pages the chunks of a compiled map in and out as they're needed, so its tiles don't all have to fit in memory.
+			// chunks within the stream radius of what was last drawn, or of a focus point, are read on a background thread.
+			// tiles of chunks that aren't loaded are impassable, so pathfinding and collision don't go where nothing is known.
+			// only the passability bits are kept for the whole map
+			bool openStream(const std::string& f);
+			
+			// replaces the layers with one per layer of generator, s tiles across, of the tile types already loaded, so a map
+			// with just its tilesets is loaded first. Chunks are made as a stream reads them, once near the view or a focus point,
+			// in parallel over the thread pool, and unloaded past the budget to be made again when needed
+			bool generate(const TileGenerator& generator, const sf::Vector2u& s);
+			
+			// chunks are paged in, from a stream or a generator
+			bool isStreaming() const;
+			
+			// folder generated chunks are kept in, one file each, by seed, generator version, layer, and position.
+			// they're read back instead of made again, in this session or the next. What's read is what would've
+			// been made, so clearing the folder changes nothing. Empty, the default, turns caching off
+			void setGenerationCache(const std::string& folder);
+			
+			// writes cached chunks off the ticking thread. Without one, they're written by the thread that made them
+			static void setAsyncWriter(AsyncWriter& w);
+			
+			// bytes of loaded tiles and vertices. Past it, chunks no longer wanted are unloaded, farthest first
+			void setStreamBudget(std::size_t bytes);
+			std::size_t getStreamMemory() const;
+			
+			// bytes of every layer's tiles and vertices, loaded chunks only when streaming
+			std::size_t getMemory() const;
+			
+			// in pixels, around the view and each focus point
+			void setStreamRadius(float r);
+			
+			// where the entities that need the map around them are. Replaces the last ones
+			void setStreamFocus(const std::vector<sf::Vector2f>& points);
+			
+			// pool that building vertices splits chunks over, shared by all maps. Without one, they're built on the calling thread
+			static void setThreadPool(ThreadPool& tp);
+			
+			// Shader needs shaders to be available, stays at Chunks if they aren't.
+			// if the texture isn't loaded yet, the indices are built once it is
+			void setRenderMode(RenderMode m);
+			RenderMode getRenderMode() const;
 
 			void setTileSize(const sf::Vector2u& ts);
 			void setSize(const sf::Vector2u& s);
 			void setTextureFile(const std::string& str);
 
+			// the type of the tile, shared with every other tile of it. nullptr if there's no tile there
 			const Tile* getTile(unsigned int t, unsigned int l) const;
 			const Tile* getTile(const sf::Vector2f& pos, unsigned int l) const;
 			
+			// nullptr if the tileset doesn't have it
+			const Tile* getType(int id) const;
+			
+			// changes tile x, y of layer l to type id, -1 for none. Only its quad, its chunk's buffer, and its passability are
+			// touched, so painting stays cheap on huge maps, and the layer's version changes if pathfinding sees a difference.
+			// False outside of the map, for ids the tileset doesn't have, or where a streamed chunk isn't loaded. Edits to
+			// streamed chunks last until they're unloaded
+			bool setTile(unsigned l, unsigned x, unsigned y, int id);
+			
+			// tiles outside of the map, or on layers that don't exist, are passable
+			bool isPassable(int x, int y, unsigned int l) const;
+			
+			// the region queries of layer l, see Layer. area is in tiles. False if the layer doesn't exist
+			bool getIDs(const sf::IntRect& area, unsigned int l, std::vector<int>& ids) const;
+			bool getPassable(const sf::IntRect& area, unsigned int l, std::vector<std::uint8_t>& passable) const;
+			bool forEachChunk(const sf::IntRect& area, unsigned int l, const std::function<void(const Layer::ChunkSpan&)>& f) const;
+			
+			// how far box can move by delta on layer l before running into impassable tiles.
+			// moves along x then y, so boxes slide along walls. Tiles box already overlaps don't block it
+			sf::Vector2f sweep(const sf::FloatRect& box, const sf::Vector2f& delta, unsigned int l) const;
+			
+			// the first impassable tile of layer l the segment crosses, in pixels, as PassabilityMap::raycast finds it.
+			// fraction is how far along the segment it's entered. false if nothing blocks it, or the layer doesn't exist.
+			// unloaded chunks of streamed maps are impassable, so they block rays too
+			bool raycast(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l, sf::Vector2i& tile, float& fraction) const;
+			bool hasLineOfSight(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l) const;
+			
+			// visible[i] is 1 if from[i] can see to[i]. Split across the thread pool once there are enough of them
+			void hasLineOfSight(const sf::Vector2f* from, const sf::Vector2f* to, std::size_t count, unsigned int l, unsigned char* visible) const;
+			
+			// draws fog over what faction doesn't see: dimmed where it has seen before, black where it never has.
+			// v must be as many tiles across as the map, it's ignored otherwise. nullptr, the default, draws no fog
+			void setVisibility(const VisibilityMap* v, unsigned faction);
+			
 			const sf::Vector2u& getTileSize() const;
 			const sf::Vector2u& getSize() const;
 			
+			// of the first tileset
 			const std::string& getTextureFile() const;
+			
+			// the image of every tileset, in the order loadTextures takes their textures
+			std::vector<std::string> getTextureFiles() const;
+			
+			// the tilesets as tiles' frames are placed in them, packed into one atlas if there's more than one. nullptr until loaded
+			const sf::Texture* getTexture() const;
 			const std::string& getFile() const;
 			
 			unsigned int getNumOfTileTypes() const;
+			unsigned int getNumLayers() const;
+			
+			// nullptr if the layer doesn't exist
+			const Layer* getLayer(unsigned int l) const;
 
 		private:
-			struct TileType
+			// a tileset of the map, placed in the atlas with the others
+			struct Tileset
 			{
-				bool passable;
-				unsigned int zIndex;
-				bool animated;
-				sf::Vector2u texPos;
+				std::string file;		// its image
+				unsigned int firstID;	// type of its first tile. Tiled's firstgid - 1
+				sf::Vector2u size;		// of the image
+				sf::Vector2u tileSize;
+				sf::Vector2u position;	// in the atlas
+				
+				// tiles that fit in the image
+				unsigned int getCount() const;
+				
+				// where tile local of the tileset is in the atlas
+				sf::IntRect getTile(unsigned int local) const;
 			};
-
+			
 			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+			void drawShaded(sf::RenderTarget& target, sf::RenderStates states) const;
+			
+			// over the layers, from quads of each VisibilityMap chunk on screen, rebuilt when its revision changes
+			void drawFog(sf::RenderTarget& target, sf::RenderStates states) const;
+			
+			// for the Shader render mode
+			void buildIndices();
+			
+			// places every tileset in the atlas, and sets textureSize to the atlas' size
+			void packTilesets();
+			
+			// the tileset type id is in, nullptr for ids between tilesets
+			const Tileset* getTileset(unsigned int id) const;
+			
+			bool loadBinary(const std::string& f);
+			
+			// the sizes and tile types at the start of a compiled map, leaves reader at the layer count
+			bool readHeader(ByteReader& reader, const std::string& f, bool& diagonal);
+			
+			// loads chunks collected from the streamer, requests the ones wanted, and unloads what's over budget
+			void updateStream();
+			
+			// true if a chunk read from a file fits chunk c of layer
+			bool isChunkValid(const Layer& layer, unsigned c, const std::vector<std::uint16_t>& ids, const std::vector<unsigned>& animated) const;
+			
+			// makes the chunks, closest first, of generated maps. Vertices are built once all are loaded
+			void generateChunks(const std::vector<std::pair<float, std::pair<unsigned, unsigned>>>& missing);
+			
+			// positions and texture coordinates for every tile of every layer
+			bool buildVertices();
+			
+			// the pixel edges of each column and row of tiles, as vertices are laid out
+			void getEdges(std::vector<float>& xs, std::vector<float>& ys) const;
+			
+			// of chunk c of layer l in the generation cache
+			std::string getCacheFile(unsigned l, unsigned c) const;
+			
+			// false if the chunk isn't cached, or its file is for different rules or is damaged
+			bool readCached(unsigned l, unsigned c, std::vector<std::uint16_t>& ids) const;
+			void writeCached(unsigned l, unsigned c, const std::vector<std::uint16_t>& ids) const;
+			
+			// distance box can move along one axis, x if horizontal
+			float sweepAxis(const sf::FloatRect& box, float delta, bool horizontal, const Layer& layer) const;
+			
+			// tiles first through last of a row, or of a column
+			static bool linePassable(const Layer& layer, int line, int first, int last, bool column);
 
-			std::map<unsigned int, TileType> tileTypes;
+			std::vector<Tile> tileTypes;		// every tile of the tileset, by id
 			std::vector<Layer> layers;
 
 			sf::Vector2u tileSize;
@@ -65,7 +230,47 @@ namespace swift
 			std::string file;
 			std::string textureFile;
 
+			std::vector<Tileset> tilesets;
+			std::unique_ptr<sf::Texture> atlas;		// the tilesets together, when there's more than one. Made then, maps never drawn don't need a graphics context
 			const sf::Texture* texture;
+			
+			RenderMode renderMode;
+			std::vector<TileIndex> indices;		// one per layer, in the Shader render mode
+			float time;							// for animating tiles in the shader
+			bool verticesBuilt;					// compiled maps come with them
+			bool streamed;						// the map's "Streamed" property
+			
+			std::unique_ptr<ChunkStreamer> streamer;			// while streaming
+			std::vector<std::vector<std::uint64_t>> chunkOffsets;	// of each chunk's record in the file, by layer
+			std::vector<std::vector<unsigned>> requested;		// chunks asked for and not loaded yet, by layer
+			std::vector<unsigned> wanted;						// chunks near the view or a focus point
+			std::size_t streamBudget;
+			std::size_t streamMemory;
+			float streamRadius;
+			std::vector<sf::Vector2f> streamFocus;
+			mutable sf::FloatRect streamView;	// last drawn, in the map's coordinates
+			
+			std::unique_ptr<TileGenerator> generator;	// while generating
+			std::vector<float> columnEdges;				// of generated maps, for building chunks
+			std::vector<float> rowEdges;
+			std::string generationCache;
+			
+			// a row's runs of fogged tiles as quads, per VisibilityMap chunk
+			struct FogChunk
+			{
+				sf::VertexArray vertices;
+				unsigned revision;
+				bool built;
+			};
+			
+			const VisibilityMap* visibility;
+			unsigned fogFaction;
+			mutable std::vector<FogChunk> fogChunks;
+			mutable std::vector<float> fogColumns;		// edges, as getEdges gives them
+			mutable std::vector<float> fogRows;
+			
+			static ThreadPool* threadPool;
+			static AsyncWriter* writer;
 	};
 }
 
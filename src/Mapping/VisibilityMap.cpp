@@ -0,0 +1,364 @@
+#include "VisibilityMap.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// 64 bits of a view's row starting at bit offset, which may be negative, with what's past either end 0
+	std::uint64_t getSpan(const std::uint64_t* row, unsigned words, int offset)
+	{
+		if(offset <= -64 || offset >= static_cast<int>(words * 64))
+			return 0;
+		
+		if(offset < 0)
+			return row[0] << -offset;
+		
+		unsigned index = offset / 64;
+		unsigned shift = offset % 64;
+		std::uint64_t bits = row[index] >> shift;
+		
+		if(shift != 0 && index + 1 < words)
+			bits |= row[index + 1] << (64 - shift);
+		
+		return bits;
+	}
+}
+
+namespace swift
+{
+	VisibilityMap::VisibilityMap()
+	:	size(0, 0),
+		chunkCount(0, 0),
+		stamp(0),
+		recomputed(0)
+	{
+	}
+	
+	void VisibilityMap::resize(const sf::Vector2u& s)
+	{
+		size = s;
+		chunkCount = {(s.x + ChunkSize - 1) / ChunkSize, (s.y + ChunkSize - 1) / ChunkSize};
+		
+		views.clear();
+		factions.clear();
+	}
+	
+	const sf::Vector2u& VisibilityMap::getSize() const
+	{
+		return size;
+	}
+	
+	void VisibilityMap::update(const std::vector<Viewer>& viewers, const PassabilityMap& passability, unsigned version)
+	{
+		stamp++;
+		recomputed = 0;
+		
+		if(size.x == 0 || size.y == 0)
+			return;
+		
+		for(auto& viewer : viewers)
+		{
+			if(viewer.faction >= MaxFactions)
+				continue;
+			
+			auto it = views.find(viewer.id);
+			bool added = it == views.end();
+			
+			if(added)
+				it = views.emplace(viewer.id, View()).first;
+			
+			View& view = it->second;
+			unsigned radius = std::min(viewer.radius, MaxRadius);
+			
+			bool changed = added || view.tile != viewer.tile || view.radius != radius || view.faction != viewer.faction || view.version != version;
+			view.stamp = stamp;
+			
+			if(!changed)
+				continue;
+			
+			// what it saw before is rebuilt without it, then what it sees now with it
+			if(!added)
+				markDirty(view);
+			
+			view.faction = viewer.faction;
+			view.tile = viewer.tile;
+			view.radius = radius;
+			view.version = version;
+			
+			cast(view, passability);
+			markDirty(view);
+			recomputed++;
+		}
+		
+		for(auto it = views.begin(); it != views.end();)
+		{
+			if(it->second.stamp != stamp)
+			{
+				markDirty(it->second);
+				it = views.erase(it);
+			}
+			else
+				++it;
+		}
+		
+		for(unsigned f = 0; f < factions.size(); f++)
+		{
+			if(!factions[f].dirtyChunks.empty())
+				rebuild(factions[f], f);
+		}
+	}
+	
+	bool VisibilityMap::isVisible(unsigned faction, int x, int y) const
+	{
+		if(faction >= factions.size() || factions[faction].visible.empty() || x < 0 || y < 0 || x >= static_cast<int>(size.x) || y >= static_cast<int>(size.y))
+			return false;
+		
+		unsigned c = (y / ChunkSize) * chunkCount.x + x / ChunkSize;
+		return (factions[faction].visible[c * ChunkSize + y % ChunkSize] >> (x % ChunkSize)) & 1;
+	}
+	
+	bool VisibilityMap::isExplored(unsigned faction, int x, int y) const
+	{
+		if(faction >= factions.size() || factions[faction].explored.empty() || x < 0 || y < 0 || x >= static_cast<int>(size.x) || y >= static_cast<int>(size.y))
+			return false;
+		
+		unsigned c = (y / ChunkSize) * chunkCount.x + x / ChunkSize;
+		return (factions[faction].explored[c * ChunkSize + y % ChunkSize] >> (x % ChunkSize)) & 1;
+	}
+	
+	const sf::Vector2u& VisibilityMap::getChunkCount() const
+	{
+		return chunkCount;
+	}
+	
+	unsigned VisibilityMap::getRevision(unsigned faction, unsigned c) const
+	{
+		if(faction >= factions.size() || c >= factions[faction].revisions.size())
+			return 0;
+		
+		return factions[faction].revisions[c];
+	}
+	
+	const std::uint64_t* VisibilityMap::getVisibleRows(unsigned faction, unsigned c) const
+	{
+		if(faction >= factions.size() || factions[faction].visible.empty())
+			return nullptr;
+		
+		return &factions[faction].visible[c * ChunkSize];
+	}
+	
+	const std::uint64_t* VisibilityMap::getExploredRows(unsigned faction, unsigned c) const
+	{
+		if(faction >= factions.size() || factions[faction].explored.empty())
+			return nullptr;
+		
+		return &factions[faction].explored[c * ChunkSize];
+	}
+	
+	unsigned VisibilityMap::getRecomputed() const
+	{
+		return recomputed;
+	}
+	
+	void VisibilityMap::cast(View& view, const PassabilityMap& passability)
+	{
+		const unsigned side = 2 * view.radius + 1;
+		
+		view.wordsPerRow = (side + 63) / 64;
+		view.bits.assign(side * view.wordsPerRow, 0);
+		
+		// it sees where it stands
+		view.bits[view.radius * view.wordsPerRow + view.radius / 64] |= std::uint64_t(1) << (view.radius % 64);
+		
+		// each octant's rows and columns, as map directions
+		static const int xx[8] = {1, 0, 0, -1, -1, 0, 0, 1};
+		static const int xy[8] = {0, 1, -1, 0, 0, -1, 1, 0};
+		static const int yx[8] = {0, 1, 1, 0, 0, -1, -1, 0};
+		static const int yy[8] = {1, 0, 0, 1, -1, 0, 0, -1};
+		
+		for(int o = 0; o < 8; o++)
+			castOctant(view, passability, 1, 1, 0, xx[o], xy[o], yx[o], yy[o]);
+	}
+	
+	void VisibilityMap::castOctant(View& view, const PassabilityMap& passability, int row, float start, float end, int xx, int xy, int yx, int yy)
+	{
+		if(start < end)
+			return;
+		
+		const int radius = static_cast<int>(view.radius);
+		const int reach = radius * radius + radius;
+		float nextStart = start;
+		
+		for(int j = row; j <= radius; j++)
+		{
+			int dy = -j;
+			bool blocked = false;
+			
+			for(int dx = -j; dx <= 0; dx++)
+			{
+				// slopes through the tile's far corners
+				float left = (dx - 0.5f) / (dy + 0.5f);
+				float right = (dx + 0.5f) / (dy - 0.5f);
+				
+				if(start < right)
+					continue;
+				else if(end > left)
+					break;
+				
+				int lx = dx * xx + dy * xy;
+				int ly = dx * yx + dy * yy;
+				
+				if(dx * dx + dy * dy <= reach)
+				{
+					unsigned bit = lx + radius;
+					view.bits[(ly + radius) * view.wordsPerRow + bit / 64] |= std::uint64_t(1) << (bit % 64);
+				}
+				
+				bool opaque = !passability.isPassable(view.tile.x + lx, view.tile.y + ly);
+				
+				if(blocked)
+				{
+					// along a wall, the shadow keeps growing
+					if(opaque)
+					{
+						nextStart = right;
+						continue;
+					}
+					
+					blocked = false;
+					start = nextStart;
+				}
+				else if(opaque && j < radius)
+				{
+					// the rows past it only see around the wall, up to where it starts
+					blocked = true;
+					castOctant(view, passability, j + 1, start, left, xx, xy, yx, yy);
+					nextStart = right;
+				}
+			}
+			
+			if(blocked)
+				break;
+		}
+	}
+	
+	void VisibilityMap::markDirty(const View& view)
+	{
+		if(view.bits.empty())
+			return;
+		
+		int radius = static_cast<int>(view.radius);
+		int left = std::max(view.tile.x - radius, 0);
+		int top = std::max(view.tile.y - radius, 0);
+		int right = std::min(view.tile.x + radius, static_cast<int>(size.x) - 1);
+		int bottom = std::min(view.tile.y + radius, static_cast<int>(size.y) - 1);
+		
+		if(left > right || top > bottom)
+			return;
+		
+		Faction& faction = getFaction(view.faction);
+		
+		for(int cy = top / ChunkSize; cy <= bottom / static_cast<int>(ChunkSize); cy++)
+		{
+			for(int cx = left / ChunkSize; cx <= right / static_cast<int>(ChunkSize); cx++)
+			{
+				unsigned c = cy * chunkCount.x + cx;
+				
+				if(!faction.dirty[c])
+				{
+					faction.dirty[c] = true;
+					faction.dirtyChunks.push_back(c);
+				}
+			}
+		}
+	}
+	
+	void VisibilityMap::rebuild(Faction& faction, unsigned f)
+	{
+		previous.resize(faction.dirtyChunks.size() * ChunkSize);
+		
+		for(std::size_t i = 0; i < faction.dirtyChunks.size(); i++)
+		{
+			std::uint64_t* rows = &faction.visible[faction.dirtyChunks[i] * ChunkSize];
+			std::copy(rows, rows + ChunkSize, &previous[i * ChunkSize]);
+			std::fill(rows, rows + ChunkSize, 0);
+		}
+		
+		// every view of the faction over a dirty chunk, a row of a chunk at a time
+		for(auto& entry : views)
+		{
+			const View& view = entry.second;
+			
+			if(view.faction != f)
+				continue;
+			
+			int radius = static_cast<int>(view.radius);
+			int x0 = view.tile.x - radius;
+			int y0 = view.tile.y - radius;
+			int left = std::max(x0, 0);
+			int top = std::max(y0, 0);
+			int right = std::min(view.tile.x + radius, static_cast<int>(size.x) - 1);
+			int bottom = std::min(view.tile.y + radius, static_cast<int>(size.y) - 1);
+			
+			for(int y = top; y <= bottom; y++)
+			{
+				const std::uint64_t* row = &view.bits[(y - y0) * view.wordsPerRow];
+				unsigned cy = y / ChunkSize;
+				
+				for(int cx = left / ChunkSize; cx <= right / static_cast<int>(ChunkSize); cx++)
+				{
+					unsigned c = cy * chunkCount.x + cx;
+					
+					if(faction.dirty[c])
+						faction.visible[c * ChunkSize + y % ChunkSize] |= getSpan(row, view.wordsPerRow, cx * static_cast<int>(ChunkSize) - x0);
+				}
+			}
+		}
+		
+		// views reaching past the right edge set bits of tiles that aren't there
+		const std::uint64_t edge = size.x % ChunkSize ? (std::uint64_t(1) << (size.x % ChunkSize)) - 1 : ~std::uint64_t(0);
+		
+		for(std::size_t i = 0; i < faction.dirtyChunks.size(); i++)
+		{
+			unsigned c = faction.dirtyChunks[i];
+			std::uint64_t* visible = &faction.visible[c * ChunkSize];
+			std::uint64_t* explored = &faction.explored[c * ChunkSize];
+			std::uint64_t mask = c % chunkCount.x == chunkCount.x - 1 ? edge : ~std::uint64_t(0);
+			bool changed = false;
+			
+			for(unsigned r = 0; r < ChunkSize; r++)
+			{
+				visible[r] &= mask;
+				changed = changed || visible[r] != previous[i * ChunkSize + r];
+				explored[r] |= visible[r];
+			}
+			
+			if(changed)
+				faction.revisions[c]++;
+			
+			faction.dirty[c] = false;
+		}
+		
+		faction.dirtyChunks.clear();
+	}
+	
+	VisibilityMap::Faction& VisibilityMap::getFaction(unsigned f)
+	{
+		if(f >= factions.size())
+			factions.resize(f + 1);
+		
+		Faction& faction = factions[f];
+		
+		if(faction.visible.empty())
+		{
+			std::size_t chunks = static_cast<std::size_t>(chunkCount.x) * chunkCount.y;
+			
+			faction.visible.assign(chunks * ChunkSize, 0);
+			faction.explored.assign(chunks * ChunkSize, 0);
+			faction.revisions.assign(chunks, 0);
+			faction.dirty.assign(chunks, false);
+		}
+		
+		return faction;
+	}
+}
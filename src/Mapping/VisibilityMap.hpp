@@ -0,0 +1,115 @@
+#ifndef VISIBILITYMAP_HPP
+#define VISIBILITYMAP_HPP
+
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "PassabilityMap.hpp"
+
+namespace swift
+{
+	// what each faction sees of a tile grid now, and has ever seen. A bit per tile, in chunks of ChunkSize tiles
+	// square, a word per row of a chunk. Each viewer's field of view is shadowcast and kept, and only cast again
+	// once the viewer moves to another tile, changes, or the blocking tiles do. Then only the chunks its old and
+	// new views cover are rebuilt, from the kept views of the faction's viewers over them
+	class VisibilityMap
+	{
+		public:
+			static const unsigned ChunkSize = 64;
+			
+			// viewers of higher factions are ignored
+			static const unsigned MaxFactions = 16;
+			
+			// the most tiles a viewer sees across, either way
+			static const unsigned MaxRadius = 255;
+			
+			struct Viewer
+			{
+				unsigned id;		// the same from one update to the next, an entity id
+				unsigned faction;
+				sf::Vector2i tile;
+				unsigned radius;	// in tiles
+			};
+			
+			VisibilityMap();
+			
+			// tiles across. Forgets every view, and what every faction has seen
+			void resize(const sf::Vector2u& s);
+			const sf::Vector2u& getSize() const;
+			
+			// the viewers this update. Ones missing since the last have stopped seeing. Impassable tiles block sight
+			// and are seen themselves. version is the passability's, when it changes every view is cast again
+			void update(const std::vector<Viewer>& viewers, const PassabilityMap& passability, unsigned version);
+			
+			// seen by a viewer of the faction now, or ever. false outside of the map
+			bool isVisible(unsigned faction, int x, int y) const;
+			bool isExplored(unsigned faction, int x, int y) const;
+			
+			const sf::Vector2u& getChunkCount() const;
+			
+			// changes whenever chunk c's bits of the faction do, so what's drawn from them knows to rebuild. 0 until it's seen anything
+			unsigned getRevision(unsigned faction, unsigned c) const;
+			
+			// ChunkSize rows of chunk c, the lowest bit the leftmost tile. nullptr if the faction hasn't seen anything yet
+			const std::uint64_t* getVisibleRows(unsigned faction, unsigned c) const;
+			const std::uint64_t* getExploredRows(unsigned faction, unsigned c) const;
+			
+			// views cast in the last update, for stats
+			unsigned getRecomputed() const;
+		
+		private:
+			struct View
+			{
+				unsigned faction;
+				sf::Vector2i tile;
+				unsigned radius;
+				unsigned version;
+				unsigned stamp;		// update it was last given in
+				
+				// a bit per tile of the square 2 * radius + 1 across centered on tile, a row of wordsPerRow words at a time
+				std::vector<std::uint64_t> bits;
+				unsigned wordsPerRow;
+			};
+			
+			struct Faction
+			{
+				std::vector<std::uint64_t> visible;		// ChunkSize words per chunk
+				std::vector<std::uint64_t> explored;
+				std::vector<unsigned> revisions;
+				std::vector<char> dirty;				// chunks to rebuild this update
+				std::vector<unsigned> dirtyChunks;
+			};
+			
+			void cast(View& view, const PassabilityMap& passability);
+			
+			// recursive shadowcasting of one octant, from row on, between the start and end slopes.
+			// xx, xy, yx, and yy turn the octant's rows and columns into the map's
+			void castOctant(View& view, const PassabilityMap& passability, int row, float start, float end, int xx, int xy, int yx, int yy);
+			
+			// the chunks the view covers are rebuilt this update
+			void markDirty(const View& view);
+			
+			void rebuild(Faction& faction, unsigned f);
+			
+			// allocates the faction's chunks the first time
+			Faction& getFaction(unsigned f);
+			
+			sf::Vector2u size;
+			sf::Vector2u chunkCount;
+			
+			// by viewer id
+			std::unordered_map<unsigned, View> views;
+			std::vector<Faction> factions;
+			
+			unsigned stamp;
+			unsigned recomputed;
+			
+			// chunks' rows before a rebuild, to tell if they changed
+			std::vector<std::uint64_t> previous;
+	};
+}
+
+#endif // VISIBILITYMAP_HPP
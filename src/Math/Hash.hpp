@@ -0,0 +1,46 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace swift
+{
+	namespace math
+	{
+		// FNV-1a, for keys and checksums kept in files, which have to come out the same on every run and platform.
+		// Hashes of several pieces chain by giving each the hash of the ones before as h
+		constexpr std::uint64_t HASH_OFFSET = 14695981039346656037ull;
+		constexpr std::uint64_t HASH_PRIME = 1099511628211ull;
+
+		inline std::uint64_t hash(const void* data, std::size_t size, std::uint64_t h = HASH_OFFSET)
+		{
+			const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+
+			for(std::size_t i = 0; i < size; i++)
+			{
+				h ^= bytes[i];
+				h *= HASH_PRIME;
+			}
+
+			return h;
+		}
+
+		inline std::uint64_t hash(const std::string& text, std::uint64_t h = HASH_OFFSET)
+		{
+			return hash(text.data(), text.size(), h);
+		}
+
+		// the word's bytes, least significant first, whatever the platform's order
+		inline std::uint64_t hash(std::uint32_t word, std::uint64_t h)
+		{
+			const std::uint8_t bytes[4] = {static_cast<std::uint8_t>(word), static_cast<std::uint8_t>(word >> 8),
+											static_cast<std::uint8_t>(word >> 16), static_cast<std::uint8_t>(word >> 24)};
+
+			return hash(bytes, sizeof(bytes), h);
+		}
+	}
+}
+
+#endif // HASH_HPP
@@ -2,6 +2,8 @@
 #define MATH_HPP
 
 #include <cmath>
+#include <cstring>
+#include <cstdint>
 
 #include <SFML/System/Vector2.hpp>
 
@@ -74,6 +76,37 @@ namespace swift
 		{
 			return (1.f - w) * p0 + w * p1;
 		}
+
+		/* approximations, for where speed matters more than the last digits */
+
+		// 1 / sqrt(x), to within 0.2%. x has to be above 0
+		inline float rsqrt(float x)
+		{
+			std::uint32_t bits;
+			std::memcpy(&bits, &x, sizeof(bits));
+			bits = 0x5f3759df - (bits >> 1);
+
+			float y;
+			std::memcpy(&y, &bits, sizeof(y));
+
+			// one Newton step
+			return y * (1.5f - 0.5f * x * y * y);
+		}
+
+		// of x radians, to within 0.0015. A parabola through the half period, sharpened once
+		inline float fastSin(float x)
+		{
+			// into [-PI, PI)
+			x -= 2 * PI * std::floor((x + PI) / (2 * PI));
+
+			float y = 4 / PI * x - 4 / (PI * PI) * x * std::abs(x);
+			return 0.225f * (y * std::abs(y) - y) + y;
+		}
+
+		inline float fastCos(float x)
+		{
+			return fastSin(x + PI / 2);
+		}
 	}
 }
 
@@ -0,0 +1,158 @@
+#include "Packed.hpp"
+
+#include "../SystemInfo/CpuInfo.hpp"
+
+#ifdef SWIFT_AVX2_KERNELS
+	#include <immintrin.h>
+#endif
+
+namespace swift
+{
+	namespace math
+	{
+		namespace
+		{
+			// 1 or 0 for each lane of a mask
+			void storeMask(const Float4& mask, unsigned char* out)
+			{
+				int bits = Float4::bits(mask);
+
+				out[0] = bits & 1;
+				out[1] = (bits >> 1) & 1;
+				out[2] = (bits >> 2) & 1;
+				out[3] = (bits >> 3) & 1;
+			}
+
+#ifdef SWIFT_AVX2_KERNELS
+			// x and y stay interleaved, squares or products are summed in pairs. hadd works per 128 bit half,
+			// leaving 0 1 4 5 2 3 6 7, the permute puts them back in order
+			SWIFT_TARGET_AVX2 __m256 sumPairs(__m256 one, __m256 two)
+			{
+				return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_hadd_ps(one, two)), _MM_SHUFFLE(3, 1, 2, 0)));
+			}
+
+			SWIFT_TARGET_AVX2 std::size_t distanceSquaredAVX2(const sf::Vector2f* points, std::size_t count, const sf::Vector2f& to, float* out)
+			{
+				const __m256 target = _mm256_setr_ps(to.x, to.y, to.x, to.y, to.x, to.y, to.x, to.y);
+
+				std::size_t i = 0;
+
+				for(; i + 8 <= count; i += 8)
+				{
+					__m256 one = _mm256_sub_ps(target, _mm256_loadu_ps(&points[i].x));
+					__m256 two = _mm256_sub_ps(target, _mm256_loadu_ps(&points[i + 4].x));
+					_mm256_storeu_ps(out + i, sumPairs(_mm256_mul_ps(one, one), _mm256_mul_ps(two, two)));
+				}
+
+				return i;
+			}
+
+			SWIFT_TARGET_AVX2 std::size_t dotAVX2(const sf::Vector2f* one, const sf::Vector2f* two, std::size_t count, float* out)
+			{
+				std::size_t i = 0;
+
+				for(; i + 8 <= count; i += 8)
+				{
+					__m256 low = _mm256_mul_ps(_mm256_loadu_ps(&one[i].x), _mm256_loadu_ps(&two[i].x));
+					__m256 high = _mm256_mul_ps(_mm256_loadu_ps(&one[i + 4].x), _mm256_loadu_ps(&two[i + 4].x));
+					_mm256_storeu_ps(out + i, sumPairs(low, high));
+				}
+
+				return i;
+			}
+#endif
+		}
+
+		void distanceSquared(const sf::Vector2f* points, std::size_t count, const sf::Vector2f& to, float* out)
+		{
+			std::size_t i = 0;
+			SimdLevel level = getSimdLevel();
+
+#ifdef SWIFT_AVX2_KERNELS
+			if(level == SimdLevel::Avx2)
+				i = distanceSquaredAVX2(points, count, to, out);
+#endif
+
+			Vec2x4 target = Vec2x4::set(to);
+			Vec2x8 wide = {target, target};
+
+			for(; level >= SimdLevel::Wide4 && i + 8 <= count; i += 8)
+				distanceSquared(Vec2x8::load(points + i), wide, out + i);
+
+			for(; level >= SimdLevel::Wide4 && i + 4 <= count; i += 4)
+				distanceSquared(Vec2x4::load(points + i), target).store(out + i);
+
+			// whatever doesn't fill a whole batch
+			for(; i < count; i++)
+				out[i] = (to.x - points[i].x) * (to.x - points[i].x) + (to.y - points[i].y) * (to.y - points[i].y);
+		}
+
+		void dot(const sf::Vector2f* one, const sf::Vector2f* two, std::size_t count, float* out)
+		{
+			std::size_t i = 0;
+			SimdLevel level = getSimdLevel();
+
+#ifdef SWIFT_AVX2_KERNELS
+			if(level == SimdLevel::Avx2)
+				i = dotAVX2(one, two, count, out);
+#endif
+
+			for(; level >= SimdLevel::Wide4 && i + 8 <= count; i += 8)
+				dot(Vec2x8::load(one + i), Vec2x8::load(two + i), out + i);
+
+			for(; level >= SimdLevel::Wide4 && i + 4 <= count; i += 4)
+				dot(Vec2x4::load(one + i), Vec2x4::load(two + i)).store(out + i);
+
+			for(; i < count; i++)
+				out[i] = one[i].x * two[i].x + one[i].y * two[i].y;
+		}
+
+		void unit(const sf::Vector2f* in, std::size_t count, sf::Vector2f* out)
+		{
+			std::size_t i = 0;
+
+			for(; i + 8 <= count; i += 8)
+				unit(Vec2x8::load(in + i)).store(out + i);
+
+			for(; i + 4 <= count; i += 4)
+				unit(Vec2x4::load(in + i)).store(out + i);
+
+			// the wide lanes' rsqrt is an estimate, the rest go through the same one so results don't depend on where they were
+			for(; i < count; i++)
+			{
+				sf::Vector2f v[4] = {in[i]};
+				unit(Vec2x4::load(v)).store(v);
+				out[i] = v[0];
+			}
+		}
+
+		void contains(const sf::FloatRect& box, const sf::Vector2f* points, std::size_t count, unsigned char* inside)
+		{
+			std::size_t i = 0;
+
+			AABBx4 boxes = AABBx4::set(box);
+
+			for(; i + 4 <= count; i += 4)
+				storeMask(contains(boxes, Vec2x4::load(points + i)), inside + i);
+
+			for(; i < count; i++)
+				inside[i] = box.contains(points[i]);
+		}
+
+		void intersects(const sf::FloatRect& box, const sf::FloatRect* boxes, std::size_t count, unsigned char* hits)
+		{
+			std::size_t i = 0;
+
+			AABBx4 one = AABBx4::set(box);
+
+			for(; i + 4 <= count; i += 4)
+				storeMask(intersects(one, AABBx4::load(boxes + i)), hits + i);
+
+			for(; i < count; i++)
+			{
+				hits[i] = box.left < boxes[i].left + boxes[i].width && boxes[i].left < box.left + box.width
+						&& box.top < boxes[i].top + boxes[i].height && boxes[i].top < box.top + box.height;
+			}
+		}
+	}
+}
@@ -0,0 +1,400 @@
+#ifndef PACKED_HPP
+#define PACKED_HPP
+
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define SWIFT_MATH_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SWIFT_MATH_NEON
+#endif
+
+namespace swift
+{
+	namespace math
+	{
+		// 4 floats worked on at once, with SSE or NEON where available, plain floats otherwise.
+		// comparisons give masks, all bits set in lanes where they hold, for select
+		class Float4
+		{
+			public:
+#if defined(SWIFT_MATH_SSE)
+				typedef __m128 Lanes;
+#elif defined(SWIFT_MATH_NEON)
+				typedef float32x4_t Lanes;
+#else
+				struct Lanes
+				{
+					float v[4];
+				};
+#endif
+
+				Float4() = default;
+				Float4(Lanes l) : lanes(l) {}
+
+				static Float4 set(float f);
+				static Float4 load(const float* p);
+				void store(float* p) const;
+
+				Float4 operator+(const Float4& o) const;
+				Float4 operator-(const Float4& o) const;
+				Float4 operator*(const Float4& o) const;
+
+				static Float4 min(const Float4& a, const Float4& b);
+				static Float4 max(const Float4& a, const Float4& b);
+
+				// about 1 in 10^6 off, the hardware estimate with a Newton step. Infinite for 0
+				static Float4 rsqrt(const Float4& a);
+
+				// masks
+				static Float4 lessEqual(const Float4& a, const Float4& b);
+				static Float4 less(const Float4& a, const Float4& b);
+				static Float4 both(const Float4& a, const Float4& b);
+
+				// a where mask is set, b elsewhere
+				static Float4 select(const Float4& mask, const Float4& a, const Float4& b);
+
+				// bit i is set if lane i of mask is
+				static int bits(const Float4& mask);
+
+				Lanes lanes;
+		};
+
+		// 4 vectors, xs in one Float4 and ys in another
+		struct Vec2x4
+		{
+			Float4 x;
+			Float4 y;
+
+			// from 4 in a row, as they're kept in arrays
+			static Vec2x4 load(const sf::Vector2f* v);
+			void store(sf::Vector2f* v) const;
+
+			static Vec2x4 set(const sf::Vector2f& v);
+		};
+
+		// 8 vectors as 2 halves of 4, for loops that have the registers for it
+		struct Vec2x8
+		{
+			Vec2x4 low;
+			Vec2x4 high;
+
+			static Vec2x8 load(const sf::Vector2f* v);
+			void store(sf::Vector2f* v) const;
+		};
+
+		// 4 boxes, by edge
+		struct AABBx4
+		{
+			Float4 left;
+			Float4 top;
+			Float4 right;
+			Float4 bottom;
+
+			static AABBx4 set(const sf::FloatRect& box);
+			static AABBx4 load(const sf::FloatRect* boxes);
+		};
+
+		Float4 dot(const Vec2x4& one, const Vec2x4& two);
+		Float4 magnitudeSquared(const Vec2x4& vec);
+		Float4 distanceSquared(const Vec2x4& one, const Vec2x4& two);
+
+		// as unit does, zero vectors stay zero
+		Vec2x4 unit(const Vec2x4& vec);
+
+		// masks. Points on the left and top edges are inside, as with sf::Rect::contains
+		Float4 contains(const AABBx4& box, const Vec2x4& points);
+		Float4 intersects(const AABBx4& one, const AABBx4& two);
+
+		// 8 results, into out
+		void dot(const Vec2x8& one, const Vec2x8& two, float* out);
+		void distanceSquared(const Vec2x8& one, const Vec2x8& two, float* out);
+
+		Vec2x8 unit(const Vec2x8& vec);
+
+		/* over arrays, 8 at a time, then 4, then one by one */
+
+		// out[i] is the squared distance from points[i] to to
+		void distanceSquared(const sf::Vector2f* points, std::size_t count, const sf::Vector2f& to, float* out);
+
+		void dot(const sf::Vector2f* one, const sf::Vector2f* two, std::size_t count, float* out);
+
+		// in and out may be the same array
+		void unit(const sf::Vector2f* in, std::size_t count, sf::Vector2f* out);
+
+		// inside[i] is 1 if points[i] is in box, 0 otherwise
+		void contains(const sf::FloatRect& box, const sf::Vector2f* points, std::size_t count, unsigned char* inside);
+
+		// hits[i] is 1 if boxes[i] overlaps box, 0 otherwise. Boxes that only touch don't
+		void intersects(const sf::FloatRect& box, const sf::FloatRect* boxes, std::size_t count, unsigned char* hits);
+
+#if defined(SWIFT_MATH_SSE)
+		inline Float4 Float4::set(float f) { return _mm_set1_ps(f); }
+		inline Float4 Float4::load(const float* p) { return _mm_loadu_ps(p); }
+		inline void Float4::store(float* p) const { _mm_storeu_ps(p, lanes); }
+
+		inline Float4 Float4::operator+(const Float4& o) const { return _mm_add_ps(lanes, o.lanes); }
+		inline Float4 Float4::operator-(const Float4& o) const { return _mm_sub_ps(lanes, o.lanes); }
+		inline Float4 Float4::operator*(const Float4& o) const { return _mm_mul_ps(lanes, o.lanes); }
+
+		inline Float4 Float4::min(const Float4& a, const Float4& b) { return _mm_min_ps(a.lanes, b.lanes); }
+		inline Float4 Float4::max(const Float4& a, const Float4& b) { return _mm_max_ps(a.lanes, b.lanes); }
+
+		inline Float4 Float4::rsqrt(const Float4& a)
+		{
+			__m128 e = _mm_rsqrt_ps(a.lanes);
+			__m128 half = _mm_mul_ps(_mm_set1_ps(0.5f), a.lanes);
+			return _mm_mul_ps(e, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half, _mm_mul_ps(e, e))));
+		}
+
+		inline Float4 Float4::lessEqual(const Float4& a, const Float4& b) { return _mm_cmple_ps(a.lanes, b.lanes); }
+		inline Float4 Float4::less(const Float4& a, const Float4& b) { return _mm_cmplt_ps(a.lanes, b.lanes); }
+		inline Float4 Float4::both(const Float4& a, const Float4& b) { return _mm_and_ps(a.lanes, b.lanes); }
+
+		inline Float4 Float4::select(const Float4& mask, const Float4& a, const Float4& b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask.lanes, a.lanes), _mm_andnot_ps(mask.lanes, b.lanes));
+		}
+
+		inline int Float4::bits(const Float4& mask) { return _mm_movemask_ps(mask.lanes); }
+
+		inline Vec2x4 Vec2x4::load(const sf::Vector2f* v)
+		{
+			// x0 y0 x1 y1, x2 y2 x3 y3
+			__m128 one = _mm_loadu_ps(&v[0].x);
+			__m128 two = _mm_loadu_ps(&v[2].x);
+			return {_mm_shuffle_ps(one, two, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(one, two, _MM_SHUFFLE(3, 1, 3, 1))};
+		}
+
+		inline void Vec2x4::store(sf::Vector2f* v) const
+		{
+			_mm_storeu_ps(&v[0].x, _mm_unpacklo_ps(x.lanes, y.lanes));
+			_mm_storeu_ps(&v[2].x, _mm_unpackhi_ps(x.lanes, y.lanes));
+		}
+#elif defined(SWIFT_MATH_NEON)
+		inline Float4 Float4::set(float f) { return vdupq_n_f32(f); }
+		inline Float4 Float4::load(const float* p) { return vld1q_f32(p); }
+		inline void Float4::store(float* p) const { vst1q_f32(p, lanes); }
+
+		inline Float4 Float4::operator+(const Float4& o) const { return vaddq_f32(lanes, o.lanes); }
+		inline Float4 Float4::operator-(const Float4& o) const { return vsubq_f32(lanes, o.lanes); }
+		inline Float4 Float4::operator*(const Float4& o) const { return vmulq_f32(lanes, o.lanes); }
+
+		inline Float4 Float4::min(const Float4& a, const Float4& b) { return vminq_f32(a.lanes, b.lanes); }
+		inline Float4 Float4::max(const Float4& a, const Float4& b) { return vmaxq_f32(a.lanes, b.lanes); }
+
+		inline Float4 Float4::rsqrt(const Float4& a)
+		{
+			float32x4_t e = vrsqrteq_f32(a.lanes);
+			e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a.lanes, e), e));
+			return vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(a.lanes, e), e));
+		}
+
+		inline Float4 Float4::lessEqual(const Float4& a, const Float4& b) { return vreinterpretq_f32_u32(vcleq_f32(a.lanes, b.lanes)); }
+		inline Float4 Float4::less(const Float4& a, const Float4& b) { return vreinterpretq_f32_u32(vcltq_f32(a.lanes, b.lanes)); }
+
+		inline Float4 Float4::both(const Float4& a, const Float4& b)
+		{
+			return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.lanes), vreinterpretq_u32_f32(b.lanes)));
+		}
+
+		inline Float4 Float4::select(const Float4& mask, const Float4& a, const Float4& b)
+		{
+			return vbslq_f32(vreinterpretq_u32_f32(mask.lanes), a.lanes, b.lanes);
+		}
+
+		inline int Float4::bits(const Float4& mask)
+		{
+			uint32_t lanes[4];
+			vst1q_u32(lanes, vreinterpretq_u32_f32(mask.lanes));
+			return (lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8);
+		}
+
+		inline Vec2x4 Vec2x4::load(const sf::Vector2f* v)
+		{
+			float32x4x2_t both = vld2q_f32(&v[0].x);
+			return {both.val[0], both.val[1]};
+		}
+
+		inline void Vec2x4::store(sf::Vector2f* v) const
+		{
+			float32x4x2_t both = {{x.lanes, y.lanes}};
+			vst2q_f32(&v[0].x, both);
+		}
+#else
+		inline Float4 Float4::set(float f) { return Lanes{{f, f, f, f}}; }
+		inline Float4 Float4::load(const float* p) { return Lanes{{p[0], p[1], p[2], p[3]}}; }
+		inline void Float4::store(float* p) const { std::copy(lanes.v, lanes.v + 4, p); }
+
+		inline Float4 Float4::operator+(const Float4& o) const
+		{
+			return Lanes{{lanes.v[0] + o.lanes.v[0], lanes.v[1] + o.lanes.v[1], lanes.v[2] + o.lanes.v[2], lanes.v[3] + o.lanes.v[3]}};
+		}
+
+		inline Float4 Float4::operator-(const Float4& o) const
+		{
+			return Lanes{{lanes.v[0] - o.lanes.v[0], lanes.v[1] - o.lanes.v[1], lanes.v[2] - o.lanes.v[2], lanes.v[3] - o.lanes.v[3]}};
+		}
+
+		inline Float4 Float4::operator*(const Float4& o) const
+		{
+			return Lanes{{lanes.v[0] * o.lanes.v[0], lanes.v[1] * o.lanes.v[1], lanes.v[2] * o.lanes.v[2], lanes.v[3] * o.lanes.v[3]}};
+		}
+
+		inline Float4 Float4::min(const Float4& a, const Float4& b)
+		{
+			return Lanes{{std::min(a.lanes.v[0], b.lanes.v[0]), std::min(a.lanes.v[1], b.lanes.v[1]), std::min(a.lanes.v[2], b.lanes.v[2]), std::min(a.lanes.v[3], b.lanes.v[3])}};
+		}
+
+		inline Float4 Float4::max(const Float4& a, const Float4& b)
+		{
+			return Lanes{{std::max(a.lanes.v[0], b.lanes.v[0]), std::max(a.lanes.v[1], b.lanes.v[1]), std::max(a.lanes.v[2], b.lanes.v[2]), std::max(a.lanes.v[3], b.lanes.v[3])}};
+		}
+
+		inline Float4 Float4::rsqrt(const Float4& a)
+		{
+			return Lanes{{1 / std::sqrt(a.lanes.v[0]), 1 / std::sqrt(a.lanes.v[1]), 1 / std::sqrt(a.lanes.v[2]), 1 / std::sqrt(a.lanes.v[3])}};
+		}
+
+		// masks are 1 or 0, select only looks at whether a lane is 0
+		inline Float4 Float4::lessEqual(const Float4& a, const Float4& b)
+		{
+			return Lanes{{a.lanes.v[0] <= b.lanes.v[0] ? 1.f : 0.f, a.lanes.v[1] <= b.lanes.v[1] ? 1.f : 0.f, a.lanes.v[2] <= b.lanes.v[2] ? 1.f : 0.f, a.lanes.v[3] <= b.lanes.v[3] ? 1.f : 0.f}};
+		}
+
+		inline Float4 Float4::less(const Float4& a, const Float4& b)
+		{
+			return Lanes{{a.lanes.v[0] < b.lanes.v[0] ? 1.f : 0.f, a.lanes.v[1] < b.lanes.v[1] ? 1.f : 0.f, a.lanes.v[2] < b.lanes.v[2] ? 1.f : 0.f, a.lanes.v[3] < b.lanes.v[3] ? 1.f : 0.f}};
+		}
+
+		inline Float4 Float4::both(const Float4& a, const Float4& b)
+		{
+			return a * b;
+		}
+
+		inline Float4 Float4::select(const Float4& mask, const Float4& a, const Float4& b)
+		{
+			return Lanes{{mask.lanes.v[0] != 0 ? a.lanes.v[0] : b.lanes.v[0], mask.lanes.v[1] != 0 ? a.lanes.v[1] : b.lanes.v[1],
+							mask.lanes.v[2] != 0 ? a.lanes.v[2] : b.lanes.v[2], mask.lanes.v[3] != 0 ? a.lanes.v[3] : b.lanes.v[3]}};
+		}
+
+		inline int Float4::bits(const Float4& mask)
+		{
+			return (mask.lanes.v[0] != 0) | (mask.lanes.v[1] != 0) << 1 | (mask.lanes.v[2] != 0) << 2 | (mask.lanes.v[3] != 0) << 3;
+		}
+
+		inline Vec2x4 Vec2x4::load(const sf::Vector2f* v)
+		{
+			return {Float4::Lanes{{v[0].x, v[1].x, v[2].x, v[3].x}}, Float4::Lanes{{v[0].y, v[1].y, v[2].y, v[3].y}}};
+		}
+
+		inline void Vec2x4::store(sf::Vector2f* v) const
+		{
+			for(int i = 0; i < 4; i++)
+				v[i] = {x.lanes.v[i], y.lanes.v[i]};
+		}
+#endif
+
+		inline Vec2x4 Vec2x4::set(const sf::Vector2f& v)
+		{
+			return {Float4::set(v.x), Float4::set(v.y)};
+		}
+
+		inline Vec2x8 Vec2x8::load(const sf::Vector2f* v)
+		{
+			return {Vec2x4::load(v), Vec2x4::load(v + 4)};
+		}
+
+		inline void Vec2x8::store(sf::Vector2f* v) const
+		{
+			low.store(v);
+			high.store(v + 4);
+		}
+
+		inline AABBx4 AABBx4::set(const sf::FloatRect& box)
+		{
+			return {Float4::set(box.left), Float4::set(box.top), Float4::set(box.left + box.width), Float4::set(box.top + box.height)};
+		}
+
+		inline AABBx4 AABBx4::load(const sf::FloatRect* boxes)
+		{
+			float edges[4][4];
+
+			for(int i = 0; i < 4; i++)
+			{
+				edges[0][i] = boxes[i].left;
+				edges[1][i] = boxes[i].top;
+				edges[2][i] = boxes[i].left + boxes[i].width;
+				edges[3][i] = boxes[i].top + boxes[i].height;
+			}
+
+			return {Float4::load(edges[0]), Float4::load(edges[1]), Float4::load(edges[2]), Float4::load(edges[3])};
+		}
+
+		inline Float4 dot(const Vec2x4& one, const Vec2x4& two)
+		{
+			return one.x * two.x + one.y * two.y;
+		}
+
+		inline Float4 magnitudeSquared(const Vec2x4& vec)
+		{
+			return dot(vec, vec);
+		}
+
+		inline Float4 distanceSquared(const Vec2x4& one, const Vec2x4& two)
+		{
+			Vec2x4 d = {two.x - one.x, two.y - one.y};
+			return dot(d, d);
+		}
+
+		inline Vec2x4 unit(const Vec2x4& vec)
+		{
+			Float4 mag = magnitudeSquared(vec);
+			Float4 zero = Float4::set(0);
+
+			// rsqrt of 0 is infinite, those lanes are zeroed instead
+			Float4 scale = Float4::select(Float4::less(zero, mag), Float4::rsqrt(mag), zero);
+			return {vec.x * scale, vec.y * scale};
+		}
+
+		inline Float4 contains(const AABBx4& box, const Vec2x4& points)
+		{
+			Float4 x = Float4::both(Float4::lessEqual(box.left, points.x), Float4::less(points.x, box.right));
+			Float4 y = Float4::both(Float4::lessEqual(box.top, points.y), Float4::less(points.y, box.bottom));
+			return Float4::both(x, y);
+		}
+
+		inline Float4 intersects(const AABBx4& one, const AABBx4& two)
+		{
+			Float4 x = Float4::both(Float4::less(one.left, two.right), Float4::less(two.left, one.right));
+			Float4 y = Float4::both(Float4::less(one.top, two.bottom), Float4::less(two.top, one.bottom));
+			return Float4::both(x, y);
+		}
+
+		inline void dot(const Vec2x8& one, const Vec2x8& two, float* out)
+		{
+			dot(one.low, two.low).store(out);
+			dot(one.high, two.high).store(out + 4);
+		}
+
+		inline void distanceSquared(const Vec2x8& one, const Vec2x8& two, float* out)
+		{
+			distanceSquared(one.low, two.low).store(out);
+			distanceSquared(one.high, two.high).store(out + 4);
+		}
+
+		inline Vec2x8 unit(const Vec2x8& vec)
+		{
+			return {unit(vec.low), unit(vec.high)};
+		}
+	}
+}
+
+#endif // PACKED_HPP
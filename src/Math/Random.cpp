@@ -0,0 +1,135 @@
+#include "Random.hpp"
+
+#include <atomic>
+
+#include "Hash.hpp"
+
+namespace swift
+{
+	namespace
+	{
+		std::uint64_t splitmix(std::uint64_t& x)
+		{
+			std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			return z ^ (z >> 31);
+		}
+		
+		// threads get streams in the order they first ask for one
+		std::atomic<unsigned> nextThread(0);
+	}
+	
+	std::uint64_t Random::seedValue = 0;
+	unsigned Random::generation = 0;
+	
+	Random::Generator::Generator()
+	{
+		seed(0, 0);
+	}
+	
+	Random::Generator::Generator(std::uint64_t s, std::uint64_t stream)
+	{
+		seed(s, stream);
+	}
+	
+	void Random::Generator::seed(std::uint64_t s, std::uint64_t stream)
+	{
+		// mixed first, so nearby seeds and streams start far apart
+		std::uint64_t x = s;
+		std::uint64_t mixed = splitmix(x) ^ stream;
+		
+		std::uint64_t a = splitmix(mixed);
+		std::uint64_t b = splitmix(mixed);
+		
+		state[0] = static_cast<std::uint32_t>(a);
+		state[1] = static_cast<std::uint32_t>(a >> 32);
+		state[2] = static_cast<std::uint32_t>(b);
+		state[3] = static_cast<std::uint32_t>(b >> 32);
+		
+		// all zeros only ever gives zeros
+		if((state[0] | state[1] | state[2] | state[3]) == 0)
+			state[0] = 1;
+	}
+	
+	std::uint32_t Random::Generator::below(std::uint32_t n)
+	{
+		if(n == 0)
+			return 0;
+		
+		// Lemire's multiply and shift, drawing again only in the rare sliver that would be biased
+		std::uint64_t m = static_cast<std::uint64_t>((*this)()) * n;
+		std::uint32_t low = static_cast<std::uint32_t>(m);
+		
+		if(low < n)
+		{
+			std::uint32_t threshold = (0u - n) % n;
+			
+			while(low < threshold)
+			{
+				m = static_cast<std::uint64_t>((*this)()) * n;
+				low = static_cast<std::uint32_t>(m);
+			}
+		}
+		
+		return static_cast<std::uint32_t>(m >> 32);
+	}
+	
+	void Random::Generator::fill(float* out, std::size_t count, float lo, float hi)
+	{
+		float scale = (hi - lo) * (1.f / 16777216.f);
+		
+		for(std::size_t i = 0; i < count; i++)
+			out[i] = lo + ((*this)() >> 8) * scale;
+	}
+	
+	void Random::Generator::fill(std::uint32_t* out, std::size_t count)
+	{
+		for(std::size_t i = 0; i < count; i++)
+			out[i] = (*this)();
+	}
+	
+	void Random::setSeed(std::uint64_t s)
+	{
+		seedValue = s;
+		generation++;
+	}
+	
+	std::uint64_t Random::getSeed()
+	{
+		return seedValue;
+	}
+	
+	Random::Generator Random::stream(const std::string& name)
+	{
+		return stream(math::hash(name));
+	}
+	
+	Random::Generator Random::stream(std::uint64_t id)
+	{
+		return Generator(seedValue, id);
+	}
+	
+	Random::Generator& Random::local()
+	{
+		struct Local
+		{
+			Generator generator;
+			unsigned generation;
+			unsigned thread;
+			bool seeded;
+		};
+		
+		thread_local Local own = {{}, 0, nextThread++, false};
+		
+		if(!own.seeded || own.generation != generation)
+		{
+			// complemented, so they're far from the small ids streams are usually given
+			own.generator.seed(seedValue, ~static_cast<std::uint64_t>(own.thread));
+			own.generation = generation;
+			own.seeded = true;
+		}
+		
+		return own.generator;
+	}
+}
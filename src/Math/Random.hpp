@@ -0,0 +1,97 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace swift
+{
+	// small, fast generators, each derived from the seed and a stream of its own, so parallel work doesn't share one,
+	// and runs from the same seed get the same numbers. Streams are named, the same name always gets the same numbers
+	class Random
+	{
+		public:
+			// xoshiro128**, 16 bytes of state, seeded through splitmix64. Works with the std:: distributions too
+			class Generator
+			{
+				public:
+					using result_type = std::uint32_t;
+					
+					Generator();
+					Generator(std::uint64_t seed, std::uint64_t stream);
+					
+					void seed(std::uint64_t seed, std::uint64_t stream = 0);
+					
+					static constexpr result_type min()
+					{
+						return 0;
+					}
+					
+					static constexpr result_type max()
+					{
+						return 0xffffffff;
+					}
+					
+					result_type operator()()
+					{
+						std::uint32_t result = rotate(state[1] * 5, 7) * 9;
+						std::uint32_t t = state[1] << 9;
+						
+						state[2] ^= state[0];
+						state[3] ^= state[1];
+						state[1] ^= state[2];
+						state[0] ^= state[3];
+						state[2] ^= t;
+						state[3] = rotate(state[3], 11);
+						
+						return result;
+					}
+					
+					// [0, 1), of the top 24 bits, all a float holds
+					float uniform()
+					{
+						return ((*this)() >> 8) * (1.f / 16777216.f);
+					}
+					
+					float uniform(float lo, float hi)
+					{
+						return lo + (hi - lo) * uniform();
+					}
+					
+					// [0, n), without the bias of taking a remainder
+					std::uint32_t below(std::uint32_t n);
+					
+					// count of them at once, for particles and noise
+					void fill(float* out, std::size_t count, float lo = 0, float hi = 1);
+					void fill(std::uint32_t* out, std::size_t count);
+				
+				private:
+					static std::uint32_t rotate(std::uint32_t x, int k)
+					{
+						return (x << k) | (x >> (32 - k));
+					}
+					
+					std::uint32_t state[4];
+			};
+			
+			// of the world, or of a recording. Generators from stream and local made after it's set derive from it.
+			// Set while nothing else is drawing numbers
+			static void setSeed(std::uint64_t s);
+			static std::uint64_t getSeed();
+			
+			// a system's, a script's, or anything else's with a name
+			static Generator stream(const std::string& name);
+			static Generator stream(std::uint64_t id);
+			
+			// this thread's own, seeded again when the seed changes. Only as repeatable as which thread runs what,
+			// work that has to be the same each run should have a stream
+			static Generator& local();
+		
+		private:
+			static std::uint64_t seedValue;
+			static unsigned generation;
+	};
+}
+
+#endif // RANDOM_HPP
@@ -0,0 +1,107 @@
+#include "FrameArena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace swift
+{
+	FrameArena::FrameArena(std::size_t bs)
+	:	current(0),
+		offset(0),
+		blockSize(std::max<std::size_t>(bs, 1024))
+	{
+	}
+	
+	FrameArena& FrameArena::get()
+	{
+		static thread_local FrameArena arena;
+		return arena;
+	}
+	
+	void* FrameArena::allocate(std::size_t bytes, std::size_t align)
+	{
+		// aligned by the address, blocks come from new, which is only aligned for the fundamental types
+		auto fits = [&](const Block& b, std::size_t from) -> std::size_t
+		{
+			std::uintptr_t start = reinterpret_cast<std::uintptr_t>(b.data.get()) + from;
+			std::size_t padding = (align - start % align) % align;
+			return from + padding + bytes <= b.size ? from + padding : b.size + 1;
+		};
+		
+		if(!blocks.empty())
+		{
+			std::size_t at = fits(blocks[current], offset);
+			
+			if(at <= blocks[current].size)
+			{
+				offset = at + bytes;
+				return blocks[current].data.get() + at;
+			}
+			
+			// blocks after the current one were used before, and are still there
+			if(current + 1 < blocks.size() && fits(blocks[current + 1], 0) <= blocks[current + 1].size)
+			{
+				current++;
+				at = fits(blocks[current], 0);
+				offset = at + bytes;
+				return blocks[current].data.get() + at;
+			}
+		}
+		
+		// after the current one, so scopes taken before it still rewind in order
+		Block block = {std::unique_ptr<char[]>(new char[std::max(blockSize, bytes + align)]), std::max(blockSize, bytes + align)};
+		std::size_t index = blocks.empty() ? 0 : current + 1;
+		blocks.insert(blocks.begin() + index, std::move(block));
+		
+		current = index;
+		std::size_t at = fits(blocks[current], 0);
+		offset = at + bytes;
+		
+		return blocks[current].data.get() + at;
+	}
+	
+	void FrameArena::release(void* ptr, std::size_t bytes)
+	{
+		if(blocks.empty())
+			return;
+		
+		char* block = blocks[current].data.get();
+		
+		if(static_cast<char*>(ptr) + bytes == block + offset)
+			offset = static_cast<char*>(ptr) - block;
+	}
+	
+	void FrameArena::reset()
+	{
+		// a period that needed more than one block gets one that would have fit it, so it stays in one the next time
+		if(blocks.size() > 1)
+		{
+			std::size_t size = getCapacity();
+			blocks.clear();
+			blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+		}
+		
+		current = 0;
+		offset = 0;
+	}
+	
+	std::size_t FrameArena::getUsed() const
+	{
+		std::size_t used = offset;
+		
+		for(std::size_t b = 0; b < current && b < blocks.size(); b++)
+			used += blocks[b].size;
+		
+		return used;
+	}
+	
+	std::size_t FrameArena::getCapacity() const
+	{
+		std::size_t capacity = 0;
+		
+		for(auto& b : blocks)
+			capacity += b.size;
+		
+		return capacity;
+	}
+}
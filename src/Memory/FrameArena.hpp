@@ -0,0 +1,133 @@
+#ifndef FRAMEARENA_HPP
+#define FRAMEARENA_HPP
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+namespace swift
+{
+	// bump allocator for what's only needed until the end of a tick or frame, one per thread. Allocations are
+	// handed out of a few large blocks and given back all at once, by a Scope ending or the arena being reset.
+	// Nothing allocated from it may outlive the innermost Scope around it, or the next reset outside of any Scope
+	class FrameArena
+	{
+		public:
+			static const std::size_t BlockSize = 64 * 1024;
+
+			explicit FrameArena(std::size_t blockSize = BlockSize);
+
+			FrameArena(const FrameArena&) = delete;
+			FrameArena& operator=(const FrameArena&) = delete;
+
+			// the calling thread's
+			static FrameArena& get();
+
+			void* allocate(std::size_t bytes, std::size_t align);
+
+			// only the last allocation is given back early, so a vector growing alone doesn't use up the block.
+			// Everything else waits for its Scope or reset
+			void release(void* ptr, std::size_t bytes);
+
+			// gives everything back. Blocks of a period that needed more than one are merged into one that fits it all
+			void reset();
+
+			// bytes handed out, and held by the blocks
+			std::size_t getUsed() const;
+			std::size_t getCapacity() const;
+
+			// gives back what's allocated from the arena during its lifetime, allocations must stay inside it
+			class Scope
+			{
+				public:
+					explicit Scope(FrameArena& a = get())
+					:	arena(a),
+						block(a.current),
+						offset(a.offset)
+					{}
+
+					~Scope()
+					{
+						arena.current = block;
+						arena.offset = offset;
+					}
+
+					Scope(const Scope&) = delete;
+					Scope& operator=(const Scope&) = delete;
+
+				private:
+					FrameArena& arena;
+					std::size_t block;
+					std::size_t offset;
+			};
+
+		private:
+			struct Block
+			{
+				std::unique_ptr<char[]> data;
+				std::size_t size;
+			};
+
+			std::vector<Block> blocks;
+			std::size_t current;	// block being handed out from
+			std::size_t offset;		// into it
+			std::size_t blockSize;
+	};
+
+	// for standard containers, allocating from the arena of the thread that made the allocator
+	template<typename T>
+	class ArenaAllocator
+	{
+		public:
+			using value_type = T;
+
+			template<typename U>
+			struct rebind
+			{
+				using other = ArenaAllocator<U>;
+			};
+
+			ArenaAllocator()
+			:	arena(&FrameArena::get())
+			{}
+
+			explicit ArenaAllocator(FrameArena& a)
+			:	arena(&a)
+			{}
+
+			template<typename U>
+			ArenaAllocator(const ArenaAllocator<U>& other)
+			:	arena(other.arena)
+			{}
+
+			T* allocate(std::size_t n)
+			{
+				return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+			}
+
+			void deallocate(T* ptr, std::size_t n)
+			{
+				arena->release(ptr, n * sizeof(T));
+			}
+
+			FrameArena* arena;
+	};
+
+	template<typename T, typename U>
+	bool operator==(const ArenaAllocator<T>& one, const ArenaAllocator<U>& two)
+	{
+		return one.arena == two.arena;
+	}
+
+	template<typename T, typename U>
+	bool operator!=(const ArenaAllocator<T>& one, const ArenaAllocator<U>& two)
+	{
+		return one.arena != two.arena;
+	}
+
+	// a vector of transient data, in a function with a FrameArena::Scope
+	template<typename T>
+	using FrameVector = std::vector<T, ArenaAllocator<T>>;
+}
+
+#endif // FRAMEARENA_HPP
@@ -0,0 +1,211 @@
+#include "MemoryTracker.hpp"
+
+#include <fstream>
+#include <new>
+#include <cstdlib>
+
+namespace swift
+{
+	namespace
+	{
+		// plain data, so it's ready before any static constructor allocates
+		thread_local MemoryTracker::Category current = MemoryTracker::Category::Untagged;
+	}
+	
+	MemoryTracker::Counters MemoryTracker::counters[static_cast<unsigned>(Category::Count)];
+	
+	void MemoryTracker::allocate(Category c, std::size_t bytes)
+	{
+		Counters& counter = counters[static_cast<unsigned>(c)];
+		
+		std::size_t live = counter.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		counter.allocations.fetch_add(1, std::memory_order_relaxed);
+		
+		std::size_t peak = counter.peak.load(std::memory_order_relaxed);
+		
+		while(live > peak && !counter.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			;
+	}
+	
+	void MemoryTracker::release(Category c, std::size_t bytes)
+	{
+		Counters& counter = counters[static_cast<unsigned>(c)];
+		
+		counter.live.fetch_sub(bytes, std::memory_order_relaxed);
+		counter.frees.fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	MemoryTracker::Stats MemoryTracker::getStats(Category c)
+	{
+		const Counters& counter = counters[static_cast<unsigned>(c)];
+		
+		return {counter.live.load(std::memory_order_relaxed), counter.peak.load(std::memory_order_relaxed),
+				counter.allocations.load(std::memory_order_relaxed), counter.frees.load(std::memory_order_relaxed)};
+	}
+	
+	const char* MemoryTracker::getName(Category c)
+	{
+		static const char* names[] = {"Untagged", "Entities", "TileMap", "Assets", "Scripting", "Audio", "Gui"};
+		
+		return c < Category::Count ? names[static_cast<unsigned>(c)] : "";
+	}
+	
+	void MemoryTracker::reset()
+	{
+		for(auto& c : counters)
+		{
+			c.peak.store(c.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			c.allocations.store(0, std::memory_order_relaxed);
+			c.frees.store(0, std::memory_order_relaxed);
+		}
+	}
+	
+	bool MemoryTracker::save(const std::string& file)
+	{
+		std::ofstream fout(file);
+		
+		if(!fout)
+			return false;
+		
+		fout << "category,live,peak,allocations,frees\n";
+		
+		for(unsigned c = 0; c < static_cast<unsigned>(Category::Count); c++)
+		{
+			Stats stats = getStats(static_cast<Category>(c));
+			fout << getName(static_cast<Category>(c)) << ',' << stats.live << ',' << stats.peak << ',' << stats.allocations << ',' << stats.frees << '\n';
+		}
+		
+		return fout.good();
+	}
+	
+	bool MemoryTracker::isTrackingHeap()
+	{
+		#ifdef SWIFT_TRACK_MEMORY
+			return true;
+		#else
+			return false;
+		#endif
+	}
+	
+	MemoryTracker::Category MemoryTracker::getCategory()
+	{
+		return current;
+	}
+	
+	void MemoryTracker::setCategory(Category c)
+	{
+		current = c;
+	}
+}
+
+#ifdef SWIFT_TRACK_MEMORY
+namespace
+{
+	// before each block, what it was counted as. A whole max_align_t, so blocks stay aligned for anything
+	union Header
+	{
+		struct
+		{
+			std::size_t size;
+			swift::MemoryTracker::Category category;
+		} block;
+		
+		std::max_align_t align;
+	};
+	
+	void* take(std::size_t size)
+	{
+		Header* header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+		
+		if(!header)
+			return nullptr;
+		
+		header->block.size = size;
+		header->block.category = swift::MemoryTracker::getCategory();
+		swift::MemoryTracker::allocate(header->block.category, size);
+		
+		return header + 1;
+	}
+	
+	void give(void* ptr)
+	{
+		if(!ptr)
+			return;
+		
+		Header* header = static_cast<Header*>(ptr) - 1;
+		swift::MemoryTracker::release(header->block.category, header->block.size);
+		std::free(header);
+	}
+	
+	void* takeOrThrow(std::size_t size)
+	{
+		// as the standard's, new handlers get a chance to free something
+		while(true)
+		{
+			if(void* ptr = take(size ? size : 1))
+				return ptr;
+			
+			std::new_handler handler = std::get_new_handler();
+			
+			if(!handler)
+				throw std::bad_alloc();
+			
+			handler();
+		}
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return takeOrThrow(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return takeOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return takeOrThrow(size);
+	}
+	catch(...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return takeOrThrow(size);
+	}
+	catch(...)
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* ptr) noexcept
+{
+	give(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	give(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	give(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	give(ptr);
+}
+#endif
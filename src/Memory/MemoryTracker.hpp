@@ -0,0 +1,97 @@
+#ifndef MEMORYTRACKER_HPP
+#define MEMORYTRACKER_HPP
+
+#include <string>
+#include <atomic>
+#include <cstddef>
+
+namespace swift
+{
+	// live bytes, peak bytes, and allocation counts for each part of the engine. Allocations count against the
+	// category of the innermost MemoryScope on the thread making them, and are freed from the category they were made in.
+	// Heap allocations through new are only seen with SWIFT_TRACK_MEMORY defined, which replaces the global operator new
+	// to keep a header with each block. Lua's memory is counted either way, through its allocator
+	class MemoryTracker
+	{
+		public:
+			enum class Category : unsigned char
+			{
+				Untagged,	// outside of any scope
+				Entities,
+				TileMap,
+				Assets,
+				Scripting,
+				Audio,
+				Gui,
+				Count
+			};
+
+			struct Stats
+			{
+				std::size_t live;			// bytes
+				std::size_t peak;			// most bytes live at once
+				std::size_t allocations;	// since starting, or the last reset
+				std::size_t frees;
+			};
+
+			static void allocate(Category c, std::size_t bytes);
+			static void release(Category c, std::size_t bytes);
+
+			static Stats getStats(Category c);
+			static const char* getName(Category c);
+
+			// peaks go down to what's live, counts to 0
+			static void reset();
+
+			// one line per category, comma separated, with a header line. Files from different builds line up
+			static bool save(const std::string& file);
+
+			// if operator new is being counted, SWIFT_TRACK_MEMORY was defined
+			static bool isTrackingHeap();
+
+			// of the calling thread
+			static Category getCategory();
+			static void setCategory(Category c);
+
+		private:
+			struct Counters
+			{
+				std::atomic<std::size_t> live;
+				std::atomic<std::size_t> peak;
+				std::atomic<std::size_t> allocations;
+				std::atomic<std::size_t> frees;
+			};
+
+			static Counters counters[static_cast<unsigned>(Category::Count)];
+	};
+
+	// counts allocations against c from construction to destruction
+	class MemoryScope
+	{
+		public:
+			explicit MemoryScope(MemoryTracker::Category c)
+			:	previous(MemoryTracker::getCategory())
+			{
+				MemoryTracker::setCategory(c);
+			}
+
+			~MemoryScope()
+			{
+				MemoryTracker::setCategory(previous);
+			}
+
+			MemoryScope(const MemoryScope&) = delete;
+			MemoryScope& operator=(const MemoryScope&) = delete;
+
+		private:
+			MemoryTracker::Category previous;
+	};
+}
+
+#define SWIFT_MEMORY_CONCAT_IMPL(a, b) a##b
+#define SWIFT_MEMORY_CONCAT(a, b) SWIFT_MEMORY_CONCAT_IMPL(a, b)
+
+// counts the rest of the enclosing scope's allocations as category, one of MemoryTracker::Category
+#define SWIFT_MEMORY_SCOPE(category) swift::MemoryScope SWIFT_MEMORY_CONCAT(memoryScope, __LINE__)(swift::MemoryTracker::Category::category)
+
+#endif // MEMORYTRACKER_HPP
@@ -0,0 +1,109 @@
+#ifndef OBJECTPOOL_HPP
+#define OBJECTPOOL_HPP
+
+#include <new>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+#include "PoolStats.hpp"
+
+namespace swift
+{
+	// fixed-size object allocator. Memory is taken in blocks of BlockSize objects and
+	// never returned before the pool dies, freed slots are chained in a free list.
+	// addresses stay stable. Objects still alive when the pool is destroyed are not destructed
+	template<typename T, std::size_t BlockSize = 256>
+	class ObjectPool
+	{
+		public:
+			ObjectPool()
+			:	freeList(nullptr)
+			{
+			}
+
+			~ObjectPool()
+			{
+				for(auto& b : blocks)
+					delete[] b;
+			}
+
+			ObjectPool(const ObjectPool&) = delete;
+			ObjectPool& operator=(const ObjectPool&) = delete;
+
+			template<typename... Args>
+			T* create(Args&&... args)
+			{
+				if(freeList == nullptr)
+					allocateBlock();
+
+				Slot* slot = freeList;
+				freeList = slot->next;
+
+				T* obj = new(&slot->storage) T(std::forward<Args>(args)...);
+
+				stats.live++;
+				if(stats.live > stats.peak)
+					stats.peak = stats.live;
+
+				return obj;
+			}
+
+			void destroy(T* obj)
+			{
+				if(obj == nullptr)
+					return;
+
+				obj->~T();
+
+				Slot* slot = reinterpret_cast<Slot*>(obj);
+				slot->next = freeList;
+				freeList = slot;
+
+				stats.live--;
+			}
+
+			// makes sure count objects can be alive without allocating
+			void reserve(std::size_t count)
+			{
+				while(stats.capacity < count)
+					allocateBlock();
+			}
+
+			const PoolStats& getStats() const
+			{
+				return stats;
+			}
+
+		private:
+			union Slot
+			{
+				Slot* next;
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+			};
+
+			void allocateBlock()
+			{
+				Slot* block = new Slot[BlockSize];
+
+				// chain in reverse, so slots are handed out in address order
+				for(std::size_t i = BlockSize; i > 0; i--)
+				{
+					block[i - 1].next = freeList;
+					freeList = &block[i - 1];
+				}
+
+				blocks.push_back(block);
+
+				stats.capacity += BlockSize;
+				stats.growths++;
+			}
+
+			std::vector<Slot*> blocks;
+			Slot* freeList;
+
+			PoolStats stats;
+	};
+}
+
+#endif // OBJECTPOOL_HPP
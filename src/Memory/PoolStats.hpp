@@ -0,0 +1,18 @@
+#ifndef POOLSTATS_HPP
+#define POOLSTATS_HPP
+
+#include <cstddef>
+
+namespace swift
+{
+	// numbers for sizing a pool up front
+	struct PoolStats
+	{
+		std::size_t live = 0;		// objects currently allocated
+		std::size_t peak = 0;		// most objects allocated at once
+		std::size_t capacity = 0;	// objects that fit without growing
+		std::size_t growths = 0;	// times the pool had to grow
+	};
+}
+
+#endif // POOLSTATS_HPP
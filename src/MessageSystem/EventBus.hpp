@@ -0,0 +1,246 @@
+#ifndef EVENTBUS_HPP
+#define EVENTBUS_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace swift
+{
+	using EventId = std::uint8_t;
+	
+	// events by id, each with a T. Any thread publishes, without locks, into one bounded queue.
+	// The owning thread calls dispatch, which hands the queued events out in a batch to each subscriber
+	// wanting their id. Subscribers read their batch in place, until the next dispatch
+	template<typename T>
+	class EventBus
+	{
+		public:
+			static const EventId MaxEvents = 64;	// ids are under this
+			
+			struct Event
+			{
+				EventId id;
+				T data;
+			};
+			
+			// a subscriber's batch, pointing into its buffer
+			class View
+			{
+				public:
+					View(const Event* b, const Event* e)
+					:	first(b),
+						last(e)
+					{}
+					
+					const Event* begin() const
+					{
+						return first;
+					}
+					
+					const Event* end() const
+					{
+						return last;
+					}
+					
+					std::size_t size() const
+					{
+						return static_cast<std::size_t>(last - first);
+					}
+					
+					bool empty() const
+					{
+						return first == last;
+					}
+				
+				private:
+					const Event* first;
+					const Event* last;
+			};
+			
+			class Subscriber
+			{
+				public:
+					// the events from the last dispatch
+					View getEvents() const
+					{
+						return {events.data(), events.data() + count};
+					}
+					
+					// events that didn't fit in the buffer, over every dispatch
+					unsigned getDropped() const
+					{
+						return dropped;
+					}
+				
+				private:
+					friend class EventBus;
+					
+					Subscriber(std::uint64_t m, std::size_t capacity)
+					:	mask(m),
+						events(capacity),
+						count(0),
+						dropped(0)
+					{}
+					
+					std::uint64_t mask;	// bit per id
+					std::vector<Event> events;	// fixed size, filled from the front each dispatch
+					std::size_t count;
+					unsigned dropped;
+			};
+			
+			// capacity is rounded up to a power of 2
+			explicit EventBus(std::size_t capacity = 1024)
+			:	slots(roundUp(capacity)),
+				head(0),
+				tail(0),
+				dropped(0)
+			{
+				for(std::size_t i = 0; i < slots.size(); i++)
+					slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			
+			EventBus(const EventBus&) = delete;
+			EventBus& operator=(const EventBus&) = delete;
+			
+			// from any thread. False if the queue is full, the event is dropped then
+			bool publish(EventId id, const T& data)
+			{
+				const std::size_t mask = slots.size() - 1;
+				std::size_t pos = tail.load(std::memory_order_relaxed);
+				Slot* slot;
+				
+				while(true)
+				{
+					slot = &slots[pos & mask];
+					std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+					std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+					
+					// the slot is free for pos, claim it
+					if(diff == 0)
+					{
+						if(tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+							break;
+					}
+					// still holding an event from a lap ago
+					else if(diff < 0)
+					{
+						dropped.fetch_add(1, std::memory_order_relaxed);
+						return false;
+					}
+					else
+					{
+						pos = tail.load(std::memory_order_relaxed);
+					}
+				}
+				
+				slot->event.id = id;
+				slot->event.data = data;
+				slot->sequence.store(pos + 1, std::memory_order_release);
+				
+				return true;
+			}
+			
+			// the remaining calls are for the owning thread only.
+			// The subscriber is good for as long as the bus is
+			Subscriber& subscribe(std::initializer_list<EventId> ids, std::size_t capacity = 256)
+			{
+				std::uint64_t mask = 0;
+				
+				for(auto id : ids)
+				{
+					if(id < MaxEvents)
+						mask |= std::uint64_t(1) << id;
+				}
+				
+				subscribers.emplace_back(new Subscriber(mask, capacity));
+				return *subscribers.back();
+			}
+			
+			void unsubscribe(Subscriber& s)
+			{
+				for(auto it = subscribers.begin(); it != subscribers.end(); ++it)
+				{
+					if(it->get() == &s)
+					{
+						subscribers.erase(it);
+						return;
+					}
+				}
+			}
+			
+			// ends every subscriber's last batch, and gives them what's been published since.
+			// Events published while it runs wait for the next one
+			void dispatch()
+			{
+				for(auto& s : subscribers)
+					s->count = 0;
+				
+				const std::size_t mask = slots.size() - 1;
+				const std::size_t end = tail.load(std::memory_order_acquire);
+				
+				// up to where it was at the start, publishers can't keep it going
+				while(head != end)
+				{
+					Slot& slot = slots[head & mask];
+					
+					// not published yet, or still being written
+					if(slot.sequence.load(std::memory_order_acquire) != head + 1)
+						break;
+					
+					std::uint64_t bit = slot.event.id < MaxEvents ? std::uint64_t(1) << slot.event.id : 0;
+					
+					for(auto& s : subscribers)
+					{
+						if(!(s->mask & bit))
+							continue;
+						
+						if(s->count < s->events.size())
+							s->events[s->count++] = slot.event;
+						else
+							s->dropped++;
+					}
+					
+					slot.sequence.store(head + slots.size(), std::memory_order_release);
+					head++;
+				}
+			}
+			
+			// events publish couldn't queue
+			unsigned getDropped() const
+			{
+				return dropped.load(std::memory_order_relaxed);
+			}
+		
+		private:
+			// sequence says whose turn the slot is. pos when free for the publisher at pos, pos + 1 once it's published
+			struct Slot
+			{
+				std::atomic<std::size_t> sequence;
+				Event event;
+			};
+			
+			static std::size_t roundUp(std::size_t n)
+			{
+				std::size_t p = 2;
+				
+				while(p < n)
+					p <<= 1;
+				
+				return p;
+			}
+			
+			std::vector<Slot> slots;
+			
+			alignas(64) std::size_t head;	// next to dispatch, the owner's alone
+			alignas(64) std::atomic<std::size_t> tail;	// next to publish into
+			std::atomic<unsigned> dropped;
+			
+			std::vector<std::unique_ptr<Subscriber>> subscribers;
+	};
+}
+
+#endif // EVENTBUS_HPP
@@ -0,0 +1,173 @@
+#include "EntityState.hpp"
+
+#include <cmath>
+
+namespace swift
+{
+	constexpr float EntityState::POSITION_SCALE;
+	constexpr float EntityState::ANGLE_SCALE;
+	
+	namespace
+	{
+		std::int32_t quantize(float f, float scale)
+		{
+			return static_cast<std::int32_t>(std::lround(f * scale));
+		}
+	}
+	
+	EntityState EntityState::capture(const Entity& e)
+	{
+		EntityState state;
+		state.components = static_cast<std::uint32_t>(e.getMask().to_ulong());
+		
+		if(Physical* phys = e.get<Physical>())
+		{
+			float angle = std::fmod(phys->angle, 360.f);
+			
+			state.x = quantize(phys->position.x, POSITION_SCALE);
+			state.y = quantize(phys->position.y, POSITION_SCALE);
+			state.angle = static_cast<std::uint16_t>(quantize(angle < 0 ? angle + 360 : angle, ANGLE_SCALE));
+			state.zIndex = phys->zIndex;
+			state.width = phys->size.x;
+			state.height = phys->size.y;
+			state.collides = phys->collides;
+		}
+		
+		if(Movable* mov = e.get<Movable>())
+		{
+			state.velocityX = quantize(mov->velocity.x, POSITION_SCALE);
+			state.velocityY = quantize(mov->velocity.y, POSITION_SCALE);
+			state.moveVelocity = quantize(mov->moveVelocity, POSITION_SCALE);
+		}
+		
+		return state;
+	}
+	
+	void EntityState::apply(Entity& e) const
+	{
+		if(Physical* phys = e.get<Physical>())
+		{
+			phys->position = {x / POSITION_SCALE, y / POSITION_SCALE};
+			phys->angle = angle / ANGLE_SCALE;
+			phys->zIndex = zIndex;
+			phys->size = {width, height};
+			phys->collides = collides;
+		}
+		
+		if(Movable* mov = e.get<Movable>())
+		{
+			mov->velocity = {velocityX / POSITION_SCALE, velocityY / POSITION_SCALE};
+			mov->moveVelocity = moveVelocity / POSITION_SCALE;
+		}
+	}
+	
+	unsigned EntityState::diff(const EntityState& base) const
+	{
+		unsigned fields = 0;
+		
+		auto field = [&fields](bool differs, unsigned f)
+		{
+			if(differs)
+				fields |= f;
+		};
+		
+		field(x != base.x, PositionX);
+		field(y != base.y, PositionY);
+		field(angle != base.angle, Angle);
+		field(zIndex != base.zIndex, ZIndex);
+		field(width != base.width, Width);
+		field(height != base.height, Height);
+		field(collides != base.collides, Collides);
+		field(velocityX != base.velocityX, VelocityX);
+		field(velocityY != base.velocityY, VelocityY);
+		field(moveVelocity != base.moveVelocity, MoveVelocity);
+		
+		return fields;
+	}
+	
+	void EntityState::writeDelta(const EntityState& base, unsigned fields, ByteWriter& out) const
+	{
+		out.writeUInt(fields);
+		
+		// as 64 bits, so the difference of two 32 bit values can't overflow
+		auto delta = [&](unsigned field, std::int64_t value, std::int64_t from)
+		{
+			if(fields & field)
+				out.writeInt(value - from);
+		};
+		
+		delta(PositionX, x, base.x);
+		delta(PositionY, y, base.y);
+		
+		// the shorter way around
+		if(fields & Angle)
+			out.writeInt(static_cast<std::int16_t>(static_cast<std::uint16_t>(angle - base.angle)));
+		
+		delta(ZIndex, zIndex, base.zIndex);
+		delta(Width, width, base.width);
+		delta(Height, height, base.height);
+		delta(VelocityX, velocityX, base.velocityX);
+		delta(VelocityY, velocityY, base.velocityY);
+		delta(MoveVelocity, moveVelocity, base.moveVelocity);
+	}
+	
+	bool EntityState::readDelta(const EntityState& base, ByteReader& in)
+	{
+		*this = base;
+		
+		std::uint64_t fields = in.readUInt();
+		
+		auto delta = [&](unsigned field, std::int64_t from) -> std::int64_t
+		{
+			return fields & field ? from + in.readInt() : from;
+		};
+		
+		x = static_cast<std::int32_t>(delta(PositionX, base.x));
+		y = static_cast<std::int32_t>(delta(PositionY, base.y));
+		
+		if(fields & Angle)
+			angle = static_cast<std::uint16_t>(base.angle + in.readInt());
+		
+		zIndex = static_cast<std::uint32_t>(delta(ZIndex, base.zIndex));
+		width = static_cast<std::uint32_t>(delta(Width, base.width));
+		height = static_cast<std::uint32_t>(delta(Height, base.height));
+		collides = fields & Collides ? !base.collides : base.collides;
+		velocityX = static_cast<std::int32_t>(delta(VelocityX, base.velocityX));
+		velocityY = static_cast<std::int32_t>(delta(VelocityY, base.velocityY));
+		moveVelocity = static_cast<std::int32_t>(delta(MoveVelocity, base.moveVelocity));
+		
+		return in.good();
+	}
+	
+	void StateHistory::add(unsigned tick, const EntityState& state, unsigned oldest)
+	{
+		states.emplace_back(tick, state);
+		
+		auto keep = states.begin();
+		
+		while(keep + 1 != states.end() && (keep + 1)->first <= oldest)
+			keep++;
+		
+		states.erase(states.begin(), keep);
+	}
+	
+	const EntityState* StateHistory::get(unsigned tick) const
+	{
+		const EntityState* state = nullptr;
+		
+		for(auto& s : states)
+		{
+			if(s.first > tick)
+				break;
+			
+			state = &s.second;
+		}
+		
+		return state;
+	}
+	
+	const EntityState& StateHistory::back() const
+	{
+		return states.back().second;
+	}
+}
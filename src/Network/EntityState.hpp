@@ -0,0 +1,81 @@
+#ifndef ENTITYSTATE_HPP
+#define ENTITYSTATE_HPP
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+#include "../EntitySystem/Entity.hpp"
+#include "../Serialization/ByteStream.hpp"
+
+namespace swift
+{
+	// the replicated fields of an entity's Physical and Movable, quantized. Two states are equal if a client
+	// couldn't tell them apart, so comparing them is how entities are found to have changed
+	struct EntityState
+	{
+		// bits of a delta's field mask
+		enum Field : unsigned
+		{
+			PositionX = 1 << 0,
+			PositionY = 1 << 1,
+			Angle = 1 << 2,
+			ZIndex = 1 << 3,
+			Width = 1 << 4,
+			Height = 1 << 5,
+			Collides = 1 << 6,
+			VelocityX = 1 << 7,
+			VelocityY = 1 << 8,
+			MoveVelocity = 1 << 9,
+		};
+		
+		static constexpr float POSITION_SCALE = 16;		// units per pixel, and per pixel per second for velocities
+		static constexpr float ANGLE_SCALE = 65536 / 360.f;
+		
+		// fields of components e lacks are 0
+		static EntityState capture(const Entity& e);
+		
+		// onto the components e has
+		void apply(Entity& e) const;
+		
+		// fields that differ from base
+		unsigned diff(const EntityState& base) const;
+		
+		// the fields as differences from base, small ones are a byte each. Collides is only its bit
+		void writeDelta(const EntityState& base, unsigned fields, ByteWriter& out) const;
+		
+		// this becomes base with what writeDelta wrote
+		bool readDelta(const EntityState& base, ByteReader& in);
+		
+		std::uint32_t components = 0;	// component mask, an entity whose components change is sent whole again
+		std::int32_t x = 0;
+		std::int32_t y = 0;
+		std::uint16_t angle = 0;
+		std::uint32_t zIndex = 0;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		bool collides = false;
+		std::int32_t velocityX = 0;
+		std::int32_t velocityY = 0;
+		std::int32_t moveVelocity = 0;
+	};
+	
+	// an entity's state at each tick it changed in, oldest first
+	class StateHistory
+	{
+		public:
+			// drops the states only needed for ticks before oldest, the newest at or before it is kept
+			void add(unsigned tick, const EntityState& state, unsigned oldest);
+			
+			// as of tick, nullptr if every state is newer
+			const EntityState* get(unsigned tick) const;
+			
+			// the newest, there has to be one
+			const EntityState& back() const;
+		
+		private:
+			std::vector<std::pair<unsigned, EntityState>> states;
+	};
+}
+
+#endif // ENTITYSTATE_HPP
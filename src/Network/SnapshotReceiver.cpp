@@ -0,0 +1,133 @@
+#include "SnapshotReceiver.hpp"
+
+#include "../World/World.hpp"
+
+#include <algorithm>
+
+namespace swift
+{
+	SnapshotReceiver::SnapshotReceiver(unsigned h)
+	:	history(std::max(h, 2u)),
+		tick(0)
+	{
+	}
+	
+	bool SnapshotReceiver::apply(World& world, ByteReader& in)
+	{
+		unsigned snapshot = static_cast<unsigned>(in.readUInt());
+		
+		if(!in.good())
+			return false;
+		
+		if(snapshot <= tick)
+			return true;
+		
+		unsigned oldest = snapshot > history ? snapshot - history + 1 : 0;
+		
+		// removed from the world, or out of the client's scope
+		std::uint64_t leaves = in.readUInt();
+		std::uint32_t handle = 0;
+		
+		for(std::uint64_t l = 0; l < leaves && in.good(); l++)
+		{
+			handle += static_cast<std::uint32_t>(in.readUInt());
+			
+			auto it = records.find(handle);
+			
+			if(it != records.end())
+			{
+				world.removeEntity(it->second.local);
+				records.erase(it);
+			}
+		}
+		
+		std::uint32_t count = in.readUInt32();
+		handle = 0;
+		
+		for(std::uint32_t e = 0; e < count && in.good(); e++)
+		{
+			handle += static_cast<std::uint32_t>(in.readUInt());
+			bool whole = in.readBool();
+			
+			auto it = records.find(handle);
+			Entity* entity = it != records.end() ? world.getEntity(it->second.local) : nullptr;
+			EntityState state;
+			
+			if(whole)
+			{
+				if(entity == nullptr)
+				{
+					entity = world.addEntity();
+					it = records.emplace(handle, Record()).first;
+					it->second.local = entity->getHandle();
+				}
+				
+				ComponentMask mask;
+				std::uint64_t components = in.readUInt();
+				
+				for(std::uint64_t c = 0; c < components && in.good(); c++)
+				{
+					unsigned type = static_cast<unsigned>(in.readUInt());
+					Component* component = type < MAX_COMPONENTS ? entity->get(type) : nullptr;
+					
+					if(component == nullptr && type < MAX_COMPONENTS && entity->add(ComponentRegistry::getName(type)))
+						component = entity->get(type);
+					
+					// components don't store their size, so one that can't be read ends the snapshot
+					if(component == nullptr || !component->read(in))
+						return false;
+					
+					mask.set(type);
+				}
+				
+				for(unsigned type = 0; type < MAX_COMPONENTS; type++)
+				{
+					if(entity->getMask().test(type) && !mask.test(type))
+						entity->remove(ComponentRegistry::getName(type));
+				}
+				
+				world.bindAssets(*entity);
+				
+				state.readDelta(EntityState(), in);
+				state.components = static_cast<std::uint32_t>(mask.to_ulong());
+			}
+			else
+			{
+				unsigned baseline = snapshot - static_cast<unsigned>(in.readUInt());
+				const EntityState* base = it != records.end() ? it->second.states.get(baseline) : nullptr;
+				
+				if(base == nullptr)
+					return false;
+				
+				state.readDelta(*base, in);
+			}
+			
+			it->second.states.add(snapshot, state, oldest);
+			
+			if(entity)
+			{
+				state.apply(*entity);
+				world.refit(*entity);
+			}
+		}
+		
+		if(!in.good())
+			return false;
+		
+		tick = snapshot;
+		
+		return true;
+	}
+	
+	unsigned SnapshotReceiver::getTick() const
+	{
+		return tick;
+	}
+	
+	EntityHandle SnapshotReceiver::getLocal(EntityHandle remote) const
+	{
+		auto it = records.find(remote.value);
+		
+		return it != records.end() ? it->second.local : EntityHandle();
+	}
+}
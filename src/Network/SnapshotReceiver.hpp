@@ -0,0 +1,45 @@
+#ifndef SNAPSHOTRECEIVER_HPP
+#define SNAPSHOTRECEIVER_HPP
+
+#include <unordered_map>
+#include <cstdint>
+
+#include "EntityState.hpp"
+
+namespace swift
+{
+	class World;
+	
+	// client side of world replication, applies what a SnapshotSender encoded to a local world.
+	// Replicated entities are local entities of their own, the remote ones are mapped to them
+	class SnapshotReceiver
+	{
+		public:
+			// has to be the sender's
+			explicit SnapshotReceiver(unsigned history = 64);
+			
+			// false if in is malformed, or a delta for an entity this doesn't have the baseline of.
+			// Snapshots older than the last applied one arrived out of order, and are skipped
+			bool apply(World& world, ByteReader& in);
+			
+			// the last applied, to acknowledge to the sender. 0 before the first
+			unsigned getTick() const;
+			
+			// the local entity replicating the sender's remote, a null handle if there's none
+			EntityHandle getLocal(EntityHandle remote) const;
+		
+		private:
+			struct Record
+			{
+				EntityHandle local;
+				StateHistory states;
+			};
+			
+			std::unordered_map<std::uint32_t, Record> records;	// by remote handle value
+			
+			unsigned history;
+			unsigned tick;
+	};
+}
+
+#endif // SNAPSHOTRECEIVER_HPP
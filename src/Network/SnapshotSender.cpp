@@ -0,0 +1,328 @@
+#include "SnapshotSender.hpp"
+
+#include "../World/World.hpp"
+#include "../Memory/FrameArena.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace swift
+{
+	SnapshotSender::SnapshotSender(unsigned h)
+	:	nextClient(0),
+		near(0.5f),
+		maxInterval(4),
+		history(std::max(h, 2u)),
+		tick(0),
+		changedCount(0)
+	{
+	}
+	
+	void SnapshotSender::capture(const World& world)
+	{
+		tick++;
+		changedCount = 0;
+		unplaced.clear();
+		
+		for(auto& e : world.getEntities())
+		{
+			EntityState state = EntityState::capture(*e);
+			std::uint32_t handle = e->getHandle().value;
+			
+			if(!e->has<Physical>())
+				unplaced.push_back(handle);
+			
+			auto result = records.emplace(handle, Record());
+			Record& record = result.first->second;
+			record.seen = tick;
+			
+			if(result.second || state.components != record.state.components)
+				record.entered = tick;
+			else if(state.diff(record.state) == 0)
+				continue;
+			
+			record.state = state;
+			record.changed = tick;
+			changedCount++;
+		}
+		
+		// removed from the world, they drop out of every scope
+		for(auto it = records.begin(); it != records.end();)
+		{
+			if(it->second.seen != tick)
+				it = records.erase(it);
+			else
+				it++;
+		}
+	}
+	
+	unsigned SnapshotSender::getTick() const
+	{
+		return tick;
+	}
+	
+	unsigned SnapshotSender::addClient()
+	{
+		clients.emplace(nextClient, Client());
+		return nextClient++;
+	}
+	
+	void SnapshotSender::removeClient(unsigned client)
+	{
+		clients.erase(client);
+	}
+	
+	void SnapshotSender::setInterest(unsigned client, const sf::Vector2f& center, float radius)
+	{
+		auto it = clients.find(client);
+		
+		if(it == clients.end())
+			return;
+		
+		it->second.interested = true;
+		it->second.center = center;
+		it->second.radius = std::max(radius, 0.f);
+	}
+	
+	void SnapshotSender::clearInterest(unsigned client)
+	{
+		auto it = clients.find(client);
+		
+		if(it != clients.end())
+			it->second.interested = false;
+	}
+	
+	void SnapshotSender::setRelevance(float n, unsigned m)
+	{
+		near = std::min(std::max(n, 0.f), 1.f);
+		maxInterval = std::max(m, 1u);
+	}
+	
+	void SnapshotSender::acknowledge(unsigned client, unsigned t)
+	{
+		auto it = clients.find(client);
+		
+		if(it == clients.end() || t <= it->second.acked || t > tick)
+			return;
+		
+		Client& c = it->second;
+		c.acked = t;
+		
+		// snapshots sent before it were lost or are superseded, what they had was sent again since
+		while(!c.sent.empty() && c.sent.front().tick < t)
+			c.sent.pop_front();
+		
+		if(c.sent.empty() || c.sent.front().tick != t)
+			return;
+		
+		for(auto& i : c.sent.front().entities)
+		{
+			auto s = c.scope.find(i.handle);
+			
+			if(s != c.scope.end() && s->second.joined <= t && s->second.ackedTick < t)
+			{
+				s->second.acked = i.state;
+				s->second.ackedTick = t;
+				s->second.entered = i.entered;
+			}
+		}
+		
+		for(auto& h : c.sent.front().leaves)
+			c.leaving.erase(std::remove(c.leaving.begin(), c.leaving.end(), h), c.leaving.end());
+		
+		c.sent.pop_front();
+	}
+	
+	bool SnapshotSender::encode(unsigned client, World& world, ByteWriter& out)
+	{
+		auto it = clients.find(client);
+		
+		if(it == clients.end())
+			return false;
+		
+		Client& c = it->second;
+		
+		FrameArena::Scope scope;
+		
+		// handle values in scope, with every how many ticks each is updated
+		FrameVector<std::pair<std::uint32_t, unsigned>> visible;
+		
+		if(c.interested)
+		{
+			world.queryRadius(c.center, c.radius, found);
+			
+			float nearRadius = near * c.radius;
+			float band = c.radius - nearRadius;
+			
+			visible.reserve(found.size() + unplaced.size());
+			
+			for(auto& e : found)
+			{
+				std::uint32_t handle = e->getHandle().value;
+				
+				// given a Physical since the capture
+				if(records.find(handle) == records.end())
+					continue;
+				
+				sf::Vector2f offset = e->get<Physical>()->position - c.center;
+				float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+				unsigned interval = 1;
+				
+				if(distance > nearRadius && band > 0)
+					interval += static_cast<unsigned>(std::min((distance - nearRadius) / band, 1.f) * (maxInterval - 1));
+				
+				visible.emplace_back(handle, interval);
+			}
+			
+			for(auto& h : unplaced)
+				visible.emplace_back(h, 1);
+		}
+		else
+		{
+			visible.reserve(records.size());
+			
+			for(auto& r : records)
+				visible.emplace_back(r.first, 1);
+		}
+		
+		// sorted, so handles are written as the difference from the one before
+		std::sort(visible.begin(), visible.end());
+		
+		for(auto& v : visible)
+		{
+			auto result = c.scope.emplace(v.first, Scoped());
+			
+			// left before, and back before the client acknowledged it leaving
+			if(result.second)
+			{
+				result.first->second.joined = tick;
+				c.leaving.erase(std::remove(c.leaving.begin(), c.leaving.end(), v.first), c.leaving.end());
+			}
+			
+			result.first->second.seen = tick;
+		}
+		
+		// what's still in scope from before but wasn't found, was removed or went out of range
+		for(auto s = c.scope.begin(); s != c.scope.end();)
+		{
+			if(s->second.seen != tick)
+			{
+				c.leaving.push_back(s->first);
+				s = c.scope.erase(s);
+			}
+			else
+				s++;
+		}
+		
+		Sent sent;
+		sent.tick = tick;
+		sent.leaves = c.leaving;
+		
+		std::sort(sent.leaves.begin(), sent.leaves.end());
+		
+		out.writeUInt(tick);
+		out.writeUInt(sent.leaves.size());
+		
+		std::uint32_t previous = 0;
+		
+		for(auto& h : sent.leaves)
+		{
+			out.writeUInt(h - previous);
+			previous = h;
+		}
+		
+		// the count is only known after skipping entities the client is up to date on, or that aren't due
+		std::size_t countAt = out.size();
+		out.writeUInt32(0);
+		
+		std::uint32_t count = 0;
+		previous = 0;
+		
+		for(auto& v : visible)
+		{
+			const Record& record = records.find(v.first)->second;
+			Scoped& scoped = c.scope.find(v.first)->second;
+			
+			bool whole = scoped.entered != record.entered;
+			
+			if(!whole)
+			{
+				// unchanged since what the client has, mostly only the ticks compared
+				if(record.changed <= scoped.ackedTick || record.state.diff(scoped.acked) == 0)
+					continue;
+				
+				if(tick - scoped.sent < v.second)
+					continue;
+				
+				// the client may not have kept a baseline that old
+				whole = tick - scoped.ackedTick >= history;
+			}
+			
+			EntityHandle handle;
+			handle.value = v.first;
+			const Entity* entity = world.getEntity(handle);
+			
+			// removed from the world since the capture, it leaves with the next one
+			if(entity == nullptr)
+				continue;
+			
+			out.writeUInt(v.first - previous);
+			previous = v.first;
+			count++;
+			
+			writeEntity(*entity, record.state, whole ? nullptr : &scoped.acked, scoped.ackedTick, tick, out);
+			
+			scoped.sent = tick;
+			sent.entities.push_back({v.first, record.state, record.entered});
+		}
+		
+		out.patchUInt32(countAt, count);
+		
+		c.sent.push_back(std::move(sent));
+		
+		if(c.sent.size() > history)
+			c.sent.pop_front();
+		
+		return true;
+	}
+	
+	std::size_t SnapshotSender::getChangedCount() const
+	{
+		return changedCount;
+	}
+	
+	std::size_t SnapshotSender::getScopeSize(unsigned client) const
+	{
+		auto it = clients.find(client);
+		
+		return it != clients.end() ? it->second.scope.size() : 0;
+	}
+	
+	void SnapshotSender::writeEntity(const Entity& entity, const EntityState& state, const EntityState* base, unsigned baseTick, unsigned tick, ByteWriter& out)
+	{
+		out.writeBool(base == nullptr);
+		
+		if(base)
+		{
+			// the tick of the baseline, as how long ago it was
+			out.writeUInt(tick - baseTick);
+			state.writeDelta(*base, state.diff(*base), out);
+			return;
+		}
+		
+		// whole, every component in its binary form, then the quantized fields over them
+		out.writeUInt(entity.getMask().count());
+		
+		for(unsigned id = 0; id < MAX_COMPONENTS; id++)
+		{
+			if(!entity.getMask().test(id))
+				continue;
+			
+			out.writeUInt(id);
+			entity.get(id)->write(out);
+		}
+		
+		EntityState zero;
+		state.writeDelta(zero, state.diff(zero), out);
+	}
+}
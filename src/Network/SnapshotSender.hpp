@@ -0,0 +1,127 @@
+#ifndef SNAPSHOTSENDER_HPP
+#define SNAPSHOTSENDER_HPP
+
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+#include "EntityState.hpp"
+
+namespace swift
+{
+	class World;
+	class Entity;
+	
+	// server side of world replication. Each tick, capture finds which entities changed, by their quantized state,
+	// and encode writes a client what changed of the entities in its scope, as deltas against what it acknowledged.
+	// Nothing here draws, so it runs the same on a headless server. The bytes are for whatever transport the game
+	// uses, a SnapshotReceiver applies them
+	class SnapshotSender
+	{
+		public:
+			// ticks kept to delta against. An entity a client last acknowledged longer ago is sent whole
+			explicit SnapshotSender(unsigned history = 64);
+			
+			// the world's entities as the next tick, once per server tick, before encoding
+			void capture(const World& world);
+			
+			// the last captured, 0 before the first capture
+			unsigned getTick() const;
+			
+			unsigned addClient();
+			void removeClient(unsigned client);
+			
+			// the client's scope becomes the entities within radius of center, found through the world's broadphase, and
+			// the ones without a Physical. Entities entering it are sent whole, leaving it the client removes them.
+			// Clients without an area have every entity in scope
+			void setInterest(unsigned client, const sf::Vector2f& center, float radius);
+			void clearInterest(unsigned client);
+			
+			// entities further than near times the radius from a client's center are sent less often, down to
+			// every maxInterval ticks at the edge. Entering, leaving, and whole entities always go out right away
+			void setRelevance(float near, unsigned maxInterval);
+			
+			// the newest tick the client has applied. Older acks than the client's last are ignored, they came out of order
+			void acknowledge(unsigned client, unsigned tick);
+			
+			// the current tick for the client, out is appended to. False for unknown clients
+			bool encode(unsigned client, World& world, ByteWriter& out);
+			
+			// entities changed or entered in the last capture
+			std::size_t getChangedCount() const;
+			
+			// entities the client has in scope, 0 for unknown clients
+			std::size_t getScopeSize(unsigned client) const;
+		
+		private:
+			struct Record
+			{
+				EntityState state;
+				unsigned changed;	// last tick state changed in
+				unsigned entered;	// tick it was created, or its components last changed, it's then sent whole
+				unsigned seen;		// last tick it was captured in
+			};
+			
+			// an entity in a client's scope
+			struct Scoped
+			{
+				EntityState acked;		// what the client has, deltas are against it
+				unsigned ackedTick;		// of the snapshot acked was in
+				unsigned entered;		// the record's entered, as of acked. 0 until the client has it whole
+				unsigned sent;			// last tick it was sent
+				unsigned seen;			// last tick it was found in scope
+				unsigned joined;		// tick it came into scope, acks of snapshots before are from when it last was
+			};
+			
+			// what went out in one snapshot, to become the client's baselines once acknowledged
+			struct Sent
+			{
+				struct Item
+				{
+					std::uint32_t handle;
+					EntityState state;
+					unsigned entered;
+				};
+				
+				unsigned tick;
+				std::vector<Item> entities;
+				std::vector<std::uint32_t> leaves;
+			};
+			
+			struct Client
+			{
+				unsigned acked = 0;
+				
+				bool interested = false;
+				sf::Vector2f center;
+				float radius = 0;
+				
+				std::unordered_map<std::uint32_t, Scoped> scope;	// by handle value
+				std::vector<std::uint32_t> leaving;					// sent until acknowledged
+				std::deque<Sent> sent;								// not yet acknowledged, oldest first
+			};
+			
+			// a delta against base, or whole if there's none
+			static void writeEntity(const Entity& entity, const EntityState& state, const EntityState* base, unsigned baseTick, unsigned tick, ByteWriter& out);
+			
+			std::unordered_map<std::uint32_t, Record> records;	// by handle value
+			std::vector<std::uint32_t> unplaced;				// entities without a Physical, in every scope
+			
+			std::unordered_map<unsigned, Client> clients;
+			unsigned nextClient;
+			
+			std::vector<Entity*> found;	// kept for its capacity
+			
+			float near;
+			unsigned maxInterval;
+			
+			unsigned history;
+			unsigned tick;
+			std::size_t changedCount;
+	};
+}
+
+#endif // SNAPSHOTSENDER_HPP
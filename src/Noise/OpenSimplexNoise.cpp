@@ -1,10 +1,156 @@
 #include "OpenSimplexNoise.hpp"
 
+#include "../SystemInfo/CpuInfo.hpp"
+
+#include <algorithm>
+
+#ifdef SWIFT_AVX2_KERNELS
+	#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define SWIFT_NOISE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define SWIFT_NOISE_NEON
+#endif
+
+namespace
+{
+	// one point at a time, for what's left after the wide lanes, and for builds without them
+	struct Lanes1
+	{
+		static const std::size_t Size = 1;
+		typedef bool Mask;
+		
+		float v;
+		
+		static Lanes1 load(const float* p) { return {*p}; }
+		static Lanes1 set(float f) { return {f}; }
+		void store(float* p) const { *p = v; }
+		void toInts(int* p) const { *p = static_cast<int>(v); }
+		
+		static Lanes1 floor(Lanes1 a) { return {std::floor(a.v)}; }
+		static Lanes1 max(Lanes1 a, Lanes1 b) { return {std::max(a.v, b.v)}; }
+		
+		static Mask greater(Lanes1 a, Lanes1 b) { return a.v > b.v; }
+		static Mask either(Mask a, Mask b) { return a || b; }
+		static Lanes1 select(Mask m, Lanes1 a, Lanes1 b) { return m ? a : b; }
+		
+		Lanes1 operator+(Lanes1 b) const { return {v + b.v}; }
+		Lanes1 operator-(Lanes1 b) const { return {v - b.v}; }
+		Lanes1 operator*(Lanes1 b) const { return {v * b.v}; }
+	};
+	
+#if defined(SWIFT_NOISE_SSE)
+	struct Lanes4
+	{
+		static const std::size_t Size = 4;
+		typedef __m128 Mask;
+		
+		__m128 v;
+		
+		static Lanes4 load(const float* p) { return {_mm_loadu_ps(p)}; }
+		static Lanes4 set(float f) { return {_mm_set1_ps(f)}; }
+		void store(float* p) const { _mm_storeu_ps(p, v); }
+		void toInts(int* p) const { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_cvttps_epi32(v)); }
+		
+		// truncates, then takes 1 off where that rounded up
+		static Lanes4 floor(Lanes4 a)
+		{
+			__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+			return {_mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1)))};
+		}
+		
+		static Lanes4 max(Lanes4 a, Lanes4 b) { return {_mm_max_ps(a.v, b.v)}; }
+		
+		static Mask greater(Lanes4 a, Lanes4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+		static Mask either(Mask a, Mask b) { return _mm_or_ps(a, b); }
+		static Lanes4 select(Mask m, Lanes4 a, Lanes4 b) { return {_mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v))}; }
+		
+		Lanes4 operator+(Lanes4 b) const { return {_mm_add_ps(v, b.v)}; }
+		Lanes4 operator-(Lanes4 b) const { return {_mm_sub_ps(v, b.v)}; }
+		Lanes4 operator*(Lanes4 b) const { return {_mm_mul_ps(v, b.v)}; }
+	};
+#elif defined(SWIFT_NOISE_NEON)
+	struct Lanes4
+	{
+		static const std::size_t Size = 4;
+		typedef uint32x4_t Mask;
+		
+		float32x4_t v;
+		
+		static Lanes4 load(const float* p) { return {vld1q_f32(p)}; }
+		static Lanes4 set(float f) { return {vdupq_n_f32(f)}; }
+		void store(float* p) const { vst1q_f32(p, v); }
+		void toInts(int* p) const { vst1q_s32(p, vcvtq_s32_f32(v)); }
+		
+		// truncates, then takes 1 off where that rounded up
+		static Lanes4 floor(Lanes4 a)
+		{
+			float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(a.v));
+			return {vsubq_f32(t, vbslq_f32(vcgtq_f32(t, a.v), vdupq_n_f32(1), vdupq_n_f32(0)))};
+		}
+		
+		static Lanes4 max(Lanes4 a, Lanes4 b) { return {vmaxq_f32(a.v, b.v)}; }
+		
+		static Mask greater(Lanes4 a, Lanes4 b) { return vcgtq_f32(a.v, b.v); }
+		static Mask either(Mask a, Mask b) { return vorrq_u32(a, b); }
+		static Lanes4 select(Mask m, Lanes4 a, Lanes4 b) { return {vbslq_f32(m, a.v, b.v)}; }
+		
+		Lanes4 operator+(Lanes4 b) const { return {vaddq_f32(v, b.v)}; }
+		Lanes4 operator-(Lanes4 b) const { return {vsubq_f32(v, b.v)}; }
+		Lanes4 operator*(Lanes4 b) const { return {vmulq_f32(v, b.v)}; }
+	};
+#endif
+	
+#ifdef SWIFT_AVX2_KERNELS
+	// the same steps as Lanes4, so every level gives the same bits
+	SWIFT_TARGET_AVX2 __m256 floorAVX2(__m256 a)
+	{
+		__m256 t = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a));
+		return _mm256_sub_ps(t, _mm256_and_ps(_mm256_cmp_ps(t, a, _CMP_GT_OQ), _mm256_set1_ps(1)));
+	}
+	
+	SWIFT_TARGET_AVX2 __m256 selectAVX2(__m256 m, __m256 a, __m256 b)
+	{
+		return _mm256_blendv_ps(b, a, m);
+	}
+	
+	// the 8 gradients fit in a register each, so they're picked with a permute instead of loaded
+	SWIFT_TARGET_AVX2 __m256 contributeAVX2(const int* perm, __m256 gradX, __m256 gradY, __m256 xv, __m256 yv, __m256 dx, __m256 dy)
+	{
+		const __m256i mask = _mm256_set1_epi32(0xFF);
+		
+		__m256 attn = _mm256_max_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(2), _mm256_mul_ps(dx, dx)), _mm256_mul_ps(dy, dy)), _mm256_setzero_ps());
+		attn = _mm256_mul_ps(attn, attn);
+		
+		__m256i xsb = _mm256_cvttps_epi32(xv);
+		__m256i ysb = _mm256_cvttps_epi32(yv);
+		
+		__m256i index = _mm256_i32gather_epi32(perm, _mm256_and_si256(xsb, mask), 4);
+		index = _mm256_i32gather_epi32(perm, _mm256_and_si256(_mm256_add_epi32(index, ysb), mask), 4);
+		index = _mm256_srli_epi32(_mm256_and_si256(index, _mm256_set1_epi32(0x0E)), 1);
+		
+		__m256 gx = _mm256_permutevar8x32_ps(gradX, index);
+		__m256 gy = _mm256_permutevar8x32_ps(gradY, index);
+		
+		return _mm256_mul_ps(_mm256_mul_ps(attn, attn), _mm256_add_ps(_mm256_mul_ps(gx, dx), _mm256_mul_ps(gy, dy)));
+	}
+#endif
+	
+	// points per run of a grid row, kept on the stack
+	const unsigned RunLength = 64;
+}
+
 namespace swift
 {
 	constexpr std::array<char, 16> OpenSimplexNoise::gradients2D;
 	constexpr std::array<char, 72> OpenSimplexNoise::gradients3D;
 	constexpr std::array<char, 16 * 16> OpenSimplexNoise::gradients4D;
+	
+	ThreadPool* OpenSimplexNoise::threadPool = nullptr;
 
 	OpenSimplexNoise::OpenSimplexNoise(unsigned long int seed)
 	{
@@ -36,7 +182,7 @@ namespace swift
 		}
 	}
 	
-	double OpenSimplexNoise::evaluate(double x, double y)
+	double OpenSimplexNoise::evaluate(double x, double y) const
 	{
 		// place coordinates onto grid
 		double stretchOffset = (x + y) * STRETCH_2D;
@@ -120,7 +266,7 @@ namespace swift
 				xsv_ext = xsb + 1;
 				ysv_ext = ysb + 1;
 				dx_ext = dx0 - 1 - 2 * SQUISH_2D;
-				dy_ext + dy0 - 1 - 2 * SQUISH_2D;
+				dy_ext = dy0 - 1 - 2 * SQUISH_2D;
 			}
 		}
 		else	// we're inside the triangle (2-Simplex) at (1, 1)
@@ -178,29 +324,294 @@ namespace swift
 		return value / NORM_2D;
 	}
 	
-	double OpenSimplexNoise::evaluate(double x, double y, double z)
+	double OpenSimplexNoise::evaluate(double x, double y, double z) const
+	{
+		
+	}
+	
+	double OpenSimplexNoise::evaluate(double x, double y, double z, double t) const
 	{
 		
 	}
 	
-	double OpenSimplexNoise::evaluate(double x, double y, double z, double t)
+	void OpenSimplexNoise::evaluate(const float* x, const float* y, float* out, std::size_t count) const
 	{
+		std::size_t i = 0;
+		SimdLevel level = getSimdLevel();
+		
+#ifdef SWIFT_AVX2_KERNELS
+		if(level == SimdLevel::Avx2)
+		{
+			for(; i + 8 <= count; i += 8)
+				evaluateAVX2(x + i, y + i, out + i);
+		}
+#endif
+		
+#if defined(SWIFT_NOISE_SSE) || defined(SWIFT_NOISE_NEON)
+		for(; level >= SimdLevel::Wide4 && i + Lanes4::Size <= count; i += Lanes4::Size)
+			evaluateLanes<Lanes4>(x + i, y + i, out + i);
+#endif
 		
+		for(; i < count; i++)
+			evaluateLanes<Lanes1>(x + i, y + i, out + i);
+	}
+	
+	void OpenSimplexNoise::evaluateGrid(float* out, unsigned width, unsigned height, float x, float y, float step) const
+	{
+		evaluateOctaves(out, width, height, x, y, step, 1);
+	}
+	
+	void OpenSimplexNoise::evaluateOctaves(float* out, unsigned width, unsigned height, float x, float y, float step,
+											unsigned octaves, float lacunarity, float gain) const
+	{
+		if(width == 0 || height == 0 || octaves == 0)
+			return;
+		
+		if(threadPool)
+		{
+			threadPool->parallelFor(height, [&](std::size_t begin, std::size_t end)
+			{
+				evaluateRows(out, width, static_cast<unsigned>(begin), static_cast<unsigned>(end), x, y, step, octaves, lacunarity, gain);
+			});
+		}
+		else
+		{
+			evaluateRows(out, width, 0, height, x, y, step, octaves, lacunarity, gain);
+		}
 	}
 	
-	double OpenSimplexNoise::extrapolate(int xsb, int ysb, double dx, double dy)
+	void OpenSimplexNoise::setThreadPool(ThreadPool& tp)
+	{
+		threadPool = &tp;
+	}
+	
+	double OpenSimplexNoise::extrapolate(int xsb, int ysb, double dx, double dy) const
 	{
 		int index = perm[(perm[xsb & 0xFF] + ysb) & 0xFF] & 0x0E;
 		return gradients2D[index] * dx + gradients2D[index + 1] * dy;
 	}
 	
-	double OpenSimplexNoise::extrapolate(int xsb, int ysb, int zsb, double dx, double dy, double dz)
+	double OpenSimplexNoise::extrapolate(int xsb, int ysb, int zsb, double dx, double dy, double dz) const
 	{
 		
 	}
 	
-	double OpenSimplexNoise::extrapolate(int xsb, int ysb, int zsb, int tsb, double dx, double dy, double dz, double dt)
+	double OpenSimplexNoise::extrapolate(int xsb, int ysb, int zsb, int tsb, double dx, double dy, double dz, double dt) const
+	{
+		
+	}
+	
+	template<typename V>
+	void OpenSimplexNoise::evaluateLanes(const float* x, const float* y, float* out) const
+	{
+		const V zero = V::set(0);
+		const V one = V::set(1);
+		const V two = V::set(2);
+		const V squish = V::set(static_cast<float>(SQUISH_2D));
+		const V squish2 = V::set(static_cast<float>(2 * SQUISH_2D));
+		
+		V xv = V::load(x);
+		V yv = V::load(y);
+		
+		// as evaluate(x, y), each branch made into a select between both sides
+		V stretchOffset = (xv + yv) * V::set(static_cast<float>(STRETCH_2D));
+		V xs = xv + stretchOffset;
+		V ys = yv + stretchOffset;
+		
+		V xsb = V::floor(xs);
+		V ysb = V::floor(ys);
+		
+		V squishOffset = (xsb + ysb) * squish;
+		V dx0 = xv - (xsb + squishOffset);
+		V dy0 = yv - (ysb + squishOffset);
+		
+		V xins = xs - xsb;
+		V yins = ys - ysb;
+		V inSum = xins + yins;
+		
+		// contributions (1, 0) and (0, 1)
+		V value = contribute(xsb + one, ysb, dx0 - one - squish, dy0 - squish);
+		value = value + contribute(xsb, ysb + one, dx0 - squish, dy0 - one - squish);
+		
+		typename V::Mask upper = V::greater(inSum, one);
+		typename V::Mask xBigger = V::greater(xins, yins);
+		
+		// the extra vertex, as an offset from (xsb, ysb)
+		V lowerZins = one - inSum;
+		typename V::Mask lowerNear = V::either(V::greater(lowerZins, xins), V::greater(lowerZins, yins));
+		
+		V lowerX = V::select(lowerNear, V::select(xBigger, one, zero - one), one);
+		V lowerY = V::select(lowerNear, V::select(xBigger, zero - one, one), one);
+		V lowerSquish = V::select(lowerNear, zero, squish2);
+		
+		V upperZins = two - inSum;
+		typename V::Mask upperNear = V::either(V::greater(xins, upperZins), V::greater(yins, upperZins));
+		
+		V upperX = V::select(upperNear, V::select(xBigger, two, zero), zero);
+		V upperY = V::select(upperNear, V::select(xBigger, zero, two), zero);
+		V upperSquish = V::select(upperNear, squish2, zero);
+		
+		V extX = V::select(upper, upperX, lowerX);
+		V extY = V::select(upper, upperY, lowerY);
+		V extSquish = V::select(upper, upperSquish, lowerSquish);
+		
+		value = value + contribute(xsb + extX, ysb + extY, dx0 - extX - extSquish, dy0 - extY - extSquish);
+		
+		// contribution (0, 0) or (1, 1)
+		V corner = V::select(upper, one, zero);
+		V cornerSquish = V::select(upper, squish2, zero);
+		
+		value = value + contribute(xsb + corner, ysb + corner, dx0 - corner - cornerSquish, dy0 - corner - cornerSquish);
+		
+		(value * V::set(static_cast<float>(1 / NORM_2D))).store(out);
+	}
+	
+	template<typename V>
+	V OpenSimplexNoise::contribute(V xv, V yv, V dx, V dy) const
 	{
+		V attn = V::max(V::set(2) - dx * dx - dy * dy, V::set(0));
+		attn = attn * attn;
 		
+		int xsb[V::Size];
+		int ysb[V::Size];
+		xv.toInts(xsb);
+		yv.toInts(ysb);
+		
+		// gradients are looked up a lane at a time, there's no gather before AVX2
+		float gx[V::Size];
+		float gy[V::Size];
+		
+		for(std::size_t l = 0; l < V::Size; l++)
+		{
+			int index = perm[(perm[xsb[l] & 0xFF] + ysb[l]) & 0xFF] & 0x0E;
+			gx[l] = gradients2D[index];
+			gy[l] = gradients2D[index + 1];
+		}
+		
+		return attn * attn * (V::load(gx) * dx + V::load(gy) * dy);
+	}
+	
+#ifdef SWIFT_AVX2_KERNELS
+	SWIFT_TARGET_AVX2 void OpenSimplexNoise::evaluateAVX2(const float* x, const float* y, float* out) const
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1);
+		const __m256 two = _mm256_set1_ps(2);
+		const __m256 minusOne = _mm256_sub_ps(zero, one);
+		const __m256 squish = _mm256_set1_ps(static_cast<float>(SQUISH_2D));
+		const __m256 squish2 = _mm256_set1_ps(static_cast<float>(2 * SQUISH_2D));
+		
+		const __m256 gradX = _mm256_setr_ps(gradients2D[0], gradients2D[2], gradients2D[4], gradients2D[6],
+											gradients2D[8], gradients2D[10], gradients2D[12], gradients2D[14]);
+		const __m256 gradY = _mm256_setr_ps(gradients2D[1], gradients2D[3], gradients2D[5], gradients2D[7],
+											gradients2D[9], gradients2D[11], gradients2D[13], gradients2D[15]);
+		
+		__m256 xv = _mm256_loadu_ps(x);
+		__m256 yv = _mm256_loadu_ps(y);
+		
+		// step for step evaluateLanes, in the same order so the results match it
+		__m256 stretchOffset = _mm256_mul_ps(_mm256_add_ps(xv, yv), _mm256_set1_ps(static_cast<float>(STRETCH_2D)));
+		__m256 xs = _mm256_add_ps(xv, stretchOffset);
+		__m256 ys = _mm256_add_ps(yv, stretchOffset);
+		
+		__m256 xsb = floorAVX2(xs);
+		__m256 ysb = floorAVX2(ys);
+		
+		__m256 squishOffset = _mm256_mul_ps(_mm256_add_ps(xsb, ysb), squish);
+		__m256 dx0 = _mm256_sub_ps(xv, _mm256_add_ps(xsb, squishOffset));
+		__m256 dy0 = _mm256_sub_ps(yv, _mm256_add_ps(ysb, squishOffset));
+		
+		__m256 xins = _mm256_sub_ps(xs, xsb);
+		__m256 yins = _mm256_sub_ps(ys, ysb);
+		__m256 inSum = _mm256_add_ps(xins, yins);
+		
+		const int* p = perm.data();
+		
+		__m256 value = contributeAVX2(p, gradX, gradY, _mm256_add_ps(xsb, one), ysb,
+										_mm256_sub_ps(_mm256_sub_ps(dx0, one), squish), _mm256_sub_ps(dy0, squish));
+		value = _mm256_add_ps(value, contributeAVX2(p, gradX, gradY, xsb, _mm256_add_ps(ysb, one),
+										_mm256_sub_ps(dx0, squish), _mm256_sub_ps(_mm256_sub_ps(dy0, one), squish)));
+		
+		__m256 upper = _mm256_cmp_ps(inSum, one, _CMP_GT_OQ);
+		__m256 xBigger = _mm256_cmp_ps(xins, yins, _CMP_GT_OQ);
+		
+		__m256 lowerZins = _mm256_sub_ps(one, inSum);
+		__m256 lowerNear = _mm256_or_ps(_mm256_cmp_ps(lowerZins, xins, _CMP_GT_OQ), _mm256_cmp_ps(lowerZins, yins, _CMP_GT_OQ));
+		
+		__m256 lowerX = selectAVX2(lowerNear, selectAVX2(xBigger, one, minusOne), one);
+		__m256 lowerY = selectAVX2(lowerNear, selectAVX2(xBigger, minusOne, one), one);
+		__m256 lowerSquish = selectAVX2(lowerNear, zero, squish2);
+		
+		__m256 upperZins = _mm256_sub_ps(two, inSum);
+		__m256 upperNear = _mm256_or_ps(_mm256_cmp_ps(xins, upperZins, _CMP_GT_OQ), _mm256_cmp_ps(yins, upperZins, _CMP_GT_OQ));
+		
+		__m256 upperX = selectAVX2(upperNear, selectAVX2(xBigger, two, zero), zero);
+		__m256 upperY = selectAVX2(upperNear, selectAVX2(xBigger, zero, two), zero);
+		__m256 upperSquish = selectAVX2(upperNear, squish2, zero);
+		
+		__m256 extX = selectAVX2(upper, upperX, lowerX);
+		__m256 extY = selectAVX2(upper, upperY, lowerY);
+		__m256 extSquish = selectAVX2(upper, upperSquish, lowerSquish);
+		
+		value = _mm256_add_ps(value, contributeAVX2(p, gradX, gradY, _mm256_add_ps(xsb, extX), _mm256_add_ps(ysb, extY),
+										_mm256_sub_ps(_mm256_sub_ps(dx0, extX), extSquish), _mm256_sub_ps(_mm256_sub_ps(dy0, extY), extSquish)));
+		
+		__m256 corner = selectAVX2(upper, one, zero);
+		__m256 cornerSquish = selectAVX2(upper, squish2, zero);
+		
+		value = _mm256_add_ps(value, contributeAVX2(p, gradX, gradY, _mm256_add_ps(xsb, corner), _mm256_add_ps(ysb, corner),
+										_mm256_sub_ps(_mm256_sub_ps(dx0, corner), cornerSquish), _mm256_sub_ps(_mm256_sub_ps(dy0, corner), cornerSquish)));
+		
+		_mm256_storeu_ps(out, _mm256_mul_ps(value, _mm256_set1_ps(static_cast<float>(1 / NORM_2D))));
+	}
+#endif
+	
+	void OpenSimplexNoise::evaluateRows(float* out, unsigned width, unsigned begin, unsigned end, float x, float y, float step,
+										unsigned octaves, float lacunarity, float gain) const
+	{
+		float xs[RunLength];
+		float ys[RunLength];
+		float values[RunLength];
+		
+		float total = 0;
+		float amplitude = 1;
+		
+		for(unsigned o = 0; o < octaves; o++)
+		{
+			total += amplitude;
+			amplitude *= gain;
+		}
+		
+		for(unsigned row = begin; row < end; row++)
+		{
+			float* outRow = out + static_cast<std::size_t>(row) * width;
+			
+			for(unsigned start = 0; start < width; start += RunLength)
+			{
+				unsigned count = std::min(RunLength, width - start);
+				
+				std::fill(outRow + start, outRow + start + count, 0.f);
+				
+				float frequency = 1;
+				amplitude = 1 / total;
+				
+				for(unsigned o = 0; o < octaves; o++)
+				{
+					for(unsigned i = 0; i < count; i++)
+					{
+						xs[i] = (x + (start + i) * step) * frequency;
+						ys[i] = (y + row * step) * frequency;
+					}
+					
+					evaluate(xs, ys, values, count);
+					
+					for(unsigned i = 0; i < count; i++)
+						outRow[start + i] += values[i] * amplitude;
+					
+					frequency *= lacunarity;
+					amplitude *= gain;
+				}
+			}
+		}
 	}
 }
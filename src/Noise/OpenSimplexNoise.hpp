@@ -3,8 +3,10 @@
 
 #include <cmath>
 #include <array>
+#include <cstddef>
 
 #include "../Math/Math.hpp"
+#include "../Threading/ThreadPool.hpp"
 
 namespace swift
 {
@@ -13,14 +15,43 @@ namespace swift
 		public:
 			OpenSimplexNoise(unsigned long int seed);
 
-			double evaluate(double x, double y);
-			double evaluate(double x, double y, double z);
-			double evaluate(double x, double y, double z, double t);
+			double evaluate(double x, double y) const;
+			double evaluate(double x, double y, double z) const;
+			double evaluate(double x, double y, double z, double t) const;
+
+			// 2D noise of many points in one call, in float precision, 8 at a time with AVX2 or 4 with SSE2 or NEON, as the CPU has.
+			// out[i] is the noise at (x[i], y[i])
+			void evaluate(const float* x, const float* y, float* out, std::size_t count) const;
+
+			// out[row * width + column] is the noise at (x + column * step, y + row * step).
+			// Rows are split across the thread pool, if there is one
+			void evaluateGrid(float* out, unsigned width, unsigned height, float x, float y, float step) const;
+
+			// fBm: octaves of the grid summed, each at lacunarity times the frequency and gain times the amplitude
+			// of the one before. Divided by the total amplitude, so it has the range of a single octave
+			void evaluateOctaves(float* out, unsigned width, unsigned height, float x, float y, float step,
+									unsigned octaves, float lacunarity = 2, float gain = 0.5f) const;
+
+			static void setThreadPool(ThreadPool& tp);
 
 		private:
-			double extrapolate(int xsb, int ysb, double dx, double dy);
-			double extrapolate(int xsb, int ysb, int zsb, double dx, double dy, double dz);
-			double extrapolate(int xsb, int ysb, int zsb, int tsb, double dx, double dy, double dz, double dt);
+			double extrapolate(int xsb, int ysb, double dx, double dy) const;
+			double extrapolate(int xsb, int ysb, int zsb, double dx, double dy, double dz) const;
+			double extrapolate(int xsb, int ysb, int zsb, int tsb, double dx, double dy, double dz, double dt) const;
+
+			// V::Size points from x and y into out, the same math whatever the width of V
+			template<typename V>
+			void evaluateLanes(const float* x, const float* y, float* out) const;
+
+			template<typename V>
+			V contribute(V xv, V yv, V dx, V dy) const;
+
+			// evaluateLanes for 8 points with AVX2, gathering the permutations. Only built for x86, and only
+			// called once getSimdLevel() has found AVX2
+			void evaluateAVX2(const float* x, const float* y, float* out) const;
+
+			void evaluateRows(float* out, unsigned width, unsigned begin, unsigned end, float x, float y, float step,
+								unsigned octaves, float lacunarity, float gain) const;
 
 			std::array<int, 256> perm;
 			std::array<int, 256> permGradIndex3D;
@@ -85,6 +116,8 @@ namespace swift
 				3, -1, -1, -1,      1, -3, -1, -1,      1, -1, -3, -1,      1, -1, -1, -3,
 				-3, -1, -1, -1,     -1, -3, -1, -1,     -1, -1, -3, -1,     -1, -1, -1, -3,
 			};
+
+			static ThreadPool* threadPool;
 	};
 }
 
@@ -0,0 +1,44 @@
+#ifndef PARTICLEEMITTER_HPP
+#define PARTICLEEMITTER_HPP
+
+#include <cstddef>
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Texture.hpp>
+
+namespace swift
+{
+	// how an emitter's particles are spawned, move, and look, see ParticleSystem. Particles go from the start size and
+	// color to the end ones over their life
+	struct ParticleEmitter
+	{
+		const sf::Texture* texture = nullptr;	// nullptr for plain squares
+		sf::IntRect region;						// of the texture, all of it if it's empty
+		
+		float rate = 20;			// particles a second
+		unsigned burst = 0;			// spawned at once when the emitter is made
+		float duration = 0;			// seconds it spawns for, 0 for until it's stopped
+		std::size_t max = 1000;		// of its particles alive at once
+		
+		float lifeMin = 1;			// seconds
+		float lifeMax = 1;
+		float speedMin = 20;		// pixels a second
+		float speedMax = 40;
+		float direction = -90;		// degrees, 0 is right and 90 down
+		float spread = 360;			// degrees around direction particles go in
+		
+		sf::Vector2f acceleration;	// pixels a second squared, gravity
+		float drag = 0;				// of its velocity a particle loses a second
+		
+		float sizeStart = 4;		// pixels
+		float sizeEnd = 4;
+		sf::Color colorStart = sf::Color::White;
+		sf::Color colorEnd = sf::Color::Transparent;
+		
+		sf::Vector2f offset;		// of the spawn point, from the emitter's position or its entity's center
+	};
+}
+
+#endif // PARTICLEEMITTER_HPP
@@ -0,0 +1,464 @@
+#include "ParticleSystem.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../EntitySystem/SystemScheduler.hpp"
+#include "../Math/Math.hpp"
+#include "../Profiling/Profiler.hpp"
+
+namespace swift
+{
+	namespace
+	{
+		// particles of one job. Small enough that a few big emitters still spread over every thread
+		const std::size_t chunkSize = 4096;
+	}
+	
+	ParticleSystem::ParticleSystem()
+	:	nextId(1),
+		limit(100000),
+		total(0),
+		lastDt(0),
+		batchCount(0),
+		drawn(0)
+	{
+	}
+	
+	void ParticleSystem::define(const std::string& name, const ParticleEmitter& settings, const AssetHandle<sf::Texture>& texture)
+	{
+		definitions[name] = settings;
+		
+		if(texture)
+			textures.push_back(texture);
+	}
+	
+	ParticleEmitter* ParticleSystem::getDefinition(const std::string& name)
+	{
+		auto it = definitions.find(name);
+		return it != definitions.end() ? &it->second : nullptr;
+	}
+	
+	unsigned ParticleSystem::emit(const std::string& name, const sf::Vector2f& position)
+	{
+		return add(name, position, {});
+	}
+	
+	unsigned ParticleSystem::attach(const std::string& name, EntityHandle entity)
+	{
+		// placed on its entity by the next update, before anything spawns
+		return add(name, {0, 0}, entity);
+	}
+	
+	void ParticleSystem::setPosition(unsigned id, const sf::Vector2f& position)
+	{
+		if(Emitter* em = find(id))
+			em->position = position;
+	}
+	
+	void ParticleSystem::burst(unsigned id, unsigned count)
+	{
+		if(Emitter* em = find(id))
+			em->bursting += count;
+	}
+	
+	void ParticleSystem::stop(unsigned id)
+	{
+		if(Emitter* em = find(id))
+			em->stopped = true;
+	}
+	
+	void ParticleSystem::remove(unsigned id)
+	{
+		auto it = std::find_if(emitters.begin(), emitters.end(), [id](const std::unique_ptr<Emitter>& em)
+		{
+			return em->id == id;
+		});
+		
+		if(it == emitters.end())
+			return;
+		
+		total -= (*it)->particles.count;
+		emitters.erase(it);
+	}
+	
+	void ParticleSystem::clear()
+	{
+		emitters.clear();
+		total = 0;
+		batchCount = 0;
+		drawn = 0;
+	}
+	
+	void ParticleSystem::update(float dt, const Locate& locate)
+	{
+		SWIFT_PROFILE("ParticleSystem::update");
+		
+		lastDt = dt;
+		
+		for(auto& em : emitters)
+		{
+			if(em->entity.isNull() || em->stopped)
+				continue;
+			
+			sf::Vector2f center;
+			
+			if(locate && locate(em->entity, center))
+				em->position = center;
+			else
+				em->stopped = true;
+		}
+		
+		chunks.clear();
+		
+		for(auto& em : emitters)
+		{
+			for(std::size_t b = 0; b < em->particles.count; b += chunkSize)
+				chunks.push_back({em.get(), b, std::min(b + chunkSize, em->particles.count), 0, 0});
+		}
+		
+		SystemScheduler::parallelFor(chunks.size(), [this, dt](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t i = begin; i < end; i++)
+			{
+				const ParticleEmitter& settings = chunks[i].emitter->settings;
+				integrate(chunks[i].emitter->particles, chunks[i].begin, chunks[i].end, dt, std::max(1 - settings.drag * dt, 0.f), settings.acceleration);
+			}
+		});
+		
+		SystemScheduler::parallelForEach(emitters, [](std::unique_ptr<Emitter>& em)
+		{
+			compact(*em);
+		});
+		
+		total = 0;
+		
+		for(auto& em : emitters)
+			total += em->particles.count;
+		
+		// one after another, so which particles are dropped at the limit doesn't depend on the threads
+		for(auto& em : emitters)
+		{
+			em->elapsed += dt;
+			
+			if(em->settings.duration > 0 && em->elapsed >= em->settings.duration)
+				em->stopped = true;
+			
+			std::size_t count = em->bursting;
+			em->bursting = 0;
+			
+			if(!em->stopped)
+			{
+				em->owed += std::max(em->settings.rate, 0.f) * dt;
+				
+				float whole = std::floor(em->owed);
+				em->owed -= whole;
+				count += static_cast<std::size_t>(whole);
+			}
+			
+			spawn(*em, count);
+		}
+		
+		emitters.erase(std::remove_if(emitters.begin(), emitters.end(), [](const std::unique_ptr<Emitter>& em)
+		{
+			return em->stopped && em->particles.count == 0;
+		}), emitters.end());
+	}
+	
+	void ParticleSystem::prepare(const sf::FloatRect& area, float e)
+	{
+		SWIFT_PROFILE("ParticleSystem::prepare");
+		
+		// particles are where they'll be the next update. Back along their velocities is where they were in between
+		float back = lastDt * (1 - e);
+		
+		chunks.clear();
+		
+		for(auto& b : batches)
+			b.count = 0;
+		
+		batchCount = 0;
+		drawn = 0;
+		
+		for(auto& em : emitters)
+		{
+			const Pool& p = em->particles;
+			const ParticleEmitter& s = em->settings;
+			
+			if(p.count == 0)
+				continue;
+			
+			// as far as a particle can be drawn from where it is
+			float reach = std::max(s.sizeStart, s.sizeEnd) / 2 + lastDt * (std::max(std::abs(s.speedMin), std::abs(s.speedMax)) + math::magnitude(s.acceleration) * s.lifeMax);
+			sf::FloatRect bounds = {em->bounds.left - reach, em->bounds.top - reach, em->bounds.width + reach * 2, em->bounds.height + reach * 2};
+			
+			if(!bounds.intersects(area))
+				continue;
+			
+			std::size_t batch = 0;
+			
+			while(batch < batchCount && batches[batch].texture != s.texture)
+				batch++;
+			
+			if(batch == batchCount)
+			{
+				if(batchCount == batches.size())
+					batches.push_back({s.texture, {}, 0});
+				
+				batches[batchCount].texture = s.texture;
+				batches[batchCount].count = 0;
+				batchCount++;
+			}
+			
+			for(std::size_t b = 0; b < p.count; b += chunkSize)
+				chunks.push_back({em.get(), b, std::min(b + chunkSize, p.count), batch, batches[batch].count + b * 4});
+			
+			batches[batch].count += p.count * 4;
+			drawn += p.count;
+		}
+		
+		for(std::size_t b = 0; b < batchCount; b++)
+		{
+			if(batches[b].vertices.size() < batches[b].count)
+				batches[b].vertices.resize(batches[b].count);
+		}
+		
+		SystemScheduler::parallelFor(chunks.size(), [this, back](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t i = begin; i < end; i++)
+				build(*chunks[i].emitter, chunks[i].begin, chunks[i].end, back, &batches[chunks[i].batch].vertices[chunks[i].vertex]);
+		});
+	}
+	
+	void ParticleSystem::setLimit(std::size_t l)
+	{
+		limit = l;
+	}
+	
+	std::size_t ParticleSystem::getParticleCount() const
+	{
+		return total;
+	}
+	
+	std::size_t ParticleSystem::getEmitterCount() const
+	{
+		return emitters.size();
+	}
+	
+	std::size_t ParticleSystem::getBatchCount() const
+	{
+		return batchCount;
+	}
+	
+	std::size_t ParticleSystem::getDrawnCount() const
+	{
+		return drawn;
+	}
+	
+	void ParticleSystem::draw(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		for(std::size_t b = 0; b < batchCount; b++)
+		{
+			if(batches[b].count == 0)
+				continue;
+			
+			sf::RenderStates batchStates = states;
+			batchStates.texture = batches[b].texture;
+			
+			target.draw(&batches[b].vertices[0], batches[b].count, sf::Quads, batchStates);
+		}
+	}
+	
+	ParticleSystem::Emitter* ParticleSystem::find(unsigned id) const
+	{
+		for(auto& em : emitters)
+		{
+			if(em->id == id)
+				return em.get();
+		}
+		
+		return nullptr;
+	}
+	
+	unsigned ParticleSystem::add(const std::string& name, const sf::Vector2f& position, EntityHandle entity)
+	{
+		auto def = definitions.find(name);
+		
+		if(def == definitions.end())
+			return 0;
+		
+		std::unique_ptr<Emitter> em(new Emitter);
+		
+		em->id = nextId++;
+		em->settings = def->second;
+		em->position = position;
+		em->entity = entity;
+		em->stopped = false;
+		em->elapsed = 0;
+		em->owed = 0;
+		em->bursting = def->second.burst;
+		em->rng = Random::stream(em->id);
+		em->bounds = {position.x, position.y, 0, 0};
+		
+		emitters.push_back(std::move(em));
+		
+		return emitters.back()->id;
+	}
+	
+	void ParticleSystem::integrate(Pool& pool, std::size_t begin, std::size_t end, float dt, float keep, const sf::Vector2f& acceleration)
+	{
+		float* posX = pool.posX.data();
+		float* posY = pool.posY.data();
+		float* velX = pool.velX.data();
+		float* velY = pool.velY.data();
+		float* age = pool.age.data();
+		const float* aging = pool.aging.data();
+		
+		const float ax = acceleration.x * dt;
+		const float ay = acceleration.y * dt;
+		
+		// no branches and the same for every particle, so it's vectorized
+		for(std::size_t i = begin; i < end; i++)
+		{
+			velX[i] = velX[i] * keep + ax;
+			velY[i] = velY[i] * keep + ay;
+			posX[i] += velX[i] * dt;
+			posY[i] += velY[i] * dt;
+			age[i] += aging[i] * dt;
+		}
+	}
+	
+	void ParticleSystem::build(const Emitter& emitter, std::size_t begin, std::size_t end, float back, sf::Vertex* vertices)
+	{
+		const Pool& p = emitter.particles;
+		const ParticleEmitter& s = emitter.settings;
+		
+		sf::Vector2f texStart;
+		sf::Vector2f texEnd;
+		
+		if(s.texture)
+		{
+			sf::IntRect region = s.region.width > 0 && s.region.height > 0 ? s.region : sf::IntRect(0, 0, s.texture->getSize().x, s.texture->getSize().y);
+			texStart = {static_cast<float>(region.left), static_cast<float>(region.top)};
+			texEnd = {static_cast<float>(region.left + region.width), static_cast<float>(region.top + region.height)};
+		}
+		
+		const float sizeStep = s.sizeEnd - s.sizeStart;
+		const float red = static_cast<float>(s.colorEnd.r) - s.colorStart.r;
+		const float green = static_cast<float>(s.colorEnd.g) - s.colorStart.g;
+		const float blue = static_cast<float>(s.colorEnd.b) - s.colorStart.b;
+		const float alpha = static_cast<float>(s.colorEnd.a) - s.colorStart.a;
+		
+		for(std::size_t i = begin; i < end; i++)
+		{
+			float t = std::min(p.age[i], 1.f);
+			float half = (s.sizeStart + sizeStep * t) / 2;
+			float x = p.posX[i] - p.velX[i] * back;
+			float y = p.posY[i] - p.velY[i] * back;
+			
+			sf::Color color(static_cast<sf::Uint8>(s.colorStart.r + red * t), static_cast<sf::Uint8>(s.colorStart.g + green * t),
+							static_cast<sf::Uint8>(s.colorStart.b + blue * t), static_cast<sf::Uint8>(s.colorStart.a + alpha * t));
+			
+			sf::Vertex* quad = vertices + (i - begin) * 4;
+			
+			quad[0] = sf::Vertex({x - half, y - half}, color, texStart);
+			quad[1] = sf::Vertex({x + half, y - half}, color, {texEnd.x, texStart.y});
+			quad[2] = sf::Vertex({x + half, y + half}, color, texEnd);
+			quad[3] = sf::Vertex({x - half, y + half}, color, {texStart.x, texEnd.y});
+		}
+	}
+	
+	void ParticleSystem::compact(Emitter& emitter)
+	{
+		Pool& p = emitter.particles;
+		
+		float minX = std::numeric_limits<float>::max();
+		float minY = std::numeric_limits<float>::max();
+		float maxX = std::numeric_limits<float>::lowest();
+		float maxY = std::numeric_limits<float>::lowest();
+		
+		std::size_t alive = p.count;
+		std::size_t i = 0;
+		
+		while(i < alive)
+		{
+			if(p.age[i] >= 1)
+			{
+				alive--;
+				p.posX[i] = p.posX[alive];
+				p.posY[i] = p.posY[alive];
+				p.velX[i] = p.velX[alive];
+				p.velY[i] = p.velY[alive];
+				p.age[i] = p.age[alive];
+				p.aging[i] = p.aging[alive];
+				continue;
+			}
+			
+			minX = std::min(minX, p.posX[i]);
+			minY = std::min(minY, p.posY[i]);
+			maxX = std::max(maxX, p.posX[i]);
+			maxY = std::max(maxY, p.posY[i]);
+			i++;
+		}
+		
+		p.count = alive;
+		
+		if(alive > 0)
+			emitter.bounds = {minX, minY, maxX - minX, maxY - minY};
+		else
+			emitter.bounds = {emitter.position.x, emitter.position.y, 0, 0};
+	}
+	
+	void ParticleSystem::spawn(Emitter& emitter, std::size_t count)
+	{
+		Pool& p = emitter.particles;
+		const ParticleEmitter& s = emitter.settings;
+		
+		count = std::min(count, s.max > p.count ? s.max - p.count : 0);
+		count = std::min(count, limit > total ? limit - total : 0);
+		
+		if(count == 0)
+			return;
+		
+		// grown by at least double, so a steady emitter stops allocating after a few updates
+		if(p.count + count > p.posX.size())
+		{
+			std::size_t size = std::max(p.count + count, p.posX.size() * 2);
+			
+			p.posX.resize(size);
+			p.posY.resize(size);
+			p.velX.resize(size);
+			p.velY.resize(size);
+			p.age.resize(size);
+			p.aging.resize(size);
+		}
+		
+		sf::Vector2f from = emitter.position + s.offset;
+		
+		for(std::size_t i = p.count; i < p.count + count; i++)
+		{
+			float angle = (s.direction + (emitter.rng.uniform() - 0.5f) * s.spread) * math::PI / 180.f;
+			float speed = s.speedMin + (s.speedMax - s.speedMin) * emitter.rng.uniform();
+			float life = s.lifeMin + (s.lifeMax - s.lifeMin) * emitter.rng.uniform();
+			
+			p.posX[i] = from.x;
+			p.posY[i] = from.y;
+			p.velX[i] = std::cos(angle) * speed;
+			p.velY[i] = std::sin(angle) * speed;
+			p.age[i] = 0;
+			p.aging[i] = 1 / std::max(life, 0.001f);
+		}
+		
+		p.count += count;
+		total += count;
+		
+		// so it's drawn before it moves
+		float left = std::min(emitter.bounds.left, from.x);
+		float top = std::min(emitter.bounds.top, from.y);
+		float right = std::max(emitter.bounds.left + emitter.bounds.width, from.x);
+		float bottom = std::max(emitter.bounds.top + emitter.bounds.height, from.y);
+		
+		emitter.bounds = {left, top, right - left, bottom - top};
+	}
+}
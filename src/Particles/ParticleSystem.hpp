@@ -0,0 +1,151 @@
+#ifndef PARTICLESYSTEM_HPP
+#define PARTICLESYSTEM_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+
+#include "ParticleEmitter.hpp"
+#include "../EntitySystem/EntityHandle.hpp"
+#include "../ResourceManager/AssetHandle.hpp"
+#include "../Math/Random.hpp"
+
+namespace swift
+{
+	// sparks, smoke, and the like, kept out of the entity system. Each emitter's particles are arrays of positions,
+	// velocities, and ages, kept between updates so spawning doesn't allocate once they've grown, and moved in chunks
+	// over the thread pool by loops over them the compiler can vectorize. Drawn as quads, one draw call per texture
+	class ParticleSystem : public sf::Drawable
+	{
+		public:
+			// where an attached emitter's entity's center is. False once the entity is gone
+			using Locate = std::function<bool(EntityHandle entity, sf::Vector2f& center)>;
+			
+			ParticleSystem();
+			
+			// settings emitters made as name are made with. Emitters already made keep what they were made with.
+			// texture is held for as long as the particle system is, so emitters made before name was defined again keep theirs
+			void define(const std::string& name, const ParticleEmitter& settings, const AssetHandle<sf::Texture>& texture = {});
+			
+			// nullptr if name isn't defined. Changes are seen by emitters made after them
+			ParticleEmitter* getDefinition(const std::string& name);
+			
+			// an emitter of name at position, or following entity's center until it's stopped or the entity is gone.
+			// 0 if name isn't defined. Ids are never reused
+			unsigned emit(const std::string& name, const sf::Vector2f& position);
+			unsigned attach(const std::string& name, EntityHandle entity);
+			
+			void setPosition(unsigned id, const sf::Vector2f& position);
+			
+			// spawns count particles on the next update, on top of the emitter's rate
+			void burst(unsigned id, unsigned count);
+			
+			// stops spawning, the emitter is removed once its last particle is gone
+			void stop(unsigned id);
+			
+			// with its particles
+			void remove(unsigned id);
+			void clear();
+			
+			// moves, ages, and spawns particles, then removes emitters that are done
+			void update(float dt, const Locate& locate);
+			
+			// builds the batches drawing the particles of emitters reaching area, e of the way from the last update to the next
+			void prepare(const sf::FloatRect& area, float e);
+			
+			// most particles alive at once. Emitters stop spawning at it
+			void setLimit(std::size_t l);
+			
+			std::size_t getParticleCount() const;
+			std::size_t getEmitterCount() const;
+			
+			// of the last prepare
+			std::size_t getBatchCount() const;
+			std::size_t getDrawnCount() const;
+		
+		private:
+			// one emitter's particles. The arrays only grow, count of them are alive
+			struct Pool
+			{
+				std::vector<float> posX;
+				std::vector<float> posY;
+				std::vector<float> velX;
+				std::vector<float> velY;
+				std::vector<float> age;		// 0 when spawned, dead at 1
+				std::vector<float> aging;	// a second, 1 / its life
+				std::size_t count = 0;
+			};
+			
+			struct Emitter
+			{
+				unsigned id;
+				ParticleEmitter settings;
+				sf::Vector2f position;
+				EntityHandle entity;		// null if it isn't attached
+				bool stopped;
+				float elapsed;
+				float owed;					// particles of the rate not spawned yet, less than one
+				unsigned bursting;
+				Random::Generator rng;
+				Pool particles;
+				sf::FloatRect bounds;		// of its particles, after the last update
+			};
+			
+			struct Batch
+			{
+				const sf::Texture* texture;
+				std::vector<sf::Vertex> vertices;	// kept between frames, only count of them are drawn
+				std::size_t count;
+			};
+			
+			// a slice of one emitter's particles, what each job of the pool works on
+			struct Chunk
+			{
+				Emitter* emitter;
+				std::size_t begin;
+				std::size_t end;
+				std::size_t batch;		// when preparing, the batch its quads go in
+				std::size_t vertex;		// and the first of them
+			};
+			
+			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+			
+			Emitter* find(unsigned id) const;
+			
+			unsigned add(const std::string& name, const sf::Vector2f& position, EntityHandle entity);
+			
+			// the loops over each particle
+			static void integrate(Pool& pool, std::size_t begin, std::size_t end, float dt, float keep, const sf::Vector2f& acceleration);
+			static void build(const Emitter& emitter, std::size_t begin, std::size_t end, float back, sf::Vertex* vertices);
+			
+			// drops dead particles, swapping the last alive into their places, and finds the bounds of the rest
+			static void compact(Emitter& emitter);
+			
+			void spawn(Emitter& emitter, std::size_t count);
+			
+			std::map<std::string, ParticleEmitter> definitions;
+			std::vector<AssetHandle<sf::Texture>> textures;
+			std::vector<std::unique_ptr<Emitter>> emitters;
+			unsigned nextId;
+			
+			std::size_t limit;
+			std::size_t total;		// alive, of every emitter
+			float lastDt;
+			
+			std::vector<Batch> batches;
+			std::size_t batchCount;
+			std::size_t drawn;
+			
+			// reused every update and prepare
+			std::vector<Chunk> chunks;
+	};
+}
+
+#endif // PARTICLESYSTEM_HPP
@@ -0,0 +1,571 @@
+#include "ClusterGraph.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace swift
+{
+	constexpr float ClusterGraph::UNREACHABLE;
+	
+	ClusterGraph::ClusterGraph(unsigned cs)
+	:	clusterSize(std::max(cs, 2u)),
+		size(0, 0),
+		clusterCount(0, 0),
+		numNodes(0),
+		built(false),
+		stamp(0),
+		expanded(0)
+	{
+	}
+	
+	void ClusterGraph::build(const PassabilityMap& map)
+	{
+		size = map.getSize();
+		clusterCount = {(size.x + clusterSize - 1) / clusterSize, (size.y + clusterSize - 1) / clusterSize};
+		
+		clusters.clear();
+		clusters.resize(clusterCount.x * clusterCount.y);
+		dirtyClusters.clear();
+		
+		for(unsigned c = 0; c < clusters.size(); c++)
+		{
+			int left = c % clusterCount.x * clusterSize;
+			int top = c / clusterCount.x * clusterSize;
+			
+			// clusters along the right and bottom edges may be cut short
+			clusters[c].area = {left, top, std::min<int>(clusterSize, size.x - left), std::min<int>(clusterSize, size.y - top)};
+			clusters[c].base = 0;
+			clusters[c].dirty = false;
+		}
+		
+		for(unsigned c = 0; c < clusters.size(); c++)
+			rebuild(map, c);
+		
+		updateBases();
+		built = true;
+	}
+	
+	bool ClusterGraph::isBuilt() const
+	{
+		return built;
+	}
+	
+	void ClusterGraph::markDirty(unsigned x, unsigned y)
+	{
+		if(!built || x >= size.x || y >= size.y)
+			return;
+		
+		unsigned c = getCluster(x, y);
+		
+		if(!clusters[c].dirty)
+		{
+			clusters[c].dirty = true;
+			dirtyClusters.push_back(c);
+		}
+	}
+	
+	void ClusterGraph::update(const PassabilityMap& map)
+	{
+		if(dirtyClusters.empty())
+			return;
+		
+		// the entrances on a dirty cluster's borders are shared with its neighbors
+		std::vector<unsigned> rebuilt;
+		
+		for(auto& c : dirtyClusters)
+		{
+			int cx = c % clusterCount.x;
+			int cy = c / clusterCount.x;
+			
+			rebuilt.push_back(c);
+			
+			if(cx > 0)
+				rebuilt.push_back(c - 1);
+			if(cx + 1 < static_cast<int>(clusterCount.x))
+				rebuilt.push_back(c + 1);
+			if(cy > 0)
+				rebuilt.push_back(c - clusterCount.x);
+			if(cy + 1 < static_cast<int>(clusterCount.y))
+				rebuilt.push_back(c + clusterCount.x);
+		}
+		
+		std::sort(rebuilt.begin(), rebuilt.end());
+		rebuilt.erase(std::unique(rebuilt.begin(), rebuilt.end()), rebuilt.end());
+		
+		for(auto& c : rebuilt)
+			rebuild(map, c);
+		
+		dirtyClusters.clear();
+		updateBases();
+	}
+	
+	bool ClusterGraph::find(const PassabilityMap& map, const sf::Vector2i& start, const sf::Vector2i& goal, std::vector<sf::Vector2i>& waypoints) const
+	{
+		waypoints.clear();
+		expanded = 0;
+		
+		if(!built || map.getSize() != size)
+			return false;
+		
+		if(!map.isInside(start.x, start.y) || !map.isInside(goal.x, goal.y))
+			return false;
+		
+		if(start == goal)
+		{
+			waypoints.push_back(start);
+			return true;
+		}
+		
+		if(!map.isPassable(goal.x, goal.y))
+			return false;
+		
+		// entrances are only made of passable tiles, so from a blocked start, step off onto a neighbor first,
+		// trying the ones closest to the goal first
+		if(!map.isPassable(start.x, start.y))
+		{
+			std::vector<sf::Vector2i> neighbors = {start + sf::Vector2i(1, 0), start + sf::Vector2i(-1, 0), start + sf::Vector2i(0, 1), start + sf::Vector2i(0, -1)};
+			
+			std::sort(neighbors.begin(), neighbors.end(), [&goal](const sf::Vector2i& one, const sf::Vector2i& two)
+			{
+				return std::abs(goal.x - one.x) + std::abs(goal.y - one.y) < std::abs(goal.x - two.x) + std::abs(goal.y - two.y);
+			});
+			
+			for(auto& n : neighbors)
+			{
+				if(map.isInside(n.x, n.y) && map.isPassable(n.x, n.y) && find(map, n, goal, waypoints))
+				{
+					waypoints.insert(waypoints.begin(), start);
+					return true;
+				}
+			}
+			
+			return false;
+		}
+		
+		const unsigned startCluster = getCluster(start.x, start.y);
+		const unsigned goalCluster = getCluster(goal.x, goal.y);
+		const Cluster& sc = clusters[startCluster];
+		const Cluster& gc = clusters[goalCluster];
+		
+		flood(map, sc, start, startDist);
+		flood(map, gc, goal, goalDist);
+		
+		auto localIndex = [](const Cluster& cluster, const sf::Vector2i& tile)
+		{
+			return (tile.y - cluster.area.top) * cluster.area.width + tile.x - cluster.area.left;
+		};
+		
+		// start and goal get the two ids after the real nodes
+		const unsigned startId = numNodes;
+		const unsigned goalId = numNodes + 1;
+		
+		if(stamps.size() < numNodes + 2)
+		{
+			cost.resize(numNodes + 2);
+			parent.resize(numNodes + 2);
+			stamps.resize(numNodes + 2, 0);
+		}
+		
+		if(++stamp == 0)
+		{
+			std::fill(stamps.begin(), stamps.end(), 0);
+			stamp = 1;
+		}
+		
+		open.clear();
+		relax(map, startId, -1, 0, start, goal);
+		
+		bool found = false;
+		
+		while(!open.empty())
+		{
+			std::pop_heap(open.begin(), open.end());
+			Open top = open.back();
+			open.pop_back();
+			
+			const unsigned u = top.node;
+			const sf::Vector2i& tile = getNodeTile(u, start, goal);
+			const float g = cost[u];
+			
+			if(top.f > g + map.estimate(tile, goal))
+				continue;
+			
+			if(u == goalId)
+			{
+				found = true;
+				break;
+			}
+			
+			expanded++;
+			
+			if(u == startId)
+			{
+				for(unsigned j = 0; j < sc.nodes.size(); j++)
+				{
+					float d = startDist[localIndex(sc, sc.nodes[j])];
+					
+					if(d < UNREACHABLE)
+						relax(map, sc.base + j, u, d, sc.nodes[j], goal);
+				}
+				
+				if(startCluster == goalCluster && startDist[localIndex(sc, goal)] < UNREACHABLE)
+					relax(map, goalId, u, startDist[localIndex(sc, goal)], goal, goal);
+				
+				continue;
+			}
+			
+			const unsigned c = nodeRefs[u].first;
+			const unsigned i = nodeRefs[u].second;
+			const Cluster& cluster = clusters[c];
+			const std::size_t n = cluster.nodes.size();
+			
+			// across the cluster
+			for(unsigned j = 0; j < n; j++)
+			{
+				float d = cluster.distances[i * n + j];
+				
+				if(j != i && d < UNREACHABLE)
+					relax(map, cluster.base + j, u, g + d, cluster.nodes[j], goal);
+			}
+			
+			// into the neighboring clusters
+			static const sf::Vector2i dirs[4] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+			
+			for(auto& d : dirs)
+			{
+				sf::Vector2i next = tile + d;
+				int other = getCluster(next.x, next.y);
+				
+				if(other == -1 || other == static_cast<int>(c))
+					continue;
+				
+				int k = findNode(clusters[other], next);
+				
+				if(k != -1)
+					relax(map, clusters[other].base + k, u, g + map.getStepCost(tile.x, tile.y, d.x, d.y), next, goal);
+			}
+			
+			if(c == goalCluster && goalDist[localIndex(gc, tile)] < UNREACHABLE)
+				relax(map, goalId, u, g + goalDist[localIndex(gc, tile)], goal, goal);
+		}
+		
+		open.clear();
+		
+		if(!found)
+			return false;
+		
+		for(int id = goalId; id != -1; id = parent[id])
+			waypoints.push_back(getNodeTile(id, start, goal));
+		
+		std::reverse(waypoints.begin(), waypoints.end());
+		
+		return true;
+	}
+	
+	bool ClusterGraph::refine(const PassabilityMap& map, const sf::Vector2i& from, const sf::Vector2i& to, std::vector<sf::Vector2i>& tiles) const
+	{
+		tiles.clear();
+		
+		if(from == to)
+			return true;
+		
+		if(!map.isInside(to.x, to.y) || !map.isPassable(to.x, to.y))
+			return false;
+		
+		if(std::abs(to.x - from.x) + std::abs(to.y - from.y) == 1)
+		{
+			tiles.push_back(to);
+			return true;
+		}
+		
+		int c = getCluster(from.x, from.y);
+		
+		if(c == -1 || c != getCluster(to.x, to.y))
+			return false;
+		
+		// search only a copy of the cluster, so the path stays inside it like the precomputed distances did
+		const sf::IntRect& area = clusters[c].area;
+		local.resize({static_cast<unsigned>(area.width), static_cast<unsigned>(area.height)});
+		
+		local.setDiagonal(map.isDiagonal());
+		
+		for(int y = 0; y < area.height; y++)
+		{
+			for(int x = 0; x < area.width; x++)
+			{
+				local.setPassable(x, y, map.isPassable(area.left + x, area.top + y));
+				local.setCost(x, y, map.getCost(area.left + x, area.top + y));
+			}
+		}
+		
+		sf::Vector2i offset(area.left, area.top);
+		
+		bool found = search.find(local, from - offset, to - offset, tiles);
+		expanded += search.getStats().expanded;
+		
+		if(!found)
+			return false;
+		
+		tiles.erase(tiles.begin());
+		
+		for(auto& t : tiles)
+			t += offset;
+		
+		return true;
+	}
+	
+	unsigned ClusterGraph::getClusterSize() const
+	{
+		return clusterSize;
+	}
+	
+	std::size_t ClusterGraph::getNumNodes() const
+	{
+		return numNodes;
+	}
+	
+	unsigned ClusterGraph::getExpanded() const
+	{
+		return expanded;
+	}
+	
+	std::size_t ClusterGraph::getMemory() const
+	{
+		std::size_t bytes = clusters.capacity() * sizeof(Cluster) + nodeRefs.capacity() * sizeof(nodeRefs[0])
+							+ dirtyClusters.capacity() * sizeof(unsigned);
+		
+		for(auto& c : clusters)
+			bytes += c.nodes.capacity() * sizeof(sf::Vector2i) + c.distances.capacity() * sizeof(float);
+		
+		bytes += (startDist.capacity() + goalDist.capacity() + cost.capacity()) * sizeof(float)
+				+ parent.capacity() * sizeof(int) + stamps.capacity() * sizeof(std::uint32_t)
+				+ open.capacity() * sizeof(Open) + queue.capacity() * sizeof(int);
+		
+		return bytes + search.getStats().memory;
+	}
+	
+	void ClusterGraph::rebuild(const PassabilityMap& map, unsigned c)
+	{
+		Cluster& cluster = clusters[c];
+		
+		cluster.nodes.clear();
+		cluster.dirty = false;
+		
+		addEntrances(map, c, {1, 0});
+		addEntrances(map, c, {-1, 0});
+		addEntrances(map, c, {0, 1});
+		addEntrances(map, c, {0, -1});
+		
+		// corner tiles can be entrances on two sides
+		std::sort(cluster.nodes.begin(), cluster.nodes.end(), [](const sf::Vector2i& one, const sf::Vector2i& two)
+		{
+			return one.y != two.y ? one.y < two.y : one.x < two.x;
+		});
+		cluster.nodes.erase(std::unique(cluster.nodes.begin(), cluster.nodes.end()), cluster.nodes.end());
+		
+		const std::size_t n = cluster.nodes.size();
+		cluster.distances.assign(n * n, UNREACHABLE);
+		
+		for(unsigned i = 0; i < n; i++)
+		{
+			flood(map, cluster, cluster.nodes[i], startDist);
+			
+			for(unsigned j = 0; j < n; j++)
+			{
+				const sf::Vector2i& t = cluster.nodes[j];
+				cluster.distances[i * n + j] = startDist[(t.y - cluster.area.top) * cluster.area.width + t.x - cluster.area.left];
+			}
+		}
+	}
+	
+	void ClusterGraph::updateBases()
+	{
+		numNodes = 0;
+		nodeRefs.clear();
+		
+		for(unsigned c = 0; c < clusters.size(); c++)
+		{
+			clusters[c].base = numNodes;
+			numNodes += clusters[c].nodes.size();
+			
+			for(unsigned i = 0; i < clusters[c].nodes.size(); i++)
+				nodeRefs.emplace_back(c, i);
+		}
+	}
+	
+	const sf::Vector2i& ClusterGraph::getNodeTile(unsigned id, const sf::Vector2i& start, const sf::Vector2i& goal) const
+	{
+		if(id == numNodes)
+			return start;
+		else if(id == numNodes + 1)
+			return goal;
+		
+		return clusters[nodeRefs[id].first].nodes[nodeRefs[id].second];
+	}
+	
+	void ClusterGraph::relax(const PassabilityMap& map, unsigned node, int from, float g, const sf::Vector2i& tile, const sf::Vector2i& goal) const
+	{
+		if(stamps[node] == stamp && cost[node] <= g)
+			return;
+		
+		stamps[node] = stamp;
+		cost[node] = g;
+		parent[node] = from;
+		
+		open.push_back({g + map.estimate(tile, goal), node});
+		std::push_heap(open.begin(), open.end());
+	}
+	
+	void ClusterGraph::addEntrances(const PassabilityMap& map, unsigned c, const sf::Vector2i& dir)
+	{
+		Cluster& cluster = clusters[c];
+		const sf::IntRect& area = cluster.area;
+		
+		// the border tiles on this side, and the step along them
+		sf::Vector2i first;
+		sf::Vector2i step = dir.x != 0 ? sf::Vector2i(0, 1) : sf::Vector2i(1, 0);
+		int length = dir.x != 0 ? area.height : area.width;
+		
+		if(dir.x > 0)
+			first = {area.left + area.width - 1, area.top};
+		else if(dir.x < 0)
+			first = {area.left, area.top};
+		else if(dir.y > 0)
+			first = {area.left, area.top + area.height - 1};
+		else
+			first = {area.left, area.top};
+		
+		// no cluster on the other side
+		if(!map.isInside(first.x + dir.x, first.y + dir.y))
+			return;
+		
+		// every run of crossable tiles gets an entrance in its middle, long runs one at each end.
+		// both clusters of a border find the same runs, so their entrances always line up
+		int runStart = -1;
+		
+		for(int i = 0; i <= length; i++)
+		{
+			sf::Vector2i tile = first + step * i;
+			
+			bool open = i < length && map.isPassable(tile.x, tile.y) && map.isPassable(tile.x + dir.x, tile.y + dir.y);
+			
+			if(open && runStart == -1)
+				runStart = i;
+			else if(!open && runStart != -1)
+			{
+				int runLength = i - runStart;
+				
+				if(runLength < 6)
+					cluster.nodes.push_back(first + step * (runStart + runLength / 2));
+				else
+				{
+					cluster.nodes.push_back(first + step * runStart);
+					cluster.nodes.push_back(first + step * (i - 1));
+				}
+				
+				runStart = -1;
+			}
+		}
+	}
+	
+	void ClusterGraph::flood(const PassabilityMap& map, const Cluster& cluster, const sf::Vector2i& tile, std::vector<float>& dist) const
+	{
+		const sf::IntRect& area = cluster.area;
+		
+		dist.assign(area.width * area.height, UNREACHABLE);
+		
+		int first = (tile.y - area.top) * area.width + tile.x - area.left;
+		dist[first] = 0;
+		
+		// diagonals last, so 4-connected maps stop before them
+		static const int offsets[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1}};
+		
+		if(map.isUniform() && !map.isDiagonal())
+		{
+			// every step costs the same, breadth first is enough
+			queue.clear();
+			queue.push_back(first);
+			
+			for(std::size_t q = 0; q < queue.size(); q++)
+			{
+				int t = queue[q];
+				int x = t % area.width;
+				int y = t / area.width;
+				
+				for(int d = 0; d < 4; d++)
+				{
+					int nx = x + offsets[d][0];
+					int ny = y + offsets[d][1];
+					
+					if(nx < 0 || ny < 0 || nx >= area.width || ny >= area.height)
+						continue;
+					
+					int next = ny * area.width + nx;
+					
+					if(dist[next] < UNREACHABLE || !map.isPassable(area.left + nx, area.top + ny))
+						continue;
+					
+					dist[next] = dist[t] + 1;
+					queue.push_back(next);
+				}
+			}
+			
+			return;
+		}
+		
+		// Dijkstra's otherwise. The open list isn't in use by a search yet when this runs
+		const int count = map.isDiagonal() ? 8 : 4;
+		
+		open.clear();
+		open.push_back({0, static_cast<unsigned>(first)});
+		
+		while(!open.empty())
+		{
+			std::pop_heap(open.begin(), open.end());
+			Open top = open.back();
+			open.pop_back();
+			
+			int t = top.node;
+			
+			if(top.f > dist[t])
+				continue;
+			
+			int x = t % area.width;
+			int y = t / area.width;
+			
+			for(int d = 0; d < count; d++)
+			{
+				int nx = x + offsets[d][0];
+				int ny = y + offsets[d][1];
+				
+				if(nx < 0 || ny < 0 || nx >= area.width || ny >= area.height)
+					continue;
+				
+				float step = map.getStepCost(area.left + x, area.top + y, offsets[d][0], offsets[d][1]);
+				int next = ny * area.width + nx;
+				
+				if(step == 0 || dist[t] + step >= dist[next])
+					continue;
+				
+				dist[next] = dist[t] + step;
+				open.push_back({dist[next], static_cast<unsigned>(next)});
+				std::push_heap(open.begin(), open.end());
+			}
+		}
+	}
+	
+	int ClusterGraph::getCluster(int x, int y) const
+	{
+		if(x < 0 || y < 0 || x >= static_cast<int>(size.x) || y >= static_cast<int>(size.y))
+			return -1;
+		
+		return y / clusterSize * clusterCount.x + x / clusterSize;
+	}
+	
+	int ClusterGraph::findNode(const Cluster& cluster, const sf::Vector2i& tile)
+	{
+		auto it = std::find(cluster.nodes.begin(), cluster.nodes.end(), tile);
+		
+		return it != cluster.nodes.end() ? it - cluster.nodes.begin() : -1;
+	}
+}
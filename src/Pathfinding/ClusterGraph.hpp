@@ -0,0 +1,125 @@
+#ifndef CLUSTERGRAPH_HPP
+#define CLUSTERGRAPH_HPP
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#include "../Mapping/PassabilityMap.hpp"
+#include "GridSearch.hpp"
+
+namespace swift
+{
+	// hierarchical pathfinding (HPA*) over a PassabilityMap. The map is cut into square clusters,
+	// with nodes on the tiles where clusters can be crossed, and the distances between the nodes
+	// of each cluster precomputed. A search then only visits those nodes, and the path between
+	// them is found later, a cluster at a time, with refine.
+	// paths are close to, but not always exactly, the shortest.
+	// queries reuse internal buffers, so one graph can't be searched from several threads at once
+	class ClusterGraph
+	{
+		public:
+			explicit ClusterGraph(unsigned clusterSize = 16);
+			
+			// rebuilds everything
+			void build(const PassabilityMap& map);
+			
+			bool isBuilt() const;
+			
+			// a tile changed, its cluster needs rebuilding. Does nothing until built
+			void markDirty(unsigned x, unsigned y);
+			
+			// rebuilds the clusters marked dirty, and their neighbors whose entrances they share
+			void update(const PassabilityMap& map);
+			
+			// fills waypoints with start, the entrance tiles on the way, and goal.
+			// consecutive waypoints are either next to each other, or in the same cluster.
+			// false if there is no path, or the graph wasn't built for map. Changes since the last update aren't seen
+			bool find(const PassabilityMap& map, const sf::Vector2i& start, const sf::Vector2i& goal, std::vector<sf::Vector2i>& waypoints) const;
+			
+			// fills tiles with the path from one waypoint to the next, from excluded, to included
+			bool refine(const PassabilityMap& map, const sf::Vector2i& from, const sf::Vector2i& to, std::vector<sf::Vector2i>& tiles) const;
+			
+			unsigned getClusterSize() const;
+			std::size_t getNumNodes() const;
+			
+			// nodes expanded by the last find, and tiles expanded by refines since then
+			unsigned getExpanded() const;
+			
+			// bytes held by the graph and the buffers searches reuse
+			std::size_t getMemory() const;
+			
+		private:
+			struct Cluster
+			{
+				sf::IntRect area;
+				std::vector<sf::Vector2i> nodes;	// entrance tiles inside this cluster
+				std::vector<float> distances;		// nodes.size() squared, between each pair of nodes
+				std::size_t base;					// id of the first node, ids are unique over the graph
+				bool dirty;
+			};
+			
+			struct Open
+			{
+				float f;
+				unsigned node;
+				
+				bool operator<(const Open& other) const
+				{
+					return f > other.f;
+				}
+			};
+			
+			static constexpr float UNREACHABLE = 1e30f;
+			
+			void rebuild(const PassabilityMap& map, unsigned c);
+			void updateBases();
+			
+			const sf::Vector2i& getNodeTile(unsigned id, const sf::Vector2i& start, const sf::Vector2i& goal) const;
+			
+			void relax(const PassabilityMap& map, unsigned node, int from, float g, const sf::Vector2i& tile, const sf::Vector2i& goal) const;
+			
+			// adds the entrances between cluster c and the cluster beside it in direction dir
+			void addEntrances(const PassabilityMap& map, unsigned c, const sf::Vector2i& dir);
+			
+			// shortest distances from tile, inside the cluster's area. Fills the distance to each tile of the area
+			void flood(const PassabilityMap& map, const Cluster& cluster, const sf::Vector2i& tile, std::vector<float>& dist) const;
+			
+			// -1 outside of the map
+			int getCluster(int x, int y) const;
+			
+			// index of tile in the cluster's nodes, -1 if it isn't one
+			static int findNode(const Cluster& cluster, const sf::Vector2i& tile);
+			
+			unsigned clusterSize;
+			sf::Vector2u size;			// in tiles
+			sf::Vector2u clusterCount;
+			
+			std::vector<Cluster> clusters;
+			std::vector<unsigned> dirtyClusters;
+			
+			// cluster and index in it, of each node id
+			std::vector<std::pair<unsigned, unsigned>> nodeRefs;
+			std::size_t numNodes;
+			bool built;
+			
+			// reused between searches
+			mutable std::vector<float> startDist;
+			mutable std::vector<float> goalDist;
+			mutable std::vector<float> cost;
+			mutable std::vector<int> parent;
+			mutable std::vector<std::uint32_t> stamps;
+			mutable std::vector<Open> open;
+			mutable std::vector<int> queue;
+			mutable std::uint32_t stamp;
+			mutable unsigned expanded;
+			
+			mutable PassabilityMap local;
+			mutable GridSearch search;
+	};
+}
+
+#endif // CLUSTERGRAPH_HPP
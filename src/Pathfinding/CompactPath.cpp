@@ -0,0 +1,66 @@
+#include "CompactPath.hpp"
+
+namespace swift
+{
+	CompactPath::CompactPath()
+	:	cursor(0)
+	{
+	}
+	
+	void CompactPath::assign(const std::vector<sf::Vector2i>& tiles)
+	{
+		clear();
+		coords.reserve(tiles.size() * 2);
+		
+		for(auto& t : tiles)
+			append(t);
+	}
+	
+	void CompactPath::append(const sf::Vector2i& tile)
+	{
+		coords.push_back(static_cast<std::uint16_t>(tile.x));
+		coords.push_back(static_cast<std::uint16_t>(tile.y));
+	}
+	
+	void CompactPath::clear()
+	{
+		coords.clear();
+		cursor = 0;
+	}
+	
+	bool CompactPath::isDone() const
+	{
+		return cursor * 2 >= coords.size();
+	}
+	
+	sf::Vector2i CompactPath::getCurrent() const
+	{
+		return {coords[cursor * 2], coords[cursor * 2 + 1]};
+	}
+	
+	void CompactPath::advance()
+	{
+		if(!isDone())
+			cursor++;
+	}
+	
+	sf::Vector2i CompactPath::get(std::size_t i) const
+	{
+		return {coords[i * 2], coords[i * 2 + 1]};
+	}
+	
+	std::size_t CompactPath::getCursor() const
+	{
+		return cursor;
+	}
+	
+	std::size_t CompactPath::getRemaining() const
+	{
+		return coords.size() / 2 - cursor;
+	}
+	
+	std::size_t CompactPath::size() const
+	{
+		return coords.size() / 2;
+	}
+}
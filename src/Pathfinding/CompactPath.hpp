@@ -0,0 +1,43 @@
+#ifndef COMPACTPATH_HPP
+#define COMPACTPATH_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+namespace swift
+{
+	// tiles to walk through, packed as 16 bit coordinates, and how far along them the walker is.
+	// maps can be up to 65536 tiles on a side
+	class CompactPath
+	{
+		public:
+			CompactPath();
+			
+			void assign(const std::vector<sf::Vector2i>& tiles);
+			void append(const sf::Vector2i& tile);
+			void clear();
+			
+			// true once every tile was reached, or if there are none
+			bool isDone() const;
+			
+			// the tile being walked to
+			sf::Vector2i getCurrent() const;
+			
+			void advance();
+			
+			// the ith tile, counted from the first, whether reached or not
+			sf::Vector2i get(std::size_t i) const;
+			std::size_t getCursor() const;
+			
+			std::size_t getRemaining() const;
+			std::size_t size() const;
+			
+		private:
+			std::vector<std::uint16_t> coords;	// x, y of each tile in turn
+			std::uint32_t cursor;				// index of the current tile
+	};
+}
+
+#endif // COMPACTPATH_HPP
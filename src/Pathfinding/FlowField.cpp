@@ -0,0 +1,180 @@
+#include "FlowField.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace swift
+{
+	namespace
+	{
+		// in opposite pairs, so d ^ 1 is the way back. Diagonals last, so 4-connected maps stop before them
+		const int offsets[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1}};
+		const std::uint8_t NONE = 0xff;
+	}
+	
+	constexpr float FlowField::UNREACHABLE;
+	
+	FlowField::FlowField(const PassabilityMap& map, const sf::Vector2i& g, unsigned v)
+	:	size(map.getSize()),
+		goal(g),
+		version(v)
+	{
+		integration.assign(size.x * size.y, UNREACHABLE);
+		directions.assign(size.x * size.y, NONE);
+		
+		if(!map.isInside(goal.x, goal.y) || !map.isPassable(goal.x, goal.y))
+			return;
+		
+		if(!map.isUniform() || map.isDiagonal())
+		{
+			integrate(map);
+			return;
+		}
+		
+		// every step costs the same, so a breadth first search out from the goal is Dijkstra's
+		std::vector<unsigned> queue;
+		queue.reserve(size.x * size.y);
+		
+		unsigned first = goal.y * size.x + goal.x;
+		integration[first] = 0;
+		queue.push_back(first);
+		
+		for(std::size_t q = 0; q < queue.size(); q++)
+		{
+			unsigned t = queue[q];
+			int x = t % size.x;
+			int y = t / size.x;
+			
+			for(std::uint8_t d = 0; d < 4; d++)
+			{
+				int nx = x + offsets[d][0];
+				int ny = y + offsets[d][1];
+				
+				if(!map.isInside(nx, ny))
+					continue;
+				
+				unsigned next = ny * size.x + nx;
+				
+				if(integration[next] != UNREACHABLE)
+					continue;
+				
+				integration[next] = integration[t] + 1;
+				
+				// the neighbor it was reached from is one step closer
+				directions[next] = d ^ 1;
+				
+				// a blocked tile points the way out, but isn't walked through
+				if(map.isPassable(nx, ny))
+					queue.push_back(next);
+			}
+		}
+	}
+	
+	void FlowField::integrate(const PassabilityMap& map)
+	{
+		// pairs of cost and tile, smallest cost on top
+		using Entry = std::pair<float, unsigned>;
+		std::vector<Entry> open;
+		auto later = [](const Entry& one, const Entry& two)
+		{
+			return one.first > two.first;
+		};
+		
+		const int count = map.isDiagonal() ? 8 : 4;
+		
+		unsigned first = goal.y * size.x + goal.x;
+		integration[first] = 0;
+		open.emplace_back(0.f, first);
+		
+		while(!open.empty())
+		{
+			std::pop_heap(open.begin(), open.end(), later);
+			Entry top = open.back();
+			open.pop_back();
+			
+			unsigned t = top.second;
+			
+			// stale, reached more cheaply since
+			if(top.first > integration[t])
+				continue;
+			
+			int x = t % size.x;
+			int y = t / size.x;
+			
+			for(std::uint8_t d = 0; d < count; d++)
+			{
+				int nx = x + offsets[d][0];
+				int ny = y + offsets[d][1];
+				
+				if(!map.isInside(nx, ny))
+					continue;
+				
+				// walking back from the neighbor costs entering this tile
+				float step = map.getStepCost(nx, ny, -offsets[d][0], -offsets[d][1]);
+				unsigned next = ny * size.x + nx;
+				
+				// a blocked tile points the way out, but isn't walked through
+				if(!map.isPassable(nx, ny))
+				{
+					if(integration[next] == UNREACHABLE && d < 4)
+					{
+						integration[next] = integration[t] + map.getCost(x, y);
+						directions[next] = d ^ 1;
+					}
+					
+					continue;
+				}
+				
+				if(step == 0 || integration[t] + step >= integration[next])
+					continue;
+				
+				integration[next] = integration[t] + step;
+				directions[next] = d ^ 1;
+				
+				open.emplace_back(integration[next], next);
+				std::push_heap(open.begin(), open.end(), later);
+			}
+		}
+	}
+	
+	sf::Vector2i FlowField::getNext(int x, int y) const
+	{
+		if(x < 0 || y < 0 || x >= static_cast<int>(size.x) || y >= static_cast<int>(size.y))
+			return {x, y};
+		
+		std::uint8_t d = directions[y * size.x + x];
+		
+		if(d == NONE)
+			return {x, y};
+		
+		return {x + offsets[d][0], y + offsets[d][1]};
+	}
+	
+	float FlowField::getCost(int x, int y) const
+	{
+		if(x < 0 || y < 0 || x >= static_cast<int>(size.x) || y >= static_cast<int>(size.y))
+			return UNREACHABLE;
+		
+		return integration[y * size.x + x];
+	}
+	
+	bool FlowField::reaches(int x, int y) const
+	{
+		return getCost(x, y) != UNREACHABLE;
+	}
+	
+	const sf::Vector2i& FlowField::getGoal() const
+	{
+		return goal;
+	}
+	
+	unsigned FlowField::getVersion() const
+	{
+		return version;
+	}
+	
+	std::size_t FlowField::getMemory() const
+	{
+		return integration.capacity() * sizeof(float) + directions.capacity() * sizeof(std::uint8_t);
+	}
+}
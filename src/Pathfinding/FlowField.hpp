@@ -0,0 +1,51 @@
+#ifndef FLOWFIELD_HPP
+#define FLOWFIELD_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+#include "../Mapping/PassabilityMap.hpp"
+
+namespace swift
+{
+	// distances from every tile to one goal tile, and the neighbor to step to from each tile.
+	// any number of entities heading for the same goal can follow one field
+	class FlowField
+	{
+		public:
+			static constexpr float UNREACHABLE = 1e30f;
+			
+			FlowField(const PassabilityMap& map, const sf::Vector2i& goal, unsigned version);
+			
+			// the tile to step to from x, y. The tile itself at the goal, or where the goal can't be reached
+			sf::Vector2i getNext(int x, int y) const;
+			
+			// cost of the way to the goal, UNREACHABLE outside of the map or where there is no path
+			float getCost(int x, int y) const;
+			
+			bool reaches(int x, int y) const;
+			
+			const sf::Vector2i& getGoal() const;
+			
+			// of the layer it was built from
+			unsigned getVersion() const;
+			
+			// bytes held by the field
+			std::size_t getMemory() const;
+			
+		private:
+			// Dijkstra's out from the goal, for maps with costs or diagonal steps
+			void integrate(const PassabilityMap& map);
+			
+			sf::Vector2u size;
+			sf::Vector2i goal;
+			unsigned version;
+			
+			std::vector<float> integration;
+			std::vector<std::uint8_t> directions;	// index into the offsets, NONE if there is no next tile
+	};
+}
+
+#endif // FLOWFIELD_HPP
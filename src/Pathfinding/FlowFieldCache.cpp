@@ -0,0 +1,57 @@
+#include "FlowFieldCache.hpp"
+
+#include "PathCache.hpp"
+
+namespace swift
+{
+	std::shared_ptr<const FlowField> FlowFieldCache::get(unsigned layer, const sf::Vector2i& goal, const TileMap& map)
+	{
+		const Layer* mapLayer = map.getLayer(layer);
+		
+		if(!mapLayer)
+			return nullptr;
+		
+		if(++gets % 256 == 0)
+		{
+			for(auto it = fields.begin(); it != fields.end();)
+			{
+				if(it->second.expired())
+					it = fields.erase(it);
+				else
+					++it;
+			}
+		}
+		
+		std::weak_ptr<const FlowField>& entry = fields[PathCache::goalKey(layer, goal)];
+		std::shared_ptr<const FlowField> field = entry.lock();
+		
+		// entities still holding the old field keep it until they ask again
+		if(!field || field->getVersion() != mapLayer->getVersion())
+		{
+			field = std::make_shared<const FlowField>(mapLayer->getPassability(), goal, mapLayer->getVersion());
+			entry = field;
+		}
+		
+		return field;
+	}
+	
+	bool FlowFieldCache::isStale(const FlowField& field, unsigned layer, const TileMap& map)
+	{
+		const Layer* mapLayer = map.getLayer(layer);
+		
+		return !mapLayer || field.getVersion() != mapLayer->getVersion();
+	}
+	
+	std::size_t FlowFieldCache::size() const
+	{
+		std::size_t count = 0;
+		
+		for(auto& f : fields)
+		{
+			if(!f.second.expired())
+				count++;
+		}
+		
+		return count;
+	}
+}
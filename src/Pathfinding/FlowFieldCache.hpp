@@ -0,0 +1,36 @@
+#ifndef FLOWFIELDCACHE_HPP
+#define FLOWFIELDCACHE_HPP
+
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+
+#include "FlowField.hpp"
+#include "../Mapping/TileMap.hpp"
+
+namespace swift
+{
+	// hands out one shared flow field per layer and goal tile. Fields are freed once the last
+	// entity following them lets go, and rebuilt when their layer changes
+	class FlowFieldCache
+	{
+		public:
+			// nullptr if the layer doesn't exist
+			std::shared_ptr<const FlowField> get(unsigned layer, const sf::Vector2i& goal, const TileMap& map);
+			
+			// true if field was built from an older version of its layer
+			static bool isStale(const FlowField& field, unsigned layer, const TileMap& map);
+			
+			// fields still in use
+			std::size_t size() const;
+			
+		private:
+			// by PathCache::goalKey
+			std::unordered_map<std::uint64_t, std::weak_ptr<const FlowField>> fields;
+			
+			// expired entries are swept every so often, not on every get
+			unsigned gets = 0;
+	};
+}
+
+#endif // FLOWFIELDCACHE_HPP
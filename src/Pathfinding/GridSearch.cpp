@@ -0,0 +1,368 @@
+#include "GridSearch.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace swift
+{
+	namespace
+	{
+		int lowestBit(std::uint64_t bits)
+		{
+#if defined(__GNUC__)
+			return __builtin_ctzll(bits);
+#else
+			int i = 0;
+			while(!(bits & 1))
+			{
+				bits >>= 1;
+				i++;
+			}
+			return i;
+#endif
+		}
+		
+		int highestBit(std::uint64_t bits)
+		{
+#if defined(__GNUC__)
+			return 63 - __builtin_clzll(bits);
+#else
+			int i = 63;
+			while(!(bits >> 63))
+			{
+				bits <<= 1;
+				i--;
+			}
+			return i;
+#endif
+		}
+	}
+	
+	GridSearch::GridSearch()
+	:	stamp(0),
+		width(0),
+		limit(0),
+		octile(false)
+	{
+	}
+	
+	bool GridSearch::find(const PassabilityMap& map, const sf::Vector2i& start, const sf::Vector2i& goal, std::vector<sf::Vector2i>& path, Algorithm algorithm)
+	{
+		path.clear();
+		stats.expanded = 0;
+		
+		if(!map.isInside(start.x, start.y) || !map.isInside(goal.x, goal.y))
+			return false;
+		
+		// the start tile itself doesn't have to be passable, so whatever stands on it can always leave
+		if(start == goal)
+		{
+			path.push_back(start);
+			return true;
+		}
+		
+		if(!map.isPassable(goal.x, goal.y))
+			return false;
+		
+		prepare(map.getSize());
+		octile = map.isDiagonal();
+		
+		relax(start.y * width + start.x, -1, 0, heuristic(start.x, start.y, goal));
+		
+		// jumping relies on every step costing the same, along rows and columns only
+		bool jump = algorithm == Algorithm::JumpPoint && map.isUniform() && !map.isDiagonal();
+		bool found = jump ? searchJumpPoint(map, goal) : searchAStar(map, goal);
+		
+		open.clear();
+		
+		if(!found)
+			return false;
+		
+		// jump points are only linked to the previous jump point, fill in the tiles between them
+		for(int t = goal.y * width + goal.x; t != -1; t = parent[t])
+		{
+			sf::Vector2i tile(t % width, t / width);
+			
+			if(parent[t] != -1)
+			{
+				sf::Vector2i from(parent[t] % width, parent[t] / width);
+				sf::Vector2i step((from.x > tile.x) - (from.x < tile.x), (from.y > tile.y) - (from.y < tile.y));
+				
+				for(; tile != from; tile += step)
+					path.push_back(tile);
+			}
+			else
+				path.push_back(tile);
+		}
+		
+		std::reverse(path.begin(), path.end());
+		
+		return true;
+	}
+	
+	void GridSearch::setExpansionLimit(unsigned l)
+	{
+		limit = l;
+	}
+	
+	const GridSearch::Stats& GridSearch::getStats() const
+	{
+		return stats;
+	}
+	
+	bool GridSearch::searchAStar(const PassabilityMap& map, const sf::Vector2i& goal)
+	{
+		// diagonals last, so 4-connected maps stop before them
+		static const int offsets[8][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}, {-1, -1}, {1, -1}, {-1, 1}, {1, 1}};
+		
+		const unsigned last = goal.y * width + goal.x;
+		const int directions = map.isDiagonal() ? 8 : 4;
+		unsigned current;
+		
+		while(pop(current, goal))
+		{
+			if(current == last)
+				return true;
+			
+			stats.expanded++;
+			
+			if(limit && stats.expanded > limit)
+				return false;
+			
+			int x = current % width;
+			int y = current / width;
+			
+			for(int d = 0; d < directions; d++)
+			{
+				int nx = x + offsets[d][0];
+				int ny = y + offsets[d][1];
+				float step = map.getStepCost(x, y, offsets[d][0], offsets[d][1]);
+				
+				if(step > 0)
+					relax(ny * width + nx, current, cost[current] + step, heuristic(nx, ny, goal));
+			}
+		}
+		
+		return false;
+	}
+	
+	bool GridSearch::searchJumpPoint(const PassabilityMap& map, const sf::Vector2i& goal)
+	{
+		// paths are kept canonical: vertical moves turn sideways anywhere, horizontal moves only turn
+		// where a wall beside them ends (a forced neighbor). Rows are scanned a word at a time off the bitmap
+		const unsigned last = goal.y * width + goal.x;
+		unsigned current;
+		
+		while(pop(current, goal))
+		{
+			if(current == last)
+				return true;
+			
+			stats.expanded++;
+			
+			if(limit && stats.expanded > limit)
+				return false;
+			
+			int x = current % width;
+			int y = current / width;
+			
+			int dx = 0;
+			int dy = 0;
+			
+			if(parent[current] != -1)
+			{
+				int px = parent[current] % width;
+				int py = parent[current] / width;
+				
+				dx = (x > px) - (x < px);
+				dy = (y > py) - (y < py);
+			}
+			
+			auto addRow = [&](int d)
+			{
+				int jx = jumpRow(map, x, y, d, goal);
+				
+				if(jx != -1)
+					relax(y * width + jx, current, cost[current] + std::abs(jx - x), heuristic(jx, y, goal));
+			};
+			
+			auto addColumn = [&](int d)
+			{
+				int jy = jumpColumn(map, x, y, d, goal);
+				
+				if(jy != -1)
+					relax(jy * width + x, current, cost[current] + std::abs(jy - y), heuristic(x, jy, goal));
+			};
+			
+			if(dx != 0)
+			{
+				addRow(dx);
+				
+				// forced, the wall that kept us from turning earlier ends here
+				for(int d = -1; d <= 1; d += 2)
+				{
+					if(isOpen(map, x, y + d) && !isOpen(map, x - dx, y + d))
+						addColumn(d);
+				}
+			}
+			else if(dy != 0)
+			{
+				addColumn(dy);
+				addRow(-1);
+				addRow(1);
+			}
+			else
+			{
+				addRow(-1);
+				addRow(1);
+				addColumn(-1);
+				addColumn(1);
+			}
+		}
+		
+		return false;
+	}
+	
+	int GridSearch::jumpRow(const PassabilityMap& map, int x, int y, int dx, const sf::Vector2i& goal)
+	{
+		int p = x + dx;
+		
+		if(p < 0)
+			return -1;
+		
+		// a tile is forced if the tile beside it is open, but the one before that was blocked
+		// the words before the current one, to carry the tile before each word's first bit
+		int w = p / 64;
+		std::uint64_t lastUp = map.getBlockedWord(y - 1, w - dx);
+		std::uint64_t lastDown = map.getBlockedWord(y + 1, w - dx);
+		
+		for(;; w += dx)
+		{
+			std::uint64_t blocked = map.getBlockedWord(y, w);
+			std::uint64_t up = map.getBlockedWord(y - 1, w);
+			std::uint64_t down = map.getBlockedWord(y + 1, w);
+			
+			std::uint64_t upBefore = dx > 0 ? (up << 1) | (lastUp >> 63) : (up >> 1) | (lastUp << 63);
+			std::uint64_t downBefore = dx > 0 ? (down << 1) | (lastDown >> 63) : (down >> 1) | (lastDown << 63);
+			
+			std::uint64_t stops = blocked | (~up & upBefore) | (~down & downBefore);
+			
+			if(y == goal.y && goal.x / 64 == w)
+				stops |= std::uint64_t(1) << (goal.x % 64);
+			
+			// skip the bits behind p
+			if(w == p / 64)
+			{
+				if(dx > 0)
+					stops &= ~std::uint64_t(0) << (p % 64);
+				else if(p % 64 != 63)
+					stops &= (std::uint64_t(1) << (p % 64 + 1)) - 1;
+			}
+			
+			if(stops)
+			{
+				int bit = dx > 0 ? lowestBit(stops) : highestBit(stops);
+				
+				return (blocked >> bit) & 1 ? -1 : w * 64 + bit;
+			}
+			
+			lastUp = up;
+			lastDown = down;
+		}
+	}
+	
+	int GridSearch::jumpColumn(const PassabilityMap& map, int x, int y, int dy, const sf::Vector2i& goal)
+	{
+		while(true)
+		{
+			y += dy;
+			
+			if(!isOpen(map, x, y))
+				return -1;
+			
+			if(x == goal.x && y == goal.y)
+				return y;
+			
+			// a vertical move may turn sideways anywhere, so stop wherever the row has something to offer
+			if(jumpRow(map, x, y, -1, goal) != -1 || jumpRow(map, x, y, 1, goal) != -1)
+				return y;
+		}
+	}
+	
+	bool GridSearch::isOpen(const PassabilityMap& map, int x, int y)
+	{
+		return map.isInside(x, y) && map.isPassable(x, y);
+	}
+	
+	void GridSearch::prepare(const sf::Vector2u& size)
+	{
+		std::size_t tiles = size.x * size.y;
+		width = size.x;
+		
+		if(stamps.size() < tiles)
+		{
+			cost.resize(tiles);
+			parent.resize(tiles);
+			stamps.resize(tiles, 0);
+		}
+		
+		// wrapped around, start over so old stamps can't match
+		if(++stamp == 0)
+		{
+			std::fill(stamps.begin(), stamps.end(), 0);
+			stamp = 1;
+		}
+		
+		stats.memory = cost.capacity() * sizeof(float) + parent.capacity() * sizeof(int)
+					+ stamps.capacity() * sizeof(std::uint32_t) + open.capacity() * sizeof(Open);
+	}
+	
+	void GridSearch::relax(unsigned tile, int from, float g, float h)
+	{
+		if(!isFresh(tile) && cost[tile] <= g)
+			return;
+		
+		stamps[tile] = stamp;
+		cost[tile] = g;
+		parent[tile] = from;
+		
+		open.push_back({g + h, tile});
+		std::push_heap(open.begin(), open.end());
+	}
+	
+	bool GridSearch::pop(unsigned& tile, const sf::Vector2i& goal)
+	{
+		while(!open.empty())
+		{
+			std::pop_heap(open.begin(), open.end());
+			Open top = open.back();
+			open.pop_back();
+			
+			// stale entry, the tile was reached more cheaply since it was pushed
+			if(top.f > cost[top.tile] + heuristic(top.tile % width, top.tile / width, goal))
+				continue;
+			
+			tile = top.tile;
+			return true;
+		}
+		
+		return false;
+	}
+	
+	bool GridSearch::isFresh(unsigned tile) const
+	{
+		return stamps[tile] != stamp;
+	}
+	
+	float GridSearch::heuristic(int x, int y, const sf::Vector2i& goal) const
+	{
+		float dx = static_cast<float>(std::abs(goal.x - x));
+		float dy = static_cast<float>(std::abs(goal.y - y));
+		
+		// same as PassabilityMap::estimate, without a call per tile
+		if(octile)
+			return std::max(dx, dy) + 0.41421356f * std::min(dx, dy);
+		
+		return dx + dy;
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef GRIDSEARCH_HPP
+#define GRIDSEARCH_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+#include "../Mapping/PassabilityMap.hpp"
+
+namespace swift
+{
+	// shortest paths over the tiles of a PassabilityMap, 4-connected, or 8-connected on diagonal maps.
+	// all per-tile state lives in flat arrays that are kept between searches,
+	// and reset lazily with a stamp, so repeated searches don't allocate
+	class GridSearch
+	{
+		public:
+			enum class Algorithm
+			{
+				AStar,
+				JumpPoint,	// same paths as AStar, but skips along open rows and columns. Much faster on open maps.
+							// only for 4-connected maps of uniform cost, runs as AStar on any other
+				Hierarchical,	// searched by a layer's ClusterGraph in Path. find runs it as AStar
+				FlowField,		// followed through a shared FlowField by PathfinderSystem. find runs it as AStar
+			};
+			
+			struct Stats
+			{
+				unsigned expanded = 0;
+				std::size_t memory = 0;		// bytes held by the search arrays
+			};
+			
+			GridSearch();
+			
+			// fills path with the tiles from start to goal, both included.
+			// returns false, leaving path empty, if there is no path.
+			// tiles outside the map are never walked through
+			bool find(const PassabilityMap& map, const sf::Vector2i& start, const sf::Vector2i& goal, std::vector<sf::Vector2i>& path, Algorithm algorithm = Algorithm::AStar);
+			
+			// searches give up, finding no path, after expanding this many tiles. 0 for no limit
+			void setExpansionLimit(unsigned limit);
+			
+			// of the last search
+			const Stats& getStats() const;
+			
+		private:
+			struct Open
+			{
+				float f;
+				unsigned tile;
+				
+				// std heaps are max heaps, so this orders the smallest f first
+				bool operator<(const Open& other) const
+				{
+					return f > other.f;
+				}
+			};
+			
+			bool searchAStar(const PassabilityMap& map, const sf::Vector2i& goal);
+			bool searchJumpPoint(const PassabilityMap& map, const sf::Vector2i& goal);
+			
+			// the next jump point from x along row y, going dx. -1 if there is none
+			static int jumpRow(const PassabilityMap& map, int x, int y, int dx, const sf::Vector2i& goal);
+			
+			// the next jump point from y along column x, going dy. -1 if there is none
+			static int jumpColumn(const PassabilityMap& map, int x, int y, int dy, const sf::Vector2i& goal);
+			
+			static bool isOpen(const PassabilityMap& map, int x, int y);
+			
+			void prepare(const sf::Vector2u& size);
+			
+			// records a way to reach tile for cost g, if it is the cheapest yet
+			void relax(unsigned tile, int from, float g, float h);
+			
+			// pops the open tile with the smallest f, skipping stale entries. False if there are none left
+			bool pop(unsigned& tile, const sf::Vector2i& goal);
+			
+			// true if the tile hasn't been touched this search
+			bool isFresh(unsigned tile) const;
+			
+			float heuristic(int x, int y, const sf::Vector2i& goal) const;
+			
+			std::vector<float> cost;
+			std::vector<int> parent;
+			std::vector<std::uint32_t> stamps;
+			std::vector<Open> open;
+			
+			std::uint32_t stamp;
+			unsigned width;
+			unsigned limit;
+			bool octile;	// the heuristic of the map being searched, diagonal or not
+			
+			Stats stats;
+	};
+}
+
+#endif // GRIDSEARCH_HPP
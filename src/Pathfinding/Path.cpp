@@ -1,123 +1,211 @@
 #include "Path.hpp"
 
-#include "../Math/Math.hpp"
-
 #include <vector>
-#include <algorithm>
+#include <cmath>
 
 namespace swift
 {
-	Path::Path(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map)
-		:	pathFound(false)
+	Path::Path(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map, GridSearch::Algorithm algorithm)
 	{
-		calculate(start, end, layer, map);
+		calculate(start, end, layer, map, algorithm);
 	}
 
+	Path::Path(const sf::Vector2f& start, const sf::Vector2f& end, const PassabilityMap& grid, const sf::Vector2u& tileSize, GridSearch::Algorithm algorithm)
+	{
+		calculate(start, end, grid, tileSize, algorithm);
+	}
+	
+	Path::Path(const sf::Vector2f& start, const std::vector<sf::Vector2i>& t, const sf::Vector2u& tileSize)
+	:	tiles(t)
+	{
+		if(tiles.empty())
+			return;
+		
+		nodes.push_back(start);
+		
+		for(auto& tile : tiles)
+			nodes.push_back(getTileCenter(tile, tileSize));
+	}
+	
 	const Path::PathNodes& Path::getNodes() const
 	{
 		return nodes;
 	}
-
-	void Path::calculate(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map)
+	
+	const std::vector<sf::Vector2i>& Path::getTiles() const
 	{
-		sf::Vector2u tileSize = map.getTileSize();
-
-		std::vector<sf::Vector2u> visited;
-
-		nodes.push_back(start);
-		visited.push_back({static_cast<unsigned int>(start.x / tileSize.x), static_cast<unsigned int>(start.y / tileSize.y)});
-
-		sf::Vector2f center = getTileCenter(nodes.back().getPosition(), tileSize);
-
-		nodes.push_back(center);
-		visited.push_back({static_cast<unsigned int>(center.x / tileSize.x), static_cast<unsigned int>(center.y / tileSize.y)});
-
-		buildPathMap(center, end, nodes, visited, layer, map);
-
-		if(!pathFound)
-			nodes.clear();
-		else
+		return tiles;
+	}
+	
+	const Path::Waypoints& Path::getWaypoints() const
+	{
+		return waypoints;
+	}
+	
+	bool Path::refine(Waypoints& waypoints, std::vector<sf::Vector2i>& segment, unsigned int layer, const TileMap& map)
+	{
+		segment.clear();
+		
+		const Layer* mapLayer = map.getLayer(layer);
+		
+		if(waypoints.size() < 2 || !mapLayer)
 		{
-			// find the path with the smallest distance, set the nodes to it
-			nodes = *std::min_element(possiblePaths.begin(), possiblePaths.end(), [](const PathNodes& one, const PathNodes& two)
-			{
-				float oneTotal = 0;
-				for(unsigned int i = 0; i < one.size() - 1; i++)
-				{
-					oneTotal += math::distance(one[i + 1].getPosition(), one[i].getPosition());
-				}
-
-				float twoTotal = 0;
-				for(unsigned int i = 0; i < two.size() - 1; i++)
-				{
-					twoTotal += math::distance(two[i + 1].getPosition(), two[i].getPosition());
-				}
-
-				return oneTotal < twoTotal;
-			});
+			waypoints.clear();
+			return mapLayer != nullptr;
 		}
+		
+		if(!mapLayer->getClusters().refine(mapLayer->getPassability(), waypoints[0], waypoints[1], segment))
+			return false;
+		
+		waypoints.pop_front();
+		
+		// the last waypoint is the goal, nothing comes after it
+		if(waypoints.size() == 1)
+			waypoints.clear();
+		
+		return true;
 	}
-
-	void Path::buildPathMap(const sf::Vector2f& center, const sf::Vector2f& end, const PathNodes& path, std::vector<sf::Vector2u> visited, unsigned int layer, const TileMap& map)
+	
+	void Path::smooth(std::vector<sf::Vector2i>& tiles, const PassabilityMap& grid)
 	{
-		sf::Vector2u tileSize = map.getTileSize();
-
-		// check if we've reached the end (in the same tile as the end position
-		if(math::distanceSquared(path.back().getPosition(), getTileCenter(end, tileSize)) <= tileSize.x * tileSize.x / 4.f)
-		{
-			// if so, add path to the list of possible paths and return
-			possiblePaths.push_back(path);
-			pathFound = true;
+		if(tiles.size() < 3)
 			return;
-		}
-
-		struct NewNode
+		
+		// greedy: from each kept tile, go as far along the path as can be seen
+		std::size_t kept = 0;
+		std::size_t from = 0;
+		
+		while(from + 1 < tiles.size())
 		{
-			sf::Vector2f position;
-			const Tile* tile;
-			PathNodes path;
-		};
-
-		std::vector<NewNode> neighbors;
-		std::vector<NewNode> validNeighbors;
-
-		neighbors.emplace_back();	// top
-		neighbors.emplace_back();	// bottom
-		neighbors.emplace_back();	// left
-		neighbors.emplace_back();	// right
-
-		neighbors[0].position = {center - sf::Vector2f(0, tileSize.y)};
-		neighbors[1].position = {center + sf::Vector2f(0, tileSize.y)};
-		neighbors[2].position = {center - sf::Vector2f(tileSize.x, 0)};
-		neighbors[3].position = {center + sf::Vector2f(tileSize.x, 0)};
+			std::size_t to = from + 1;
+			
+			while(to + 1 < tiles.size() && grid.isLineClear(tiles[from], tiles[to + 1]))
+				to++;
+			
+			tiles[++kept] = tiles[to];
+			from = to;
+		}
+		
+		tiles.resize(kept + 1);
+	}
 
-		// check if positions are valid tiles, if they are passable, and if they haven't already been visited
-		// if so, add them to the neighbors vector
-		// also, save copying until now. Less copying that way
-		for(auto& n : neighbors)
+	bool Path::repair(CompactPath& path, const sf::Vector2i& from, const PassabilityMap& grid, unsigned limit)
+	{
+		// one per thread, as paths are repaired by systems running in parallel
+		static thread_local GridSearch search;
+		static thread_local std::vector<sf::Vector2i> route;
+		static thread_local std::vector<sf::Vector2i> repaired;
+		static thread_local std::vector<sf::Vector2i> detour;
+		
+		route.clear();
+		route.push_back(from);
+		
+		for(std::size_t i = path.getCursor(); i < path.size(); i++)
+			route.push_back(path.get(i));
+		
+		repaired.clear();
+		repaired.push_back(from);
+		
+		search.setExpansionLimit(limit);
+		
+		bool changed = false;
+		std::size_t i = 0;
+		
+		while(i + 1 < route.size())
 		{
-			n.tile = map.getTile(n.position, layer);
-
-			sf::Vector2u tilePos = {static_cast<unsigned int>(n.position.x / tileSize.x), static_cast<unsigned int>(n.position.y / tileSize.y)};
-
-			if(n.tile && n.tile->isPassable() && std::find(visited.begin(), visited.end(), tilePos) == visited.end())
+			if(grid.isLineClear(route[i], route[i + 1]))
 			{
-				n.path = path;
-				n.path.push_back(n.position);
-				validNeighbors.push_back(n);
-				visited.push_back(tilePos);
+				repaired.push_back(route[++i]);
+				continue;
 			}
+			
+			// rejoins at the first tile after the break that's still open
+			std::size_t j = i + 1;
+			
+			while(j + 1 < route.size() && !grid.isPassable(route[j].x, route[j].y))
+				j++;
+			
+			if(!search.find(grid, route[i], route[j], detour))
+				return false;
+			
+			smooth(detour, grid);
+			repaired.insert(repaired.end(), detour.begin() + 1, detour.end());
+			
+			changed = true;
+			i = j;
 		}
+		
+		// untouched paths keep their place
+		if(changed)
+		{
+			repaired.erase(repaired.begin());
+			path.assign(repaired);
+		}
+		
+		return true;
+	}
 
-		// recursive across all valid neighbors
-		for(auto& n : validNeighbors)
+	void Path::calculate(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map, GridSearch::Algorithm algorithm)
+	{
+		const Layer* mapLayer = map.getLayer(layer);
+		
+		if(!mapLayer)
+			return;
+		
+		sf::Vector2u tileSize = map.getTileSize();
+		
+		// falls back to a full search if the layer has no graph
+		if(algorithm == GridSearch::Algorithm::Hierarchical && mapLayer->getClusters().isBuilt())
 		{
-			buildPathMap(n.position, end, n.path, visited, layer, map);
+			// one per thread, so its buffers are reused between paths
+			static thread_local std::vector<sf::Vector2i> found;
+			
+			if(!mapLayer->getClusters().find(mapLayer->getPassability(), getTile(start, tileSize), getTile(end, tileSize), found))
+				return;
+			
+			waypoints.assign(found.begin(), found.end());
+			
+			sf::Vector2i first = waypoints.front();
+			
+			if(!refine(waypoints, tiles, layer, map))
+			{
+				tiles.clear();
+				waypoints.clear();
+				return;
+			}
+			
+			tiles.insert(tiles.begin(), first);
+			
+			nodes.push_back(start);
+			
+			for(auto& t : tiles)
+				nodes.push_back(getTileCenter(t, tileSize));
 		}
+		else
+			calculate(start, end, mapLayer->getPassability(), tileSize, algorithm);
+	}
+	
+	void Path::calculate(const sf::Vector2f& start, const sf::Vector2f& end, const PassabilityMap& grid, const sf::Vector2u& tileSize, GridSearch::Algorithm algorithm)
+	{
+		// one per thread, so its buffers are reused between paths
+		static thread_local GridSearch search;
+		
+		if(!search.find(grid, getTile(start, tileSize), getTile(end, tileSize), tiles, algorithm))
+			return;
+		
+		nodes.push_back(start);
+		
+		for(auto& t : tiles)
+			nodes.push_back(getTileCenter(t, tileSize));
+	}
+
+	sf::Vector2i Path::getTile(const sf::Vector2f& pos, const sf::Vector2u& tileSize)
+	{
+		return {static_cast<int>(std::floor(pos.x / tileSize.x)), static_cast<int>(std::floor(pos.y / tileSize.y))};
 	}
 
-	sf::Vector2f Path::getTileCenter(const sf::Vector2f& pos, const sf::Vector2u& tileSize)
+	sf::Vector2f Path::getTileCenter(const sf::Vector2i& tile, const sf::Vector2u& tileSize)
 	{
-		return {static_cast<unsigned int>(pos.x / tileSize.x) * tileSize.x + tileSize.x / 2.f, static_cast<unsigned int>(pos.y / tileSize.y) * tileSize.y + tileSize.y / 2.f};
+		return {tile.x * static_cast<float>(tileSize.x) + tileSize.x / 2.f, tile.y * static_cast<float>(tileSize.y) + tileSize.y / 2.f};
 	}
 }
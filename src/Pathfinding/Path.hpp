@@ -2,10 +2,13 @@
 #define PATH_H
 
 #include <deque>
+#include <vector>
 
 #include <SFML/System/Vector2.hpp>
 #include "../Mapping/TileMap.hpp"
 #include "Node.hpp"
+#include "GridSearch.hpp"
+#include "CompactPath.hpp"
 
 namespace swift
 {
@@ -13,23 +16,50 @@ namespace swift
 	{
 		public:
 			using PathNodes = std::deque<Node>;
+			using Waypoints = std::deque<sf::Vector2i>;
 			
-			Path(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map);
+			// nodes are the start position, followed by the center of each tile on the way to end.
+			// empty if end can't be reached.
+			// Hierarchical paths only hold the nodes up to the first waypoint, use refine for the rest
+			Path(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map, GridSearch::Algorithm algorithm = GridSearch::Algorithm::AStar);
+			
+			// searches grid directly, without a TileMap. Hierarchical runs as AStar, as there is no cluster graph
+			Path(const sf::Vector2f& start, const sf::Vector2f& end, const PassabilityMap& grid, const sf::Vector2u& tileSize, GridSearch::Algorithm algorithm = GridSearch::Algorithm::AStar);
+			
+			// nodes along tiles, a path found earlier
+			Path(const sf::Vector2f& start, const std::vector<sf::Vector2i>& tiles, const sf::Vector2u& tileSize);
 			
 			const PathNodes& getNodes() const;
 			
-		private:
-			void calculate(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map);
+			// every tile from start to end. Hierarchical paths only up to the first waypoint
+			const std::vector<sf::Vector2i>& getTiles() const;
 			
-			void buildPathMap(const sf::Vector2f& center, const sf::Vector2f& end, const PathNodes& path, std::vector<sf::Vector2u> visited, unsigned int layer, const TileMap& map);
+			// tiles left to refine, the first of them is the last tile
+			const Waypoints& getWaypoints() const;
 			
-			static sf::Vector2f getTileCenter(const sf::Vector2f& pos, const sf::Vector2u& tileSize);
+			// fills segment with the tiles to the next waypoint, its first waypoint excluded, and drops that waypoint.
+			// false if the map changed so it can't be reached anymore
+			static bool refine(Waypoints& waypoints, std::vector<sf::Vector2i>& segment, unsigned int layer, const TileMap& map);
 			
-			PathNodes nodes;
+			// string pulling, drops every tile that can be skipped by walking in a straight line.
+			// the first and last tiles stay
+			static void smooth(std::vector<sf::Vector2i>& tiles, const PassabilityMap& grid);
 			
-			std::vector<PathNodes> possiblePaths;
+			// fixes what's left of path, walked from tile from, after grid changed. Each stretch that got
+			// blocked is searched around, from the tile before it to the first open tile after it, leaving the rest as is.
+			// false if a detour takes more than limit expanded tiles, or there is none, so a full search is needed
+			static bool repair(CompactPath& path, const sf::Vector2i& from, const PassabilityMap& grid, unsigned limit = 4096);
 			
-			bool pathFound;
+			static sf::Vector2i getTile(const sf::Vector2f& pos, const sf::Vector2u& tileSize);
+			static sf::Vector2f getTileCenter(const sf::Vector2i& tile, const sf::Vector2u& tileSize);
+			
+		private:
+			void calculate(const sf::Vector2f& start, const sf::Vector2f& end, unsigned int layer, const TileMap& map, GridSearch::Algorithm algorithm);
+			void calculate(const sf::Vector2f& start, const sf::Vector2f& end, const PassabilityMap& grid, const sf::Vector2u& tileSize, GridSearch::Algorithm algorithm);
+			
+			PathNodes nodes;
+			Waypoints waypoints;
+			std::vector<sf::Vector2i> tiles;
 	};
 }
 
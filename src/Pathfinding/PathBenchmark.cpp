@@ -0,0 +1,360 @@
+#include "PathBenchmark.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <SFML/System/Clock.hpp>
+
+#include "ClusterGraph.hpp"
+#include "FlowField.hpp"
+#include "../Noise/OpenSimplexNoise.hpp"
+#include "../Logger/Logger.hpp"
+
+namespace swift
+{
+	namespace
+	{
+		const PathBenchmark::MapType mapTypes[] = {PathBenchmark::MapType::Open, PathBenchmark::MapType::Maze, PathBenchmark::MapType::Rooms, PathBenchmark::MapType::Noise};
+		const GridSearch::Algorithm algorithms[] = {GridSearch::Algorithm::AStar, GridSearch::Algorithm::JumpPoint, GridSearch::Algorithm::Hierarchical, GridSearch::Algorithm::FlowField};
+	}
+	
+	PathBenchmark::PathBenchmark(unsigned s)
+	:	seed(s)
+	{
+	}
+	
+	void PathBenchmark::generate(MapType type, unsigned size, PassabilityMap& map) const
+	{
+		map.resize({size, size});
+		
+		std::mt19937 rng(seed + size * 4 + static_cast<unsigned>(type));
+		
+		switch(type)
+		{
+			case MapType::Open:
+				break;
+			
+			case MapType::Maze:
+			{
+				// cells on the odd tiles, carved out depth first, the walls between them on the even ones
+				for(unsigned y = 0; y < size; y++)
+					for(unsigned x = 0; x < size; x++)
+						map.setPassable(x, y, false);
+				
+				int cells = std::max<int>((size - 1) / 2, 1);
+				std::vector<bool> visited(cells * cells, false);
+				std::vector<sf::Vector2i> stack = {{0, 0}};
+				
+				visited[0] = true;
+				map.setPassable(1, 1, true);
+				
+				while(!stack.empty())
+				{
+					sf::Vector2i cell = stack.back();
+					
+					sf::Vector2i options[4];
+					int count = 0;
+					
+					static const sf::Vector2i dirs[4] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+					
+					for(auto& d : dirs)
+					{
+						sf::Vector2i next = cell + d;
+						
+						if(next.x >= 0 && next.y >= 0 && next.x < cells && next.y < cells && !visited[next.y * cells + next.x])
+							options[count++] = next;
+					}
+					
+					if(count == 0)
+					{
+						stack.pop_back();
+						continue;
+					}
+					
+					sf::Vector2i next = options[rng() % count];
+					visited[next.y * cells + next.x] = true;
+					
+					// the wall between, and the cell
+					map.setPassable(cell.x + next.x + 1, cell.y + next.y + 1, true);
+					map.setPassable(next.x * 2 + 1, next.y * 2 + 1, true);
+					
+					stack.push_back(next);
+				}
+				
+				break;
+			}
+			
+			case MapType::Rooms:
+			{
+				// rooms 16 tiles on a side, with a door through each wall to the right and below
+				const unsigned room = 16;
+				
+				for(unsigned y = 0; y < size; y++)
+					for(unsigned x = 0; x < size; x++)
+						map.setPassable(x, y, x % room != 0 && y % room != 0);
+				
+				for(unsigned y = 0; y < size; y += room)
+				{
+					for(unsigned x = 0; x < size; x += room)
+					{
+						map.setPassable(x + room, y + 1 + rng() % (room - 1), true);
+						map.setPassable(x + 1 + rng() % (room - 1), y + room, true);
+					}
+				}
+				
+				break;
+			}
+			
+			case MapType::Noise:
+			{
+				OpenSimplexNoise noise(seed);
+				
+				std::vector<float> values(size * size);
+				noise.evaluateGrid(values.data(), size, size, 0, 0, 1 / 12.f);
+				
+				for(unsigned y = 0; y < size; y++)
+					for(unsigned x = 0; x < size; x++)
+						map.setPassable(x, y, values[y * size + x] < 0.35f);
+				
+				break;
+			}
+		}
+	}
+	
+	void PathBenchmark::run(const std::vector<unsigned>& sizes, unsigned queries)
+	{
+		results.clear();
+		
+		PassabilityMap map;
+		
+		for(auto& size : sizes)
+		{
+			for(auto& type : mapTypes)
+			{
+				generate(type, size, map);
+				
+				for(auto& algorithm : algorithms)
+					results.push_back(measure(map, type, algorithm, queries));
+			}
+		}
+	}
+	
+	const std::vector<PathBenchmark::Result>& PathBenchmark::getResults() const
+	{
+		return results;
+	}
+	
+	bool PathBenchmark::save(const std::string& file) const
+	{
+		std::ofstream fout(file);
+		
+		if(!fout)
+		{
+			SWIFT_ERROR(Pathfinding, "Could not write pathfinding benchmark to \"" << file << "\".\n");
+			return false;
+		}
+		
+		fout << "map,size,algorithm,queries,found,expanded,microseconds,memory\n";
+		
+		for(auto& r : results)
+		{
+			fout << getName(r.map) << ',' << r.size << ',' << getName(r.algorithm) << ',' << r.queries << ',' << r.found << ','
+				<< r.expanded << ',' << r.microseconds << ',' << r.memory << '\n';
+		}
+		
+		return true;
+	}
+	
+	unsigned PathBenchmark::compare(const std::string& file, float tolerance) const
+	{
+		std::ifstream fin(file);
+		
+		if(!fin)
+		{
+			SWIFT_WARNING(Pathfinding, "No pathfinding benchmark to compare with at \"" << file << "\".\n");
+			return 0;
+		}
+		
+		unsigned regressions = 0;
+		std::string line;
+		
+		// the header
+		std::getline(fin, line);
+		
+		while(std::getline(fin, line))
+		{
+			std::istringstream iss(line);
+			std::vector<std::string> fields;
+			std::string field;
+			
+			while(std::getline(iss, field, ','))
+				fields.push_back(field);
+			
+			if(fields.size() != 8)
+				continue;
+			
+			unsigned size = std::stoul(fields[1]);
+			float expanded = std::stof(fields[5]);
+			float microseconds = std::stof(fields[6]);
+			
+			for(auto& r : results)
+			{
+				if(getName(r.map) != fields[0] || r.size != size || getName(r.algorithm) != fields[2])
+					continue;
+				
+				std::string name = getName(r.map) + " " + std::to_string(r.size) + " " + getName(r.algorithm);
+				
+				if(r.microseconds > microseconds * (1 + tolerance))
+				{
+					SWIFT_WARNING(Pathfinding, "Pathfinding regression: " << name << " took " << r.microseconds << " us per query, was " << microseconds << ".\n");
+					regressions++;
+				}
+				
+				if(r.expanded > expanded * (1 + tolerance))
+				{
+					SWIFT_WARNING(Pathfinding, "Pathfinding regression: " << name << " expanded " << r.expanded << " per query, was " << expanded << ".\n");
+					regressions++;
+				}
+			}
+		}
+		
+		return regressions;
+	}
+	
+	std::string PathBenchmark::getName(MapType type)
+	{
+		switch(type)
+		{
+			case MapType::Open:
+				return "open";
+			case MapType::Maze:
+				return "maze";
+			case MapType::Rooms:
+				return "rooms";
+			case MapType::Noise:
+				return "noise";
+		}
+		
+		return "";
+	}
+	
+	std::string PathBenchmark::getName(GridSearch::Algorithm algorithm)
+	{
+		switch(algorithm)
+		{
+			case GridSearch::Algorithm::AStar:
+				return "astar";
+			case GridSearch::Algorithm::JumpPoint:
+				return "jps";
+			case GridSearch::Algorithm::Hierarchical:
+				return "hpa";
+			case GridSearch::Algorithm::FlowField:
+				return "flow";
+		}
+		
+		return "";
+	}
+	
+	PathBenchmark::Result PathBenchmark::measure(const PassabilityMap& map, MapType type, GridSearch::Algorithm algorithm, unsigned queries) const
+	{
+		Result result = {type, map.getSize().x, algorithm, queries, 0, 0, 0, 0};
+		
+		// the same pairs for every algorithm
+		std::mt19937 rng(seed + map.getSize().x + static_cast<unsigned>(type));
+		
+		GridSearch search;
+		ClusterGraph graph;
+		
+		if(algorithm == GridSearch::Algorithm::Hierarchical)
+			graph.build(map);
+		
+		std::vector<sf::Vector2i> tiles;
+		std::vector<sf::Vector2i> segment;
+		sf::Clock clock;
+		
+		double expanded = 0;
+		double microseconds = 0;
+		double memory = 0;
+		
+		for(unsigned q = 0; q < queries; q++)
+		{
+			sf::Vector2i start = pick(map, rng);
+			sf::Vector2i goal = pick(map, rng);
+			bool found = false;
+			
+			clock.restart();
+			
+			switch(algorithm)
+			{
+				case GridSearch::Algorithm::AStar:
+				case GridSearch::Algorithm::JumpPoint:
+					found = search.find(map, start, goal, tiles, algorithm);
+					microseconds += clock.getElapsedTime().asMicroseconds();
+					
+					expanded += search.getStats().expanded;
+					memory += search.getStats().memory;
+					break;
+				
+				case GridSearch::Algorithm::Hierarchical:
+				{
+					// refined all the way, to compare with the searches that give every tile
+					found = graph.find(map, start, goal, tiles);
+					
+					for(std::size_t i = 1; found && i < tiles.size(); i++)
+						found = graph.refine(map, tiles[i - 1], tiles[i], segment);
+					
+					microseconds += clock.getElapsedTime().asMicroseconds();
+					
+					expanded += graph.getExpanded();
+					memory += graph.getMemory();
+					break;
+				}
+				
+				case GridSearch::Algorithm::FlowField:
+				{
+					FlowField field(map, goal, 0);
+					microseconds += clock.getElapsedTime().asMicroseconds();
+					
+					found = field.reaches(start.x, start.y);
+					
+					// every tile the field reached was expanded
+					for(unsigned y = 0; y < map.getSize().y; y++)
+						for(unsigned x = 0; x < map.getSize().x; x++)
+							expanded += field.reaches(x, y);
+					
+					memory += field.getMemory();
+					break;
+				}
+			}
+			
+			result.found += found;
+		}
+		
+		if(queries != 0)
+		{
+			result.expanded = static_cast<float>(expanded / queries);
+			result.microseconds = static_cast<float>(microseconds / queries);
+			result.memory = static_cast<std::size_t>(memory / queries);
+		}
+		
+		return result;
+	}
+	
+	sf::Vector2i PathBenchmark::pick(const PassabilityMap& map, std::mt19937& rng)
+	{
+		const sf::Vector2u& size = map.getSize();
+		sf::Vector2i tile;
+		
+		// gives up eventually on maps that are almost all walls
+		for(int tries = 0; tries < 1000; tries++)
+		{
+			tile = {static_cast<int>(rng() % size.x), static_cast<int>(rng() % size.y)};
+			
+			if(map.isPassable(tile.x, tile.y))
+				break;
+		}
+		
+		return tile;
+	}
+}
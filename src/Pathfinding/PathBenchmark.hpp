@@ -0,0 +1,69 @@
+#ifndef PATHBENCHMARK_HPP
+#define PATHBENCHMARK_HPP
+
+#include <vector>
+#include <string>
+#include <random>
+
+#include "../Mapping/PassabilityMap.hpp"
+#include "GridSearch.hpp"
+
+namespace swift
+{
+	// times every pathfinding backend on generated maps, so changes to them can be measured.
+	// maps and queries come from the seed, so runs with the same seed search the same paths
+	class PathBenchmark
+	{
+		public:
+			enum class MapType
+			{
+				Open,
+				Maze,
+				Rooms,
+				Noise,		// blobs of walls from OpenSimplexNoise
+			};
+			
+			struct Result
+			{
+				MapType map;
+				unsigned size;
+				GridSearch::Algorithm algorithm;
+				unsigned queries;
+				unsigned found;			// queries that had a path
+				float expanded;			// per query, tiles, or graph nodes for Hierarchical
+				float microseconds;		// per query. Building a Hierarchical graph isn't counted
+				std::size_t memory;		// bytes held by the backend after a query, on average
+			};
+			
+			explicit PathBenchmark(unsigned seed = 0);
+			
+			// fills map, size tiles on a side
+			void generate(MapType type, unsigned size, PassabilityMap& map) const;
+			
+			// queries random start and goal pairs on every map type and size, with every algorithm
+			void run(const std::vector<unsigned>& sizes = {64, 256, 1024, 2048}, unsigned queries = 16);
+			
+			const std::vector<Result>& getResults() const;
+			
+			// one line per result, comma separated, with a header line
+			bool save(const std::string& file) const;
+			
+			// logs a warning for each result that is slower or expands more than an earlier run
+			// saved to file did, by more than tolerance (0.1 = 10%). Returns how many that was
+			unsigned compare(const std::string& file, float tolerance = 0.1f) const;
+			
+			static std::string getName(MapType type);
+			static std::string getName(GridSearch::Algorithm algorithm);
+		
+		private:
+			Result measure(const PassabilityMap& map, MapType type, GridSearch::Algorithm algorithm, unsigned queries) const;
+			
+			// a random passable tile
+			static sf::Vector2i pick(const PassabilityMap& map, std::mt19937& rng);
+			
+			unsigned seed;
+			std::vector<Result> results;
+	};
+}
+
+#endif // PATHBENCHMARK_HPP
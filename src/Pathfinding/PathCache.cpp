@@ -0,0 +1,148 @@
+#include "PathCache.hpp"
+
+#include <algorithm>
+
+namespace swift
+{
+	PathCache::PathCache(std::size_t c)
+	:	capacity(c),
+		hits(0),
+		partialHits(0),
+		misses(0)
+	{
+	}
+	
+	bool PathCache::find(unsigned layer, unsigned version, const sf::Vector2i& start, const sf::Vector2i& goal, Tiles& tiles)
+	{
+		auto it = index.find({layer, start, goal});
+		
+		if(it != index.end())
+		{
+			if(it->second->version == version)
+			{
+				// most recently used goes to the front
+				entries.splice(entries.begin(), entries, it->second);
+				tiles = it->second->tiles;
+				hits++;
+				return true;
+			}
+			
+			erase(it->second);
+		}
+		
+		// every part of a shortest path is a shortest path too, so the rest of one from start on works
+		auto goalIt = byGoal.find(goalKey(layer, goal));
+		
+		if(goalIt != byGoal.end())
+		{
+			for(auto& e : goalIt->second)
+			{
+				if(e->version != version)
+					continue;
+				
+				auto from = std::find(e->tiles.begin(), e->tiles.end(), start);
+				
+				if(from != e->tiles.end())
+				{
+					entries.splice(entries.begin(), entries, e);
+					tiles.assign(from, e->tiles.end());
+					partialHits++;
+					return true;
+				}
+			}
+		}
+		
+		misses++;
+		return false;
+	}
+	
+	void PathCache::store(unsigned layer, unsigned version, const Tiles& tiles)
+	{
+		if(tiles.empty() || capacity == 0)
+			return;
+		
+		Key key = {layer, tiles.front(), tiles.back()};
+		
+		auto it = index.find(key);
+		
+		if(it != index.end())
+			erase(it->second);
+		
+		entries.push_front({key, version, tiles});
+		index.emplace(key, entries.begin());
+		byGoal[goalKey(layer, key.goal)].push_back(entries.begin());
+		
+		while(entries.size() > capacity)
+			erase(std::prev(entries.end()));
+	}
+	
+	void PathCache::clear()
+	{
+		entries.clear();
+		index.clear();
+		byGoal.clear();
+	}
+	
+	void PathCache::setCapacity(std::size_t c)
+	{
+		capacity = c;
+		
+		while(entries.size() > capacity)
+			erase(std::prev(entries.end()));
+	}
+	
+	std::size_t PathCache::size() const
+	{
+		return entries.size();
+	}
+	
+	unsigned PathCache::getHits() const
+	{
+		return hits;
+	}
+	
+	unsigned PathCache::getPartialHits() const
+	{
+		return partialHits;
+	}
+	
+	unsigned PathCache::getMisses() const
+	{
+		return misses;
+	}
+	
+	std::size_t PathCache::KeyHash::operator()(const Key& key) const
+	{
+		std::uint64_t h = key.layer;
+		h = h * 0x9e3779b97f4a7c15ull + static_cast<std::uint32_t>(key.start.x);
+		h = h * 0x9e3779b97f4a7c15ull + static_cast<std::uint32_t>(key.start.y);
+		h = h * 0x9e3779b97f4a7c15ull + static_cast<std::uint32_t>(key.goal.x);
+		h = h * 0x9e3779b97f4a7c15ull + static_cast<std::uint32_t>(key.goal.y);
+		
+		return static_cast<std::size_t>(h ^ (h >> 32));
+	}
+	
+	std::uint64_t PathCache::goalKey(unsigned layer, const sf::Vector2i& goal)
+	{
+		// 16 bits for the layer, 24 per coordinate
+		return (static_cast<std::uint64_t>(layer & 0xffff) << 48) | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(goal.y) & 0xffffff) << 24)
+				| (static_cast<std::uint32_t>(goal.x) & 0xffffff);
+	}
+	
+	void PathCache::erase(Entries::iterator it)
+	{
+		auto goalIt = byGoal.find(goalKey(it->key.layer, it->key.goal));
+		
+		if(goalIt != byGoal.end())
+		{
+			auto& list = goalIt->second;
+			list.erase(std::remove(list.begin(), list.end(), it), list.end());
+			
+			if(list.empty())
+				byGoal.erase(goalIt);
+		}
+		
+		index.erase(it->key);
+		entries.erase(it);
+	}
+}
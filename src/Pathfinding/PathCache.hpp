@@ -0,0 +1,83 @@
+#ifndef PATHCACHE_HPP
+#define PATHCACHE_HPP
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+namespace swift
+{
+	// least recently used cache of tile paths, by layer, start tile and goal tile.
+	// entries remember the layer version they were found on, and are only used while it still matches.
+	// not thread safe, callers lock around it
+	class PathCache
+	{
+		public:
+			using Tiles = std::vector<sf::Vector2i>;
+			
+			explicit PathCache(std::size_t capacity = 256);
+			
+			// fills tiles with a stored path from start to goal on this version of the layer.
+			// failing that, with the rest of a stored path to goal that passes through start
+			bool find(unsigned layer, unsigned version, const sf::Vector2i& start, const sf::Vector2i& goal, Tiles& tiles);
+			
+			// tiles go from the start tile to the goal tile
+			void store(unsigned layer, unsigned version, const Tiles& tiles);
+			
+			void clear();
+			
+			void setCapacity(std::size_t c);
+			std::size_t size() const;
+			
+			unsigned getHits() const;
+			unsigned getPartialHits() const;
+			unsigned getMisses() const;
+			
+			// the layer and goal packed into one key, the ones paths to a goal are found by. FlowFieldCache keys fields with it too
+			static std::uint64_t goalKey(unsigned layer, const sf::Vector2i& goal);
+			
+		private:
+			struct Key
+			{
+				unsigned layer;
+				sf::Vector2i start;
+				sf::Vector2i goal;
+				
+				bool operator==(const Key& other) const
+				{
+					return layer == other.layer && start == other.start && goal == other.goal;
+				}
+			};
+			
+			struct KeyHash
+			{
+				std::size_t operator()(const Key& key) const;
+			};
+			
+			struct Entry
+			{
+				Key key;
+				unsigned version;
+				Tiles tiles;
+			};
+			
+			using Entries = std::list<Entry>;
+			
+			void erase(Entries::iterator it);
+			
+			Entries entries;	// most recently used first
+			std::unordered_map<Key, Entries::iterator, KeyHash> index;
+			std::unordered_map<std::uint64_t, std::vector<Entries::iterator>> byGoal;
+			
+			std::size_t capacity;
+			
+			unsigned hits;
+			unsigned partialHits;
+			unsigned misses;
+	};
+}
+
+#endif // PATHCACHE_HPP
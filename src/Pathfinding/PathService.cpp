@@ -0,0 +1,307 @@
+#include "PathService.hpp"
+
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+
+namespace swift
+{
+	constexpr PathService::Ticket PathService::NONE;
+	
+	PathService::PathService(unsigned threads)
+	:	tileSize(0, 0),
+		nextTicket(1),
+		tick(0),
+		maxAge(300),
+		budget(sf::milliseconds(2)),
+		stopping(false)
+	{
+		for(unsigned i = 0; i < threads; i++)
+			workers.emplace_back(&PathService::work, this);
+	}
+	
+	PathService::~PathService()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		
+		wake.notify_all();
+		
+		for(auto& w : workers)
+			w.join();
+	}
+	
+	PathService::Ticket PathService::submit(const sf::Vector2f& start, const sf::Vector2f& end, unsigned layer, GridSearch::Algorithm algorithm, int priority)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		Ticket ticket = nextTicket++;
+		
+		if(nextTicket == NONE)
+			nextTicket++;
+		
+		queued.insert(ticket);
+		push({ticket, start, end, layer, algorithm, priority, tick});
+		
+		return ticket;
+	}
+	
+	void PathService::cancel(Ticket ticket)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		// still queued requests are skipped once popped
+		queued.erase(ticket);
+		finished.erase(ticket);
+	}
+	
+	bool PathService::collect(Ticket ticket, Result& result)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		auto it = finished.find(ticket);
+		
+		if(it == finished.end())
+			return false;
+		
+		result = std::move(it->second.result);
+		result.version = it->second.version;
+		finished.erase(it);
+		
+		return true;
+	}
+	
+	bool PathService::isPending(Ticket ticket) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		return queued.count(ticket) != 0;
+	}
+	
+	void PathService::update(const TileMap& map)
+	{
+		// copy changed layers before locking, so workers aren't held up by it
+		std::vector<Snapshot> current;
+		
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			current = snapshots;
+		}
+		
+		current.resize(map.getNumLayers());
+		
+		for(unsigned l = 0; l < current.size(); l++)
+		{
+			const Layer* layer = map.getLayer(l);
+			
+			if(!current[l].grid || current[l].version != layer->getVersion())
+			{
+				current[l].grid = std::make_shared<const PassabilityMap>(layer->getPassability());
+				current[l].version = layer->getVersion();
+			}
+		}
+		
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		snapshots = std::move(current);
+		tileSize = map.getTileSize();
+		tick++;
+		
+		for(auto it = finished.begin(); it != finished.end();)
+		{
+			const Request& request = it->second.request;
+			bool changed = request.layer < snapshots.size() && it->second.version != snapshots[request.layer].version;
+			
+			if(tick - it->second.tick > maxAge)
+				it = finished.erase(it);
+			else if(changed)
+			{
+				// solved on a map that has changed since, solve it again
+				queued.insert(request.ticket);
+				push(request);
+				it = finished.erase(it);
+			}
+			else
+				++it;
+		}
+		
+		// a new tick, workers get a new budget
+		wake.notify_all();
+		
+		sf::Clock clock;
+		Request request;
+		
+		while(clock.getElapsedTime() < budget && pop(localQueue, request))
+		{
+			const Layer* layer = map.getLayer(request.layer);
+			unsigned version = layer ? layer->getVersion() : 0;
+			Result result;
+			
+			if(request.algorithm == GridSearch::Algorithm::Hierarchical || !layer)
+			{
+				lock.unlock();
+				
+				Path path(request.start, request.end, request.layer, map, request.algorithm);
+				
+				std::vector<sf::Vector2i> tiles = path.getTiles();
+				
+				if(layer)
+					Path::smooth(tiles, layer->getPassability());
+				
+				result.path.assign(tiles);
+				result.waypoints = path.getWaypoints();
+				
+				lock.lock();
+			}
+			else
+				result = solve(request, layer->getPassability(), version, map.getTileSize(), lock);
+			
+			// may have been cancelled meanwhile
+			if(queued.erase(request.ticket))
+				finished[request.ticket] = {request, std::move(result), version, tick};
+		}
+	}
+	
+	void PathService::setTickBudget(const sf::Time& b)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		budget = b;
+	}
+	
+	const sf::Time& PathService::getTickBudget() const
+	{
+		return budget;
+	}
+	
+	void PathService::setMaxAge(unsigned ticks)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		maxAge = ticks;
+	}
+	
+	void PathService::setCacheCapacity(std::size_t c)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		cache.setCapacity(c);
+	}
+	
+	std::size_t PathService::getPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return queued.size();
+	}
+	
+	unsigned PathService::getThreadCount() const
+	{
+		return workers.size();
+	}
+	
+	void PathService::work()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		unsigned seenTick = tick;
+		sf::Time spent;
+		
+		while(!stopping)
+		{
+			if(tick != seenTick)
+			{
+				seenTick = tick;
+				spent = sf::Time::Zero;
+			}
+			
+			Request request;
+			
+			if(spent < budget && pop(workerQueue, request))
+			{
+				// holding on to the copy keeps it alive, even if update replaces it meanwhile
+				Snapshot snapshot = request.layer < snapshots.size() ? snapshots[request.layer] : Snapshot();
+				
+				sf::Clock clock;
+				Result result;
+				
+				if(snapshot.grid)
+					result = solve(request, *snapshot.grid, snapshot.version, tileSize, lock);
+				
+				spent += clock.getElapsedTime();
+				
+				if(queued.erase(request.ticket))
+					finished[request.ticket] = {request, std::move(result), snapshot.version, tick};
+				
+				continue;
+			}
+			
+			wake.wait(lock, [this, &seenTick, &spent]()
+			{
+				return stopping || tick != seenTick || (spent < budget && !workerQueue.empty());
+			});
+		}
+	}
+	
+	PathService::Result PathService::solve(const Request& request, const PassabilityMap& grid, unsigned version, const sf::Vector2u& size, std::unique_lock<std::mutex>& lock)
+	{
+		PathCache::Tiles tiles;
+		bool cached = cache.find(request.layer, version, Path::getTile(request.start, size), Path::getTile(request.end, size), tiles);
+		
+		// size may be the member, which update can change once unlocked
+		sf::Vector2u searchSize = size;
+		
+		lock.unlock();
+		
+		if(!cached)
+			tiles = Path(request.start, request.end, grid, searchSize, request.algorithm).getTiles();
+		
+		// the cache keeps every tile, so the rest of a path from any of them can be reused
+		PathCache::Tiles smoothed = tiles;
+		Path::smooth(smoothed, grid);
+		
+		Result result;
+		result.path.assign(smoothed);
+		
+		lock.lock();
+		
+		if(!cached)
+			cache.store(request.layer, version, tiles);
+		
+		return result;
+	}
+	
+	bool PathService::pop(std::vector<Request>& queue, Request& request)
+	{
+		while(!queue.empty())
+		{
+			std::pop_heap(queue.begin(), queue.end());
+			request = queue.back();
+			queue.pop_back();
+			
+			// cancelled
+			if(!queued.count(request.ticket))
+				continue;
+			
+			// stale, whoever asked has likely moved on
+			if(tick - request.tick > maxAge)
+			{
+				queued.erase(request.ticket);
+				continue;
+			}
+			
+			return true;
+		}
+		
+		return false;
+	}
+	
+	void PathService::push(const Request& request)
+	{
+		std::vector<Request>& queue = workers.empty() || request.algorithm == GridSearch::Algorithm::Hierarchical ? localQueue : workerQueue;
+		
+		queue.push_back(request);
+		std::push_heap(queue.begin(), queue.end());
+		
+		if(&queue == &workerQueue)
+			wake.notify_one();
+	}
+}
@@ -0,0 +1,141 @@
+#ifndef PATHSERVICE_HPP
+#define PATHSERVICE_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include <SFML/System/Time.hpp>
+
+#include "Path.hpp"
+#include "PathCache.hpp"
+#include "CompactPath.hpp"
+
+namespace swift
+{
+	// solves path requests off the ticking thread. Workers search immutable copies of each layer's
+	// passability, taken in update when a layer changes, so the map can change while they work.
+	// results are collected in a later tick. Each thread only spends its budget on requests per tick.
+	// hierarchical requests use the layer's cluster graph, which isn't safe to share, so they are solved
+	// in update on the ticking thread, as is everything if there are no workers.
+	// everything but update may be called from any thread
+	class PathService
+	{
+		public:
+			using Ticket = std::uint32_t;
+			static constexpr Ticket NONE = 0;
+			
+			struct Result
+			{
+				CompactPath path;			// smoothed, empty if there is no path
+				Path::Waypoints waypoints;	// left to refine, for Hierarchical paths
+				unsigned version = 0;		// of the layer it was solved on
+			};
+			
+			explicit PathService(unsigned threads = 1);
+			~PathService();
+			
+			PathService(const PathService&) = delete;
+			PathService& operator=(const PathService&) = delete;
+			
+			// higher priorities are solved first, then older requests
+			Ticket submit(const sf::Vector2f& start, const sf::Vector2f& end, unsigned layer, GridSearch::Algorithm algorithm, int priority = 0);
+			
+			// drops the request, or its result if already solved
+			void cancel(Ticket ticket);
+			
+			// true once the request is solved, the result is handed over once
+			bool collect(Ticket ticket, Result& result);
+			
+			// false once the request is solved, cancelled, or dropped as stale
+			bool isPending(Ticket ticket) const;
+			
+			// call once per tick. Takes new copies of changed layers, requeues results solved on old copies,
+			// drops requests and results older than the max age, and solves requests meant for this thread
+			void update(const TileMap& map);
+			
+			// per thread, per tick
+			void setTickBudget(const sf::Time& budget);
+			const sf::Time& getTickBudget() const;
+			
+			// in ticks, requests not solved or results not collected by then are dropped
+			void setMaxAge(unsigned ticks);
+			
+			// paths solved recently are reused, 0 turns the cache off. Hierarchical paths aren't cached
+			void setCacheCapacity(std::size_t c);
+			
+			std::size_t getPendingCount() const;
+			unsigned getThreadCount() const;
+			
+		private:
+			struct Request
+			{
+				Ticket ticket;
+				sf::Vector2f start;
+				sf::Vector2f end;
+				unsigned layer;
+				GridSearch::Algorithm algorithm;
+				int priority;
+				unsigned tick;		// when submitted
+				
+				// std heaps are max heaps
+				bool operator<(const Request& other) const
+				{
+					return priority != other.priority ? priority < other.priority : ticket > other.ticket;
+				}
+			};
+			
+			struct Finished
+			{
+				Request request;
+				Result result;
+				unsigned version;	// of the layer copy it was solved on
+				unsigned tick;
+			};
+			
+			struct Snapshot
+			{
+				std::shared_ptr<const PassabilityMap> grid;
+				unsigned version = 0;
+			};
+			
+			void work();
+			
+			// pops the next live request off queue, false if there is none. Callers hold the lock
+			bool pop(std::vector<Request>& queue, Request& request);
+			
+			// to the workers, or to update
+			void push(const Request& request);
+			
+			// searches grid for request, through the cache. lock is held on entry and exit, but not while searching
+			Result solve(const Request& request, const PassabilityMap& grid, unsigned version, const sf::Vector2u& size, std::unique_lock<std::mutex>& lock);
+			
+			std::vector<Request> workerQueue;
+			std::vector<Request> localQueue;
+			std::unordered_map<Ticket, Finished> finished;
+			std::unordered_set<Ticket> queued;
+			
+			PathCache cache;
+			
+			std::vector<Snapshot> snapshots;
+			sf::Vector2u tileSize;
+			
+			Ticket nextTicket;
+			unsigned tick;
+			unsigned maxAge;
+			sf::Time budget;
+			
+			mutable std::mutex mutex;
+			std::condition_variable wake;
+			bool stopping;
+			
+			std::vector<std::thread> workers;
+	};
+}
+
+#endif // PATHSERVICE_HPP
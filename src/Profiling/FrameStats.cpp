@@ -0,0 +1,102 @@
+#include "FrameStats.hpp"
+
+namespace swift
+{
+	FrameStats::Counts FrameStats::current = {};
+	FrameStats::Counts FrameStats::last = {};
+	std::size_t FrameStats::totalDroppedTicks = 0;
+	
+	std::vector<FrameStats::SystemTime> FrameStats::systemTimes;
+	sf::Time FrameStats::gpuTime;
+	
+	void FrameStats::countDraw(Draws who, std::size_t vertices, std::size_t calls)
+	{
+		DrawCount& count = current.draws[static_cast<unsigned>(who)];
+		count.calls += calls;
+		count.vertices += vertices;
+	}
+	
+	void FrameStats::countTick()
+	{
+		current.ticks++;
+	}
+	
+	void FrameStats::countDroppedTicks(unsigned count)
+	{
+		current.droppedTicks += count;
+		totalDroppedTicks += count;
+	}
+	
+	void FrameStats::setSystemTime(const std::string& name, sf::Time time)
+	{
+		// only a handful of systems
+		for(auto& s : systemTimes)
+		{
+			if(s.name == name)
+			{
+				s.time = time;
+				return;
+			}
+		}
+		
+		systemTimes.push_back({name, time});
+	}
+	
+	void FrameStats::setGpuTime(sf::Time time)
+	{
+		gpuTime = time;
+	}
+	
+	void FrameStats::endFrame()
+	{
+		last = current;
+		current = {};
+	}
+	
+	const FrameStats::DrawCount& FrameStats::getDraws(Draws who)
+	{
+		return last.draws[static_cast<unsigned>(who)];
+	}
+	
+	unsigned FrameStats::getTicks()
+	{
+		return last.ticks;
+	}
+	
+	unsigned FrameStats::getDroppedTicks()
+	{
+		return last.droppedTicks;
+	}
+	
+	std::size_t FrameStats::getTotalDroppedTicks()
+	{
+		return totalDroppedTicks;
+	}
+	
+	const std::vector<FrameStats::SystemTime>& FrameStats::getSystemTimes()
+	{
+		return systemTimes;
+	}
+	
+	sf::Time FrameStats::getGpuTime()
+	{
+		return gpuTime;
+	}
+	
+	const char* FrameStats::getName(Draws who)
+	{
+		switch(who)
+		{
+			case Draws::TileMap:
+				return "Tilemap";
+			case Draws::Sprites:
+				return "Sprites";
+			case Draws::Lights:
+				return "Lights";
+			case Draws::GUI:
+				return "GUI";
+			default:
+				return "";
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef FRAMESTATS_HPP
+#define FRAMESTATS_HPP
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include <SFML/System/Time.hpp>
+
+namespace swift
+{
+	// what went into a frame, for the debug overlay. Counted by the engine's own drawing code, SFML doesn't
+	// report what it draws. Drawing and updating never run at the same time, so nothing here is locked
+	class FrameStats
+	{
+		public:
+			enum class Draws
+			{
+				TileMap,
+				Sprites,
+				Lights,
+				GUI,
+				Count
+			};
+			
+			struct DrawCount
+			{
+				std::size_t calls;
+				std::size_t vertices;
+			};
+			
+			struct SystemTime
+			{
+				std::string name;
+				sf::Time time;
+			};
+			
+			static void countDraw(Draws who, std::size_t vertices, std::size_t calls = 1);
+			static void countTick();
+			
+			// ticks that were due but not run, the game fell too far behind to catch up on them
+			static void countDroppedTicks(unsigned count);
+			
+			// how long a system's last update took
+			static void setSystemTime(const std::string& name, sf::Time time);
+			
+			static void setGpuTime(sf::Time time);
+			
+			// starts counting a new frame, what was counted so far is what the getters return
+			static void endFrame();
+			
+			static const DrawCount& getDraws(Draws who);
+			static unsigned getTicks();
+			static unsigned getDroppedTicks();
+			static std::size_t getTotalDroppedTicks();	// since starting
+			static const std::vector<SystemTime>& getSystemTimes();
+			static sf::Time getGpuTime();
+			
+			static const char* getName(Draws who);
+		
+		private:
+			struct Counts
+			{
+				DrawCount draws[static_cast<unsigned>(Draws::Count)];
+				unsigned ticks;
+				unsigned droppedTicks;
+			};
+			
+			static Counts current;
+			static Counts last;
+			
+			static std::size_t totalDroppedTicks;
+			
+			static std::vector<SystemTime> systemTimes;
+			static sf::Time gpuTime;
+	};
+}
+
+#endif // FRAMESTATS_HPP
@@ -0,0 +1,108 @@
+#include "GpuTimer.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+	#include <GL/glew.h>
+#else
+	#define GL_GLEXT_PROTOTYPES
+	#include <GL/gl.h>
+	#include <GL/glext.h>
+#endif
+
+namespace swift
+{
+	GpuTimer::GpuTimer()
+	:	current(0),
+		issued(0),
+		created(false),
+		running(false)
+	{}
+	
+	GpuTimer::~GpuTimer()
+	{
+		release();
+	}
+	
+	void GpuTimer::begin()
+	{
+		if(running || !isAvailable())
+			return;
+		
+		if(!created)
+		{
+			glGenQueries(Frames, queries);
+			created = true;
+		}
+		
+		// the query about to be reused was issued Frames frames ago. If the GPU still hasn't finished it, this frame goes untimed
+		if(issued >= Frames)
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(queries[current], GL_QUERY_RESULT_AVAILABLE, &available);
+			
+			if(!available)
+				return;
+			
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &nanoseconds);
+			time = sf::microseconds(static_cast<sf::Int64>(nanoseconds / 1000));
+		}
+		
+		glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+		running = true;
+	}
+	
+	void GpuTimer::end()
+	{
+		if(!running)
+			return;
+		
+		glEndQuery(GL_TIME_ELAPSED);
+		running = false;
+		
+		current = (current + 1) % Frames;
+		issued++;
+	}
+	
+	sf::Time GpuTimer::getTime() const
+	{
+		return time;
+	}
+	
+	void GpuTimer::release()
+	{
+		if(created)
+			glDeleteQueries(Frames, queries);
+		
+		created = false;
+		running = false;
+		issued = 0;
+		current = 0;
+	}
+	
+	bool GpuTimer::isAvailable()
+	{
+		// checked once, the answer doesn't change
+		static int available = -1;
+		
+		if(available == -1)
+		{
+#ifdef _WIN32
+			available = glewInit() == GLEW_OK && (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+#else
+			// timer queries are core since 3.3
+			const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+			const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+			int major = 0;
+			int minor = 0;
+			
+			bool core = version && std::sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 3 || (major == 3 && minor >= 3));
+			available = core || (extensions && std::strstr(extensions, "GL_ARB_timer_query"));
+#endif
+		}
+		
+		return available == 1;
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef GPUTIMER_HPP
+#define GPUTIMER_HPP
+
+#include <SFML/System/Time.hpp>
+
+namespace swift
+{
+	// how long the GPU spends on a frame, measured with OpenGL timer queries.
+	// results arrive a few frames late, the timer never waits on the GPU for them
+	class GpuTimer
+	{
+		public:
+			GpuTimer();
+			~GpuTimer();
+			
+			GpuTimer(const GpuTimer&) = delete;
+			GpuTimer& operator=(const GpuTimer&) = delete;
+			
+			// around what's timed, once a frame. Need an active context, and do nothing without timer queries
+			void begin();
+			void end();
+			
+			// latest finished result
+			sf::Time getTime() const;
+			
+			// frees the queries while the context they were made in is still around
+			void release();
+			
+			// false if the OpenGL driver doesn't have timer queries. Needs an active context
+			static bool isAvailable();
+		
+		private:
+			static const unsigned Frames = 3;	// queries in flight
+			
+			unsigned queries[Frames];
+			unsigned current;
+			unsigned issued;
+			bool created;
+			bool running;
+			
+			sf::Time time;
+	};
+}
+
+#endif // GPUTIMER_HPP
@@ -0,0 +1,101 @@
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+
+namespace swift
+{
+	std::atomic<bool> Profiler::capturing(false);
+	std::vector<std::unique_ptr<Profiler::Buffer>> Profiler::buffers;
+	std::mutex Profiler::buffersMutex;
+	
+	void Profiler::start()
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		
+		for(auto& b : buffers)
+			b->count.store(0, std::memory_order_relaxed);
+		
+		capturing = true;
+	}
+	
+	void Profiler::stop()
+	{
+		capturing = false;
+	}
+	
+	bool Profiler::save(const std::string& file, std::int64_t since)
+	{
+		std::ofstream fout(file);
+		
+		if(!fout)
+			return false;
+		
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		
+		fout << "{\"traceEvents\":[";
+		bool first = true;
+		
+		for(auto& b : buffers)
+		{
+			std::size_t count = b->count.load(std::memory_order_acquire);
+			
+			// a wrapped buffer holds its last Capacity events
+			std::size_t begin = count > Capacity ? count - Capacity : 0;
+			
+			for(std::size_t i = begin; i < count; i++)
+			{
+				const Event& e = b->events[i % Capacity];
+				
+				if(e.start < since)
+					continue;
+				
+				fout << (first ? "\n" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"ts\":" << e.start
+					<< ",\"dur\":" << e.duration << ",\"pid\":0,\"tid\":" << b->thread << '}';
+				
+				first = false;
+			}
+		}
+		
+		fout << "\n]}\n";
+		
+		return fout.good();
+	}
+	
+	std::int64_t Profiler::now()
+	{
+		using Clock = std::chrono::steady_clock;
+		static const Clock::time_point epoch = Clock::now();
+		
+		return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - epoch).count();
+	}
+	
+	void Profiler::record(const char* name, std::int64_t start, std::int64_t end)
+	{
+		Buffer& buffer = getBuffer();
+		std::size_t count = buffer.count.load(std::memory_order_relaxed);
+		
+		buffer.events[count % Capacity] = {name, start, end - start};
+		buffer.count.store(count + 1, std::memory_order_release);
+	}
+	
+	Profiler::Buffer& Profiler::getBuffer()
+	{
+		// looked up once per thread, the lock is only taken the first time
+		thread_local Buffer* buffer = nullptr;
+		
+		if(buffer)
+			return *buffer;
+		
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		
+		buffers.emplace_back(new Buffer);
+		buffer = buffers.back().get();
+		buffer->events.resize(Capacity);
+		buffer->count = 0;
+		buffer->thread = buffers.size() - 1;
+		
+		return *buffer;
+	}
+}
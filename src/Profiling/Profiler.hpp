@@ -0,0 +1,98 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace swift
+{
+	// records named scopes into per thread ring buffers, for saving as a Chrome tracing (or Perfetto) JSON file.
+	// while not capturing, a scope costs one relaxed atomic load. Define SWIFT_NO_PROFILING to compile scopes out entirely
+	class Profiler
+	{
+		public:
+			// events kept per thread, older ones are overwritten
+			static const std::size_t Capacity = 1 << 16;
+			
+			// clears what was captured before
+			static void start();
+			static void stop();
+			
+			static bool isCapturing()
+			{
+				return capturing.load(std::memory_order_relaxed);
+			}
+			
+			// writes everything captured that started at since or later, best while nothing is being recorded
+			static bool save(const std::string& file, std::int64_t since = 0);
+			
+			// microseconds since the profiler was first used
+			static std::int64_t now();
+			
+			// name has to outlive the capture, string literals are what it's meant for
+			static void record(const char* name, std::int64_t start, std::int64_t end);
+		
+		private:
+			struct Event
+			{
+				const char* name;
+				std::int64_t start;
+				std::int64_t duration;
+			};
+			
+			// only written by its thread. count is atomic so a buffer can be read while its thread is still around
+			struct Buffer
+			{
+				std::vector<Event> events;
+				std::atomic<std::size_t> count;
+				unsigned thread;
+			};
+			
+			static Buffer& getBuffer();
+			
+			static std::atomic<bool> capturing;
+			
+			// kept after their threads end, so their events can still be saved
+			static std::vector<std::unique_ptr<Buffer>> buffers;
+			static std::mutex buffersMutex;
+	};
+	
+	// times from construction to destruction
+	class ProfileScope
+	{
+		public:
+			explicit ProfileScope(const char* n)
+			:	name(Profiler::isCapturing() ? n : nullptr),
+				start(name ? Profiler::now() : 0)
+			{}
+			
+			~ProfileScope()
+			{
+				if(name)
+					Profiler::record(name, start, Profiler::now());
+			}
+			
+			ProfileScope(const ProfileScope&) = delete;
+			ProfileScope& operator=(const ProfileScope&) = delete;
+		
+		private:
+			const char* name;
+			std::int64_t start;
+	};
+}
+
+#define SWIFT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SWIFT_PROFILE_CONCAT(a, b) SWIFT_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef SWIFT_NO_PROFILING
+	#define SWIFT_PROFILE(name)
+#else
+	// profiles the rest of the enclosing scope as name
+	#define SWIFT_PROFILE(name) swift::ProfileScope SWIFT_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
+
+#endif // PROFILER_HPP
@@ -0,0 +1,52 @@
+#include "StartupTimer.hpp"
+
+#include <cstring>
+
+namespace swift
+{
+	std::vector<std::pair<const char*, std::int64_t>> StartupTimer::phases;
+	std::mutex StartupTimer::mutex;
+	
+	void StartupTimer::add(const char* phase, std::int64_t microseconds)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		for(auto& p : phases)
+		{
+			if(std::strcmp(p.first, phase) == 0)
+			{
+				p.second += microseconds;
+				return;
+			}
+		}
+		
+		phases.emplace_back(phase, microseconds);
+	}
+	
+	std::string StartupTimer::report()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		
+		auto milliseconds = [](std::int64_t us)
+		{
+			return std::to_string(us / 1000.f).substr(0, 7) + " ms";
+		};
+		
+		std::string text;
+		std::int64_t total = 0;
+		
+		for(auto& p : phases)
+		{
+			text += std::string(p.first) + ":\t" + milliseconds(p.second) + '\n';
+			total += p.second;
+		}
+		
+		return text + "Total:\t" + milliseconds(total) + '\n';
+	}
+	
+	void StartupTimer::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		phases.clear();
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef STARTUPTIMER_HPP
+#define STARTUPTIMER_HPP
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+#include "Profiler.hpp"
+
+namespace swift
+{
+	// how long each phase of starting up took, summed by name in the order they first ran, for the log.
+	// Phases time themselves with SWIFT_STARTUP, and shouldn't be nested, or their time is counted twice
+	class StartupTimer
+	{
+		public:
+			static void add(const char* phase, std::int64_t microseconds);
+			
+			// a line per phase, then the total
+			static std::string report();
+			
+			static void clear();
+		
+		private:
+			static std::vector<std::pair<const char*, std::int64_t>> phases;
+			static std::mutex mutex;
+	};
+	
+	// times from construction to destruction
+	class StartupPhase
+	{
+		public:
+			explicit StartupPhase(const char* n)
+			:	name(n),
+				start(Profiler::now())
+			{}
+			
+			~StartupPhase()
+			{
+				StartupTimer::add(name, Profiler::now() - start);
+			}
+			
+			StartupPhase(const StartupPhase&) = delete;
+			StartupPhase& operator=(const StartupPhase&) = delete;
+		
+		private:
+			const char* name;
+			std::int64_t start;
+	};
+}
+
+// times the rest of the enclosing scope as a phase of starting up named name
+#define SWIFT_STARTUP(name) swift::StartupPhase SWIFT_PROFILE_CONCAT(startupPhase, __LINE__)(name)
+
+#endif // STARTUPTIMER_HPP
@@ -0,0 +1,123 @@
+#include "Watchdog.hpp"
+
+#include <fstream>
+#include <ctime>
+#include <algorithm>
+
+#include "Profiler.hpp"
+#include "FrameStats.hpp"
+
+namespace swift
+{
+	Watchdog::Watchdog()
+	:	threshold(sf::Time::Zero),
+		folder("./data/"),
+		maxDumps(5),
+		dumps(0),
+		starts(120, 0),
+		next(0),
+		sinceDump(0),
+		session(0)
+	{
+	}
+	
+	void Watchdog::setThreshold(sf::Time t)
+	{
+		threshold = t;
+		
+		// the ring buffers are what's dumped, they have to be filling
+		if(isEnabled())
+		{
+			session = static_cast<std::int64_t>(std::time(nullptr));
+			
+			if(!Profiler::isCapturing())
+				Profiler::start();
+		}
+	}
+	
+	sf::Time Watchdog::getThreshold() const
+	{
+		return threshold;
+	}
+	
+	void Watchdog::setFrames(unsigned f)
+	{
+		starts.assign(std::max(f, 1u), 0);
+		next = 0;
+		sinceDump = 0;
+	}
+	
+	void Watchdog::setFolder(const std::string& f)
+	{
+		folder = f;
+		
+		if(!folder.empty() && folder.back() != '/')
+			folder += '/';
+	}
+	
+	void Watchdog::setMaxDumps(unsigned m)
+	{
+		maxDumps = m;
+	}
+	
+	bool Watchdog::isEnabled() const
+	{
+		return threshold > sf::Time::Zero;
+	}
+	
+	void Watchdog::begin()
+	{
+		if(!isEnabled())
+			return;
+		
+		starts[next] = Profiler::now();
+		next = (next + 1) % starts.size();
+		sinceDump++;
+	}
+	
+	bool Watchdog::check(const char* what, sf::Time time, const std::function<void(std::ostream&)>& report)
+	{
+		if(!isEnabled() || time <= threshold || dumps >= maxDumps || sinceDump < starts.size() / 2)
+			return false;
+		
+		// the oldest frame kept, or the first since the last dump if that's later
+		std::size_t kept = std::min(sinceDump, starts.size());
+		std::int64_t since = starts[(next + starts.size() - kept) % starts.size()];
+		
+		std::string name = folder + "hitch-" + std::to_string(session) + '-' + std::to_string(dumps);
+		
+		// the part being captured is still written to, so stop until it's saved
+		Profiler::stop();
+		bool saved = Profiler::save(name + ".json", since);
+		Profiler::start();
+		
+		std::ofstream fout(name + ".txt");
+		
+		if(fout)
+		{
+			fout << what << " took " << time.asMicroseconds() / 1000.f << " ms, over the " << threshold.asMicroseconds() / 1000.f
+				<< " ms threshold. The last " << kept << " frames are in " << name << ".json\n\n";
+			
+			// of the last tick
+			fout << "Systems:\n";
+			
+			for(auto& s : FrameStats::getSystemTimes())
+				fout << '\t' << s.name << ": " << s.time.asMicroseconds() / 1000.f << " ms\n";
+			
+			fout << "Dropped ticks: " << FrameStats::getTotalDroppedTicks() << " total\n";
+			
+			if(report)
+				report(fout);
+		}
+		
+		dumps++;
+		sinceDump = 0;
+		
+		return saved && fout.good();
+	}
+	
+	unsigned Watchdog::getDumps() const
+	{
+		return dumps;
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef WATCHDOG_HPP
+#define WATCHDOG_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <ostream>
+#include <cstdint>
+
+#include <SFML/System/Time.hpp>
+
+namespace swift
+{
+	// catches hitches where they happen. While it's on the profiler keeps capturing, and the start of each of the last
+	// frames is remembered. A frame or tick over the threshold saves the profile of those frames as a Chrome tracing
+	// file, with a report next to it. Frames under it only cost their scopes being recorded
+	class Watchdog
+	{
+		public:
+			Watchdog();
+			
+			// 0, the default, turns it off
+			void setThreshold(sf::Time t);
+			sf::Time getThreshold() const;
+			
+			// frames before a hitch that are saved with it
+			void setFrames(unsigned f);
+			
+			// dumps are written to folder as hitch-<time>-<n>.json and .txt. Only the first max of a session are
+			void setFolder(const std::string& f);
+			void setMaxDumps(unsigned m);
+			
+			bool isEnabled() const;
+			
+			// where a frame starts
+			void begin();
+			
+			// what, a frame or a tick, took time. Over the threshold, its frames are dumped, with what report writes
+			// to the report after them. True if it dumped
+			bool check(const char* what, sf::Time time, const std::function<void(std::ostream&)>& report);
+			
+			unsigned getDumps() const;
+		
+		private:
+			sf::Time threshold;
+			std::string folder;
+			unsigned maxDumps;
+			unsigned dumps;
+			
+			// starts of the last frames, a ring of them
+			std::vector<std::int64_t> starts;
+			std::size_t next;
+			std::size_t sinceDump;	// frames begun since the last dump, so each dump has frames of its own
+			
+			std::int64_t session;	// seconds since the epoch when it was turned on, so sessions don't overwrite each other
+	};
+}
+
+#endif // WATCHDOG_HPP
@@ -0,0 +1,89 @@
+#ifndef ASSET_HANDLE_HPP
+#define ASSET_HANDLE_HPP
+
+#include <atomic>
+
+namespace swift
+{
+	// a counted reference to an asset of the AssetManager. Assets with handles to them are never evicted,
+	// ones only referenced by handles can be once their last handle is gone. Empty if the asset doesn't exist.
+	// The count is atomic, handles can be copied and dropped on any thread
+	template<typename T>
+	class AssetHandle
+	{
+		public:
+			AssetHandle()
+			:	asset(nullptr),
+				refs(nullptr)
+			{
+			}
+
+			AssetHandle(T* a, std::atomic<unsigned>* r)
+			:	asset(a),
+				refs(a ? r : nullptr)
+			{
+				if(refs)
+					++*refs;
+			}
+
+			AssetHandle(const AssetHandle& other)
+			:	AssetHandle(other.asset, other.refs)
+			{
+			}
+
+			AssetHandle& operator=(const AssetHandle& other)
+			{
+				if(this != &other)
+				{
+					reset();
+					asset = other.asset;
+					refs = other.refs;
+
+					if(refs)
+						++*refs;
+				}
+
+				return *this;
+			}
+
+			~AssetHandle()
+			{
+				reset();
+			}
+
+			void reset()
+			{
+				if(refs)
+					--*refs;
+
+				asset = nullptr;
+				refs = nullptr;
+			}
+
+			T* get() const
+			{
+				return asset;
+			}
+
+			T& operator*() const
+			{
+				return *asset;
+			}
+
+			T* operator->() const
+			{
+				return asset;
+			}
+
+			explicit operator bool() const
+			{
+				return asset != nullptr;
+			}
+
+		private:
+			T* asset;
+			std::atomic<unsigned>* refs;
+	};
+}
+
+#endif // ASSET_HANDLE_HPP
@@ -1,36 +1,874 @@
 #include "AssetManager.hpp"
 
+#include <memory>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+
+#include <SFML/Graphics/Image.hpp>
+
+#include "../Profiling/Profiler.hpp"
+#include "../Memory/MemoryTracker.hpp"
+
 namespace swift
 {
+	ThreadPool* AssetManager::threadPool = nullptr;
+	FileIndex* AssetManager::fileIndex = nullptr;
+	
 	AssetManager::AssetManager()
 	{
 		smooth = false;
+		lazy = false;
+		compressedSounds = false;
+		encodedMemory = 0;
+		atlasMax = 0;
+		useClock = 0;
+		budgets.fill(0);
+		memory.fill(0);
+		evictions.fill(0);
 		sf::err().rdbuf(nullptr);	// redirect sfml errors to nothing, we want to handle errors on our own
 	}
 
 	AssetManager::~AssetManager()
 	{
+		// the decoding thread's results are dropped with everything else
+		finishPrefetches(true);
+		uploader.release();
+		
 		for(auto& a : animTextures)
 			delete a.second;
 		
 		for(auto& t : textures)
 			delete t.second;
 		
-		for(auto& s : soundBuffers)
-			delete s.second;
+		for(auto& s : soundBuffers)
+			delete s.second;
+			
+		for(auto& m : music)
+			delete m.second;
+		
+		for(auto& f : fonts)
+			delete f.second;
+		
+		for(auto& s : scripts)
+			delete s.second;
+		
+		for(auto& p : prefabs)
+			delete p.second;
+	}
+
+	bool AssetManager::loadResourceFolder(const std::string& folder)
+	{
+		return loadResourceFolders({folder});
+	}
+	
+	bool AssetManager::loadResourceFolders(const std::vector<std::string>& folders)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		bool result = true;
+		std::vector<std::string> files;
+		
+		for(auto& f : folders)
+			result = gatherFiles(f, files) && result;
+		
+		// packs among the files are opened first, and loose files of the same path take their place. Each path is loaded once
+		std::vector<PackFile*> opened;
+		std::vector<std::string> loose;
+		
+		for(auto& f : files)
+		{
+			if(!isPack(f))
+				loose.push_back(f);
+			else if(PackFile* pack = openPack(f))
+				opened.push_back(pack);
+			else
+				result = false;
+		}
+		
+		std::unordered_set<std::string> seen;
+		std::vector<std::string> load;
+		
+		// later packs overlay earlier ones
+		for(auto& p : opened)
+		{
+			for(auto& e : p->getEntries())
+				packed[e.path] = p;
+		}
+		
+		for(auto& p : opened)
+		{
+			for(auto& e : p->getEntries())
+			{
+				if(seen.insert(e.path).second)
+					load.push_back(e.path);
+			}
+		}
+		
+		for(auto& f : loose)
+		{
+			packed.erase(f);
+			
+			if(seen.insert(f).second)
+				load.push_back(f);
+		}
+		
+		return loadFiles(load) && result;
+	}
+	
+	bool AssetManager::mountPack(const std::string& file)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		PackFile* pack = openPack(file);
+		
+		if(pack == nullptr)
+			return false;
+		
+		std::vector<std::string> files;
+		files.reserve(pack->getEntries().size());
+		
+		// later packs overlay earlier ones
+		for(auto& e : pack->getEntries())
+		{
+			packed[e.path] = pack;
+			files.push_back(e.path);
+		}
+		
+		return loadFiles(files);
+	}
+	
+	PackFile* AssetManager::openPack(const std::string& file)
+	{
+		std::unique_ptr<PackFile> pack(new PackFile());
+		
+		if(!pack->open(file))
+		{
+			SWIFT_WARNING(Assets, "Unable to mount " << file << " as a pack.\n");
+			return nullptr;
+		}
+		
+		SWIFT_DEBUG(Assets, "Pack:\t" << file << ", " << pack->getEntries().size() << " files\n");
+		
+		packs.push_back(std::move(pack));
+		
+		return packs.back().get();
+	}
+	
+	bool AssetManager::writePack(const std::string& pack, const std::vector<std::string>& folders)
+	{
+		std::vector<std::string> files;
+		
+		for(auto& f : folders)
+		{
+			if(!gatherFiles(f, files))
+				return false;
+		}
+		
+		// packs aren't packed into packs
+		files.erase(std::remove_if(files.begin(), files.end(), isPack), files.end());
+		
+		// anims are packed compiled, so loading them from the pack parses no XML
+		return PackFile::write(pack, files, [](const std::string& file, std::vector<std::uint8_t>& data)
+		{
+			if(file.find("/anims/") == std::string::npos)
+				return true;
+			
+			AnimTexture anim;
+			
+			if(!anim.loadFromMemory(data.data(), data.size(), file))
+				return false;
+			
+			ByteWriter out;
+			anim.write(out);
+			data = out.getData();
+			
+			return true;
+		});
+	}
+	
+	bool AssetManager::loadFiles(const std::vector<std::string>& files)
+	{
+		SWIFT_MEMORY_SCOPE(Assets);
+		
+		bool result = true;
+		
+		// only remembered, each is loaded the first time it's asked for
+		if(lazy)
+		{
+			indexed.insert(files.begin(), files.end());
+			SWIFT_DEBUG(Assets, "Indexed " << files.size() << " files\n");
+			return result;
+		}
+		
+		std::vector<Decoded> decoded;
+		std::vector<std::string> rest;
+		
+		for(auto& f : files)
+		{
+			// each song holds its file and decoder open, they're opened when they're played
+			if(f.find("/music/") != std::string::npos)
+				indexed.insert(f);
+			// decoded when first played
+			else if(compressedSounds && isCompressedSound(f))
+				indexed.insert(f);
+			else if(isDecodable(f))
+				decoded.push_back(makeDecoded(f));
+			else
+				rest.push_back(f);
+		}
+		
+		// into their own slots, so the jobs don't share anything
+		std::vector<ThreadPool::Job> jobs;
+		jobs.reserve(decoded.size());
+		
+		for(auto& d : decoded)
+			jobs.push_back([&d]() { decode(d); });
+		
+		if(threadPool)
+			threadPool->run(jobs);
+		else
+		{
+			for(auto& j : jobs)
+				j();
+		}
+		
+		packAtlas(decoded);
+		
+		for(auto& d : decoded)
+		{
+			// atlased
+			if(d.file.empty())
+				continue;
+			
+			result = store(d) && result;
+		}
+		
+		// scripts run as they load, and may look up what was decoded above
+		for(auto& f : rest)
+			loadResource(f);
+		
+		return result;
+	}
+	
+	void AssetManager::setLazy(bool l)
+	{
+		lazy = l;
+	}
+	
+	void AssetManager::setCompressedSounds(bool c)
+	{
+		compressedSounds = c;
+	}
+	
+	std::size_t AssetManager::getCompressedMemory() const
+	{
+		return encodedMemory;
+	}
+	
+	void AssetManager::setAtlas(unsigned maxSize)
+	{
+		atlasMax = maxSize;
+	}
+	
+	void AssetManager::packAtlas(std::vector<Decoded>& decoded)
+	{
+		if(atlasMax == 0)
+			return;
+		
+		std::vector<Decoded*> small;
+		std::vector<const sf::Image*> images;
+		
+		for(auto& d : decoded)
+		{
+			sf::Vector2u size = d.image.getSize();
+			
+			// ones already loaded are pointed to as they are. Compressed ones can't be copied onto a page
+			if(d.loaded && d.file.find("/textures/") != std::string::npos && !CompressedImage::isCompressed(d.file)
+				&& size.x <= atlasMax && size.y <= atlasMax && textures.find(d.file) == textures.end())
+			{
+				small.push_back(&d);
+				images.push_back(&d.image);
+			}
+		}
+		
+		if(small.empty())
+			return;
+		
+		std::size_t pages = atlas.getPageCount();
+		std::size_t bytes = atlas.getMemory();
+		std::vector<TextureAtlas::Region> regions = atlas.pack(images, smooth);
+		
+		for(std::size_t i = 0; i < small.size(); i++)
+		{
+			if(regions[i].texture == nullptr)
+				continue;
+			
+			atlased[small[i]->file] = regions[i];
+			SWIFT_DEBUG(Assets, "Atlased:\t" << small[i]->file << '\n');
+			
+			small[i]->file.clear();
+			small[i]->image = sf::Image();
+		}
+		
+		// pages are never evicted, but count against the budget
+		memory[static_cast<std::size_t>(Category::Textures)] += atlas.getMemory() - bytes;
+		
+		SWIFT_DEBUG(Assets, "Atlas:\t" << atlas.getPageCount() - pages << " pages\n");
+	}
+	
+	void AssetManager::prefetch(const std::vector<std::string>& files)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		std::vector<Decoded> decoded;
+		
+		for(auto& f : files)
+		{
+			auto it = indexed.find(f);
+			
+			if(it == indexed.end() || !isDecodable(f))
+				continue;
+			
+			indexed.erase(it);
+			pending.insert(f);
+			decoded.push_back(makeDecoded(f));
+		}
+		
+		if(decoded.empty())
+			return;
+		
+		prefetches.push_back(std::async(std::launch::async, [](std::vector<Decoded> batch)
+		{
+			for(auto& d : batch)
+				decode(d);
+			
+			return batch;
+		}, std::move(decoded)));
+	}
+	
+	bool AssetManager::prefetchManifest(const std::string& file)
+	{
+		std::ifstream fin(file);
+		
+		if(!fin)
+			return false;
+		
+		std::vector<std::string> files;
+		std::string line;
+		
+		while(std::getline(fin, line))
+		{
+			if(!line.empty())
+				files.push_back(line);
+		}
+		
+		prefetch(files);
+		
+		return true;
+	}
+	
+	bool AssetManager::watch(const std::vector<std::string>& folders)
+	{
+		if(!watcher)
+			watcher.reset(new FileWatcher());
+		
+		bool result = true;
+		
+		for(auto& f : folders)
+		{
+			if(!watcher->watch(f))
+			{
+				SWIFT_WARNING(Assets, "Unable to watch " << f << " for changes.\n");
+				result = false;
+			}
+		}
+		
+		return result;
+	}
+	
+	void AssetManager::update()
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		SWIFT_MEMORY_SCOPE(Assets);
+		
+		finishPrefetches(false);
+		
+		if(watcher)
+		{
+			// the real files of mods are watched, assets are known by the path they replace
+			for(auto& f : watcher->poll())
+			{
+				std::string file = fileTable.reverse(f);
+				
+				if(!file.empty() && packed.find(file) == packed.end())
+					reload(file);
+			}
+		}
+		
+		trim();
+	}
+	
+	bool AssetManager::reload(const std::string& file)
+	{
+		SWIFT_PROFILE("AssetManager::reload");
+		SWIFT_MEMORY_SCOPE(Assets);
+		
+		bool known = animTextures.count(file) || textures.count(file) || atlased.count(file) || soundBuffers.count(file)
+			|| fonts.count(file) || scripts.count(file);
+		
+		// an evicted compressed sound is read again when it's next decoded
+		if(!soundBuffers.count(file))
+		{
+			auto encoded = encodedSounds.find(file);
+			
+			if(encoded != encodedSounds.end())
+			{
+				encodedMemory -= encoded->second.size();
+				encodedSounds.erase(encoded);
+			}
+		}
+		
+		if(!known)
+			return false;
+		
+		const std::uint8_t* data = nullptr;
+		std::size_t size = 0;
+		std::vector<std::uint8_t> buffer;
+		bool result = readSource(file, data, size, buffer);
+		
+		if(!result)
+		{
+			SWIFT_WARNING(Assets, "Unable to read " << file << " again.\n");
+			return false;
+		}
+		
+		if(file.find("/anims/") != std::string::npos)
+		{
+			AnimTexture anim;
+			
+			// entities already animated play the new frames, of the animation with the number theirs had
+			result = anim.loadFromMemory(data, size, file);
+			
+			if(result)
+				*animTextures[file] = anim;
+		}
+		else if(file.find("/textures/") != std::string::npos)
+		{
+			auto atlasIt = atlased.find(file);
+			auto it = textures.find(file);
+			
+			// never atlased, they're loaded over what's there as they are
+			if(CompressedImage::isCompressed(file))
+			{
+				if(it == textures.end())
+					it = textures.emplace(file, new sf::Texture()).first;
+				
+				result = loadTexture(*it->second, file, file, data, size);
+				
+				if(result)
+					atlased.erase(file);
+				
+				SWIFT_DEBUG(Assets, (result ? "Reloaded:\t" : "Unable to reload ") << file << '\n');
+				return result;
+			}
+			
+			sf::Image image;
+			result = image.loadFromMemory(data, size);
+			
+			if(!result)
+			{
+				SWIFT_WARNING(Assets, "Unable to reload " << file << " as a texture.\n");
+				return false;
+			}
+			
+			const sf::IntRect& rect = atlasIt != atlased.end() ? atlasIt->second.rect : sf::IntRect();
+			
+			// copied over the old one where it's packed, if it still fits. Otherwise it's a texture of its own from here on
+			if(atlasIt != atlased.end() && image.getSize() == sf::Vector2u(rect.width, rect.height))
+			{
+				const_cast<sf::Texture*>(atlasIt->second.texture)->update(image, rect.left, rect.top);
+			}
+			else
+			{
+				atlased.erase(file);
+				
+				if(it == textures.end())
+					it = textures.emplace(file, new sf::Texture()).first;
+			}
+			
+			if(it != textures.end())
+			{
+				result = it->second->loadFromImage(image);
+				finishTexture(*it->second);
+				track(file, Category::Textures, TextureUploader::getMemory(image.getSize()));
+			}
+		}
+		else if(file.find("/sounds/") != std::string::npos)
+		{
+			sf::SoundBuffer sound;
+			
+			// sounds playing the old one stop
+			result = sound.loadFromMemory(data, size);
+			
+			if(result)
+			{
+				*soundBuffers[file] = sound;
+				track(file, Category::Sounds, sound.getSampleCount() * sizeof(sf::Int16));
+				
+				auto encoded = encodedSounds.find(file);
+				
+				if(encoded != encodedSounds.end())
+				{
+					encodedMemory += size - encoded->second.size();
+					encoded->second.assign(data, data + size);
+				}
+			}
+		}
+		else if(file.find("/fonts/") != std::string::npos)
+		{
+			sf::Font font;
+			result = font.loadFromMemory(data, size);
+			
+			// fonts read from their data as they're used
+			if(result)
+			{
+				*fonts[file] = font;
+				keptData[file].swap(buffer);
+			}
+		}
+		else
+		{
+			result = scripts[file]->reload(data, size);
+		}
+		
+		if(result)
+			SWIFT_DEBUG(Assets, "Reloaded:\t" << file << '\n');
+		else
+			SWIFT_WARNING(Assets, "Unable to reload " << file << '\n');
+		
+		return result;
+	}
+	
+	bool AssetManager::readSource(const std::string& file, const std::uint8_t*& data, std::size_t& size, std::vector<std::uint8_t>& buffer) const
+	{
+		auto inPack = packed.find(file);
+		
+		if(inPack != packed.end())
+			return readPacked(*inPack->second, file, data, size, buffer);
+		
+		std::ifstream fin(fileTable.resolve(file), std::ios::binary);
+		
+		if(!fin)
+			return false;
+		
+		buffer.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+		data = buffer.data();
+		size = buffer.size();
+		
+		return true;
+	}
+	
+	void AssetManager::finishPrefetches(bool wait)
+	{
+		for(auto it = prefetches.begin(); it != prefetches.end();)
+		{
+			if(!wait && it->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+			
+			// staged ones stay pending until they're up
+			for(auto& d : it->get())
+			{
+				if(wait || !stage(d))
+			{
+				pending.erase(d.file);
+				store(d);
+			}
+			}
+			
+			it = prefetches.erase(it);
+		}
+		
+		for(auto& f : wait ? uploader.flush() : uploader.update())
+		{
+			auto s = staged.find(f);
+			
+			if(s == staged.end())
+				continue;
+			
+			textures[f] = s->second;
+			track(f, Category::Textures, TextureUploader::getMemory(s->second->getSize()));
+			finishTexture(*s->second);
+			pending.erase(f);
+			staged.erase(s);
+			
+			SWIFT_DEBUG(Assets, "Texture:\t" << f << '\n');
+		}
+	}
+	
+	void AssetManager::require(const std::string& n)
+	{
+		SWIFT_MEMORY_SCOPE(Assets);
+		
+		if(pending.find(n) != pending.end())
+		{
+			finishPrefetches(true);
+			return;
+		}
+		
+		auto it = indexed.find(n);
+		
+		if(it == indexed.end())
+			return;
+		
+		indexed.erase(it);
+		loadResource(n);
+	}
+	
+	bool AssetManager::isDecodable(const std::string& file)
+	{
+		return file.find("/anims/") == std::string::npos && (file.find("/textures/") != std::string::npos
+			|| file.find("/sounds/") != std::string::npos || file.find("/fonts/") != std::string::npos);
+	}
+	
+	bool AssetManager::isCompressedSound(const std::string& file)
+	{
+		if(file.find("/sounds/") == std::string::npos)
+			return false;
+		
+		std::string ext = file.substr(file.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		
+		return ext == "ogg" || ext == "flac";
+	}
+	
+	AssetManager::Decoded AssetManager::makeDecoded(const std::string& file) const
+	{
+		auto it = packed.find(file);
+		
+		return {file, fileTable.resolve(file), it != packed.end() ? it->second : nullptr, {}, {}, nullptr, nullptr, false, {}};
+	}
+	
+	void AssetManager::decode(Decoded& d)
+	{
+		SWIFT_PROFILE("AssetManager::decode");
+		SWIFT_MEMORY_SCOPE(Assets);
+		
+		const std::uint8_t* data = nullptr;
+		std::size_t size = 0;
+		
+		if(d.pack && !readPacked(*d.pack, d.file, data, size, d.data))
+			return;
+		
+		if(d.file.find("/textures/") != std::string::npos && CompressedImage::isCompressed(d.file))
+		{
+			d.loaded = d.pack ? d.compressed.loadFromMemory(data, size) : d.compressed.loadFromFile(d.source);
+		}
+		else if(d.file.find("/textures/") != std::string::npos)
+		{
+			d.loaded = d.pack ? d.image.loadFromMemory(data, size) : d.image.loadFromFile(d.source);
+		}
+		else if(d.file.find("/sounds/") != std::string::npos)
+		{
+			d.sound.reset(new sf::SoundBuffer());
+			d.loaded = d.pack ? d.sound->loadFromMemory(data, size) : d.sound->loadFromFile(d.source);
+		}
+		else
+		{
+			// reads from data as it's used, which store keeps around
+			d.font.reset(new sf::Font());
+			d.loaded = d.pack ? d.font->loadFromMemory(data, size) : d.font->loadFromFile(d.source);
+		}
+	}
+	
+	bool AssetManager::readPacked(const PackFile& pack, const std::string& file, const std::uint8_t*& data, std::size_t& size, std::vector<std::uint8_t>& buffer)
+	{
+		const PackFile::Entry* entry = pack.find(file);
+		
+		if(entry == nullptr)
+			return false;
+		
+		// stored as they are, straight from the mapping
+		data = pack.getData(*entry);
+		size = entry->size;
+		
+		if(data)
+			return true;
+		
+		if(!pack.read(*entry, buffer))
+			return false;
+		
+		data = buffer.data();
+		size = buffer.size();
+		
+		return true;
+	}
+	
+	bool AssetManager::stage(Decoded& d)
+	{
+		// ones loaded again go into what's there, which is drawn meanwhile, so they're uploaded whole
+		if(uploader.getBudget() == 0 || !d.loaded || d.file.find("/textures/") == std::string::npos
+			|| CompressedImage::isCompressed(d.file) || textures.count(d.file) || staged.count(d.file))
+			return false;
+		
+		std::unique_ptr<sf::Texture> texture(new sf::Texture());
+		
+		if(!uploader.queue(d.file, *texture, d.image, smooth))
+			return false;
+		
+		atlased.erase(d.file);
+		staged[d.file] = texture.release();
+		
+		return true;
+	}
+	
+	void AssetManager::finishTexture(sf::Texture& texture)
+	{
+		texture.setSmooth(smooth);
+		TextureUploader::finish(texture, smooth);
+	}
+	
+	bool AssetManager::loadTexture(sf::Texture& texture, const std::string& file, const std::string& source, const std::uint8_t* data, std::size_t size)
+	{
+		if(!CompressedImage::isCompressed(file))
+		{
+			if(!(data ? texture.loadFromMemory(data, size) : texture.loadFromFile(source)))
+				return false;
+			
+			finishTexture(texture);
+			track(file, Category::Textures, TextureUploader::getMemory(texture.getSize()));
+			
+			return true;
+		}
+		
+		CompressedImage image;
+		
+		if(!(data ? image.loadFromMemory(data, size) : image.loadFromFile(source)))
+			return false;
+		
+		if(!TextureUploader::upload(texture, image, smooth))
+		{
+			SWIFT_WARNING(Assets, file << " is in a compressed format the driver doesn't support.\n");
+			return false;
+		}
+		
+		finishTexture(texture);
+		track(file, Category::Textures, image.getMemory());
+		
+		return true;
+	}
+	
+	bool AssetManager::isPack(const std::string& file)
+	{
+		return file.size() > 5 && file.compare(file.size() - 5, 5, ".pack") == 0;
+	}
+	
+	bool AssetManager::store(Decoded& d)
+	{
+		SWIFT_MEMORY_SCOPE(Assets);
+		
+		if(d.file.find("/textures/") != std::string::npos)
+		{
+			// files loaded again, from an overlaying pack, are loaded into what's there, so pointers to it stay valid
+			// and take over from where they're atlased, for what's drawn from here on
+			atlased.erase(d.file);
+			sf::Texture*& texture = textures[d.file];
+			bool fresh = texture == nullptr;
 			
-		for(auto& m : music)
-			delete m.second;
-		
-		for(auto& f : fonts)
-			delete f.second;
+			if(fresh)
+				texture = new sf::Texture();
+			
+			bool compressed = CompressedImage::isCompressed(d.file);
+			
+			if(!d.loaded || !(compressed ? TextureUploader::upload(*texture, d.compressed, smooth) : texture->loadFromImage(d.image)))
+			{
+				SWIFT_WARNING(Assets, "Unable to load " << d.file << " as a texture.\n");
+				
+				if(fresh)
+				{
+					delete texture;
+					textures.erase(d.file);
+				}
+				
+				return false;
+			}
+			
+			finishTexture(*texture);
+			track(d.file, Category::Textures, compressed ? d.compressed.getMemory() : TextureUploader::getMemory(texture->getSize()));
+			
+			SWIFT_DEBUG(Assets, "Texture:\t" << d.file << '\n');
+		}
+		else if(d.file.find("/sounds/") != std::string::npos)
+		{
+			if(!d.loaded)
+			{
+				SWIFT_WARNING(Assets, "Unable to load " << d.file << " as a sound.\n");
+				return false;
+			}
+			
+			track(d.file, Category::Sounds, d.sound->getSampleCount() * sizeof(sf::Int16));
+			
+			auto it = soundBuffers.find(d.file);
+			
+			if(it != soundBuffers.end())
+				*it->second = *d.sound;
+			else
+				soundBuffers.emplace(d.file, d.sound.release());
+			
+			SWIFT_DEBUG(Assets, "Sound:\t" << d.file << '\n');
+		}
+		else
+		{
+			if(!d.loaded)
+			{
+				SWIFT_WARNING(Assets, "Unable to load " << d.file << " as a font.\n");
+				return false;
+			}
+			
+			auto it = fonts.find(d.file);
+			
+			if(it != fonts.end())
+				*it->second = *d.font;
+			else
+				fonts.emplace(d.file, d.font.release());
+			
+			// fonts read from their data as they're used
+			if(!d.data.empty())
+				keptData[d.file].swap(d.data);
+			
+			SWIFT_DEBUG(Assets, "Font:\t" << d.file << '\n');
+		}
 		
-		for(auto& s : scripts)
-			delete s.second;
+		return true;
 	}
-
-	bool AssetManager::loadResourceFolder(const std::string& folder)
+	
+	void AssetManager::setThreadPool(ThreadPool& tp)
+	{
+		threadPool = &tp;
+	}
+	
+	void AssetManager::setFileIndex(FileIndex& fi)
+	{
+		fileIndex = &fi;
+	}
+	
+	bool AssetManager::gatherFiles(const std::string& folder, std::vector<std::string>& files)
 	{
+		if(fileIndex)
+		{
+			if(fileIndex->gather(folder, files))
+				return true;
+			
+			SWIFT_WARNING(Assets, "Unable to open resource folder: " << folder << "\n");
+			return false;
+		}
+		
 		DIR* dir = nullptr;
 		struct dirent* entry = nullptr;
 
@@ -39,27 +877,21 @@ namespace swift
 		// error handling
 		if(dir == nullptr)
 		{
-			log << "Unable to open resource folder: " << folder << "\n";
+			SWIFT_WARNING(Assets, "Unable to open resource folder: " << folder << "\n");
 			return false;
 		}
 
 		while((entry = readdir(dir)))
 		{
-			if(entry == nullptr)
-			{
-				log << "Unable to read resource folder: " << folder << "\n";
-				return false;
-			}
-
 			// if the entry is a directory, but is not the current or parent directory
 			if(entry->d_type == DT_DIR && !(std::string(entry->d_name).compare(".") == 0 || std::string(entry->d_name).compare("..") == 0))
 			{
-				loadResourceFolder(folder + '/' + std::string(entry->d_name));	// recursive on child directory
+				gatherFiles(folder + '/' + std::string(entry->d_name), files);	// recursive on child directory
 			}
 			// entry is a file
 			else if(entry->d_type == DT_REG)
 			{
-				loadResource(folder + '/' + std::string(entry->d_name));
+				files.push_back(folder + '/' + std::string(entry->d_name));
 			}
 		}
 
@@ -68,26 +900,118 @@ namespace swift
 		return true;
 	}
 	
-	bool AssetManager::loadMod(const Mod& mod)
+	bool AssetManager::loadMods(const std::vector<const Mod*>& mods, const std::string& base)
 	{
-		bool returnVar = true;
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		bool result = true;
+		
+		// the last file of each path, from a pack or loose, in the order paths were first seen
+		struct Winner
+		{
+			const PackFile* pack;
+			std::string source;
+		};
+		
+		std::unordered_map<std::string, Winner> winners;
+		std::vector<std::string> order;
+		
+		auto win = [&](const std::string& file, const PackFile* pack, const std::string& source)
+		{
+			auto it = winners.find(file);
+			
+			if(it == winners.end())
+			{
+				winners.emplace(file, Winner{pack, source});
+				order.push_back(file);
+			}
+			else
+			{
+				it->second = {pack, source};
+			}
+		};
+		
+		for(auto& m : mods)
+		{
+			for(auto& f : m->getFiles())
+			{
+				if(!isPack(f))
+				{
+					win(FileTable::mount(f, m->getFolder(), base), nullptr, f);
+					continue;
+				}
+				
+				// a mod's packs overlay the base's
+				PackFile* pack = openPack(f);
+				
+				if(pack == nullptr)
+				{
+					SWIFT_ERROR(Assets, "In " << m->getName() << ", could not load " << f << '\n');
+					result = false;
+					continue;
+				}
+				
+				for(auto& e : pack->getEntries())
+					win(e.path, pack, "");
+			}
+		}
+		
+		std::vector<std::string> load;
+		std::vector<std::string> replaced;
+		
+		for(auto& file : order)
+		{
+			const Winner& w = winners[file];
+			
+			if(w.pack)
+			{
+				packed[file] = w.pack;
+			}
+			else
+			{
+				packed.erase(file);
+				fileTable.map(file, w.source);
+			}
+			
+			if(isLoaded(file))
+				replaced.push_back(file);
+			else
+				load.push_back(file);
+		}
 		
-		for(auto &f : mod.getFiles())
+		result = loadFiles(load) && result;
+		
+		// already handed out, so loaded into what's there
+		for(auto& file : replaced)
 		{
-			bool temp = true;
-			temp = loadResource(f);
-			if(temp == false)
+			if(!reload(file))
 			{
-				log << "ERROR: In " << mod.getName() << ", could not load " << f << '\n';
-				returnVar = false;
+				SWIFT_ERROR(Assets, "A mod could not replace " << file << '\n');
+				result = false;
 			}
 		}
 		
-		return returnVar;
+		return result;
+	}
+	
+	bool AssetManager::loadMod(const Mod& mod)
+	{
+		return loadMods({&mod});
+	}
+	
+	bool AssetManager::isLoaded(const std::string& file) const
+	{
+		return animTextures.count(file) || textures.count(file) || atlased.count(file) || soundBuffers.count(file)
+			|| music.count(file) || fonts.count(file) || scripts.count(file) || prefabs.count(file);
 	}
 
 	void AssetManager::clean()
 	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		finishPrefetches(true);
+		uploader.release();
+		
 		for(auto& a : animTextures)
 			delete a.second;
 		
@@ -106,12 +1030,28 @@ namespace swift
 		for(auto& s : scripts)
 			delete s.second;
 		
+		for(auto& p : prefabs)
+			delete p.second;
+		
 		animTextures.clear();
 		textures.clear();
 		soundBuffers.clear();
 		music.clear();
 		fonts.clear();
 		scripts.clear();
+		prefabs.clear();
+		
+		atlas.clear();
+		atlased.clear();
+		
+		encodedSounds.clear();
+		encodedMemory = 0;
+		
+		// handles may still point at the entries
+		for(auto& u : usage)
+			u.second.loaded = false;
+		
+		memory.fill(0);
 	}
 
 	void AssetManager::setSmooth(bool s)
@@ -119,80 +1059,317 @@ namespace swift
 		smooth = s;
 		for(auto &t : textures)
 		{
-			t.second->setSmooth(smooth);
+			finishTexture(*t.second);
 		}
+		
+		atlas.setSmooth(smooth);
 	}
 	
-	AnimTexture* AssetManager::getAnimTexture(const std::string& n)
+	void AssetManager::setMipmaps(bool m)
 	{
-		if(animTextures.find(n) != animTextures.end())
-			return animTextures.find(n)->second;
-		else
-			log << "No \"" << n << "\" anim file exists\n";
+		TextureUploader::setMipmaps(m);
 		
-		return nullptr;
+		// those made before, generated now. Tracked again, for the levels they gained or lost
+		for(auto& t : textures)
+		{
+			finishTexture(*t.second);
+			
+			if(!CompressedImage::isCompressed(t.first))
+				track(t.first, Category::Textures, TextureUploader::getMemory(t.second->getSize()));
+		}
+	}
+	
+	void AssetManager::setUploadBudget(std::size_t bytes)
+	{
+		uploader.setBudget(bytes);
+	}
+	
+	AnimTexture* AssetManager::getAnimTexture(const std::string& n)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		return find(animTextures, n, "anim");
 	}
 
 	sf::Texture* AssetManager::getTexture(const std::string& n)
 	{
-		if(textures.find(n) != textures.end())
-			return textures.find(n)->second;
-		else
-			log << "No \"" << n << "\" texture file exists\n";
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		sf::Texture* texture = findTexture(n);
+		
+		if(texture)
+			touch(n, true);
 		
-		return nullptr;
+		return texture;
 	}
 	
 	sf::SoundBuffer* AssetManager::getSoundBuffer(const std::string& n)
 	{
-		if(soundBuffers.find(n) != soundBuffers.end())
-			return soundBuffers.find(n)->second;
-		else
-			log << "No \"" << n << "\" sound buffer file exists\n";
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		sf::SoundBuffer* buffer = findSoundBuffer(n);
 		
-		return nullptr;
+		if(buffer)
+			touch(n, true);
+		
+		return buffer;
 	}
 	
 	sf::Music* AssetManager::getSong(const std::string& n)
 	{
-		if(music.find(n) != music.end())
-			return music.find(n)->second;
-		else
-			log << "No \"" << n << "\" music file exists\n";
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		return find(music, n, "music");
+	}
+	
+	bool AssetManager::findSong(const std::string& n, SongSource& source) const
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		auto inPack = packed.find(n);
 		
-		return nullptr;
+		if(n.find("/music/") == std::string::npos || !(music.count(n) || indexed.count(n) || inPack != packed.end()))
+		{
+			SWIFT_WARNING(Assets, "No \"" << n << "\" music file exists\n");
+			return false;
+		}
+		
+		source = {n, fileTable.resolve(n), inPack != packed.end() ? inPack->second : nullptr};
+		return true;
 	}
 	
-	sf::Font* AssetManager::getFont(const std::string& n)
+	bool AssetManager::openSong(const SongSource& source, sf::Music& music, std::vector<std::uint8_t>& data)
 	{
-		if(fonts.find(n) != fonts.end())
-			return fonts.find(n)->second;
-		else
-			log << "No \"" << n << "\" font file exists\n";
+		if(!source.pack)
+			return music.openFromFile(source.path);
+		
+		const std::uint8_t* bytes = nullptr;
+		std::size_t size = 0;
 		
-		return nullptr;
+		// straight from the pack's mapping, unless it's compressed
+		return readPacked(*source.pack, source.file, bytes, size, data) && music.openFromMemory(bytes, size);
+	}
+	
+	sf::Font* AssetManager::getFont(const std::string& n)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		return find(fonts, n, "font");
 	}
 	
 	Script* AssetManager::getScript(const std::string& n)
 	{
-		if(scripts.find(n) != scripts.end())
-			return scripts.find(n)->second;
-		else
-			log << "No \"" << n << "\" script file exists\n";
-		
-		return nullptr;
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		return find(scripts, n, "script");
+	}
+
+	Prefab* AssetManager::getPrefab(const std::string& n)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		return find(prefabs, n, "prefab");
 	}
 
+	AssetHandle<sf::Texture> AssetManager::acquireTexture(const std::string& n)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		sf::Texture* texture = findTexture(n);
+		
+		return texture ? AssetHandle<sf::Texture>(texture, &touch(n, false).refs) : AssetHandle<sf::Texture>();
+	}
+	
+	AssetHandle<sf::SoundBuffer> AssetManager::acquireSoundBuffer(const std::string& n)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		sf::SoundBuffer* buffer = findSoundBuffer(n);
+		
+		return buffer ? AssetHandle<sf::SoundBuffer>(buffer, &touch(n, false).refs) : AssetHandle<sf::SoundBuffer>();
+	}
+	
+	AssetHandle<sf::Texture> AssetManager::acquireSprite(const std::string& n, sf::IntRect& rect)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		
+		auto it = atlased.find(n);
+		
+		if(it != atlased.end())
+		{
+			rect = it->second.rect;
+			
+			// pages outlive every handle, the count is only kept for n's own texture
+			return AssetHandle<sf::Texture>(const_cast<sf::Texture*>(it->second.texture), &touch(n, false).refs);
+		}
+		
+		AssetHandle<sf::Texture> texture = acquireTexture(n);
+		
+		if(texture)
+			rect = {0, 0, static_cast<int>(texture->getSize().x), static_cast<int>(texture->getSize().y)};
+		
+		return texture;
+	}
+	
+	std::size_t AssetManager::getAtlasPages() const
+	{
+		return atlas.getPageCount();
+	}
+	
+	const std::unordered_map<std::string, Script*>& AssetManager::getScripts() const
+	{
+		return scripts;
+	}
+	
+	void AssetManager::setBudget(Category c, std::size_t bytes)
+	{
+		budgets[static_cast<std::size_t>(c)] = bytes;
+	}
+	
+	std::size_t AssetManager::getBudget(Category c) const
+	{
+		return budgets[static_cast<std::size_t>(c)];
+	}
+	
+	std::size_t AssetManager::getMemory(Category c) const
+	{
+		return memory[static_cast<std::size_t>(c)];
+	}
+	
+	std::size_t AssetManager::getCount(Category c) const
+	{
+		return c == Category::Textures ? textures.size() : soundBuffers.size();
+	}
+	
+	std::size_t AssetManager::getEvictions(Category c) const
+	{
+		return evictions[static_cast<std::size_t>(c)];
+	}
+	
+	sf::Texture* AssetManager::findTexture(const std::string& n)
+	{
+		auto it = atlased.find(n);
+		
+		if(it == atlased.end() || textures.find(n) != textures.end())
+			return find(textures, n, "texture");
+		
+		// by itself, for what draws it whole. Slow, the page is read back from the GPU
+		std::unique_ptr<sf::Texture> texture(new sf::Texture());
+		
+		if(!texture->loadFromImage(it->second.texture->copyToImage(), it->second.rect))
+		{
+			SWIFT_WARNING(Assets, "Unable to copy " << n << " from its atlas page.\n");
+			return nullptr;
+		}
+		
+		finishTexture(*texture);
+		track(n, Category::Textures, TextureUploader::getMemory(texture->getSize()));
+		
+		return textures[n] = texture.release();
+	}
+	
+	sf::SoundBuffer* AssetManager::findSoundBuffer(const std::string& n)
+	{
+		return find(soundBuffers, n, "sound buffer");
+	}
+	
+	void AssetManager::track(const std::string& file, Category c, std::size_t bytes)
+	{
+		Usage& u = usage[file];
+		
+		if(u.loaded)
+			memory[static_cast<std::size_t>(u.category)] -= u.bytes;
+		
+		u.category = c;
+		u.bytes = bytes;
+		u.loaded = true;
+		u.lastUse = ++useClock;
+		
+		memory[static_cast<std::size_t>(c)] += bytes;
+	}
+	
+	AssetManager::Usage& AssetManager::touch(const std::string& file, bool pin)
+	{
+		Usage& u = usage[file];
+		
+		u.lastUse = ++useClock;
+		u.pinned = u.pinned || pin;
+		
+		return u;
+	}
+	
+	void AssetManager::trim()
+	{
+		for(std::size_t c = 0; c < CATEGORIES; c++)
+		{
+			if(budgets[c] == 0 || memory[c] <= budgets[c])
+				continue;
+			
+			std::vector<std::pair<std::uint64_t, const std::string*>> candidates;
+			
+			for(auto& u : usage)
+			{
+				if(static_cast<std::size_t>(u.second.category) == c && u.second.loaded && u.second.refs == 0 && !u.second.pinned)
+					candidates.emplace_back(u.second.lastUse, &u.first);
+			}
+			
+			// least recently used first
+			std::sort(candidates.begin(), candidates.end());
+			
+			for(auto& cand : candidates)
+			{
+				if(memory[c] <= budgets[c])
+					break;
+				
+				const std::string& file = *cand.second;
+				Usage& u = usage[file];
+				
+				if(u.category == Category::Textures)
+				{
+					delete textures[file];
+					textures.erase(file);
+				}
+				else
+				{
+					// sounds still playing it are stopped by SFML
+					delete soundBuffers[file];
+					soundBuffers.erase(file);
+				}
+				
+				memory[c] -= u.bytes;
+				u.loaded = false;
+				evictions[c]++;
+				
+				// loads again when it's next asked for, or is copied from its atlas page again
+				if(atlased.find(file) == atlased.end())
+					indexed.insert(file);
+			}
+		}
+	}
+	
 	bool AssetManager::loadResource(const std::string& file)
 	{
+		SWIFT_PROFILE("AssetManager::loadResource");
+		SWIFT_MEMORY_SCOPE(Assets);
+		
+		// from the pack it's in, if it's in one, otherwise from the file standing in for it
+		const std::string& source = fileTable.resolve(file);
+		auto inPack = packed.find(file);
+		const PackFile* pack = inPack != packed.end() ? inPack->second : nullptr;
+		
+		const std::uint8_t* data = nullptr;
+		std::size_t size = 0;
+		std::vector<std::uint8_t> buffer;
+		
+		if(pack && !readPacked(*pack, file, data, size, buffer))
+		{
+			SWIFT_WARNING(Assets, "Unable to read " << file << " from pack " << pack->getFile() << ".\n");
+			return false;
+		}
+		
 		// this if chain checks what folder the file is in
 		if(file.find("/anims/") != std::string::npos)
 		{
 			animTextures.emplace(file, new AnimTexture());
 			
-			if(!animTextures[file]->loadFromFile(file))
+			if(!(pack ? animTextures[file]->loadFromMemory(data, size, file) : animTextures[file]->loadFromFile(source)))
 			{
-				log << "Unable to load " << file << " as an anim\n";
+				SWIFT_WARNING(Assets, "Unable to load " << file << " as an anim\n");
 				
 				delete animTextures[file];
 				
@@ -200,112 +1377,155 @@ namespace swift
 				return false;
 			}
 			
-			log << "Anim:\t" << file << '\n';
+			SWIFT_DEBUG(Assets, "Anim:\t" << file << '\n');
 		}
 		else if(file.find("/textures/") != std::string::npos)
 		{
+			// a mod's texture replaces an atlased one
+			atlased.erase(file);
 			textures.emplace(file, new sf::Texture());
 
-			if(!textures[file]->loadFromFile(file))
+			if(!loadTexture(*textures[file], file, source, pack ? data : nullptr, size))
 			{
-				log << "Unable to load " << file << " as a texture.\n";
+				SWIFT_WARNING(Assets, "Unable to load " << file << " as a texture.\n");
 				
 				delete textures[file];
 				
 				textures.erase(file);
 				return false;
 			}
-			
-			textures[file]->setSmooth(smooth);
 
-			log << "Texture:\t" << file << '\n';
+			SWIFT_DEBUG(Assets, "Texture:\t" << file << '\n');
 		}
 		else if(file.find("/sounds/") != std::string::npos)
 		{
 			soundBuffers.emplace(file, new sf::SoundBuffer());
+			
+			bool loaded;
+			
+			if(compressedSounds && isCompressedSound(file))
+			{
+				auto encoded = encodedSounds.find(file);
+				
+				// read once, evictions decode it from here again
+				if(encoded == encodedSounds.end())
+				{
+					std::vector<std::uint8_t> bytes;
+					
+					if(pack)
+						bytes.assign(data, data + size);
+					else if(readSource(file, data, size, buffer))
+						bytes.swap(buffer);
+					
+					if(!bytes.empty())
+					{
+						encodedMemory += bytes.size();
+						encoded = encodedSounds.emplace(file, std::move(bytes)).first;
+					}
+				}
+				
+				loaded = encoded != encodedSounds.end() && soundBuffers[file]->loadFromMemory(encoded->second.data(), encoded->second.size());
+			}
+			else
+			{
+				loaded = pack ? soundBuffers[file]->loadFromMemory(data, size) : soundBuffers[file]->loadFromFile(source);
+			}
 
-			if(!soundBuffers[file]->loadFromFile(file))
+			if(!loaded)
 			{
-				log << "Unable to load " << file << " as a sound.\n";
+				SWIFT_WARNING(Assets, "Unable to load " << file << " as a sound.\n");
 				
-				// delete new'd soundbuffer
-				auto it = soundBuffers.end();
-				it--;
-				delete it->second;
+				delete soundBuffers[file];
 				
 				soundBuffers.erase(file);
 				return false;
 			}
 
-			log << "Sound:\t" << file << '\n';
+			track(file, Category::Sounds, soundBuffers[file]->getSampleCount() * sizeof(sf::Int16));
+			
+			SWIFT_DEBUG(Assets, "Sound:\t" << file << '\n');
 		}
 		else if(file.find("/music/") != std::string::npos)
 		{
 			music.emplace(file, new sf::Music());
 
-			if(!music[file]->openFromFile(file))
+			// streams from data as it plays
+			if(!(pack ? music[file]->openFromMemory(data, size) : music[file]->openFromFile(source)))
 			{
-				log << "Unable to open " << file << " as a music file.\n";
+				SWIFT_WARNING(Assets, "Unable to open " << file << " as a music file.\n");
 				
-				// delete new'd music
-				auto it = music.end();
-				it--;
-				delete it->second;
+				delete music[file];
 				
 				music.erase(file);
 				return false;
 			}
 
-			log << "Music:\t" << file << '\n';
+			if(!buffer.empty())
+				keptData[file].swap(buffer);
+			
+			SWIFT_DEBUG(Assets, "Music:\t" << file << '\n');
 		}
 		else if(file.find("/fonts/") != std::string::npos)
 		{
 			fonts.emplace(file, new sf::Font());
 
-			if(!fonts[file]->loadFromFile(file))
+			if(!(pack ? fonts[file]->loadFromMemory(data, size) : fonts[file]->loadFromFile(source)))
 			{
-				log << "Unable to load " << file << " as a font.\n";
+				SWIFT_WARNING(Assets, "Unable to load " << file << " as a font.\n");
 				
-				// delete new'd font
-				auto it = fonts.end();
-				it--;
-				delete it->second;
+				delete fonts[file];
 				
 				fonts.erase(file);
 				return false;
 			}
 
-			log << "Font:\t" << file << '\n';
+			if(!buffer.empty())
+				keptData[file].swap(buffer);
+			
+			SWIFT_DEBUG(Assets, "Font:\t" << file << '\n');
 		}
 		else if(file.find("/scripts/") != std::string::npos)
 		{
 			scripts.emplace(file, new Script());
 			
-			if(!scripts[file]->loadFromFile(file))
+			if(!(pack ? scripts[file]->loadFromMemory(data, size, file) : scripts[file]->loadFromFile(source)))
 			{
-				log << "Unable to load " << file << " as a script.\n";
+				SWIFT_WARNING(Assets, "Unable to load " << file << " as a script.\n");
 				
-				// delete new'd script
-				auto it = scripts.end();
-				it--;
-				delete it->second;
+				delete scripts[file];
 				
 				scripts.erase(file);
 				return false;
 			}
 			
-			log << "Script:\t" << file << '\n';
+			SWIFT_DEBUG(Assets, "Script:\t" << file << '\n');
 			
 			scripts[file]->load("./data/saves/" + file.substr(file.find_last_of('/') + 1) + ".script");
 		}
+		else if(file.find("/prefabs/") != std::string::npos)
+		{
+			prefabs.emplace(file, new Prefab());
+			
+			if(!(pack ? prefabs[file]->loadFromMemory(data, size, file) : prefabs[file]->loadFromFile(source)))
+			{
+				SWIFT_WARNING(Assets, "Unable to load " << file << " as a prefab.\n");
+				
+				delete prefabs[file];
+				
+				prefabs.erase(file);
+				return false;
+			}
+			
+			SWIFT_DEBUG(Assets, "Prefab:\t" << file << '\n');
+		}
 		else if(file.find(".txt") != std::string::npos)
 		{
 			// ignore *.txt files, but don't throw a warning/error
-			log << "Ignoring " << file << '\n';
+			SWIFT_DEBUG(Assets, "Ignoring " << file << '\n');
 		}
 		else
 		{
-			log << "WARNING: " << file << " is an unknown resource type.\n";
+			SWIFT_WARNING(Assets, file << " is an unknown resource type.\n");
 			return false;
 		}
 		return true;
@@ -2,22 +2,42 @@
 #define ASSET_MANAGER_HPP
 
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <array>
+#include <cstdint>
 #include <utility>
 #include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <atomic>
 
 #include <dirent.h>
 
 #include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Audio/SoundBuffer.hpp>
 #include <SFML/Audio/Music.hpp>
 #include "../Animation/AnimTexture.hpp"
 #include "../Scripting/Script.hpp"
+#include "../EntitySystem/Prefab.hpp"
 
 #include "../Logger/Logger.hpp"
+#include "../Threading/ThreadPool.hpp"
 
 #include "Mod.hpp"
+#include "AssetHandle.hpp"
+#include "TextureAtlas.hpp"
+#include "TextureUploader.hpp"
+#include "CompressedImage.hpp"
+#include "FileWatcher.hpp"
+#include "FileTable.hpp"
+#include "FileIndex.hpp"
+#include "../Serialization/PackFile.hpp"
 
 namespace swift
 {
@@ -32,6 +52,79 @@ namespace swift
 			// The function returns false if it cannot find the given folder, and returns true if otherwise.
 			bool loadResourceFolder(const std::string& folder);
 			
+			// the files of every folder are gathered first. Images, sounds, and fonts are then decoded on the thread pool,
+			// and textures uploaded on this thread, which must own the GL context. The rest load here, in folder order
+			bool loadResourceFolders(const std::vector<std::string>& folders);
+			
+			// loads the files of a pack made by PackFile::write, which then shadow loose files and earlier packs of the same
+			// path. .pack files found in resource folders, and in mods, are mounted this way
+			bool mountPack(const std::string& file);
+			
+			// packs every file under folders, under the same paths loadResourceFolders would load them as
+			static bool writePack(const std::string& pack, const std::vector<std::string>& folders);
+			
+			// decodes on the pool's threads. Without one, loadResourceFolders decodes everything itself
+			static void setThreadPool(ThreadPool& tp);
+			
+			// folders are gathered through it, so unchanged ones aren't walked again. Without one, every folder is walked
+			static void setFileIndex(FileIndex& fi);
+			
+			// set before loading folders. Lazily, loading folders only finds their files, and each is loaded by the first
+			// get that asks for it. Pointers returned by the getters stay the same either way
+			void setLazy(bool l);
+			
+			// starts decoding the images, sounds, and fonts of files not yet loaded on a thread of its own. update
+			// stores what has finished. A get of a file still decoding waits for it, there are no placeholders,
+			// as sprites take their size from the texture they're given
+			void prefetch(const std::vector<std::string>& files);
+			
+			// prefetches the files listed in file, one per line. False if it can't be opened
+			bool prefetchManifest(const std::string& file);
+			
+			// set before loading folders. .ogg and .flac sounds are then kept in memory as their files' bytes, and each is only
+			// decoded by the first get that asks for it. The Sounds budget bounds what's decoded: past it, the least recently
+			// used go back to their bytes, decoded from memory again when next asked for, instead of read from their files
+			void setCompressedSounds(bool c);
+			
+			// bytes of sounds kept as they are in their files
+			std::size_t getCompressedMemory() const;
+			
+			// set before loading folders. Textures loaded along with others by loadResourceFolders, no more than
+			// maxSize on a side, are then packed onto shared atlas pages. Ones loaded on their own, lazily, by a mod,
+			// or prefetched, aren't. 0 atlases none
+			void setAtlas(unsigned maxSize);
+			
+			// watches the loose files under folders. update then reloads the loaded textures, sounds, fonts, anims,
+			// and scripts that change, into what they were loaded into, so pointers and handles to them stay valid.
+			// Files in packs, music, and prefabs aren't reloaded
+			bool watch(const std::vector<std::string>& folders);
+			
+			// stores prefetched assets that are done decoding, on the GL thread, reloads changed files if
+			// watching, then evicts what's over budget
+			void update();
+			
+			// what budgets apply to. Other assets are small, or hold state, and are kept
+			enum class Category
+			{
+				Textures,
+				Sounds,
+				Count
+			};
+			
+			// bytes of loaded assets of category before the least recently used ones are evicted, 0 for no limit.
+			// only assets with no handles to them that were never handed out by a getter as a pointer are evicted.
+			// evicted assets load again, from their file, on their next get
+			void setBudget(Category c, std::size_t bytes);
+			std::size_t getBudget(Category c) const;
+			std::size_t getMemory(Category c) const;
+			std::size_t getCount(Category c) const;
+			std::size_t getEvictions(Category c) const;
+			
+			// mods, in order, stand in for the files of the same path under base, later mods for earlier ones. Which file
+			// wins each path is settled first, so files a later mod replaces aren't loaded at all. Assets already loaded
+			// from the base are loaded again into what they were loaded into, except for music and prefabs
+			bool loadMods(const std::vector<const Mod*>& mods, const std::string& base = "./data");
+			
 			bool loadMod(const Mod& mod);
 			
 			// destroys all resources the AssetManager contains
@@ -40,24 +133,218 @@ namespace swift
 			// sets the AssetManager to load textures with smoothing (antialiasing)
 			void setSmooth(bool s);
 			
+			// textures get mipmaps, for views zoomed out past their size. Applies to loaded textures too, not atlas pages
+			void setMipmaps(bool m);
+			
+			// bytes of prefetched textures uploaded each update, so a large one is spread over a few frames instead of
+			// hitching one. They're only got once they're done, a get of one being uploaded finishes it. 0, the default,
+			// uploads each as soon as it's decoded
+			void setUploadBudget(std::size_t bytes);
+			
 			AnimTexture* getAnimTexture(const std::string& n);
 			sf::Texture* getTexture(const std::string& n);
 			sf::SoundBuffer* getSoundBuffer(const std::string& n);
 			sf::Music* getSong(const std::string& n);
+			
+			// where a song is read from, for opening it somewhere else than getSong does
+			struct SongSource
+			{
+				std::string file;
+				std::string path;		// loose file it resolves to
+				const PackFile* pack;	// nullptr if it's loose
+			};
+			
+			// false if there's no song n
+			bool findSong(const std::string& n, SongSource& source) const;
+			
+			// opens source into music, with data holding what music streams from if there has to be a copy.
+			// Only touches its arguments, safe on any thread. data has to last as long as music is open
+			static bool openSong(const SongSource& source, sf::Music& music, std::vector<std::uint8_t>& data);
 			sf::Font* getFont(const std::string& n);
 			Script* getScript(const std::string& n);
+			Prefab* getPrefab(const std::string& n);
+			
+			// pointers from the getters are kept loaded for good, as the manager can't tell when they're no longer used.
+			// handles keep theirs loaded while they exist. Handles must not outlive the manager
+			AssetHandle<sf::Texture> acquireTexture(const std::string& n);
+			AssetHandle<sf::SoundBuffer> acquireSoundBuffer(const std::string& n);
+			
+			// what a sprite of n is drawn with: its atlas page and where n is on it, or n's own texture and all of it.
+			// getTexture and acquireTexture give atlased textures a texture of their own, copied from the page
+			AssetHandle<sf::Texture> acquireSprite(const std::string& n, sf::IntRect& rect);
+			
+			std::size_t getAtlasPages() const;
+			
+			// scripts loaded so far, by file
+			const std::unordered_map<std::string, Script*>& getScripts() const;
 
 		private:
 			bool loadResource(const std::string& file);
 			
-			std::map<std::string, AnimTexture*> animTextures;
-			std::map<std::string, sf::Texture*> textures;
-			std::map<std::string, sf::SoundBuffer*> soundBuffers;
-			std::map<std::string, sf::Music*> music;
-			std::map<std::string, sf::Font*> fonts;
-			std::map<std::string, Script*> scripts;
+			// what loadResourceFolders does once it has its files
+			bool loadFiles(const std::vector<std::string>& files);
+			
+			static bool isPack(const std::string& file);
+			
+			// opens file, without loading from it. nullptr if it can't be
+			PackFile* openPack(const std::string& file);
+			
+			// data of file, from its pack, or from the file it resolves to, into buffer
+			bool readSource(const std::string& file, const std::uint8_t*& data, std::size_t& size, std::vector<std::uint8_t>& buffer) const;
+			
+			// loaded, or atlased
+			bool isLoaded(const std::string& file) const;
+			
+			// data is in the pack's mapping for files stored as they are, in buffer for compressed ones
+			static bool readPacked(const PackFile& pack, const std::string& file, const std::uint8_t*& data, std::size_t& size, std::vector<std::uint8_t>& buffer);
+			
+			// every regular file under folder, recursively
+			static bool gatherFiles(const std::string& folder, std::vector<std::string>& files);
+			
+			// images, sounds, and fonts, which can be decoded off the GL thread
+			struct Decoded
+			{
+				std::string file;
+				std::string source;					// loose file it's read from
+				const PackFile* pack;				// nullptr if it's loose
+				std::vector<std::uint8_t> data;		// decompressed from the pack
+				sf::Image image;
+				std::unique_ptr<sf::SoundBuffer> sound;
+				std::unique_ptr<sf::Font> font;
+				bool loaded;
+				CompressedImage compressed;			// for .dds and .ktx textures, instead of image
+			};
+			
+			static bool isDecodable(const std::string& file);
+			
+			// a sound in a format setCompressedSounds keeps, wavs are as big as what they decode to
+			static bool isCompressedSound(const std::string& file);
+			
+			Decoded makeDecoded(const std::string& file) const;
+			
+			// only touches d, safe on any thread
+			static void decode(Decoded& d);
+			
+			// uploads textures, and takes over what was decoded
+			bool store(Decoded& d);
+			
+			// hands a prefetched texture to the uploader, false if it's uploaded right away instead
+			bool stage(Decoded& d);
+			
+			// after a texture's pixels changed, its smoothing and mipmaps
+			void finishTexture(sf::Texture& texture);
+			
+			// file, compressed or not, from data, or from source if there's none
+			bool loadTexture(sf::Texture& texture, const std::string& file, const std::string& source, const std::uint8_t* data, std::size_t size);
+			
+			// file changed on disk. False if it isn't loaded, or didn't load again
+			bool reload(const std::string& file);
+			
+			// loads n if it was indexed and isn't yet, waiting for it if it's being prefetched
+			void require(const std::string& n);
+			
+			// stores finished prefetches, or all of them if wait
+			void finishPrefetches(bool wait);
+			
+			// n in assets, loading it first if it's indexed. One hashed lookup for assets already loaded
+			template<typename T>
+			T* find(std::unordered_map<std::string, T*>& assets, const std::string& n, const char* kind)
+			{
+				auto it = assets.find(n);
+				
+				if(it != assets.end())
+					return it->second;
+				
+				require(n);
+				it = assets.find(n);
+				
+				if(it != assets.end())
+					return it->second;
+				
+				SWIFT_WARNING(Assets, "No \"" << n << "\" " << kind << " file exists\n");
+				return nullptr;
+			}
+			
+			// sprites of d too small to draw by themselves are packed onto atlas pages, and taken out of d
+			void packAtlas(std::vector<Decoded>& decoded);
+			
+			// loading it first if needed, without pinning it
+			sf::Texture* findTexture(const std::string& n);
+			sf::SoundBuffer* findSoundBuffer(const std::string& n);
+			
+			// loaded textures and sound buffers
+			struct Usage
+			{
+				Category category;
+				std::size_t bytes;
+				std::atomic<unsigned> refs;	// handles to it. Entries aren't removed, so handles can point here
+				bool pinned;			// handed out as a pointer
+				bool loaded;
+				std::uint64_t lastUse;
+			};
+			
+			// a file of c was loaded
+			void track(const std::string& file, Category c, std::size_t bytes);
+			
+			// the file was asked for, pin if it was as a pointer
+			Usage& touch(const std::string& file, bool pin);
+			
+			// unloads the least recently used evictable assets of each category over its budget
+			void trim();
+			
+			std::unordered_map<std::string, AnimTexture*> animTextures;
+			std::unordered_map<std::string, sf::Texture*> textures;
+			std::unordered_map<std::string, sf::SoundBuffer*> soundBuffers;
+			std::unordered_map<std::string, sf::Music*> music;
+			std::unordered_map<std::string, sf::Font*> fonts;
+			std::unordered_map<std::string, Script*> scripts;
+			std::unordered_map<std::string, Prefab*> prefabs;
 			
 			bool smooth;
+			bool lazy;
+			bool compressedSounds;
+			
+			// textures being uploaded over a few updates, not in textures until they're done
+			TextureUploader uploader;
+			std::unordered_map<std::string, sf::Texture*> staged;
+			
+			TextureAtlas atlas;
+			unsigned atlasMax;		// side of the largest texture atlased
+			std::unordered_map<std::string, TextureAtlas::Region> atlased;
+			
+			std::unique_ptr<FileWatcher> watcher;
+			
+			// loose files replacing others, from mods
+			FileTable fileTable;
+			
+			std::unordered_set<std::string> indexed;		// found, not loaded yet
+			std::unordered_set<std::string> pending;		// being prefetched
+			std::list<std::future<std::vector<Decoded>>> prefetches;
+			
+			// node based, so the counts handles point at stay put as it grows
+			std::unordered_map<std::string, Usage> usage;
+			std::uint64_t useClock;
+			
+			static constexpr std::size_t CATEGORIES = static_cast<std::size_t>(Category::Count);
+			std::array<std::size_t, CATEGORIES> budgets;
+			std::array<std::size_t, CATEGORIES> memory;
+			std::array<std::size_t, CATEGORIES> evictions;
+			
+			std::vector<std::unique_ptr<PackFile>> packs;
+			std::unordered_map<std::string, const PackFile*> packed;	// by path, the last mounted pack with it
+			
+			// decompressed music and fonts, which are read from as they're used
+			std::unordered_map<std::string, std::vector<std::uint8_t>> keptData;
+			
+			// sounds' files, by path, while compressedSounds. Kept when their buffers are evicted
+			std::unordered_map<std::string, std::vector<std::uint8_t>> encodedSounds;
+			std::size_t encodedMemory;
+			
+			// worlds ticking on other threads get and acquire assets too. Recursive, as loading one can get others
+			mutable std::recursive_mutex mutex;
+			
+			static ThreadPool* threadPool;
+			static FileIndex* fileIndex;
 	};
 }
 
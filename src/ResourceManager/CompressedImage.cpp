@@ -0,0 +1,204 @@
+#include "CompressedImage.hpp"
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace swift
+{
+	namespace
+	{
+		std::uint32_t readUInt32(const std::uint8_t* data)
+		{
+			return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<std::uint32_t>(data[3]) << 24);
+		}
+		
+		bool endsWith(const std::string& s, const char* end)
+		{
+			std::size_t length = std::strlen(end);
+			return s.size() >= length && s.compare(s.size() - length, length, end) == 0;
+		}
+	}
+	
+	bool CompressedImage::isCompressed(const std::string& file)
+	{
+		return endsWith(file, ".dds") || endsWith(file, ".ktx");
+	}
+	
+	bool CompressedImage::loadFromMemory(const std::uint8_t* data, std::size_t size)
+	{
+		format = None;
+		levels.clear();
+		pixels.clear();
+		
+		bool result = false;
+		
+		if(size >= 4 && std::memcmp(data, "DDS ", 4) == 0)
+			result = loadDds(data, size);
+		else if(size >= 12 && std::memcmp(data, "\xABKTX 11\xBB\r\n\x1A\n", 12) == 0)
+			result = loadKtx(data, size);
+		
+		if(!result)
+		{
+			format = None;
+			levels.clear();
+			pixels.clear();
+		}
+		
+		return result;
+	}
+	
+	bool CompressedImage::loadFromFile(const std::string& file)
+	{
+		std::ifstream fin(file, std::ios::binary);
+		
+		if(!fin)
+			return false;
+		
+		std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		
+		return loadFromMemory(data.data(), data.size());
+	}
+	
+	CompressedImage::Format CompressedImage::getFormat() const
+	{
+		return format;
+	}
+	
+	sf::Vector2u CompressedImage::getSize() const
+	{
+		return levels.empty() ? sf::Vector2u() : levels.front().size;
+	}
+	
+	const std::vector<CompressedImage::Level>& CompressedImage::getLevels() const
+	{
+		return levels;
+	}
+	
+	const std::uint8_t* CompressedImage::getData(const Level& level) const
+	{
+		return pixels.data() + level.offset;
+	}
+	
+	std::size_t CompressedImage::getMemory() const
+	{
+		return pixels.size();
+	}
+	
+	bool CompressedImage::loadDds(const std::uint8_t* data, std::size_t size)
+	{
+		// magic, then a 124 byte header, then a 20 byte one for the DXGI format if the four cc is DX10
+		if(size < 128 || readUInt32(data + 4) != 124)
+			return false;
+		
+		sf::Vector2u dimensions(readUInt32(data + 16), readUInt32(data + 12));
+		unsigned mipCount = std::max<std::uint32_t>(readUInt32(data + 28), 1);
+		const std::uint8_t* fourCC = data + 84;
+		std::size_t offset = 128;
+		
+		if(std::memcmp(fourCC, "DXT1", 4) == 0)
+			format = BC1;
+		else if(std::memcmp(fourCC, "DXT3", 4) == 0)
+			format = BC2;
+		else if(std::memcmp(fourCC, "DXT5", 4) == 0)
+			format = BC3;
+		else if(std::memcmp(fourCC, "DX10", 4) == 0 && size >= 148)
+		{
+			// the UNORM and SRGB variants of BC1-3, sampled the same here
+			switch(readUInt32(data + 128))
+			{
+				case 71: case 72:
+					format = BC1;
+					break;
+				case 74: case 75:
+					format = BC2;
+					break;
+				case 77: case 78:
+					format = BC3;
+					break;
+				default:
+					return false;
+			}
+			
+			offset = 148;
+		}
+		else
+			return false;
+		
+		if(dimensions.x == 0 || dimensions.y == 0)
+			return false;
+		
+		for(unsigned l = 0; l < mipCount; l++)
+		{
+			std::size_t bytes = getLevelSize(format, dimensions);
+			
+			if(offset + bytes > size)
+				return false;
+			
+			levels.push_back({dimensions, pixels.size(), bytes});
+			pixels.insert(pixels.end(), data + offset, data + offset + bytes);
+			offset += bytes;
+			
+			if(dimensions.x == 1 && dimensions.y == 1)
+				break;
+			
+			dimensions = {std::max(dimensions.x / 2, 1u), std::max(dimensions.y / 2, 1u)};
+		}
+		
+		return true;
+	}
+	
+	bool CompressedImage::loadKtx(const std::uint8_t* data, std::size_t size)
+	{
+		// identifier, then 13 32 bit fields. Only files written little endian
+		if(size < 64 || readUInt32(data + 12) != 0x04030201)
+			return false;
+		
+		format = static_cast<Format>(readUInt32(data + 28));
+		
+		if(format != BC1 && format != BC2 && format != BC3 && format != ETC2 && format != ETC2Alpha)
+			return false;
+		
+		sf::Vector2u dimensions(readUInt32(data + 36), readUInt32(data + 40));
+		
+		// arrays, cube maps, and 3D textures
+		if(dimensions.x == 0 || dimensions.y == 0 || readUInt32(data + 44) > 1 || readUInt32(data + 48) > 0 || readUInt32(data + 52) != 1)
+			return false;
+		
+		unsigned mipCount = std::max<std::uint32_t>(readUInt32(data + 56), 1);
+		std::size_t offset = 64 + static_cast<std::size_t>(readUInt32(data + 60));
+		
+		for(unsigned l = 0; l < mipCount; l++)
+		{
+			if(offset + 4 > size)
+				return false;
+			
+			std::size_t bytes = readUInt32(data + offset);
+			offset += 4;
+			
+			if(bytes != getLevelSize(format, dimensions) || offset + bytes > size)
+				return false;
+			
+			levels.push_back({dimensions, pixels.size(), bytes});
+			pixels.insert(pixels.end(), data + offset, data + offset + bytes);
+			
+			// levels are padded to 4 bytes
+			offset += (bytes + 3) & ~static_cast<std::size_t>(3);
+			
+			if(dimensions.x == 1 && dimensions.y == 1)
+				break;
+			
+			dimensions = {std::max(dimensions.x / 2, 1u), std::max(dimensions.y / 2, 1u)};
+		}
+		
+		return true;
+	}
+	
+	std::size_t CompressedImage::getLevelSize(Format format, const sf::Vector2u& size)
+	{
+		// all of them are 4x4 blocks, of 8 bytes without a separate alpha block and 16 with
+		std::size_t blocks = static_cast<std::size_t>((size.x + 3) / 4) * ((size.y + 3) / 4);
+		
+		return blocks * (format == BC1 || format == ETC2 ? 8 : 16);
+	}
+}
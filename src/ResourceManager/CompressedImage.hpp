@@ -0,0 +1,65 @@
+#ifndef COMPRESSED_IMAGE_HPP
+#define COMPRESSED_IMAGE_HPP
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include <SFML/System/Vector2.hpp>
+
+namespace swift
+{
+	// a texture already in a format the GPU samples as it is, as made by the asset pipeline: BC1-3 (DXT1/3/5) in .dds
+	// files, and those or ETC2 in .ktx files. Kept as it's stored, with the mip levels the file has, for upload
+	class CompressedImage
+	{
+		public:
+			// OpenGL internal formats
+			enum Format : unsigned
+			{
+				None = 0,
+				BC1 = 0x83F1,			// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+				BC2 = 0x83F2,			// GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+				BC3 = 0x83F3,			// GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+				ETC2 = 0x9274,			// GL_COMPRESSED_RGB8_ETC2
+				ETC2Alpha = 0x9278,		// GL_COMPRESSED_RGBA8_ETC2_EAC
+			};
+			
+			struct Level
+			{
+				sf::Vector2u size;
+				std::size_t offset;		// into the data
+				std::size_t bytes;
+			};
+			
+			// .dds and .ktx files, by their extension
+			static bool isCompressed(const std::string& file);
+			
+			// only touch the image, safe on any thread. False for other formats, or data that's cut short
+			bool loadFromMemory(const std::uint8_t* data, std::size_t size);
+			bool loadFromFile(const std::string& file);
+			
+			Format getFormat() const;
+			sf::Vector2u getSize() const;
+			
+			const std::vector<Level>& getLevels() const;
+			const std::uint8_t* getData(const Level& level) const;
+			
+			// bytes of every level
+			std::size_t getMemory() const;
+		
+		private:
+			bool loadDds(const std::uint8_t* data, std::size_t size);
+			bool loadKtx(const std::uint8_t* data, std::size_t size);
+			
+			// bytes of a level of format and size
+			static std::size_t getLevelSize(Format format, const sf::Vector2u& size);
+			
+			Format format = None;
+			std::vector<Level> levels;
+			std::vector<std::uint8_t> pixels;
+	};
+}
+
+#endif // COMPRESSED_IMAGE_HPP
@@ -0,0 +1,237 @@
+#include "FileIndex.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "../Serialization/ByteStream.hpp"
+#include "../Serialization/AsyncWriter.hpp"
+
+namespace swift
+{
+	FileIndex::FileIndex()
+	:	changed(false),
+		reused(0),
+		walked(0)
+	{
+	}
+	
+	bool FileIndex::load(const std::string& f)
+	{
+		file = f;
+		trees.clear();
+		values.clear();
+		changed = false;
+		reused = 0;
+		walked = 0;
+		
+		std::ifstream fin(file, std::ios::binary);
+		
+		if(!fin)
+			return false;
+		
+		std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		ByteReader in(bytes);
+		
+		if(in.readUInt32() != INDEX_MAGIC || in.readByte() != INDEX_VERSION)
+			return false;
+		
+		std::uint64_t treeCount = in.readUInt();
+		
+		for(std::uint64_t t = 0; t < treeCount && in.good(); t++)
+		{
+			std::string folder = in.readString();
+			Tree& tree = trees[folder];
+			
+			std::uint64_t directories = in.readUInt();
+			
+			for(std::uint64_t d = 0; d < directories && in.good(); d++)
+			{
+				std::string directory = in.readString();
+				tree.directories.emplace_back(directory, in.readInt());
+			}
+			
+			std::uint64_t files = in.readUInt();
+			
+			for(std::uint64_t i = 0; i < files && in.good(); i++)
+				tree.files.push_back(in.readString());
+		}
+		
+		std::uint64_t valueCount = in.readUInt();
+		
+		for(std::uint64_t v = 0; v < valueCount && in.good(); v++)
+		{
+			Values& entry = values[in.readString()];
+			entry.time = in.readInt();
+			
+			std::uint64_t count = in.readUInt();
+			
+			for(std::uint64_t i = 0; i < count && in.good(); i++)
+				entry.values.push_back(in.readString());
+		}
+		
+		// what's damaged is walked and parsed again
+		if(!in.good())
+		{
+			trees.clear();
+			values.clear();
+			return false;
+		}
+		
+		return true;
+	}
+	
+	bool FileIndex::save()
+	{
+		if(!changed || file.empty())
+			return true;
+		
+		ByteWriter out;
+		out.writeUInt32(INDEX_MAGIC);
+		out.writeByte(INDEX_VERSION);
+		
+		out.writeUInt(trees.size());
+		
+		for(auto& t : trees)
+		{
+			out.writeString(t.first);
+			out.writeUInt(t.second.directories.size());
+			
+			for(auto& d : t.second.directories)
+			{
+				out.writeString(d.first);
+				out.writeInt(d.second);
+			}
+			
+			out.writeUInt(t.second.files.size());
+			
+			for(auto& f : t.second.files)
+				out.writeString(f);
+		}
+		
+		out.writeUInt(values.size());
+		
+		for(auto& v : values)
+		{
+			out.writeString(v.first);
+			out.writeInt(v.second.time);
+			out.writeUInt(v.second.values.size());
+			
+			for(auto& s : v.second.values)
+				out.writeString(s);
+		}
+		
+		changed = !AsyncWriter::write(file, out.getData(), AsyncWriter::Mode::Replace);
+		
+		return !changed;
+	}
+	
+	bool FileIndex::gather(const std::string& folder, std::vector<std::string>& files)
+	{
+		auto it = trees.find(folder);
+		
+		if(it != trees.end())
+		{
+			bool same = true;
+			
+			// a stat for each directory, instead of reading every entry of each
+			for(auto& d : it->second.directories)
+			{
+				if(getTime(d.first) != d.second)
+				{
+					same = false;
+					break;
+				}
+			}
+			
+			if(same)
+			{
+				files.insert(files.end(), it->second.files.begin(), it->second.files.end());
+				reused++;
+				return true;
+			}
+		}
+		
+		Tree tree;
+		
+		if(!walk(folder, tree))
+		{
+			trees.erase(folder);
+			return false;
+		}
+		
+		files.insert(files.end(), tree.files.begin(), tree.files.end());
+		trees[folder] = std::move(tree);
+		changed = true;
+		walked++;
+		
+		return true;
+	}
+	
+	bool FileIndex::findValues(const std::string& f, std::vector<std::string>& found) const
+	{
+		auto it = values.find(f);
+		
+		if(it == values.end() || it->second.time != getTime(f))
+			return false;
+		
+		found = it->second.values;
+		return true;
+	}
+	
+	void FileIndex::storeValues(const std::string& f, const std::vector<std::string>& v)
+	{
+		values[f] = {getTime(f), v};
+		changed = true;
+	}
+	
+	unsigned FileIndex::getReused() const
+	{
+		return reused;
+	}
+	
+	unsigned FileIndex::getWalked() const
+	{
+		return walked;
+	}
+	
+	std::int64_t FileIndex::getTime(const std::string& path)
+	{
+		struct stat info;
+		
+		if(stat(path.c_str(), &info) != 0)
+			return -1;
+		
+		return static_cast<std::int64_t>(info.st_mtime);
+	}
+	
+	bool FileIndex::walk(const std::string& folder, Tree& tree)
+	{
+		// before reading it, so a change while it's read is caught next time
+		std::int64_t time = getTime(folder);
+		DIR* dir = opendir(folder.c_str());
+		
+		if(dir == nullptr)
+			return false;
+		
+		tree.directories.emplace_back(folder, time);
+		
+		struct dirent* entry = nullptr;
+		
+		while((entry = readdir(dir)))
+		{
+			std::string name = entry->d_name;
+			
+			if(entry->d_type == DT_DIR && name != "." && name != "..")
+				walk(folder + '/' + name, tree);
+			else if(entry->d_type == DT_REG)
+				tree.files.push_back(folder + '/' + name);
+		}
+		
+		closedir(dir);
+		
+		return true;
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef FILE_INDEX_HPP
+#define FILE_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace swift
+{
+	// what's under content folders, and what was read from small files, kept between runs so a warm start skips
+	// what hasn't changed. A folder's files are used again while none of its directories' modification times changed,
+	// which adding, removing, or renaming a file does, but editing one doesn't
+	class FileIndex
+	{
+		public:
+			FileIndex();
+			
+			// false if there's no index at file yet, or it's damaged or from another version. save writes to file either way
+			bool load(const std::string& file);
+			
+			// if anything changed since it was loaded
+			bool save();
+			
+			// the regular files under folder, recursively, as walking it finds them. False if it can't be opened
+			bool gather(const std::string& folder, std::vector<std::string>& files);
+			
+			// values parsed from file, like a mod's info, while its modification time is the one they were stored with
+			bool findValues(const std::string& file, std::vector<std::string>& values) const;
+			void storeValues(const std::string& file, const std::vector<std::string>& values);
+			
+			// folders whose files were used again, and ones that were walked, since it was loaded
+			unsigned getReused() const;
+			unsigned getWalked() const;
+		
+		private:
+			struct Tree
+			{
+				std::vector<std::pair<std::string, std::int64_t>> directories;	// every one under the folder, with its time
+				std::vector<std::string> files;
+			};
+			
+			struct Values
+			{
+				std::int64_t time;
+				std::vector<std::string> values;
+			};
+			
+			// modification time, -1 if it doesn't exist
+			static std::int64_t getTime(const std::string& path);
+			
+			static bool walk(const std::string& folder, Tree& tree);
+			
+			static const std::uint32_t INDEX_MAGIC = 0x49465753;	// "SWFI"
+			static const std::uint8_t INDEX_VERSION = 1;
+			
+			std::string file;
+			std::unordered_map<std::string, Tree> trees;
+			std::unordered_map<std::string, Values> values;
+			bool changed;
+			
+			unsigned reused;
+			unsigned walked;
+	};
+}
+
+#endif // FILE_INDEX_HPP
@@ -0,0 +1,54 @@
+#include "FileTable.hpp"
+
+namespace swift
+{
+	void FileTable::map(const std::string& file, const std::string& source)
+	{
+		auto it = sources.find(file);
+		
+		// the source it had loses
+		if(it != sources.end())
+		{
+			files[it->second].clear();
+			it->second = source;
+		}
+		else
+		{
+			sources.emplace(file, source);
+		}
+		
+		files[source] = file;
+		
+		// a base file mapped over loses to its replacement
+		if(file != source)
+			files[file].clear();
+	}
+	
+	const std::string& FileTable::resolve(const std::string& file) const
+	{
+		auto it = sources.find(file);
+		
+		return it != sources.end() ? it->second : file;
+	}
+	
+	std::string FileTable::reverse(const std::string& source) const
+	{
+		auto it = files.find(source);
+		
+		return it != files.end() ? it->second : source;
+	}
+	
+	std::string FileTable::mount(const std::string& source, const std::string& folder, const std::string& base)
+	{
+		if(folder.empty() || source.compare(0, folder.size(), folder) != 0)
+			return source;
+		
+		return base + source.substr(folder.size());
+	}
+	
+	void FileTable::clear()
+	{
+		sources.clear();
+		files.clear();
+	}
+}
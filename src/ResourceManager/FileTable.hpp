@@ -0,0 +1,34 @@
+#ifndef FILE_TABLE_HPP
+#define FILE_TABLE_HPP
+
+#include <string>
+#include <unordered_map>
+
+namespace swift
+{
+	// where files are read from, by the path assets are known by. Mods' files stand in for the base's of the same
+	// path, so the winner of each path is settled here first, and only the winners are loaded
+	class FileTable
+	{
+		public:
+			// file is read from source from now on
+			void map(const std::string& file, const std::string& source);
+			
+			// what file is read from, file itself if it isn't mapped
+			const std::string& resolve(const std::string& file) const;
+			
+			// the file source is read for. Empty if source lost to another, source itself if it isn't mapped
+			std::string reverse(const std::string& source) const;
+			
+			// source's path for a mod in folder, under base in place of the folder
+			static std::string mount(const std::string& source, const std::string& folder, const std::string& base);
+			
+			void clear();
+			
+		private:
+			std::unordered_map<std::string, std::string> sources;	// by file
+			std::unordered_map<std::string, std::string> files;		// by source
+	};
+}
+
+#endif // FILE_TABLE_HPP
@@ -0,0 +1,180 @@
+#include "FileWatcher.hpp"
+
+#include <unordered_set>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <unistd.h>
+	#include <fcntl.h>
+#endif
+
+namespace swift
+{
+#ifdef __linux__
+	FileWatcher::FileWatcher()
+	:	inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+	{
+	}
+	
+	FileWatcher::~FileWatcher()
+	{
+		if(inotify != -1)
+			::close(inotify);
+	}
+	
+	bool FileWatcher::watch(const std::string& folder)
+	{
+		return inotify != -1 && addFolder(folder);
+	}
+	
+	bool FileWatcher::addFolder(const std::string& folder)
+	{
+		// editors often save to a new file and move it over the old one, so moves in count as writes
+		int wd = inotify_add_watch(inotify, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		
+		if(wd == -1)
+			return false;
+		
+		folders[wd] = folder;
+		
+		DIR* dir = opendir(folder.c_str());
+		
+		if(dir == nullptr)
+			return true;
+		
+		while(struct dirent* entry = readdir(dir))
+		{
+			std::string name = entry->d_name;
+			
+			if(entry->d_type == DT_DIR && name != "." && name != "..")
+				addFolder(folder + '/' + name);
+		}
+		
+		closedir(dir);
+		
+		return true;
+	}
+	
+	std::vector<std::string> FileWatcher::poll()
+	{
+		std::vector<std::string> changed;
+		
+		if(inotify == -1)
+			return changed;
+		
+		std::unordered_set<std::string> seen;
+		
+		// aligned for the events read into it
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		
+		while((length = read(inotify, buffer, sizeof(buffer))) > 0)
+		{
+			for(char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len)
+			{
+				const inotify_event* event = reinterpret_cast<inotify_event*>(p);
+				auto it = folders.find(event->wd);
+				
+				if(it == folders.end() || event->len == 0)
+					continue;
+				
+				std::string path = it->second + '/' + event->name;
+				
+				if(event->mask & IN_ISDIR)
+				{
+					if(event->mask & (IN_CREATE | IN_MOVED_TO))
+						addFolder(path);
+				}
+				else if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+				{
+					if(seen.insert(path).second)
+						changed.push_back(path);
+				}
+			}
+		}
+		
+		return changed;
+	}
+#else
+	FileWatcher::FileWatcher()
+	:	lastScan(std::chrono::steady_clock::now())
+	{
+	}
+	
+	FileWatcher::~FileWatcher()
+	{
+	}
+	
+	bool FileWatcher::watch(const std::string& folder)
+	{
+		DIR* dir = opendir(folder.c_str());
+		
+		if(dir == nullptr)
+			return false;
+		
+		closedir(dir);
+		
+		roots.push_back(folder);
+		scan(folder, nullptr);
+		
+		return true;
+	}
+	
+	void FileWatcher::scan(const std::string& folder, std::vector<std::string>* changed)
+	{
+		DIR* dir = opendir(folder.c_str());
+		
+		if(dir == nullptr)
+			return;
+		
+		while(struct dirent* entry = readdir(dir))
+		{
+			std::string name = entry->d_name;
+			
+			if(name == "." || name == "..")
+				continue;
+			
+			std::string path = folder + '/' + name;
+			struct stat info;
+			
+			if(stat(path.c_str(), &info) != 0)
+				continue;
+			
+			if(S_ISDIR(info.st_mode))
+			{
+				scan(path, changed);
+				continue;
+			}
+			
+			std::time_t& time = times[path];
+			
+			// files first seen during a poll are new, so they changed too
+			if(time != info.st_mtime && changed)
+				changed->push_back(path);
+			
+			time = info.st_mtime;
+		}
+		
+		closedir(dir);
+	}
+	
+	std::vector<std::string> FileWatcher::poll()
+	{
+		std::vector<std::string> changed;
+		auto now = std::chrono::steady_clock::now();
+		
+		if(now - lastScan < std::chrono::seconds(1))
+			return changed;
+		
+		lastScan = now;
+		
+		for(auto& r : roots)
+			scan(r, &changed);
+		
+		return changed;
+	}
+#endif
+}
@@ -0,0 +1,47 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <ctime>
+
+namespace swift
+{
+	// tells which files under some folders were written to. Uses inotify on Linux. Elsewhere, the folders are
+	// scanned for changed modification times, at most once a second
+	class FileWatcher
+	{
+		public:
+			FileWatcher();
+			~FileWatcher();
+			
+			FileWatcher(const FileWatcher&) = delete;
+			FileWatcher& operator=(const FileWatcher&) = delete;
+			
+			// folder and every folder under it, including ones made later. False if it can't be watched
+			bool watch(const std::string& folder);
+			
+			// files written or moved in since the last poll, each once. Doesn't block
+			std::vector<std::string> poll();
+			
+		private:
+#ifdef __linux__
+			// adds folders under folder as well
+			bool addFolder(const std::string& folder);
+			
+			int inotify;
+			std::unordered_map<int, std::string> folders;	// by watch descriptor
+#else
+			// modification times of the files under folder, the ones that changed added to changed
+			void scan(const std::string& folder, std::vector<std::string>* changed);
+			
+			std::vector<std::string> roots;
+			std::unordered_map<std::string, std::time_t> times;
+			std::chrono::steady_clock::time_point lastScan;
+#endif
+	};
+}
+
+#endif // FILE_WATCHER_HPP
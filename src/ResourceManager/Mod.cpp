@@ -47,6 +47,11 @@ namespace swift
 	{
 		return files;
 	}
+
+	const std::string& Mod::getFolder() const
+	{
+		return folder;
+	}
 	
 	void Mod::setName(const std::string& n)
 	{
@@ -68,6 +73,11 @@ namespace swift
 		description = d;
 	}
 
+	void Mod::setFolder(const std::string& f)
+	{
+		folder = f;
+	}
+
 	bool Mod::operator ==(const Mod& other) const
 	{
 		return name == other.name && version == other.version && author == other.author;
@@ -25,11 +25,15 @@ namespace swift
 			const std::string& getAuthor() const;
 			const std::string& getDescription() const;
 			const std::vector<std::string>& getFiles() const;
+			
+			// what the mod's files are under. They stand in for the files of the same path under the data folder
+			const std::string& getFolder() const;
 
 			void setName(const std::string& n);
 			void setVersion(const std::string& v);
 			void setAuthor(const std::string& a);
 			void setDescription(const std::string d);
+			void setFolder(const std::string& f);
 
 			bool operator ==(const Mod& other) const;
 			bool operator !=(const Mod& other) const;
@@ -39,6 +43,7 @@ namespace swift
 			std::string version;
 			std::string author;
 			std::string description;
+			std::string folder;
 
 			std::vector<std::string> files;
 	};
@@ -5,6 +5,8 @@
 
 namespace swift
 {
+	FileIndex* ModManager::fileIndex = nullptr;
+	
 	ModManager::ModManager()
 	{
 	}
@@ -23,7 +25,7 @@ namespace swift
 		// error handling
 		if(dir == nullptr)
 		{
-			log << "[ERROR]: Unable to open mod folder: " << f << "\n";
+			SWIFT_ERROR(Assets, "Unable to open mod folder: " << f << "\n");
 			return false;
 		}
 
@@ -31,7 +33,7 @@ namespace swift
 		{
 			if(entry == nullptr)
 			{
-				log << "[WARNING]: Unable to read mod folder: " << f << "\n";
+				SWIFT_WARNING(Assets, "Unable to read mod folder: " << f << "\n");
 				return false;
 			}
 
@@ -43,19 +45,35 @@ namespace swift
 				std::string version;
 				std::string author;
 				std::string description;
-
-				swift::Settings info;
-				info.loadFile(f + '/' + std::string(entry->d_name) + "/info.txt");
 				
-				bool nameError = info.get("name", name);
-				bool versionError = info.get("version", version);
-				bool authorError = info.get("author", author);
-				bool descriptionError = info.get("description", description);
+				std::string infoFile = f + '/' + std::string(entry->d_name) + "/info.txt";
+				std::vector<std::string> cached;
 				
-				if(!(nameError || versionError || authorError || descriptionError))
+				if(fileIndex && fileIndex->findValues(infoFile, cached) && cached.size() == 4)
+				{
+					name = cached[0];
+					version = cached[1];
+					author = cached[2];
+					description = cached[3];
+				}
+				else
 				{
-					log << "[WARNING]: Ill formed info.txt for mod \"" << entry->d_name << "\", not loading.\n";
-					continue;
+					swift::Settings info;
+					info.loadFile(infoFile);
+					
+					bool nameError = info.get("name", name);
+					bool versionError = info.get("version", version);
+					bool authorError = info.get("author", author);
+					bool descriptionError = info.get("description", description);
+					
+					if(!(nameError || versionError || authorError || descriptionError))
+					{
+						SWIFT_WARNING(Assets, "Ill formed info.txt for mod \"" << entry->d_name << "\", not loading.\n");
+						continue;
+					}
+					
+					if(fileIndex)
+						fileIndex->storeValues(infoFile, {name, version, author, description});
 				}
 				
 				mods.emplace(name, ModPair());
@@ -63,11 +81,12 @@ namespace swift
 				mods[name].mod.setVersion(version);
 				mods[name].mod.setAuthor(author);
 				mods[name].mod.setDescription(description);
+				mods[name].mod.setFolder(f + '/' + std::string(entry->d_name));
 				
-				log << "\nLoading mod: " << name << '\n';
-				log << "Version: " << version << '\n';
-				log << "By: " << author << '\n';
-				log << description << '\n';
+				SWIFT_INFO(Assets, "Loading mod: " << name << '\n');
+				SWIFT_INFO(Assets, "Version: " << version << '\n');
+				SWIFT_INFO(Assets, "By: " << author << '\n');
+				SWIFT_INFO(Assets, description << '\n');
 				loadMod(f + '/' + std::string(entry->d_name), mods[name].mod);
 			}
 		}
@@ -86,9 +105,33 @@ namespace swift
 	{
 		return mods.find(n);
 	}
+	
+	void ModManager::setFileIndex(FileIndex& fi)
+	{
+		fileIndex = &fi;
+	}
 
 	bool ModManager::loadMod(const std::string& f, Mod& mod)
 	{
+		if(fileIndex)
+		{
+			std::vector<std::string> files;
+			
+			if(!fileIndex->gather(f, files))
+			{
+				SWIFT_WARNING(Assets, "Unable to open resource folder!\n");
+				return false;
+			}
+			
+			for(auto& file : files)
+			{
+				SWIFT_DEBUG(Assets, "\tFound mod file: " << file << '\n');
+				mod.addFile(file);
+			}
+			
+			return true;
+		}
+		
 		DIR* dir = nullptr;
 		struct dirent* entry = nullptr;
 
@@ -97,7 +140,7 @@ namespace swift
 		// error handling
 		if(dir == nullptr)
 		{
-			log << "[WARNING]: Unable to open resource folder!\n";
+			SWIFT_WARNING(Assets, "Unable to open resource folder!\n");
 			return false;
 		}
 
@@ -105,7 +148,7 @@ namespace swift
 		{
 			if(entry == nullptr)
 			{
-				log << "[WARNING]: Unable to read resource folder!\n";
+				SWIFT_WARNING(Assets, "Unable to read resource folder!\n");
 				return false;
 			}
 
@@ -116,7 +159,7 @@ namespace swift
 			}
 			else if(entry->d_type == DT_REG)
 			{
-				log << "\tFound mod file: " << f + '/' + std::string(entry->d_name) << '\n';
+				SWIFT_DEBUG(Assets, "\tFound mod file: " << f + '/' + std::string(entry->d_name) << '\n');
 				mod.addFile(f + '/' + std::string(entry->d_name));
 			}
 		}
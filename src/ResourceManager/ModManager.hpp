@@ -8,6 +8,7 @@
 #include <dirent.h>
 
 #include "Mod.hpp"
+#include "FileIndex.hpp"
 
 namespace swift
 {
@@ -22,6 +23,9 @@ namespace swift
 
 			bool loadMods(const std::string& f);
 			
+			// mods' files, and their info.txt, are found through it, so unchanged mods aren't walked or parsed again
+			static void setFileIndex(FileIndex& fi);
+			
 			const std::map<std::string, ModPair>& getMods() const;
 
 			std::map<std::string, ModPair>::iterator getMod(const std::string& n);
@@ -45,6 +49,8 @@ namespace swift
 			};
 
 			std::map<std::string, ModPair> mods;
+			
+			static FileIndex* fileIndex;
 	};
 }
 
@@ -0,0 +1,146 @@
+#include "TextureAtlas.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace swift
+{
+	TextureAtlas::TextureAtlas(unsigned ps, unsigned pad)
+	:	pageSize(ps),
+		padding(pad)
+	{
+	}
+	
+	std::vector<TextureAtlas::Region> TextureAtlas::pack(const std::vector<const sf::Image*>& images, bool smooth)
+	{
+		std::vector<Region> regions(images.size(), Region{nullptr, {}});
+		
+		unsigned size = std::min(pageSize, sf::Texture::getMaximumSize());
+		
+		std::vector<std::size_t> order(images.size());
+		std::iota(order.begin(), order.end(), 0);
+		
+		// rows waste the least when the images in each are about as tall
+		std::stable_sort(order.begin(), order.end(), [&](std::size_t one, std::size_t two)
+		{
+			return images[one]->getSize().y > images[two]->getSize().y;
+		});
+		
+		sf::Image page;
+		page.create(size, size, sf::Color::Transparent);
+		
+		// pages are only textures once they're full, so the regions of the images on one are filled in then
+		std::vector<std::size_t> onPage;
+		
+		unsigned x = 0;
+		unsigned y = 0;
+		unsigned rowHeight = 0;
+		
+		auto finish = [&]()
+		{
+			if(onPage.empty() || !addPage(page, std::min(y + rowHeight, size), smooth))
+			{
+				for(auto& i : onPage)
+					regions[i].texture = nullptr;
+			}
+			else
+			{
+				for(auto& i : onPage)
+					regions[i].texture = pages.back().get();
+			}
+			
+			onPage.clear();
+			page.create(size, size, sf::Color::Transparent);
+			x = 0;
+			y = 0;
+			rowHeight = 0;
+		};
+		
+		for(auto& i : order)
+		{
+			sf::Vector2u imageSize = images[i]->getSize();
+			unsigned width = imageSize.x + padding * 2;
+			unsigned height = imageSize.y + padding * 2;
+			
+			if(imageSize.x == 0 || imageSize.y == 0 || width > size || height > size)
+				continue;
+			
+			// next row, then next page
+			if(x + width > size)
+			{
+				x = 0;
+				y += rowHeight;
+				rowHeight = 0;
+			}
+			
+			if(y + height > size)
+				finish();
+			
+			unsigned left = x + padding;
+			unsigned top = y + padding;
+			
+			page.copy(*images[i], left, top);
+			
+			// edges repeated into the padding around them
+			int w = imageSize.x;
+			int h = imageSize.y;
+			
+			for(unsigned p = 1; p <= padding; p++)
+			{
+				page.copy(*images[i], left, top - p, {0, 0, w, 1});
+				page.copy(*images[i], left, top + h - 1 + p, {0, h - 1, w, 1});
+				page.copy(page, left - p, top - p, {static_cast<int>(left), static_cast<int>(top - p), 1, h + static_cast<int>(p) * 2});
+				page.copy(page, left + w - 1 + p, top - p, {static_cast<int>(left) + w - 1, static_cast<int>(top - p), 1, h + static_cast<int>(p) * 2});
+			}
+			
+			regions[i].rect = {static_cast<int>(left), static_cast<int>(top), w, h};
+			onPage.push_back(i);
+			
+			x += width;
+			rowHeight = std::max(rowHeight, height);
+		}
+		
+		finish();
+		
+		return regions;
+	}
+	
+	bool TextureAtlas::addPage(const sf::Image& page, unsigned height, bool smooth)
+	{
+		std::unique_ptr<sf::Texture> texture(new sf::Texture());
+		
+		if(!texture->loadFromImage(page, {0, 0, static_cast<int>(page.getSize().x), static_cast<int>(height)}))
+			return false;
+		
+		texture->setSmooth(smooth);
+		pages.push_back(std::move(texture));
+		
+		return true;
+	}
+	
+	void TextureAtlas::setSmooth(bool s)
+	{
+		for(auto& p : pages)
+			p->setSmooth(s);
+	}
+	
+	std::size_t TextureAtlas::getPageCount() const
+	{
+		return pages.size();
+	}
+	
+	std::size_t TextureAtlas::getMemory() const
+	{
+		std::size_t bytes = 0;
+		
+		for(auto& p : pages)
+			bytes += p->getSize().x * p->getSize().y * 4;
+		
+		return bytes;
+	}
+	
+	void TextureAtlas::clear()
+	{
+		pages.clear();
+	}
+}
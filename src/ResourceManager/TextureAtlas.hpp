@@ -0,0 +1,50 @@
+#ifndef TEXTURE_ATLAS_HPP
+#define TEXTURE_ATLAS_HPP
+
+#include <vector>
+#include <memory>
+
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+namespace swift
+{
+	// small images packed together onto a few large textures, so sprites of different images can share a draw call
+	class TextureAtlas
+	{
+		public:
+			// pages are at most pageSize, or the largest texture the GPU takes, on each side. Images are padding pixels
+			// apart, with their edges repeated into it, so smoothing doesn't bleed neighbours in
+			TextureAtlas(unsigned pageSize = 2048, unsigned padding = 1);
+			
+			struct Region
+			{
+				const sf::Texture* texture;		// nullptr if the image wasn't packed
+				sf::IntRect rect;
+			};
+			
+			// packs images onto new pages, in rows, tallest first. Images too big for a page aren't packed
+			std::vector<Region> pack(const std::vector<const sf::Image*>& images, bool smooth);
+			
+			void setSmooth(bool s);
+			
+			std::size_t getPageCount() const;
+			
+			// bytes of every page
+			std::size_t getMemory() const;
+			
+			void clear();
+			
+		private:
+			// uploads page, cut down to the height used
+			bool addPage(const sf::Image& page, unsigned height, bool smooth);
+			
+			unsigned pageSize;
+			unsigned padding;
+			
+			std::vector<std::unique_ptr<sf::Texture>> pages;
+	};
+}
+
+#endif // TEXTURE_ATLAS_HPP
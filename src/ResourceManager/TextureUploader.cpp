@@ -0,0 +1,315 @@
+#include "TextureUploader.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#ifdef _WIN32
+	#include <GL/glew.h>
+#else
+	#define GL_GLEXT_PROTOTYPES
+	#include <GL/gl.h>
+	#include <GL/glext.h>
+#endif
+
+namespace swift
+{
+	namespace
+	{
+		bool hasExtension(const char* extension)
+		{
+#ifdef _WIN32
+			static bool glew = glewInit() == GLEW_OK;
+			
+			if(!glew)
+				return false;
+#endif
+			const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+			return extensions && std::strstr(extensions, extension);
+		}
+		
+		// core since major.minor, or there as extension
+		bool hasGL(int major, int minor, const char* extension)
+		{
+			if(hasExtension(extension))
+				return true;
+			
+			const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+			int coreMajor = 0;
+			int coreMinor = 0;
+			
+			return version && std::sscanf(version, "%d.%d", &coreMajor, &coreMinor) == 2 && (coreMajor > major || (coreMajor == major && coreMinor >= minor));
+		}
+		
+		// checked once each, the answers don't change
+		bool canGenerateMipmaps()
+		{
+			static bool available = hasGL(3, 0, "GL_ARB_framebuffer_object");
+			return available;
+		}
+		
+		bool hasPixelBuffers()
+		{
+			static bool available = hasGL(2, 1, "GL_ARB_pixel_buffer_object");
+			return available;
+		}
+		
+		// binds texture as SFML would, and puts back what was bound before, as SFML's own uploads do
+		class Binding
+		{
+			public:
+				explicit Binding(const sf::Texture& texture)
+				{
+					glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+					sf::Texture::bind(&texture);
+				}
+				
+				~Binding()
+				{
+					glBindTexture(GL_TEXTURE_2D, previous);
+				}
+			
+			private:
+				GLint previous;
+		};
+		
+		// what's left of GL_TEXTURE_MAX_LEVEL when it isn't set
+		const GLint DefaultMaxLevel = 1000;
+	}
+	
+	bool TextureUploader::mipmaps = false;
+	
+	TextureUploader::TextureUploader()
+	:	budget(0),
+		buffer(0)
+	{
+	}
+	
+	TextureUploader::~TextureUploader()
+	{
+		release();
+	}
+	
+	bool TextureUploader::isSupported(CompressedImage::Format format)
+	{
+		// S3TC never became core
+		static bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+		static bool etc2 = hasGL(4, 3, "GL_ARB_ES3_compatibility");
+		
+		switch(format)
+		{
+			case CompressedImage::BC1:
+			case CompressedImage::BC2:
+			case CompressedImage::BC3:
+				return s3tc;
+			case CompressedImage::ETC2:
+			case CompressedImage::ETC2Alpha:
+				return etc2;
+			default:
+				return false;
+		}
+	}
+	
+	bool TextureUploader::upload(sf::Texture& texture, const CompressedImage& image, bool smooth)
+	{
+		const std::vector<CompressedImage::Level>& levels = image.getLevels();
+		
+		if(levels.empty() || !isSupported(image.getFormat()))
+			return false;
+		
+		// sized by SFML first, so it draws the texture as it would its own
+		if(!texture.create(image.getSize().x, image.getSize().y))
+			return false;
+		
+		texture.setSmooth(smooth);
+		
+		Binding binding(texture);
+		
+		while(glGetError() != GL_NO_ERROR)
+			;
+		
+		for(std::size_t l = 0; l < levels.size(); l++)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(l), image.getFormat(), levels[l].size.x, levels[l].size.y, 0,
+									static_cast<GLsizei>(levels[l].bytes), image.getData(levels[l]));
+		}
+		
+		// what finish tells apart from textures whose mipmaps are generated
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size() - 1));
+		
+		if(mipmaps && levels.size() > 1)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, smooth ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR);
+		
+		return glGetError() == GL_NO_ERROR;
+	}
+	
+	void TextureUploader::setMipmaps(bool m)
+	{
+		mipmaps = m;
+	}
+	
+	bool TextureUploader::getMipmaps()
+	{
+		return mipmaps;
+	}
+	
+	void TextureUploader::finish(sf::Texture& texture, bool smooth)
+	{
+		if(!mipmaps)
+			return;
+		
+		Binding binding(texture);
+		
+		GLint maxLevel = DefaultMaxLevel;
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+		
+		// compressed without levels of its own
+		if(maxLevel == 0)
+			return;
+		
+		if(maxLevel == DefaultMaxLevel)
+		{
+			if(!canGenerateMipmaps())
+				return;
+			
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		
+		// setSmooth only sets the filter without mipmaps, so this is done again after each
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, smooth ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR);
+	}
+	
+	std::size_t TextureUploader::getMemory(const sf::Vector2u& size)
+	{
+		std::size_t bytes = static_cast<std::size_t>(size.x) * size.y * 4;
+		
+		// the levels below add up to a third more
+		return mipmaps ? bytes + bytes / 3 : bytes;
+	}
+	
+	void TextureUploader::setBudget(std::size_t bytes)
+	{
+		budget = bytes;
+	}
+	
+	std::size_t TextureUploader::getBudget() const
+	{
+		return budget;
+	}
+	
+	bool TextureUploader::queue(const std::string& file, sf::Texture& texture, const sf::Image& image, bool smooth)
+	{
+		if(!texture.create(image.getSize().x, image.getSize().y))
+			return false;
+		
+		uploads.push_back({file, &texture, image, smooth, 0});
+		
+		return true;
+	}
+	
+	std::deque<std::string> TextureUploader::update()
+	{
+		std::deque<std::string> done;
+		std::size_t left = budget > 0 ? budget : std::numeric_limits<std::size_t>::max();
+		
+		while(!uploads.empty() && left > 0)
+		{
+			Upload& upload = uploads.front();
+			std::size_t rowBytes = std::max<std::size_t>(upload.image.getSize().x * 4, 1);
+			
+			// at least a row each update, so images with rows over the budget still get there
+			std::size_t rows = std::min<std::size_t>(std::max<std::size_t>(left / rowBytes, 1), upload.image.getSize().y - upload.row);
+			left -= std::min(left, rows * rowBytes);
+			
+			if(uploadRows(upload, static_cast<unsigned>(rows)))
+				break;
+			
+			finish(*upload.texture, upload.smooth);
+			done.push_back(upload.file);
+			uploads.pop_front();
+		}
+		
+		return done;
+	}
+	
+	std::deque<std::string> TextureUploader::flush()
+	{
+		std::deque<std::string> done;
+		
+		for(auto& u : uploads)
+		{
+			uploadRows(u, u.image.getSize().y - u.row);
+			finish(*u.texture, u.smooth);
+			done.push_back(u.file);
+		}
+		
+		uploads.clear();
+		
+		return done;
+	}
+	
+	bool TextureUploader::isQueued(const std::string& file) const
+	{
+		return std::any_of(uploads.begin(), uploads.end(), [&file](const Upload& u) { return u.file == file; });
+	}
+	
+	bool TextureUploader::empty() const
+	{
+		return uploads.empty();
+	}
+	
+	void TextureUploader::release()
+	{
+		uploads.clear();
+		
+		if(buffer != 0)
+			glDeleteBuffers(1, &buffer);
+		
+		buffer = 0;
+	}
+	
+	bool TextureUploader::uploadRows(Upload& upload, unsigned rows)
+	{
+		unsigned width = upload.image.getSize().x;
+		rows = std::min(rows, upload.image.getSize().y - upload.row);
+		
+		const sf::Uint8* pixels = upload.image.getPixelsPtr() + static_cast<std::size_t>(upload.row) * width * 4;
+		std::size_t bytes = static_cast<std::size_t>(rows) * width * 4;
+		bool uploaded = false;
+		
+		if(rows > 0 && hasPixelBuffers())
+		{
+			if(buffer == 0)
+				glGenBuffers(1, &buffer);
+			
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+			
+			// orphaned each time, so the driver doesn't wait on the copy out of the last one
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+			void* mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+			
+			if(mapped)
+			{
+				std::memcpy(mapped, pixels, bytes);
+				
+				if(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+				{
+					// from the buffer, the copy to the texture happens without holding this thread up
+					Binding binding(*upload.texture);
+					glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.row, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+					uploaded = true;
+				}
+			}
+			
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+		
+		if(rows > 0 && !uploaded)
+			upload.texture->update(pixels, width, rows, 0, upload.row);
+		
+		upload.row += rows;
+		
+		return upload.row < upload.image.getSize().y;
+	}
+}
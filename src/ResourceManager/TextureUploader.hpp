@@ -0,0 +1,87 @@
+#ifndef TEXTURE_UPLOADER_HPP
+#define TEXTURE_UPLOADER_HPP
+
+#include <deque>
+#include <string>
+#include <cstddef>
+
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Image.hpp>
+
+#include "CompressedImage.hpp"
+
+namespace swift
+{
+	// what sf::Texture doesn't do for the asset manager: compressed formats, mipmaps, and uploads spread over frames.
+	// Everything here needs the GL context the textures are used with to be active
+	class TextureUploader
+	{
+		public:
+			TextureUploader();
+			~TextureUploader();
+			
+			TextureUploader(const TextureUploader&) = delete;
+			TextureUploader& operator=(const TextureUploader&) = delete;
+			
+			// false if the driver can't sample format
+			static bool isSupported(CompressedImage::Format format);
+			
+			// texture becomes image, with the levels it has. False if the format isn't supported
+			static bool upload(sf::Texture& texture, const CompressedImage& image, bool smooth);
+			
+			// textures given mipmaps are filtered between them when drawn smaller, so zoomed out views don't shimmer.
+			// Regenerated from the top level, for textures that have none of their own. Does nothing if the driver
+			// can't generate them, or for compressed textures without levels in their file
+			static void setMipmaps(bool m);
+			static bool getMipmaps();
+			
+			// after the texture's pixels or smoothing changed. Gives it its mipmaps and their filter, if they're on
+			static void finish(sf::Texture& texture, bool smooth);
+			
+			// bytes of a texture of size with its mipmaps, if they're on
+			static std::size_t getMemory(const sf::Vector2u& size);
+			
+			// rows of the images queued are uploaded by update, up to budget bytes each call, through a pixel buffer
+			// where there are ones. 0 uploads each whole when it's queued
+			void setBudget(std::size_t bytes);
+			std::size_t getBudget() const;
+			
+			// texture is created at image's size, and filled in from a copy of it over the next updates. file is what
+			// update hands back once it's done. False if the texture can't be created
+			bool queue(const std::string& file, sf::Texture& texture, const sf::Image& image, bool smooth);
+			
+			// uploads up to the budget, what's done finishing in file. Returns the files of textures finished
+			std::deque<std::string> update();
+			
+			// uploads the rest of every queued texture right away. Returns their files
+			std::deque<std::string> flush();
+			
+			bool isQueued(const std::string& file) const;
+			bool empty() const;
+			
+			// drops what's queued, along with the pixel buffer, while the context is still around
+			void release();
+		
+		private:
+			struct Upload
+			{
+				std::string file;
+				sf::Texture* texture;
+				sf::Image image;
+				bool smooth;
+				unsigned row;		// next one to upload
+			};
+			
+			// the next rows of upload. False once the last row is up
+			bool uploadRows(Upload& upload, unsigned rows);
+			
+			std::deque<Upload> uploads;
+			std::size_t budget;
+			
+			unsigned buffer;		// pixel unpack buffer, 0 until the first staged upload, or without them
+			
+			static bool mipmaps;
+	};
+}
+
+#endif // TEXTURE_UPLOADER_HPP
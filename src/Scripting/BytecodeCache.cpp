@@ -0,0 +1,117 @@
+#include "BytecodeCache.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#include "../Serialization/AsyncWriter.hpp"
+#include "../Serialization/ByteStream.hpp"
+#include "../Math/Hash.hpp"
+
+namespace swift
+{
+	BytecodeCache::BytecodeCache()
+	:	hits(0),
+		misses(0)
+	{
+	}
+	
+	void BytecodeCache::setDirectory(const std::string& d)
+	{
+		directory = d;
+		
+		if(!directory.empty() && directory.back() != '/')
+			directory += '/';
+		
+		hits = 0;
+		misses = 0;
+	}
+	
+	bool BytecodeCache::isEnabled() const
+	{
+		return !directory.empty();
+	}
+	
+	bool BytecodeCache::find(const std::string& name, const char* source, std::size_t size, std::vector<std::uint8_t>& bytecode) const
+	{
+		bytecode.clear();
+		
+		if(!isEnabled())
+			return false;
+		
+		std::uint64_t key = hash(name, source, size);
+		std::ifstream fin(getFile(key), std::ios::binary);
+		
+		std::vector<std::uint8_t> bytes;
+		
+		if(fin)
+			bytes.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+		
+		ByteReader in(bytes.data(), bytes.size());
+		
+		// the hash is only in the file name, checking it and the size again catches the rare collision
+		bool found = bytes.size() > HEADER_SIZE && in.readUInt32() == CACHE_MAGIC && in.readByte() == CACHE_VERSION
+					&& in.readUInt32() == (key >> 32) && in.readUInt32() == (key & 0xffffffff)
+					&& in.readUInt32() == (static_cast<std::uint64_t>(size) >> 32) && in.readUInt32() == (size & 0xffffffff);
+		
+		if(found)
+			bytecode.assign(bytes.begin() + HEADER_SIZE, bytes.end());
+		
+		(found ? hits : misses)++;
+		
+		return found;
+	}
+	
+	bool BytecodeCache::store(const std::string& name, const char* source, std::size_t size, const std::vector<std::uint8_t>& bytecode) const
+	{
+		if(!isEnabled() || bytecode.empty())
+			return false;
+		
+		std::uint64_t key = hash(name, source, size);
+		
+		ByteWriter out;
+		out.writeUInt32(CACHE_MAGIC);
+		out.writeByte(CACHE_VERSION);
+		out.writeUInt32(static_cast<std::uint32_t>(key >> 32));
+		out.writeUInt32(static_cast<std::uint32_t>(key));
+		out.writeUInt32(static_cast<std::uint32_t>(static_cast<std::uint64_t>(size) >> 32));
+		out.writeUInt32(static_cast<std::uint32_t>(size));
+		
+		std::vector<std::uint8_t> data = out.getData();
+		data.insert(data.end(), bytecode.begin(), bytecode.end());
+		
+		return AsyncWriter::write(getFile(key), data, AsyncWriter::Mode::Replace);
+	}
+	
+	unsigned BytecodeCache::getHits() const
+	{
+		return hits;
+	}
+	
+	unsigned BytecodeCache::getMisses() const
+	{
+		return misses;
+	}
+	
+	std::uint64_t BytecodeCache::hash(const std::string& name, const char* source, std::size_t size)
+	{
+		// of the name too, as it's compiled into the chunk for errors
+		std::uint64_t h = math::hash(name);
+		
+		// between them, so a name and source can't run into each other
+		const std::uint8_t separator = 0xff;
+		h = math::hash(&separator, 1, h);
+		
+		return math::hash(source, size, h);
+	}
+	
+	std::string BytecodeCache::getFile(std::uint64_t key) const
+	{
+		static const char digits[] = "0123456789abcdef";
+		std::string file = directory;
+		
+		for(int shift = 60; shift >= 0; shift -= 4)
+			file += digits[(key >> shift) & 0xf];
+		
+		return file + ".luac";
+	}
+}
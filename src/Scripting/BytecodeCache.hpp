@@ -0,0 +1,52 @@
+#ifndef BYTECODECACHE_HPP
+#define BYTECODECACHE_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+namespace swift
+{
+	// compiled Lua chunks, kept as files in a directory by a hash of their name and source, so scripts load without
+	// being parsed and compiled again until they change. A changed script is stored under a new hash, the old file is
+	// just never found again. Scripts of packs are cached the same way, the packs themselves are never written to
+	class BytecodeCache
+	{
+		public:
+			BytecodeCache();
+			
+			// empty, the default, caches nothing. The directory has to exist
+			void setDirectory(const std::string& d);
+			bool isEnabled() const;
+			
+			// what was stored for name compiled from source. False if nothing was, or the file isn't whole
+			bool find(const std::string& name, const char* source, std::size_t size, std::vector<std::uint8_t>& bytecode) const;
+			
+			// written to a temporary file that then replaces the entry, so a crash never leaves half of one
+			bool store(const std::string& name, const char* source, std::size_t size, const std::vector<std::uint8_t>& bytecode) const;
+			
+			// finds that found something, and ones that didn't, since the directory was set
+			unsigned getHits() const;
+			unsigned getMisses() const;
+		
+		private:
+			static const std::uint32_t CACHE_MAGIC = 0x43425753;	// "SWBC"
+			static const std::uint8_t CACHE_VERSION = 1;
+			
+			// magic, version, then the key and the source's size as two halves each
+			static const std::size_t HEADER_SIZE = 4 + 1 + 8 + 8;
+			
+			static std::uint64_t hash(const std::string& name, const char* source, std::size_t size);
+			
+			std::string getFile(std::uint64_t key) const;
+			
+			std::string directory;
+			
+			// scripts may be loaded on several threads at once
+			mutable std::atomic<unsigned> hits;
+			mutable std::atomic<unsigned> misses;
+	};
+}
+
+#endif // BYTECODECACHE_HPP
@@ -0,0 +1,399 @@
+#include "ComponentFields.hpp"
+
+#include <algorithm>
+
+/* EntitySystem */
+#include "../EntitySystem/Components/Animated.hpp"
+#include "../EntitySystem/Components/Controllable.hpp"
+#include "../EntitySystem/Components/Drawable.hpp"
+#include "../EntitySystem/Components/Luminous.hpp"
+#include "../EntitySystem/Components/Movable.hpp"
+#include "../EntitySystem/Components/Name.hpp"
+#include "../EntitySystem/Components/Noisy.hpp"
+#include "../EntitySystem/Components/Pathfinder.hpp"
+#include "../EntitySystem/Components/Physical.hpp"
+#include "../EntitySystem/Components/Sighted.hpp"
+
+namespace swift
+{
+	void ComponentFields::open(lua_State* state)
+	{
+		for(auto& type : getTypes())
+		{
+			// a VM shared by scripts opens them once
+			if(!luaL_newmetatable(state, getMetatable(type.name).c_str()))
+			{
+				lua_pop(state, 1);
+				continue;
+			}
+
+			lua_createtable(state, 0, static_cast<int>(type.fields.size()));
+
+			for(auto& f : type.fields)
+			{
+				lua_pushlightuserdata(state, const_cast<Field*>(&f.second));
+				lua_setfield(state, -2, f.first.c_str());
+			}
+
+			const std::pair<const char*, lua_CFunction> metamethods[] =
+			{
+				{"__index", &index},
+				{"__newindex", &newIndex},
+				{"__eq", &equal},
+				{"__tostring", &toString},
+			};
+
+			for(auto& m : metamethods)
+			{
+				lua_pushvalue(state, -1);
+				lua_pushlstring(state, type.name.c_str(), type.name.size());
+				lua_pushcclosure(state, m.second, 2);
+				lua_setfield(state, -3, m.first);
+			}
+
+			// the field table, then the metatable
+			lua_pop(state, 2);
+		}
+	}
+
+	const std::vector<ComponentFields::Type>& ComponentFields::getTypes()
+	{
+		static const std::vector<Type> types = makeTypes();
+		return types;
+	}
+
+	std::vector<ComponentFields::Type> ComponentFields::makeTypes()
+	{
+		std::vector<Type> types;
+
+		Animated anim;
+		Controllable cont;
+		Drawable draw;
+		Luminous lum;
+		Movable mov;
+		Noisy noisy;
+		Pathfinder path;
+		Physical phys;
+		Sighted sight;
+
+		types.push_back({Animated::getType(),
+		{
+			{"animation", accessor([](const void* a)
+			{
+				return static_cast<const Animated*>(a)->getAnimation();
+			},
+			[](void* a, const std::string& v)
+			{
+				return static_cast<Animated*>(a)->setAnimation(v);
+			})},
+			{"animationFile", at(&anim, anim.animationFile, false)},
+		}});
+
+		types.push_back({Controllable::getType(),
+		{
+			{"moveLeft", at(&cont, cont.moveLeft)},
+			{"moveRight", at(&cont, cont.moveRight)},
+			{"moveUp", at(&cont, cont.moveUp)},
+			{"moveDown", at(&cont, cont.moveDown)},
+		}});
+
+		// the sprite keeps its scale itself. The texture is changed with setTexture, which loads it
+		types.push_back({Drawable::getType(),
+		{
+			{"texture", at(&draw, draw.texture, false)},
+			{"scaleX", accessor([](const void* d)
+			{
+				return static_cast<const Drawable*>(d)->sprite.getScale().x;
+			},
+			[](void* d, float v)
+			{
+				sf::Sprite& sprite = static_cast<Drawable*>(d)->sprite;
+				sprite.setScale(v, sprite.getScale().y);
+			})},
+			{"scaleY", accessor([](const void* d)
+			{
+				return static_cast<const Drawable*>(d)->sprite.getScale().y;
+			},
+			[](void* d, float v)
+			{
+				sf::Sprite& sprite = static_cast<Drawable*>(d)->sprite;
+				sprite.setScale(sprite.getScale().x, v);
+			})},
+		}});
+
+		types.push_back({Luminous::getType(),
+		{
+			{"radius", at(&lum, lum.radius)},
+			{"red", at(&lum, lum.color.r)},
+			{"green", at(&lum, lum.color.g)},
+			{"blue", at(&lum, lum.color.b)},
+			{"alpha", at(&lum, lum.color.a)},
+			{"texture", at(&lum, lum.texture, false)},
+		}});
+
+		types.push_back({Movable::getType(),
+		{
+			{"moveVelocity", at(&mov, mov.moveVelocity)},
+			{"velocityX", at(&mov, mov.velocity.x)},
+			{"velocityY", at(&mov, mov.velocity.y)},
+		}});
+
+		types.push_back({Name::getType(),
+		{
+			{"name", accessor([](const void* n)
+			{
+				return static_cast<const Name*>(n)->getName();
+			},
+			[](void* n, const std::string& v)
+			{
+				static_cast<Name*>(n)->setName(v);
+				return true;
+			})},
+		}});
+
+		types.push_back({Noisy::getType(),
+		{
+			{"sound", at(&noisy, noisy.soundFile)},
+			{"shouldPlay", at(&noisy, noisy.shouldPlay)},
+			{"priority", at(&noisy, noisy.priority)},
+		}});
+
+		// setting needsPath asks for a path to the destination
+		types.push_back({Pathfinder::getType(),
+		{
+			{"destinationX", at(&path, path.destination.x)},
+			{"destinationY", at(&path, path.destination.y)},
+			{"needsPath", at(&path, path.needsPath)},
+			{"priority", at(&path, path.priority)},
+			{"avoidance", at(&path, path.avoidance)},
+		}});
+
+		types.push_back({Physical::getType(),
+		{
+			{"x", at(&phys, phys.position.x)},
+			{"y", at(&phys, phys.position.y)},
+			{"zIndex", at(&phys, phys.zIndex)},
+			{"width", at(&phys, phys.size.x)},
+			{"height", at(&phys, phys.size.y)},
+			{"collides", at(&phys, phys.collides)},
+			{"angle", at(&phys, phys.angle)},
+			{"category", at(&phys, phys.category)},
+			{"mask", at(&phys, phys.mask)},
+		}});
+
+		types.push_back({Sighted::getType(),
+		{
+			{"faction", at(&sight, sight.faction)},
+			{"radius", at(&sight, sight.radius)},
+		}});
+
+#ifdef LPP_LUAJIT
+		// ffi.cast("swift_Physical*", p.pointer)
+		for(auto& t : types)
+			t.fields.push_back({"pointer", {Field::Kind::Pointer, 0, false, nullptr, nullptr, nullptr, nullptr}});
+#endif
+
+		return types;
+	}
+
+	template<typename M>
+	ComponentFields::Field ComponentFields::at(const void* object, const M& member, bool writable)
+	{
+		std::size_t offset = static_cast<std::size_t>(reinterpret_cast<const char*>(&member) - static_cast<const char*>(object));
+		return {kindOf(member), offset, writable, nullptr, nullptr, nullptr, nullptr};
+	}
+
+	ComponentFields::Field ComponentFields::accessor(float (*get)(const void*), void (*set)(void*, float))
+	{
+		return {Field::Kind::Accessor, 0, set != nullptr, get, set, nullptr, nullptr};
+	}
+
+	ComponentFields::Field ComponentFields::accessor(std::string (*get)(const void*), bool (*set)(void*, const std::string&))
+	{
+		return {Field::Kind::StringAccessor, 0, set != nullptr, nullptr, nullptr, get, set};
+	}
+
+	ComponentFields::Field::Kind ComponentFields::kindOf(const float&)
+	{
+		return Field::Kind::Float;
+	}
+
+	ComponentFields::Field::Kind ComponentFields::kindOf(const unsigned&)
+	{
+		return Field::Kind::Unsigned;
+	}
+
+	ComponentFields::Field::Kind ComponentFields::kindOf(const int&)
+	{
+		return Field::Kind::Int;
+	}
+
+	ComponentFields::Field::Kind ComponentFields::kindOf(const bool&)
+	{
+		return Field::Kind::Bool;
+	}
+
+	ComponentFields::Field::Kind ComponentFields::kindOf(const std::uint8_t&)
+	{
+		return Field::Kind::Byte;
+	}
+
+	ComponentFields::Field::Kind ComponentFields::kindOf(const std::string&)
+	{
+		return Field::Kind::String;
+	}
+
+	std::string ComponentFields::getMetatable(const std::string& type)
+	{
+		return "swift." + type;
+	}
+
+	void ComponentFields::push(lua_State* state, void* c, const char* metatable)
+	{
+		if(!c)
+		{
+			lua_pushnil(state);
+			return;
+		}
+
+		*static_cast<void**>(lua_newuserdata(state, sizeof(void*))) = c;
+		luaL_getmetatable(state, metatable);
+		lua_setmetatable(state, -2);
+	}
+
+	int ComponentFields::index(lua_State* state)
+	{
+		char* component = *static_cast<char**>(lua_touserdata(state, 1));
+
+		lua_pushvalue(state, 2);
+		lua_rawget(state, lua_upvalueindex(1));
+		const Field* field = static_cast<const Field*>(lua_touserdata(state, -1));
+
+		// not a field, reads as nil as a table's would
+		if(!field)
+		{
+			lua_pushnil(state);
+			return 1;
+		}
+
+		char* value = component + field->offset;
+
+		switch(field->kind)
+		{
+			case Field::Kind::Float:
+				lua_pushnumber(state, *reinterpret_cast<float*>(value));
+				break;
+			case Field::Kind::Unsigned:
+				lua_pushnumber(state, *reinterpret_cast<unsigned*>(value));
+				break;
+			case Field::Kind::Int:
+				lua_pushinteger(state, *reinterpret_cast<int*>(value));
+				break;
+			case Field::Kind::Bool:
+				lua_pushboolean(state, *reinterpret_cast<bool*>(value));
+				break;
+			case Field::Kind::Byte:
+				lua_pushinteger(state, *reinterpret_cast<std::uint8_t*>(value));
+				break;
+			case Field::Kind::String:
+			{
+				const std::string& s = *reinterpret_cast<std::string*>(value);
+				lua_pushlstring(state, s.c_str(), s.size());
+				break;
+			}
+			case Field::Kind::Accessor:
+				lua_pushnumber(state, field->get(component));
+				break;
+			case Field::Kind::StringAccessor:
+			{
+				std::string s = field->getString(component);
+				lua_pushlstring(state, s.c_str(), s.size());
+				break;
+			}
+			case Field::Kind::Pointer:
+				lua_pushlightuserdata(state, component);
+				break;
+		}
+
+		return 1;
+	}
+
+	int ComponentFields::newIndex(lua_State* state)
+	{
+		char* component = *static_cast<char**>(lua_touserdata(state, 1));
+
+		lua_pushvalue(state, 2);
+		lua_rawget(state, lua_upvalueindex(1));
+		const Field* field = static_cast<const Field*>(lua_touserdata(state, -1));
+		lua_pop(state, 1);
+
+		// checked before anything is made, an error doesn't unwind C++ objects
+		if(!field || !field->writable)
+		{
+			const char* key = lua_type(state, 2) == LUA_TSTRING ? lua_tostring(state, 2) : lua_typename(state, lua_type(state, 2));
+			return luaL_error(state, "%s has no writable field '%s'", lua_tostring(state, lua_upvalueindex(2)), key);
+		}
+
+		char* value = component + field->offset;
+
+		switch(field->kind)
+		{
+			case Field::Kind::Float:
+				*reinterpret_cast<float*>(value) = static_cast<float>(luaL_checknumber(state, 3));
+				break;
+			case Field::Kind::Unsigned:
+				*reinterpret_cast<unsigned*>(value) = static_cast<unsigned>(std::max<lua_Number>(luaL_checknumber(state, 3), 0));
+				break;
+			case Field::Kind::Int:
+				*reinterpret_cast<int*>(value) = static_cast<int>(luaL_checkinteger(state, 3));
+				break;
+			case Field::Kind::Bool:
+				*reinterpret_cast<bool*>(value) = lua_toboolean(state, 3) != 0;
+				break;
+			case Field::Kind::Byte:
+				*reinterpret_cast<std::uint8_t*>(value) = static_cast<std::uint8_t>(std::min<lua_Integer>(std::max<lua_Integer>(luaL_checkinteger(state, 3), 0), 255));
+				break;
+			case Field::Kind::String:
+			{
+				std::size_t size;
+				const char* s = luaL_checklstring(state, 3, &size);
+				reinterpret_cast<std::string*>(value)->assign(s, size);
+				break;
+			}
+			case Field::Kind::Accessor:
+				field->set(component, static_cast<float>(luaL_checknumber(state, 3)));
+				break;
+			case Field::Kind::StringAccessor:
+			{
+				std::size_t size;
+				const char* s = luaL_checklstring(state, 3, &size);
+
+				// the string is gone before the error
+				if(!field->setString(component, {s, size}))
+					return luaL_error(state, "%s can't set '%s' to '%s'", lua_tostring(state, lua_upvalueindex(2)), lua_tostring(state, 2), s);
+
+				break;
+			}
+			case Field::Kind::Pointer:
+				break;
+		}
+
+		return 0;
+	}
+
+	int ComponentFields::equal(lua_State* state)
+	{
+		// separate userdata for the same component
+		void** one = static_cast<void**>(lua_touserdata(state, 1));
+		void** two = static_cast<void**>(lua_touserdata(state, 2));
+
+		lua_pushboolean(state, one && two && *one == *two);
+		return 1;
+	}
+
+	int ComponentFields::toString(lua_State* state)
+	{
+		lua_pushfstring(state, "%s: %p", lua_tostring(state, lua_upvalueindex(2)), *static_cast<void**>(lua_touserdata(state, 1)));
+		return 1;
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef COMPONENTFIELDS_HPP
+#define COMPONENTFIELDS_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "LuaCpp/LuaCpp.hpp"
+
+namespace swift
+{
+	// components as full userdata, with their fields read and written by name: p.x = p.x + 1.
+	// Each type's metatable has a table of its fields and where they are in the component, so an access is one lookup.
+	// The userdata holds a pointer to the component, it's good for as long as a pointer from the component's pool is
+	class ComponentFields
+	{
+		public:
+			// makes each component type's metatable in state's registry
+			static void open(lua_State* state);
+			
+			// pushes c, or nil for nullptr
+			template<typename C>
+			static void push(lua_State* state, C* c)
+			{
+				static const std::string metatable = getMetatable(C::getType());
+				push(state, c, metatable.c_str());
+			}
+		
+		private:
+			struct Field
+			{
+				enum class Kind
+				{
+					Float,
+					Unsigned,
+					Int,
+					Bool,
+					Byte,
+					String,
+					Accessor,	// for what isn't a plain member, through get and set
+					StringAccessor,	// the same, through getString and setString
+					Pointer		// the component, as a light userdata, for the ffi
+				};
+				
+				Kind kind;
+				std::size_t offset;
+				bool writable;
+				
+				float (*get)(const void* component);
+				void (*set)(void* component, float value);
+				
+				// false if value isn't one the field can take
+				std::string (*getString)(const void* component);
+				bool (*setString)(void* component, const std::string& value);
+			};
+			
+			struct Type
+			{
+				std::string name;
+				std::vector<std::pair<std::string, Field>> fields;
+			};
+			
+			// every type, made once. Metatables point into it
+			static const std::vector<Type>& getTypes();
+			static std::vector<Type> makeTypes();
+			
+			// member of the component at object
+			template<typename M>
+			static Field at(const void* object, const M& member, bool writable = true);
+			static Field accessor(float (*get)(const void*), void (*set)(void*, float));
+			static Field accessor(std::string (*get)(const void*), bool (*set)(void*, const std::string&));
+			
+			static Field::Kind kindOf(const float&);
+			static Field::Kind kindOf(const unsigned&);
+			static Field::Kind kindOf(const int&);
+			static Field::Kind kindOf(const bool&);
+			static Field::Kind kindOf(const std::uint8_t&);
+			static Field::Kind kindOf(const std::string&);
+			
+			static std::string getMetatable(const std::string& type);
+			static void push(lua_State* state, void* c, const char* metatable);
+			
+			// metamethods. The field table is upvalue 1, the type's name upvalue 2
+			static int index(lua_State* state);
+			static int newIndex(lua_State* state);
+			static int equal(lua_State* state);
+			static int toString(lua_State* state);
+	};
+}
+
+#endif // COMPONENTFIELDS_HPP
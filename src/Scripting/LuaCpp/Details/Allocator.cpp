@@ -0,0 +1,140 @@
+#include "Allocator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace lpp
+{
+	Allocator::Observer Allocator::observer = nullptr;
+	
+	Allocator::Allocator()
+	{
+		std::fill(std::begin(freeLists), std::end(freeLists), nullptr);
+	}
+	
+	Allocator::~Allocator()
+	{
+		for(auto& c : chunks)
+			std::free(c);
+	}
+	
+	void* Allocator::allocate(void* ud, void* ptr, std::size_t osize, std::size_t nsize)
+	{
+		Allocator& allocator = *static_cast<Allocator*>(ud);
+		
+		// osize is only the block's size when there is a block
+		if(nsize == 0)
+		{
+			if(ptr)
+			{
+				allocator.give(ptr, osize);
+				
+				if(observer)
+					observer(osize, 0);
+			}
+			
+			return nullptr;
+		}
+		
+		void* block = resize(allocator, ptr, osize, nsize);
+		
+		if(block && observer)
+			observer(ptr ? osize : 0, nsize);
+		
+		return block;
+	}
+	
+	void Allocator::setObserver(Observer o)
+	{
+		observer = o;
+	}
+	
+	void* Allocator::resize(Allocator& allocator, void* ptr, std::size_t osize, std::size_t nsize)
+	{
+		if(!ptr)
+			return allocator.take(nsize);
+		
+		bool wasPooled = osize <= MaxPooled;
+		bool pooled = nsize <= MaxPooled;
+		
+		if(!wasPooled && !pooled)
+			return std::realloc(ptr, nsize);
+		
+		// still fits its slot
+		if(wasPooled && pooled && getClass(osize) == getClass(nsize))
+			return ptr;
+		
+		void* block = allocator.take(nsize);
+		
+		if(!block)
+			return nullptr;
+		
+		std::memcpy(block, ptr, std::min(osize, nsize));
+		allocator.give(ptr, osize);
+		
+		return block;
+	}
+	
+	void* Allocator::take(std::size_t size)
+	{
+		if(size > MaxPooled)
+			return std::malloc(size);
+		
+		std::size_t c = getClass(size);
+		
+		if(!freeLists[c])
+		{
+			char* chunk = static_cast<char*>(std::malloc(ChunkSize));
+			
+			if(!chunk)
+				return nullptr;
+			
+			// Lua can't take an exception from here
+			try
+			{
+				chunks.push_back(chunk);
+			}
+			catch(...)
+			{
+				std::free(chunk);
+				return nullptr;
+			}
+			
+			// chained in reverse, so slots are handed out in address order
+			std::size_t slotSize = (c + 1) * Granularity;
+			
+			for(std::size_t i = ChunkSize / slotSize; i > 0; i--)
+			{
+				Slot* slot = reinterpret_cast<Slot*>(chunk + (i - 1) * slotSize);
+				slot->next = freeLists[c];
+				freeLists[c] = slot;
+			}
+		}
+		
+		Slot* slot = freeLists[c];
+		freeLists[c] = slot->next;
+		
+		return slot;
+	}
+	
+	void Allocator::give(void* block, std::size_t size)
+	{
+		if(size > MaxPooled)
+		{
+			std::free(block);
+			return;
+		}
+		
+		Slot* slot = static_cast<Slot*>(block);
+		std::size_t c = getClass(size);
+		
+		slot->next = freeLists[c];
+		freeLists[c] = slot;
+	}
+	
+	std::size_t Allocator::getClass(std::size_t size)
+	{
+		return (size + Granularity - 1) / Granularity - 1;
+	}
+}
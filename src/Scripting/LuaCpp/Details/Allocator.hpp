@@ -0,0 +1,54 @@
+#ifndef LUA_ALLOCATOR_HPP
+#define LUA_ALLOCATOR_HPP
+
+#include <vector>
+#include <cstddef>
+
+namespace lpp
+{
+	// lua_Alloc for one VM. Blocks of up to MaxPooled bytes come from free lists, one for each size class, of slots
+	// cut out of chunks that are kept until the allocator is destroyed. Bigger blocks are malloc'd.
+	// Not thread safe, like the VM it's for
+	class Allocator
+	{
+		public:
+			static const std::size_t Granularity = 16;	// size classes are multiples of it
+			static const std::size_t MaxPooled = 256;
+			static const std::size_t ChunkSize = 16 * 1024;
+			
+			Allocator();
+			~Allocator();
+			
+			Allocator(const Allocator&) = delete;
+			Allocator& operator=(const Allocator&) = delete;
+			
+			// a lua_Alloc, ud is the Allocator
+			static void* allocate(void* ud, void* ptr, std::size_t osize, std::size_t nsize);
+			
+			// told of every block any Allocator hands out or takes back, for counting memory. A resized block is both
+			using Observer = void (*)(std::size_t freed, std::size_t allocated);
+			static void setObserver(Observer o);
+		
+		private:
+			struct Slot
+			{
+				Slot* next;
+			};
+			
+			// allocate for a new block or one that's growing or shrinking, nullptr if there's no memory for it
+			static void* resize(Allocator& allocator, void* ptr, std::size_t osize, std::size_t nsize);
+			
+			// nullptr if there's no memory for it
+			void* take(std::size_t size);
+			void give(void* block, std::size_t size);
+			
+			static std::size_t getClass(std::size_t size);
+			
+			Slot* freeLists[MaxPooled / Granularity];
+			std::vector<void*> chunks;
+			
+			static Observer observer;
+	};
+}
+
+#endif // LUA_ALLOCATOR_HPP
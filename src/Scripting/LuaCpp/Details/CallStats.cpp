@@ -0,0 +1,33 @@
+#include "CallStats.hpp"
+
+namespace lpp
+{
+	thread_local CallStats::Counts* CallStats::counts = nullptr;
+	
+	std::mutex CallStats::namesMutex;
+	std::vector<std::string> CallStats::names;
+	std::unordered_map<std::string, unsigned> CallStats::ids;
+	
+	unsigned CallStats::getId(const std::string& name)
+	{
+		std::lock_guard<std::mutex> lock(namesMutex);
+		
+		auto it = ids.find(name);
+		
+		if(it != ids.end())
+			return it->second;
+		
+		unsigned id = static_cast<unsigned>(names.size());
+		names.push_back(name);
+		ids.emplace(name, id);
+		
+		return id;
+	}
+	
+	std::string CallStats::getName(unsigned id)
+	{
+		std::lock_guard<std::mutex> lock(namesMutex);
+		
+		return id < names.size() ? names[id] : "";
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef LUA_CALL_STATS_HPP
+#define LUA_CALL_STATS_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace lpp
+{
+	// counts calls into bound C++ functions, by the name they were bound under. Calls are counted into
+	// the Counts a Scope set for the calling thread. Without one, a call only costs checking there isn't
+	class CallStats
+	{
+		public:
+			using Counts = std::vector<unsigned>;	// by id
+			
+			// the same id for a name every time, from any state
+			static unsigned getId(const std::string& name);
+			static std::string getName(unsigned id);
+			
+			static void count(unsigned id)
+			{
+				if(!counts)
+					return;
+				
+				if(id >= counts->size())
+					counts->resize(id + 1, 0);
+				
+				(*counts)[id]++;
+			}
+			
+			// calls on the thread it's made on are counted into c, until it's destroyed
+			class Scope
+			{
+				public:
+					explicit Scope(Counts& c)
+					:	previous(counts)
+					{
+						counts = &c;
+					}
+					
+					~Scope()
+					{
+						counts = previous;
+					}
+					
+					Scope(const Scope&) = delete;
+					Scope& operator=(const Scope&) = delete;
+				
+				private:
+					Counts* previous;
+			};
+		
+		private:
+			static thread_local Counts* counts;
+			
+			// functions are bound from the threads scripts are made on
+			static std::mutex namesMutex;
+			static std::vector<std::string> names;
+			static std::unordered_map<std::string, unsigned> ids;
+	};
+}
+
+#endif // LUA_CALL_STATS_HPP
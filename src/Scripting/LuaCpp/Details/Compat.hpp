@@ -0,0 +1,88 @@
+#ifndef LUA_COMPAT_HPP
+#define LUA_COMPAT_HPP
+
+/*
+ * lpp is written against the Lua 5.2 API. Defining LPP_LUAJIT builds it against LuaJIT
+ * (the Lua 5.1 API) instead, with what 5.2 has and 5.1 doesn't filled in here.
+ * LuaJIT's lua_Number is double, values are converted to and from float where bindings take floats.
+ */
+
+#include <cstddef>
+
+#include <lua.hpp>
+
+#ifdef LPP_LUAJIT
+	#include <luajit.h>
+	
+	#ifndef LUA_OK
+		#define LUA_OK 0
+	#endif
+	
+	inline void lua_pushunsigned(lua_State* state, unsigned int u)
+	{
+		lua_pushnumber(state, static_cast<lua_Number>(u));
+	}
+	
+	inline unsigned int luaL_checkunsigned(lua_State* state, int idx)
+	{
+		return static_cast<unsigned int>(luaL_checknumber(state, idx));
+	}
+	
+	inline std::size_t lua_rawlen(lua_State* state, int idx)
+	{
+		return lua_objlen(state, idx);
+	}
+	
+	// only what lpp uses: calls open, and sets the global name to what it returns if global is set
+	inline void luaL_requiref(lua_State* state, const char* name, lua_CFunction open, int global)
+	{
+		lua_pushcfunction(state, open);
+		lua_pushstring(state, name);
+		lua_call(state, 1, 1);
+		
+		if(global)
+		{
+			lua_pushvalue(state, -1);
+			lua_setglobal(state, name);
+		}
+	}
+#endif
+
+namespace lpp
+{
+	namespace compat
+	{
+		// the table lua_getglobal, lua_setglobal, and chunks loaded from now on use
+		inline void pushGlobals(lua_State* state)
+		{
+#ifdef LPP_LUAJIT
+			lua_pushvalue(state, LUA_GLOBALSINDEX);
+#else
+			lua_rawgeti(state, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+#endif
+		}
+		
+		// pops the table on top of the stack into the globals
+		inline void setGlobals(lua_State* state)
+		{
+#ifdef LPP_LUAJIT
+			lua_replace(state, LUA_GLOBALSINDEX);
+#else
+			lua_rawseti(state, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+#endif
+		}
+		
+		// starts or carries on thread with nargs args on its stack. from is the state resuming it
+		inline int resume(lua_State* thread, lua_State* from, int nargs)
+		{
+#ifdef LPP_LUAJIT
+			(void)from;
+			return lua_resume(thread, nargs);
+#else
+			return lua_resume(thread, from, nargs);
+#endif
+		}
+	}
+}
+
+#endif // LUA_COMPAT_HPP
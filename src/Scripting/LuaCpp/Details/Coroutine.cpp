@@ -0,0 +1,95 @@
+#include "Coroutine.hpp"
+
+namespace lpp
+{
+	thread_local lua_State* Coroutine::running = nullptr;
+	thread_local bool Coroutine::outOfBudget = false;
+	
+	Coroutine::Coroutine()
+	:	thread(nullptr),
+		paused(false)
+	{}
+	
+	auto Coroutine::resume(lua_State* state, const Reference& function, unsigned budget) -> Status
+	{
+		if(!paused)
+		{
+			if(!thread)
+			{
+				// kept referenced, or it would be collected
+				thread = lua_newthread(state);
+				threadRef = Reference(state);
+			}
+			
+			function.push();
+			lua_xmove(state, thread, 1);
+		}
+		
+		// the count starts again from 0 every time the hook is set
+		if(budget)
+			lua_sethook(thread, &hook, LUA_MASKCOUNT, budget);
+		
+		running = thread;
+		outOfBudget = false;
+		
+		int result = compat::resume(thread, state, 0);
+		
+		running = nullptr;
+		lua_sethook(thread, nullptr, 0, 0);
+		
+		if(result == LUA_YIELD)
+		{
+			// nothing is passed back in when it carries on
+			lua_settop(thread, 0);
+			paused = true;
+			return outOfBudget ? Status::OutOfBudget : Status::Yielded;
+		}
+		
+		paused = false;
+		
+		if(result == LUA_OK)
+		{
+			lua_settop(thread, 0);
+			return Status::Finished;
+		}
+		
+		// a thread that errored can't be run again
+		lua_xmove(thread, state, 1);
+		reset();
+		
+		return Status::Error;
+	}
+	
+	bool Coroutine::isPaused() const
+	{
+		return paused;
+	}
+	
+	void Coroutine::reset()
+	{
+		threadRef.reset();
+		thread = nullptr;
+		paused = false;
+	}
+	
+	void Coroutine::hook(lua_State* thread, lua_Debug* /*ar*/)
+	{
+		if(thread != running)
+			return;
+		
+		// Lua called from C, a table.sort comparator, can't always be yielded from, so it never is.
+		// The budget is counted again, and it's paused the next time it's only in Lua
+		lua_Debug frame;
+		
+		for(int level = 0; lua_getstack(thread, level, &frame); level++)
+		{
+			lua_getinfo(thread, "S", &frame);
+			
+			if(frame.what[0] == 'C')
+				return;
+		}
+		
+		outOfBudget = true;
+		lua_yield(thread, 0);
+	}
+}
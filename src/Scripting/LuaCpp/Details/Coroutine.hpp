@@ -0,0 +1,50 @@
+#ifndef LUA_COROUTINE_HPP
+#define LUA_COROUTINE_HPP
+
+#include "Compat.hpp"
+
+#include "Reference.hpp"
+
+namespace lpp
+{
+	// a function run in a Lua thread of its own, so it can be paused partway through and carried on later.
+	// the thread is kept and reused each time the function finishes. Must not outlive the lua_State it's from
+	class Coroutine
+	{
+		public:
+			enum class Status
+			{
+				Finished,
+				Yielded,		// the function called coroutine.yield
+				OutOfBudget,	// paused by the instruction budget
+				Error
+			};
+			
+			Coroutine();
+			
+			// calls function until it returns, yields, errors, or has run budget more instructions. 0 is no budget.
+			// A paused coroutine carries on from where it was instead, function isn't called again.
+			// On errors, the error is pushed onto state's stack, like State::run
+			Status resume(lua_State* state, const Reference& function, unsigned budget);
+			
+			bool isPaused() const;
+			
+			// drops the thread, a paused function is never finished
+			void reset();
+		
+		private:
+			// yields where Lua can carry on from, skips where it can't
+			static void hook(lua_State* thread, lua_Debug* ar);
+			
+			// hooks are per VM with LuaJIT, so the hook checks it's in the thread it's meant for.
+			// Coroutines are resumed one at a time on each thread
+			static thread_local lua_State* running;
+			static thread_local bool outOfBudget;
+			
+			Reference threadRef;
+			lua_State* thread;
+			bool paused;
+	};
+}
+
+#endif // LUA_COROUTINE_HPP
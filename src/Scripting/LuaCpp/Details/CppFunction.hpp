@@ -6,19 +6,28 @@
 #include <memory>
 
 #include "Details.hpp"
+#include "CallStats.hpp"
 
 namespace lpp
 {
 	class BaseCppFunction
 	{
 		public:
+			explicit BaseCppFunction(const std::string& name)
+			:	id(CallStats::getId(name))
+			{}
+			
 			virtual int run(lua_State* state) = 0;
 			
 			static int luaDispatcher(lua_State* state)
 			{
 				BaseCppFunction* func = static_cast<BaseCppFunction*>(lua_touserdata(state, lua_upvalueindex(1)));
+				CallStats::count(func->id);
 				return func->run(state);
 			}
+		
+		private:
+			const unsigned id;
 	};
 	
 	template<typename Ret, typename... Args>
@@ -26,7 +35,8 @@ namespace lpp
 	{
 		public:
 			CppFunction(lua_State* state, const std::string& name, const std::function<Ret(Args...)>& f)
-			:	function(f)
+			:	BaseCppFunction(name),
+				function(f)
 			{
 				lua_pushlightuserdata(state, static_cast<BaseCppFunction*>(this));
 				
@@ -54,7 +64,8 @@ namespace lpp
 	{
 		public:
 			CppFunction(lua_State* state, const std::string& name, const std::function<void(Args...)>& f)
-			:	function(f)
+			:	BaseCppFunction(name),
+				function(f)
 			{
 				lua_pushlightuserdata(state, static_cast<BaseCppFunction*>(this));
 				
@@ -75,6 +86,78 @@ namespace lpp
 		private:
 			const std::function<void(Args...)> function;
 	};
+	
+	// plain function pointers are called from a lua_CFunction made for their signature, with the pointer and its CallStats id
+	// as its upvalue. arguments are read off the stack straight into the call, without a std::function, tuple, or virtual call between
+	template<typename Ret, typename... Args>
+	struct FunctionPointer
+	{
+		using Type = Ret (*)(Args...);
+		
+		struct Bound
+		{
+			Type function;
+			unsigned id;
+		};
+		
+		// pushes the closure
+		static void push(lua_State* state, Type f, unsigned id)
+		{
+			Bound* bound = static_cast<Bound*>(lua_newuserdata(state, sizeof(Bound)));
+			*bound = {f, id};
+			
+			lua_pushcclosure(state, &dispatch, 1);
+		}
+		
+		static int dispatch(lua_State* state)
+		{
+			Bound bound = *static_cast<Bound*>(lua_touserdata(state, lua_upvalueindex(1)));
+			CallStats::count(bound.id);
+			return call(state, bound.function, typename detail::indicesBuilder<sizeof...(Args)>::type());
+		}
+		
+		template<std::size_t... N>
+		static int call(lua_State* state, Type f, detail::indices<N...>)
+		{
+			Ret value = f(detail::checkGet(detail::id<Args>{}, state, N + 1)...);
+			return detail::pushValue(state, value);
+		}
+	};
+	
+	template<typename... Args>
+	struct FunctionPointer<void, Args...>
+	{
+		using Type = void (*)(Args...);
+		
+		struct Bound
+		{
+			Type function;
+			unsigned id;
+		};
+		
+		static void push(lua_State* state, Type f, unsigned id)
+		{
+			Bound* bound = static_cast<Bound*>(lua_newuserdata(state, sizeof(Bound)));
+			*bound = {f, id};
+			
+			lua_pushcclosure(state, &dispatch, 1);
+		}
+		
+		static int dispatch(lua_State* state)
+		{
+			Bound bound = *static_cast<Bound*>(lua_touserdata(state, lua_upvalueindex(1)));
+			CallStats::count(bound.id);
+			return call(state, bound.function, typename detail::indicesBuilder<sizeof...(Args)>::type());
+		}
+		
+		template<std::size_t... N>
+		static int call(lua_State* state, Type f, detail::indices<N...>)
+		{
+			(void)state; // unused by functions without arguments
+			f(detail::checkGet(detail::id<Args>{}, state, N + 1)...);
+			return 0;
+		}
+	};
 }
 
 #endif // CPP_FUNCTION_HPP
@@ -1,11 +1,15 @@
 #ifndef DETAILS_HPP
 #define DETAILS_HPP
 
-#include <lua.hpp>
+#include "Compat.hpp"
 
+#include <string>
 #include <vector>
 #include <map>
 #include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
 
 namespace detail
 {
@@ -25,6 +29,17 @@ namespace detail
 		using type = indices<Is...>;
 	};
 	
+	// small trivially copyable types (ex: handles) can be passed by value, stored in a light userdata.
+	// specialize to true for a type to enable it
+	template<typename T>
+	struct isLightValue : std::false_type {};
+	
+	template<typename T>
+	using enableIfLight = typename std::enable_if<isLightValue<typename std::remove_cv<T>::type>::value, int>::type;
+	
+	template<typename T>
+	using enableIfNotLight = typename std::enable_if<!isLightValue<typename std::remove_cv<T>::type>::value, int>::type;
+	
 	// pushing primitives
 	inline int pushValue(lua_State* state, bool b)
 	{
@@ -50,6 +65,15 @@ namespace detail
 		return 1;
 	}
 	
+#ifdef LPP_LUAJIT
+	// bindings take floats, LuaJIT's numbers are doubles
+	inline int pushValue(lua_State* state, float f)
+	{
+		lua_pushnumber(state, f);
+		return 1;
+	}
+#endif
+	
 	inline int pushValue(lua_State* state, const std::string s)
 	{
 		lua_pushlstring(state, s.c_str(), s.size());
@@ -101,12 +125,30 @@ namespace detail
 	}
 	
 	template<typename T>
-	inline int pushValue(lua_State* state, T& t)
+	inline int pushValue(lua_State* state, T& t, enableIfNotLight<T> = 0)
 	{
 		lua_pushlightuserdata(state, &t);
 		return 1;
 	}
 	
+	// pushing light values
+	template<typename T>
+	inline int pushValue(lua_State* state, const T& t, enableIfLight<T> = 0)
+	{
+		static_assert(sizeof(T) <= sizeof(void*), "light values must fit in a pointer");
+		
+		std::uintptr_t bits = 0;
+		std::memcpy(&bits, static_cast<const void*>(&t), sizeof(T));
+		
+		// zeroed values are pushed as nil, like null pointers
+		if(bits)
+			lua_pushlightuserdata(state, reinterpret_cast<void*>(bits));
+		else
+			lua_pushnil(state);
+		
+		return 1;
+	}
+	
 	// push tuple
 	template<typename... Ts>
 	inline int pushValue(lua_State* state, std::tuple<Ts...>& tup)
@@ -155,6 +197,13 @@ namespace detail
 	{
 		return luaL_checknumber(state, idx);
 	}
+	
+#ifdef LPP_LUAJIT
+	inline float checkGet(id<float>, lua_State* state, int idx = -1)
+	{
+		return static_cast<float>(luaL_checknumber(state, idx));
+	}
+#endif
 
 	inline std::string checkGet(id<std::string>, lua_State* state, int idx = -1)
 	{
@@ -223,21 +272,40 @@ namespace detail
 	
 	// objects
 	template<typename T>
-	inline T checkGet(id<T>, lua_State* state, int idx = -1)
+	inline T checkGet(id<T>, lua_State* state, int idx = -1, enableIfNotLight<T> = 0)
 	{
 		return static_cast<T>(lua_touserdata(state, idx));
 	}
+	
+	// light values, nil or anything else gives a zeroed value
+	template<typename T>
+	inline T checkGet(id<T>, lua_State* state, int idx = -1, enableIfLight<T> = 0)
+	{
+		T t{};
+		
+		if(lua_islightuserdata(state, idx))
+		{
+			std::uintptr_t bits = reinterpret_cast<std::uintptr_t>(lua_touserdata(state, idx));
+			std::memcpy(static_cast<void*>(&t), &bits, sizeof(T));
+		}
+		
+		return t;
+	}
 
+	// a full userdata holds a pointer to its object, a light one is the pointer
 	template<typename T>
 	inline T* checkGet(id<T*>, lua_State* state, int idx = -1)
 	{
+		if(lua_type(state, idx) == LUA_TUSERDATA)
+			return *static_cast<T**>(lua_touserdata(state, idx));
+		
 		return static_cast<T*>(lua_touserdata(state, idx));
 	}
 
 	template<typename T>
 	inline T& checkGet(id<T&>, lua_State* state, int idx = -1)
 	{
-		return *static_cast<T*>(lua_touserdata(state, idx));
+		return *checkGet(id<T*>{}, state, idx);
 	}
 
 	// getting arguments
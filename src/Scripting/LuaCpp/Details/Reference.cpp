@@ -0,0 +1,129 @@
+#include "Reference.hpp"
+
+#include <utility>
+
+namespace lpp
+{
+	Reference::Reference()
+	:	state(nullptr),
+		ref(LUA_NOREF)
+	{}
+	
+	Reference::Reference(lua_State* s)
+	:	state(s),
+		ref(luaL_ref(state, LUA_REGISTRYINDEX))	// nil is referenced as LUA_REFNIL
+	{}
+	
+	Reference::Reference(lua_State* s, const std::string& global)
+	:	state(s),
+		ref(LUA_NOREF)
+	{
+		lua_getglobal(state, global.c_str());
+		ref = luaL_ref(state, LUA_REGISTRYINDEX);
+	}
+	
+	Reference::Reference(Reference&& other)
+	:	state(other.state),
+		ref(other.ref)
+	{
+		other.ref = LUA_NOREF;
+	}
+	
+	Reference& Reference::operator=(Reference&& other)
+	{
+		if(this != &other)
+		{
+			reset();
+			state = other.state;
+			ref = other.ref;
+			other.ref = LUA_NOREF;
+		}
+		
+		return *this;
+	}
+	
+	Reference::~Reference()
+	{
+		reset();
+	}
+	
+	Reference::operator bool() const
+	{
+		return ref != LUA_NOREF && ref != LUA_REFNIL;
+	}
+	
+	void Reference::push() const
+	{
+		if(*this)
+			lua_rawgeti(state, LUA_REGISTRYINDEX, ref);
+		else
+			lua_pushnil(state);
+	}
+	
+	void Reference::reset()
+	{
+		if(*this)
+			luaL_unref(state, LUA_REGISTRYINDEX, ref);
+		
+		ref = LUA_NOREF;
+	}
+	
+	Global::Global()
+	:	state(nullptr)
+	{}
+	
+	Global::Global(lua_State* s, const std::string& name)
+	:	state(s)
+	{
+		compat::pushGlobals(state);
+		table = Reference(state);
+		
+		// the string is interned once, here
+		lua_pushlstring(state, name.c_str(), name.size());
+		key = Reference(state);
+	}
+	
+	Global::Global(Global&& other)
+	:	table(std::move(other.table)),
+		key(std::move(other.key)),
+		state(other.state)
+	{}
+	
+	Global& Global::operator=(Global&& other)
+	{
+		table = std::move(other.table);
+		key = std::move(other.key);
+		state = other.state;
+		
+		return *this;
+	}
+	
+	void Global::push() const
+	{
+		if(!key)
+		{
+			lua_pushnil(state);
+			return;
+		}
+		
+		table.push();
+		key.push();
+		lua_rawget(state, -2);
+		lua_remove(state, -2);
+	}
+	
+	bool Global::toBool() const
+	{
+		push();
+		bool value = lua_toboolean(state, -1);
+		lua_pop(state, 1);
+		
+		return value;
+	}
+	
+	void Global::reset()
+	{
+		table.reset();
+		key.reset();
+	}
+}
@@ -0,0 +1,86 @@
+#ifndef LUA_REFERENCE_HPP
+#define LUA_REFERENCE_HPP
+
+#include "Compat.hpp"
+
+#include <string>
+
+#include "Details.hpp"
+
+namespace lpp
+{
+	// a value kept in the registry, looked up once where a Selection would look it up by name each time.
+	// for functions called often. Must not outlive the lua_State it's from
+	class Reference
+	{
+		public:
+			Reference();
+			
+			// the value on top of the stack, which is popped. Empty if it's nil
+			explicit Reference(lua_State* s);
+			
+			// the global's value as it is now. Empty if it's nil
+			Reference(lua_State* s, const std::string& global);
+			
+			Reference(const Reference&) = delete;
+			Reference& operator=(const Reference&) = delete;
+			
+			Reference(Reference&& other);
+			Reference& operator=(Reference&& other);
+			
+			~Reference();
+			
+			explicit operator bool() const;
+			
+			void push() const;
+			
+			// calls the value with args, dropping what it returns.
+			// Returns an error code if an error occurs, the error is then pushed onto the stack, like State::run
+			template<typename... Args>
+			auto call(Args... args) const -> decltype(LUA_OK);
+			
+			void reset();
+			
+		private:
+			lua_State* state;
+			int ref;
+	};
+	
+	// a global looked up by a key string kept in the registry, so its name isn't hashed again for every read.
+	// for variables read often, whose values change. Read from the globals table that's current when it's made,
+	// skipping its metatable
+	class Global
+	{
+		public:
+			Global();
+			Global(lua_State* s, const std::string& name);
+			
+			Global(Global&& other);
+			Global& operator=(Global&& other);
+			
+			// its value, on the stack
+			void push() const;
+			
+			// its value, as Lua takes it as a condition
+			bool toBool() const;
+			
+			void reset();
+			
+		private:
+			Reference table;
+			Reference key;
+			lua_State* state;
+	};
+	
+	template<typename... Args>
+	auto Reference::call(Args... args) const -> decltype(LUA_OK)
+	{
+		push();
+		
+		detail::distributeArgs(state, args...);
+		
+		return lua_pcall(state, sizeof...(Args), 0, 0);
+	}
+}
+
+#endif // LUA_REFERENCE_HPP
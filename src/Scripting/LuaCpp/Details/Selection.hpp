@@ -117,7 +117,11 @@ namespace lpp
 	template<typename Ret, typename... Args>
 	void Selection::operator =(Ret (*f)(Args... args))
 	{
-		functions.emplace(name, std::unique_ptr<BaseCppFunction>(new CppFunction<Ret, Args...>(state, name, f)));
+		// nothing to keep on this side, a function bound here before under the name is done with
+		functions.erase(name);
+		
+		FunctionPointer<Ret, Args...>::push(state, f, CallStats::getId(name));
+		lua_setglobal(state, name.c_str());
 	}
 	
 	// casting
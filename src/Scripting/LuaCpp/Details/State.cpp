@@ -1,41 +1,148 @@
 #include "State.hpp"
 
+#include <cstdio>
+
 namespace lpp
 {
 	State::State()
+	:	State(nullptr)
 	{
-		state = luaL_newstate();
+	}
+	
+	State::State(State* host)
+#ifdef LPP_LUAJIT
+	:	allocator(nullptr),
+#else
+	:	allocator(host ? nullptr : new Allocator()),
+#endif
+		state(host ? host->state : newState(allocator.get())),
+		owner(host == nullptr),
+		globals(LUA_NOREF),
+		hostGlobals(host ? host->globals : LUA_NOREF)
+	{
+		if(owner)
+		{
+			compat::pushGlobals(state);
+			globals = luaL_ref(state, LUA_REGISTRYINDEX);
+		}
+		else
+		{
+			makeEnvironment(hostGlobals);
+		}
 	}
 
 	State::~State()
 	{
-		lua_settop(state, 0);
-		lua_close(state);
+		if(owner)
+		{
+			lua_settop(state, 0);
+			lua_close(state);
+		}
+		else
+		{
+			luaL_unref(state, LUA_REGISTRYINDEX, globals);
+		}
+	}
+	
+	lua_State* State::newState(Allocator* allocator)
+	{
+		if(!allocator)
+			return luaL_newstate();
+		
+		lua_State* state = lua_newstate(&Allocator::allocate, allocator);
+		
+		// as luaL_newstate's
+		if(state)
+			lua_atpanic(state, &panic);
+		
+		return state;
+	}
+	
+	int State::panic(lua_State* state)
+	{
+		std::fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n", lua_tostring(state, -1));
+		return 0;
+	}
+	
+	void State::activate() const
+	{
+		lua_rawgeti(state, LUA_REGISTRYINDEX, globals);
+		compat::setGlobals(state);
+	}
+	
+	void State::makeEnvironment(int host)
+	{
+		// looks up what it doesn't have in the host's globals, libraries and all
+		lua_newtable(state);
+		lua_newtable(state);
+		lua_rawgeti(state, LUA_REGISTRYINDEX, host);
+		lua_setfield(state, -2, "__index");
+		lua_setmetatable(state, -2);
+		
+		globals = luaL_ref(state, LUA_REGISTRYINDEX);
 	}
 	
 	auto State::loadFile(const std::string& f) -> decltype(LUA_OK)
 	{
+		activate();
 		return luaL_loadfile(state, f.c_str());
 	}
 	
+	auto State::loadBuffer(const char* data, std::size_t size, const std::string& name) -> decltype(LUA_OK)
+	{
+		activate();
+		return luaL_loadbuffer(state, data, size, name.c_str());
+	}
+	
+	auto State::loadBinary(const char* data, std::size_t size, const std::string& name) -> decltype(LUA_OK)
+	{
+		activate();
+		return luaL_loadbufferx(state, data, size, name.c_str(), "b");
+	}
+	
+	bool State::dump(std::vector<std::uint8_t>& out) const
+	{
+		out.clear();
+		
+		if(!lua_isfunction(state, -1) || lua_iscfunction(state, -1))
+			return false;
+		
+		auto writer = [](lua_State*, const void* p, std::size_t size, void* data) -> int
+		{
+			const std::uint8_t* bytes = static_cast<const std::uint8_t*>(p);
+			std::vector<std::uint8_t>* chunk = static_cast<std::vector<std::uint8_t>*>(data);
+			chunk->insert(chunk->end(), bytes, bytes + size);
+			return 0;
+		};
+		
+		return lua_dump(state, writer, &out) == 0;
+	}
+	
 	auto State::run() -> decltype(LUA_OK)
 	{
+		activate();
 		return lua_pcall(state, 0, 0, 0);
 	}
 	
 	void State::openLib(const std::string& name, lua_CFunction open)
 	{
+		if(!owner)
+			return;
+		
+		activate();
 		luaL_requiref(state, name.c_str(), open, 1);
 		clean();
 	}
 	
 	Selection State::operator[](const std::string& name)
 	{
+		activate();
 		return Selection(state, name, functions);
 	}
 	
 	Selection State::operator[](int idx)
 	{
+		activate();
 		int top = lua_gettop(state);
 		
 		if(top != 0 && std::abs(idx) <= top)
@@ -52,6 +159,7 @@ namespace lpp
 	void State::call(const std::string& func, int nargs)
 	{
 		// put everything in the right order
+		activate();
 		lua_getglobal(state, func.c_str());
 		
 		for(int i = -(nargs + 1); i < -1; i++)
@@ -74,6 +182,7 @@ namespace lpp
 	
 	auto State::operator()(const std::string& name) -> decltype(LUA_OK)
 	{
+		activate();
 		luaL_loadstring(state, name.c_str());
 		return lua_pcall(state, 0, 0, 0);
 	}
@@ -95,15 +204,32 @@ namespace lpp
 	
 	State::operator lua_State*() const
 	{
+		activate();
 		return state;
 	}
 	
 	void State::reload()
 	{
+		functions.clear();
+		
+		if(!owner)
+		{
+			luaL_unref(state, LUA_REGISTRYINDEX, globals);
+			makeEnvironment(hostGlobals);
+			return;
+		}
+		
 		lua_settop(state, 0);
 		lua_close(state);
-		state = luaL_newstate();
-		functions.clear();
+		state = newState(allocator.get());
+		
+		compat::pushGlobals(state);
+		globals = luaL_ref(state, LUA_REGISTRYINDEX);
+	}
+	
+	bool State::isShared() const
+	{
+		return !owner;
 	}
 	
 	void State::clean()
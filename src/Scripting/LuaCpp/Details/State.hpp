@@ -1,11 +1,16 @@
 #ifndef LUA_STATE_HPP
 #define LUA_STATE_HPP
 
-#include <lua.hpp>
+#include "Compat.hpp"
 
 #include <string>
+#include <memory>
+#include <vector>
+#include <cstdint>
 
 #include "Selection.hpp"
+#include "Reference.hpp"
+#include "Allocator.hpp"
 
 namespace lpp
 {
@@ -14,6 +19,12 @@ namespace lpp
 		public:
 			State();
 			
+			// runs in host's lua_State, with a globals table of its own that falls back to host's.
+			// Libraries are host's, opening them here does nothing. host must outlive it, and isn't reloaded.
+			// Only one state of a VM is used at a time: every call on a state makes its globals the VM's globals.
+			// A VM of its own if host is nullptr
+			explicit State(State* host);
+			
 			// non-copyable
 			State(const State&) = delete;
 			State& operator=(const State&) = delete;
@@ -29,6 +40,15 @@ namespace lpp
 			// popped and read with getErrors()
 			auto loadFile(const std::string& f) -> decltype(LUA_OK);
 			
+			// the same, from code in memory. name is what errors call it
+			auto loadBuffer(const char* data, std::size_t size, const std::string& name) -> decltype(LUA_OK);
+			
+			// the same, only taking chunks compiled by dump, by this version of Lua
+			auto loadBinary(const char* data, std::size_t size, const std::string& name) -> decltype(LUA_OK);
+			
+			// the compiled form of the loaded chunk on top of the stack, which is left there. False if it isn't a Lua function
+			bool dump(std::vector<std::uint8_t>& out) const;
+			
 			// run the file.
 			// Returns an error code if an error occurs
 			// the error is then pushed onto the stack, from where it can be
@@ -63,13 +83,32 @@ namespace lpp
 			// act as a lua_State
 			operator lua_State*() const;
 			
-			// reset the Lua state
+			// reset the Lua state. A shared state only gets a new globals table
 			void reload();
 			
+			bool isShared() const;
+			
 			void clean();
 
 		private:
+			// sets the registry's globals to this state's, which is what lua_getglobal, lua_setglobal,
+			// and chunks loaded from now on use
+			void activate() const;
+			
+			// a globals table falling back to host's
+			void makeEnvironment(int hostGlobals);
+			
+			// a VM allocating from allocator, if there is one
+			static lua_State* newState(Allocator* allocator);
+			static int panic(lua_State* state);
+			
+			// made before state, and destroyed after it. LuaJIT allocates with its own, 64 bit builds can't be given one
+			std::unique_ptr<Allocator> allocator;
+			
 			lua_State* state;
+			bool owner;
+			int globals;	// registry reference of the globals table
+			int hostGlobals;
 			
 			using FunctionsMap = std::unordered_map<std::string, std::unique_ptr<BaseCppFunction>>;
 			
@@ -79,6 +118,7 @@ namespace lpp
 	template<typename T>
 	void State::push(T v)
 	{
+		activate();
 		detail::pushValue(state, v);
 	}
 }
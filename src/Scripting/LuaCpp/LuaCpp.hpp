@@ -2,5 +2,7 @@
 #define LUA_CPP_HPP
 
 #include "Details/State.hpp"
+#include "Details/Coroutine.hpp"
+#include "Details/CallStats.hpp"
 
 #endif // LUA_CPP_HPP
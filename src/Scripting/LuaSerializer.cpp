@@ -0,0 +1,243 @@
+#include "LuaSerializer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace swift
+{
+	void LuaSerializer::write(lua_State* state, int idx, ByteWriter& out)
+	{
+		std::vector<const void*> path;
+		write(state, idx, out, path);
+	}
+
+	bool LuaSerializer::read(lua_State* state, ByteReader& in)
+	{
+		return read(state, in, 0);
+	}
+
+	void LuaSerializer::write(lua_State* state, int idx, ByteWriter& out, std::vector<const void*>& path)
+	{
+		// by type, lua_tolstring would turn number keys into strings under lua_next
+		switch(lua_type(state, idx))
+		{
+			case LUA_TBOOLEAN:
+				out.writeByte(lua_toboolean(state, idx) ? True : False);
+				break;
+			case LUA_TNUMBER:
+				writeNumber(lua_tonumber(state, idx), out);
+				break;
+			case LUA_TSTRING:
+			{
+				std::size_t size;
+				const char* s = lua_tolstring(state, idx, &size);
+
+				out.writeByte(String);
+				out.writeString({s, size});
+				break;
+			}
+			case LUA_TTABLE:
+				writeTable(state, idx, out, path);
+				break;
+			default:
+				out.writeByte(Nil);
+				break;
+		}
+	}
+
+	void LuaSerializer::writeTable(lua_State* state, int idx, ByteWriter& out, std::vector<const void*>& path)
+	{
+		// relative indices move as things are pushed
+		if(idx < 0 && idx > LUA_REGISTRYINDEX)
+			idx = lua_gettop(state) + idx + 1;
+
+		const void* table = lua_topointer(state, idx);
+
+		if(path.size() >= MaxDepth || std::find(path.begin(), path.end(), table) != path.end() || !lua_checkstack(state, 3))
+		{
+			out.writeByte(Nil);
+			return;
+		}
+
+		path.push_back(table);
+		out.writeByte(Table);
+
+		std::size_t length = lua_rawlen(state, idx);
+		out.writeUInt(length);
+
+		for(std::size_t i = 1; i <= length; i++)
+		{
+			lua_rawgeti(state, idx, static_cast<int>(i));
+			write(state, -1, out, path);
+			lua_pop(state, 1);
+		}
+
+		lua_pushnil(state);
+
+		while(lua_next(state, idx))
+		{
+			int keyType = lua_type(state, -2);
+			bool inArray = false;
+
+			if(keyType == LUA_TNUMBER)
+			{
+				lua_Number key = lua_tonumber(state, -2);
+				inArray = key >= 1 && key <= length && key == std::floor(key);
+			}
+
+			if(!inArray && keyType != LUA_TTABLE && isWritable(keyType) && isWritable(lua_type(state, -1)))
+			{
+				write(state, -2, out, path);
+				write(state, -1, out, path);
+			}
+
+			lua_pop(state, 1);
+		}
+
+		// no key is nil, so it ends the pairs
+		out.writeByte(Nil);
+
+		path.pop_back();
+	}
+
+	void LuaSerializer::writeNumber(lua_Number n, ByteWriter& out)
+	{
+		double d = n;
+
+		// whole numbers a double holds exactly
+		if(d == std::floor(d) && std::abs(d) <= 9007199254740992.0)
+		{
+			out.writeByte(Integer);
+			out.writeInt(static_cast<std::int64_t>(d));
+		}
+		else if(static_cast<double>(static_cast<float>(d)) == d)
+		{
+			out.writeByte(Float);
+			out.writeFloat(static_cast<float>(d));
+		}
+		else
+		{
+			std::uint64_t bits;
+			std::memcpy(&bits, &d, sizeof(bits));
+
+			out.writeByte(Double);
+			out.writeUInt32(static_cast<std::uint32_t>(bits));
+			out.writeUInt32(static_cast<std::uint32_t>(bits >> 32));
+		}
+	}
+
+	bool LuaSerializer::read(lua_State* state, ByteReader& in, unsigned depth)
+	{
+		if(!lua_checkstack(state, 3))
+			return false;
+
+		switch(in.readByte())
+		{
+			case Nil:
+				lua_pushnil(state);
+				break;
+			case False:
+				lua_pushboolean(state, 0);
+				break;
+			case True:
+				lua_pushboolean(state, 1);
+				break;
+			case Integer:
+				lua_pushnumber(state, static_cast<lua_Number>(in.readInt()));
+				break;
+			case Float:
+				lua_pushnumber(state, static_cast<lua_Number>(in.readFloat()));
+				break;
+			case Double:
+			{
+				std::uint64_t bits = in.readUInt32();
+				bits |= static_cast<std::uint64_t>(in.readUInt32()) << 32;
+
+				double d;
+				std::memcpy(&d, &bits, sizeof(d));
+
+				lua_pushnumber(state, static_cast<lua_Number>(d));
+				break;
+			}
+			case String:
+			{
+				std::string s = in.readString();
+				lua_pushlstring(state, s.c_str(), s.size());
+				break;
+			}
+			case Table:
+				if(!readTable(state, in, depth))
+					return false;
+
+				break;
+			default:
+				in.fail();
+				return false;
+		}
+
+		if(!in.good())
+		{
+			lua_pop(state, 1);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool LuaSerializer::readTable(lua_State* state, ByteReader& in, unsigned depth)
+	{
+		if(depth >= MaxDepth)
+			return false;
+
+		std::uint64_t length = in.readUInt();
+
+		// every value takes at least a byte
+		if(!in.good() || length > in.remaining())
+			return false;
+
+		lua_createtable(state, static_cast<int>(length), 0);
+
+		for(std::uint64_t i = 1; i <= length; i++)
+		{
+			if(!read(state, in, depth + 1))
+			{
+				lua_pop(state, 1);
+				return false;
+			}
+
+			lua_rawseti(state, -2, static_cast<int>(i));
+		}
+
+		while(true)
+		{
+			if(!read(state, in, depth + 1))
+			{
+				lua_pop(state, 1);
+				return false;
+			}
+
+			if(lua_isnil(state, -1))
+			{
+				lua_pop(state, 1);
+				return true;
+			}
+
+			// a NaN key is an error in Lua, and never written
+			bool nan = lua_type(state, -1) == LUA_TNUMBER && lua_tonumber(state, -1) != lua_tonumber(state, -1);
+
+			if(nan || !read(state, in, depth + 1))
+			{
+				lua_pop(state, 2);
+				return false;
+			}
+
+			lua_rawset(state, -3);
+		}
+	}
+
+	bool LuaSerializer::isWritable(int type)
+	{
+		return type == LUA_TBOOLEAN || type == LUA_TNUMBER || type == LUA_TSTRING || type == LUA_TTABLE;
+	}
+}
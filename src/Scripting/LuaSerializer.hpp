@@ -0,0 +1,55 @@
+#ifndef LUASERIALIZER_HPP
+#define LUASERIALIZER_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "LuaCpp/LuaCpp.hpp"
+
+#include "../Serialization/ByteStream.hpp"
+
+namespace swift
+{
+	// Lua values in the ByteStream encoding, a tag byte then the value. Numbers that are whole are varints,
+	// strings are written as ByteWriter writes them, and tables are their array part then their other pairs.
+	// tables are read and written raw, their metatables aren't
+	class LuaSerializer
+	{
+		public:
+			static const unsigned MaxDepth = 32;	// of nested tables
+			
+			// the value at idx. Functions, userdata, and threads are written as nil, as are tables nested
+			// deeper than MaxDepth, and tables already being written (cycles). Pairs with keys or values
+			// like that are left out, as are pairs with table keys
+			static void write(lua_State* state, int idx, ByteWriter& out);
+			
+			// pushes the value read. False, with nothing pushed, if the data is malformed
+			static bool read(lua_State* state, ByteReader& in);
+		
+		private:
+			enum Tag : std::uint8_t
+			{
+				Nil,
+				False,
+				True,
+				Integer,
+				Float,
+				Double,
+				String,
+				Table
+			};
+			
+			// path holds the tables being written
+			static void write(lua_State* state, int idx, ByteWriter& out, std::vector<const void*>& path);
+			static void writeTable(lua_State* state, int idx, ByteWriter& out, std::vector<const void*>& path);
+			static void writeNumber(lua_Number n, ByteWriter& out);
+			
+			static bool read(lua_State* state, ByteReader& in, unsigned depth);
+			static bool readTable(lua_State* state, ByteReader& in, unsigned depth);
+			
+			// types that aren't written as nil
+			static bool isWritable(int type);
+	};
+}
+
+#endif // LUASERIALIZER_HPP
@@ -8,118 +8,487 @@
 #include "../World/World.hpp"
 
 #include "../Math/Math.hpp"
+#include "../Profiling/Profiler.hpp"
+#include "../Memory/MemoryTracker.hpp"
+#include "../Memory/FrameArena.hpp"
+
+#include "../Serialization/AsyncWriter.hpp"
+
+#include "LuaSerializer.hpp"
+#include "ComponentFields.hpp"
+#include "LuaCpp/Details/Allocator.hpp"
 
 #include <tinyxml2.h>
 
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <fstream>
+
 namespace swift
 {
+	namespace
+	{
+		// every VM's blocks count as scripting memory, set before statics make any VM
+		struct CountLuaMemory
+		{
+			CountLuaMemory()
+			{
+				lpp::Allocator::setObserver([](std::size_t freed, std::size_t allocated)
+				{
+					if(freed)
+						MemoryTracker::release(MemoryTracker::Category::Scripting, freed);
+					
+					if(allocated)
+						MemoryTracker::allocate(MemoryTracker::Category::Scripting, allocated);
+				});
+			}
+		} countLuaMemory;
+	}
+	
 	sf::RenderWindow* Script::window = nullptr;
 	AssetManager* Script::assets = nullptr;
 	sf::Clock* Script::clock = nullptr;
 	Settings* Script::settings = nullptr;
 	KeyboardManager* Script::keyboard = nullptr;
-	World* Script::world = nullptr;
 	Play* Script::play = nullptr;
 
+	World* Script::active = nullptr;
+	thread_local World* Script::world = nullptr;
+	thread_local Script::Deferred* Script::deferred = nullptr;
+
+	std::unique_ptr<lpp::State> Script::host;
+	bool Script::shareState = false;
+
+	unsigned Script::budget = 0;
+	std::map<std::string, unsigned> Script::overBudget;
+
+	TimerWheel Script::timers;
+	float Script::tickLength = 1.f / 60.f;	// until the first tick
+
+	BytecodeCache Script::bytecode;
+
+	std::vector<Script*> Script::listeners;
+
+	std::vector<Script*> Script::instances;
+	std::size_t Script::nextCollected = 0;
+
 	Script::Script()
-	:	file(""),
+	:	luaState(sharedHost()),
+		nextTrigger(1),
+		stats(),
+		collected(0),
+		settled(0),
+		collecting(false),
+		file(""),
 		deleteMe(false)
 	{
-		// We don't want to give the scripts access to os commands or file writing abilities
-		// so we only open the necessary libraries
-		luaState.openLib("base", luaopen_base);
-		luaState.openLib("math", luaopen_math);
-		luaState.openLib("string", luaopen_string);
-		luaState.openLib("table", luaopen_table);
-
-		addVariables();
-		addClasses();
-		addFunctions();
+		setup();
+		instances.push_back(this);
 	}
 
 	Script::~Script()
 	{
+		clearTriggers();
+		instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
 	}
 
 	bool Script::loadFromFile(const std::string& file)
 	{
-		bool loadResult = luaState.loadFile(file) == LUA_OK;
+		SWIFT_MEMORY_SCOPE(Scripting);
+
+		std::ifstream fin(file, std::ios::binary);
+
+		if(!bytecode.isEnabled() || !fin)
+			return finishLoad(luaState.loadFile(file) == LUA_OK, file);
+
+		std::vector<char> source((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+		// as luaL_loadfile does, a first line starting with # is skipped, keeping its newline so line numbers stay right
+		std::size_t skip = 0;
+
+		if(!source.empty() && source[0] == '#')
+		{
+			while(skip < source.size() && source[skip] != '\n')
+				skip++;
+		}
+
+		// named as luaL_loadfile names it
+		return finishLoad(loadChunk(source.data() + skip, source.size() - skip, '@' + file) == LUA_OK, file);
+	}
+
+	bool Script::loadFromMemory(const void* data, std::size_t size, const std::string& file)
+	{
+		SWIFT_MEMORY_SCOPE(Scripting);
+
+		return finishLoad(loadChunk(static_cast<const char*>(data), size, file) == LUA_OK, file);
+	}
+
+	bool Script::reload(const void* data, std::size_t size)
+	{
+		if(loadChunk(static_cast<const char*>(data), size, file) != LUA_OK)
+		{
+			SWIFT_ERROR(Scripting, file << " reload: " << luaState.getErrors() << '\n');
+			return false;
+		}
+
+		return finishLoad(true, file);
+	}
+
+	decltype(LUA_OK) Script::loadChunk(const char* data, std::size_t size, const std::string& name)
+	{
+		thread_local std::vector<std::uint8_t> compiled;
+
+		if(bytecode.find(name, data, size, compiled))
+		{
+			// made by another version of Lua, or of the engine's build of it, it's compiled again and replaced
+			if(luaState.loadBinary(reinterpret_cast<const char*>(compiled.data()), compiled.size(), name) == LUA_OK)
+				return LUA_OK;
+
+			lua_pop(static_cast<lua_State*>(luaState), 1);
+		}
+
+		auto result = luaState.loadBuffer(data, size, name);
 
+		if(result == LUA_OK && bytecode.isEnabled() && luaState.dump(compiled))
+		{
+			if(!bytecode.store(name, data, size, compiled))
+				SWIFT_DEBUG(Scripting, "Could not cache the bytecode of " << name << '\n');
+		}
+
+		return result;
+	}
+
+	bool Script::finishLoad(bool loadResult, const std::string& file)
+	{
 		if(!loadResult)
-			log << "[ERROR]: " << file << " load: " << luaState.getErrors() << '\n';
+			SWIFT_ERROR(Scripting, file << " load: " << luaState.getErrors() << '\n');
+
+		// the same numbers each run from the same seed, whichever thread the script runs on
+		rng = Random::stream(file);
 
 		bool runResult = luaState.run() == LUA_OK;
 
 		if(!runResult)
-			log << "[ERROR]: " << file << " run: " << luaState.getErrors() << '\n';
+			SWIFT_ERROR(Scripting, file << " run: " << luaState.getErrors() << '\n');
 
 		this->file = file;
 
+		resolveGlobals();
+
 		return loadResult && runResult;
 	}
 
+	void Script::resolveGlobals()
+	{
+		startFunction = lpp::Reference(luaState, "Start");
+		updateFunction = lpp::Reference(luaState, "Update");
+		collisionFunction = lpp::Reference(luaState, "OnCollision");
+		done = lpp::Global(luaState, "Done");
+	}
+
+	void Script::releaseGlobals()
+	{
+		startFunction.reset();
+		updateFunction.reset();
+		collisionFunction.reset();
+		done.reset();
+		updateRoutine.reset();
+	}
+
+	void Script::checkCall(decltype(LUA_OK) result, const char* function)
+	{
+		if(result != LUA_OK)
+			report(file + ' ' + function + ": " + luaState.getErrors() + '\n', Logger::Error);
+	}
+
+	void Script::checkDone()
+	{
+		if(done.toBool())
+			deleteMe = true;
+	}
+
 	void Script::start()
 	{
-		if(!luaState["Start"])
+		if(!startFunction)
 			return;
+		
+		lpp::CallStats::Scope counting(stats.calls);
 
-		luaState["Start"]();
+		checkCall(startFunction.call(), "Start");
 
-		if(!luaState["Done"])
-			return;
+		// Start may define the others
+		resolveGlobals();
 
-		if(static_cast<bool>(luaState["Done"]))
-		{
-			deleteMe = true;
-		}
+		checkDone();
 	}
 
 	void Script::update()
 	{
-		if(!luaState["Update"])
+		SWIFT_PROFILE("Script::update");
+		SWIFT_MEMORY_SCOPE(Scripting);
+		
+		lpp::CallStats::Scope counting(stats.calls);
+
+		// scripts only waiting on triggers don't need an Update
+		if(!updateFunction)
+		{
+			checkDone();
+			keepUpCollecting();
 			return;
+		}
 
-		luaState["Update"]();
+		std::int64_t begin = Profiler::now();
 
-		if(!luaState["Done"])
+		switch(updateRoutine.resume(luaState, updateFunction, budget))
+		{
+			case lpp::Coroutine::Status::Finished:
+				checkDone();
+				break;
+			case lpp::Coroutine::Status::Yielded:
+				break;
+			case lpp::Coroutine::Status::OutOfBudget:
+			{
+				// shows as its own event, on top of Script::update
+				if(Profiler::isCapturing())
+					Profiler::record("Script over budget", begin, Profiler::now());
+
+				std::string name = file;
+
+				runOrDefer([name]
+				{
+					if(overBudget[name]++ == 0)
+						SWIFT_WARNING(Scripting, name << " Update ran out of budget, it carries on next tick\n");
+				});
+
+				break;
+			}
+			case lpp::Coroutine::Status::Error:
+				checkCall(LUA_ERRRUN, "Update");
+				break;
+		}
+		
+		stats.updateTime += Profiler::now() - begin;
+		stats.updates++;
+		
+		keepUpCollecting();
+	}
+	
+	void Script::collectGarbage(sf::Time budget)
+	{
+		if(instances.empty() || budget <= sf::Time::Zero)
 			return;
+		
+		SWIFT_PROFILE("Script::collectGarbage");
+		
+		std::int64_t end = Profiler::now() + budget.asMicroseconds();
+		std::size_t skipped = 0;
+		
+		// one small step at a time, round the scripts, carrying on from where the last frame stopped.
+		// Done once none has garbage worth collecting
+		while(skipped < instances.size() && Profiler::now() < end)
+		{
+			Script* s = instances[nextCollected++ % instances.size()];
+			std::size_t memory = getMemory(s->luaState);
+			
+			if(!s->collecting && memory <= s->settled + s->settled / 4)
+			{
+				skipped++;
+				continue;
+			}
+			
+			skipped = 0;
+			s->stepCollector(0);
+		}
+	}
+	
+	void Script::keepUpCollecting()
+	{
+		// spare time wasn't enough. Steps as big as what was allocated since the last, so memory can't run away
+		std::size_t memory = getMemory(luaState);
+		
+		if(memory > 2 * settled)
+			stepCollector(static_cast<int>((memory > collected ? memory - collected : 0) / 1024));
+	}
+	
+	void Script::stepCollector(int kilobytes)
+	{
+		lua_State* state = luaState;
+		
+		std::int64_t begin = Profiler::now();
+		
+		bool finished = lua_gc(state, LUA_GCSTEP, kilobytes) != 0;
+		
+		std::int64_t end = Profiler::now();
+		
+		if(Profiler::isCapturing())
+			Profiler::record("Script GC", begin, end);
+		
+		stats.gcTime += end - begin;
+		stats.memory = collected = getMemory(state);
+		
+		collecting = !finished;
+		
+		if(finished)
+			settled = collected;
+	}
+	
+	std::size_t Script::getMemory(lua_State* state)
+	{
+		return static_cast<std::size_t>(lua_gc(state, LUA_GCCOUNT, 0)) * 1024 + static_cast<std::size_t>(lua_gc(state, LUA_GCCOUNTB, 0));
+	}
+	
+	const Script::Stats& Script::getStats() const
+	{
+		return stats;
+	}
+	
+	void Script::resetStats()
+	{
+		stats = Stats();
+		stats.memory = collected;
+	}
 
-		if(static_cast<bool>(luaState["Done"]))
+	void Script::onContact(ContactEvent::Type type, EntityHandle self, EntityHandle other)
+	{
+		std::string name = type == ContactEvent::Type::Begin ? "begin" : type == ContactEvent::Type::Stay ? "stay" : "end";
+		
+		lpp::CallStats::Scope counting(stats.calls);
+		
+		if(collisionFunction)
+			checkCall(collisionFunction.call(name, self, other), "OnCollision");
+		
+		for(auto& id : findTriggers(Trigger::Type::Collision, [self](const Trigger& t) { return t.entity == self; }))
 		{
-			deleteMe = true;
+			auto it = triggers.find(id);
+			
+			if(it != triggers.end())
+				checkCall(it->second.function.call(name, self, other), "onCollision");
+		}
+	}
+	
+	void Script::updateEvents(float dt)
+	{
+		tickLength = dt;
+		
+		FrameArena::Scope scope;
+		FrameVector<TimerWheel::Timer> due;
+		timers.advance(due);
+		
+		for(auto& t : due)
+			t.owner->fireTimer(t.id);
+		
+		if(!world)
+			return;
+		
+		// callbacks may add and remove listeners
+		FrameVector<Script*> current(listeners.begin(), listeners.end());
+		
+		for(auto& s : current)
+			s->checkRadii();
+	}
+	
+	void Script::onKeyBinding(const std::string& binding)
+	{
+		std::vector<Script*> current = listeners;
+		
+		for(auto& s : current)
+		{
+			for(auto& id : s->findTriggers(Trigger::Type::Key, [&binding](const Trigger& t) { return t.binding == binding; }))
+			{
+				auto it = s->triggers.find(id);
+				lpp::CallStats::Scope counting(s->stats.calls);
+				
+				if(it != s->triggers.end())
+					s->checkCall(it->second.function.call(binding), "onKey");
+			}
 		}
 	}
 
 	bool Script::load(const std::string& lfile)
 	{
-		tinyxml2::XMLDocument loadFile;
-		tinyxml2::XMLError result = loadFile.LoadFile(lfile.c_str());
+		std::ifstream fin(lfile, std::ios::binary);
 
-		if(result != tinyxml2::XML_SUCCESS)
+		if(!fin)
 		{
-			if(result == tinyxml2::XML_ERROR_FILE_NOT_FOUND)
-				log << "[INFO]: Save file \"" << lfile << "\" not found.\n";
-			else
-				log << "[ERROR]: Loading script save file \"" << lfile << "\" failed.\n";
-			
+			SWIFT_INFO(Scripting, "Save file \"" << lfile << "\" not found.\n");
+			return false;
+		}
+
+		std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+		luaState.clean();
+
+		// saves from before binary ones are XML
+		ByteReader magic(bytes);
+		bool binary = magic.readUInt32() == SAVE_MAGIC && magic.good();
+
+		int total = binary ? readBinary(bytes) : readXml(bytes, lfile);
+
+		if(total < 0)
+		{
+			SWIFT_ERROR(Scripting, "Loading script save file \"" << lfile << "\" failed.\n");
+			luaState.clean();
 			return false;
 		}
 
+		if(luaState["Load"])
+			luaState.call("Load", total);
+		else
+			SWIFT_WARNING(Scripting, "No Load function in script \"" << file << "\"\n");
+
+		luaState.clean();
+
+		return true;
+	}
+
+	int Script::readBinary(const std::vector<std::uint8_t>& bytes)
+	{
+		ByteReader in(bytes);
+		in.readUInt32();
+
+		if(in.readByte() > SAVE_VERSION)
+			return -1;
+
+		std::uint64_t total = in.readUInt();
+
+		// every value takes at least a byte
+		if(!in.good() || total > in.remaining() || !lua_checkstack(luaState, static_cast<int>(total)))
+			return -1;
+
+		for(std::uint64_t i = 0; i < total; i++)
+		{
+			if(!LuaSerializer::read(luaState, in))
+				return -1;
+		}
+
+		return static_cast<int>(total);
+	}
+
+	int Script::readXml(const std::vector<std::uint8_t>& bytes, const std::string& lfile)
+	{
+		tinyxml2::XMLDocument loadFile;
+		loadFile.Parse(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+		if(loadFile.Error())
+			return -1;
+
 		tinyxml2::XMLElement* root = loadFile.FirstChildElement("script");
 		if(root == nullptr)
 		{
-			log << "[ERROR]: Script save file \"" << lfile << "\" does not have a \"script\" root element.\n";
-			return false;
+			SWIFT_ERROR(Scripting, "Script save file \"" << lfile << "\" does not have a \"script\" root element.\n");
+			return -1;
 		}
 
 		int total = 0;
 		tinyxml2::XMLElement* variable = root->FirstChildElement("variable");
 		while(variable != nullptr)
 		{
-			char type = variable->Attribute("type")[0];
-			std::string value = variable->GetText();
+			const char* type = variable->Attribute("type");
+			const char* text = variable->GetText();
+			std::string value = text ? text : "";
 
-			switch(type)
+			switch(type ? type[0] : '0')
 			{
 				case 'n':	// number
 					luaState.push(std::stod(value));
@@ -140,90 +509,96 @@ namespace swift
 			total++;
 			variable = variable->NextSiblingElement("variable");
 		}
-		
-		if(luaState["Load"])
-			luaState.call("Load", total);
-		else
-			log << "[WARNING]: No Load function in script \"" << file << "\"\n";
 
-		return true;
+		return total;
 	}
 
 	bool Script::save(const std::string& sfile)
 	{
-		// save all variables to save file
-		tinyxml2::XMLDocument saveFile;
-		tinyxml2::XMLError result = saveFile.LoadFile(sfile.c_str());
+		luaState.clean();
 
-		if(result != tinyxml2::XML_SUCCESS && result != tinyxml2::XML_ERROR_EMPTY_DOCUMENT && result != tinyxml2::XML_ERROR_FILE_NOT_FOUND)
+		if(!luaState["Save"])
 		{
-			log << "[ERROR]: Loading script save file \"" << sfile << "\" failed.\n";
+			SWIFT_INFO(Scripting, "Script: " << file << " does not have a Save function.\n");
 			return false;
 		}
 
-		tinyxml2::XMLElement* root = saveFile.FirstChildElement("script");
-		if(root == nullptr)
-		{
-			log << "[INFO]: Script save file \"" << sfile << "\" does not have a \"script\" root element.\n";
-			root = saveFile.NewElement("script");
-			saveFile.InsertEndChild(root);
-		}
-		else
-			root->DeleteChildren();
+		// what Save returns is saved
+		luaState["Save"]();
+
+		int totalRets = luaState.getTop();
+
+		// written with the worlds' format
+		std::vector<std::uint8_t> data = World::getSaveFormat() == World::SaveFormat::Binary ? writeBinary(totalRets) : writeXml(totalRets);
 
 		luaState.clean();
 
-		if(luaState["Save"])
+		if(!AsyncWriter::write(sfile, data, AsyncWriter::Mode::Replace))
 		{
-			// call save function
-			luaState["Save"]();
+			SWIFT_ERROR(Scripting, "Saving script save file: " << sfile << " failed at saving.\n");
+			return false;
+		}
 
-			int totalRets = luaState.getTop();
+		return true;
+	}
 
-			for(int i = 1; i <= totalRets; i++)
-			{
-				tinyxml2::XMLElement* newVariable = saveFile.NewElement("variable");
+	std::vector<std::uint8_t> Script::writeBinary(int total)
+	{
+		ByteWriter out;
+		out.writeUInt32(SAVE_MAGIC);
+		out.writeByte(SAVE_VERSION);
+		out.writeUInt(total);
 
-				auto type = luaState[i].getType();
+		for(int i = 1; i <= total; i++)
+			LuaSerializer::write(luaState, i, out);
 
-				switch(type)
-				{
-					case LUA_TNUMBER:
-						newVariable->SetAttribute("type", "n");
-						newVariable->SetText(static_cast<float>(luaState[i]));
-						break;
-					case LUA_TBOOLEAN:
-						newVariable->SetAttribute("type", "b");
-						newVariable->SetText(static_cast<bool>(luaState[i]));
-						break;
-					case LUA_TSTRING:
-					{
-						newVariable->SetAttribute("type", "s");
-						std::string temp = luaState[i];
-						newVariable->SetText(temp.c_str());
-						break;
-					}
-					default:
-						newVariable->SetAttribute("type", "0");
-						newVariable->SetText("nil");
-						break;
-				}
+		return out.getData();
+	}
 
-				root->InsertEndChild(newVariable);
-			}
+	std::vector<std::uint8_t> Script::writeXml(int total)
+	{
+		tinyxml2::XMLDocument saveFile;
+		tinyxml2::XMLElement* root = saveFile.NewElement("script");
+		saveFile.InsertEndChild(root);
+
+		for(int i = 1; i <= total; i++)
+		{
+			tinyxml2::XMLElement* newVariable = saveFile.NewElement("variable");
+
+			auto type = luaState[i].getType();
 
-			if(saveFile.SaveFile(sfile.c_str()) != tinyxml2::XML_SUCCESS)
+			switch(type)
 			{
-				log << "[ERROR]: Saving script save file: " << sfile << " failed at saving.\n";
-				return false;
+				case LUA_TNUMBER:
+					newVariable->SetAttribute("type", "n");
+					newVariable->SetText(static_cast<float>(luaState[i]));
+					break;
+				case LUA_TBOOLEAN:
+					newVariable->SetAttribute("type", "b");
+					newVariable->SetText(static_cast<bool>(luaState[i]));
+					break;
+				case LUA_TSTRING:
+				{
+					newVariable->SetAttribute("type", "s");
+					std::string temp = luaState[i];
+					newVariable->SetText(temp.c_str());
+					break;
+				}
+				default:
+					// tables only save in binary
+					newVariable->SetAttribute("type", "0");
+					newVariable->SetText("nil");
+					break;
 			}
 
-			return true;
+			root->InsertEndChild(newVariable);
 		}
-		
-		log << "[INFO]: Script: " << file << " does not have a Save function.\n";
-		
-		return false;
+
+		tinyxml2::XMLPrinter printer;
+		saveFile.Print(&printer);
+
+		const char* text = printer.CStr();
+		return std::vector<std::uint8_t>(text, text + printer.CStrSize() - 1);
 	}
 
 	bool Script::toDelete()
@@ -233,18 +608,11 @@ namespace swift
 
 	void Script::reset()
 	{
+		clearTriggers();
+		releaseGlobals();
 		luaState.reload();
 
-		// We don't want to give the scripts access to os commands or file writing abilities
-		// so we only open the necessary libraries
-		luaState.openLib("base", luaopen_base);
-		luaState.openLib("math", luaopen_math);
-		luaState.openLib("string", luaopen_string);
-		luaState.openLib("table", luaopen_table);
-
-		addVariables();
-		addClasses();
-		addFunctions();
+		setup();
 
 		loadFromFile(file);
 	}
@@ -276,11 +644,13 @@ namespace swift
 
 	void Script::setWorld(World& w)
 	{
+		active = &w;
 		world = &w;
 	}
 
 	void Script::setWorld(std::nullptr_t)
 	{
+		active = nullptr;
 		world = nullptr;
 	}
 
@@ -291,7 +661,209 @@ namespace swift
 
 	const World* Script::getWorld()
 	{
-		return world;
+		return active;
+	}
+
+	Script::Scope::Scope(World& w)
+	:	previousWorld(world),
+		previousDeferred(deferred)
+	{
+		world = &w;
+	}
+
+	Script::Scope::Scope(World& w, Deferred& d)
+	:	previousWorld(world),
+		previousDeferred(deferred)
+	{
+		world = &w;
+		deferred = &d;
+	}
+
+	Script::Scope::~Scope()
+	{
+		world = previousWorld;
+		deferred = previousDeferred;
+	}
+
+	bool Script::canRunInParallel()
+	{
+		return !shareState;
+	}
+
+	bool Script::runOrDefer(std::function<void()> f)
+	{
+		if(deferred)
+		{
+			deferred->push_back(std::move(f));
+			return true;
+		}
+
+		f();
+		return false;
+	}
+
+	void Script::report(const std::string& line, Logger::Level level)
+	{
+		runOrDefer([line, level]
+		{
+			log << level << line;
+		});
+	}
+
+	void Script::setSharedState(bool s)
+	{
+		shareState = s;
+	}
+
+	void Script::setBudget(unsigned instructions)
+	{
+		budget = instructions;
+	}
+
+	void Script::setBytecodeCache(const std::string& directory)
+	{
+		bytecode.setDirectory(directory);
+	}
+
+	const BytecodeCache& Script::getBytecodeCache()
+	{
+		return bytecode;
+	}
+
+	const std::map<std::string, unsigned>& Script::getOverBudget()
+	{
+		return overBudget;
+	}
+
+	lpp::State* Script::sharedHost()
+	{
+		if(!shareState)
+			return nullptr;
+
+		// libraries and bindings every script sees, made once
+		if(!host)
+		{
+			host.reset(new lpp::State());
+			openLibs(*host);
+			addFunctions(*host);
+			
+			// collected in steps with time to spare, see collectGarbage
+			lua_gc(*host, LUA_GCSTOP, 0);
+
+			// for scripts to pass data between each other. Globals they set are their own
+			(*host)("shared = {}");
+		}
+
+		return host.get();
+	}
+
+	void Script::openLibs(lpp::State& state)
+	{
+		// We don't want to give the scripts access to os commands or file writing abilities
+		// so we only open the necessary libraries
+		state.openLib("base", luaopen_base);
+		state.openLib("math", luaopen_math);
+		state.openLib("string", luaopen_string);
+		state.openLib("table", luaopen_table);
+
+#ifndef LPP_LUAJIT
+		// for Update to pause itself. LuaJIT's base library has it
+		state.openLib("coroutine", luaopen_coroutine);
+#endif
+
+#ifdef LPP_LUAJIT
+		// for hot component data. The ffi can reach any memory and C function, so it's only for trusted scripts
+		state.openLib("ffi", luaopen_ffi);
+
+		if(state("ffi.cdef[[" + getFfiTypes() + "]]") != LUA_OK)
+			SWIFT_ERROR(Scripting, "ffi types: " << state.getErrors() << '\n');
+#endif
+	}
+
+#ifdef LPP_LUAJIT
+	std::string Script::getFfiTypes()
+	{
+		struct Field
+		{
+			std::size_t offset;
+			std::size_t size;
+			std::string declaration;
+		};
+
+		// fields in order, padding between them, from where they are in an instance
+		auto layout = [](const std::string& name, std::size_t size, std::vector<Field> fields)
+		{
+			std::sort(fields.begin(), fields.end(), [](const Field& one, const Field& two)
+			{
+				return one.offset < two.offset;
+			});
+
+			std::string def = "typedef struct { ";
+			std::size_t at = 0;
+			unsigned pads = 0;
+
+			for(auto& f : fields)
+			{
+				if(f.offset > at)
+					def += "char pad" + std::to_string(pads++) + "[" + std::to_string(f.offset - at) + "]; ";
+
+				def += f.declaration + "; ";
+				at = f.offset + f.size;
+			}
+
+			if(size > at)
+				def += "char pad" + std::to_string(pads) + "[" + std::to_string(size - at) + "]; ";
+
+			return def + "} " + name + ";\n";
+		};
+
+		auto offset = [](const void* object, const void* member)
+		{
+			return static_cast<std::size_t>(static_cast<const char*>(member) - static_cast<const char*>(object));
+		};
+
+		Physical phys;
+		Movable mov;
+
+		std::string types = "typedef struct { float x, y; } swift_Vector2f;\n"
+							"typedef struct { unsigned int x, y; } swift_Vector2u;\n";
+
+		types += layout("swift_Physical", sizeof(Physical),
+		{
+			{offset(&phys, &phys.position), sizeof(phys.position), "swift_Vector2f position"},
+			{offset(&phys, &phys.zIndex), sizeof(phys.zIndex), "unsigned int zIndex"},
+			{offset(&phys, &phys.size), sizeof(phys.size), "swift_Vector2u size"},
+			{offset(&phys, &phys.collides), sizeof(phys.collides), "bool collides"},
+			{offset(&phys, &phys.angle), sizeof(phys.angle), "float angle"},
+			{offset(&phys, &phys.category), sizeof(phys.category), "unsigned int category"},
+			{offset(&phys, &phys.mask), sizeof(phys.mask), "unsigned int mask"},
+		});
+
+		types += layout("swift_Movable", sizeof(Movable),
+		{
+			{offset(&mov, &mov.moveVelocity), sizeof(mov.moveVelocity), "float moveVelocity"},
+			{offset(&mov, &mov.velocity), sizeof(mov.velocity), "swift_Vector2f velocity"},
+		});
+
+		return types;
+	}
+#endif
+
+	void Script::setup()
+	{
+		// a shared state has its host's
+		if(!luaState.isShared())
+		{
+			openLibs(luaState);
+			addFunctions(luaState);
+			
+			// collected in steps with time to spare instead of as it allocates, see collectGarbage
+			lua_gc(luaState, LUA_GCSTOP, 0);
+		}
+
+		addVariables();
+		addClasses();
+		addInstanceFunctions();
 	}
 
 	void Script::addVariables()
@@ -302,69 +874,417 @@ namespace swift
 	{
 	}
 
-	void Script::addFunctions()
+	void Script::addFunctions(lpp::State& state)
 	{
 		// utility functions
-		luaState["getWindowSize"] = &getWindowSize;
-		luaState["getTime"] = &getTime;
-		luaState["doKeypress"] = &doKeypress;
-		luaState["log"] = &logMsg;
+		state["getWindowSize"] = &getWindowSize;
+		state["getTime"] = &getTime;
+		state["doKeypress"] = &doKeypress;
+		state["log"] = &logMsg;
 
 		// play
-		luaState["addScript"] = &addScript;
-		luaState["removeScript"] = &removeScript;
+		state["addScript"] = &addScript;
+		state["removeScript"] = &removeScript;
 
 		// world
-		luaState["newEntity"] = &newEntity;
-		luaState["removeEntity"] = &removeEntity;
-		luaState["getEntities"] = &getEntities;
-		luaState["getEntity"] = &getEntity;
-		luaState["getPlayer"] = &getPlayer;
-		luaState["isAround"] = &isAround;
-		luaState["getCurrentWorld"] = &getCurrentWorld;
-		luaState["setCurrentWorld"] = &setCurrentWorld;
+		state["newEntity"] = &newEntity;
+		state["removeEntity"] = &removeEntity;
+		state["getEntities"] = &getEntities;
+		state["getEntity"] = &getEntity;
+		state["getPlayer"] = &getPlayer;
+		state["isAround"] = &isAround;
+		state["getEntitiesAround"] = &getEntitiesAround;
+		state["getNearestEntities"] = &getNearestEntities;
+		state["queryRadius"] = &queryRadius;
+		state["getEntitiesWith"] = &getEntitiesWith;
+		state["findByName"] = &findByName;
+		state["spawn"] = &spawn;
+		state["getCurrentWorld"] = &getCurrentWorld;
+		state["setCurrentWorld"] = &setCurrentWorld;
 		
 		// tilemap
-		luaState["getTileSize"] = &getTileSize;
+		state["getTileSize"] = &getTileSize;
+		state["raycast"] = &raycast;
+		state["hasLineOfSight"] = &hasLineOfSight;
+		state["isVisible"] = &isVisible;
+		state["isExplored"] = &isExplored;
+		state["showFog"] = &showFog;
+		state["hideFog"] = &hideFog;
+		
+		// particles
+		state["defineEmitter"] = &defineEmitter;
+		state["setEmitter"] = &setEmitter;
+		state["setEmitterColors"] = &setEmitterColors;
+		state["emit"] = &emit;
+		state["attachEmitter"] = &attachEmitter;
+		state["moveEmitter"] = &moveEmitter;
+		state["burstEmitter"] = &burstEmitter;
+		state["stopEmitter"] = &stopEmitter;
 
 		// Entity System
-		luaState["add"] = &add;
-		luaState["remove"] = &remove;
-		luaState["has"] = &has;
+		state["add"] = &add;
+		state["remove"] = &remove;
+		state["has"] = &has;
+		state["wake"] = &wake;
+
+		// components are userdata with their fields, getPhysical(e).x. They're set with the functions below too
+		ComponentFields::open(state);
+		
+		// with their CallStats id as their upvalue
+		auto getter = [&state](const char* name, lua_CFunction function)
+		{
+			lua_State* s = state;
+			lua_pushinteger(s, lpp::CallStats::getId(name));
+			lua_pushcclosure(s, function, 1);
+			lua_setglobal(s, name);
+		};
+		
+		getter("getAnimated", &getComponent<Animated>);
+		getter("getControllable", &getComponent<Controllable>);
+		getter("getDrawable", &getComponent<Drawable>);
+		getter("getLuminous", &getComponent<Luminous>);
+		getter("getMovable", &getComponent<Movable>);
+		getter("getName", &getComponent<Name>);
+		getter("getNoisy", &getComponent<Noisy>);
+		getter("getPathfinder", &getComponent<Pathfinder>);
+		getter("getPhysical", &getComponent<Physical>);
+		getter("getSighted", &getComponent<Sighted>);
 
 		// Drawable
-		luaState["getDrawable"] = &getDrawable;
-		luaState["setTexture"] = &setTexture;
-		luaState["setTextureRect"] = &setTextureRect;
-		luaState["getSpriteSize"] = &getSpriteSize;
-		luaState["setScale"] = &setScale;
+		state["setTexture"] = &setTexture;
+		state["setTextureRect"] = &setTextureRect;
+		state["getSpriteSize"] = &getSpriteSize;
+		state["setScale"] = &setScale;
 
 		// Movable
-		luaState["getMovable"] = &getMovable;
-		luaState["setMoveVelocity"] = &setMoveVelocity;
-		luaState["getVelocity"] = &getVelocity;
+		state["setMoveVelocity"] = &setMoveVelocity;
+		state["getVelocity"] = &getVelocity;
 
 		// Physical
-		luaState["getPhysical"] = &getPhysical;
-		luaState["setPosition"] = &setPosition;
-		luaState["getPosition"] = &getPosition;
-		luaState["setSize"] = &setSize;
-		luaState["getSize"] = &getSize;
+		state["setPosition"] = &setPosition;
+		state["getPosition"] = &getPosition;
+		state["getPositions"] = &getPositions;
+		state["setSize"] = &setSize;
+		state["getSize"] = &getSize;
 
 		// Name
-		luaState["getName"] = &getName;
-		luaState["setName"] = &setName;
-		luaState["getNameVal"] = &getNameVal;
+		state["setName"] = &setName;
+		state["getNameVal"] = &getNameVal;
+
+		// Luminous
+		state["setLightRadius"] = &setLightRadius;
+		state["setLightColor"] = &setLightColor;
 
 		// Noisy
-		luaState["getNoisy"] = &getNoisy;
-		luaState["setSound"] = &setSound;
-		luaState["getSound"] = &getSound;
+		state["setSound"] = &setSound;
+		state["getSound"] = &getSound;
 
 		// Settings
-		luaState["getSettingStr"] = &getSettingStr;
-		luaState["getSettingBool"] = &getSettingBool;
-		luaState["getSettingNum"] = &getSettingNum;
+		state["getSettingStr"] = &getSettingStr;
+		state["getSettingBool"] = &getSettingBool;
+		state["getSettingNum"] = &getSettingNum;
+	}
+
+	void Script::addInstanceFunctions()
+	{
+		// collision events for this script
+		luaState["subscribeCollisions"] = std::function<bool(EntityHandle)>([this](EntityHandle e)
+		{
+			return world ? world->subscribeContacts(e, *this) : false;
+		});
+		
+		luaState["unsubscribeCollisions"] = std::function<bool(EntityHandle)>([this](EntityHandle e)
+		{
+			return world ? world->unsubscribeContacts(e, *this) : false;
+		});
+		
+		// the bindings can't take Lua functions, these are lua_CFunctions with the script as their upvalue.
+		// Arguments are checked before anything is made, an error doesn't unwind C++ objects
+		auto bind = [this](const char* name, lua_CFunction function)
+		{
+			lua_State* state = luaState;
+			lua_pushlightuserdata(state, this);
+			lua_pushcclosure(state, function, 1);
+			lua_setglobal(state, name);
+		};
+		
+		// math.random's arguments, drawn from the script's own stream instead of the C library's shared one
+		bind("random", [](lua_State* state) -> int
+		{
+			Random::Generator& rng = getBound(state)->rng;
+			int args = lua_gettop(state);
+			
+			if(args == 0)
+			{
+				lua_pushnumber(state, rng.uniform());
+				return 1;
+			}
+			
+			lua_Integer lo = args >= 2 ? luaL_checkinteger(state, 1) : 1;
+			lua_Integer hi = luaL_checkinteger(state, args >= 2 ? 2 : 1);
+			
+			if(lo > hi)
+				return luaL_error(state, "random's interval is empty");
+			
+			lua_pushinteger(state, lo + static_cast<lua_Integer>(rng.below(static_cast<std::uint32_t>(hi - lo + 1))));
+			return 1;
+		});
+		
+		bind("onTimer", [](lua_State* state) -> int
+		{
+			float seconds = static_cast<float>(luaL_checknumber(state, 1));
+			luaL_checktype(state, 2, LUA_TFUNCTION);
+			bool repeats = lua_toboolean(state, 3);
+			
+			unsigned ticks = std::max(static_cast<unsigned>(std::ceil(seconds / tickLength)), 1u);
+			
+			Trigger trigger{};
+			trigger.type = Trigger::Type::Timer;
+			trigger.ticks = repeats ? ticks : 0;
+			
+			trigger.function = takeFunction(state, 2);
+			
+			Script* script = getBound(state);
+			unsigned id = script->addTrigger(std::move(trigger));
+			
+			// the wheel is shared, scripts on other threads add to it once they're done
+			runOrDefer([ticks, script, id]
+			{
+				timers.add(ticks, script, id);
+			});
+			
+			lua_pushunsigned(state, id);
+			return 1;
+		});
+		
+		bind("onCollision", [](lua_State* state) -> int
+		{
+			EntityHandle entity = detail::checkGet(detail::id<EntityHandle>{}, state, 1);
+			luaL_checktype(state, 2, LUA_TFUNCTION);
+			
+			Script* script = getBound(state);
+			
+			if(!world || !world->getEntity(entity))
+			{
+				lua_pushnil(state);
+				return 1;
+			}
+			
+			// may already be subscribed, by subscribeCollisions or another callback
+			world->subscribeContacts(entity, *script);
+			
+			Trigger trigger{};
+			trigger.type = Trigger::Type::Collision;
+			trigger.entity = entity;
+			
+			trigger.function = takeFunction(state, 2);
+			
+			lua_pushunsigned(state, script->addTrigger(std::move(trigger)));
+			return 1;
+		});
+		
+		bind("onKey", [](lua_State* state) -> int
+		{
+			luaL_checkstring(state, 1);
+			luaL_checktype(state, 2, LUA_TFUNCTION);
+			
+			Trigger trigger{};
+			trigger.type = Trigger::Type::Key;
+			trigger.binding = lua_tostring(state, 1);
+			
+			trigger.function = takeFunction(state, 2);
+			
+			lua_pushunsigned(state, getBound(state)->addTrigger(std::move(trigger)));
+			return 1;
+		});
+		
+		bind("onEnterRadius", [](lua_State* state) -> int
+		{
+			float x = static_cast<float>(luaL_checknumber(state, 1));
+			float y = static_cast<float>(luaL_checknumber(state, 2));
+			float r = static_cast<float>(luaL_checknumber(state, 3));
+			luaL_checkstring(state, 4);
+			luaL_checktype(state, 5, LUA_TFUNCTION);
+			
+			std::string component = lua_tostring(state, 4);
+			
+			Trigger trigger{};
+			trigger.type = Trigger::Type::Radius;
+			trigger.center = {x, y};
+			trigger.radius = r;
+			trigger.component = component.empty() ? MAX_COMPONENTS : ComponentRegistry::getID(component);
+			
+			// an unknown component would match nothing, ever
+			if(!component.empty() && trigger.component == MAX_COMPONENTS)
+			{
+				lua_pushnil(state);
+				return 1;
+			}
+			
+			trigger.function = takeFunction(state, 5);
+			
+			lua_pushunsigned(state, getBound(state)->addTrigger(std::move(trigger)));
+			return 1;
+		});
+		
+		luaState["cancel"] = std::function<bool(unsigned)>([this](unsigned id)
+		{
+			return cancelTrigger(id);
+		});
+	}
+
+	unsigned Script::addTrigger(Trigger&& trigger)
+	{
+		unsigned id = nextTrigger++;
+		Trigger::Type type = trigger.type;
+		
+		triggers.emplace(id, std::move(trigger));
+		
+		bool listens = type == Trigger::Type::Key || type == Trigger::Type::Radius;
+		
+		if(listens)
+		{
+			runOrDefer([this]
+			{
+				if(std::find(listeners.begin(), listeners.end(), this) == listeners.end())
+					listeners.push_back(this);
+			});
+		}
+		
+		return id;
+	}
+	
+	bool Script::cancelTrigger(unsigned id)
+	{
+		auto it = triggers.find(id);
+		
+		if(it == triggers.end())
+			return false;
+		
+		// timers stay in the wheel, and are skipped once they're due
+		Trigger::Type type = it->second.type;
+		EntityHandle entity = it->second.entity;
+		
+		triggers.erase(it);
+		
+		// the last callback for an entity stops its contacts, as unsubscribeCollisions would
+		auto same = [entity](const Trigger& t) { return t.entity == entity; };
+		
+		if(type == Trigger::Type::Collision && world && findTriggers(Trigger::Type::Collision, same).empty())
+			world->unsubscribeContacts(entity, *this);
+		
+		return true;
+	}
+	
+	void Script::clearTriggers()
+	{
+		// the world may already be gone, its contacts aren't unsubscribed. Without triggers, they only reach OnCollision
+		triggers.clear();
+		timers.remove(this);
+		listeners.erase(std::remove(listeners.begin(), listeners.end(), this), listeners.end());
+	}
+	
+	void Script::fireTimer(unsigned id)
+	{
+		auto it = triggers.find(id);
+		
+		// cancelled
+		if(it == triggers.end() || it->second.type != Trigger::Type::Timer)
+			return;
+		
+		lpp::CallStats::Scope counting(stats.calls);
+		
+		checkCall(it->second.function.call(), "onTimer");
+		
+		// the callback may have cancelled it
+		it = triggers.find(id);
+		
+		if(it == triggers.end())
+			return;
+		
+		if(it->second.ticks)
+			timers.add(it->second.ticks, this, id);
+		else
+			triggers.erase(it);
+	}
+	
+	void Script::checkRadii()
+	{
+		thread_local std::vector<Entity*> found;
+		std::vector<std::uint32_t> now;
+		FrameArena::Scope scope;
+		FrameVector<std::uint32_t> entered;
+		
+		lpp::CallStats::Scope counting(stats.calls);
+		
+		for(auto& id : findTriggers(Trigger::Type::Radius, [](const Trigger&) { return true; }))
+		{
+			auto it = triggers.find(id);
+			
+			if(it == triggers.end())
+				continue;
+			
+			Trigger& trigger = it->second;
+			world->queryRadius(trigger.center, trigger.radius, found);
+			
+			now.clear();
+			
+			for(auto& e : found)
+			{
+				if(trigger.component == MAX_COMPONENTS || e->getMask().test(trigger.component))
+					now.push_back(e->getHandle().value);
+			}
+			
+			std::sort(now.begin(), now.end());
+			
+			entered.clear();
+			std::set_difference(now.begin(), now.end(), trigger.inside.begin(), trigger.inside.end(), std::back_inserter(entered));
+			trigger.inside.swap(now);
+			
+			for(auto& value : entered)
+			{
+				// a callback may cancel it
+				it = triggers.find(id);
+				
+				if(it == triggers.end())
+					break;
+				
+				EntityHandle handle;
+				handle.value = value;
+				
+				checkCall(it->second.function.call(handle), "onEnterRadius");
+			}
+		}
+	}
+	
+	template<typename F>
+	std::vector<unsigned> Script::findTriggers(Trigger::Type type, F matching) const
+	{
+		std::vector<unsigned> ids;
+		
+		for(auto& t : triggers)
+		{
+			if(t.second.type == type && matching(t.second))
+				ids.push_back(t.first);
+		}
+		
+		return ids;
+	}
+	
+	Script* Script::getBound(lua_State* state)
+	{
+		return static_cast<Script*>(lua_touserdata(state, lua_upvalueindex(1)));
+	}
+	
+	lpp::Reference Script::takeFunction(lua_State* state, int idx)
+	{
+		// kept with the script's own lua_State. state may be Update's coroutine, which doesn't last
+		lua_State* own = getBound(state)->luaState;
+		
+		lua_pushvalue(state, idx);
+		lua_xmove(state, own, 1);
+		
+		return lpp::Reference(own);
 	}
 
 	/* Lua converted functions */
@@ -387,18 +1307,28 @@ namespace swift
 
 	void Script::doKeypress(std::string k)
 	{
-		if(keyboard)
-			keyboard->call(k);
+		runOrDefer([k]
+		{
+			if(keyboard)
+				keyboard->call(k);
+		});
 	}
 
 	void Script::logMsg(std::string m)
 	{
-		log << m << '\n';
+		report(m + '\n');
 	}
 
 	// Play
 	bool Script::addScript(std::string s)
 	{
+		// deferred ones are taken to have worked
+		if(deferred)
+		{
+			runOrDefer([s] { if(play) play->addScript(s); });
+			return true;
+		}
+		
 		if(play)
 			return play->addScript(s);
 		else
@@ -407,61 +1337,218 @@ namespace swift
 
 	bool Script::removeScript(std::string s)
 	{
+		if(deferred)
+		{
+			runOrDefer([s] { if(play) play->removeScript(s); });
+			return true;
+		}
+		
 		if(play)
 			return play->removeScript(s);
 		else
 			return false;
 	}
 
-	// World
-	Entity* Script::newEntity()
+	Entity* Script::resolve(EntityHandle e)
 	{
 		if(world)
-			return world->addEntity();
+			return world->getEntity(e);
 		else
 			return nullptr;
 	}
 
-	bool Script::removeEntity(int e)
+	template<typename C>
+	int Script::getComponent(lua_State* state)
+	{
+		lpp::CallStats::count(static_cast<unsigned>(lua_tointeger(state, lua_upvalueindex(1))));
+		
+		Entity* e = resolve(detail::checkGet(detail::id<EntityHandle>{}, state, 1));
+		ComponentFields::push(state, e && e->has<C>() ? e->get<C>() : nullptr);
+		return 1;
+	}
+
+	// World
+	EntityHandle Script::newEntity()
 	{
 		if(world)
-			return world->removeEntity(e);
+			return world->addEntity()->getHandle();
 		else
-			return false;
+			return {};
 	}
 
-	std::vector<Entity*> Script::getEntities()
+	// positions are x, y pairs: spawn("./data/prefabs/crate.prefab", 2, {0, 0, 32, 0})
+	std::vector<EntityHandle> Script::spawn(std::string prefab, unsigned count, std::vector<float> positions)
+	{
+		std::vector<EntityHandle> handles;
+		
+		Prefab* p = assets ? assets->getPrefab(prefab) : nullptr;
+		
+		if(world && p)
+		{
+			thread_local std::vector<sf::Vector2f> points;
+			thread_local std::vector<Entity*> spawned;
+			
+			points.clear();
+			
+			for(std::size_t i = 0; i + 1 < positions.size(); i += 2)
+				points.emplace_back(positions[i], positions[i + 1]);
+			
+			world->spawn(*p, count, points, spawned);
+			
+			handles.reserve(spawned.size());
+			
+			for(auto& e : spawned)
+				handles.push_back(e->getHandle());
+		}
+		
+		return handles;
+	}
+	
+	bool Script::removeEntity(EntityHandle e)
 	{
 		if(world)
-			return world->getEntities();
+			return world->removeEntity(e);
 		else
-			return std::vector<Entity*> {};
+			return false;
 	}
 
-	Entity* Script::getEntity(int e)
+	std::vector<EntityHandle> Script::getEntities()
 	{
+		std::vector<EntityHandle> handles;
+		
 		if(world)
-			return world->getEntity(e);
+		{
+			handles.reserve(world->getEntities().size());
+			
+			for(auto& e : world->getEntities())
+				handles.push_back(e->getHandle());
+		}
+		
+		return handles;
+	}
+
+	EntityHandle Script::getEntity(int e)
+	{
+		Entity* entity = world ? world->getEntity(e) : nullptr;
+		
+		if(entity)
+			return entity->getHandle();
 		else
-			return nullptr;
+			return {};
 	}
 
-	Entity* Script::getPlayer()
+	EntityHandle Script::getPlayer()
 	{
-		if(play)
-			return play->getPlayer();
+		if(play && play->getPlayer())
+			return play->getPlayer()->getHandle();
 		else
-			return nullptr;
+			return {};
 	}
 
 	bool Script::isAround(Physical* p, float x, float y, float r)
 	{
 		if(p)
-			return math::distance(p->position, {x, y}) <= r;
+			return math::distanceSquared(p->position, {x, y}) <= r * r;
 		else
 			return false;
 	}
 
+	std::vector<EntityHandle> Script::getEntitiesAround(float x, float y, float r)
+	{
+		std::vector<EntityHandle> handles;
+		
+		// one for each thread scripts run on
+		thread_local std::vector<Entity*> around;
+		
+		if(world && 0 <= x && 0 <= y)
+		{
+			world->queryRadius({x, y}, r, around);
+			
+			for(auto& e : around)
+				handles.push_back(e->getHandle());
+		}
+		
+		return handles;
+	}
+
+	std::vector<EntityHandle> Script::getNearestEntities(float x, float y, unsigned k, float r)
+	{
+		std::vector<EntityHandle> handles;
+		
+		thread_local std::vector<Entity*> nearest;
+		
+		if(world)
+		{
+			world->queryNearest({x, y}, k, r, nearest);
+			
+			for(auto& e : nearest)
+				handles.push_back(e->getHandle());
+		}
+		
+		return handles;
+	}
+
+	std::vector<EntityHandle> Script::queryRadius(float x, float y, float r, std::string c)
+	{
+		std::vector<EntityHandle> handles;
+		
+		thread_local std::vector<Entity*> around;
+		
+		unsigned type = c.empty() ? 0 : ComponentRegistry::getID(c);
+		
+		if(world && type < MAX_COMPONENTS)
+		{
+			world->queryRadius({x, y}, r, around);
+			handles.reserve(around.size());
+			
+			for(auto& e : around)
+			{
+				if(c.empty() || e->getMask().test(type))
+					handles.push_back(e->getHandle());
+			}
+		}
+		
+		return handles;
+	}
+	
+	std::vector<EntityHandle> Script::getEntitiesWith(std::string c)
+	{
+		std::vector<EntityHandle> handles;
+		
+		if(c.empty())
+			return getEntities();
+		
+		unsigned type = ComponentRegistry::getID(c);
+		
+		if(world && type < MAX_COMPONENTS)
+		{
+			// the storage keeps a view per signature up to date, so there's nothing to filter
+			ComponentMask mask;
+			mask.set(type);
+			
+			const std::vector<Entity*>& with = world->getStorage().getView(mask).getEntities();
+			handles.reserve(with.size());
+			
+			for(auto& e : with)
+				handles.push_back(e->getHandle());
+		}
+		
+		return handles;
+	}
+
+	std::vector<EntityHandle> Script::findByName(std::string n)
+	{
+		std::vector<EntityHandle> handles;
+		
+		if(world)
+		{
+			for(auto& e : world->findByName(n))
+				handles.push_back(e->getHandle());
+		}
+		
+		return handles;
+	}
+
 	std::string Script::getCurrentWorld()
 	{
 		if(world)
@@ -475,6 +1562,13 @@ namespace swift
 	
 	bool Script::setCurrentWorld(std::string s, std::string mf)
 	{
+		// waits for the scripts on other threads, which may be in a world it would suspend
+		if(deferred)
+		{
+			runOrDefer([s, mf] { if(play) play->changeWorld(s, mf); });
+			return true;
+		}
+		
 		if(play)
 		{
 			play->changeWorld(s, mf);
@@ -495,46 +1589,249 @@ namespace swift
 		else
 			return std::make_tuple(0, 0);
 	}
+	
+	std::tuple<std::vector<bool>, std::vector<float>, std::vector<EntityHandle>> Script::raycast(std::vector<float> rays, unsigned layer, std::vector<EntityHandle> casters)
+	{
+		std::vector<bool> hit;
+		std::vector<float> points;
+		std::vector<EntityHandle> entities;
+		
+		thread_local std::vector<World::Ray> batch;
+		thread_local std::vector<World::RayHit> hits;
+		
+		if(world)
+		{
+			batch.clear();
+			
+			for(std::size_t i = 0; i + 3 < rays.size(); i += 4)
+			{
+				std::size_t r = i / 4;
+				batch.push_back({{rays[i], rays[i + 1]}, {rays[i + 2], rays[i + 3]}, r < casters.size() ? resolve(casters[r]) : nullptr});
+			}
+			
+			world->raycast(batch, layer, hits);
+			
+			hit.reserve(hits.size());
+			points.reserve(hits.size() * 2);
+			entities.reserve(hits.size());
+			
+			for(auto& h : hits)
+			{
+				hit.push_back(h.hit);
+				points.push_back(h.point.x);
+				points.push_back(h.point.y);
+				entities.push_back(h.entity ? h.entity->getHandle() : EntityHandle());
+			}
+		}
+		
+		return std::make_tuple(hit, points, entities);
+	}
+	
+	std::vector<bool> Script::hasLineOfSight(std::vector<float> segments, unsigned layer)
+	{
+		std::vector<bool> clear;
+		
+		thread_local std::vector<World::Ray> batch;
+		thread_local std::vector<unsigned char> visible;
+		
+		if(world)
+		{
+			batch.clear();
+			
+			for(std::size_t i = 0; i + 3 < segments.size(); i += 4)
+				batch.push_back({{segments[i], segments[i + 1]}, {segments[i + 2], segments[i + 3]}, nullptr});
+			
+			world->hasLineOfSight(batch, layer, visible);
+			clear.assign(visible.begin(), visible.end());
+		}
+		
+		return clear;
+	}
+	
+	bool Script::isVisible(unsigned faction, float x, float y)
+	{
+		return world && world->isVisible(faction, {x, y});
+	}
+	
+	bool Script::isExplored(unsigned faction, float x, float y)
+	{
+		return world && world->isExplored(faction, {x, y});
+	}
+	
+	void Script::showFog(unsigned faction)
+	{
+		if(world)
+			world->showFog(faction);
+	}
+	
+	void Script::hideFog()
+	{
+		if(world)
+			world->hideFog();
+	}
+	
+	bool Script::defineEmitter(std::string name, std::string texture)
+	{
+		if(!world)
+			return false;
+		
+		ParticleEmitter settings;
+		AssetHandle<sf::Texture> handle;
+		
+		if(!texture.empty())
+		{
+			handle = assets->acquireSprite(texture, settings.region);
+			
+			if(!handle)
+				return false;
+			
+			settings.texture = handle.get();
+			world->getParticles().define(name, settings, handle);
+			handle.reset();
+		}
+		else
+			world->getParticles().define(name, settings);
+		
+		return true;
+	}
+	
+	bool Script::setEmitter(std::string name, std::string field, float value)
+	{
+		ParticleEmitter* settings = world ? world->getParticles().getDefinition(name) : nullptr;
+		
+		if(!settings)
+			return false;
+		
+		static const std::map<std::string, float ParticleEmitter::*> floats =
+		{
+			{"rate", &ParticleEmitter::rate},
+			{"duration", &ParticleEmitter::duration},
+			{"lifeMin", &ParticleEmitter::lifeMin},
+			{"lifeMax", &ParticleEmitter::lifeMax},
+			{"speedMin", &ParticleEmitter::speedMin},
+			{"speedMax", &ParticleEmitter::speedMax},
+			{"direction", &ParticleEmitter::direction},
+			{"spread", &ParticleEmitter::spread},
+			{"drag", &ParticleEmitter::drag},
+			{"sizeStart", &ParticleEmitter::sizeStart},
+			{"sizeEnd", &ParticleEmitter::sizeEnd},
+		};
+		
+		auto it = floats.find(field);
+		
+		if(it != floats.end())
+			settings->*(it->second) = value;
+		else if(field == "burst")
+			settings->burst = static_cast<unsigned>(std::max(value, 0.f));
+		else if(field == "max")
+			settings->max = static_cast<std::size_t>(std::max(value, 0.f));
+		else if(field == "accelerationX")
+			settings->acceleration.x = value;
+		else if(field == "accelerationY")
+			settings->acceleration.y = value;
+		else if(field == "offsetX")
+			settings->offset.x = value;
+		else if(field == "offsetY")
+			settings->offset.y = value;
+		else
+			return false;
+		
+		return true;
+	}
+	
+	bool Script::setEmitterColors(std::string name, unsigned r0, unsigned g0, unsigned b0, unsigned a0, unsigned r1, unsigned g1, unsigned b1, unsigned a1)
+	{
+		ParticleEmitter* settings = world ? world->getParticles().getDefinition(name) : nullptr;
+		
+		if(!settings)
+			return false;
+		
+		settings->colorStart = sf::Color(r0, g0, b0, a0);
+		settings->colorEnd = sf::Color(r1, g1, b1, a1);
+		return true;
+	}
+	
+	unsigned Script::emit(std::string name, float x, float y)
+	{
+		return world ? world->getParticles().emit(name, {x, y}) : 0;
+	}
+	
+	unsigned Script::attachEmitter(std::string name, EntityHandle e)
+	{
+		return world ? world->getParticles().attach(name, e) : 0;
+	}
+	
+	void Script::moveEmitter(unsigned id, float x, float y)
+	{
+		if(world)
+			world->getParticles().setPosition(id, {x, y});
+	}
+	
+	void Script::burstEmitter(unsigned id, unsigned count)
+	{
+		if(world)
+			world->getParticles().burst(id, count);
+	}
+	
+	void Script::stopEmitter(unsigned id)
+	{
+		if(world)
+			world->getParticles().stop(id);
+	}
 
 	// Entity System
-	bool Script::add(Entity* e, std::string c)
+	bool Script::add(EntityHandle handle, std::string c)
 	{
-		if(e)
-			return e->add(c);
-		else
+		Entity* e = resolve(handle);
+		
+		if(!e || !e->add(c))
 			return false;
+		
+		// at its default position, where queries find it from now on
+		if(world && e->get<Physical>())
+			world->refit(*e);
+		
+		return true;
 	}
 
-	bool Script::remove(Entity* e, std::string c)
+	bool Script::remove(EntityHandle handle, std::string c)
 	{
+		Entity* e = resolve(handle);
+		
 		if(e)
 			return e->remove(c);
 		else
 			return false;
 	}
 
-	bool Script::has(Entity* e, std::string c)
+	bool Script::has(EntityHandle handle, std::string c)
 	{
+		Entity* e = resolve(handle);
+		
 		if(e)
 			return e->has(c);
 		else
 			return false;
 	}
-
-	// Drawable
-	Drawable* Script::getDrawable(Entity* e)
+	
+	void Script::wake(EntityHandle handle, unsigned ticks)
 	{
-		if(e && e->has<Drawable>())
-			return e->get<Drawable>();
-		else
-			return nullptr;
+		if(world)
+			world->wake(handle, ticks);
 	}
 
+	// Drawable
 	bool Script::setTexture(Drawable* d, std::string t)
 	{
 		if(d)
 		{
-			d->sprite.setTexture(*assets->getTexture(t));
+			sf::IntRect region;
+			AssetHandle<sf::Texture> texture = assets->acquireSprite(t, region);
+			
+			if(!texture)
+				return false;
+			
+			d->setTexture(texture, region);
 			d->texture = t;
 			return true;
 		}
@@ -545,7 +1842,7 @@ namespace swift
 	void Script::setTextureRect(Drawable* d, int x, int y, int w, int h)
 	{
 		if(d)
-			d->sprite.setTextureRect( {x, y, w, h});
+			d->setTextureRect({x, y, w, h});
 	}
 
 	std::tuple<float, float> Script::getSpriteSize(Drawable* d)
@@ -563,14 +1860,6 @@ namespace swift
 	}
 
 	// Movable
-	Movable* Script::getMovable(Entity* e)
-	{
-		if(e && e->has<Movable>())
-			return e->get<Movable>();
-		else
-			return nullptr;
-	}
-
 	void Script::setMoveVelocity(Movable* m, float v)
 	{
 		if(m)
@@ -586,18 +1875,16 @@ namespace swift
 	}
 
 	// Physical
-	Physical* Script::getPhysical(Entity* e)
-	{
-		if(e && e->has<Physical>())
-			return e->get<Physical>();
-		else
-			return nullptr;
-	}
-
 	void Script::setPosition(Physical* p, float x, float y)
 	{
 		if(p)
+		{
 			p->position = {x, y};
+			
+			// scripts teleport entities, queries find them where they are before physics updates again
+			if(world)
+				world->refit(*p);
+		}
 	}
 
 	std::tuple<float, float> Script::getPosition(Physical* p)
@@ -608,10 +1895,40 @@ namespace swift
 			return std::make_tuple(0.f, 0.f);
 	}
 
+	std::vector<float> Script::getPositions(std::vector<EntityHandle> list)
+	{
+		std::vector<float> positions;
+		positions.reserve(list.size() * 2);
+		
+		for(auto& h : list)
+		{
+			Entity* e = resolve(h);
+			const Physical* p = e ? e->get<Physical>() : nullptr;
+			
+			if(p)
+			{
+				positions.push_back(p->position.x);
+				positions.push_back(p->position.y);
+			}
+			else
+			{
+				positions.push_back(0);
+				positions.push_back(0);
+			}
+		}
+		
+		return positions;
+	}
+
 	void Script::setSize(Physical* p, unsigned x, unsigned y)
 	{
 		if(p)
+		{
 			p->size = {x, y};
+			
+			if(world)
+				world->refit(*p);
+		}
 	}
 
 	std::tuple<unsigned, unsigned> Script::getSize(Physical* p)
@@ -623,37 +1940,34 @@ namespace swift
 	}
 
 	// Name
-	Name* Script::getName(Entity* e)
-	{
-		if(e && e->has<Name>())
-			return e->get<Name>();
-		else
-			return nullptr;
-	}
-
 	void Script::setName(Name* n, std::string name)
 	{
 		if(n)
-			n->name = name;
+			n->setName(name);
 	}
 
 	std::string Script::getNameVal(Name* n)
 	{
 		if(n)
-			return n->name;
+			return n->getName();
 		else
 			return "null";
 	}
 
-	// Noisy
-	Noisy* Script::getNoisy(Entity* e)
+	// Luminous
+	void Script::setLightRadius(Luminous* l, float r)
 	{
-		if(e && e->has<Noisy>())
-			return e->get<Noisy>();
-		else
-			return nullptr;
+		if(l)
+			l->radius = r;
 	}
 
+	void Script::setLightColor(Luminous* l, unsigned r, unsigned g, unsigned b, unsigned a)
+	{
+		if(l)
+			l->color = sf::Color(r, g, b, a);
+	}
+
+	// Noisy
 	void Script::setSound(Noisy* n, std::string s)
 	{
 		if(n)
@@ -671,19 +1985,19 @@ namespace swift
 	// Settings
 	std::tuple<bool, std::string> Script::getSettingStr(std::string s)
 	{
-		std::string v;
-		return std::make_tuple(settings->get(s, v), v);
+		const std::string* v = settings->find<std::string>(s);
+		return std::make_tuple(v != nullptr, v ? *v : std::string());
 	}
 
 	std::tuple<bool, bool> Script::getSettingBool(std::string s)
 	{
-		bool v;
-		return std::make_tuple(settings->get(s, v), v);
+		const bool* v = settings->find<bool>(s);
+		return std::make_tuple(v != nullptr, v && *v);
 	}
 
 	std::tuple<bool, float> Script::getSettingNum(std::string s)
 	{
-		float v;
-		return std::make_tuple(settings->get(s, v), v);
+		const float* v = settings->find<float>(s);
+		return std::make_tuple(v != nullptr, v ? *v : 0.f);
 	}
 }
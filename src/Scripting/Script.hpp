@@ -3,11 +3,23 @@
 
 /*
  * Lua is expected to be compiled with float as lua_number!!!
+ * Or, with LPP_LUAJIT defined, LuaJIT is used as it comes. Scripts then also get
+ * the ffi library, and swift_Physical and swift_Movable types for reading and
+ * writing those components in place, ex:
+ *
+ * local p = ffi.cast("swift_Physical*", getPhysical(e).pointer)
+ * p.position.x = p.position.x + 1
  */
 
 #include "LuaCpp/LuaCpp.hpp"
 
 #include <string>
+#include <vector>
+#include <memory>
+#include <map>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 
 #include <SFML/Graphics/RenderWindow.hpp>
 
@@ -19,6 +31,21 @@
 
 /* EntitySystem */
 #include "../EntitySystem/Entity.hpp"
+#include "../EntitySystem/EntityHandle.hpp"
+
+#include "../Collision/ContactEvent.hpp"
+
+#include "../Math/Random.hpp"
+
+#include "TimerWheel.hpp"
+#include "BytecodeCache.hpp"
+
+namespace detail
+{
+	// scripts hold entity handles, not pointers
+	template<>
+	struct isLightValue<swift::EntityHandle> : std::true_type {};
+}
 
 /*
  * Each Script object expects two functions to exist in the
@@ -36,9 +63,23 @@
  * This function should only do setup, etc.
  *
  * Update is called every game tick. If the state of the script
- * should ever change, that code goes in here.
+ * should ever change, that code goes in here. It runs as a coroutine:
+ * if it yields or runs out of budget, it carries on next tick instead.
  *
  * Finish is called at a game tick that finds 'Done' to be true
+ *
+ * An optional OnCollision(type, entity, other) is called for
+ * entities passed to subscribeCollisions. type is "begin",
+ * "stay", or "end".
+ *
+ * Scripts waiting on something can leave Update out, and be called
+ * only when it happens instead. Each returns an id for cancel(id):
+ *
+ * onTimer(seconds, function, repeats)
+ * onCollision(entity, function)		function(type, entity, other)
+ * onKey(binding, function)				function(binding), when a key binding fires
+ * onEnterRadius(x, y, r, component, function)	function(entity), for each entity
+ * 		with component ("" for any) that moved into the radius since the last tick
  */
 
 namespace swift
@@ -54,11 +95,46 @@ namespace swift
 			~Script();
 			
 			bool loadFromFile(const std::string& file);
+			
+			// code read from somewhere else, a pack. file is what it's known as
+			bool loadFromMemory(const void* data, std::size_t size, const std::string& file);
+			
+			// runs the file's new code in the same state, so its functions are replaced and the variables it set are kept.
+			// Start isn't called again. If the code doesn't load, the script keeps running what it had
+			bool reload(const void* data, std::size_t size);
 
 			void start();
 
 			void update();
 			
+			// since the script was made, or resetStats. Times are in microseconds
+			struct Stats
+			{
+				std::int64_t updateTime;
+				unsigned updates;
+				std::int64_t gcTime;			// in collector steps
+				std::size_t memory;				// bytes in the VM after the last step. Scripts that share one all have its
+				lpp::CallStats::Counts calls;	// into bindings, by lpp::CallStats id
+			};
+			
+			const Stats& getStats() const;
+			void resetStats();
+			
+			// calls OnCollision, if the script has it, and the onCollision callbacks for self
+			void onContact(ContactEvent::Type type, EntityHandle self, EntityHandle other);
+			
+			// fires due timers and onEnterRadius callbacks, once a tick, for the world being played
+			static void updateEvents(float dt);
+			
+			// steps scripts' garbage collectors for up to budget, in time the frame has to spare.
+			// Scripts' VMs don't collect as they allocate. A VM that grows too far anyway is stepped after updates
+			static void collectGarbage(sf::Time budget);
+			
+			// calls the onKey callbacks for a key binding that fired
+			static void onKeyBinding(const std::string& binding);
+			
+			// what Save returns is saved, and passed to Load. Saves are binary, tables and all, unless worlds save as XML.
+			// Either loads
 			bool load(const std::string& lfile);
 			bool save(const std::string& sfile);
 
@@ -72,32 +148,220 @@ namespace swift
 			static void setClock(sf::Clock& c);
 			static void setSettings(Settings& s);
 			static void setKeyboard(KeyboardManager& k);
+			// the world being played. Bindings act on it, unless a Scope says otherwise
 			static void setWorld(World& w);
 			static void setWorld(std::nullptr_t);
 			static void setPlayState(Play& p);
 			
-			// get world pointer for comparison
+			// set before scripts are made. Scripts made from then on share one VM, each with a globals table of its own
+			// instead of a VM. Libraries and bindings are made once, and a "shared" table every script sees can pass data
+			static void setSharedState(bool s);
+			
+			// Lua instructions Update may run each tick before it's paused, to carry on from there next tick. 0 for no limit.
+			// Update can also pause itself with coroutine.yield(), to spread work over ticks
+			static void setBudget(unsigned instructions);
+			
+			// ticks each script ran out of budget, by file
+			static const std::map<std::string, unsigned>& getOverBudget();
+			
+			// scripts loaded from then on are compiled once, and loaded from their cached bytecode in directory until
+			// they change. "" for none, the default
+			static void setBytecodeCache(const std::string& directory);
+			static const BytecodeCache& getBytecodeCache();
+			
+			// get world pointer for comparison, the world being played
 			static const World* getWorld();
-
+			
+			using Deferred = std::vector<std::function<void()>>;
+			
+			// sets the world bindings act on, for the thread it's made on, until it's destroyed.
+			// scripts of different worlds can then run on different threads
+			class Scope
+			{
+				public:
+					explicit Scope(World& w);
+					
+					// and engine writes, changing worlds, adding scripts, keys, and logging, are queued in d
+					// to be run on the main thread after the scripts, instead of being run
+					Scope(World& w, Deferred& d);
+					
+					~Scope();
+					
+					Scope(const Scope&) = delete;
+					Scope& operator=(const Scope&) = delete;
+				
+				private:
+					World* previousWorld;
+					Deferred* previousDeferred;
+			};
+			
+			// false if scripts can only run on one thread at a time, when they share a VM
+			static bool canRunInParallel();
+		
 		private:
+			// the VM scripts share, nullptr if they don't
+			static lpp::State* sharedHost();
+			static void openLibs(lpp::State& state);
+			
+#ifdef LPP_LUAJIT
+			// ffi.cdef of the components scripts may use through the ffi, laid out as the compiler laid them out
+			static std::string getFfiTypes();
+#endif
+			
+			// libraries and bindings, for separate VMs. Then variables, classes, and functions of this script
+			void setup();
+			
 			void addVariables();
 			void addClasses();
-			void addFunctions();
+			static void addFunctions(lpp::State& state);
+			void addInstanceFunctions();
+			
+			// compiles data named name, or loads it compiled from the bytecode cache, leaving the chunk on the stack
+			decltype(LUA_OK) loadChunk(const char* data, std::size_t size, const std::string& name);
+			
+			// runs the loaded chunk
+			bool finishLoad(bool loadResult, const std::string& file);
+			
+			// looks up the functions called every tick, and Done, once. Functions assigned again later
+			// than Start aren't seen until the script is reloaded
+			void resolveGlobals();
+			void releaseGlobals();
+			
+			// logs the error if result isn't LUA_OK
+			void checkCall(decltype(LUA_OK) result, const char* function);
+			
+			// sets the script to be deleted if Done is true
+			void checkDone();
+			
+			static const std::uint32_t SAVE_MAGIC = 0x43535753;	// "SWSC"
+			static const std::uint8_t SAVE_VERSION = 1;
+			
+			// push the values saved, returning how many, or -1 for malformed saves
+			int readBinary(const std::vector<std::uint8_t>& bytes);
+			int readXml(const std::vector<std::uint8_t>& bytes, const std::string& lfile);
+			
+			// the total values on the stack
+			std::vector<std::uint8_t> writeBinary(int total);
+			std::vector<std::uint8_t> writeXml(int total);
+			
+			// a callback registered with one of the on functions
+			struct Trigger
+			{
+				enum class Type
+				{
+					Timer,
+					Collision,
+					Key,
+					Radius
+				};
+				
+				Type type;
+				lpp::Reference function;
+				
+				unsigned ticks;			// timer: between firings, 0 if it fires once
+				EntityHandle entity;	// collision
+				std::string binding;	// key
+				
+				// radius
+				sf::Vector2f center;
+				float radius;
+				unsigned component;		// MAX_COMPONENTS for any
+				std::vector<std::uint32_t> inside;	// handle values, sorted
+			};
+			
+			unsigned addTrigger(Trigger&& trigger);
+			bool cancelTrigger(unsigned id);
+			
+			// drops every trigger and what it's registered with
+			void clearTriggers();
+			
+			void fireTimer(unsigned id);
+			void checkRadii();
+			
+			// the script a registering function was bound for
+			static Script* getBound(lua_State* state);
+			
+			// the function at idx of the calling state, referenced
+			static lpp::Reference takeFunction(lua_State* state, int idx);
+			
+			// ids of the triggers of type, matching, so callbacks can cancel triggers while they're called
+			template<typename F>
+			std::vector<unsigned> findTriggers(Trigger::Type type, F matching) const;
 			
 			lpp::State luaState;
 			
+			// after luaState, so they're released before it's closed
+			lpp::Reference startFunction;
+			lpp::Reference updateFunction;
+			lpp::Reference collisionFunction;
+			lpp::Global done;
+			lpp::Coroutine updateRoutine;
+			
+			std::map<unsigned, Trigger> triggers;
+			unsigned nextTrigger;
+			
+			Random::Generator rng;	// random's, a stream named after the script's file
+			
+			Stats stats;
+			std::size_t collected;	// bytes in the VM after the last step
+			std::size_t settled;	// after the last step that finished a cycle
+			bool collecting;		// partway through a cycle
+			
+			// after each update, a step for what was allocated since the last if the VM grew to twice what it settled at
+			void keepUpCollecting();
+			
+			// a step of the collector, timed into stats. kilobytes sizes it, 0 for the smallest
+			void stepCollector(int kilobytes);
+			static std::size_t getMemory(lua_State* state);
+			
+			// for collectGarbage
+			static std::vector<Script*> instances;
+			static std::size_t nextCollected;
+			
 			// Variables that need to be accessed by Lua
 			static sf::RenderWindow* window;
 			static AssetManager* assets;
 			static sf::Clock* clock;
 			static Settings* settings;
 			static KeyboardManager* keyboard;
-			static World* world;
 			static Play* play;
 			
+			static World* active;
+			
+			// this thread's, see Scope
+			static thread_local World* world;
+			static thread_local Deferred* deferred;
+			
+			// runs f now, or queues it if this thread's engine writes are deferred. True if it was queued
+			static bool runOrDefer(std::function<void()> f);
+			
+			// a line for the log, through runOrDefer
+			static void report(const std::string& line, Logger::Level level = Logger::Info);
+			
+			static std::unique_ptr<lpp::State> host;
+			static bool shareState;
+			
+			static unsigned budget;
+			static std::map<std::string, unsigned> overBudget;
+			
+			static TimerWheel timers;
+			static float tickLength;	// seconds, the last tick's
+			
+			static BytecodeCache bytecode;
+			
+			// scripts with key or radius triggers
+			static std::vector<Script*> listeners;
+			
 			std::string file;
 			bool deleteMe;
 			
+			// nullptr if the handle is stale, or there is no world
+			static Entity* resolve(EntityHandle e);
+			
+			// pushes e's C as a ComponentFields userdata, nil if it has none
+			template<typename C>
+			static int getComponent(lua_State* state);
+			
 			/* Lua converted functions */
 			// Utility
 			static std::tuple<unsigned, unsigned> getWindowSize();
@@ -108,49 +372,91 @@ namespace swift
 			// World
 			static bool addScript(std::string s);
 			static bool removeScript(std::string s);
-			static Entity* newEntity();
-			static bool removeEntity(int e);
-			static std::vector<Entity*> getEntities();
-			static Entity* getEntity(int e);
-			static Entity* getPlayer();
+			static EntityHandle newEntity();
+			static bool removeEntity(EntityHandle e);
+			static std::vector<EntityHandle> spawn(std::string prefab, unsigned count, std::vector<float> positions);
+			static std::vector<EntityHandle> getEntities();
+			static EntityHandle getEntity(int e);
+			static EntityHandle getPlayer();
 			static bool isAround(Physical* p, float x, float y, float r);
+			static std::vector<EntityHandle> getEntitiesAround(float x, float y, float r);
+			static std::vector<EntityHandle> getNearestEntities(float x, float y, unsigned k, float r);
+			
+			// filtered in C++ and returned as one table, instead of a binding call per entity.
+			// c is a component name, "" for any entity. Unknown components match nothing
+			static std::vector<EntityHandle> queryRadius(float x, float y, float r, std::string c);
+			static std::vector<EntityHandle> getEntitiesWith(std::string c);
+			
+			// through the world's index, instead of comparing getNameVal of every entity
+			static std::vector<EntityHandle> findByName(std::string n);
 			static std::string getCurrentWorld();
 			static bool setCurrentWorld(std::string s, std::string mf);
 			
 			// tilemap
 			static std::tuple<int, int> getTileSize();
+			
+			// many rays in one call, as x0, y0, x1, y1 each. casters has the entity each ray starts from, to not hit it, or is {}.
+			// returns if each hit something, where each stopped as x, y, and the entity each hit, null for a tile or nothing
+			static std::tuple<std::vector<bool>, std::vector<float>, std::vector<EntityHandle>> raycast(std::vector<float> rays, unsigned layer, std::vector<EntityHandle> casters);
+			
+			// segments as x0, y0, x1, y1 each. Only tiles block sight
+			static std::vector<bool> hasLineOfSight(std::vector<float> segments, unsigned layer);
+			
+			// by the faction's Sighted entities, now or ever, at x, y in pixels
+			static bool isVisible(unsigned faction, float x, float y);
+			static bool isExplored(unsigned faction, float x, float y);
+			
+			// fogs the tilemap as the faction sees it
+			static void showFog(unsigned faction);
+			static void hideFog();
+			
+			// particles. An emitter is defined with its texture, "" for plain squares, then its settings set by name, as
+			// ParticleEmitter's fields are, with the vectors' as accelerationX and so on. Emitters made from it return their id, 0 if it isn't defined
+			static bool defineEmitter(std::string name, std::string texture);
+			static bool setEmitter(std::string name, std::string field, float value);
+			static bool setEmitterColors(std::string name, unsigned r0, unsigned g0, unsigned b0, unsigned a0, unsigned r1, unsigned g1, unsigned b1, unsigned a1);
+			static unsigned emit(std::string name, float x, float y);
+			static unsigned attachEmitter(std::string name, EntityHandle e);
+			static void moveEmitter(unsigned id, float x, float y);
+			static void burstEmitter(unsigned id, unsigned count);
+			static void stopEmitter(unsigned id);
 		
 			// Entity System
-			static bool add(Entity* e, std::string c);
-			static bool remove(Entity* e, std::string c);
-			static bool has(Entity* e, std::string c);
+			static bool add(EntityHandle e, std::string c);
+			static bool remove(EntityHandle e, std::string c);
+			static bool has(EntityHandle e, std::string c);
+			
+			// runs e every tick for the next ticks, however far from the players it is
+			static void wake(EntityHandle e, unsigned ticks);
 			
 			// Drawable
-			static Drawable* getDrawable(Entity* e);
 			static bool setTexture(Drawable* d, std::string t);
 			static void setTextureRect(Drawable* d, int x, int y, int w, int h);
 			static std::tuple<float, float> getSpriteSize(Drawable* d);
 			static void setScale(Drawable* d, float x, float y);
 			
 			// Movable
-			static Movable* getMovable(Entity* e);
 			static void setMoveVelocity(Movable* m, float v);
 			static std::tuple<float, float> getVelocity(Movable* m);
 			
 			// Physical
-			static Physical* getPhysical(Entity* e);
 			static void setPosition(Physical* p, float x, float y);
 			static std::tuple<float, float> getPosition(Physical* p);
+			
+			// x then y of each entity, one after another. 0, 0 for entities that are gone or have no Physical
+			static std::vector<float> getPositions(std::vector<EntityHandle> list);
 			static void setSize(Physical* p, unsigned x, unsigned y);
 			static std::tuple<unsigned, unsigned> getSize(Physical* p);
 			
 			// Name
-			static Name* getName(Entity* e);
 			static void setName(Name* n, std::string name);
 			static std::string getNameVal(Name* n);
 			
+			// Luminous
+			static void setLightRadius(Luminous* l, float r);
+			static void setLightColor(Luminous* l, unsigned r, unsigned g, unsigned b, unsigned a);
+			
 			// Noisy
-			static Noisy* getNoisy(Entity* e);
 			static void setSound(Noisy* n, std::string s);
 			static std::string getSound(Noisy* n);
 			
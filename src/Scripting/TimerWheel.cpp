@@ -0,0 +1,72 @@
+#include "TimerWheel.hpp"
+
+#include <algorithm>
+
+namespace swift
+{
+	TimerWheel::TimerWheel(unsigned s)
+	:	mask(0),
+		current(0),
+		size(0)
+	{
+		unsigned count = 1;
+
+		while(count < s)
+			count <<= 1;
+
+		slots.resize(count);
+		mask = count - 1;
+	}
+
+	void TimerWheel::add(unsigned ticks, Script* owner, unsigned id)
+	{
+		ticks = std::max(ticks, 1u);
+
+		// the slot advance steps into after ticks steps, went past (ticks - 1) / slots times before then
+		unsigned slot = (current + ticks) & mask;
+		slots[slot].push_back({{owner, id}, (ticks - 1) / static_cast<unsigned>(slots.size())});
+		size++;
+	}
+
+	void TimerWheel::remove(const Script* owner)
+	{
+		for(auto& s : slots)
+		{
+			auto end = std::remove_if(s.begin(), s.end(), [owner](const Entry& e)
+			{
+				return e.timer.owner == owner;
+			});
+
+			size -= s.end() - end;
+			s.erase(end, s.end());
+		}
+	}
+
+	void TimerWheel::advance(FrameVector<Timer>& due)
+	{
+		current = (current + 1) & mask;
+
+		std::vector<Entry>& slot = slots[current];
+		std::size_t kept = 0;
+
+		for(auto& e : slot)
+		{
+			if(e.rounds == 0)
+			{
+				due.push_back(e.timer);
+				continue;
+			}
+
+			e.rounds--;
+			slot[kept++] = e;
+		}
+
+		size -= slot.size() - kept;
+		slot.resize(kept);
+	}
+
+	std::size_t TimerWheel::getSize() const
+	{
+		return size;
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include "../Memory/FrameArena.hpp"
+
+namespace swift
+{
+	class Script;
+	
+	// timers counted in ticks, in slots of a ring that's stepped once a tick. Adding a timer costs the same however many
+	// there are, and a step only looks at one slot. Timers further away than the ring is long go round it more than once
+	class TimerWheel
+	{
+		public:
+			struct Timer
+			{
+				Script* owner;
+				unsigned id;
+			};
+			
+			// slots is rounded up to a power of 2
+			explicit TimerWheel(unsigned slots = 256);
+			
+			// due after ticks more advances, at least 1
+			void add(unsigned ticks, Script* owner, unsigned id);
+			
+			// drops every timer of owner
+			void remove(const Script* owner);
+			
+			// one tick on. Timers now due are appended to due
+			void advance(FrameVector<Timer>& due);
+			
+			std::size_t getSize() const;
+		
+		private:
+			struct Entry
+			{
+				Timer timer;
+				unsigned rounds;	// times round the ring left before it's due
+			};
+			
+			std::vector<std::vector<Entry>> slots;
+			unsigned mask;
+			unsigned current;
+			std::size_t size;
+	};
+}
+
+#endif // TIMERWHEEL_HPP
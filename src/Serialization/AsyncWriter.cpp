@@ -0,0 +1,136 @@
+#include "AsyncWriter.hpp"
+
+#include <fstream>
+#include <cstdio>
+
+#include "../Logger/Logger.hpp"
+
+namespace swift
+{
+	AsyncWriter::AsyncWriter()
+	:	writing(0),
+		stopping(false),
+		worker(&AsyncWriter::work, this)
+	{}
+
+	AsyncWriter::~AsyncWriter()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		wake.notify_all();
+		worker.join();
+
+		poll();
+	}
+
+	void AsyncWriter::queue(const std::string& file, std::vector<std::uint8_t> data, Mode mode, Callback done, std::vector<std::uint8_t> header)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push_back({file, std::move(data), mode, std::move(done), std::move(header), false});
+		}
+
+		wake.notify_one();
+	}
+
+	void AsyncWriter::poll()
+	{
+		std::vector<Task> done;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			done.swap(finished);
+		}
+
+		for(auto& t : done)
+		{
+			if(!t.ok)
+				SWIFT_ERROR(World, "Writing \"" << t.file << "\" failed.\n");
+
+			if(t.done)
+				t.done(t.ok);
+		}
+	}
+
+	void AsyncWriter::wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		idle.wait(lock, [this]()
+		{
+			return tasks.empty() && writing == 0;
+		});
+	}
+
+	std::size_t AsyncWriter::getPending() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return tasks.size() + writing;
+	}
+
+	bool AsyncWriter::write(const std::string& file, const std::vector<std::uint8_t>& data, Mode mode, const std::vector<std::uint8_t>& header)
+	{
+		if(mode == Mode::Append)
+		{
+			std::ofstream fout(file, std::ios::binary | std::ios::app | std::ios::ate);
+
+			if(fout && fout.tellp() == 0 && !header.empty())
+				fout.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+			if(!data.empty())
+				fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+			return fout.good();
+		}
+
+		std::string temp = file + ".tmp";
+
+		{
+			std::ofstream fout(temp, std::ios::binary | std::ios::trunc);
+
+			if(!data.empty())
+				fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+			if(!fout)
+				return false;
+		}
+
+		// rename doesn't replace existing files everywhere
+		std::remove(file.c_str());
+		return std::rename(temp.c_str(), file.c_str()) == 0;
+	}
+
+	void AsyncWriter::work()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while(true)
+		{
+			wake.wait(lock, [this]()
+			{
+				return stopping || !tasks.empty();
+			});
+
+			// everything queued is written before stopping
+			if(tasks.empty())
+				return;
+
+			Task task = std::move(tasks.front());
+			tasks.pop_front();
+			writing++;
+
+			lock.unlock();
+			task.ok = write(task.file, task.data, task.mode, task.header);
+			lock.lock();
+
+			writing--;
+			finished.push_back(std::move(task));
+
+			if(tasks.empty() && writing == 0)
+				idle.notify_all();
+		}
+	}
+}
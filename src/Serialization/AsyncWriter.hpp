@@ -0,0 +1,77 @@
+#ifndef ASYNCWRITER_HPP
+#define ASYNCWRITER_HPP
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace swift
+{
+	// writes files on its own thread, so saving doesn't hold up the game. Writes happen in the order they were
+	// queued, so an append queued after a replace of the same file sees the new file.
+	// callbacks run, and failures are logged, in poll(), on the thread that owns the logger
+	class AsyncWriter
+	{
+		public:
+			enum class Mode
+			{
+				Replace,	// written to a temporary file that then replaces the old one, so a crash never leaves half a file
+				Append
+			};
+
+			using Callback = std::function<void(bool ok)>;
+
+			AsyncWriter();
+
+			// writes everything still queued first
+			~AsyncWriter();
+
+			AsyncWriter(const AsyncWriter&) = delete;
+			AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+			// header is written before data when appending to a new or empty file
+			void queue(const std::string& file, std::vector<std::uint8_t> data, Mode mode, Callback done = nullptr, std::vector<std::uint8_t> header = {});
+
+			// runs the callbacks of finished writes
+			void poll();
+
+			// blocks until everything queued has been written
+			void wait();
+
+			std::size_t getPending() const;
+
+			// what the worker does, for writing on the calling thread
+			static bool write(const std::string& file, const std::vector<std::uint8_t>& data, Mode mode, const std::vector<std::uint8_t>& header = {});
+
+		private:
+			struct Task
+			{
+				std::string file;
+				std::vector<std::uint8_t> data;
+				Mode mode;
+				Callback done;
+				std::vector<std::uint8_t> header;
+				bool ok;
+			};
+
+			void work();
+
+			std::deque<Task> tasks;
+			std::vector<Task> finished;
+			std::size_t writing;	// tasks taken by the worker, but not finished
+			bool stopping;
+
+			mutable std::mutex mutex;
+			std::condition_variable wake;
+			std::condition_variable idle;
+
+			std::thread worker;
+	};
+}
+
+#endif // ASYNCWRITER_HPP
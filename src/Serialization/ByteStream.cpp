@@ -0,0 +1,309 @@
+#include "ByteStream.hpp"
+
+#include <cstring>
+
+namespace swift
+{
+	unsigned StringTable::add(const std::string& s)
+	{
+		auto it = indices.find(s);
+
+		if(it != indices.end())
+			return it->second;
+
+		indices.emplace(s, strings.size());
+		strings.push_back(s);
+
+		return strings.size() - 1;
+	}
+
+	const std::string* StringTable::get(unsigned i) const
+	{
+		return i < strings.size() ? &strings[i] : nullptr;
+	}
+
+	std::size_t StringTable::size() const
+	{
+		return strings.size();
+	}
+
+	void StringTable::write(ByteWriter& out) const
+	{
+		out.writeUInt(strings.size());
+
+		for(auto& s : strings)
+		{
+			out.writeUInt(s.size());
+			out.writeBytes(s.data(), s.size());
+		}
+	}
+
+	bool StringTable::read(ByteReader& in)
+	{
+		strings.clear();
+		indices.clear();
+
+		std::uint64_t count = in.readUInt();
+
+		// every string takes at least a byte
+		if(count > in.remaining())
+			in.fail();
+
+		for(std::uint64_t i = 0; i < count && in.good(); i++)
+			add(in.readString());
+
+		return in.good();
+	}
+
+	void ByteWriter::writeByte(std::uint8_t b)
+	{
+		data.push_back(b);
+	}
+
+	void ByteWriter::writeBool(bool b)
+	{
+		data.push_back(b ? 1 : 0);
+	}
+
+	void ByteWriter::writeUInt(std::uint64_t u)
+	{
+		while(u >= 0x80)
+		{
+			data.push_back(static_cast<std::uint8_t>(u) | 0x80);
+			u >>= 7;
+		}
+
+		data.push_back(static_cast<std::uint8_t>(u));
+	}
+
+	void ByteWriter::writeInt(std::int64_t i)
+	{
+		// zigzag, so small negative numbers stay small
+		writeUInt((static_cast<std::uint64_t>(i) << 1) ^ static_cast<std::uint64_t>(i >> 63));
+	}
+
+	void ByteWriter::writeFloat(float f)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		writeUInt32(bits);
+	}
+
+	void ByteWriter::writeString(const std::string& s)
+	{
+		if(strings)
+		{
+			writeUInt(strings->add(s));
+			return;
+		}
+
+		writeUInt(s.size());
+		data.insert(data.end(), s.begin(), s.end());
+	}
+
+	void ByteWriter::writeBytes(const void* d, std::size_t s)
+	{
+		const std::uint8_t* bytes = static_cast<const std::uint8_t*>(d);
+		data.insert(data.end(), bytes, bytes + s);
+	}
+
+	void ByteWriter::patchUInt32(std::size_t p, std::uint32_t u)
+	{
+		for(unsigned i = 0; i < 4; i++)
+			data[p + i] = static_cast<std::uint8_t>(u >> (i * 8));
+	}
+
+	void ByteWriter::writeUInt32(std::uint32_t u)
+	{
+		for(unsigned i = 0; i < 4; i++)
+			data.push_back(static_cast<std::uint8_t>(u >> (i * 8)));
+	}
+
+	const std::vector<std::uint8_t>& ByteWriter::getData() const
+	{
+		return data;
+	}
+
+	std::size_t ByteWriter::size() const
+	{
+		return data.size();
+	}
+
+	void ByteWriter::setStringTable(StringTable* t)
+	{
+		strings = t;
+	}
+
+	void ByteWriter::clear()
+	{
+		data.clear();
+	}
+
+	ByteReader::ByteReader(const std::uint8_t* d, std::size_t s)
+	:	data(d),
+		size(s),
+		pos(0),
+		failed(false),
+		strings(nullptr)
+	{
+	}
+
+	ByteReader::ByteReader(const std::vector<std::uint8_t>& d)
+	:	ByteReader(d.data(), d.size())
+	{
+	}
+
+	std::uint8_t ByteReader::readByte()
+	{
+		if(failed || pos >= size)
+		{
+			failed = true;
+			return 0;
+		}
+
+		return data[pos++];
+	}
+
+	bool ByteReader::readBool()
+	{
+		return readByte() != 0;
+	}
+
+	std::uint64_t ByteReader::readUInt()
+	{
+		std::uint64_t u = 0;
+
+		for(unsigned shift = 0; shift < 64; shift += 7)
+		{
+			std::uint8_t b = readByte();
+
+			if(failed)
+				return 0;
+
+			u |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+
+			if(!(b & 0x80))
+				return u;
+		}
+
+		// more than 10 bytes, not a varint we wrote
+		failed = true;
+		return 0;
+	}
+
+	std::int64_t ByteReader::readInt()
+	{
+		std::uint64_t u = readUInt();
+		return static_cast<std::int64_t>(u >> 1) ^ -static_cast<std::int64_t>(u & 1);
+	}
+
+	float ByteReader::readFloat()
+	{
+		std::uint32_t bits = readUInt32();
+
+		float f;
+		std::memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	std::string ByteReader::readString()
+	{
+		if(strings)
+		{
+			const std::string* s = strings->get(readStringIndex());
+			return s ? *s : std::string();
+		}
+
+		std::uint64_t length = readUInt();
+
+		if(failed || length > remaining())
+		{
+			failed = true;
+			return {};
+		}
+
+		std::string s(reinterpret_cast<const char*>(data + pos), length);
+		pos += length;
+
+		return s;
+	}
+
+	void ByteReader::setStringTable(const StringTable* t)
+	{
+		strings = t;
+	}
+
+	unsigned ByteReader::readStringIndex()
+	{
+		std::uint64_t index = readUInt();
+
+		if(!strings || index >= strings->size())
+		{
+			failed = true;
+			return 0;
+		}
+
+		return static_cast<unsigned>(index);
+	}
+
+	bool ByteReader::readBytes(void* out, std::size_t count)
+	{
+		if(failed || count > remaining())
+		{
+			failed = true;
+			return false;
+		}
+
+		std::memcpy(out, data + pos, count);
+		pos += count;
+
+		return true;
+	}
+
+	std::uint32_t ByteReader::readUInt32()
+	{
+		std::uint32_t u = 0;
+
+		for(unsigned i = 0; i < 4; i++)
+			u |= static_cast<std::uint32_t>(readByte()) << (i * 8);
+
+		return failed ? 0 : u;
+	}
+
+	bool ByteReader::skip(std::size_t count)
+	{
+		if(failed || count > remaining())
+		{
+			failed = true;
+			return false;
+		}
+
+		pos += count;
+		return true;
+	}
+
+	void ByteReader::fail()
+	{
+		failed = true;
+	}
+
+	bool ByteReader::good() const
+	{
+		return !failed;
+	}
+
+	bool ByteReader::atEnd() const
+	{
+		return pos >= size;
+	}
+
+	std::size_t ByteReader::getPosition() const
+	{
+		return pos;
+	}
+
+	std::size_t ByteReader::remaining() const
+	{
+		return size - pos;
+	}
+}
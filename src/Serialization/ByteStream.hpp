@@ -0,0 +1,106 @@
+#ifndef BYTESTREAM_HPP
+#define BYTESTREAM_HPP
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace swift
+{
+	class ByteWriter;
+	class ByteReader;
+
+	// strings written through a table are stored once, and written as their index in the table.
+	// the table itself has to be written before anything that uses it
+	class StringTable
+	{
+		public:
+			unsigned add(const std::string& s);
+
+			// nullptr if i is out of range
+			const std::string* get(unsigned i) const;
+			std::size_t size() const;
+
+			void write(ByteWriter& out) const;
+			bool read(ByteReader& in);
+
+		private:
+			std::vector<std::string> strings;
+			std::unordered_map<std::string, unsigned> indices;
+	};
+
+	// binary encoding shared by saves and snapshots.
+	// unsigned and signed integers are varints (signed ones zigzagged), floats are 4 little endian bytes,
+	// strings are a varint length followed by the bytes
+	class ByteWriter
+	{
+		public:
+			void writeByte(std::uint8_t b);
+			void writeBool(bool b);
+			void writeUInt(std::uint64_t u);
+			void writeInt(std::int64_t i);
+			void writeFloat(float f);
+			void writeString(const std::string& s);
+			void writeBytes(const void* data, std::size_t size);
+
+			// strings written after this go into t, which has to outlive the writing
+			void setStringTable(StringTable* t);
+
+			// overwrites 4 bytes at pos with u, for sizes only known after writing what follows
+			void patchUInt32(std::size_t pos, std::uint32_t u);
+			void writeUInt32(std::uint32_t u);
+
+			const std::vector<std::uint8_t>& getData() const;
+			std::size_t size() const;
+			void clear();
+
+		private:
+			std::vector<std::uint8_t> data;
+			StringTable* strings = nullptr;
+	};
+
+	// reads what a ByteWriter wrote. Reading past the end, or malformed data, sets the reader
+	// as failed and every read after that returns zeroes
+	class ByteReader
+	{
+		public:
+			ByteReader(const std::uint8_t* d, std::size_t s);
+			explicit ByteReader(const std::vector<std::uint8_t>& d);
+
+			std::uint8_t readByte();
+			bool readBool();
+			std::uint64_t readUInt();
+			std::int64_t readInt();
+			float readFloat();
+			std::string readString();
+			bool readBytes(void* out, std::size_t count);
+
+			// strings read after this are looked up in t, it has to be the table they were written with
+			void setStringTable(const StringTable* t);
+
+			// with a table, a string's index in it, for callers that resolve each string once
+			unsigned readStringIndex();
+			std::uint32_t readUInt32();
+
+			bool skip(std::size_t count);
+
+			// marks the data as invalid, ex: an unknown version
+			void fail();
+
+			bool good() const;
+			bool atEnd() const;
+			std::size_t getPosition() const;
+			std::size_t remaining() const;
+
+		private:
+			const std::uint8_t* data;
+			std::size_t size;
+			std::size_t pos;
+			bool failed;
+			const StringTable* strings;
+	};
+}
+
+#endif // BYTESTREAM_HPP
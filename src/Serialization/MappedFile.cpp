@@ -0,0 +1,142 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace swift
+{
+#ifdef _WIN32
+	MappedFile::MappedFile()
+	:	data(nullptr),
+		size(0),
+		file(INVALID_HANDLE_VALUE),
+		mapping(nullptr)
+	{
+	}
+#else
+	MappedFile::MappedFile()
+	:	data(nullptr),
+		size(0),
+		file(-1)
+	{
+	}
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::open(const std::string& f)
+	{
+		close();
+
+#ifdef _WIN32
+		file = CreateFileA(f.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if(file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+
+		if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if(mapping == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+		file = ::open(f.c_str(), O_RDONLY);
+
+		if(file == -1)
+			return false;
+
+		struct stat info;
+
+		// empty files can't be mapped
+		if(fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			close();
+			return false;
+		}
+
+		void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if(mapped == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+
+		data = static_cast<const std::uint8_t*>(mapped);
+		size = static_cast<std::size_t>(info.st_size);
+#endif
+
+		if(data == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+#ifdef _WIN32
+		if(data != nullptr)
+			UnmapViewOfFile(data);
+
+		if(mapping != nullptr)
+			CloseHandle(mapping);
+
+		if(file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if(data != nullptr)
+			munmap(const_cast<std::uint8_t*>(data), size);
+
+		if(file != -1)
+			::close(file);
+
+		file = -1;
+#endif
+
+		data = nullptr;
+		size = 0;
+	}
+
+	bool MappedFile::isOpen() const
+	{
+		return data != nullptr;
+	}
+
+	const std::uint8_t* MappedFile::getData() const
+	{
+		return data;
+	}
+
+	std::size_t MappedFile::getSize() const
+	{
+		return size;
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace swift
+{
+	// a file mapped read only into memory, so it can be read without copying it into buffers first.
+	// pages are only read from disk as they're touched. Not copyable, the mapping belongs to one object
+	class MappedFile
+	{
+		public:
+			MappedFile();
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			// closes whatever was open first. False if the file couldn't be opened or mapped
+			bool open(const std::string& file);
+			void close();
+
+			bool isOpen() const;
+
+			// nullptr if nothing is open. Page aligned
+			const std::uint8_t* getData() const;
+			std::size_t getSize() const;
+
+		private:
+			const std::uint8_t* data;
+			std::size_t size;
+
+#ifdef _WIN32
+			void* file;
+			void* mapping;
+#else
+			int file;
+#endif
+	};
+}
+
+#endif // MAPPEDFILE_HPP
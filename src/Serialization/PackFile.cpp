@@ -0,0 +1,230 @@
+#include "PackFile.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#include <zlib.h>
+
+#include "ByteStream.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Math/Hash.hpp"
+
+namespace swift
+{
+	bool PackFile::open(const std::string& f)
+	{
+		close();
+
+		if(!mapping.open(f))
+			return false;
+
+		ByteReader in(mapping.getData(), mapping.getSize());
+
+		if(in.readUInt32() != PACK_MAGIC || in.readByte() > PACK_VERSION)
+		{
+			close();
+			return false;
+		}
+
+		std::uint64_t count = in.readUInt();
+
+		// every entry takes more than a byte
+		if(count > in.remaining())
+			in.fail();
+
+		entries.reserve(count);
+
+		for(std::uint64_t i = 0; i < count && in.good(); i++)
+		{
+			Entry entry;
+			std::uint64_t pathHash = in.readUInt();
+			entry.path = in.readString();
+			entry.offset = in.readUInt();
+			entry.size = in.readUInt();
+			entry.rawSize = in.readUInt();
+			entry.compressed = in.readBool();
+
+			if(entry.offset > mapping.getSize() || entry.size > mapping.getSize() - entry.offset || pathHash != hash(entry.path))
+				in.fail();
+
+			byHash.emplace(pathHash, entries.size());
+			entries.push_back(entry);
+		}
+
+		if(!in.good())
+		{
+			SWIFT_ERROR(Assets, "Pack file \"" << f << "\" is malformed.\n");
+			close();
+			return false;
+		}
+
+		file = f;
+
+		return true;
+	}
+
+	void PackFile::close()
+	{
+		mapping.close();
+		file.clear();
+		entries.clear();
+		byHash.clear();
+	}
+
+	bool PackFile::isOpen() const
+	{
+		return mapping.isOpen();
+	}
+
+	const std::string& PackFile::getFile() const
+	{
+		return file;
+	}
+
+	const PackFile::Entry* PackFile::find(const std::string& path) const
+	{
+		auto it = byHash.find(hash(path));
+
+		if(it == byHash.end() || entries[it->second].path != path)
+			return nullptr;
+
+		return &entries[it->second];
+	}
+
+	const std::vector<PackFile::Entry>& PackFile::getEntries() const
+	{
+		return entries;
+	}
+
+	const std::uint8_t* PackFile::getData(const Entry& entry) const
+	{
+		return entry.compressed ? nullptr : mapping.getData() + entry.offset;
+	}
+
+	bool PackFile::read(const Entry& entry, std::vector<std::uint8_t>& out) const
+	{
+		const std::uint8_t* data = mapping.getData() + entry.offset;
+
+		if(!entry.compressed)
+		{
+			out.assign(data, data + entry.size);
+			return true;
+		}
+
+		out.resize(entry.rawSize);
+		uLongf size = entry.rawSize;
+
+		return uncompress(out.data(), &size, data, entry.size) == Z_OK && size == entry.rawSize;
+	}
+
+	bool PackFile::write(const std::string& pack, const std::vector<std::string>& files, const Convert& convert)
+	{
+		std::vector<Entry> packed;
+		std::vector<std::vector<std::uint8_t>> blobs;
+		std::unordered_map<std::uint64_t, std::string> paths;
+
+		for(auto& f : files)
+		{
+			std::ifstream fin(f, std::ios::binary);
+
+			if(!fin)
+			{
+				SWIFT_ERROR(Assets, "Could not read \"" << f << "\" for pack \"" << pack << "\".\n");
+				return false;
+			}
+
+			auto inserted = paths.emplace(hash(f), f);
+
+			if(!inserted.second)
+			{
+				SWIFT_ERROR(Assets, "\"" << f << "\" and \"" << inserted.first->second << "\" have the same hash, they can't share a pack.\n");
+				return false;
+			}
+
+			std::vector<std::uint8_t> raw((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+			if(convert && !convert(f, raw))
+			{
+				SWIFT_ERROR(Assets, "Could not convert \"" << f << "\" for pack \"" << pack << "\".\n");
+				return false;
+			}
+
+			Entry entry{f, 0, raw.size(), raw.size(), false};
+
+			// compressing these again gains next to nothing
+			std::string extension = f.substr(f.find_last_of('.') + 1);
+			bool compressible = extension != "png" && extension != "jpg" && extension != "ogg" && extension != "flac";
+
+			if(compressible && !raw.empty())
+			{
+				std::vector<std::uint8_t> deflated(compressBound(raw.size()));
+				uLongf size = deflated.size();
+
+				// only kept if it saves a tenth, decompressing isn't free
+				if(compress2(deflated.data(), &size, raw.data(), raw.size(), Z_DEFAULT_COMPRESSION) == Z_OK && size < raw.size() - raw.size() / 10)
+				{
+					deflated.resize(size);
+					raw.swap(deflated);
+					entry.size = size;
+					entry.compressed = true;
+				}
+			}
+
+			packed.push_back(entry);
+			blobs.push_back(std::move(raw));
+		}
+
+		// offsets depend on the index's size, which depends on the offsets. Varints only grow with them, so
+		// the index is written with offsets from 0 first, then again until its size stops changing
+		std::size_t indexSize = 0;
+		ByteWriter index;
+
+		while(true)
+		{
+			index.clear();
+			index.writeUInt32(PACK_MAGIC);
+			index.writeByte(PACK_VERSION);
+			index.writeUInt(packed.size());
+
+			std::uint64_t offset = indexSize;
+
+			for(auto& e : packed)
+			{
+				e.offset = offset;
+				offset += e.size;
+
+				index.writeUInt(hash(e.path));
+				index.writeString(e.path);
+				index.writeUInt(e.offset);
+				index.writeUInt(e.size);
+				index.writeUInt(e.rawSize);
+				index.writeBool(e.compressed);
+			}
+
+			if(index.size() == indexSize)
+				break;
+
+			indexSize = index.size();
+		}
+
+		std::ofstream fout(pack, std::ios::binary | std::ios::trunc);
+
+		fout.write(reinterpret_cast<const char*>(index.getData().data()), index.size());
+
+		for(auto& b : blobs)
+			fout.write(reinterpret_cast<const char*>(b.data()), b.size());
+
+		if(!fout)
+		{
+			SWIFT_ERROR(Assets, "Could not write pack \"" << pack << "\".\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	std::uint64_t PackFile::hash(const std::string& path)
+	{
+		return math::hash(path);
+	}
+}
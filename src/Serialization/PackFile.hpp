@@ -0,0 +1,67 @@
+#ifndef PACKFILE_HPP
+#define PACKFILE_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+#include "MappedFile.hpp"
+
+namespace swift
+{
+	// many files in one, mapped into memory. An index at the front has each file's path, the hash it's looked up by,
+	// and where its bytes are. Files are stored as they are, or zlib compressed where that makes them much smaller.
+	// reading is safe from several threads at once
+	class PackFile
+	{
+		public:
+			struct Entry
+			{
+				std::string path;
+				std::uint64_t offset;		// from the start of the pack
+				std::uint64_t size;			// stored
+				std::uint64_t rawSize;		// once decompressed
+				bool compressed;
+			};
+
+			// false if the file isn't a pack, or is malformed
+			bool open(const std::string& file);
+			void close();
+
+			bool isOpen() const;
+			const std::string& getFile() const;
+
+			// nullptr if the pack doesn't have path
+			const Entry* find(const std::string& path) const;
+			const std::vector<Entry>& getEntries() const;
+
+			// where an uncompressed entry is in the mapping, nullptr for compressed ones
+			const std::uint8_t* getData(const Entry& entry) const;
+
+			// the entry's bytes, decompressed
+			bool read(const Entry& entry, std::vector<std::uint8_t>& out) const;
+
+			// can replace a file's bytes with what's stored for it, ex: a compiled form. False stops the packing
+			using Convert = std::function<bool(const std::string& path, std::vector<std::uint8_t>& data)>;
+
+			// packs the files under the paths they're given as. Already compressed formats are stored as they are
+			static bool write(const std::string& pack, const std::vector<std::string>& files, const Convert& convert = nullptr);
+
+			static std::uint64_t hash(const std::string& path);
+
+		private:
+			static const std::uint32_t PACK_MAGIC = 0x4b505753;	// "SWPK"
+			static const std::uint8_t PACK_VERSION = 1;
+
+			MappedFile mapping;
+			std::string file;
+
+			std::vector<Entry> entries;
+			std::unordered_map<std::uint64_t, std::size_t> byHash;
+	};
+}
+
+#endif // PACKFILE_HPP
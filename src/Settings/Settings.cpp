@@ -2,9 +2,12 @@
 
 #include "../Logger/Logger.hpp"
 
+#include <cstdlib>
+
 namespace swift
 {
 	Settings::Settings()
+	:	events(64)
 	{
 		changed = false;
 	}
@@ -17,6 +20,7 @@ namespace swift
 	bool Settings::loadFile(const std::string& f)
 	{
 		data.clear();
+		values.clear();
 		file = f;
 		return read();
 	}
@@ -35,178 +39,164 @@ namespace swift
 
 	bool Settings::get(const std::string& setting, std::string& value) const
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			value = data[i].second;
-			return true;
-		}
-		return false;
+		const Value* v = findValue(setting);
+		if(v)
+			value = v->text;
+		return v != nullptr;
 	}
 
 	bool Settings::get(const std::string& setting, bool& value) const
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			std::string temp = data[i].second;
-
-			if(temp == "true" || temp == "1" || temp == "TRUE")
-				value = true;
-			else
-				value = false;
-
-			return true;
-		}
-		return false;
+		const Value* v = findValue(setting);
+		if(v)
+			value = v->boolean;
+		return v != nullptr;
 	}
 
 	bool Settings::get(const std::string& setting, char& value) const
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			value = data[i].second[0];
-			return true;
-		}
-		return false;
+		const Value* v = findValue(setting);
+		if(v)
+			value = v->text.empty() ? 0 : v->text[0];
+		return v != nullptr;
 	}
 
 	bool Settings::get(const std::string& setting, int& value) const
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			value = std::stoi(data[i].second);
-			return true;
-		}
-		return false;
+		const Value* v = findValue(setting);
+		if(v)
+			value = v->integer;
+		return v != nullptr;
 	}
 
 	bool Settings::get(const std::string& setting, unsigned& value) const
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			value = std::stoi(data[i].second);
-			return true;
-		}
-		return false;
+		const Value* v = findValue(setting);
+		if(v)
+			value = static_cast<unsigned>(v->integer);
+		return v != nullptr;
 	}
 
 	bool Settings::get(const std::string& setting, float& value) const
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			value = std::stof(data[i].second);
-			return true;
-		}
-		return false;
+		const Value* v = findValue(setting);
+		if(v)
+			value = v->number;
+		return v != nullptr;
 	}
 
 	bool Settings::set(const std::string& setting, std::string& value)
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			data[i].second = value;
-			changed = true;
-			
-			sendMessage(setting, value);
-			return true;
-		}
-		
-		return false;
+		Value* v = findValue(setting);
+		if(v)
+			store(*v, setting, value);
+		return v != nullptr;
 	}
 
 	bool Settings::set(const std::string& setting, bool& value)
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			data[i].second = value ? "true" : "false";
-			changed = true;
-			
-			sendMessage(setting, value ? "true" : "false");
-			return true;
-		}
-		
-		return false;
+		Value* v = findValue(setting);
+		if(v)
+			store(*v, setting, value ? "true" : "false");
+		return v != nullptr;
 	}
 
 	bool Settings::set(const std::string& setting, char& value)
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			data[i].second = value;
-			changed = true;
-			
-			sendMessage(setting, std::to_string(value));
-			return true;
-		}
-		
-		return false;
+		Value* v = findValue(setting);
+		if(v)
+			store(*v, setting, std::string(1, value));
+		return v != nullptr;
 	}
 
 	bool Settings::set(const std::string& setting, int& value)
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			data[i].second = std::to_string(value);
-			changed = true;
-			
-			sendMessage(setting, std::to_string(value));
-			return true;
-		}
-		
-		return false;
+		Value* v = findValue(setting);
+		if(v)
+			store(*v, setting, std::to_string(value));
+		return v != nullptr;
 	}
-	
+
 	bool Settings::set(const std::string& setting, unsigned& value)
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			data[i].second = std::to_string(value);
-			changed = true;
-			
-			sendMessage(setting, std::to_string(value));
-			return true;
-		}
-		
-		return false;
+		Value* v = findValue(setting);
+		if(v)
+			store(*v, setting, std::to_string(value));
+		return v != nullptr;
 	}
 
 	bool Settings::set(const std::string& setting, float& value)
 	{
-		int i = findIndex(setting);
-		if(i > -1)
-		{
-			data[i].second = std::to_string(value);
-			changed = true;
-			
-			sendMessage(setting, std::to_string(value));
-			return true;
-		}
-		
-		return false;
+		Value* v = findValue(setting);
+		if(v)
+			store(*v, setting, std::to_string(value));
+		return v != nullptr;
 	}
 
-	int Settings::findIndex(const std::string& setting) const
+	template<>
+	const std::string* Settings::find<std::string>(const std::string& setting) const
 	{
-		for(size_t i = 0; i < data.size(); i++)
-		{
-			if(data[i].first[0] == '#')
-				continue;
-			else if(data[i].first == setting)
-			{
-				return i;
-			}
-		}
-		return -1;
+		const Value* v = findValue(setting);
+		return v ? &v->text : nullptr;
+	}
+
+	template<>
+	const bool* Settings::find<bool>(const std::string& setting) const
+	{
+		const Value* v = findValue(setting);
+		return v ? &v->boolean : nullptr;
+	}
+
+	template<>
+	const int* Settings::find<int>(const std::string& setting) const
+	{
+		const Value* v = findValue(setting);
+		return v ? &v->integer : nullptr;
+	}
+
+	template<>
+	const float* Settings::find<float>(const std::string& setting) const
+	{
+		const Value* v = findValue(setting);
+		return v ? &v->number : nullptr;
+	}
+
+	EventBus<std::string>& Settings::getEvents()
+	{
+		return events;
+	}
+
+	void Settings::parse(Value& v)
+	{
+		v.boolean = v.text == "true" || v.text == "1" || v.text == "TRUE";
+
+		// what isn't a number reads as 0
+		const char* c = v.text.c_str();
+		v.integer = static_cast<int>(std::strtol(c, nullptr, 10));
+		v.number = std::strtof(c, nullptr);
+	}
+
+	Settings::Value* Settings::findValue(const std::string& setting)
+	{
+		auto it = values.find(setting);
+		return it != values.end() ? &it->second : nullptr;
+	}
+
+	const Settings::Value* Settings::findValue(const std::string& setting) const
+	{
+		auto it = values.find(setting);
+		return it != values.end() ? &it->second : nullptr;
+	}
+
+	void Settings::store(Value& v, const std::string& setting, const std::string& text)
+	{
+		v.text = text;
+		parse(v);
+
+		data[v.line].second = text;
+		changed = true;
+
+		events.publish(Changed, setting);
 	}
 
 	bool Settings::read()
@@ -255,6 +245,15 @@ namespace swift
 				value = "";
 			}
 
+			// the first of a setting given twice is the one read, as it always was
+			if(line.size() > 0 && line[0] != '#' && !values.count(setting))
+			{
+				Value& v = values[setting];
+				v.text = value;
+				v.line = data.size();
+				parse(v);
+			}
+
 			data.push_back(make_pair(setting, value));
 		}
 
@@ -271,7 +270,7 @@ namespace swift
 
 		if(!out.is_open())
 		{
-			log << "Error: Unable to open settings file: \"" << file << "\" for writing.\n";
+			SWIFT_ERROR(General, "Unable to open settings file: \"" << file << "\" for writing.\n");
 			return false;
 		}
 
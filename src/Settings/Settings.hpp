@@ -1,18 +1,25 @@
 #ifndef SETTINGS_HPP
 #define SETTINGS_HPP
 
-#include "../MessageSystem/Observable.hpp"
+#include "../MessageSystem/EventBus.hpp"
 
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <vector>
+#include <unordered_map>
 
 namespace swift
 {
-	class Settings : public Observable<std::string>
+	class Settings
 	{
 		public:
+			// published by set, with the setting's name
+			enum Events : EventId
+			{
+				Changed
+			};
+
 			Settings();
 			~Settings();
 
@@ -45,15 +52,53 @@ namespace swift
 			bool set(const std::string& setting, unsigned& value);
 			bool set(const std::string& setting, float& value);
 
+			// the setting's value, parsed as T, or nullptr if there's no such setting. T is std::string, bool, int, or float.
+			// Values are parsed once, by loadFile and set, so a kept pointer is a cheap read that sees every set.
+			// It's good until the next loadFile
+			template<typename T>
+			const T* find(const std::string& setting) const;
+
+			// subscribe to Changed here. The game dispatches it each update
+			EventBus<std::string>& getEvents();
+
 		private:
-			int findIndex(const std::string& setting) const;
+			struct Value
+			{
+				std::string text;
+				bool boolean;
+				int integer;
+				float number;
+
+				std::size_t line;	// in data
+			};
+
+			// from text
+			static void parse(Value& v);
+
+			Value* findValue(const std::string& setting);
+			const Value* findValue(const std::string& setting) const;
+
+			void store(Value& v, const std::string& setting, const std::string& text);
+
 			bool read();
 			bool write() const;
 
 			bool changed;
 			std::string file;
-			std::vector< std::pair<std::string, std::string> > data;
+			std::vector< std::pair<std::string, std::string> > data;	// lines of the file, for writing it back
+			std::unordered_map<std::string, Value> values;	// nodes don't move, so pointers into them stay good
+
+			EventBus<std::string> events;
 	};
+
+	template<>
+	const std::string* Settings::find<std::string>(const std::string& setting) const;
+	template<>
+	const bool* Settings::find<bool>(const std::string& setting) const;
+	template<>
+	const int* Settings::find<int>(const std::string& setting) const;
+	template<>
+	const float* Settings::find<float>(const std::string& setting) const;
 }
 
 #endif // SETTINGS_HPP
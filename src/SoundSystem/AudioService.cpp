@@ -0,0 +1,101 @@
+#include "AudioService.hpp"
+
+#include <chrono>
+
+#include <SFML/System/Clock.hpp>
+
+#include "SoundPlayer.hpp"
+#include "MusicPlayer.hpp"
+
+#include "../Memory/MemoryTracker.hpp"
+
+namespace swift
+{
+	const sf::Time AudioService::UpdateInterval = sf::milliseconds(10);
+	thread_local bool AudioService::onThread = false;
+
+	AudioService::AudioService(SoundPlayer& sp, MusicPlayer& mp)
+	:	soundPlayer(sp),
+		musicPlayer(mp),
+		commands(QueueSize),
+		running(false)
+	{
+		soundPlayer.setService(this);
+		musicPlayer.setService(this);
+	}
+
+	AudioService::~AudioService()
+	{
+		stop();
+
+		soundPlayer.setService(nullptr);
+		musicPlayer.setService(nullptr);
+	}
+
+	void AudioService::start()
+	{
+		if(thread.joinable())
+			return;
+
+		running = true;
+		thread = std::thread(&AudioService::run, this);
+	}
+
+	void AudioService::stop()
+	{
+		if(!thread.joinable())
+			return;
+
+		// what's still queued is run before the thread ends
+		running = false;
+		thread.join();
+	}
+
+	bool AudioService::isElsewhere() const
+	{
+		return running && !onThread;
+	}
+
+	bool AudioService::post(Command c)
+	{
+		if(!isElsewhere())
+			return false;
+
+		// full only if the audio thread is stuck, commands are small and quick
+		while(!commands.push(std::move(c)))
+			std::this_thread::yield();
+
+		return true;
+	}
+
+	void AudioService::run()
+	{
+		SWIFT_MEMORY_SCOPE(Audio);
+
+		onThread = true;
+
+		sf::Clock clock;
+		Command c;
+
+		while(true)
+		{
+			bool stopping = !running;
+
+			while(commands.pop(c))
+				c();
+
+			if(stopping)
+				break;
+
+			if(clock.getElapsedTime() >= UpdateInterval)
+			{
+				clock.restart();
+				soundPlayer.update();
+				musicPlayer.update();
+			}
+
+			// commands wait at most this long, well under a frame
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
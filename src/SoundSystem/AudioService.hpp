@@ -0,0 +1,60 @@
+#ifndef AUDIOSERVICE_HPP
+#define AUDIOSERVICE_HPP
+
+#include <functional>
+#include <thread>
+#include <atomic>
+
+#include <SFML/System/Time.hpp>
+
+#include "../Threading/SpscQueue.hpp"
+
+namespace swift
+{
+	class SoundPlayer;
+	class MusicPlayer;
+	
+	// runs the sound and music players on a thread of their own. What's asked of them is posted to it as commands,
+	// and it updates them between commands, so the game thread never waits on them.
+	// Without the thread running, the players are used and updated straight from whoever calls them
+	class AudioService
+	{
+		public:
+			using Command = std::function<void()>;
+			
+			AudioService(SoundPlayer& sp, MusicPlayer& mp);
+			~AudioService();
+			
+			AudioService(const AudioService&) = delete;
+			AudioService& operator=(const AudioService&) = delete;
+			
+			void start();
+			void stop();
+			
+			// the thread is running, and this isn't it. The players post what they're asked to do then
+			bool isElsewhere() const;
+			
+			// runs c on the audio thread, after what was posted before. False, without running it, if the thread
+			// isn't elsewhere. Only one thread posts at a time
+			bool post(Command c);
+			
+		private:
+			// how long the thread waits between updating the players
+			static const sf::Time UpdateInterval;
+			static const std::size_t QueueSize = 1024;
+			
+			void run();
+			
+			SoundPlayer& soundPlayer;
+			MusicPlayer& musicPlayer;
+			
+			SpscQueue<Command> commands;
+			
+			std::thread thread;
+			std::atomic<bool> running;
+			
+			static thread_local bool onThread;
+	};
+}
+
+#endif // AUDIOSERVICE_HPP
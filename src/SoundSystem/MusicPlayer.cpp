@@ -1,76 +1,243 @@
 #include "MusicPlayer.hpp"
 
+#include <chrono>
+
+#include "../Memory/MemoryTracker.hpp"
+
 namespace swift
 {
-	MusicPlayer::MusicPlayer()
-		:	activeTrack(0),
-		    volume(100)
+	const sf::Time MusicPlayer::PrefetchLead = sf::seconds(5);
+
+	MusicPlayer::MusicPlayer(AssetManager& am)
+		:	assets(am),
+			playing(false),
+		    volume(100),
+			crossfade(sf::seconds(2)),
+			service(nullptr)
+	{
+		// current and outgoing, or current and next
+		SoundsLimit::total += 2;
+	}
+
+	MusicPlayer::~MusicPlayer()
+	{
+		// waits for a song still opening
+		if(next.valid())
+			next.wait();
+
+		SoundsLimit::total -= 2;
+	}
+
+	void MusicPlayer::setService(AudioService* s)
 	{
+		service = s;
 	}
 
 	void MusicPlayer::update()
 	{
-		if(musics.size() > 0)
+		SWIFT_MEMORY_SCOPE(Audio);
+
+		// its own thread updates it
+		if(service && service->isElsewhere())
+			return;
+
+		sf::Time elapsed = clock.restart();
+
+		if(!playing || tracks.empty())
+			return;
+
+		if(!current)
 		{
-			if(musics[activeTrack]->getStatus() == sf::Music::Status::Stopped && musics.size() != 0)
-			{
-				activeTrack++;
+			if(!next.valid())
+				prefetch(0);
+
+			std::unique_ptr<Stream> stream = takePrefetched();
+
+			if(stream)
+				start(std::move(stream));
+
+			return;
+		}
 
-				if(activeTrack >= musics.size())
-					activeTrack = 0;
+		if(outgoing)
+		{
+			faded += elapsed;
 
-				musics[activeTrack]->play();
+			if(faded >= crossfade)
+			{
+				outgoing.reset();
+				current->music.setVolume(volume);
+			}
+			else
+			{
+				float t = faded.asSeconds() / crossfade.asSeconds();
+				current->music.setVolume(volume * t);
+				outgoing->music.setVolume(volume * (1 - t));
 			}
 		}
+
+		if(tracks[current->track].loop)
+			return;
+
+		bool done = current->music.getStatus() == sf::Music::Status::Stopped;
+		sf::Time left = current->music.getDuration() - current->music.getPlayingOffset();
+
+		// one fading out and one opening would be three open
+		if(!outgoing && !next.valid() && (done || left <= crossfade + PrefetchLead))
+			prefetch((current->track + 1) % tracks.size());
+
+		if(done || left <= crossfade)
+		{
+			std::unique_ptr<Stream> stream = takePrefetched();
+
+			if(stream)
+				start(std::move(stream));
+		}
 	}
 
 	void MusicPlayer::play()
 	{
-		if(musics[activeTrack]->getStatus() != sf::Music::Status::Playing && musics.size() != 0)
-			musics[activeTrack]->play();
+		if(service && service->post([this]() { play(); }))
+			return;
+
+		playing = true;
+		clock.restart();
+
+		if(current && current->music.getStatus() == sf::Music::Status::Paused)
+			current->music.play();
+
+		if(outgoing && outgoing->music.getStatus() == sf::Music::Status::Paused)
+			outgoing->music.play();
 	}
 
 	void MusicPlayer::pause()
 	{
-		if(musics.size() != 0)
-			musics[activeTrack]->pause();
+		if(service && service->post([this]() { pause(); }))
+			return;
+
+		playing = false;
+
+		if(current)
+			current->music.pause();
+
+		if(outgoing)
+			outgoing->music.pause();
 	}
 
 	void MusicPlayer::stop()
 	{
-		if(musics.size() != 0)
-		{
-			musics[activeTrack]->stop();
-			activeTrack = 0;
+		if(service && service->post([this]() { stop(); }))
+			return;
 
-			SoundsLimit::total -= musics.size();
+		playing = false;
 
-			musics.clear();
-		}
+		current.reset();
+		outgoing.reset();
+
+		// a song that's opening is waited for, it can't be cancelled
+		if(next.valid())
+			next.get();
+
+		tracks.clear();
 	}
 
 	void MusicPlayer::setVolume(float v)
 	{
-		for(auto& m : musics)
-		{
-			m->setVolume(v);
-		}
+		if(service && service->post([this, v]() { setVolume(v); }))
+			return;
 
 		volume = v;
+
+		// fading ones get theirs on the next update
+		if(current && !outgoing)
+			current->music.setVolume(v);
 	}
 
-	bool MusicPlayer::newTrack(sf::Music& m, bool loop)
+	bool MusicPlayer::newTrack(const std::string& file, bool loop)
 	{
-		if(SoundsLimit::total + 1 > SoundsLimit::limit)
-			return false;
+		SWIFT_MEMORY_SCOPE(Audio);
+
+		Track track;
+		track.loop = loop;
 
-		musics.emplace_back(&m);
-		musics.back()->setLoop(loop);
-		musics.back()->setVolume(volume);
-		musics.back()->setRelativeToListener(true);
+		// the assets are the game thread's
+		if(!assets.findSong(file, track.source))
+			return false;
 
-		SoundsLimit::total++;
+		if(!service || !service->post([this, track]() { tracks.push_back(track); }))
+			tracks.push_back(track);
 
 		return true;
 	}
+
+	void MusicPlayer::setCrossfade(sf::Time t)
+	{
+		if(service && service->post([this, t]() { setCrossfade(t); }))
+			return;
+
+		crossfade = t;
+	}
+
+	void MusicPlayer::prefetch(std::size_t track)
+	{
+		SWIFT_MEMORY_SCOPE(Audio);
+
+		AssetManager::SongSource source = tracks[track].source;
+		bool loop = tracks[track].loop;
+
+		next = std::async(std::launch::async, [source, loop, track]() -> std::unique_ptr<Stream>
+		{
+			std::unique_ptr<Stream> stream(new Stream());
+			stream->track = track;
+			stream->opened = AssetManager::openSong(source, stream->music, stream->data);
+
+			if(!stream->opened)
+				return stream;
+
+			stream->music.setLoop(loop);
+			stream->music.setRelativeToListener(true);
+			stream->music.setVolume(0);
+
+			return stream;
+		});
+	}
+
+	std::unique_ptr<MusicPlayer::Stream> MusicPlayer::takePrefetched()
+	{
+		if(!next.valid() || next.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return nullptr;
+
+		std::unique_ptr<Stream> stream = next.get();
+
+		if(stream->opened)
+			return stream;
+
+		// not tried again, the rest of the list keeps playing
+		SWIFT_WARNING(Audio, "Unable to open " << tracks[stream->track].source.file << " as a music file.\n");
+
+		tracks.erase(tracks.begin() + stream->track);
+
+		for(Stream* s : {current.get(), outgoing.get()})
+		{
+			if(s && s->track > stream->track)
+				s->track--;
+		}
+
+		return nullptr;
+	}
+
+	void MusicPlayer::start(std::unique_ptr<Stream> stream)
+	{
+		// one that's done needs no fading out
+		if(current && current->music.getStatus() != sf::Music::Status::Stopped && crossfade > sf::Time::Zero)
+		{
+			outgoing = std::move(current);
+			faded = sf::Time::Zero;
+		}
+		else
+			stream->music.setVolume(volume);
+
+		current = std::move(stream);
+		current->music.play();
+	}
 }
@@ -4,16 +4,31 @@
 #include "SoundsLimit.hpp"
 
 #include <vector>
+#include <string>
+#include <memory>
+#include <future>
 
 #include <SFML/Audio/Music.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include "../ResourceManager/AssetManager.hpp"
+
+#include "AudioService.hpp"
 
 namespace swift
 {
+	// plays a list of songs, one after another, fading each into the next. Songs are only opened once they're
+	// about to play, on another thread, so the game doesn't wait on files or decoders. At most two are open at once
 	class MusicPlayer : public SoundsLimit
 	{
 		public:
-			MusicPlayer();
+			explicit MusicPlayer(AssetManager& am);
+			~MusicPlayer();
 			
+			// with a service running, what the player is asked is done on its thread, which also updates it
+			void setService(AudioService* s);
+			
+			// fades, and starts the next song when it's time
 			void update();
 			
 			void play();
@@ -21,12 +36,57 @@ namespace swift
 			void stop();
 			void setVolume(float v);
 			
-			bool newTrack(sf::Music& m, bool loop = false);
+			// adds the song file to the end of the list. A looping song plays until it's stopped.
+			// Returns false if there's no such song
+			bool newTrack(const std::string& file, bool loop = false);
+			
+			// how long one song fades into the next, 0 to start the next once the last is done
+			void setCrossfade(sf::Time t);
 
 		private:
-			std::vector<sf::Music*> musics;
-			unsigned activeTrack;
+			struct Track
+			{
+				AssetManager::SongSource source;
+				bool loop;
+			};
+			
+			struct Stream
+			{
+				sf::Music music;
+				std::vector<std::uint8_t> data;	// what music streams from, if it's a copy
+				std::size_t track;
+				bool opened;
+			};
+			
+			// how long before a song starts it's opened
+			static const sf::Time PrefetchLead;
+			
+			// starts opening tracks[track]
+			void prefetch(std::size_t track);
+			
+			// the prefetched stream, if it's done opening. nullptr if it isn't, or couldn't be opened,
+			// in which case its track is taken off the list
+			std::unique_ptr<Stream> takePrefetched();
+			
+			// makes stream current, fading it in over what was
+			void start(std::unique_ptr<Stream> stream);
+			
+			AssetManager& assets;
+			
+			std::vector<Track> tracks;
+			
+			std::unique_ptr<Stream> current;
+			std::unique_ptr<Stream> outgoing;	// fading out
+			std::future<std::unique_ptr<Stream>> next;
+			
+			bool playing;
 			float volume;
+			
+			sf::Time crossfade;
+			sf::Time faded;		// so far, of outgoing into current
+			sf::Clock clock;	// since the last update
+			
+			AudioService* service;
 	};
 }
 
@@ -1,38 +1,97 @@
 #include "SoundPlayer.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include "../Memory/MemoryTracker.hpp"
+
 namespace swift
 {
-	SoundPlayer::SoundPlayer()
-		:	volume(100)
+	SoundPlayer::SoundPlayer(unsigned v)
+		:	playingCount(0),
+			volume(100),
+			audibleDistance(0),
+			stolen(0),
+			dropped(0),
+			service(nullptr)
+	{
+		// leaves the rest of the limit to music
+		v = std::min(v, SoundsLimit::limit - std::min(SoundsLimit::total, SoundsLimit::limit));
+		
+		voiceCount = v;
+		enabled = true;
+		freeVoices.reserve(v);
+		playing.reserve(v);
+		
+		// taken from the back, so the first voices are used first
+		for(std::size_t i = v; i > 0; i--)
+			freeVoices.push_back(i - 1);
+		
+		SoundsLimit::total += v;
+	}
+	
+	SoundPlayer::~SoundPlayer()
+	{
+		SoundsLimit::total -= voiceCount;
+	}
+
+	void SoundPlayer::setService(AudioService* s)
 	{
+		service = s;
 	}
 
 	void SoundPlayer::update()
 	{
-		for(auto it = sounds.begin(); it != sounds.end();)
+		SWIFT_MEMORY_SCOPE(Audio);
+		
+		// its own thread updates it
+		if(service && service->isElsewhere())
+			return;
+		
+		for(std::size_t i = 0; i < playing.size();)
 		{
-			if(it->getStatus() == sf::Sound::Status::Stopped)
+			Voice& voice = voices[playing[i]];
+			
+			if(voice.sound.getStatus() == sf::Sound::Status::Stopped)
 			{
-				it->stop();
-				it = sounds.erase(it);
-				SoundsLimit::total--;
+				// the buffer may be unloaded once the sound's done with it
+				voice.sound.resetBuffer();
+				
+				freeVoices.push_back(playing[i]);
+				playing[i] = playing.back();
+				playing.pop_back();
 			}
 			else
 			{
-				it++;
+				i++;
 			}
 		}
+		
+		playingCount = playing.size();
 	}
 	
 	void SoundPlayer::setListenerPosition(const sf::Vector3f& pos)
 	{
+		listener = pos;
+		
+		if(!enabled)
+			return;
+		
+		if(service && service->post([pos]() { sf::Listener::setPosition(pos); }))
+			return;
+		
 		sf::Listener::setPosition(pos);
 	}
 
 	void SoundPlayer::play()
 	{
-		for(auto& s : sounds)
+		if(service && service->post([this]() { play(); }))
+			return;
+		
+		for(auto& p : playing)
 		{
+			sf::Sound& s = voices[p].sound;
+			
 			if(s.getStatus() != sf::Sound::Status::Playing)
 			{
 				s.play();
@@ -42,46 +101,183 @@ namespace swift
 	
 	void SoundPlayer::pause()
 	{
-		for(auto& s : sounds)
+		if(service && service->post([this]() { pause(); }))
+			return;
+		
+		for(auto& p : playing)
 		{
-			s.pause();
+			voices[p].sound.pause();
 		}
 	}
 	
 	void SoundPlayer::stop()
 	{
-		for(auto& s : sounds)
+		if(service && service->post([this]() { stop(); }))
+			return;
+		
+		for(auto& p : playing)
 		{
-			s.stop();
+			voices[p].sound.stop();
+			voices[p].sound.resetBuffer();
+			freeVoices.push_back(p);
 		}
-			
-		SoundsLimit::total -= sounds.size();
 		
-		sounds.clear();
+		playing.clear();
+		playingCount = 0;
 	}
 	
 	void SoundPlayer::setVolume(float v)
 	{
-		for(auto& s : sounds)
+		if(service && service->post([this, v]() { setVolume(v); }))
+			return;
+		
+		for(auto& p : playing)
 		{
-			s.setVolume(v);
+			voices[p].sound.setVolume(std::min(v * voices[p].gain, 100.f));
 		}
 		
 		volume = v;
 	}
 
-	bool SoundPlayer::newSound(const sf::SoundBuffer& sb, const sf::Vector3f& pos, bool loop)
+	bool SoundPlayer::newSound(const sf::SoundBuffer& sb, const sf::Vector3f& pos, bool loop, int priority, float gain)
 	{
-		if(SoundsLimit::total + 1 > SoundsLimit::limit)
+		SWIFT_MEMORY_SCOPE(Audio);
+		
+		if(!enabled)
 			return false;
 		
-		sounds.emplace_back(sb);
-		sounds.back().setPosition(pos);
-		sounds.back().setLoop(loop);
-		sounds.back().setVolume(100);
+		const sf::SoundBuffer* buffer = &sb;
+		
+		// whether it got a voice isn't known yet
+		if(service && service->post([this, buffer, pos, loop, priority, gain]() { newSound(*buffer, pos, loop, priority, gain); }))
+			return true;
+		
+		if(voices.size() != voiceCount)
+			voices.resize(voiceCount, {sf::Sound(), 0, 1});
+		
+		std::size_t v;
+		
+		if(!freeVoices.empty())
+		{
+			v = freeVoices.back();
+			freeVoices.pop_back();
+			playing.push_back(v);
+			playingCount = playing.size();
+		}
+		else
+		{
+			// it keeps its place in playing
+			v = findStealable(pos, priority);
+			
+			if(v == voices.size())
+			{
+				dropped++;
+				return false;
+			}
+			
+			voices[v].sound.stop();
+			stolen++;
+		}
 		
-		SoundsLimit::total++;
+		Voice& voice = voices[v];
+		voice.priority = priority;
+		voice.gain = gain;
+		voice.sound.setBuffer(sb);
+		voice.sound.setPosition(pos);
+		voice.sound.setLoop(loop);
+		voice.sound.setVolume(std::min(volume * gain, 100.f));
+		voice.sound.play();
 		
 		return true;
 	}
+	
+	void SoundPlayer::setEnabled(bool e)
+	{
+		enabled = e;
+		
+		if(!enabled)
+			stop();
+	}
+	
+	bool SoundPlayer::isEnabled() const
+	{
+		return enabled;
+	}
+	
+	void SoundPlayer::setAudibleDistance(float d)
+	{
+		audibleDistance = d;
+	}
+	
+	bool SoundPlayer::isAudible(const sf::Vector3f& pos) const
+	{
+		if(!enabled)
+			return false;
+		
+		if(audibleDistance <= 0)
+			return true;
+		
+		sf::Vector3f d = pos - listener;
+		return d.x * d.x + d.y * d.y + d.z * d.z <= audibleDistance * audibleDistance;
+	}
+	
+	float SoundPlayer::getAttenuation(const sf::Vector3f& pos) const
+	{
+		sf::Vector3f d = pos - listener;
+		float distance = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+		
+		// minimum distance 1, attenuation 1: minDistance / (minDistance + attenuation * (distance - minDistance))
+		return distance > 1 ? 1 / distance : 1;
+	}
+	
+	std::size_t SoundPlayer::getVoiceCount() const
+	{
+		return voiceCount;
+	}
+	
+	std::size_t SoundPlayer::getPlayingCount() const
+	{
+		return playingCount;
+	}
+	
+	unsigned SoundPlayer::getStolen() const
+	{
+		return stolen;
+	}
+	
+	unsigned SoundPlayer::getDropped() const
+	{
+		return dropped;
+	}
+	
+	std::size_t SoundPlayer::findStealable(const sf::Vector3f& pos, int priority) const
+	{
+		sf::Vector3f listener = sf::Listener::getPosition();
+		
+		auto distance = [&listener](const sf::Vector3f& p)
+		{
+			sf::Vector3f d = p - listener;
+			return d.x * d.x + d.y * d.y + d.z * d.z;
+		};
+		
+		// the new sound is a candidate too, it loses ties so what's playing isn't cut off for nothing
+		std::size_t best = voices.size();
+		int bestPriority = priority;
+		float bestDistance = distance(pos);
+		
+		for(auto& p : playing)
+		{
+			const Voice& voice = voices[p];
+			float d = distance(voice.sound.getPosition());
+			
+			if(voice.priority < bestPriority || (voice.priority == bestPriority && d > bestDistance))
+			{
+				best = p;
+				bestPriority = voice.priority;
+				bestDistance = d;
+			}
+		}
+		
+		return best;
+	}
 }
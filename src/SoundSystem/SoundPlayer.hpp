@@ -9,13 +9,26 @@
 
 #include <SFML/System/Vector2.hpp>
 
+#include <vector>
+#include <atomic>
+
+#include "AudioService.hpp"
+
 namespace swift
 {
+	// plays sounds on a fixed set of voices, made once. Each voice is a source to the sound device,
+	// so the voices count against the limit for as long as the player is around
 	class SoundPlayer : public SoundsLimit
 	{
 		public:
-			SoundPlayer();
+			explicit SoundPlayer(unsigned v = 128);
+			~SoundPlayer();
 			
+			// with a service running, what the player is asked is done on its thread, which also updates it.
+			// Sound buffers have to outlast the sounds playing them either way
+			void setService(AudioService* s);
+			
+			// frees the voices of sounds that are done
 			void update();
 			void setListenerPosition(const sf::Vector3f& pos);
 			
@@ -24,11 +37,63 @@ namespace swift
 			void stop();
 			void setVolume(float v);
 			
-			bool newSound(const sf::SoundBuffer& sb, const sf::Vector3f& pos, bool loop = false);
+			// plays sb at pos. With every voice busy, the sound takes the voice of the least important one playing:
+			// the lowest priority, and of those, the farthest from the listener.
+			// Returns false if every sound playing is more important than this one, which isn't played.
+			// Always true when it's posted to the service, which finds out later
+			// gain scales the volume, sounds are never louder than the full volume
+			bool newSound(const sf::SoundBuffer& sb, const sf::Vector3f& pos, bool loop = false, int priority = 0, float gain = 1);
+			
+			// turned off, nothing is played and the sound device is left alone, for running without audio. On by default
+			void setEnabled(bool e);
+			bool isEnabled() const;
+			
+			// sounds further than d from the listener are too quiet to play, 0 for no limit
+			void setAudibleDistance(float d);
+			bool isAudible(const sf::Vector3f& pos) const;
+			
+			// how much a sound at pos is turned down by its distance, 1 for none. The same as SFML does it,
+			// for sounds with its default attenuation and minimum distance
+			float getAttenuation(const sf::Vector3f& pos) const;
+			
+			std::size_t getVoiceCount() const;
+			std::size_t getPlayingCount() const;	// safe from any thread
+			
+			// sounds that took a busy voice, and sounds that didn't get one, since starting. Safe from any thread
+			unsigned getStolen() const;
+			unsigned getDropped() const;
 			
 		private:
-			std::vector<sf::Sound> sounds;
+			struct Voice
+			{
+				sf::Sound sound;
+				int priority;
+				float gain;
+			};
+			
+			// the index of the voice that sound would take, or voices.size() for none
+			std::size_t findStealable(const sf::Vector3f& pos, int priority) const;
+			
+			// made for the first sound, so a player that never plays doesn't open the sound device.
+			// never resized after that, sounds are only ever given new buffers
+			std::vector<Voice> voices;
+			std::size_t voiceCount;
+			std::atomic<bool> enabled;
+			
+			std::vector<std::size_t> freeVoices;
+			std::vector<std::size_t> playing;
+			std::atomic<std::size_t> playingCount;
+			
 			float volume;
+			float audibleDistance;
+			
+			// where the listener was last set, for checking sounds on the thread starting them
+			sf::Vector3f listener;
+			
+			std::atomic<unsigned> stolen;
+			std::atomic<unsigned> dropped;
+			
+			AudioService* service;
 	};
 }
 
@@ -2,6 +2,8 @@
 
 namespace swift
 {
+	const InputBuffer* State::input = nullptr;
+
 	State::State(sf::RenderWindow& win, AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, Settings& set, Settings& dic)
 		: 	window(win),
 			assets(am),
@@ -15,4 +17,22 @@ namespace swift
 	State::~State()
 	{
 	}
+
+	std::function<void()> State::preload()
+	{
+		return {};
+	}
+
+	void State::setInput(const InputBuffer& i)
+	{
+		input = &i;
+	}
+
+	const InputBuffer::Snapshot& State::getInput()
+	{
+		// nothing held, before there's a game
+		static const InputBuffer none;
+
+		return input ? input->getSnapshot() : none.getSnapshot();
+	}
 }
@@ -3,9 +3,12 @@
 
 #include <SFML/Graphics/RenderWindow.hpp>
 
+#include <functional>
+
 /* Input headers */
 #include "../KeyBindings/KeyboardManager.hpp"
 #include "../KeyBindings/MouseManager.hpp"
+#include "../KeyBindings/InputBuffer.hpp"
 
 namespace swift
 {
@@ -28,12 +31,20 @@ namespace swift
 				Exit
 			};
 			
+			// called on the main thread before setup. The job returned, if any, then runs on a thread of its own while
+			// a loading screen is shown, and setup is called once it's done. Jobs mustn't touch the assets or GL
+			virtual std::function<void()> preload();
+			
 			virtual void setup() = 0;
 			virtual void handleEvent(sf::Event &event) = 0;
 			virtual void update(sf::Time dt) = 0;
 			virtual void draw(float e) = 0;
 			virtual bool switchFrom() = 0;
 			virtual Type finish() = 0;
+			
+			// the game's input, as of the events of the tick being updated
+			static void setInput(const InputBuffer& i);
+			static const InputBuffer::Snapshot& getInput();
 
 		protected:
 			/* Environment */
@@ -49,6 +60,9 @@ namespace swift
 			MouseManager mouse;
 			
 			Type returnType;
+		
+		private:
+			static const InputBuffer* input;
 	};
 }
 
@@ -18,6 +18,9 @@
 /* serialization headers */
 #include <tinyxml2.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace swift
 {
 	const float EDITOR_MOVE_SPEED = 400.f;
@@ -31,6 +34,11 @@ namespace swift
 			currentMap(nullptr),
 			mapName(""),
 			mapLoaded(false),
+			tileSelected(-1),
+			brushSize(1),
+			currentLayer(0),
+			painting(false),
+			paintID(-1),
 			done(false)
 	{
 		editorView.setViewport({0, 0, (win.getSize().x - 200.f) / win.getSize().x, 1});
@@ -48,6 +56,12 @@ namespace swift
 		setupNewMapGUI();
 		setupLoadMapGUI();
 		
+		// menus only change when they're used
+		pauseMenu.setRetained(true);
+		editorCtrls.setRetained(true);
+		newMapGUI.setRetained(true);
+		loadMapGUI.setRetained(true);
+		
 		setupKeyBindings();
 		
 		activeState = &pause;
@@ -84,32 +98,48 @@ namespace swift
 		return State::Type::Exit;
 	}
 	
-	/*void Editor::addTile(const sf::Vector2i& pos)
+	void Editor::paint(const sf::Vector2i& tile, int id)
 	{
-		int tileNum = mouseToTile(pos);
+		int first = -(brushSize - 1) / 2;
 		
-		if(tileNum != -1)
-			currentMap->setTileNum(tileNum, tileSelected);
+		for(int y = first; y < first + brushSize; y++)
+		{
+			for(int x = first; x < first + brushSize; x++)
+			{
+				sf::Vector2i t = tile + sf::Vector2i(x, y);
+				
+				if(t.x >= 0 && t.y >= 0)
+					history.set(*currentMap, currentLayer, t.x, t.y, id);
+			}
+		}
 	}
 	
-	void Editor::removeTile(const sf::Vector2i& pos)
+	void Editor::paintLine(const sf::Vector2i& tile, int id)
 	{
-		int tileNum = mouseToTile(pos);
+		sf::Vector2i delta = tile - lastTile;
+		int steps = std::max(std::abs(delta.x), std::abs(delta.y));
+		
+		// a brush wide covers the gap between steps on its own
+		int stride = std::max(brushSize, 1);
 		
-		if(tileNum != -1)
-			currentMap->setTileNum(tileNum, 0);
-	}*/
+		for(int s = stride; s < steps; s += stride)
+			paint({lastTile.x + delta.x * s / steps, lastTile.y + delta.y * s / steps}, id);
+		
+		paint(tile, id);
+		lastTile = tile;
+	}
 	
-	int Editor::mouseToTile(const sf::Vector2i& pos) const	
+	bool Editor::mouseToTile(const sf::Vector2i& pos, sf::Vector2i& tile) const
 	{
 		sf::Vector2f worldPos = window.mapPixelToCoords(pos, editorView);
 		
 		sf::Vector2f worldTilePos = {std::floor(worldPos.x / currentMap->getTileSize().x), std::floor(worldPos.y / currentMap->getTileSize().y)};
 		
-		if(worldTilePos.x >= currentMap->getSize().x || worldTilePos.y >= currentMap->getSize().y)
-			return -1;
+		if(worldTilePos.x < 0 || worldTilePos.y < 0 || worldTilePos.x >= currentMap->getSize().x || worldTilePos.y >= currentMap->getSize().y)
+			return false;
 		
-		return worldTilePos.x + worldTilePos.y * currentMap->getSize().x;
+		tile = {static_cast<int>(worldTilePos.x), static_cast<int>(worldTilePos.y)};
+		return true;
 	}
 	
 	void Editor::setupSubStateFuncs()
@@ -139,6 +169,37 @@ namespace swift
 				editorView.zoom(zoom);
 			}
 			
+			// left paints the selected tile, right erases. Not through the controls on the right
+			if(e.type == sf::Event::MouseButtonPressed && e.mouseButton.x < static_cast<int>(window.getSize().x) - 200)
+			{
+				sf::Vector2i tile;
+				
+				if((e.mouseButton.button == sf::Mouse::Left && tileSelected != -1) || e.mouseButton.button == sf::Mouse::Right)
+				{
+					paintID = e.mouseButton.button == sf::Mouse::Left ? tileSelected : -1;
+					painting = true;
+					history.begin();
+					
+					if(mouseToTile({e.mouseButton.x, e.mouseButton.y}, tile))
+					{
+						paint(tile, paintID);
+						lastTile = tile;
+					}
+				}
+			}
+			else if(e.type == sf::Event::MouseMoved && painting)
+			{
+				sf::Vector2i tile;
+				
+				if(mouseToTile({e.mouseMove.x, e.mouseMove.y}, tile) && tile != lastTile)
+					paintLine(tile, paintID);
+			}
+			else if(e.type == sf::Event::MouseButtonReleased && painting)
+			{
+				painting = false;
+				history.end();
+			}
+			
 			editorCtrls.update(e);
 		});
 		
@@ -370,6 +431,7 @@ namespace swift
 					delete currentMap;
 				
 				currentMap = new TileMap();
+				history.clear();
 				
 				// set the texture of the map
 				currentMap->setTextureFile("./data/textures/" + textureText.getString());
@@ -436,6 +498,7 @@ namespace swift
 				delete currentMap;
 			
 			currentMap = new TileMap();
+			history.clear();
 			
 			loadMapText.clear();
 			
@@ -576,18 +639,32 @@ namespace swift
 			};
 		});
 		
-		// mouse controls, adding/removing tiles
-		/*mouse.newBinding("AddTile", sf::Mouse::Left, [&](const sf::Vector2i& pos)
+		// brush size
+		keyboard.newBinding("brushDown", sf::Keyboard::LBracket, [&]()
 		{
-			if(activeState == &editor)
-				if(tileSelected != -1)
-					addTile(pos);
+			brushSize = std::max(brushSize - 1, 1);
 		});
 		
-		mouse.newBinding("RemoveTile", sf::Mouse::Right, [&](const sf::Vector2i& pos)
+		keyboard.newBinding("brushUp", sf::Keyboard::RBracket, [&]()
 		{
-			if(activeState == &editor)
-				removeTile(pos);
-		});*/
+			brushSize = std::min(brushSize + 1, 64);
+		});
+		
+		// history, with either control key held
+		keyboard.newBinding("undo", sf::Keyboard::Z, [&]()
+		{
+			bool control = sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) || sf::Keyboard::isKeyPressed(sf::Keyboard::RControl);
+			
+			if(activeState == &editor && currentMap && control && !painting)
+				history.undo(*currentMap);
+		}, true);
+		
+		keyboard.newBinding("redo", sf::Keyboard::Y, [&]()
+		{
+			bool control = sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) || sf::Keyboard::isKeyPressed(sf::Keyboard::RControl);
+			
+			if(activeState == &editor && currentMap && control && !painting)
+				history.redo(*currentMap);
+		}, true);
 	}
 }
@@ -7,6 +7,7 @@
 #include "../../GUI/Window.hpp"
 
 #include "../../Mapping/TileMap.hpp"
+#include "../../Mapping/TileHistory.hpp"
 
 #include <SFML/Graphics/View.hpp>
 
@@ -26,10 +27,14 @@ namespace swift
 			virtual Type finish();
 
 		private:
-			//void addTile(const sf::Vector2i& pos);
-			//void removeTile(const sf::Vector2i& pos);
+			// sets the tiles under the brush, centered on tile, to id, -1 to erase
+			void paint(const sf::Vector2i& tile, int id);
 			
-			int mouseToTile(const sf::Vector2i& pos) const;
+			// the brush along the tiles from lastTile to tile, so fast strokes don't leave gaps
+			void paintLine(const sf::Vector2i& tile, int id);
+			
+			// false if pos isn't over the map
+			bool mouseToTile(const sf::Vector2i& pos, sf::Vector2i& tile) const;
 			
 			void setupSubStateFuncs();
 			
@@ -63,6 +68,16 @@ namespace swift
 			bool mapLoaded;
 			int tileSelected;
 			
+			// tiles on a side of the square brush, changed with [ and ]
+			int brushSize;
+			unsigned currentLayer;
+			bool painting;			// while a mouse button is held over the map
+			int paintID;			// what the held button paints
+			sf::Vector2i lastTile;	// painted last in the stroke
+			
+			// strokes, for undoing with ctrl z and redoing with ctrl y
+			TileHistory history;
+			
 			bool done;
 	};
 }
@@ -0,0 +1,86 @@
+#include "Loading.hpp"
+
+#include "../../Settings/Settings.hpp"
+
+namespace swift
+{
+	Loading::Loading(sf::RenderWindow& win, AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, Settings& set, Settings& dic,
+					const sf::Font& font, State* n, Type type, const std::function<void()>& job)
+		:	State(win, am, sp, mp, set, dic),
+			next(n),
+			done(false),
+			label("Loading"),
+			elapsed(0)
+	{
+		returnType = type;
+		
+		text.setFont(font);
+		text.setCharacterSize(30);
+		text.setColor(sf::Color::White);
+		
+		dictionary.get("loading", label);
+		text.setString(label + "...");
+		
+		// placed with the dots, so it doesn't move as they change
+		sf::FloatRect bounds = text.getLocalBounds();
+		text.setPosition(static_cast<float>(win.getSize().x) / 2 - bounds.width / 2, static_cast<float>(win.getSize().y) / 2 - bounds.height / 2);
+		text.setString(label);
+		
+		thread = std::thread([this, job]()
+		{
+			job();
+			done = true;
+		});
+	}
+	
+	Loading::~Loading()
+	{
+		if(thread.joinable())
+			thread.join();
+		
+		delete next;
+	}
+	
+	void Loading::setup()
+	{
+	}
+	
+	void Loading::handleEvent(sf::Event&)
+	{
+	}
+	
+	void Loading::update(sf::Time dt)
+	{
+		elapsed += dt.asSeconds();
+	}
+	
+	void Loading::draw(float)
+	{
+		std::size_t dots = static_cast<std::size_t>(elapsed * 2) % 4;
+		text.setString(label + std::string(dots, '.'));
+		
+		window.setView(window.getDefaultView());
+		window.draw(text);
+	}
+	
+	bool Loading::switchFrom()
+	{
+		return done;
+	}
+	
+	State::Type Loading::finish()
+	{
+		return returnType;
+	}
+	
+	State* Loading::take()
+	{
+		if(thread.joinable())
+			thread.join();
+		
+		State* state = next;
+		next = nullptr;
+		
+		return state;
+	}
+}
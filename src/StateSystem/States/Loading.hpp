@@ -0,0 +1,47 @@
+#ifndef LOADING_HPP
+#define LOADING_HPP
+
+#include "../State.hpp"
+
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Font.hpp>
+
+#include <string>
+#include <atomic>
+#include <thread>
+
+namespace swift
+{
+	// shown while the job of next's preload runs on a thread of its own. Keeps drawing, and the game keeps
+	// ticking, so the window never freezes. Done once the job returns, next is then handed over by take.
+	// type is what next was made as, what finish gives, as next isn't set up to be asked
+	class Loading : public State
+	{
+		public:
+			Loading(sf::RenderWindow& win, AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, Settings& set, Settings& dic,
+					const sf::Font& font, State* next, Type type, const std::function<void()>& job);
+			virtual ~Loading();
+
+			virtual void setup();
+			virtual void handleEvent(sf::Event& event);
+			virtual void update(sf::Time dt);
+			virtual void draw(float e);
+			virtual bool switchFrom();
+			virtual Type finish();
+
+			// waits for the job, and gives up the state it was preloading, to be set up
+			State* take();
+
+		private:
+			State* next;
+
+			std::thread thread;
+			std::atomic<bool> done;
+
+			sf::Text text;
+			std::string label;	// "loading" of the dictionary
+			float elapsed;		// seconds, for the dots
+	};
+}
+
+#endif // LOADING_HPP
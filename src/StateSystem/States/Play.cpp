@@ -23,9 +23,25 @@ namespace swift
 		activeWorld(nullptr),
 		player(nullptr),
 		playView({0, 0, static_cast<float>(win.getSize().x), static_cast<float>(win.getSize().y)}),
-		currentZoom(1.f)
+		currentZoom(1.f),
+		preloaded(nullptr),
+		preloadedMapResult(false),
+		preloadedSaveResult(false),
+		suspendedBudget(64),
+		suspendedTickRate(0),
+		suspendedTickBudget(sf::Time::Zero)
 	{
 		returnType = State::Type::Play;
+		
+		unsigned megabytes = suspendedBudget;
+		settings.get("worldCache", megabytes);
+		suspendedBudget = static_cast<std::size_t>(megabytes) * 1024 * 1024;
+		
+		settings.get("suspendedTps", suspendedTickRate);
+		
+		unsigned milliseconds = 0;
+		settings.get("suspendedBudget", milliseconds);
+		suspendedTickBudget = sf::milliseconds(milliseconds);
 	}
 
 	Play::~Play()
@@ -39,11 +55,39 @@ namespace swift
 		
 		for(auto& w : worlds)
 			delete w.second;
+		
+		delete preloaded;
 
 		for(auto& s : scripts)
 			removeScript(s.first);
 	}
 
+	std::function<void()> Play::preload()
+	{
+		std::ifstream fin("./data/saves/currentWorld");
+		
+		std::string worldName;
+		std::getline(fin, worldName);
+		std::getline(fin, preloadedMap);
+		
+		if(worldName.empty())
+			return {};
+		
+		// decoding starts now, and is stored by the asset manager's updates while the loading screen ticks
+		assets.prefetchManifest("./data/manifests/" + worldName + ".manifest");
+		
+		preloaded = new World(worldName, assets, soundPlayer, musicPlayer, {});
+		World* world = preloaded;
+		const std::string map = preloadedMap;
+		
+		// textures, sprites, and scripts are left to changeWorld, on this thread
+		return [this, world, map]()
+		{
+			preloadedMapResult = world->tilemap.loadFile(map);
+			preloadedSaveResult = preloadedMapResult && world->readSave();
+		};
+	}
+	
 	bool Play::switchFrom()
 	{
 		return returnType != State::Type::Play;
@@ -76,7 +120,7 @@ namespace swift
 		if(scripts.find(scriptFile) != scripts.end())
 		{
 			if(!scripts[scriptFile]->save("./data/saves/" + scriptFile.substr(scriptFile.find_last_of('/') + 1) + ".script"))
-				log << "[WARNING]: Could not save script: " << scriptFile << "!\n";
+				SWIFT_WARNING(World, "Could not save script: " << scriptFile << "!\n");
 			scripts[scriptFile]->reset();
 			scripts.erase(scriptFile);
 			return true;
@@ -87,22 +131,86 @@ namespace swift
 
 	void Play::changeWorld(const std::string& name, const std::string& mapFile)
 	{
-		worlds.emplace(name, new World(name, assets, soundPlayer, musicPlayer, {}));
-		World* newWorld = worlds[name];
+		if(activeWorld && activeWorld->getName() == name)
+			return;
+		
+		// a suspended world is picked up as it was left
+		auto cached = worlds.find(name);
+		
+		if(cached != worlds.end())
+		{
+			World* newWorld = cached->second;
+			resume(newWorld);
+			
+			if(activeWorld)
+			{
+				Entity* newPlayer = newWorld->addEntity();
+				*newPlayer = *player;
+				
+				activeWorld->removeEntity(player->getHandle());
+				player = newPlayer;
+				
+				// saved now, in case it's deleted from the cache without being entered again
+				activeWorld->save();
+				suspend(activeWorld);
+			}
+			
+			activeWorld = newWorld;
+			Script::setWorld(*activeWorld);
+			buildMinimap();
+			
+			trimSuspended();
+			return;
+		}
+		
+		// read by preload already, only the textures and sprites are left
+		bool wasPreloaded = preloaded && preloaded->getName() == name && preloadedMap == mapFile;
+		World* newWorld = nullptr;
+		bool mapResult = false;
+		
+		if(wasPreloaded)
+		{
+			newWorld = preloaded;
+			preloaded = nullptr;
+			worlds.emplace(name, newWorld);
+			mapResult = preloadedMapResult;
+		}
+		else
+		{
+			// what the world uses, starting to decode while its map loads. Only does anything with lazy assets
+			assets.prefetchManifest("./data/manifests/" + name + ".manifest");
+			
+			worlds.emplace(name, new World(name, assets, soundPlayer, musicPlayer, {}));
+			newWorld = worlds[name];
 
-		// setup world
-		bool mapResult = newWorld->tilemap.loadFile(mapFile);
-		bool textureResult = newWorld->tilemap.loadTexture(*assets.getTexture(newWorld->tilemap.getTextureFile()));
+			// setup world
+			mapResult = newWorld->tilemap.loadFile(mapFile);
+		}
+		
+		auto loadSave = [&]()
+		{
+			return wasPreloaded ? preloadedSaveResult && newWorld->bindSave() : newWorld->load();
+		};
+		
+		// one per tileset, packed together by the tilemap
+		std::vector<const sf::Texture*> textures;
+		
+		for(auto& t : newWorld->tilemap.getTextureFiles())
+			textures.push_back(assets.getTexture(t));
+		
+		bool textureResult = mapResult && newWorld->tilemap.loadTextures(textures);
 
 		if(!mapResult)
-			log << "[ERROR]: Loading tilemap \"" << mapFile << "\" failed.\n";
+			SWIFT_ERROR(World, "Loading tilemap \"" << mapFile << "\" failed.\n");
 
 		if(!textureResult)
-			log << "[ERROR]: Setting texture for \"" << mapFile << "\" failed.\n";
+			SWIFT_ERROR(World, "Setting texture for \"" << mapFile << "\" failed.\n");
 
 		if(!mapResult || !textureResult)
 		{
-			worlds.erase(name);	// undo what we did and exit since loading the world failed
+			// undo what we did and exit since loading the world failed
+			delete newWorld;
+			worlds.erase(name);
 			return;
 		}
 
@@ -112,28 +220,27 @@ namespace swift
 			// copy over play from current world to new world
 			Entity* newPlayer = newWorld->addEntity();
 			*newPlayer = *player;
-			player = newPlayer;
 
-			activeWorld->removeEntity(0);	// delete player from current world
+			activeWorld->removeEntity(player->getHandle());	// delete player from current world
+			player = newPlayer;
 
-			// delete old world
-			std::string oldWorld = activeWorld->getName();
-			delete activeWorld;
-			worlds.erase(oldWorld);
+			// keep the old world around, saved in case it's deleted from the cache without being entered again
+			activeWorld->save();
+			suspend(activeWorld);
 
 			// load the world's save file
-			bool loadResult = newWorld->load();
+			bool loadResult = loadSave();
 			
 			if(!loadResult)
-				log << "[WARNING]: Loading World data for world: \"" << name << "\" failed.\n";
+				SWIFT_WARNING(World, "Loading World data for world: \"" << name << "\" failed.\n");
 		}
 		else
 		{
 			// load the world's save file
-			bool loadResult = newWorld->load();
+			bool loadResult = loadSave();
 			
 			if(!loadResult)
-				log << "[WARNING]: Loading World data for world: \"" << name << "\" failed.\n";
+				SWIFT_WARNING(World, "Loading World data for world: \"" << name << "\" failed.\n");
 			
 			for(auto& e : newWorld->getEntities())
 			{
@@ -147,6 +254,18 @@ namespace swift
 
 		activeWorld = newWorld;
 		Script::setWorld(*activeWorld);
+		buildMinimap();
+		
+		trimSuspended();
+	}
+	
+	void Play::buildMinimap()
+	{
+		bool enabled = false;
+		settings.get("minimap", enabled);
+		
+		if(!enabled || !minimap.build(activeWorld->tilemap))
+			minimap.clear();
 	}
 	
 	void Play::loadLastWorld()
@@ -167,6 +286,59 @@ namespace swift
 		Script::setWorld(*activeWorld);
 	}
 	
+	void Play::updateSuspended(float dt)
+	{
+		if(neighbors)
+			neighbors->update(dt);
+	}
+	
+	void Play::suspend(World* world)
+	{
+		suspended.push_front(world);
+		
+		if(suspendedTickRate <= 0)
+			return;
+		
+		// a worker per hardware thread, or as many as the setting says
+		if(!neighbors)
+		{
+			unsigned threads = 0;
+			settings.get("worldThreads", threads);
+			neighbors.reset(new WorldScheduler(threads));
+		}
+		
+		neighbors->add(*world, suspendedTickRate);
+		neighbors->setBudget(*world, suspendedTickBudget);
+	}
+	
+	void Play::resume(World* world)
+	{
+		suspended.remove(world);
+		
+		if(neighbors)
+			neighbors->remove(*world);
+	}
+	
+	void Play::trimSuspended()
+	{
+		std::size_t memory = 0;
+		
+		for(auto& w : suspended)
+			memory += w->getMemory();
+		
+		while(!suspended.empty() && memory > suspendedBudget)
+		{
+			World* oldest = suspended.back();
+			resume(oldest);
+			
+			memory -= oldest->getMemory();
+			
+			// saves itself
+			worlds.erase(oldest->getName());
+			delete oldest;
+		}
+	}
+	
 	void Play::updateScripts()
 	{
 		std::vector<std::string> doneScripts;
@@ -6,12 +6,16 @@
 #include "../SubState.hpp"
 
 #include <vector>
+#include <list>
+#include <memory>
 
 /* GUI headers */
 #include "../../GUI/Window.hpp"
 
 /* World headers */
 #include "../../World/World.hpp"
+#include "../../World/Minimap.hpp"
+#include "../../World/WorldScheduler.hpp"
 
 /* Scripting */
 #include "../../Scripting/Script.hpp"
@@ -24,6 +28,9 @@ namespace swift
 			Play(sf::RenderWindow& win, AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, Settings& set, Settings& dic);
 			virtual ~Play();
 
+			// the last world's map and save are read in the background, for loadLastWorld to pick up
+			virtual std::function<void()> preload();
+			
 			virtual void setup() = 0;
 			virtual void handleEvent(sf::Event& event) = 0;
 			virtual void update(sf::Time dt) = 0;
@@ -36,6 +43,8 @@ namespace swift
 			bool addScript(const std::string& scriptFile);
 			bool removeScript(const std::string& scriptFile);
 
+			// worlds left are kept suspended, so going back to them doesn't load them again. Once suspended worlds take
+			// more than the "worldCache" setting's megabytes, the least recently left are saved and deleted
 			void changeWorld(const std::string& name, const std::string& mapFile);
 
 		protected:
@@ -45,6 +54,11 @@ namespace swift
 			
 			void loadLastWorld();
 			void updateScripts();
+			
+			// updates suspended worlds at the "suspendedTps" setting's rate, if it's above 0, each on a worker of its own
+			// while there are enough of them. They don't tick otherwise. "suspendedBudget" is the milliseconds each may
+			// take an update, past which it drops ticks, 0 for no limit
+			void updateSuspended(float dt);
 
 			// SubState system
 			SubState* activeState;
@@ -57,10 +71,35 @@ namespace swift
 			
 			sf::View playView;
 			float currentZoom;
+			
+			// of the active world, built as it's entered if the "minimap" setting is on. Updated and drawn by the game
+			Minimap minimap;
 
 		private:
 			std::map<std::string, World*> worlds;
 			std::map<std::string, Script*> scripts;
+			
+			// deletes the least recently left worlds until the rest fit in the budget
+			void trimSuspended();
+			
+			// for the world just entered
+			void buildMinimap();
+			
+			// what preload read the last world into, until changeWorld enters it
+			World* preloaded;
+			std::string preloadedMap;
+			bool preloadedMapResult;
+			bool preloadedSaveResult;
+			
+			// ticks the suspended worlds, made once there are some to tick
+			void suspend(World* world);
+			void resume(World* world);
+			
+			std::list<World*> suspended;	// most recently left first
+			std::size_t suspendedBudget;	// bytes
+			float suspendedTickRate;
+			sf::Time suspendedTickBudget;
+			std::unique_ptr<WorldScheduler> neighbors;
 	};
 }
 
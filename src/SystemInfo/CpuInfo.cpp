@@ -0,0 +1,311 @@
+#include "CpuInfo.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define SWIFT_CPU_X86
+	
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#include <immintrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <vector>
+#endif
+
+namespace
+{
+	using namespace swift;
+
+#ifdef SWIFT_CPU_X86
+	void cpuid(unsigned leaf, unsigned sub, unsigned regs[4])
+	{
+		#ifdef _MSC_VER
+			int r[4];
+			__cpuidex(r, static_cast<int>(leaf), static_cast<int>(sub));
+			
+			for(int i = 0; i < 4; i++)
+				regs[i] = static_cast<unsigned>(r[i]);
+		#else
+			__cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+		#endif
+	}
+	
+	// which register states the OS saves on a switch. Without them, wide registers can't be used even if the CPU has them
+	unsigned long long xgetbv()
+	{
+		#ifdef _MSC_VER
+			return _xgetbv(0);
+		#else
+			unsigned eax, edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			return (static_cast<unsigned long long>(edx) << 32) | eax;
+		#endif
+	}
+	
+	void readFeatures(CpuInfo& info)
+	{
+		unsigned regs[4];
+		cpuid(0, 0, regs);
+		unsigned maxLeaf = regs[0];
+		
+		if(maxLeaf < 1)
+			return;
+		
+		cpuid(1, 0, regs);
+		info.sse2 = (regs[3] & (1u << 26)) != 0;
+		info.sse41 = (regs[2] & (1u << 19)) != 0;
+		info.sse42 = (regs[2] & (1u << 20)) != 0;
+		
+		bool xsave = (regs[2] & (1u << 27)) != 0;
+		unsigned long long saved = xsave ? xgetbv() : 0;
+		
+		// xmm and ymm, then opmask and the upper zmm halves
+		bool ymm = (saved & 0x6) == 0x6;
+		bool zmm = (saved & 0xe6) == 0xe6;
+		
+		info.avx = ymm && (regs[2] & (1u << 28)) != 0;
+		info.fma = info.avx && (regs[2] & (1u << 12)) != 0;
+		
+		if(maxLeaf < 7)
+			return;
+		
+		cpuid(7, 0, regs);
+		info.avx2 = info.avx && (regs[1] & (1u << 5)) != 0;
+		info.avx512f = zmm && (regs[1] & (1u << 16)) != 0;
+	}
+#else
+	void readFeatures(CpuInfo& info)
+	{
+		#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+			info.neon = true;
+		#else
+			(void)info;
+		#endif
+	}
+#endif
+
+#ifdef __linux__
+	// "48K" and the like
+	unsigned parseSize(const std::string& text)
+	{
+		std::istringstream in(text);
+		unsigned size = 0;
+		char unit = 0;
+		in >> size >> unit;
+		
+		if(unit == 'K')
+			size *= 1024;
+		else if(unit == 'M')
+			size *= 1024 * 1024;
+		
+		return size;
+	}
+	
+	void readTopology(CpuInfo& info)
+	{
+		// hardware threads list the core they're on, threads of a core share one
+		std::ifstream fin("/proc/cpuinfo");
+		std::set<std::pair<int, int>> cores;
+		int physical = 0;
+		std::string line;
+		
+		while(std::getline(fin, line))
+		{
+			std::size_t colon = line.find(':');
+			
+			if(colon == std::string::npos)
+				continue;
+			
+			if(line.compare(0, 11, "physical id") == 0)
+				physical = std::stoi(line.substr(colon + 1));
+			else if(line.compare(0, 7, "core id") == 0)
+				cores.emplace(physical, std::stoi(line.substr(colon + 1)));
+		}
+		
+		if(!cores.empty())
+			info.cores = static_cast<unsigned>(cores.size());
+		
+		for(int i = 0; ; i++)
+		{
+			std::string folder = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(i) + '/';
+			std::ifstream levelFile(folder + "level");
+			
+			if(!levelFile)
+				break;
+			
+			int level = 0;
+			std::string type;
+			std::string size;
+			levelFile >> level;
+			std::ifstream(folder + "type") >> type;
+			std::ifstream(folder + "size") >> size;
+			
+			if(type == "Instruction")
+				continue;
+			
+			if(level == 1)
+				info.cacheL1 = parseSize(size);
+			else if(level == 2)
+				info.cacheL2 = parseSize(size);
+			else if(level == 3)
+				info.cacheL3 = parseSize(size);
+		}
+	}
+#elif defined(_WIN32)
+	void readTopology(CpuInfo& info)
+	{
+		DWORD bytes = 0;
+		GetLogicalProcessorInformation(nullptr, &bytes);
+		
+		std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> entries(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+		
+		if(entries.empty() || !GetLogicalProcessorInformation(entries.data(), &bytes))
+			return;
+		
+		unsigned cores = 0;
+		
+		for(auto& e : entries)
+		{
+			if(e.Relationship == RelationProcessorCore)
+			{
+				cores++;
+			}
+			else if(e.Relationship == RelationCache && e.Cache.Type != CacheInstruction)
+			{
+				if(e.Cache.Level == 1)
+					info.cacheL1 = e.Cache.Size;
+				else if(e.Cache.Level == 2)
+					info.cacheL2 = e.Cache.Size;
+				else if(e.Cache.Level == 3)
+					info.cacheL3 = e.Cache.Size;
+			}
+		}
+		
+		if(cores)
+			info.cores = cores;
+	}
+#else
+	void readTopology(CpuInfo&)
+	{
+	}
+#endif
+
+	CpuInfo detect()
+	{
+		CpuInfo info = {};
+		
+		readFeatures(info);
+		
+		info.threads = std::max(1u, std::thread::hardware_concurrency());
+		info.cores = info.threads;
+		
+		readTopology(info);
+		
+		if(info.cores > info.threads)
+			info.cores = info.threads;
+		
+		return info;
+	}
+	
+	SimdLevel detectLevel()
+	{
+		const CpuInfo& info = getCpuInfo();
+
+#ifdef SWIFT_AVX2_KERNELS
+		if(info.avx2)
+			return SimdLevel::Avx2;
+#endif
+
+		// kernels are built with SSE or NEON where the compiler targets it at all, so the build decides those
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+		if(info.sse2)
+			return SimdLevel::Wide4;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		if(info.neon)
+			return SimdLevel::Wide4;
+#endif
+
+		return SimdLevel::Scalar;
+	}
+	
+	std::atomic<int> simdLimit(static_cast<int>(SimdLevel::Avx2));
+}
+
+namespace swift
+{
+	const CpuInfo& getCpuInfo()
+	{
+		static const CpuInfo info = detect();
+		return info;
+	}
+	
+	std::string getCpuFeatures()
+	{
+		const CpuInfo& info = getCpuInfo();
+		std::ostringstream out;
+		
+		const std::pair<bool, const char*> features[] =
+		{
+			{info.sse2, "sse2"},
+			{info.sse41, "sse4.1"},
+			{info.sse42, "sse4.2"},
+			{info.avx, "avx"},
+			{info.avx2, "avx2"},
+			{info.fma, "fma"},
+			{info.avx512f, "avx512f"},
+			{info.neon, "neon"},
+		};
+		
+		for(auto& f : features)
+		{
+			if(f.first)
+				out << f.second << ' ';
+		}
+		
+		out << "| " << info.cores << " cores, " << info.threads << " threads"
+			<< " | L1 " << info.cacheL1 / 1024 << "K, L2 " << info.cacheL2 / 1024 << "K, L3 " << info.cacheL3 / 1024 << 'K'
+			<< " | kernels " << getName(getSimdLevel());
+		
+		return out.str();
+	}
+	
+	SimdLevel getSimdLevel()
+	{
+		static const SimdLevel best = detectLevel();
+		return std::min(best, static_cast<SimdLevel>(simdLimit.load(std::memory_order_relaxed)));
+	}
+	
+	void setSimdLimit(SimdLevel limit)
+	{
+		simdLimit = static_cast<int>(limit);
+	}
+	
+	const char* getName(SimdLevel level)
+	{
+		switch(level)
+		{
+			case SimdLevel::Avx2:
+				return "AVX2";
+			case SimdLevel::Wide4:
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+				return "NEON";
+#else
+				return "SSE2";
+#endif
+			default:
+				return "scalar";
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef CPUINFO_HPP
+#define CPUINFO_HPP
+
+#include <string>
+
+// functions marked SWIFT_TARGET_AVX2 may use AVX2 however the rest of the program is built.
+// They're only to be called once getSimdLevel() says the CPU has it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SWIFT_AVX2_KERNELS
+	#define SWIFT_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#define SWIFT_AVX2_KERNELS
+	#define SWIFT_TARGET_AVX2
+#endif
+
+namespace swift
+{
+	// what the processor can do, read once at first use
+	struct CpuInfo
+	{
+		bool sse2;
+		bool sse41;
+		bool sse42;
+		bool avx;
+		bool avx2;
+		bool fma;
+		bool avx512f;
+		bool neon;
+		
+		unsigned cores;		// physical
+		unsigned threads;	// logical, cores times threads per core
+		
+		// in bytes, 0 if it couldn't be found. L1 is the data cache of one core
+		unsigned cacheL1;
+		unsigned cacheL2;
+		unsigned cacheL3;
+	};
+	
+	const CpuInfo& getCpuInfo();
+	
+	// features, counts, and caches on a line, for the log
+	std::string getCpuFeatures();
+	
+	// kernels with more than one implementation pick by this. Wide4 is SSE2 or NEON, whichever the build has
+	enum class SimdLevel
+	{
+		Scalar,
+		Wide4,
+		Avx2
+	};
+	
+	// the widest both the CPU and the build have, no higher than the limit
+	SimdLevel getSimdLevel();
+	
+	// caps the level, to compare kernels or avoid a bad one. A limit above what's supported changes nothing
+	void setSimdLimit(SimdLevel limit);
+	
+	const char* getName(SimdLevel level);
+}
+
+#endif // CPUINFO_HPP
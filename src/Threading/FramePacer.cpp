@@ -0,0 +1,60 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include <SFML/System/Sleep.hpp>
+
+namespace swift
+{
+	namespace
+	{
+		const sf::Time minMargin = sf::microseconds(250);
+		const sf::Time maxMargin = sf::milliseconds(4);
+	}
+
+	FramePacer::FramePacer(const sf::Clock& c)
+	:	clock(c),
+		frameLimit(0),
+		margin(sf::milliseconds(1))
+	{
+	}
+
+	void FramePacer::setFrameLimit(unsigned fps)
+	{
+		frameLimit = fps;
+	}
+
+	unsigned FramePacer::getFrameLimit() const
+	{
+		return frameLimit;
+	}
+
+	sf::Time FramePacer::getFrameDeadline(sf::Time start) const
+	{
+		return frameLimit ? start + sf::seconds(1.f / frameLimit) : start;
+	}
+
+	void FramePacer::waitUntil(sf::Time deadline)
+	{
+		sf::Time left = deadline - clock.getElapsedTime();
+
+		if(left > margin)
+		{
+			sf::Time asked = left - margin;
+			sf::Time before = clock.getElapsedTime();
+
+			sf::sleep(asked);
+
+			// the scheduler wakes threads late by an amount that varies. The margin follows the worst of
+			// recent overshoots, easing back down when sleeps are on time
+			sf::Time overshoot = clock.getElapsedTime() - before - asked;
+			margin = std::max(overshoot + overshoot / 2, margin - margin / 8);
+			margin = std::min(std::max(margin, minMargin), maxMargin);
+		}
+
+		// the last stretch, shorter than sleeping can be trusted with
+		while(clock.getElapsedTime() < deadline)
+			std::this_thread::yield();
+	}
+}
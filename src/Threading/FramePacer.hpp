@@ -0,0 +1,36 @@
+#ifndef FRAMEPACER_HPP
+#define FRAMEPACER_HPP
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+
+namespace swift
+{
+	// waits out the time until a deadline instead of spinning. Sleeps most of the way, stopping early by
+	// about what sleeps have overshot by, and yields for the rest, so deadlines are met closely without a core pegged
+	class FramePacer
+	{
+		public:
+			// deadlines are times of clock
+			explicit FramePacer(const sf::Clock& clock);
+
+			// frames a second, 0 for no limit
+			void setFrameLimit(unsigned fps);
+			unsigned getFrameLimit() const;
+
+			// when a frame that began at start may end. start itself if there's no limit
+			sf::Time getFrameDeadline(sf::Time start) const;
+
+			// returns once clock reaches deadline, at once if it has
+			void waitUntil(sf::Time deadline);
+
+		private:
+			const sf::Clock& clock;
+			unsigned frameLimit;
+
+			// how much earlier than the deadline sleeping stops
+			sf::Time margin;
+	};
+}
+
+#endif // FRAMEPACER_HPP
@@ -0,0 +1,78 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace swift
+{
+	// fixed size queue for one thread pushing and one thread popping, without locks.
+	// Each side only writes its own index, and reads the other's to see how far it can go
+	template<typename T>
+	class SpscQueue
+	{
+		public:
+			// holds capacity items at once
+			explicit SpscQueue(std::size_t capacity)
+			:	slots(capacity + 1),
+				head(0),
+				tail(0)
+			{}
+			
+			SpscQueue(const SpscQueue&) = delete;
+			SpscQueue& operator=(const SpscQueue&) = delete;
+			
+			// false if it's full, item isn't moved from then
+			bool push(T&& item)
+			{
+				std::size_t t = tail.load(std::memory_order_relaxed);
+				std::size_t n = next(t);
+				
+				if(n == head.load(std::memory_order_acquire))
+					return false;
+				
+				slots[t] = std::move(item);
+				tail.store(n, std::memory_order_release);
+				
+				return true;
+			}
+			
+			// false if it's empty
+			bool pop(T& item)
+			{
+				std::size_t h = head.load(std::memory_order_relaxed);
+				
+				if(h == tail.load(std::memory_order_acquire))
+					return false;
+				
+				item = std::move(slots[h]);
+				slots[h] = T();
+				head.store(next(h), std::memory_order_release);
+				
+				return true;
+			}
+			
+			// only exact from the popping thread
+			bool empty() const
+			{
+				return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+			}
+			
+		private:
+			std::size_t next(std::size_t i) const
+			{
+				return i + 1 == slots.size() ? 0 : i + 1;
+			}
+			
+			// one slot is always empty, so full and empty look different
+			std::vector<T> slots;
+			
+			// on their own cache lines, so the two threads don't fight over one
+			alignas(64) std::atomic<std::size_t> head;	// next to pop
+			alignas(64) std::atomic<std::size_t> tail;	// next to push into
+	};
+}
+
+#endif // SPSCQUEUE_HPP
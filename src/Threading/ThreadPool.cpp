@@ -0,0 +1,217 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+#include "../Memory/FrameArena.hpp"
+
+namespace swift
+{
+	namespace
+	{
+		// index of the worker running on this thread, -1 for threads outside any pool
+		thread_local int workerIndex = -1;
+		thread_local const ThreadPool* workerPool = nullptr;
+	}
+
+	ThreadPool::ThreadPool(unsigned threads)
+	:	queued(0),
+		nextQueue(0),
+		stopping(false),
+		parallelThreshold(256)
+	{
+		if(threads == 0)
+		{
+			unsigned hardware = std::thread::hardware_concurrency();
+			threads = hardware > 1 ? hardware - 1 : 0;
+		}
+
+		for(unsigned i = 0; i < threads; i++)
+			queues.emplace_back(new Queue);
+
+		for(unsigned i = 0; i < threads; i++)
+			workers.emplace_back(&ThreadPool::work, this, i);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+
+		wake.notify_all();
+
+		for(auto& w : workers)
+			w.join();
+	}
+
+	void ThreadPool::run(const std::vector<Job>& jobs)
+	{
+		run(jobs.data(), jobs.size());
+	}
+
+	void ThreadPool::run(const Job* jobs, std::size_t count)
+	{
+		if(count == 0)
+			return;
+
+		// nothing to share the work with
+		if(workers.empty() || count == 1)
+		{
+			for(std::size_t j = 0; j < count; j++)
+				jobs[j]();
+
+			return;
+		}
+
+		std::atomic<std::size_t> remaining(count);
+
+		// counted first, so it never drops below zero when a job is stolen right after being pushed
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			queued += count;
+		}
+
+		// workers push to their own queue, other threads spread the jobs over all queues
+		for(std::size_t j = 0; j < count; j++)
+		{
+			unsigned q = workerPool == this ? workerIndex : nextQueue++ % queues.size();
+
+			std::lock_guard<std::mutex> lock(queues[q]->mutex);
+			queues[q]->tasks.push_back({&jobs[j], &remaining});
+		}
+
+		wake.notify_all();
+
+		// help out until the batch is done
+		unsigned start = workerPool == this ? workerIndex : 0;
+
+		while(remaining.load() != 0)
+		{
+			Task task;
+
+			if(pop(start, task) || steal(start, task))
+				execute(task);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	void ThreadPool::parallelFor(std::size_t count, const RangeJob& func)
+	{
+		if(count == 0)
+			return;
+
+		if(workers.empty() || count < parallelThreshold)
+		{
+			func(0, count);
+			return;
+		}
+
+		// a few chunks per thread, so stealing can even out uneven chunks
+		std::size_t chunks = std::min<std::size_t>(count, (workers.size() + 1) * 4);
+		std::size_t chunkSize = (count + chunks - 1) / chunks;
+
+		// the chunks only live for this call
+		FrameArena::Scope scope;
+		FrameVector<Job> jobs;
+		jobs.reserve(chunks);
+
+		for(std::size_t begin = 0; begin < count; begin += chunkSize)
+		{
+			std::size_t end = std::min(begin + chunkSize, count);
+
+			jobs.push_back([&func, begin, end]()
+			{
+				func(begin, end);
+			});
+		}
+
+		run(jobs.data(), jobs.size());
+	}
+
+	void ThreadPool::setParallelThreshold(std::size_t t)
+	{
+		parallelThreshold = std::max<std::size_t>(t, 1);
+	}
+
+	std::size_t ThreadPool::getParallelThreshold() const
+	{
+		return parallelThreshold;
+	}
+
+	unsigned ThreadPool::getThreadCount() const
+	{
+		return workers.size();
+	}
+
+	void ThreadPool::work(unsigned index)
+	{
+		workerIndex = index;
+		workerPool = this;
+
+		while(true)
+		{
+			Task task;
+
+			if(pop(index, task) || steal(index, task))
+			{
+				execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+
+			wake.wait(lock, [this]()
+			{
+				return stopping || queued.load() != 0;
+			});
+
+			if(stopping)
+				return;
+		}
+	}
+
+	bool ThreadPool::pop(unsigned index, Task& task)
+	{
+		Queue& queue = *queues[index];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if(queue.tasks.empty())
+			return false;
+
+		task = queue.tasks.back();
+		queue.tasks.pop_back();
+		queued--;
+
+		return true;
+	}
+
+	bool ThreadPool::steal(unsigned index, Task& task)
+	{
+		for(unsigned i = 1; i < queues.size(); i++)
+		{
+			Queue& queue = *queues[(index + i) % queues.size()];
+
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if(!queue.tasks.empty())
+			{
+				task = queue.tasks.front();
+				queue.tasks.pop_front();
+				queued--;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::execute(const Task& task)
+	{
+		(*task.job)();
+		task.remaining->fetch_sub(1);
+	}
+}
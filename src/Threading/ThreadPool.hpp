@@ -0,0 +1,91 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace swift
+{
+	// work stealing thread pool. Each worker has its own queue, and takes jobs from
+	// the other queues once its own is empty.
+	// a thread waiting on a batch runs queued jobs meanwhile, so jobs can start batches of their own
+	class ThreadPool
+	{
+		public:
+			using Job = std::function<void()>;
+			using RangeJob = std::function<void(std::size_t begin, std::size_t end)>;
+
+			// threads = 0 uses one worker per hardware thread, minus the calling thread
+			explicit ThreadPool(unsigned threads = 0);
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator=(const ThreadPool&) = delete;
+
+			// runs every job and returns once they are all done
+			void run(const std::vector<Job>& jobs);
+			void run(const Job* jobs, std::size_t count);
+
+			// calls func over chunks of [0, count). Counts under the parallel threshold run in one call on this thread
+			void parallelFor(std::size_t count, const RangeJob& func);
+
+			template<typename T, typename F>
+			void parallelForEach(std::vector<T>& items, F func)
+			{
+				parallelFor(items.size(), [&items, &func](std::size_t begin, std::size_t end)
+				{
+					for(std::size_t i = begin; i < end; i++)
+						func(items[i]);
+				});
+			}
+
+			// fewest items worth splitting across threads
+			void setParallelThreshold(std::size_t t);
+			std::size_t getParallelThreshold() const;
+
+			unsigned getThreadCount() const;
+
+		private:
+			struct Task
+			{
+				const Job* job;
+				std::atomic<std::size_t>* remaining;
+			};
+
+			struct Queue
+			{
+				std::deque<Task> tasks;
+				std::mutex mutex;
+			};
+
+			void work(unsigned index);
+
+			// own queue first, from the back. Others from the front
+			bool pop(unsigned index, Task& task);
+			bool steal(unsigned index, Task& task);
+
+			void execute(const Task& task);
+
+			std::vector<std::thread> workers;
+			std::vector<std::unique_ptr<Queue>> queues;
+
+			// queued, not yet started tasks, so idle workers know when to sleep
+			std::atomic<std::size_t> queued;
+			std::atomic<unsigned> nextQueue;
+
+			std::mutex sleepMutex;
+			std::condition_variable wake;
+
+			std::atomic<bool> stopping;
+
+			std::size_t parallelThreshold;
+	};
+}
+
+#endif // THREADPOOL_HPP
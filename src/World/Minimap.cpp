@@ -0,0 +1,280 @@
+#include "Minimap.hpp"
+
+#include <algorithm>
+
+#include <SFML/Graphics/Image.hpp>
+
+#include "World.hpp"
+#include "../Logger/Logger.hpp"
+#include "../Profiling/Profiler.hpp"
+
+namespace swift
+{
+	Minimap::Minimap()
+	:	map(nullptr),
+		size(200, 200),
+		markerSize(3),
+		markers(sf::PrimitiveType::Quads)
+	{
+	}
+	
+	bool Minimap::build(const TileMap& m)
+	{
+		SWIFT_PROFILE("Minimap::build");
+		
+		clear();
+		
+		const sf::Texture* texture = m.getTexture();
+		const sf::Vector2u& tiles = m.getSize();
+		
+		if(texture == nullptr || tiles.x == 0 || tiles.y == 0)
+			return false;
+		
+		if(std::max(tiles.x, tiles.y) > sf::Texture::getMaximumSize())
+		{
+			SWIFT_WARNING(World, "\"" << m.getFile() << "\" is too many tiles across for a minimap.\n");
+			return false;
+		}
+		
+		// the alpha weighted average of each type's first frame, so the transparent parts of a tile don't darken it
+		sf::Image image = texture->copyToImage();
+		colors.assign(m.getNumOfTileTypes(), sf::Color::Transparent);
+		
+		for(unsigned id = 0; id < colors.size(); id++)
+		{
+			const Tile* type = m.getType(id);
+			
+			if(type == nullptr || type->getFrames().empty())
+				continue;
+			
+			const sf::IntRect& frame = type->getFrames().front();
+			unsigned right = std::min<unsigned>(std::max(frame.left + frame.width, 0), image.getSize().x);
+			unsigned bottom = std::min<unsigned>(std::max(frame.top + frame.height, 0), image.getSize().y);
+			
+			unsigned long long r = 0, g = 0, b = 0, a = 0, count = 0;
+			
+			for(unsigned y = std::max(frame.top, 0); y < bottom; y++)
+			{
+				for(unsigned x = std::max(frame.left, 0); x < right; x++)
+				{
+					sf::Color p = image.getPixel(x, y);
+					r += p.r * p.a;
+					g += p.g * p.a;
+					b += p.b * p.a;
+					a += p.a;
+					count++;
+				}
+			}
+			
+			if(a > 0)
+				colors[id] = sf::Color(static_cast<sf::Uint8>(r / a), static_cast<sf::Uint8>(g / a), static_cast<sf::Uint8>(b / a), static_cast<sf::Uint8>(a / count));
+		}
+		
+		for(unsigned l = 0; l < m.getNumLayers(); l++)
+		{
+			const Layer* layer = m.getLayer(l);
+			LayerImage li;
+			li.texture.reset(new sf::Texture());
+			
+			if(!li.texture->create(layer->getSize().x, layer->getSize().y))
+			{
+				SWIFT_WARNING(World, "Unable to make a minimap of \"" << m.getFile() << "\".\n");
+				clear();
+				return false;
+			}
+			
+			// revisions are never 0, so every chunk is drawn by the first update
+			li.revisions.assign(layer->getChunkCount().x * layer->getChunkCount().y, 0);
+			layers.push_back(std::move(li));
+		}
+		
+		map = &m;
+		
+		for(unsigned l = 0; l < layers.size(); l++)
+			for(unsigned c = 0; c < layers[l].revisions.size(); c++)
+				drawChunk(l, c);
+		
+		return true;
+	}
+	
+	void Minimap::clear()
+	{
+		map = nullptr;
+		layers.clear();
+		colors.clear();
+		markers.clear();
+	}
+	
+	void Minimap::update(World* world)
+	{
+		if(map == nullptr)
+			return;
+		
+		if(!matches() && !build(*map))
+			return;
+		
+		for(unsigned l = 0; l < layers.size(); l++)
+		{
+			const Layer* layer = map->getLayer(l);
+			
+			for(unsigned c = 0; c < layers[l].revisions.size(); c++)
+			{
+				if(layers[l].revisions[c] != layer->getRevision(c))
+					drawChunk(l, c);
+			}
+		}
+		
+		markers.clear();
+		
+		if(world == nullptr)
+			return;
+		
+		sf::FloatRect shown = getShown();
+		
+		if(shown.width <= 0 || shown.height <= 0)
+			return;
+		
+		world->queryArea(shown, found);
+		
+		const sf::Vector2f scale(size.x / shown.width, size.y / shown.height);
+		const float half = markerSize / 2;
+		
+		for(auto& e : found)
+		{
+			sf::Color color = markerColor ? markerColor(*e) : sf::Color::White;
+			
+			if(color.a == 0)
+				continue;
+			
+			const Physical* p = e->get<Physical>();
+			sf::Vector2f center((p->position.x + p->size.x / 2.f - shown.left) * scale.x, (p->position.y + p->size.y / 2.f - shown.top) * scale.y);
+			
+			markers.append({{center.x - half, center.y - half}, color});
+			markers.append({{center.x + half, center.y - half}, color});
+			markers.append({{center.x + half, center.y + half}, color});
+			markers.append({{center.x - half, center.y + half}, color});
+		}
+	}
+	
+	void Minimap::setSize(const sf::Vector2f& s)
+	{
+		size = s;
+	}
+	
+	const sf::Vector2f& Minimap::getSize() const
+	{
+		return size;
+	}
+	
+	void Minimap::setArea(const sf::FloatRect& a)
+	{
+		area = a;
+	}
+	
+	void Minimap::setMarkerColor(const std::function<sf::Color(const Entity&)>& c)
+	{
+		markerColor = c;
+	}
+	
+	void Minimap::setMarkerSize(float s)
+	{
+		markerSize = s;
+	}
+	
+	sf::Color Minimap::getColor(int id) const
+	{
+		return id >= 0 && static_cast<unsigned>(id) < colors.size() ? colors[id] : sf::Color::Transparent;
+	}
+	
+	void Minimap::draw(sf::RenderTarget& target, sf::RenderStates states) const
+	{
+		if(map == nullptr)
+			return;
+		
+		states.transform *= getTransform();
+		
+		// one pixel per tile, so the shown area in tiles is its texture rect
+		sf::FloatRect shown = getShown();
+		const sf::Vector2u& tileSize = map->getTileSize();
+		
+		float left = tileSize.x ? shown.left / tileSize.x : 0;
+		float top = tileSize.y ? shown.top / tileSize.y : 0;
+		float right = tileSize.x ? (shown.left + shown.width) / tileSize.x : 0;
+		float bottom = tileSize.y ? (shown.top + shown.height) / tileSize.y : 0;
+		
+		sf::Vertex quad[4] =
+		{
+			{{0, 0}, {left, top}},
+			{{size.x, 0}, {right, top}},
+			{{size.x, size.y}, {right, bottom}},
+			{{0, size.y}, {left, bottom}},
+		};
+		
+		for(auto& l : layers)
+		{
+			states.texture = l.texture.get();
+			target.draw(quad, 4, sf::PrimitiveType::Quads, states);
+		}
+		
+		states.texture = nullptr;
+		target.draw(markers, states);
+	}
+	
+	void Minimap::drawChunk(unsigned l, unsigned c)
+	{
+		const Layer* layer = map->getLayer(l);
+		const sf::Vector2u& layerSize = layer->getSize();
+		
+		unsigned left = c % layer->getChunkCount().x * Layer::CHUNK_SIZE;
+		unsigned top = c / layer->getChunkCount().x * Layer::CHUNK_SIZE;
+		unsigned width = std::min(Layer::CHUNK_SIZE, layerSize.x - left);
+		unsigned height = std::min(Layer::CHUNK_SIZE, layerSize.y - top);
+		
+		pixels.resize(width * height * 4);
+		
+		// unloaded chunks have no tiles, so they're left clear
+		for(unsigned y = 0; y < height; y++)
+		{
+			for(unsigned x = 0; x < width; x++)
+			{
+				sf::Color color = getColor(layer->getID((top + y) * layerSize.x + left + x));
+				sf::Uint8* p = &pixels[(y * width + x) * 4];
+				
+				p[0] = color.r;
+				p[1] = color.g;
+				p[2] = color.b;
+				p[3] = color.a;
+			}
+		}
+		
+		layers[l].texture->update(pixels.data(), width, height, left, top);
+		layers[l].revisions[c] = layer->getRevision(c);
+	}
+	
+	bool Minimap::matches() const
+	{
+		if(map->getNumLayers() != layers.size())
+			return false;
+		
+		for(unsigned l = 0; l < layers.size(); l++)
+		{
+			const Layer* layer = map->getLayer(l);
+			
+			if(layer->getSize() != layers[l].texture->getSize() || layer->getChunkCount().x * layer->getChunkCount().y != layers[l].revisions.size())
+				return false;
+		}
+		
+		return true;
+	}
+	
+	sf::FloatRect Minimap::getShown() const
+	{
+		if(area.width > 0 && area.height > 0)
+			return area;
+		
+		sf::Vector2u tiles = map->getSize();
+		const sf::Vector2u& tileSize = map->getTileSize();
+		
+		return {0, 0, static_cast<float>(tiles.x * tileSize.x), static_cast<float>(tiles.y * tileSize.y)};
+	}
+}
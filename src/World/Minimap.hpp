@@ -0,0 +1,89 @@
+#ifndef MINIMAP_HPP
+#define MINIMAP_HPP
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Transformable.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Color.hpp>
+
+namespace swift
+{
+	class TileMap;
+	class World;
+	class Entity;
+	
+	// a TileMap at one pixel per tile, a texture per layer colored with the average of each tile type, and entities as dots
+	// over it. Built once per map, after which only chunks whose tiles changed, through TileMap::setTile or by being
+	// streamed in or out, are drawn into the textures again. The map's own vertices are never drawn
+	class Minimap : public sf::Drawable, public sf::Transformable
+	{
+		public:
+			Minimap();
+			
+			// reads the map's texture back from the GPU for the tile colors, so it's for once per map, not per frame.
+			// False if the map has no texture yet, or is more tiles across than a texture can be
+			bool build(const TileMap& map);
+			void clear();
+			
+			// draws the chunks changed since the last update into the textures again, built again if the map was loaded again.
+			// Markers are placed for world's entities in the area shown, none if world is nullptr
+			void update(World* world);
+			
+			// pixels it's drawn across, before its transform
+			void setSize(const sf::Vector2f& s);
+			const sf::Vector2f& getSize() const;
+			
+			// part of the map shown, in the map's pixels. The whole map, if it's empty, the default
+			void setArea(const sf::FloatRect& a);
+			
+			// entity's marker, transparent for none. By default every entity with a Physical is a white dot
+			void setMarkerColor(const std::function<sf::Color(const Entity&)>& c);
+			
+			// markers' side, in pixels of the minimap
+			void setMarkerSize(float s);
+			
+			// of tile type id, as the minimap draws it. Transparent for no tile
+			sf::Color getColor(int id) const;
+		
+		private:
+			struct LayerImage
+			{
+				std::unique_ptr<sf::Texture> texture;
+				std::vector<unsigned> revisions;	// of each chunk, when it was last drawn
+			};
+			
+			void draw(sf::RenderTarget& target, sf::RenderStates states) const;
+			
+			// chunk c of layer l, from the map's tiles into the texture
+			void drawChunk(unsigned l, unsigned c);
+			
+			// false if the map's layers changed size or number since build
+			bool matches() const;
+			
+			// in the map's pixels
+			sf::FloatRect getShown() const;
+			
+			const TileMap* map;
+			std::vector<LayerImage> layers;
+			std::vector<sf::Color> colors;		// by tile type
+			std::vector<sf::Uint8> pixels;		// of the chunk being drawn
+			
+			sf::Vector2f size;
+			sf::FloatRect area;
+			
+			std::function<sf::Color(const Entity&)> markerColor;
+			float markerSize;
+			sf::VertexArray markers;
+			std::vector<Entity*> found;			// reused by every update
+	};
+}
+
+#endif // MINIMAP_HPP
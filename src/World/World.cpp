@@ -1,21 +1,68 @@
 #include "World.hpp"
 
 #include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <functional>
 #include "../Math/Math.hpp"
+#include "../Math/Packed.hpp"
+#include "../Math/Hash.hpp"
+#include "../Profiling/FrameStats.hpp"
+#include "../Profiling/Profiler.hpp"
+#include "../Memory/MemoryTracker.hpp"
+#include "../Memory/FrameArena.hpp"
+#include "../EntitySystem/NameTable.hpp"
 
 /* serialization headers */
 #include <tinyxml2.h>
 
 namespace swift
 {
+	namespace
+	{
+		// ticks an entity frozen by the lod runs for once something running runs into it
+		const unsigned contactWakeTicks = 60;
+	}
+	
+	AsyncWriter* World::writer = nullptr;
+	World::SaveFormat World::saveFormat = World::SaveFormat::Binary;
+	
 	World::World(const std::string& n, AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, const std::vector<std::string>& scriptFiles)
 		:	assets(am),
 			soundPlayer(sp),
 			musicPlayer(mp),
 			noisySystem(soundPlayer, assets),
-			name(n)
+			cullMargin(64),
+			sightLayer(0),
+			drawn(false),
+			updating(false),
+			nextSaveKey(0),
+			journalRecords(0),
+			hasFullSave(false),
+			saveFailed(std::make_shared<bool>(false)),
+			name(n),
+			nameRevision(0),
+			namesIndexed(false)
 	{
-		PathfinderSystem::world = this;
+		pathSystem.world = this;
+		
+		// players and the broadphase always run, the lod is found from it. Sounds and sprites are cheap, and need every entity at once
+		addSystem(controlSystem, "Controllable", false);
+		
+		scheduler.add(moveSystem, [this](float dt)
+		{
+			moveSystem.update(storage, dt, SimulationLod::isEnabled() ? &lod : nullptr);
+		}, "Movable");
+		
+		addSystem(pathSystem, "Pathfinder");
+		
+		// after the velocities are set, with every mover at once to steer around
+		addSystem(steerSystem, "Steering", false);
+		addSystem(physicalSystem, "Physical", false);
+		addSystem(noisySystem, "Noisy", false);
+		addSystem(animSystem, "Animated");
+		addSystem(drawSystem, "Drawable", false);
 		
 		for(auto& s : scriptFiles)
 			addScript(s);
@@ -29,51 +76,154 @@ namespace swift
 			removeScript(s.first);
 		
 		for(auto& e : entities)
-			delete e;
+			entityPool.destroy(e);
+		
+		for(auto& e : commands.getCreated())
+			entityPool.destroy(e);
 	}
 	
 	void World::update(float dt)
 	{
-		controlSystem.update(entities, dt);
-		moveSystem.update(entities, dt);
-		pathSystem.update(entities, dt);
-		physicalSystem.update(entities, dt);
-		noisySystem.update(entities, dt);
-		animSystem.update(entities, dt);
-		drawSystem.update(entities, dt);
+		updateSystems(dt);
+		updateScripts(dt);
+		finishUpdate();
+	}
+	
+	void World::updateSystems(float dt)
+	{
+		SWIFT_MEMORY_SCOPE(Entities);
 		
-		// check for collision with tilemap
-		for(auto& e : entities)
+		updating = true;
+		storage.setDeferred(true);
+		
+		// where entities were before this update, for drawing between updates
+		ComponentPool<Physical>& physicals = storage.getPool<Physical>();
+		
+		for(std::size_t i = 0; i < physicals.size(); i++)
+			physicals[i].storePrevious();
+		
+		// no-op unless the map changed
+		physicalSystem.setCellSize(tilemap.getTileSize());
+		
+		// paths solved since the last update are collected this one
+		pathService.update(tilemap);
+		
+		if(SimulationLod::isEnabled())
+			updateLod();
+		
+		scheduler.run(dt);
+		
+		// the stats are of the world being played, if there is one. Others may be ticking on other threads
+		if(Script::getWorld() == this || Script::getWorld() == nullptr)
+		{
+			for(std::size_t i = 0; i < scheduler.getSystemCount(); i++)
+				FrameStats::setSystemTime(scheduler.getName(i), scheduler.getTime(i));
+		}
+		
+		// check for collision with tilemap. The move is swept from where the entity was,
+		// so fast entities can't skip over thin walls
+		for(auto& e : storage.getView<Physical, Movable>().getEntities())
 		{
-			if(e->has<Physical>() && e->has<Movable>())
+			Physical* phys = e->get<Physical>();
+			
+			// from where it was stored at the start of the update, so being pushed by collisions, and however many
+			// steps the lod ran it for, are swept too
+			sf::Vector2f delta = phys->position - phys->previousPosition;
+			
+			if(delta == sf::Vector2f(0, 0))
+				continue;
+			
+			sf::FloatRect start = phys->getBounds();
+			start.left -= delta.x;
+			start.top -= delta.y;
+			
+			sf::Vector2f allowed = tilemap.sweep(start, delta, phys->zIndex);
+			
+			if(allowed != delta)
 			{
-				Physical* phys = e->get<Physical>();
-				Movable* mov = e->get<Movable>();
-				
-				const Tile* tile = tilemap.getTile(phys->position, phys->zIndex);
-				
-				// if tile is valid
-				// need to decide if engine should do something if this is not the case. delete the entity?
-				if(tile)
+				// if entity ran into an impassable tile, stop it there, keeping the rest of its movement
+				phys->position += allowed - delta;
+				physicalSystem.refit(*e);
+			}
+		}
+		
+		// streamed maps keep the chunks around anything that moves loaded
+		if(tilemap.isStreaming())
+		{
+			std::vector<sf::Vector2f> focus;
+			
+			for(auto& e : storage.getView<Physical, Movable>().getEntities())
+				focus.push_back(e->get<Physical>()->position);
+			
+			tilemap.setStreamFocus(focus);
+		}
+		
+		tilemap.update(dt);
+		
+		// emitters attached to entities follow the centers they were moved to
+		particles.update(dt, [this](EntityHandle handle, sf::Vector2f& center)
+		{
+			Entity* ent = getEntity(handle);
+			const Physical* phys = ent ? ent->get<Physical>() : nullptr;
+			
+			if(phys == nullptr)
+				return false;
+			
+			center = phys->position + static_cast<sf::Vector2f>(phys->size) / 2.f;
+			return true;
+		});
+		
+		// views are only cast again for entities that changed tiles, or once the layer does
+		if(const Layer* layer = tilemap.getLayer(sightLayer))
+		{
+			if(visibility.getSize() != tilemap.getSize())
+				visibility.resize(tilemap.getSize());
+			
+			sf::Vector2f tileSize = {static_cast<float>(tilemap.getTileSize().x), static_cast<float>(tilemap.getTileSize().y)};
+			viewers.clear();
+			
+			if(tileSize.x > 0 && tileSize.y > 0)
+			{
+				for(auto& e : storage.getView<Sighted, Physical>().getEntities())
 				{
-					if(!tile->isPassable())
-					{
-						// if entity moved onto an impassable tile, move it back
-						phys->position -= mov->velocity * dt;
-					}
+					Physical* phys = e->get<Physical>();
+					Sighted* sight = e->get<Sighted>();
+					sf::Vector2f center = phys->position + sf::Vector2f(phys->size) / 2.f;
+					
+					viewers.push_back({e->getID(), sight->faction, {static_cast<int>(std::floor(center.x / tileSize.x)), static_cast<int>(std::floor(center.y / tileSize.y))},
+										static_cast<unsigned>(std::ceil(std::max(sight->radius, 0.f) / tileSize.x))});
 				}
 			}
+			
+			visibility.update(viewers, layer->getPassability(), layer->getVersion());
 		}
+	}
+	
+	void World::updateScripts(float dt)
+	{
+		// bindings act on this world, whichever is being played
+		Script::Scope scope(*this);
 		
-		tilemap.update(dt);
+		dispatchContacts();
 		
-		std::vector<std::string> doneScripts;
+		// script timers and radius triggers tick with the world being played, not suspended ones
+		if(Script::getWorld() == this)
+			Script::updateEvents(dt);
 		
 		for(auto& s : scripts)
-		{
 			s.second->update();
-			
-			// check if script is done, if so, push it for deletion
+	}
+	
+	void World::finishUpdate()
+	{
+		SWIFT_MEMORY_SCOPE(Entities);
+		
+		FrameArena::Scope scope;
+		FrameVector<std::string> doneScripts;
+		
+		// check if script is done, if so, push it for deletion
+		for(auto& s : scripts)
+		{
 			if(s.second->toDelete())
 				doneScripts.push_back(s.first);
 		}
@@ -83,6 +233,11 @@ namespace swift
 		{
 			removeScript(s);
 		}
+		
+		updating = false;
+		storage.setDeferred(false);
+		
+		flush();
 	}
 	
 	bool World::addScript(const std::string& scriptFile)
@@ -90,6 +245,8 @@ namespace swift
 		if(scripts.find(scriptFile) == scripts.end())
 		{
 			scripts.emplace(scriptFile, assets.getScript(scriptFile));
+			
+			Script::Scope scope(*this);
 			scripts[scriptFile]->start();
 			return true;
 		}
@@ -101,8 +258,11 @@ namespace swift
 	{
 		if(scripts.find(scriptFile) != scripts.end())
 		{
+			for(auto& s : contactSubscribers)
+				s.second.erase(std::remove(s.second.begin(), s.second.end(), scripts[scriptFile]), s.second.end());
+			
 			if(!scripts[scriptFile]->save("./data/saves/" + scriptFile.substr(scriptFile.find_last_of('/') + 1) + ".script"))
-				log << "[WARNING]: Could not save script: " << scriptFile << "!\n";
+				SWIFT_WARNING(World, "Could not save script: " << scriptFile << "!\n");
 			scripts[scriptFile]->reset();
 			scripts.erase(scriptFile);
 			return true;
@@ -111,6 +271,11 @@ namespace swift
 			return false;
 	}
 	
+	const std::map<std::string, Script*>& World::getScripts() const
+	{
+		return scripts;
+	}
+	
 	void World::drawWorld(sf::RenderTarget& target, sf::RenderStates states)
 	{
 		target.draw(tilemap, states);
@@ -118,8 +283,81 @@ namespace swift
 	
 	void World::drawEntities(sf::RenderTarget& target, float e, sf::RenderStates states)
 	{
-		animSystem.draw(entities, e, target, states);
-		drawSystem.draw(entities, e, target, states);
+		// what the view shows, in the world's coordinates
+		sf::FloatRect area = target.getView().getInverseTransform().transformRect({-1, -1, 2, 2});
+		area = states.transform.getInverse().transformRect(area);
+		
+		// the camera keeps what's around it running
+		drawnCenter = {area.left + area.width / 2, area.top + area.height / 2};
+		drawn = true;
+		
+		area.left -= cullMargin;
+		area.top -= cullMargin;
+		area.width += cullMargin * 2;
+		area.height += cullMargin * 2;
+		
+		visibleIDs.clear();
+		visibleDrawables.clear();
+		visibleAnimateds.clear();
+		
+		physicalSystem.query(area, visibleIDs);
+		
+		for(auto& id : visibleIDs)
+		{
+			Entity* ent = storage.getEntity(id);
+			
+			if(ent == nullptr || !ent->has<Physical>())
+				continue;
+			
+			if(ent->has<Drawable>())
+				visibleDrawables.push_back(ent);
+			
+			if(ent->has<Animated>())
+				visibleAnimateds.push_back(ent);
+		}
+		
+		renderList.update(visibleDrawables, visibleAnimateds, e, area);
+		target.draw(renderList, states);
+		
+		particles.prepare(area, e);
+		target.draw(particles, states);
+	}
+	
+	void World::setCullMargin(float m)
+	{
+		cullMargin = m;
+	}
+	
+	void World::drawLights(sf::RenderTarget& target, float e, sf::RenderStates states)
+	{
+		lightMap.begin(target.getView(), target.getSize(), states.transform);
+		
+		// culled by the light map, there aren't many lights compared to other entities
+		for(auto& ent : storage.getView<Luminous, Physical>().getEntities())
+		{
+			Luminous* lum = ent->get<Luminous>();
+			const Physical* phys = ent->get<Physical>();
+			
+			if(!lum->texture.empty() && lum->lightTexture == nullptr)
+				lum->lightTexture = assets.getTexture(lum->texture);
+			
+			sf::Vector2f center = phys->getDrawPosition(e) + static_cast<sf::Vector2f>(phys->size) / 2.f;
+			
+			lightMap.add({center, lum->radius, lum->color, lum->lightTexture});
+		}
+		
+		lightMap.end();
+		target.draw(lightMap, states);
+	}
+	
+	LightMap& World::getLightMap()
+	{
+		return lightMap;
+	}
+	
+	ParticleSystem& World::getParticles()
+	{
+		return particles;
 	}
 	
 	const std::string& World::getName() const
@@ -129,21 +367,74 @@ namespace swift
 	
 	Entity* World::addEntity()
 	{
-		unsigned oldSize = entities.size();
+		SWIFT_MEMORY_SCOPE(Entities);
+		
+		Entity* entity = entityPool.create(storage);
+		
+		if(updating)
+			commands.create(entity);
+		else
+			insertEntity(entity);
+		
+		return entity;
+	}
+	
+	void World::spawn(Prefab& prefab, unsigned count, const std::vector<sf::Vector2f>& positions, std::vector<Entity*>& spawned)
+	{
+		SWIFT_MEMORY_SCOPE(Entities);
+		
+		spawned.clear();
+		spawned.reserve(count);
 		
-		entities.emplace_back(new Entity);
+		prefab.resolve(assets);
 		
-		return entities.size() > oldSize ? entities[entities.size() - 1] : nullptr;
+		const Entity& source = prefab.getEntity();
+		
+		for(unsigned t = 0; t < MAX_COMPONENTS; t++)
+		{
+			if(source.getMask().test(t))
+				storage.reserve(t, storage.getStats(t).live + count);
+		}
+		
+		storage.reserveEntities(entities.size() + count);
+		entities.reserve(entities.size() + count);
+		
+		for(unsigned i = 0; i < count; i++)
+		{
+			Entity* entity = addEntity();
+			*entity = source;
+			
+			Physical* phys = entity->get<Physical>();
+			
+			if(phys && i < positions.size())
+			{
+				phys->position = positions[i];
+				phys->resetPrevious();
+			}
+			
+			physicalSystem.refit(*entity);
+			spawned.push_back(entity);
+		}
 	}
 	
 	bool World::removeEntity(int e)
 	{
-		// if e is positive, check if is greater than last entity
-		// if e is negative, check if it refers to entity less than 0
-		if(e > static_cast<int>(entities.size()) || static_cast<int>(entities.size()) + e < 0)
+		Entity* entity = getEntity(e);
+		
+		return entity ? removeEntity(entity->getHandle()) : false;
+	}
+	
+	bool World::removeEntity(EntityHandle e)
+	{
+		Entity* entity = getEntity(e);
+		
+		if(!entity)
 			return false;
 		
-		entities.erase((e >= 0 ? entities.begin() : entities.end()) + e);
+		if(updating)
+			commands.destroy(e);
+		else
+			destroyEntity(entity);
 		
 		return true;
 	}
@@ -152,34 +443,94 @@ namespace swift
 	{
 		// if e is positive, check if is greater than last entity
 		// if e is negative, check if it refers to entity less than 0
-		if(e > static_cast<int>(entities.size()) || static_cast<int>(entities.size()) + e < 0)
+		if(e >= static_cast<int>(entities.size()) || static_cast<int>(entities.size()) + e < 0)
 			return nullptr;
-			
+		
 		return entities[(e >= 0 ? 0 : entities.size()) + e];
 	}
 	
+	Entity* World::getEntity(EntityHandle e) const
+	{
+		return storage.getEntity(e);
+	}
+	
 	const std::vector<Entity*>& World::getEntities() const
 	{
 		return entities;
 	}
 	
+	std::vector<Entity*> World::findByName(const std::string& n)
+	{
+		std::vector<Entity*> found;
+		
+		unsigned id = NameTable::find(n);
+		
+		if(id == 0)
+			return found;
+		
+		indexNames();
+		
+		auto it = byName.find(id);
+		
+		if(it == byName.end())
+			return found;
+		
+		for(auto& h : it->second)
+		{
+			Entity* entity = getEntity(h);
+			
+			if(entity && entity->has<Name>() && entity->get<Name>()->getID() == id)
+				found.push_back(entity);
+		}
+		
+		return found;
+	}
+	
+	bool World::setName(Entity* entity, const std::string& n)
+	{
+		Name* component = entity ? entity->get<Name>() : nullptr;
+		
+		if(!component)
+			return false;
+		
+		// only kept up to date if it already was, otherwise the next lookup rebuilds it all anyway
+		bool current = namesIndexed && nameRevision == Name::getRevision();
+		
+		unsigned old = component->getID();
+		component->setName(n);
+		
+		if(!current || old == component->getID())
+			return true;
+		
+		EntityHandle handle = entity->getHandle();
+		
+		auto it = byName.find(old);
+		
+		if(it != byName.end())
+		{
+			it->second.erase(std::remove(it->second.begin(), it->second.end(), handle), it->second.end());
+			
+			if(it->second.empty())
+				byName.erase(it);
+		}
+		
+		if(component->getID() != 0)
+			byName[component->getID()].push_back(handle);
+		
+		nameRevision = Name::getRevision();
+		
+		return true;
+	}
+	
 	const std::vector<Entity*> World::getEntitiesAround(const sf::Vector2f& pos, float radius)
 	{
 		std::vector<Entity*> around;
 		
-		// if pos is outside of the world, or the radius is 0 or less, just return an empty vector
-		if(!(0 <= pos.x && 0 <= pos.y) || radius <= 0)
+		// if pos is outside of the world, just return an empty vector
+		if(!(0 <= pos.x && 0 <= pos.y))
 			return around;
 		
-		for(auto& e : entities)
-		{
-			if(e->has<Physical>())
-			{
-				Physical* p = e->get<Physical>();
-				if(math::distance(p->position, pos) <= radius)
-					around.push_back(e);
-			}
-		}
+		queryRadius(pos, radius, around);
 		
 		return around;
 	}
@@ -188,118 +539,1196 @@ namespace swift
 	{
 		std::vector<unsigned> around;
 		
-		if(!(0 <= pos.x && 0 <= pos.y) || radius <= 0)
-			return around;
+		for(auto& e : getEntitiesAround(pos, radius))
+		{
+			// entities created during this update aren't in entities yet
+			unsigned index = e->getID() < positions.size() ? positions[e->getID()] : entities.size();
+			
+			if(index < entities.size() && entities[index] == e)
+				around.push_back(index);
+		}
+		
+		return around;
+	}
+	
+	void World::queryRadius(const sf::Vector2f& pos, float radius, std::vector<Entity*>& found)
+	{
+		found.clear();
 		
-		for(unsigned i = 0; i < entities.size(); i++)
+		if(radius <= 0)
+			return;
+		
+		queryIDs.clear();
+		physicalSystem.query({pos.x - radius, pos.y - radius, radius * 2, radius * 2}, queryIDs);
+		
+		const float radiusSquared = radius * radius;
+		
+		// gathered, so the distances are worked out together
+		queryEntities.clear();
+		queryPositions.clear();
+		
+		for(auto& id : queryIDs)
 		{
-			if(entities[i]->has<Physical>())
+			Entity* e = storage.getEntity(id);
+			Physical* p = e ? e->get<Physical>() : nullptr;
+			
+			if(p)
 			{
-				Physical* p = entities[i]->get<Physical>();
-				
-				if(math::distance(p->position, pos) <= radius)
-					around.push_back(i);
+				queryEntities.push_back(e);
+				queryPositions.push_back(p->position);
 			}
 		}
 		
-		return around;
+		queryDistances.resize(queryPositions.size());
+		math::distanceSquared(queryPositions.data(), queryPositions.size(), pos, queryDistances.data());
+		
+		for(std::size_t i = 0; i < queryEntities.size(); i++)
+		{
+			if(queryDistances[i] <= radiusSquared)
+				found.push_back(queryEntities[i]);
+		}
 	}
 	
-	const std::vector<Collision*> World::getCollisions() const
+	void World::refit(const Entity& e)
 	{
-		return physicalSystem.getCollisions();
+		physicalSystem.refit(e);
 	}
 	
-	bool World::load()
+	void World::refit(const Physical& p)
 	{
-		std::string file = "./data/saves/" + name + ".world";
+		ComponentPool<Physical>& physicals = storage.getPool<Physical>();
+		const Physical* first = physicals.data();
 		
-		tinyxml2::XMLDocument loadFile;
-		loadFile.LoadFile(file.c_str());
+		// a Physical of another world's pool
+		if(std::less<const Physical*>()(&p, first) || !std::less<const Physical*>()(&p, first + physicals.size()))
+			return;
 		
-		if(loadFile.Error())
-		{
-			log << "[ERROR] Loading world save file \"" << file << "\" failed.\n";
-			return false;
-		}
+		Entity* e = storage.getEntity(physicals.getOwner(&p - first));
 		
-		tinyxml2::XMLElement* worldRoot = loadFile.FirstChildElement("world");
-		if(worldRoot == nullptr)
-		{
-			log << "[WARNING] World save file \"" << file << "\" does not have a \"world\" root element.\n";
-			return false;
-		}
+		if(e)
+			physicalSystem.refit(*e);
+	}
+	
+	void World::queryArea(const sf::FloatRect& area, std::vector<Entity*>& found)
+	{
+		found.clear();
 		
-		tinyxml2::XMLElement* entityElement = worldRoot->FirstChildElement("entity");
-		while(entityElement != nullptr)
+		queryIDs.clear();
+		physicalSystem.query(area, queryIDs);
+		
+		for(auto& id : queryIDs)
 		{
-			Entity* entity = addEntity();
-			
-			tinyxml2::XMLElement* component = entityElement->FirstChildElement();
-			while(component != nullptr)
-			{
-				std::string componentName = component->Value();
-				entity->add(componentName);
-				
-				std::map<std::string, std::string> variables;
-				tinyxml2::XMLElement* variableElement = component->FirstChildElement();
-				while(variableElement != nullptr)
-				{
-					// make sure the strings aren't empty...
-					if(std::string(variableElement->Value()).size() > 0 && std::string(variableElement->GetText()).size() > 0)
-						variables.emplace(variableElement->Value(), variableElement->GetText());
-					variableElement = variableElement->NextSiblingElement();
-				}
-				
-				// get component and add to it
-				entity->get(componentName)->unserialize(variables);
-				
-				if(componentName == "Drawable")
-				{
-					entity->get<Drawable>()->sprite.setTexture(*assets.getTexture(entity->get<Drawable>()->texture));
-				}
-				
-				component = component->NextSiblingElement();
-			}
+			Entity* e = storage.getEntity(id);
+			Physical* p = e ? e->get<Physical>() : nullptr;
 			
-			entityElement = entityElement->NextSiblingElement("entity");
+			if(p && area.contains(p->position))
+				found.push_back(e);
 		}
-		
-		return true;
 	}
 	
-	bool World::save()
+	void World::queryNearest(const sf::Vector2f& pos, unsigned k, float maxRadius, std::vector<Entity*>& found)
 	{
-		std::string file = "./data/saves/" + name + ".world";
+		found.clear();
 		
-		tinyxml2::XMLDocument saveFile;
-		tinyxml2::XMLError result = saveFile.LoadFile(file.c_str());
-
-		if(result != tinyxml2::XML_SUCCESS && result != tinyxml2::XML_ERROR_EMPTY_DOCUMENT && result != tinyxml2::XML_ERROR_FILE_NOT_FOUND)
+		if(k == 0 || maxRadius <= 0)
+			return;
+		
+		// grows from about a tile until there are enough entities, most queries are answered by the first, small, search
+		float radius = std::min(static_cast<float>(std::max(tilemap.getTileSize().x, 16u)) * 2, maxRadius);
+		
+		while(true)
 		{
-			log << "[ERROR]: Saving world save file \"" << file << "\" failed.\n";
-			return false;
+			queryRadius(pos, radius, found);
+			
+			if(found.size() >= k || radius >= maxRadius)
+				break;
+			
+			radius = std::min(radius * 2, maxRadius);
 		}
 		
-		tinyxml2::XMLElement* root = saveFile.FirstChildElement("world");
-		if(root == nullptr)
+		auto closer = [&pos](Entity* one, Entity* two)
+		{
+			return math::distanceSquared(one->get<Physical>()->position, pos) < math::distanceSquared(two->get<Physical>()->position, pos);
+		};
+		
+		if(found.size() > k)
 		{
-			log << "[WARNING]: World save file \"" << file << "\" does not have a \"world\" root element.\n";
-			root = saveFile.NewElement("world");
-			saveFile.InsertFirstChild(root);
+			std::partial_sort(found.begin(), found.begin() + k, found.end(), closer);
+			found.resize(k);
 		}
 		else
-			root->DeleteChildren();
+			std::sort(found.begin(), found.end(), closer);
+	}
+	
+	bool World::raycast(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l, RayHit& hit, const Entity* ignore)
+	{
+		hit.fraction = 1;
+		hit.entity = nullptr;
+		hit.tile = {0, 0};
+		hit.hit = tilemap.raycast(from, to, l, hit.tile, hit.fraction);
 		
-		for(auto& e : entities)
+		// only entities nearer than the tile it stopped at
+		const sf::Vector2f delta = to - from;
+		const sf::Vector2f end = from + delta * hit.fraction;
+		const float scale = hit.fraction;
+		
+		physicalSystem.raycast(from, end, [&](unsigned id, float maxFraction)
 		{
-			tinyxml2::XMLElement* entity = saveFile.NewElement("entity");
+			Entity* e = storage.getEntity(id);
+			Physical* p = e ? e->get<Physical>() : nullptr;
+			float fraction;
 			
-			for(auto& c : e->getComponents())
-			{
-				tinyxml2::XMLElement* component = saveFile.NewElement(c.first.c_str());
+			if(!p || e == ignore || !AABBTree::intersectRay({p->position, static_cast<sf::Vector2f>(p->size)}, from, end - from, maxFraction, fraction))
+				return maxFraction;
+			
+			hit.entity = e;
+			hit.fraction = fraction * scale;
+			hit.hit = true;
+			return fraction;
+		});
+		
+		hit.point = from + delta * hit.fraction;
+		
+		return hit.hit;
+	}
+	
+	void World::raycast(const std::vector<Ray>& rays, unsigned int l, std::vector<RayHit>& hits)
+	{
+		hits.resize(rays.size());
+		
+		for(std::size_t i = 0; i < rays.size(); i++)
+			raycast(rays[i].from, rays[i].to, l, hits[i], rays[i].ignore);
+	}
+	
+	bool World::hasLineOfSight(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l) const
+	{
+		return tilemap.hasLineOfSight(from, to, l);
+	}
+	
+	void World::hasLineOfSight(const std::vector<Ray>& rays, unsigned int l, std::vector<unsigned char>& visible)
+	{
+		sightFrom.clear();
+		sightTo.clear();
+		
+		for(auto& r : rays)
+		{
+			sightFrom.push_back(r.from);
+			sightTo.push_back(r.to);
+		}
+		
+		visible.resize(rays.size());
+		tilemap.hasLineOfSight(sightFrom.data(), sightTo.data(), rays.size(), l, visible.data());
+	}
+	
+	void World::setSightLayer(unsigned int l)
+	{
+		sightLayer = l;
+	}
+	
+	bool World::isVisible(unsigned faction, const sf::Vector2f& pos) const
+	{
+		const sf::Vector2u& tileSize = tilemap.getTileSize();
+		
+		if(tileSize.x == 0 || tileSize.y == 0)
+			return false;
+		
+		return visibility.isVisible(faction, static_cast<int>(std::floor(pos.x / tileSize.x)), static_cast<int>(std::floor(pos.y / tileSize.y)));
+	}
+	
+	bool World::isExplored(unsigned faction, const sf::Vector2f& pos) const
+	{
+		const sf::Vector2u& tileSize = tilemap.getTileSize();
+		
+		if(tileSize.x == 0 || tileSize.y == 0)
+			return false;
+		
+		return visibility.isExplored(faction, static_cast<int>(std::floor(pos.x / tileSize.x)), static_cast<int>(std::floor(pos.y / tileSize.y)));
+	}
+	
+	void World::showFog(unsigned faction)
+	{
+		tilemap.setVisibility(&visibility, faction);
+	}
+	
+	void World::hideFog()
+	{
+		tilemap.setVisibility(nullptr, 0);
+	}
+	
+	const VisibilityMap& World::getVisibility() const
+	{
+		return visibility;
+	}
+	
+	void World::addSystem(System& system, const std::string& name, bool lod)
+	{
+		// views live as long as the storage, so the job can keep a pointer
+		View* view = &storage.getView(system.getSignature());
+		
+		if(!lod)
+		{
+			scheduler.add(system, [&system, view](float dt)
+			{
+				system.update(view->getEntities(), dt);
+			}, name);
+			
+			return;
+		}
+		
+		// each job its own, systems may run at the same time
+		std::vector<std::vector<Entity*>> buckets;
+		
+		scheduler.add(system, [this, &system, view, buckets](float dt) mutable
+		{
+			if(!SimulationLod::isEnabled())
+			{
+				system.update(view->getEntities(), dt);
+				return;
+			}
+			
+			this->lod.split(view->getEntities(), buckets);
+			
+			for(std::size_t s = 1; s < buckets.size(); s++)
+			{
+				if(!buckets[s].empty())
+					system.update(buckets[s], dt * s);
+			}
+		}, name);
+	}
+	
+	void World::updateLod()
+	{
+		// something running into a frozen entity wakes it, before the bands are found again
+		for(auto& c : physicalSystem.getContactEvents())
+		{
+			if(c.type != ContactEvent::Type::Begin)
+				continue;
+			
+			Entity* one = getEntity(c.one);
+			Entity* two = getEntity(c.two);
+			
+			if(!one || !two)
+				continue;
+			
+			bool oneFrozen = lod.isFrozen(one->getID());
+			bool twoFrozen = lod.isFrozen(two->getID());
+			
+			if(oneFrozen && !twoFrozen)
+				lod.wake(one->getID(), contactWakeTicks);
+			else if(twoFrozen && !oneFrozen)
+				lod.wake(two->getID(), contactWakeTicks);
+		}
+		
+		lod.begin(storage);
+		
+		queryPositions.clear();
+		
+		for(auto& e : storage.getView<Controllable, Physical>().getEntities())
+			queryPositions.push_back(e->get<Physical>()->position);
+		
+		if(drawn)
+			queryPositions.push_back(drawnCenter);
+		
+		queryPositions.insert(queryPositions.end(), lodFocus.begin(), lodFocus.end());
+		
+		// one broadphase query around each focus, as far as the last band reaches
+		const float reach = SimulationLod::getReach();
+		
+		for(auto& focus : queryPositions)
+		{
+			queryIDs.clear();
+			physicalSystem.query({focus.x - reach, focus.y - reach, reach * 2, reach * 2}, queryIDs);
+			
+			for(auto& id : queryIDs)
+			{
+				Entity* e = storage.getEntity(id);
+				Physical* p = e ? e->get<Physical>() : nullptr;
+				
+				if(p)
+					lod.place(id, math::distanceSquared(p->position, focus));
+			}
+		}
+		
+		lod.finish();
+	}
+	
+	void World::setLodFocus(const std::vector<sf::Vector2f>& points)
+	{
+		lodFocus = points;
+	}
+	
+	void World::wake(EntityHandle e, unsigned ticks)
+	{
+		Entity* entity = getEntity(e);
+		
+		if(entity)
+			lod.wake(entity->getID(), ticks);
+	}
+	
+	const SimulationLod& World::getLod() const
+	{
+		return lod;
+	}
+	
+	std::vector<Entity*>& World::getView(const System& system)
+	{
+		return storage.getView(system.getSignature()).getEntities();
+	}
+	
+	const std::vector<Collision>& World::getCollisions() const
+	{
+		return physicalSystem.getCollisions();
+	}
+	
+	void World::setBroadphase(PhysicalSystem::Broadphase b)
+	{
+		physicalSystem.setBroadphase(b);
+	}
+	
+	bool World::subscribeContacts(EntityHandle e, Script& script)
+	{
+		if(!getEntity(e))
+			return false;
+		
+		std::vector<Script*>& subscribers = contactSubscribers[e.value];
+		
+		if(std::find(subscribers.begin(), subscribers.end(), &script) != subscribers.end())
+			return false;
+		
+		subscribers.push_back(&script);
+		return true;
+	}
+	
+	bool World::unsubscribeContacts(EntityHandle e, Script& script)
+	{
+		auto it = contactSubscribers.find(e.value);
+		
+		if(it == contactSubscribers.end())
+			return false;
+		
+		auto s = std::find(it->second.begin(), it->second.end(), &script);
+		
+		if(s == it->second.end())
+			return false;
+		
+		it->second.erase(s);
+		
+		if(it->second.empty())
+			contactSubscribers.erase(it);
+		
+		return true;
+	}
+	
+	ComponentStorage& World::getStorage()
+	{
+		return storage;
+	}
+	
+	const PoolStats& World::getEntityStats() const
+	{
+		return entityPool.getStats();
+	}
+	
+	void World::insertEntity(Entity* entity)
+	{
+		if(entity->getID() >= positions.size())
+			positions.resize(entity->getID() + 1);
+		
+		positions[entity->getID()] = entities.size();
+		entities.push_back(entity);
+		
+		// named while queued, after the index may have been rebuilt without it
+		if(namesIndexed && entity->has<Name>() && entity->get<Name>()->getID() != 0)
+		{
+			std::vector<EntityHandle>& handles = byName[entity->get<Name>()->getID()];
+			
+			if(std::find(handles.begin(), handles.end(), entity->getHandle()) == handles.end())
+				handles.push_back(entity->getHandle());
+		}
+	}
+	
+	void World::destroyEntity(Entity* entity)
+	{
+		if(namesIndexed && entity->has<Name>())
+		{
+			auto it = byName.find(entity->get<Name>()->getID());
+			
+			if(it != byName.end())
+			{
+				it->second.erase(std::remove(it->second.begin(), it->second.end(), entity->getHandle()), it->second.end());
+				
+				if(it->second.empty())
+					byName.erase(it);
+			}
+		}
+		
+		unsigned pos = positions[entity->getID()];
+		
+		entities[pos] = entities.back();
+		positions[entities[pos]->getID()] = pos;
+		entities.pop_back();
+		
+		entityPool.destroy(entity);
+	}
+	
+	void World::indexNames()
+	{
+		unsigned revision = Name::getRevision();
+		
+		if(namesIndexed && nameRevision == revision)
+			return;
+		
+		byName.clear();
+		
+		for(auto& e : entities)
+		{
+			Name* component = e->has<Name>() ? e->get<Name>() : nullptr;
+			
+			if(component && component->getID() != 0)
+				byName[component->getID()].push_back(e->getHandle());
+		}
+		
+		nameRevision = revision;
+		namesIndexed = true;
+	}
+	
+	void World::flush()
+	{
+		if(commands.empty())
+			return;
+		
+		entities.reserve(entities.size() + commands.getCreated().size());
+		
+		for(auto& e : commands.getCreated())
+			insertEntity(e);
+		
+		// an entity can be queued more than once, the handle stops resolving after the first
+		for(auto& h : commands.getDestroyed())
+		{
+			Entity* entity = getEntity(h);
+			
+			if(entity)
+				destroyEntity(entity);
+		}
+		
+		commands.clear();
+	}
+	
+	void World::dispatchContacts()
+	{
+		if(contactSubscribers.empty())
+			return;
+		
+		for(auto& c : physicalSystem.getContactEvents())
+		{
+			notifyContact(c, c.one, c.two);
+			notifyContact(c, c.two, c.one);
+		}
+		
+		// removed entities' end events went out above, their subscriptions can go now
+		for(auto it = contactSubscribers.begin(); it != contactSubscribers.end();)
+		{
+			EntityHandle handle;
+			handle.value = it->first;
+			
+			if(!getEntity(handle))
+				it = contactSubscribers.erase(it);
+			else
+				++it;
+		}
+	}
+	
+	void World::notifyContact(const ContactEvent& event, EntityHandle self, EntityHandle other)
+	{
+		auto it = contactSubscribers.find(self.value);
+		
+		if(it == contactSubscribers.end())
+			return;
+		
+		// a callback may unsubscribe
+		std::vector<Script*> subscribers = it->second;
+		
+		for(auto& s : subscribers)
+			s->onContact(event.type, self, other);
+	}
+	
+	std::size_t World::getMemory() const
+	{
+		return storage.getMemory() + entities.size() * sizeof(Entity) + entities.capacity() * sizeof(Entity*)
+			+ positions.capacity() * sizeof(unsigned) + tilemap.getMemory();
+	}
+	
+	bool World::load()
+	{
+		SWIFT_PROFILE("World::load");
+		
+		return readSave() && bindSave();
+	}
+	
+	bool World::readSave()
+	{
+		SWIFT_MEMORY_SCOPE(Entities);
+		
+		std::string file = "./data/saves/" + name + ".world";
+		
+		// read in one go, both formats are parsed from memory
+		std::ifstream fin(file, std::ios::binary);
+		std::vector<std::uint8_t> bytes;
+		
+		if(fin)
+			bytes.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+		
+		if(!fin && !fin.eof())
+		{
+			SWIFT_ERROR(World, "Loading world save file \"" << file << "\" failed.\n");
+			return false;
+		}
+		
+		// by their key in the save, which for the full save is their order in it
+		std::vector<Entity*>& byKey = loadedKeys;
+		byKey.clear();
+		
+		ByteReader magic(bytes);
+		bool binary = magic.readUInt32() == SAVE_MAGIC && magic.good();
+		
+		if(!(binary ? loadBinary(bytes, byKey) : loadXml(bytes, byKey)))
+		{
+			SWIFT_ERROR(World, "Loading world save file \"" << file << "\" failed.\n");
+			return false;
+		}
+		
+		// changes saved since the full save
+		journalRecords = readJournal(byKey);
+		
+		// found by queries before the first update
+		for(auto& e : entities)
+			physicalSystem.refit(*e);
+		
+		return true;
+	}
+	
+	bool World::bindSave()
+	{
+		SWIFT_MEMORY_SCOPE(Entities);
+		
+		std::vector<Entity*>& byKey = loadedKeys;
+		saved.clear();
+		
+		// entities mostly share a few textures, each is looked up once
+		std::unordered_map<std::string, std::pair<AssetHandle<sf::Texture>, sf::IntRect>> textures;
+		
+		auto sprite = [&](const std::string& file) -> const std::pair<AssetHandle<sf::Texture>, sf::IntRect>&
+		{
+			auto it = textures.find(file);
+			
+			if(it == textures.end())
+			{
+				sf::IntRect region;
+				AssetHandle<sf::Texture> texture = assets.acquireSprite(file, region);
+				it = textures.emplace(file, std::make_pair(texture, region)).first;
+			}
+			
+			return it->second;
+		};
+		
+		for(unsigned key = 0; key < byKey.size(); key++)
+		{
+			Entity* entity = byKey[key];
+			
+			if(entity == nullptr)
+				continue;
+			
+			if(entity->has<Drawable>())
+			{
+				Drawable* draw = entity->get<Drawable>();
+				auto& texture = sprite(draw->texture);
+				draw->setTexture(texture.first, texture.second);
+			}
+			
+			if(entity->has<Animated>())
+			{
+				Animated* anim = entity->get<Animated>();
+				AnimTexture* animTex = assets.getAnimTexture(anim->animationFile);
+				
+				if(animTex)
+				{
+					auto& texture = sprite(animTex->getTextureFile());
+					anim->setAnimTexture(*animTex, texture.first, texture.second);
+				}
+			}
+		}
+		
+		// what the journal compares against, written out and hashed for each entity over the thread pool
+		std::vector<std::uint64_t> hashes(byKey.size(), 0);
+		
+		SystemScheduler::parallelFor(byKey.size(), [&](std::size_t begin, std::size_t end)
+		{
+			ByteWriter data;
+			
+			for(std::size_t key = begin; key < end; key++)
+			{
+				if(byKey[key] == nullptr)
+					continue;
+				
+				data.clear();
+				writeEntity(*byKey[key], data);
+				hashes[key] = hash(data.getData());
+			}
+		});
+		
+		for(unsigned key = 0; key < byKey.size(); key++)
+		{
+			if(byKey[key])
+				saved.emplace(byKey[key]->getHandle().value, SavedEntity{key, hashes[key]});
+		}
+		
+		nextSaveKey = byKey.size();
+		hasFullSave = true;
+		
+		byKey.clear();
+		byKey.shrink_to_fit();
+		
+		return true;
+	}
+	
+	void World::bindAssets(Entity& entity)
+	{
+		sf::IntRect region;
+		
+		if(entity.has<Drawable>())
+		{
+			Drawable* draw = entity.get<Drawable>();
+			AssetHandle<sf::Texture> texture = assets.acquireSprite(draw->texture, region);
+			draw->setTexture(texture, region);
+		}
+		
+		if(entity.has<Animated>())
+		{
+			Animated* anim = entity.get<Animated>();
+			AnimTexture* animTex = assets.getAnimTexture(anim->animationFile);
+			
+			if(animTex)
+			{
+				AssetHandle<sf::Texture> texture = assets.acquireSprite(animTex->getTextureFile(), region);
+				anim->setAnimTexture(*animTex, texture, region);
+			}
+		}
+	}
+	
+	bool World::save()
+	{
+		SWIFT_PROFILE("World::save");
+		
+		// a journal missing a write can't be replayed onto the full save
+		if(*saveFailed)
+		{
+			*saveFailed = false;
+			hasFullSave = false;
+		}
+		
+		// the journal is folded back into the full save once replaying it would cost more than the save itself
+		if(!hasFullSave || journalRecords > std::max<std::size_t>(64, entities.size()))
+			return saveFull();
+		else
+			return saveJournal();
+	}
+	
+	bool World::saveFull()
+	{
+		std::string file = "./data/saves/" + name + ".world";
+		
+		// put together here, written on the writer's thread
+		std::vector<std::uint8_t> data = saveFormat == SaveFormat::Binary ? writeBinary() : writeXml();
+		
+		// everything in the journal is in the full save now. Written after it, so a crash between them only replays changes already saved
+		if(!writeFile(file, std::move(data), AsyncWriter::Mode::Replace) || !writeFile(getJournalFile(), {}, AsyncWriter::Mode::Replace))
+			return false;
+		
+		saved.clear();
+		
+		for(unsigned key = 0; key < entities.size(); key++)
+		{
+			ByteWriter data;
+			writeEntity(*entities[key], data);
+			saved.emplace(entities[key]->getHandle().value, SavedEntity{key, hash(data.getData())});
+		}
+		
+		nextSaveKey = entities.size();
+		journalRecords = 0;
+		hasFullSave = true;
+		
+		return true;
+	}
+	
+	bool World::saveJournal()
+	{
+		ByteWriter out;
+		unsigned records = 0;
+		
+		// records are length prefixed, so a record cut short by a crash is dropped on load instead of corrupting the rest
+		auto beginRecord = [&out](JournalOp op, unsigned key)
+		{
+			std::size_t start = out.size();
+			out.writeUInt32(0);
+			out.writeByte(static_cast<std::uint8_t>(op));
+			out.writeUInt(key);
+			return start;
+		};
+		
+		auto endRecord = [&out, &records](std::size_t start)
+		{
+			out.patchUInt32(start, out.size() - start - 4);
+			records++;
+		};
+		
+		ByteWriter data;
+		
+		for(auto& e : entities)
+		{
+			data.clear();
+			writeEntity(*e, data);
+			std::uint64_t h = hash(data.getData());
+			
+			auto it = saved.find(e->getHandle().value);
+			
+			// unchanged since it was last written
+			if(it != saved.end() && it->second.hash == h)
+				continue;
+			
+			if(it == saved.end())
+				it = saved.emplace(e->getHandle().value, SavedEntity{nextSaveKey++, 0}).first;
+			
+			it->second.hash = h;
+			
+			std::size_t start = beginRecord(JournalOp::Entity, it->second.key);
+			out.writeBytes(data.getData().data(), data.size());
+			endRecord(start);
+		}
+		
+		// saved entities that have been removed since
+		for(auto it = saved.begin(); it != saved.end();)
+		{
+			EntityHandle handle;
+			handle.value = it->first;
+			
+			if(getEntity(handle))
+			{
+				++it;
+				continue;
+			}
+			
+			endRecord(beginRecord(JournalOp::Remove, it->second.key));
+			it = saved.erase(it);
+		}
+		
+		if(records == 0)
+			return true;
+		
+		// new journals start with their magic number
+		ByteWriter header;
+		header.writeUInt32(JOURNAL_MAGIC);
+		
+		if(!writeFile(getJournalFile(), out.getData(), AsyncWriter::Mode::Append, header.getData()))
+			return false;
+		
+		journalRecords += records;
+		
+		return true;
+	}
+	
+	unsigned World::readJournal(std::vector<Entity*>& byKey)
+	{
+		std::string file = getJournalFile();
+		std::ifstream fin(file, std::ios::binary);
+		
+		if(!fin)
+			return 0;
+		
+		std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		
+		if(bytes.empty())
+			return 0;
+		
+		ByteReader in(bytes);
+		
+		if(in.readUInt32() != JOURNAL_MAGIC)
+		{
+			SWIFT_WARNING(World, "World journal \"" << file << "\" is not a journal, ignoring it.\n");
+			return 0;
+		}
+		
+		unsigned records = 0;
+		
+		while(in.remaining() >= 4)
+		{
+			std::uint32_t length = in.readUInt32();
+			
+			if(length > in.remaining())
+			{
+				SWIFT_WARNING(World, "World journal \"" << file << "\" ends in an incomplete record, ignoring it.\n");
+				break;
+			}
+			
+			ByteReader record(bytes.data() + in.getPosition(), length);
+			in.skip(length);
+			records++;
+			
+			JournalOp op = static_cast<JournalOp>(record.readByte());
+			unsigned key = record.readUInt();
+			
+			if(!record.good())
+				continue;
+			
+			if(key >= byKey.size())
+				byKey.resize(key + 1, nullptr);
+			
+			// a record replaces the whole entity
+			if(byKey[key])
+			{
+				removeEntity(byKey[key]->getHandle());
+				byKey[key] = nullptr;
+			}
+			
+			if(op != JournalOp::Entity)
+				continue;
+			
+			Entity* entity = addEntity();
+			byKey[key] = entity;
+			
+			std::uint64_t count = record.readUInt();
+			
+			for(std::uint64_t c = 0; c < count && record.good(); c++)
+			{
+				std::string componentName = record.readString();
+				
+				// components are self describing only through their reader, an unknown one ends the record
+				if(!entity->add(componentName) || !entity->get(componentName)->read(record))
+				{
+					SWIFT_WARNING(World, "Could not read component \"" << componentName << "\" in world journal \"" << file << "\".\n");
+					break;
+				}
+			}
+		}
+		
+		return records;
+	}
+	
+	bool World::loadXml(const std::vector<std::uint8_t>& bytes, std::vector<Entity*>& byKey)
+	{
+		tinyxml2::XMLDocument loadFile;
+		loadFile.Parse(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		
+		if(loadFile.Error())
+			return false;
+		
+		tinyxml2::XMLElement* worldRoot = loadFile.FirstChildElement("world");
+		if(worldRoot == nullptr)
+		{
+			SWIFT_WARNING(World, "World save file for \"" << name << "\" does not have a \"world\" root element.\n");
+			return false;
+		}
+		
+		// by entity and type, with the element they're read from once they're all made
+		struct Read
+		{
+			unsigned entity;
+			unsigned type;
+			const tinyxml2::XMLElement* element;
+		};
+		
+		std::vector<Read> reads;
+		
+		tinyxml2::XMLElement* entityElement = worldRoot->FirstChildElement("entity");
+		while(entityElement != nullptr)
+		{
+			Entity* entity = addEntity();
+			byKey.push_back(entity);
+			
+			tinyxml2::XMLElement* component = entityElement->FirstChildElement();
+			while(component != nullptr)
+			{
+				std::string componentName = component->Value();
+				entity->add(componentName);
+				
+				if(!entity->has(componentName))
+				{
+					SWIFT_WARNING(World, "Unknown component \"" << componentName << "\" in world save file for \"" << name << "\".\n");
+					component = component->NextSiblingElement();
+					continue;
+				}
+				
+				reads.push_back({entity->getID(), ComponentRegistry::getID(componentName), component});
+				
+				component = component->NextSiblingElement();
+			}
+			
+			entityElement = entityElement->NextSiblingElement("entity");
+		}
+		
+		// parsing the values is most of the work, and the components no longer move
+		SystemScheduler::parallelFor(reads.size(), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t r = begin; r < end; r++)
+			{
+				std::map<std::string, std::string> variables;
+				const tinyxml2::XMLElement* variableElement = reads[r].element->FirstChildElement();
+				while(variableElement != nullptr)
+				{
+					// make sure the strings aren't empty...
+					if(std::string(variableElement->Value()).size() > 0 && variableElement->GetText() && std::string(variableElement->GetText()).size() > 0)
+						variables.emplace(variableElement->Value(), variableElement->GetText());
+					variableElement = variableElement->NextSiblingElement();
+				}
+				
+				storage.get(reads[r].entity, reads[r].type)->unserialize(variables);
+			}
+		});
+		
+		return true;
+	}
+	
+	bool World::loadBinary(const std::vector<std::uint8_t>& bytes, std::vector<Entity*>& byKey)
+	{
+		ByteReader in(bytes);
+		in.readUInt32();
+		
+		unsigned version = in.readByte();
+		
+		if(version > SAVE_VERSION)
+		{
+			SWIFT_ERROR(World, "World save file for \"" << name << "\" is from a newer version.\n");
+			return false;
+		}
+		
+		StringTable strings;
+		
+		if(!strings.read(in))
+			return false;
+		
+		in.setStringTable(&strings);
+		
+		if(version < 2)
+			return loadEntities(in, strings, byKey);
+		
+		// component names are resolved once per name, not once per component
+		std::vector<unsigned> types(strings.size(), MAX_COMPONENTS + 1);
+		
+		std::uint64_t count = in.readUInt();
+		
+		// every entity takes at least a byte
+		if(count > in.remaining())
+			return false;
+		
+		entities.reserve(entities.size() + count);
+		byKey.reserve(count);
+		
+		// each component, by entity and type, in the order what's in them was written
+		std::vector<std::pair<unsigned, unsigned>> order;
+		
+		struct Block
+		{
+			std::size_t offset;		// of what's in its components, in bytes
+			std::size_t size;
+			std::size_t first;		// of its components in order
+			std::size_t last;
+		};
+		
+		std::vector<Block> blocks;
+		blocks.reserve(count / SAVE_BLOCK + 1);
+		
+		std::size_t loaded = 0;
+		
+		while(loaded < count && in.good())
+		{
+			std::uint64_t size = in.readUInt();
+			
+			if(size == 0 || size > count - loaded)
+				return false;
+			
+			Block block;
+			block.first = order.size();
+			
+			for(std::uint64_t e = 0; e < size && in.good(); e++)
+			{
+				Entity* entity = addEntity();
+				byKey.push_back(entity);
+				
+				std::uint64_t components = in.readUInt();
+				
+				for(std::uint64_t c = 0; c < components && in.good(); c++)
+				{
+					unsigned index = in.readStringIndex();
+					
+					if(!in.good())
+						break;
+					
+					if(types[index] == MAX_COMPONENTS + 1)
+						types[index] = ComponentRegistry::getID(*strings.get(index));
+					
+					if(types[index] >= MAX_COMPONENTS || storage.add(entity->getID(), types[index]) == nullptr)
+					{
+						SWIFT_ERROR(World, "Could not read component \"" << *strings.get(index) << "\" in world save file for \"" << name << "\".\n");
+						return false;
+					}
+					
+					order.emplace_back(entity->getID(), types[index]);
+				}
+			}
+			
+			block.last = order.size();
+			block.size = in.readUInt();
+			block.offset = in.getPosition();
+			
+			if(!in.skip(block.size))
+				return false;
+			
+			blocks.push_back(block);
+			loaded += size;
+		}
+		
+		if(!in.good())
+			return false;
+		
+		// every component is made, so none moves while the blocks are read into them, each by whichever thread
+		std::vector<std::uint8_t> failed(blocks.size(), 0);
+		
+		SystemScheduler::parallelFor(blocks.size(), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t b = begin; b < end; b++)
+			{
+				const Block& block = blocks[b];
+				
+				ByteReader data(bytes.data() + block.offset, block.size);
+				data.setStringTable(&strings);
+				
+				for(std::size_t i = block.first; i < block.last && data.good(); i++)
+					storage.get(order[i].first, order[i].second)->read(data);
+				
+				failed[b] = !data.good();
+			}
+		});
+		
+		for(std::size_t b = 0; b < blocks.size(); b++)
+		{
+			if(failed[b])
+			{
+				SWIFT_ERROR(World, "Could not read the components of entities " << b * SAVE_BLOCK << " on in world save file for \"" << name << "\".\n");
+				return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	bool World::loadEntities(ByteReader& in, const StringTable& strings, std::vector<Entity*>& byKey)
+	{
+		// component names are resolved once per name, not once per component
+		std::vector<unsigned> types(strings.size(), MAX_COMPONENTS + 1);
+		
+		std::uint64_t count = in.readUInt();
+		
+		// every entity takes at least a byte
+		if(count > in.remaining())
+			return false;
+		
+		entities.reserve(entities.size() + count);
+		byKey.reserve(count);
+		
+		for(std::uint64_t e = 0; e < count && in.good(); e++)
+		{
+			Entity* entity = addEntity();
+			byKey.push_back(entity);
+			
+			std::uint64_t components = in.readUInt();
+			
+			for(std::uint64_t c = 0; c < components && in.good(); c++)
+			{
+				unsigned index = in.readStringIndex();
+				
+				if(!in.good())
+					break;
+				
+				if(types[index] == MAX_COMPONENTS + 1)
+					types[index] = ComponentRegistry::getID(*strings.get(index));
+				
+				// components don't store their size, so one that can't be read ends the load
+				Component* component = types[index] < MAX_COMPONENTS ? storage.add(entity->getID(), types[index]) : nullptr;
+				
+				if(component == nullptr || !component->read(in))
+				{
+					SWIFT_ERROR(World, "Could not read component \"" << *strings.get(index) << "\" in world save file for \"" << name << "\".\n");
+					return false;
+				}
+			}
+		}
+		
+		return in.good();
+	}
+	
+	std::vector<std::uint8_t> World::writeBinary() const
+	{
+		StringTable strings;
+		
+		ByteWriter body;
+		body.setStringTable(&strings);
+		body.writeUInt(entities.size());
+		
+		ByteWriter data;
+		data.setStringTable(&strings);
+		
+		for(std::size_t first = 0; first < entities.size(); first += SAVE_BLOCK)
+		{
+			std::size_t last = std::min(first + SAVE_BLOCK, entities.size());
+			body.writeUInt(last - first);
+			
+			// the names ahead of what's in them, so loading can make every component before reading any
+			for(std::size_t e = first; e < last; e++)
+			{
+				const Entity& entity = *entities[e];
+				body.writeUInt(entity.getMask().count());
+				
+				for(unsigned id = 0; id < MAX_COMPONENTS; id++)
+				{
+					if(!entity.getMask().test(id))
+						continue;
+					
+					body.writeString(ComponentRegistry::getName(id));
+					entity.get(id)->write(data);
+				}
+			}
+			
+			body.writeUInt(data.size());
+			body.writeBytes(data.getData().data(), data.size());
+			data.clear();
+		}
+		
+		ByteWriter out;
+		out.writeUInt32(SAVE_MAGIC);
+		out.writeByte(SAVE_VERSION);
+		strings.write(out);
+		out.writeBytes(body.getData().data(), body.size());
+		
+		return out.getData();
+	}
+	
+	std::vector<std::uint8_t> World::writeXml() const
+	{
+		tinyxml2::XMLDocument saveFile;
+		tinyxml2::XMLElement* root = saveFile.NewElement("world");
+		saveFile.InsertFirstChild(root);
+		
+		for(auto& e : entities)
+		{
+			tinyxml2::XMLElement* entity = saveFile.NewElement("entity");
+			
+			for(unsigned id = 0; id < MAX_COMPONENTS; id++)
+			{
+				if(!e->getMask().test(id))
+					continue;
+				
+				tinyxml2::XMLElement* component = saveFile.NewElement(ComponentRegistry::getName(id).c_str());
 				
-				for(auto& v : c.second->serialize())
+				for(auto& v : e->get(id)->serialize())
 				{
 					tinyxml2::XMLElement* variable = saveFile.NewElement(v.first.c_str());
 					variable->SetText(v.second.c_str());
@@ -312,8 +1741,73 @@ namespace swift
 			root->InsertEndChild(entity);
 		}
 		
-		saveFile.SaveFile(file.c_str());
+		tinyxml2::XMLPrinter printer;
+		saveFile.Print(&printer);
 		
-		return true;
+		const char* text = printer.CStr();
+		return std::vector<std::uint8_t>(text, text + printer.CStrSize() - 1);
+	}
+	
+	std::string World::getJournalFile() const
+	{
+		return "./data/saves/" + name + ".journal";
+	}
+	
+	bool World::writeFile(const std::string& file, std::vector<std::uint8_t> data, AsyncWriter::Mode mode, std::vector<std::uint8_t> header)
+	{
+		if(writer)
+		{
+			std::shared_ptr<bool> failed = saveFailed;
+			
+			writer->queue(file, std::move(data), mode, [failed](bool ok)
+			{
+				if(!ok)
+					*failed = true;
+			}, std::move(header));
+			
+			return true;
+		}
+		
+		if(AsyncWriter::write(file, data, mode, header))
+			return true;
+		
+		SWIFT_ERROR(World, "Writing \"" << file << "\" failed.\n");
+		*saveFailed = true;
+		
+		return false;
+	}
+	
+	void World::setAsyncWriter(AsyncWriter& w)
+	{
+		writer = &w;
+	}
+	
+	void World::setSaveFormat(SaveFormat f)
+	{
+		saveFormat = f;
+	}
+	
+	World::SaveFormat World::getSaveFormat()
+	{
+		return saveFormat;
+	}
+	
+	void World::writeEntity(const Entity& e, ByteWriter& out)
+	{
+		out.writeUInt(e.getMask().count());
+		
+		for(unsigned id = 0; id < MAX_COMPONENTS; id++)
+		{
+			if(!e.getMask().test(id))
+				continue;
+			
+			out.writeString(ComponentRegistry::getName(id));
+			e.get(id)->write(out);
+		}
+	}
+	
+	std::uint64_t World::hash(const std::vector<std::uint8_t>& data)
+	{
+		return math::hash(data.data(), data.size());
 	}
 }
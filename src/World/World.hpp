@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
 
 /* SFML */
 #include <SFML/System/Vector2.hpp>
@@ -15,6 +17,12 @@
 
 /* Entity */
 #include "../EntitySystem/Entity.hpp"
+#include "../EntitySystem/Prefab.hpp"
+#include "../Memory/ObjectPool.hpp"
+#include "../EntitySystem/CommandBuffer.hpp"
+#include "../EntitySystem/SystemScheduler.hpp"
+#include "../EntitySystem/RenderList.hpp"
+#include "../EntitySystem/SimulationLod.hpp"
 
 #include "../EntitySystem/Systems/AnimatedSystem.hpp"
 #include "../EntitySystem/Systems/ControllableSystem.hpp"
@@ -22,9 +30,18 @@
 #include "../EntitySystem/Systems/MovableSystem.hpp"
 #include "../EntitySystem/Systems/PathfinderSystem.hpp"
 #include "../EntitySystem/Systems/PhysicalSystem.hpp"
+#include "../EntitySystem/Systems/SteeringSystem.hpp"
 #include "../EntitySystem/Systems/NoisySystem.hpp"
 
+#include "../Lighting/LightMap.hpp"
+#include "../Particles/ParticleSystem.hpp"
+
+#include "../Serialization/AsyncWriter.hpp"
+
 #include "../Mapping/TileMap.hpp"
+#include "../Mapping/VisibilityMap.hpp"
+#include "../Pathfinding/PathService.hpp"
+#include "../Pathfinding/FlowFieldCache.hpp"
 
 #include "../SoundSystem/MusicPlayer.hpp"
 #include "../SoundSystem/SoundPlayer.hpp"
@@ -36,34 +53,190 @@ namespace swift
 		public:
 			World(const std::string& n, AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, const std::vector<std::string>& scriptFiles);
 			virtual ~World();
-
+			
 			virtual void update(float dt);
 			
+			// update in its steps: systems, then scripts, then removing done scripts and applying structural changes.
+			// updateSystems and updateScripts of different worlds may run on different threads at once, as WorldScheduler
+			// runs them. finishUpdate is for the main thread
+			void updateSystems(float dt);
+			void updateScripts(float dt);
+			void finishUpdate();
+			
 			bool addScript(const std::string& scriptFile);
 			bool removeScript(const std::string& scriptFile);
-
+			const std::map<std::string, Script*>& getScripts() const;
+			
 			void drawWorld(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default);
+			// only entities the physics broadphase has near the target's view are visited. Entities given a Physical
+			// since the last update are drawn from the next one
 			void drawEntities(sf::RenderTarget& target, float e, sf::RenderStates states = sf::RenderStates::Default);
 			
+			// how far outside of the view entities are still drawn, for sprites bigger than their entity's bounds
+			void setCullMargin(float m);
+			
+			// darkens what's been drawn so far to the light map's ambient, then lights it up around Luminous entities
+			void drawLights(sf::RenderTarget& target, float e, sf::RenderStates states = sf::RenderStates::Default);
+			
+			// for the ambient light and the light map's scale
+			LightMap& getLightMap();
+			
+			// updated after the systems, and drawn over the entities by drawEntities
+			ParticleSystem& getParticles();
+			
 			const std::string& getName() const;
-
+			
+			// while the world is updating, new entities only show up in getEntities() once the update is done,
+			// and removed entities are destroyed at the end of the update
 			Entity* addEntity();
+			
+			// removing swaps the last entity into the freed position, so indices are not stable. Use handles to keep track of entities
 			bool removeEntity(int e);
+			bool removeEntity(EntityHandle e);
+			
+			// count copies of prefab, the first positions.size() of them moved to positions, the rest where the prefab has them.
+			// pools are grown once for all of them. spawned is cleared first
+			void spawn(Prefab& prefab, unsigned count, const std::vector<sf::Vector2f>& positions, std::vector<Entity*>& spawned);
 			
 			Entity* getEntity(int e) const;
+			
+			// nullptr if the entity was removed
+			Entity* getEntity(EntityHandle e) const;
 			const std::vector<Entity*>& getEntities() const;
-
+			
+			// entities with a Name of name, found through an index by NameTable id instead of comparing every entity's
+			std::vector<Entity*> findByName(const std::string& name);
+			
+			// keeps the index up to date, instead of it being rebuilt on the next lookup. False if entity has no Name
+			bool setName(Entity* entity, const std::string& name);
+			
+			// looked up in the physics broadphase, entities moved outside of the systems are found once they're refit
 			const std::vector<Entity*> getEntitiesAround(const sf::Vector2f& pos, float radius);
 			const std::vector<unsigned> getEntitiesAroundIDs(const sf::Vector2f& pos, float radius);
 			
-			const std::vector<Collision*> getCollisions() const;
-
+			// the same lookups, into a buffer the caller keeps, which is cleared first. Positions are an entity's Physical position
+			void queryRadius(const sf::Vector2f& pos, float radius, std::vector<Entity*>& found);
+			void queryArea(const sf::FloatRect& area, std::vector<Entity*>& found);
+			
+			// up to k entities closest to pos, nearest first, no further than maxRadius
+			void queryNearest(const sf::Vector2f& pos, unsigned k, float maxRadius, std::vector<Entity*>& found);
+			
+			// updates the broadphase after an entity's Physical was given, moved, or resized outside of the systems, so
+			// queries find it before the next update. Spawns, loads, and transfers do it themselves. p is found by its pool
+			void refit(const Entity& e);
+			void refit(const Physical& p);
+			
+			struct Ray
+			{
+				sf::Vector2f from;
+				sf::Vector2f to;
+				const Entity* ignore;	// usually what casts it, so it doesn't hit itself. nullptr for none
+			};
+			
+			struct RayHit
+			{
+				sf::Vector2f point;		// where the ray stopped, its end if nothing was in the way
+				float fraction;			// how far along the ray point is
+				Entity* entity;			// what it hit, nullptr for a tile or nothing
+				sf::Vector2i tile;		// the tile it hit, if it hit one and not an entity
+				bool hit;
+			};
+			
+			// stops at the nearer of the impassable tiles of layer l and the unrotated boxes of Physical entities,
+			// found through the physics broadphase as other queries are. Returns hit.hit
+			bool raycast(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l, RayHit& hit, const Entity* ignore = nullptr);
+			
+			// hits[i] for rays[i]. hits is resized to fit
+			void raycast(const std::vector<Ray>& rays, unsigned int l, std::vector<RayHit>& hits);
+			
+			// only tiles block sight, entities don't
+			bool hasLineOfSight(const sf::Vector2f& from, const sf::Vector2f& to, unsigned int l) const;
+			
+			// visible[i] is 1 if rays[i] is clear, ignore isn't used. Split across the tilemap's thread pool
+			void hasLineOfSight(const std::vector<Ray>& rays, unsigned int l, std::vector<unsigned char>& visible);
+			
+			// Sighted entities see through the passable tiles of layer l, 0 by default
+			void setSightLayer(unsigned int l);
+			
+			// by a Sighted entity of faction now, or ever, at pos in pixels. Views are updated with the systems
+			bool isVisible(unsigned faction, const sf::Vector2f& pos) const;
+			bool isExplored(unsigned faction, const sf::Vector2f& pos) const;
+			
+			// draws the tilemap fogged as faction sees it, or without fog again
+			void showFog(unsigned faction);
+			void hideFog();
+			
+			const VisibilityMap& getVisibility() const;
+			
+			// with SimulationLod bands set, entities run less often the further they are from Controllable entities,
+			// the last drawn view, and these points. Replaces the last ones
+			void setLodFocus(const std::vector<sf::Vector2f>& points);
+			
+			// runs e every tick for the next ticks however far it is. Frozen entities are also woken when an entity that isn't runs into them
+			void wake(EntityHandle e, unsigned ticks);
+			
+			const SimulationLod& getLod() const;
+			
+			const std::vector<Collision>& getCollisions() const;
+			
+			void setBroadphase(PhysicalSystem::Broadphase b);
+			
+			// script gets told when e begins, keeps, or stops touching other entities. Scripts only
+			// hear about entities they subscribed to, instead of searching all collisions
+			bool subscribeContacts(EntityHandle e, Script& script);
+			bool unsubscribeContacts(EntityHandle e, Script& script);
+			
+			// component pools, for stats and reserving
+			ComponentStorage& getStorage();
+			const PoolStats& getEntityStats() const;
+			
+			// bytes held by entities, their components, and the tilemap's tiles and vertices. An estimate, textures
+			// are shared through the asset manager and not counted
+			std::size_t getMemory() const;
+			
 			virtual bool load();
+			
+			// load in two halves, so the first can run off the main thread. readSave reads the save file and its journal
+			// into entities without touching the assets or scripts, bindSave then gives them their textures and animations
+			bool readSave();
+			bool bindSave();
+			
+			// gives an entity whose components were read, not loaded from a prefab, its texture and animation
+			void bindAssets(Entity& entity);
+			
+			// only entities that changed since they were last saved are written, appended to a journal next to the
+			// save file. Once the journal grows past the world's size, the whole world is saved again instead
 			virtual bool save();
-
+			
+			// saves are written on the writer's thread once they've been put together. Without one, save writes them itself
+			static void setAsyncWriter(AsyncWriter& w);
+			
+			// how full saves are written. Binary loads fastest, XML is for editing and debugging. Either loads
+			enum class SaveFormat
+			{
+				Binary,
+				Xml
+			};
+			
+			static void setSaveFormat(SaveFormat f);
+			static SaveFormat getSaveFormat();
+			
 			TileMap tilemap;
-
+			
+			// solves the path system's requests on its own thread
+			PathService pathService;
+			
+			// shared between the path system's FlowField entities
+			FlowFieldCache flowFields;
+		
 		protected:
+			// entities matching the system's signature
+			std::vector<Entity*>& getView(const System& system);
+			
+			// schedules system to be updated with its view. name is what stats show it as.
+			// lod systems are only given the entities due this tick, once for each step they're given
+			void addSystem(System& system, const std::string& name, bool lod = true);
+			
 			AssetManager& assets;
 			SoundPlayer& soundPlayer;
 			MusicPlayer& musicPlayer;
@@ -73,15 +246,144 @@ namespace swift
 			DrawableSystem drawSystem;
 			MovableSystem moveSystem;
 			PathfinderSystem pathSystem;
+			SteeringSystem steerSystem;
 			PhysicalSystem physicalSystem;
 			NoisySystem noisySystem;
 			
+			// the sprites of both animSystem's and drawSystem's entities, in the order they're drawn
+			RenderList renderList;
+			float cullMargin;
+			
+			LightMap lightMap;
+			
+			ParticleSystem particles;
+			
+			// what each faction's Sighted entities see of the sight layer
+			VisibilityMap visibility;
+			std::vector<VisibilityMap::Viewer> viewers;
+			unsigned int sightLayer;
+			
+			SimulationLod lod;
+			std::vector<sf::Vector2f> lodFocus;
+			sf::Vector2f drawnCenter;
+			bool drawn;
+			
+			// reused by every query
+			std::vector<unsigned> queryIDs;
+			std::vector<Entity*> queryEntities;
+			std::vector<sf::Vector2f> queryPositions;
+			std::vector<float> queryDistances;
+			std::vector<sf::Vector2f> sightFrom;
+			std::vector<sf::Vector2f> sightTo;
+			
+			// reused every draw
+			std::vector<unsigned> visibleIDs;
+			std::vector<Entity*> visibleDrawables;
+			std::vector<Entity*> visibleAnimateds;
+			
+			// must outlive entities
+			ComponentStorage storage;
+			ObjectPool<Entity> entityPool;
 			std::vector<Entity*> entities;
-
+			
+			// indexed by entity id, position in entities
+			std::vector<unsigned> positions;
+			
+			// structural changes made during update
+			CommandBuffer commands;
+			bool updating;
+			
+			SystemScheduler scheduler;
+		
 		private:
+			void insertEntity(Entity* entity);
+			void destroyEntity(Entity* entity);
+			
+			// rebuilds byName if any name was set or copied without setName since it was built
+			void indexNames();
+			
+			// applies the changes recorded in commands
+			void flush();
+			
+			// bands every entity before the systems run
+			void updateLod();
+			
+			// passes the physical system's contact events to subscribed scripts
+			void dispatchContacts();
+			
+			void notifyContact(const ContactEvent& event, EntityHandle self, EntityHandle other);
+			
+			enum class JournalOp : std::uint8_t
+			{
+				Entity = 1,		// followed by the entity's components, replacing what was saved for the key
+				Remove = 2
+			};
+			
+			static const std::uint32_t JOURNAL_MAGIC = 0x4a575753;	// "SWWJ"
+			static const std::uint32_t SAVE_MAGIC = 0x42575753;		// "SWWB"
+			static const std::uint8_t SAVE_VERSION = 2;
+			
+			// entities of a block of a binary save, from version 2
+			static const std::size_t SAVE_BLOCK = 32;
+			
+			// full saves, appending to byKey in the order entities were saved. Entities and their components are made
+			// on this thread, then what's in the components is read over the thread pool
+			bool loadXml(const std::vector<std::uint8_t>& bytes, std::vector<Entity*>& byKey);
+			bool loadBinary(const std::vector<std::uint8_t>& bytes, std::vector<Entity*>& byKey);
+			
+			// version 1 binary saves, the components of each entity right after their names, read one after the other
+			bool loadEntities(ByteReader& in, const StringTable& strings, std::vector<Entity*>& byKey);
+			
+			// a string table of component, texture, and sound names, then blocks of entities: the names of each one's
+			// components, then the size of what's in them and what's in them, so the blocks can be read in parallel
+			std::vector<std::uint8_t> writeBinary() const;
+			std::vector<std::uint8_t> writeXml() const;
+			
+			bool saveFull();
+			bool saveJournal();
+			
+			// replays the journal over the entities loaded from the full save, returns how many records it had
+			unsigned readJournal(std::vector<Entity*>& byKey);
+			
+			std::string getJournalFile() const;
+			
+			// through the writer if there is one. A failed write makes the next save a full one
+			bool writeFile(const std::string& file, std::vector<std::uint8_t> data, AsyncWriter::Mode mode, std::vector<std::uint8_t> header = {});
+			
+			// the entity's components in their binary form, what's hashed to tell if it changed
+			static void writeEntity(const Entity& e, ByteWriter& out);
+			static std::uint64_t hash(const std::vector<std::uint8_t>& data);
+			
+			struct SavedEntity
+			{
+				unsigned key;			// which entity in the save it is, stays the same between saves
+				std::uint64_t hash;		// of what was saved
+			};
+			
+			// by handle value
+			std::unordered_map<std::uint32_t, SavedEntity> saved;
+			unsigned nextSaveKey;
+			unsigned journalRecords;	// since the last full save
+			std::vector<Entity*> loadedKeys;	// by key, between readSave and bindSave
+			bool hasFullSave;
+			
+			// shared with the writer's callbacks, which may run after the world is gone
+			std::shared_ptr<bool> saveFailed;
+			
+			static AsyncWriter* writer;
+			static SaveFormat saveFormat;
+			
 			std::string name;
 			
 			std::map<std::string, Script*> scripts;
+			
+			// handles by Name id. Entries may have been renamed or lost their Name since, lookups check
+			std::unordered_map<unsigned, std::vector<EntityHandle>> byName;
+			unsigned nameRevision;		// Name's, when byName was last up to date
+			bool namesIndexed;
+			
+			// scripts subscribed to an entity's contacts, by handle value
+			std::unordered_map<std::uint32_t, std::vector<Script*>> contactSubscribers;
 	};
 }
 
@@ -0,0 +1,319 @@
+#include "WorldBenchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+#ifdef __linux__
+	#include <sys/resource.h>
+#elif _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#endif
+
+#include <SFML/System/Clock.hpp>
+
+#include "../Mapping/TileGenerator.hpp"
+#include "../Profiling/FrameStats.hpp"
+#include "../Logger/Logger.hpp"
+
+namespace swift
+{
+	namespace
+	{
+		// ticks run before measuring, while the map's first chunks are made and the first paths requested
+		const unsigned warmupTicks = 30;
+		
+		// tiles per entity, so each size is as crowded as the others
+		const unsigned tilesPerEntity = 16;
+		
+		const float tickTime = 1 / 60.f;
+		
+		// what entities are made of, and how many out of 100 are each
+		struct Archetype
+		{
+			const char* components;
+			unsigned share;
+			bool moves;
+			bool paths;
+		};
+		
+		const Archetype archetypes[] =
+		{
+			{"<Physical><sizeX>16</sizeX><sizeY>16</sizeY></Physical><Movable><moveVelocity>48</moveVelocity></Movable><Drawable><texture>$texture</texture></Drawable>", 45, true, false},
+			{"<Physical><sizeX>16</sizeX><sizeY>16</sizeY></Physical><Movable><moveVelocity>32</moveVelocity></Movable><Animated><animation>$animation</animation></Animated>", 25, true, false},
+			{"<Physical><sizeX>16</sizeX><sizeY>16</sizeY></Physical><Movable><moveVelocity>64</moveVelocity></Movable><Drawable><texture>$texture</texture></Drawable><Pathfinder><algorithm>jps</algorithm></Pathfinder>", 5, false, true},
+			{"<Physical><sizeX>32</sizeX><sizeY>32</sizeY></Physical><Drawable><texture>$texture</texture></Drawable>", 25, false, false},
+		};
+		
+		std::string replace(std::string text, const std::string& what, const std::string& with)
+		{
+			for(std::size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + with.size()))
+				text.replace(at, what.size(), with);
+			
+			return text;
+		}
+		
+		// the process's peak memory since the last reset. Windows can't reset it, so it's the peak since starting there
+		std::size_t getPeakMemory()
+		{
+			#ifdef __linux__
+				std::ifstream fin("/proc/self/status");
+				std::string line;
+				
+				while(std::getline(fin, line))
+				{
+					if(line.compare(0, 6, "VmHWM:") == 0)
+						return std::stoull(line.substr(6)) * 1024;	// convert to B from KB
+				}
+				
+				rusage usage;
+				return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<std::size_t>(usage.ru_maxrss) * 1024 : 0;
+			#elif _WIN32
+				PROCESS_MEMORY_COUNTERS counters;
+				return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+			#else
+				return 0;
+			#endif
+		}
+		
+		void resetPeakMemory()
+		{
+			#ifdef __linux__
+				// resets VmHWM to what's held now
+				std::ofstream fout("/proc/self/clear_refs");
+				fout << "5";
+			#endif
+		}
+	}
+	
+	WorldBenchmark::WorldBenchmark(AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, AsyncWriter& w, unsigned s)
+	:	assets(am),
+		soundPlayer(sp),
+		musicPlayer(mp),
+		writer(w),
+		seed(s)
+	{
+	}
+	
+	bool WorldBenchmark::run(const std::string& map, const std::string& animation, sf::RenderTarget& target, const std::vector<unsigned>& sizes, unsigned ticks)
+	{
+		results.clear();
+		
+		// checked once here, instead of for every world
+		TileMap check;
+		
+		if(!check.loadFile(map))
+		{
+			SWIFT_ERROR(World, "Loading tilemap \"" << map << "\" failed, world benchmark stopped.\n");
+			return false;
+		}
+		
+		for(auto& s : sizes)
+			results.push_back(measure(map, animation, target, s, ticks));
+		
+		target.setView(target.getDefaultView());
+		
+		return true;
+	}
+	
+	const std::vector<WorldBenchmark::Result>& WorldBenchmark::getResults() const
+	{
+		return results;
+	}
+	
+	bool WorldBenchmark::save(const std::string& file) const
+	{
+		std::ofstream fout(file);
+		
+		if(!fout)
+		{
+			SWIFT_ERROR(General, "Could not write world benchmark results to \"" << file << "\".\n");
+			return false;
+		}
+		
+		fout << "{\n\t\"seed\": " << seed << ",\n\t\"results\": [\n";
+		
+		for(std::size_t i = 0; i < results.size(); i++)
+		{
+			const Result& r = results[i];
+			
+			fout << "\t\t{\n"
+				<< "\t\t\t\"entities\": " << r.entities << ",\n"
+				<< "\t\t\t\"ticks\": " << r.ticks << ",\n"
+				<< "\t\t\t\"update\": " << r.update << ",\n"
+				<< "\t\t\t\"systems\": {";
+			
+			for(std::size_t s = 0; s < r.systems.size(); s++)
+				fout << (s == 0 ? "" : ", ") << '"' << r.systems[s].first << "\": " << r.systems[s].second;
+			
+			fout << "},\n"
+				<< "\t\t\t\"collisions\": " << r.collisions << ",\n"
+				<< "\t\t\t\"draw\": " << r.draw << ",\n"
+				<< "\t\t\t\"save\": " << r.save << ",\n"
+				<< "\t\t\t\"load\": " << r.load << ",\n"
+				<< "\t\t\t\"memory\": " << r.memory << ",\n"
+				<< "\t\t\t\"peakMemory\": " << r.peakMemory << '\n'
+				<< "\t\t}" << (i + 1 < results.size() ? "," : "") << '\n';
+		}
+		
+		fout << "\t]\n}\n";
+		
+		return static_cast<bool>(fout);
+	}
+	
+	WorldBenchmark::Result WorldBenchmark::measure(const std::string& map, const std::string& animation, sf::RenderTarget& target, unsigned count, unsigned ticks)
+	{
+		Result result = {count, ticks, {}, 0, 0, 0, 0, 0, 0, 0};
+		const std::string name = "benchmark" + std::to_string(count);
+		
+		resetPeakMemory();
+		
+		{
+			World world(name, assets, soundPlayer, musicPlayer, {});
+			
+			world.tilemap.loadFile(map);
+			
+			std::vector<const sf::Texture*> textures;
+			
+			for(auto& t : world.tilemap.getTextureFiles())
+				textures.push_back(assets.getTexture(t));
+			
+			world.tilemap.loadTextures(textures);
+			
+			// as dense as the other sizes, with walls of the map's second tile type where the noise is high
+			unsigned side = std::max(64u, static_cast<unsigned>(std::ceil(std::sqrt(static_cast<float>(count * tilesPerEntity)))));
+			
+			TileGenerator generator(seed + count);
+			generator.addLayer({{0.35f, 0}, {2.f, 1}});
+			world.tilemap.generate(generator, {side, side});
+			
+			sf::Vector2f mapSize(static_cast<float>(side * world.tilemap.getTileSize().x), static_cast<float>(side * world.tilemap.getTileSize().y));
+			
+			std::mt19937 rng(seed + count);
+			std::uniform_real_distribution<float> xs(0, mapSize.x);
+			std::uniform_real_distribution<float> ys(0, mapSize.y);
+			std::uniform_real_distribution<float> angles(0, 6.2831853f);
+			
+			const std::string texture = textures.empty() ? "" : world.tilemap.getTextureFiles()[0];
+			std::vector<Entity*> spawned;
+			unsigned made = 0;
+			
+			for(std::size_t a = 0; a < sizeof(archetypes) / sizeof(archetypes[0]); a++)
+			{
+				const Archetype& type = archetypes[a];
+				unsigned n = a + 1 < sizeof(archetypes) / sizeof(archetypes[0]) ? count * type.share / 100 : count - made;
+				
+				std::string text = "<prefab>" + replace(replace(type.components, "$texture", texture), "$animation", animation) + "</prefab>";
+				
+				Prefab prefab;
+				prefab.loadFromMemory(text.data(), text.size(), name + ".prefab");
+				
+				std::vector<sf::Vector2f> positions(n);
+				
+				for(auto& p : positions)
+					p = {xs(rng), ys(rng)};
+				
+				world.spawn(prefab, n, positions, spawned);
+				
+				for(auto& e : spawned)
+				{
+					if(type.moves)
+					{
+						Movable* mov = e->get<Movable>();
+						float angle = angles(rng);
+						mov->velocity = {std::cos(angle) * mov->moveVelocity, std::sin(angle) * mov->moveVelocity};
+					}
+					
+					if(type.paths)
+					{
+						Pathfinder* pf = e->get<Pathfinder>();
+						pf->destination = {xs(rng), ys(rng)};
+						pf->needsPath = true;
+					}
+				}
+				
+				made += n;
+			}
+			
+			target.setView(sf::View(mapSize / 2.f, sf::Vector2f(target.getSize())));
+			
+			sf::Time update;
+			sf::Time draw;
+			std::size_t collisions = 0;
+			
+			for(unsigned t = 0; t < warmupTicks + ticks; t++)
+			{
+				sf::Clock clock;
+				world.update(tickTime);
+				sf::Time took = clock.getElapsedTime();
+				
+				target.clear();
+				
+				clock.restart();
+				world.drawWorld(target);
+				world.drawEntities(target, 1);
+				sf::Time drew = clock.getElapsedTime();
+				
+				if(t < warmupTicks)
+					continue;
+				
+				update += took;
+				draw += drew;
+				collisions += world.getCollisions().size();
+				
+				// in the order the world added its systems, which is the same every tick
+				for(auto& s : FrameStats::getSystemTimes())
+				{
+					auto it = std::find_if(result.systems.begin(), result.systems.end(), [&](const std::pair<std::string, float>& r)
+					{
+						return r.first == s.name;
+					});
+					
+					if(it == result.systems.end())
+						it = result.systems.insert(result.systems.end(), {s.name, 0.f});
+					
+					it->second += s.time.asMicroseconds();
+				}
+			}
+			
+			float perTick = ticks == 0 ? 0 : 1.f / ticks;
+			
+			for(auto& s : result.systems)
+				s.second *= perTick;
+			
+			result.update = update.asMicroseconds() * perTick;
+			result.draw = draw.asMicroseconds() * perTick;
+			result.collisions = collisions * perTick;
+			result.memory = world.getMemory();
+			
+			// the first save is always a full one
+			sf::Clock clock;
+			world.save();
+			writer.wait();
+			writer.poll();
+			result.save = clock.getElapsedTime().asMicroseconds() / 1000.f;
+		}
+		
+		{
+			World loaded(name, assets, soundPlayer, musicPlayer, {});
+			
+			sf::Clock clock;
+			loaded.load();
+			result.load = clock.getElapsedTime().asMicroseconds() / 1000.f;
+		}
+		
+		writer.wait();
+		writer.poll();
+		
+		result.peakMemory = getPeakMemory();
+		
+		// the saves were only for timing
+		std::remove(("./data/saves/" + name + ".world").c_str());
+		std::remove(("./data/saves/" + name + ".journal").c_str());
+		
+		return result;
+	}
+}
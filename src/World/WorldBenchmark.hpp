@@ -0,0 +1,61 @@
+#ifndef WORLDBENCHMARK_HPP
+#define WORLDBENCHMARK_HPP
+
+#include <vector>
+#include <string>
+#include <utility>
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include "World.hpp"
+
+namespace swift
+{
+	// times whole worlds of generated entities, on maps generated from the tilesets of a real one, so changes
+	// anywhere in the engine can be measured together. Entities and maps come from the seed, so runs with the
+	// same seed tick the same worlds
+	class WorldBenchmark
+	{
+		public:
+			struct Result
+			{
+				unsigned entities;
+				unsigned ticks;
+				
+				// per tick, in microseconds, by how the world names its systems. Physical is the collision time
+				std::vector<std::pair<std::string, float>> systems;
+				float update;				// all of World::update, per tick
+				float collisions;			// per tick
+				float draw;					// of submitting the tilemap and entities, per frame. The GPU isn't waited on
+				float save;					// milliseconds, a full save, until the writer's done with it
+				float load;					// milliseconds, of a new world
+				std::size_t memory;			// bytes, by World::getMemory after the ticks
+				std::size_t peakMemory;		// bytes, the most the process held during the run, 0 if it can't be found
+			};
+			
+			WorldBenchmark(AssetManager& am, SoundPlayer& sp, MusicPlayer& mp, AsyncWriter& w, unsigned seed = 0);
+			
+			// one world per size, with that many entities, on a map as dense as the others made from map's tilesets.
+			// Animated entities play animation. Each draws to target every tick. False if map couldn't be loaded
+			bool run(const std::string& map, const std::string& animation, sf::RenderTarget& target,
+					const std::vector<unsigned>& sizes = {1000, 10000, 100000}, unsigned ticks = 300);
+			
+			const std::vector<Result>& getResults() const;
+			
+			// the results as a JSON object, one entry per size, to compare runs between commits with
+			bool save(const std::string& file) const;
+		
+		private:
+			Result measure(const std::string& map, const std::string& animation, sf::RenderTarget& target, unsigned count, unsigned ticks);
+			
+			AssetManager& assets;
+			SoundPlayer& soundPlayer;
+			MusicPlayer& musicPlayer;
+			AsyncWriter& writer;
+			
+			unsigned seed;
+			std::vector<Result> results;
+	};
+}
+
+#endif // WORLDBENCHMARK_HPP
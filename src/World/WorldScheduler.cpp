@@ -0,0 +1,407 @@
+#include "WorldScheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+#include <SFML/System/Clock.hpp>
+
+#include "World.hpp"
+#include "../Profiling/Profiler.hpp"
+
+namespace swift
+{
+	WorldScheduler::WorldScheduler(unsigned count)
+	:	parallelScripts(false),
+		round(0),
+		remaining(0),
+		stopping(false)
+	{
+		if(count == 0)
+			count = std::max(std::thread::hardware_concurrency(), 1u);
+		
+		for(unsigned i = 0; i < count; i++)
+			workers.emplace_back(new Worker);
+		
+		for(unsigned i = 1; i < count; i++)
+			workers[i]->thread = std::thread(&WorldScheduler::work, this, i);
+	}
+	
+	WorldScheduler::~WorldScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		
+		start.notify_all();
+		
+		for(auto& w : workers)
+		{
+			if(w->thread.joinable())
+				w->thread.join();
+		}
+	}
+	
+	bool WorldScheduler::add(World& world, float tickRate, int worker)
+	{
+		if(find(world))
+			return false;
+		
+		unsigned index = 0;
+		
+		if(worker >= 0)
+			index = std::min<unsigned>(worker, workers.size() - 1);
+		else
+		{
+			// fewest worlds. The calling thread's worker only when it has strictly fewer, it has the rest of each round to do too
+			std::vector<unsigned> counts(workers.size(), 0);
+			
+			for(auto& e : entries)
+				counts[e->worker]++;
+			
+			index = workers.size() > 1 ? 1 : 0;
+			
+			for(unsigned w = 0; w < counts.size(); w++)
+			{
+				if(counts[w] < counts[index])
+					index = w;
+			}
+		}
+		
+		entries.emplace_back(new Entry{&world, index, std::max(tickRate, 0.f), 0, sf::Time::Zero, sf::Time::Zero, sf::Time::Zero, 0, 0, false, false, {}});
+		assign();
+		
+		return true;
+	}
+	
+	bool WorldScheduler::remove(World& world)
+	{
+		auto it = std::find_if(entries.begin(), entries.end(), [&](const std::unique_ptr<Entry>& e)
+		{
+			return e->world == &world;
+		});
+		
+		if(it == entries.end())
+			return false;
+		
+		entries.erase(it);
+		assign();
+		
+		std::lock_guard<std::mutex> lock(transferMutex);
+		
+		transfers.erase(std::remove_if(transfers.begin(), transfers.end(), [&](const Transfer& t)
+		{
+			return t.from == &world || t.to == &world;
+		}), transfers.end());
+		
+		return true;
+	}
+	
+	void WorldScheduler::clear()
+	{
+		entries.clear();
+		assign();
+		
+		std::lock_guard<std::mutex> lock(transferMutex);
+		transfers.clear();
+	}
+	
+	bool WorldScheduler::has(const World& world) const
+	{
+		return find(world) != nullptr;
+	}
+	
+	std::size_t WorldScheduler::getWorldCount() const
+	{
+		return entries.size();
+	}
+	
+	unsigned WorldScheduler::getWorkerCount() const
+	{
+		return workers.size();
+	}
+	
+	int WorldScheduler::getWorker(const World& world) const
+	{
+		Entry* e = find(world);
+		return e ? static_cast<int>(e->worker) : -1;
+	}
+	
+	void WorldScheduler::setTickRate(World& world, float tickRate)
+	{
+		if(Entry* e = find(world))
+		{
+			e->tickRate = std::max(tickRate, 0.f);
+			e->lag = 0;
+		}
+	}
+	
+	void WorldScheduler::setBudget(World& world, sf::Time budget)
+	{
+		if(Entry* e = find(world))
+			e->budget = budget;
+	}
+	
+	std::size_t WorldScheduler::getDroppedTicks(const World& world) const
+	{
+		Entry* e = find(world);
+		return e ? e->dropped : 0;
+	}
+	
+	sf::Time WorldScheduler::getTickTime(const World& world) const
+	{
+		Entry* e = find(world);
+		return e ? e->tickTime : sf::Time::Zero;
+	}
+	
+	void WorldScheduler::transfer(World& from, EntityHandle entity, World& to, const sf::Vector2f& position)
+	{
+		std::lock_guard<std::mutex> lock(transferMutex);
+		transfers.push_back({&from, entity, &to, position});
+	}
+	
+	void WorldScheduler::update(float dt)
+	{
+		SWIFT_PROFILE("WorldScheduler::update");
+		
+		for(auto& e : entries)
+		{
+			if(e->tickRate > 0)
+				e->lag += dt;
+			
+			e->spent = sf::Time::Zero;
+			e->ticked = false;
+		}
+		
+		while(true)
+		{
+			bool any = false;
+			
+			for(auto& e : entries)
+			{
+				float interval = e->tickRate > 0 ? 1 / e->tickRate : 0;
+				bool over = e->budget > sf::Time::Zero && e->spent >= e->budget;
+				
+				// whole ticks only, what's left of one is kept for the next update
+				if(over && interval > 0 && e->lag >= interval)
+				{
+					float ticks = std::floor(e->lag / interval);
+					e->dropped += static_cast<std::size_t>(ticks);
+					e->lag -= ticks * interval;
+				}
+				
+				e->step = interval > 0 ? interval : dt;
+				e->due = !over && (interval > 0 ? e->lag >= interval : !e->ticked);
+				any = any || e->due;
+			}
+			
+			if(!any)
+				break;
+			
+			runRound();
+			
+			for(auto& e : entries)
+			{
+				if(!e->due)
+					continue;
+				
+				if(e->tickRate > 0)
+					e->lag -= e->step;
+				
+				e->ticked = true;
+			}
+		}
+		
+		// ones queued outside of any tick
+		applyTransfers();
+	}
+	
+	void WorldScheduler::work(unsigned index)
+	{
+		unsigned seen = 0;
+		
+		while(true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				start.wait(lock, [&]() { return stopping || round != seen; });
+				
+				if(stopping)
+					return;
+				
+				seen = round;
+			}
+			
+			tickWorker(index);
+			
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				remaining--;
+			}
+			
+			done.notify_one();
+		}
+	}
+	
+	void WorldScheduler::tickWorker(unsigned index)
+	{
+		for(auto& e : workers[index]->entries)
+		{
+			if(!e->due)
+				continue;
+			
+			sf::Clock clock;
+			
+			e->world->updateSystems(e->step);
+			
+			if(parallelScripts)
+			{
+				Script::Scope scope(*e->world, e->deferred);
+				e->world->updateScripts(e->step);
+			}
+			
+			e->tickTime = clock.getElapsedTime();
+			e->spent += e->tickTime;
+		}
+	}
+	
+	void WorldScheduler::runRound()
+	{
+		parallelScripts = scriptsAreSeparate();
+		
+		// the threads are only woken if one of them has something due
+		unsigned busy = 0;
+		
+		for(unsigned w = 1; w < workers.size(); w++)
+		{
+			for(auto& e : workers[w]->entries)
+			{
+				if(e->due)
+				{
+					busy++;
+					break;
+				}
+			}
+		}
+		
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			// every thread sees the round, those with nothing due just count themselves done
+			remaining = busy > 0 ? workers.size() - 1 : 0;
+			
+			if(busy > 0)
+				round++;
+		}
+		
+		if(busy > 0)
+			start.notify_all();
+		
+		tickWorker(0);
+		
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [&]() { return remaining == 0; });
+		}
+		
+		// in the order worlds were added, so the result is the same as ticking them one after another
+		for(auto& e : entries)
+		{
+			if(!e->due)
+				continue;
+			
+			if(parallelScripts)
+			{
+				for(auto& f : e->deferred)
+					f();
+				
+				e->deferred.clear();
+			}
+			else
+			{
+				sf::Clock clock;
+				e->world->updateScripts(e->step);
+				e->spent += clock.getElapsedTime();
+			}
+			
+			e->world->finishUpdate();
+		}
+		
+		applyTransfers();
+	}
+	
+	void WorldScheduler::applyTransfers()
+	{
+		std::vector<Transfer> moving;
+		
+		{
+			std::lock_guard<std::mutex> lock(transferMutex);
+			moving.swap(transfers);
+		}
+		
+		for(auto& t : moving)
+		{
+			Entity* entity = t.from->getEntity(t.entity);
+			
+			if(entity == nullptr || t.from == t.to)
+				continue;
+			
+			// copied over, as Play moves the player, so only the handle changes
+			Entity* moved = t.to->addEntity();
+			*moved = *entity;
+			
+			if(Physical* phys = moved->get<Physical>())
+			{
+				phys->position = t.position;
+				phys->resetPrevious();
+			}
+			
+			t.to->refit(*moved);
+			t.from->removeEntity(t.entity);
+		}
+	}
+	
+	void WorldScheduler::assign()
+	{
+		for(auto& w : workers)
+			w->entries.clear();
+		
+		for(auto& e : entries)
+			workers[e->worker]->entries.push_back(e.get());
+	}
+	
+	bool WorldScheduler::scriptsAreSeparate() const
+	{
+		// one VM can only run on one thread at a time, and a script file's Script is shared by every world running it
+		if(!Script::canRunInParallel())
+			return false;
+		
+		std::unordered_set<const Script*> seen;
+		
+		for(auto& e : entries)
+		{
+			if(!e->due)
+				continue;
+			
+			for(auto& s : e->world->getScripts())
+			{
+				if(!seen.insert(s.second).second)
+					return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	WorldScheduler::Entry* WorldScheduler::find(const World& world) const
+	{
+		for(auto& e : entries)
+		{
+			if(e->world == &world)
+				return e.get();
+		}
+		
+		return nullptr;
+	}
+}
@@ -0,0 +1,134 @@
+#ifndef WORLDSCHEDULER_HPP
+#define WORLDSCHEDULER_HPP
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "../EntitySystem/EntityHandle.hpp"
+#include "../Scripting/Script.hpp"
+
+namespace swift
+{
+	class World;
+	
+	// ticks several worlds at once, each pinned to one worker, so its ticks never move between threads and its data stays
+	// in one core's cache. Each world runs its systems, through its own SystemScheduler, on its worker, and its scripts
+	// there too when scripts can run in parallel. Engine writes of scripts, the worlds' structural changes from their
+	// CommandBuffers, and entities moved between worlds are applied on the thread calling update, in the order worlds
+	// were added, so the result is the same however many workers there are
+	class WorldScheduler
+	{
+		public:
+			// workers = 0 uses one per hardware thread. The thread calling update is the first of them
+			explicit WorldScheduler(unsigned workers = 0);
+			~WorldScheduler();
+			
+			WorldScheduler(const WorldScheduler&) = delete;
+			WorldScheduler& operator=(const WorldScheduler&) = delete;
+			
+			// world ticks tickRate times a second of update's time, or once every update, with its time, if it's 0.
+			// Runs on worker, or the one with the fewest worlds if it's -1. False if it's already added
+			bool add(World& world, float tickRate, int worker = -1);
+			
+			// moves of world that are still queued are dropped. False if it wasn't added
+			bool remove(World& world);
+			void clear();
+			
+			bool has(const World& world) const;
+			std::size_t getWorldCount() const;
+			unsigned getWorkerCount() const;
+			
+			// -1 if world isn't added
+			int getWorker(const World& world) const;
+			
+			void setTickRate(World& world, float tickRate);
+			
+			// time world's ticks may take in one update. Once they've taken it, the whole ticks it's still behind by are
+			// dropped, so a world that can't keep up runs slower instead of holding the others back. 0, the default, for none
+			void setBudget(World& world, sf::Time budget);
+			
+			// ticks world dropped since it was added, and how long its last one took
+			std::size_t getDroppedTicks(const World& world) const;
+			sf::Time getTickTime(const World& world) const;
+			
+			// moves entity from from to to, at position, once the ticks going on are done, or on the next update. Safe from
+			// any thread, so systems and scripts of ticking worlds may call it. Neither world needs to be added, but both
+			// must still be around by then. Dropped if the entity is gone by the time it's moved
+			void transfer(World& from, EntityHandle entity, World& to, const sf::Vector2f& position);
+			
+			// ticks what's due, in rounds of a tick of every world due one. Between rounds, worlds finish their
+			// updates and queued moves are done
+			void update(float dt);
+		
+		private:
+			struct Entry
+			{
+				World* world;
+				unsigned worker;
+				float tickRate;
+				float lag;
+				sf::Time budget;
+				sf::Time spent;				// on ticks this update
+				sf::Time tickTime;
+				std::size_t dropped;
+				float step;					// of this round's tick
+				bool due;					// this round
+				bool ticked;				// this update
+				Script::Deferred deferred;	// of its scripts, when they run on its worker
+			};
+			
+			struct Worker
+			{
+				std::thread thread;
+				std::vector<Entry*> entries;
+			};
+			
+			struct Transfer
+			{
+				World* from;
+				EntityHandle entity;
+				World* to;
+				sf::Vector2f position;
+			};
+			
+			void work(unsigned index);
+			
+			// systems, and scripts if parallelScripts, of the entries of worker that are due
+			void tickWorker(unsigned index);
+			
+			// due entries, on their workers, then finished here
+			void runRound();
+			
+			void applyTransfers();
+			
+			// which entries go on which worker, after adding or removing
+			void assign();
+			
+			// if no two worlds share a Script or a VM, so their scripts can run at once
+			bool scriptsAreSeparate() const;
+			
+			Entry* find(const World& world) const;
+			
+			std::vector<std::unique_ptr<Entry>> entries;
+			std::vector<std::unique_ptr<Worker>> workers;	// the first runs on the calling thread, and has no thread
+			bool parallelScripts;							// this round
+			
+			std::mutex mutex;
+			std::condition_variable start;
+			std::condition_variable done;
+			unsigned round;
+			unsigned remaining;		// workers still ticking this round
+			bool stopping;
+			
+			std::mutex transferMutex;
+			std::vector<Transfer> transfers;
+	};
+}
+
+#endif // WORLDSCHEDULER_HPP